@@ -36,6 +36,9 @@ if(FEATURE_METRICS)
     find_package(opentelemetry-cpp CONFIG REQUIRED)
     find_package(prometheus-cpp CONFIG REQUIRED)
 endif()
+if(FEATURE_TRACY)
+    find_package(Tracy CONFIG REQUIRED)
+endif()
 find_package(mio REQUIRED)
 find_package(pugixml CONFIG REQUIRED)
 find_package(spdlog REQUIRED)
@@ -108,6 +108,41 @@ target_link_libraries(${PROJECT_NAME}_lib
         protobuf
 )
 
+if(FEATURE_ALLOCATION_COUNTER)
+    add_definitions(-DFEATURE_ALLOCATION_COUNTER)
+endif()
+
+# === libdeflate ===
+if(FEATURE_LIBDEFLATE)
+    find_package(libdeflate CONFIG REQUIRED)
+    add_definitions(-DFEATURE_LIBDEFLATE)
+    if(TARGET libdeflate::libdeflate_shared)
+        target_link_libraries(${PROJECT_NAME}_lib PUBLIC libdeflate::libdeflate_shared)
+    else()
+        target_link_libraries(${PROJECT_NAME}_lib PUBLIC libdeflate::libdeflate_static)
+    endif()
+endif()
+
+# === io_uring ===
+# asio runs every socket operation (accept, receive, send) through io_uring when epoll is disabled
+if(FEATURE_IO_URING)
+    if(NOT CMAKE_SYSTEM_NAME STREQUAL "Linux")
+        message(FATAL_ERROR "FEATURE_IO_URING is only available on Linux")
+    endif()
+
+    find_package(LibUring REQUIRED)
+    add_definitions(-DFEATURE_IO_URING -DASIO_HAS_IO_URING -DASIO_DISABLE_EPOLL)
+    target_include_directories(${PROJECT_NAME}_lib PUBLIC ${LIBURING_INCLUDE_DIR})
+    target_link_libraries(${PROJECT_NAME}_lib PUBLIC ${LIBURING_LIBRARIES})
+endif()
+
+# === Tracy ===
+# TRACY_ENABLE and TRACY_ON_DEMAND come with the client
+if(FEATURE_TRACY)
+    add_definitions(-DFEATURE_TRACY)
+    target_link_libraries(${PROJECT_NAME}_lib PUBLIC Tracy::TracyClient)
+endif()
+
 if(FEATURE_METRICS)
     add_definitions(-DFEATURE_METRICS)
 
@@ -0,0 +1,23 @@
+# - Try to find the liburing library
+# This module defines:
+#  LIBURING_FOUND        - system has liburing
+#  LIBURING_INCLUDE_DIR  - the liburing include directory
+#  LIBURING_LIBRARIES    - Link these to use liburing
+
+include(FindPackageHandleStandardArgs)
+
+find_path(LIBURING_INCLUDE_DIR
+          NAMES liburing.h
+          HINTS ENV LIBURING_DIR
+          PATH_SUFFIXES include
+          DOC "The directory containing the liburing header files"
+         )
+
+find_library(LIBURING_LIBRARIES NAMES uring
+  HINTS ENV LIBURING_DIR
+  PATH_SUFFIXES lib
+  DOC "Path to the liburing library"
+  )
+
+find_package_handle_standard_args(LibUring "DEFAULT_MSG" LIBURING_LIBRARIES LIBURING_INCLUDE_DIR)
+mark_as_advanced(LIBURING_INCLUDE_DIR LIBURING_LIBRARIES)
@@ -249,10 +249,12 @@ end
 
 function setPlayerSpouse(id, val)
 	db.query("UPDATE `players` SET `marriage_spouse` = " .. val .. " WHERE `id` = " .. id)
+	Game.removeOfflinePlayer(id)
 end
 
 function setPlayerMarriageStatus(id, val)
 	db.query("UPDATE `players` SET `marriage_status` = " .. val .. " WHERE `id` = " .. id)
+	Game.removeOfflinePlayer(id)
 end
 
 function checkBoss(centerPosition, rangeX, rangeY, bossName, bossPos)
@@ -1,3 +1,22 @@
+-- The loot of the monster types with what the rolls need of their item types, by loot revision
+local compiledLoots = {}
+
+local function compileLoot(monsterType)
+	local compiled = {}
+	for _, item in ipairs(monsterType:getLoot() or {}) do
+		local iType = ItemType(item.itemId)
+		compiled[#compiled + 1] = {
+			item = item,
+			itemType = iType,
+			charges = iType:getCharges(),
+			stackable = iType:isStackable(),
+			creatureProduct = iType:getType() == ITEM_TYPE_CREATUREPRODUCT,
+			bagYouDesire = iType:getId() == SoulWarQuest.bagYouDesireItemId,
+		}
+	end
+	return compiled
+end
+
 -- return a dictionary of itemId => { count, gut }
 ---@param config { factor: number, gut: boolean, filter?: fun(itemType: ItemType, unique: boolean): boolean }
 ---@return LootItems
@@ -6,7 +25,12 @@ function MonsterType:generateLootRoll(config, resultTable, player)
 		return resultTable or {}
 	end
 
-	local monsterLoot = self:getLoot() or {}
+	local revision = self:getLootRevision()
+	local monsterLoot = compiledLoots[revision]
+	if not monsterLoot then
+		monsterLoot = compileLoot(self)
+		compiledLoots[revision] = monsterLoot
+	end
 	local factor = config.factor or 1.0
 	local uniqueItems = {}
 
@@ -15,9 +39,9 @@ function MonsterType:generateLootRoll(config, resultTable, player)
 	end
 
 	local result = resultTable or {}
-	for _, item in ipairs(monsterLoot) do
-		local iType = ItemType(item.itemId)
-		if config.filter and not config.filter(iType, item.unique) then
+	for _, compiled in ipairs(monsterLoot) do
+		local item = compiled.item
+		if config.filter and not config.filter(compiled.itemType, item.unique) then
 			goto continue
 		end
 		if uniqueItems[item.itemId] then
@@ -28,12 +52,12 @@ function MonsterType:generateLootRoll(config, resultTable, player)
 		end
 
 		local chance = item.chance
-		if iType:getId() == SoulWarQuest.bagYouDesireItemId then
+		if compiled.bagYouDesire then
 			result[item.itemId].chance = self:calculateBagYouDesireChance(player, chance)
 			logger.debug("Final chance for bag you desire: {}, original chance: {}", result[item.itemId].chance, chance)
 		end
 
-		if config.gut and iType:getType() == ITEM_TYPE_CREATUREPRODUCT then
+		if config.gut and compiled.creatureProduct then
 			chance = math.ceil((chance * GLOBAL_CHARM_GUT) / 100)
 		end
 
@@ -43,10 +67,10 @@ function MonsterType:generateLootRoll(config, resultTable, player)
 		end
 
 		local count = 0
-		local charges = iType:getCharges()
+		local charges = compiled.charges
 		if charges > 0 then
 			count = charges
-		elseif iType:isStackable() then
+		elseif compiled.stackable then
 			local maxc, minc = item.maxCount or 1, item.minCount or 1
 			count = math.max(0, randValue % (maxc - minc + 1)) + minc
 		else
@@ -54,7 +78,7 @@ function MonsterType:generateLootRoll(config, resultTable, player)
 		end
 
 		result[item.itemId].count = result[item.itemId].count + count
-		result[item.itemId].gut = config.gut and iType:getType() == ITEM_TYPE_CREATUREPRODUCT
+		result[item.itemId].gut = config.gut and compiled.creatureProduct
 		result[item.itemId].unique = item.unique
 		result[item.itemId].subType = item.subType
 		result[item.itemId].text = item.text
@@ -269,7 +269,34 @@ end
 
 -- Monsters revscriptsys
 do
+	-- Most monster files define their callbacks as empty functions, a monster without them does not call Lua at all.
+	-- An empty function is only a return, so they are told apart by their number of instructions (needs LuaJIT).
+	local hasJitUtil, jitUtil = pcall(require, "jit.util")
+	local emptyFunctionSize = hasJitUtil and jitUtil.funcinfo(function() end).bytecodes or nil
+
+	local function isEmptyFunction(value)
+		if not emptyFunctionSize or type(value) ~= "function" then
+			return false
+		end
+		local info = jitUtil.funcinfo(value)
+		return info.bytecodes == emptyFunctionSize and info.upvalues == 0
+	end
+
+	local monsterTypeEvents = {
+		onThink = true,
+		onAppear = true,
+		onDisappear = true,
+		onMove = true,
+		onSay = true,
+		onPlayerAttack = true,
+		onSpawn = true,
+	}
+
 	local function MonsterTypeNewIndex(self, key, value)
+		if monsterTypeEvents[key] and isEmptyFunction(value) then
+			return
+		end
+
 		if key == "onThink" then
 			self:eventType(MONSTERS_EVENT_THINK)
 			self:onThink(value)
@@ -8,6 +8,11 @@
 ---@method getMonsters
 ---@method getNpcs
 ---@method getItems
+---@method getCreatureCount
+---@method getPlayerCount
+---@method getMonsterCount
+---@method getNpcCount
+---@method getItemCount
 
 function Zone:randomPosition()
 	local positions = self:getPositions()
@@ -32,9 +37,12 @@ function Zone:sendTextMessage(...)
 end
 
 function Zone:countMonsters(name)
+	if not name then
+		return self:getMonsterCount()
+	end
 	local count = 0
 	for _, monster in ipairs(self:getMonsters()) do
-		if not name or monster:getName():lower() == name:lower() then
+		if monster:getName():lower() == name:lower() then
 			count = count + 1
 		end
 	end
@@ -52,14 +60,12 @@ function Zone:getMonstersByName(name)
 end
 
 function Zone:countPlayers(notFlag)
-	local players = self:getPlayers()
+	if not notFlag then
+		return self:getPlayerCount()
+	end
 	local count = 0
-	for _, player in ipairs(players) do
-		if notFlag then
-			if not player:hasGroupFlag(notFlag) then
-				count = count + 1
-			end
-		else
+	for _, player in ipairs(self:getPlayers()) do
+		if not player:hasGroupFlag(notFlag) then
 			count = count + 1
 		end
 	end
@@ -39,6 +39,7 @@ local function processHouseAuctions()
 				local lastBid = Result.getNumber(resultId, "last_bid")
 				if balance >= lastBid then
 					db.query("UPDATE `players` SET `balance` = " .. (balance - lastBid) .. " WHERE `id` = " .. highestBidder)
+					Game.removeOfflinePlayer(highestBidder)
 					house:setHouseOwner(highestBidder)
 				end
 
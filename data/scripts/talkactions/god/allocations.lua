@@ -0,0 +1,26 @@
+local allocations = TalkAction("/allocations")
+
+local tags = { "dispatcher", "lua", "network", "map", "untagged" }
+
+function allocations.onSay(player, words, param)
+	-- create log
+	logCommand(player, words, param)
+
+	local stats = Game.getAllocationStats()
+	if not stats then
+		player:sendTextMessage(MESSAGE_ADMINISTRATOR, "The allocation counter is disabled, build the server with FEATURE_ALLOCATION_COUNTER.")
+		return true
+	end
+
+	local text = "Heap allocations since start, by the subsystem that made them:\n"
+	for _, tag in ipairs(tags) do
+		local entry = stats[tag]
+		text = text .. string.format("\n%s\nallocations: %d, allocated: %.1f KB\n", tag, entry.allocations, entry.bytes / 1024)
+	end
+	player:popupFYI(text)
+	return true
+end
+
+allocations:separator(" ")
+allocations:groupType("god")
+allocations:register()
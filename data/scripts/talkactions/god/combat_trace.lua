@@ -0,0 +1,44 @@
+local combatTrace = TalkAction("/combattrace")
+
+function combatTrace.onSay(player, words, param)
+	-- create log
+	logCommand(player, words, param)
+
+	-- /combattrace start, file | stop | replay, file
+	local split = param:split(",")
+	local action = split[1] and split[1]:trim():lower() or ""
+	local file = split[2] and split[2]:trim() or "combat.trace"
+
+	if action == "start" then
+		if Game.startCombatTrace(file) then
+			player:sendTextMessage(MESSAGE_ADMINISTRATOR, "Recording combats to " .. file .. ".")
+		else
+			player:sendTextMessage(MESSAGE_ADMINISTRATOR, "Could not record to " .. file .. ", is a trace already being recorded?")
+		end
+	elseif action == "stop" then
+		if Game.stopCombatTrace() then
+			player:sendTextMessage(MESSAGE_ADMINISTRATOR, "Stopped recording combats.")
+		else
+			player:sendTextMessage(MESSAGE_ADMINISTRATOR, "No combats are being recorded.")
+		end
+	elseif action == "replay" then
+		local report = Game.replayCombatTrace(file)
+		if not report then
+			player:sendTextMessage(MESSAGE_ADMINISTRATOR, "Could not replay " .. file .. ", see the server log.")
+			return true
+		end
+
+		local text = string.format("Replayed %d combats recorded in %d ms, in %d microseconds.\ntiles: %d, creatures: %d, spectators: %d, bytes: %d\n", report.events, report.recordedTime, report.replayTime, report.tiles, report.creatures, report.spectators, report.bytes)
+		for _, phase in ipairs(report.phases) do
+			text = text .. string.format("\n%s (microseconds)\ntotal: %d, p50: %d, p99: %d\n", phase.name, phase.totalTime, phase.p50Time, phase.p99Time)
+		end
+		player:popupFYI(text)
+	else
+		player:sendTextMessage(MESSAGE_ADMINISTRATOR, "Usage: /combattrace start, file | stop | replay, file")
+	end
+	return true
+end
+
+combatTrace:separator(" ")
+combatTrace:groupType("god")
+combatTrace:register()
@@ -0,0 +1,48 @@
+local connectionStats = TalkAction("/netstats")
+
+function connectionStats.onSay(player, words, param)
+	-- create log
+	logCommand(player, words, param)
+
+	-- /netstats [count], [received|sent|packetsin|packetsout|queue|latency]
+	local split = param:split(",")
+	local count = tonumber(split[1]) or 10
+	local sort = split[2] and split[2]:trim() or "sent"
+
+	local connections = Game.getConnectionStats(count, sort)
+	if not connections then
+		player:sendTextMessage(MESSAGE_ADMINISTRATOR, "Unknown sort " .. sort .. ", use received, sent, packetsin, packetsout, queue or latency.")
+		return true
+	end
+
+	if #connections == 0 then
+		player:sendTextMessage(MESSAGE_ADMINISTRATOR, "There are no connections.")
+		return true
+	end
+
+	local text = string.format("Top %d connections by %s (packets per second of the last second):\n", #connections, sort)
+	for index, connection in ipairs(connections) do
+		text = text
+			.. string.format(
+				"\n%d. %s (%s, %ds)\nin: %.1f KB, %d/s, out: %.1f KB, %d/s\nqueue: %d (max %d), write: %.0fus, compression: %.0f%%\n",
+				index,
+				connection.ip,
+				connection.protocol,
+				connection.age,
+				connection.bytesReceived / 1024,
+				connection.packetsReceivedPerSecond,
+				connection.bytesSent / 1024,
+				connection.packetsSentPerSecond,
+				connection.queueDepth,
+				connection.maxQueueDepth,
+				connection.writeLatency,
+				connection.compressionRatio * 100
+			)
+	end
+	player:popupFYI(text)
+	return true
+end
+
+connectionStats:separator(" ")
+connectionStats:groupType("god")
+connectionStats:register()
@@ -0,0 +1,27 @@
+local globalEvents = TalkAction("/globalevents")
+
+function globalEvents.onSay(player, words, param)
+	-- create log
+	logCommand(player, words, param)
+
+	-- /globalevents [count]
+	local count = tonumber(param) or 10
+	local entries = Game.getGlobalEventStats(count)
+	if #entries == 0 then
+		player:sendTextMessage(MESSAGE_ADMINISTRATOR, "No think or timer globalevents are registered.")
+		return true
+	end
+
+	local text = string.format("Top %d globalevents by total time (times in microseconds):\n", #entries)
+	for index, entry in ipairs(entries) do
+		local average = entry.calls > 0 and math.floor(entry.totalTime / entry.calls) or 0
+		local kind = entry.type == "timer" and "timer" or string.format("every %d ms", entry.interval)
+		text = text .. string.format("\n%d. %s (%s)\ncalls: %d, total: %d, avg: %d, max: %d\n", index, entry.name, kind, entry.calls, entry.totalTime, average, entry.maxTime)
+	end
+	player:popupFYI(text)
+	return true
+end
+
+globalEvents:separator(" ")
+globalEvents:groupType("god")
+globalEvents:register()
@@ -0,0 +1,25 @@
+local luaMemory = TalkAction("/luamemory")
+
+function luaMemory.onSay(player, words, param)
+	-- create log
+	logCommand(player, words, param)
+
+	-- /luamemory [count]
+	local count = tonumber(param) or 10
+	local memory = Game.getLuaMemory(count)
+	local text = string.format("Lua heap: %.1f KB (peak %.1f KB), %d collector cycles, %d idle steps\n", memory.heapBytes / 1024, memory.peakBytes / 1024, memory.gcCycles, memory.idleSteps)
+	if not memory.tracked then
+		text = text .. "\nThe Lua build does not accept the accounting allocator, the allocations are not known.\n"
+	else
+		text = text .. string.format("Allocated since start: %.1f KB in %d allocations, %d frees\n", memory.allocatedBytes / 1024, memory.allocations, memory.frees)
+		for index, entry in ipairs(memory.interfaces) do
+			text = text .. string.format("\n%d. %s\ncalls: %d, allocated: %.1f KB, allocations: %d\n", index, entry.name, entry.calls, entry.allocatedBytes / 1024, entry.allocations)
+		end
+	end
+	player:popupFYI(text)
+	return true
+end
+
+luaMemory:separator(" ")
+luaMemory:groupType("god")
+luaMemory:register()
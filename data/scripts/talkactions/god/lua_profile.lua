@@ -0,0 +1,51 @@
+local luaProfile = TalkAction("/luaprofile")
+
+function luaProfile.onSay(player, words, param)
+	-- create log
+	logCommand(player, words, param)
+
+	-- /luaprofile start | stop | top, [count] | scripts, [count] | dump, file
+	local split = param:split(",")
+	local action = split[1] and split[1]:trim():lower() or ""
+
+	if action == "start" then
+		if Game.startLuaProfiler() then
+			player:sendTextMessage(MESSAGE_ADMINISTRATOR, "Profiling the Lua scripts, the JIT compiler is off until it stops.")
+		else
+			player:sendTextMessage(MESSAGE_ADMINISTRATOR, "The Lua profiler is already running.")
+		end
+	elseif action == "stop" then
+		if Game.stopLuaProfiler() then
+			player:sendTextMessage(MESSAGE_ADMINISTRATOR, "Stopped the Lua profiler.")
+		else
+			player:sendTextMessage(MESSAGE_ADMINISTRATOR, "The Lua profiler is not running.")
+		end
+	elseif action == "top" or action == "scripts" then
+		local count = tonumber(split[2]) or 10
+		local entries = Game.getLuaProfile(count, action == "scripts")
+		if #entries == 0 then
+			player:sendTextMessage(MESSAGE_ADMINISTRATOR, "Nothing was profiled, use /luaprofile start first.")
+			return true
+		end
+
+		local text = string.format("Top %d Lua %s by self time (times in microseconds):\n", #entries, action == "scripts" and "scripts" or "functions")
+		for index, entry in ipairs(entries) do
+			text = text .. string.format("\n%d. %s\ncalls: %d, self: %d, total: %d, allocations: %d bytes\n", index, entry.name, entry.calls, entry.selfTime, entry.totalTime, entry.allocations)
+		end
+		player:popupFYI(text)
+	elseif action == "dump" then
+		local file = split[2] and split[2]:trim() or "lua.profile"
+		if Game.dumpLuaProfile(file) then
+			player:sendTextMessage(MESSAGE_ADMINISTRATOR, "Saved the Lua stacks to " .. file .. ", render it with flamegraph.pl.")
+		else
+			player:sendTextMessage(MESSAGE_ADMINISTRATOR, "Could not save to " .. file .. ".")
+		end
+	else
+		player:sendTextMessage(MESSAGE_ADMINISTRATOR, "Usage: /luaprofile start | stop | top, [count] | scripts, [count] | dump, file")
+	end
+	return true
+end
+
+luaProfile:separator(" ")
+luaProfile:groupType("god")
+luaProfile:register()
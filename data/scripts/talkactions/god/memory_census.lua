@@ -0,0 +1,24 @@
+local memoryCensus = TalkAction("/memory")
+
+function memoryCensus.onSay(player, words, param)
+	-- create log
+	logCommand(player, words, param)
+
+	-- /memory
+	local categories = Game.getMemoryCensus()
+	local total = 0
+	for _, category in ipairs(categories) do
+		total = total + category.bytes
+	end
+
+	local text = string.format("Memory census: %.1f MB in total (approximate, allocator overhead and libraries not counted)\n", total / 1024 / 1024)
+	for index, category in ipairs(categories) do
+		text = text .. string.format("\n%d. %s: %.1f MB, %.0f objects", index, category.name, category.bytes / 1024 / 1024, category.objects)
+	end
+	player:popupFYI(text)
+	return true
+end
+
+memoryCensus:separator(" ")
+memoryCensus:groupType("god")
+memoryCensus:register()
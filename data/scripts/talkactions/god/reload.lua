@@ -1,5 +1,6 @@
 local reloadTypes = {
 	["all"] = RELOAD_TYPE_ALL,
+	["changed"] = RELOAD_TYPE_SCRIPTS_CHANGED,
 	["channel"] = RELOAD_TYPE_CHAT,
 	["chat"] = RELOAD_TYPE_CHAT,
 	["chatchannels"] = RELOAD_TYPE_CHAT,
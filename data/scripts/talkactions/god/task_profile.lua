@@ -0,0 +1,33 @@
+local taskProfile = TalkAction("/taskprofile")
+
+function taskProfile.onSay(player, words, param)
+	-- create log
+	logCommand(player, words, param)
+
+	if not configManager.getBoolean(configKeys.DISPATCHER_PROFILER) then
+		player:sendTextMessage(MESSAGE_ADMINISTRATOR, "The task profiler is disabled, set dispatcherProfiler = true in config.lua and reload it.")
+		return true
+	end
+
+	-- /taskprofile [count], [seconds]
+	local split = param:split(",")
+	local count = tonumber(split[1]) or 10
+	local seconds = tonumber(split[2]) or 60
+
+	local entries = Game.getTaskProfile(count, seconds)
+	if #entries == 0 then
+		player:sendTextMessage(MESSAGE_ADMINISTRATOR, "No tasks were profiled in the last " .. seconds .. " seconds.")
+		return true
+	end
+
+	local text = string.format("Top %d task contexts of the last %d seconds (times in microseconds):\n", #entries, seconds)
+	for index, entry in ipairs(entries) do
+		text = text .. string.format("\n%d. %s\ncount: %d, total: %d, avg: %d, p99: <%d, allocations: %d\n", index, entry.context, entry.count, entry.totalTime, entry.averageTime, entry.p99Time, entry.allocations)
+	end
+	player:popupFYI(text)
+	return true
+end
+
+taskProfile:separator(" ")
+taskProfile:groupType("god")
+taskProfile:register()
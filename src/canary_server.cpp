@@ -13,6 +13,7 @@
 
 #include "declarations.hpp"
 #include "creatures/players/grouping/familiars.hpp"
+#include "creatures/players/highscore_index.hpp"
 #include "creatures/players/storages/storages.hpp"
 #include "database/databasemanager.hpp"
 #include "game/game.hpp"
@@ -20,10 +21,15 @@
 #include "game/scheduling/dispatcher.hpp"
 #include "game/scheduling/events_scheduler.hpp"
 #include "io/iomarket.hpp"
+#include "io/persistence_journal.hpp"
+#include "kv/kv.hpp"
+#include "lib/thread/task_graph.hpp"
 #include "lib/thread/thread_pool.hpp"
 #include "lua/creature/events.hpp"
 #include "lua/modules/modules.hpp"
 #include "lua/scripts/lua_environment.hpp"
+#include "lua/scripts/lua_memory.hpp"
+#include "lua/scripts/lua_workers.hpp"
 #include "lua/scripts/scripts.hpp"
 #include "server/network/protocol/protocollogin.hpp"
 #include "server/network/protocol/protocolstatus.hpp"
@@ -60,6 +66,21 @@ int CanaryServer::run() {
 			try {
 				loadConfigLua();
 
+				if (g_configManager().getBoolean(LOG_ASYNC, __FUNCTION__)) {
+					logger.setAsync(static_cast<size_t>(std::max<int32_t>(g_configManager().getNumber(LOG_ASYNC_QUEUE_SIZE, __FUNCTION__), 1)), g_configManager().getBoolean(LOG_ASYNC_DROP_WHEN_FULL, __FUNCTION__));
+				}
+
+				if (g_configManager().getBoolean(DISPATCHER_TIMING_WHEEL, __FUNCTION__)) {
+					g_dispatcher().enableTimingWheel();
+				}
+
+				g_dispatcher().setIdleHandler([](std::chrono::milliseconds available) {
+					g_luaMemory().idle(available);
+				});
+
+				setupThreadPoolLanes();
+				setupThreadAffinity();
+
 				logger.info("Server protocol: {}.{}{}", CLIENT_VERSION_UPPER, CLIENT_VERSION_LOWER, g_configManager().getBoolean(OLD_PROTOCOL, __FUNCTION__) ? " and 10x allowed!" : "");
 #ifdef FEATURE_METRICS
 				metrics::Options metricsOptions;
@@ -73,11 +94,7 @@ int CanaryServer::run() {
 				}
 				g_metrics().init(metricsOptions);
 #endif
-				rsa.start();
-				initializeDatabase();
-				loadModules();
-				setWorldType();
-				loadMaps();
+				runStartupStages();
 
 				logger.info("Initializing gamestate...");
 				g_game().setGameState(GAME_STATE_INIT);
@@ -87,6 +104,7 @@ int CanaryServer::run() {
 
 				IOMarket::checkExpiredOffers();
 				IOMarket::getInstance().updateStatistics();
+				g_highscoreIndex().load();
 
 				logger.info("Loaded all modules, server starting up...");
 
@@ -300,6 +318,39 @@ void CanaryServer::loadConfigLua() {
 #endif
 }
 
+void CanaryServer::setupThreadPoolLanes() {
+	auto &threadPool = inject<ThreadPool>();
+	threadPool.setLaneThreads(ThreadLane::Database, static_cast<uint16_t>(g_configManager().getNumber(THREAD_POOL_DATABASE_THREADS, __FUNCTION__)));
+	threadPool.setLaneThreads(ThreadLane::Save, static_cast<uint16_t>(g_configManager().getNumber(THREAD_POOL_SAVE_THREADS, __FUNCTION__)));
+	threadPool.setLaneThreads(ThreadLane::Network, static_cast<uint16_t>(g_configManager().getNumber(THREAD_POOL_NETWORK_THREADS, __FUNCTION__)));
+	threadPool.setLaneThreads(ThreadLane::Crypto, static_cast<uint16_t>(g_configManager().getNumber(THREAD_POOL_CRYPTO_THREADS, __FUNCTION__)));
+	g_luaWorkers().start(threadPool);
+}
+
+void CanaryServer::setupThreadAffinity() {
+	const auto gameCore = g_configManager().getNumber(THREAD_AFFINITY_GAME_CORE, __FUNCTION__);
+	const auto numaNode = g_configManager().getNumber(THREAD_AFFINITY_NUMA_NODE, __FUNCTION__);
+	auto workerCores = ThreadPool::parseCoreList(g_configManager().getString(THREAD_AFFINITY_WORKER_CORES, __FUNCTION__));
+
+	if (numaNode >= 0) {
+		const auto nodeCores = ThreadPool::getNumaNodeCores(static_cast<uint16_t>(numaNode));
+		if (nodeCores.empty()) {
+			logger.warn("NUMA node {} was not found, worker threads will not be restricted to it.", numaNode);
+		} else if (workerCores.empty()) {
+			workerCores = nodeCores;
+		} else {
+			std::erase_if(workerCores, [&nodeCores](uint16_t core) { return std::ranges::find(nodeCores, core) == nodeCores.end(); });
+		}
+	}
+
+	if (gameCore < 0 && workerCores.empty()) {
+		return;
+	}
+
+	// Called from the dispatcher, so the calling thread is the one running the game loop
+	inject<ThreadPool>().setAffinity(gameCore, std::move(workerCores));
+}
+
 void CanaryServer::initializeDatabase() {
 	logger.info("Establishing database connection... ");
 	if (!Database::getInstance().connect()) {
@@ -317,12 +368,62 @@ void CanaryServer::initializeDatabase() {
 
 	DatabaseManager::updateDatabase();
 
+	if (g_configManager().getBoolean(PERSISTENCE_JOURNAL, __FUNCTION__)
+	    && !g_persistenceJournal().open(g_configManager().getString(PERSISTENCE_JOURNAL_FILE, __FUNCTION__))) {
+		throw FailedToInitializeCanary("Failed to replay the persistence journal!");
+	}
+
+	if (g_configManager().getString(KV_BACKEND, __FUNCTION__) == "file"
+	    && !g_kv().useEmbeddedStorage(g_configManager().getString(KV_FILE, __FUNCTION__))) {
+		throw FailedToInitializeCanary("Failed to open the KV file!");
+	}
+
 	if (g_configManager().getBoolean(OPTIMIZE_DATABASE, __FUNCTION__)
 	    && !DatabaseManager::optimizeTables()) {
 		logger.debug("No tables were optimized");
 	}
 }
 
+void CanaryServer::runStartupStages() {
+	// The stages that only parse files or talk to the database run on the thread pool,
+	// the ones that need the Lua state or the game run here, once their dependencies are done
+	TaskGraph startup(inject<ThreadPool>());
+	const auto coreFolder = g_configManager().getString(CORE_DIRECTORY, __FUNCTION__);
+
+	startup.add("rsa", {}, true, [this] { rsa.start(); });
+	startup.add("database", {}, true, [this] { initializeDatabase(); });
+	startup.add("appearances", {}, true, [this, coreFolder] {
+		modulesLoadHelper((g_game().loadAppearanceProtobuf(coreFolder + "/items/appearances.dat") == ERROR_NONE), "appearances.dat");
+	});
+	startup.add("vocations", {}, true, [this] {
+		modulesLoadHelper(g_vocations().loadFromXml(), "XML/vocations.xml");
+		modulesLoadHelper(g_eventsScheduler().loadScheduleEventFromXml(), "XML/events.xml");
+		modulesLoadHelper(g_storages().loadFromXML(), "XML/storages.xml");
+	});
+	startup.add("outfits", { "appearances" }, true, [this] {
+		modulesLoadHelper(Outfits::getInstance().loadFromXml(), "XML/outfits.xml");
+		modulesLoadHelper(Familiars::getInstance().loadFromXml(), "XML/familiars.xml");
+	});
+	startup.add("items", { "appearances" }, true, [this] {
+		modulesLoadHelper(g_imbuements().loadFromXml(), "XML/imbuements.xml");
+		modulesLoadHelper(Item::items.loadFromXml(), "items.xml");
+	});
+	startup.add("map", { "items" }, true, [] {
+		g_game().parseMainMap(g_configManager().getString(MAP_NAME, __FUNCTION__));
+	});
+	startup.add("scripts", { "database", "vocations", "outfits", "items" }, false, [this] { loadModules(); });
+	startup.add("world", { "scripts", "map" }, false, [this] {
+		setWorldType();
+		loadMaps();
+	});
+
+	startup.run();
+
+	for (const auto &stage : startup.getTimeline()) {
+		logger.info("Startup stage {} took {} ms, started at {} ms{}", stage.name, stage.duration, stage.startedAt, stage.background ? " on the thread pool" : "");
+	}
+}
+
 void CanaryServer::loadModules() {
 	// If "USE_ANY_DATAPACK_FOLDER" is set to true then you can choose any datapack folder for your server
 	const auto useAnyDatapack = g_configManager().getBoolean(USE_ANY_DATAPACK_FOLDER, __FUNCTION__);
@@ -341,20 +442,8 @@ void CanaryServer::loadModules() {
 		g_luaEnvironment().initState();
 	}
 
+	// appearances.dat and the XML files were loaded by the earlier startup stages
 	auto coreFolder = g_configManager().getString(CORE_DIRECTORY, __FUNCTION__);
-	// Load appearances.dat first
-	modulesLoadHelper((g_game().loadAppearanceProtobuf(coreFolder + "/items/appearances.dat") == ERROR_NONE), "appearances.dat");
-
-	// Load XML folder dependencies (order matters)
-	modulesLoadHelper(g_vocations().loadFromXml(), "XML/vocations.xml");
-	modulesLoadHelper(g_eventsScheduler().loadScheduleEventFromXml(), "XML/events.xml");
-	modulesLoadHelper(Outfits::getInstance().loadFromXml(), "XML/outfits.xml");
-	modulesLoadHelper(Familiars::getInstance().loadFromXml(), "XML/familiars.xml");
-	modulesLoadHelper(g_imbuements().loadFromXml(), "XML/imbuements.xml");
-	modulesLoadHelper(g_storages().loadFromXML(), "XML/storages.xml");
-
-	modulesLoadHelper(Item::items.loadFromXml(), "items.xml");
-
 	const auto datapackFolder = g_configManager().getString(DATA_DIRECTORY, __FUNCTION__);
 	logger.debug("Loading core scripts on folder: {}/", coreFolder);
 	// Load first core Lua libs
@@ -377,6 +466,7 @@ void CanaryServer::loadModules() {
 	g_game().loadBoostedCreature();
 	g_ioBosstiary().loadBoostedBoss();
 	g_ioprey().initializeTaskHuntOptions();
+	g_ioprey().reloadMonsterCandidates();
 	g_game().logCyclopediaStats();
 }
 
@@ -61,6 +61,9 @@ private:
 	static std::string getPlatform();
 
 	void loadConfigLua();
+	void setupThreadPoolLanes();
+	void setupThreadAffinity();
+	void runStartupStages();
 	void initializeDatabase();
 	void loadModules();
 	void setWorldType();
@@ -32,6 +32,7 @@ enum ConfigKey_t : uint16_t {
 	BOSS_DEFAULT_TIME_TO_DEFEAT,
 	BOSS_DEFAULT_TIME_TO_FIGHT_AGAIN,
 	BOSSTIARY_KILL_MULTIPLIER,
+	BROADCAST_PARALLEL_DELIVERY,
 	BUY_AOL_COMMAND_FEE,
 	BUY_BLESS_COMMAND_FEE,
 	CHECK_EXPIRED_MARKET_OFFERS_EACH_MINUTES,
@@ -59,7 +60,12 @@ enum ConfigKey_t : uint16_t {
 	DISABLE_MONSTER_ARMOR,
 	DISCORD_SEND_FOOTER,
 	DISCORD_WEBHOOK_DELAY_MS,
+	DISCORD_WEBHOOK_MAX_QUEUE,
 	DISCORD_WEBHOOK_URL,
+	DISPATCHER_CYCLE_BUDGET,
+	DISPATCHER_PROFILER,
+	DISPATCHER_TIMING_WHEEL,
+	DISPATCHER_WORK_STEALING,
 	EMOTE_SPELLS,
 	ENABLE_PLAYER_PUT_ITEM_IN_AMMO_SLOT,
 	ENABLE_SUPPORT_OUTFIT,
@@ -67,6 +73,7 @@ enum ConfigKey_t : uint16_t {
 	EXP_FROM_PLAYERS_LEVEL_RANGE,
 	EXPERIENCE_FROM_PLAYERS,
 	FAMILIAR_TIME,
+	FLOW_FIELD_RADIUS,
 	FORGE_AMOUNT_MULTIPLIER,
 	FORGE_BASE_SUCCESS_RATE,
 	FORGE_BONUS_SUCCESS_RATE,
@@ -87,10 +94,14 @@ enum ConfigKey_t : uint16_t {
 	FORGE_TIER_LOSS_REDUCTION,
 	FORGE_TRANSFER_DUST_COST,
 	FRAG_TIME,
+	FRAME_DUMP_FILE,
+	FRAME_DUMP_THRESHOLD,
+	FRAME_PROFILER_FRAMES,
 	FREE_DEPOT_LIMIT,
 	FREE_PREMIUM,
 	FREE_QUEST_STAGE,
 	GAME_PORT,
+	GLOBAL_EVENT_BUDGET,
 	GLOBAL_SERVER_SAVE_CLEAN_MAP,
 	GLOBAL_SERVER_SAVE_CLOSE,
 	GLOBAL_SERVER_SAVE_NOTIFY_DURATION,
@@ -118,12 +129,26 @@ enum ConfigKey_t : uint16_t {
 	HOUSE_PURSHASED_SHOW_PRICE,
 	HOUSE_RENT_PERIOD,
 	HOUSE_RENT_RATE,
+	INTEREST_EDGE_DISTANCE,
+	INTEREST_ICONS_DELAY,
+	INTEREST_LIGHT_DELAY,
+	INTEREST_OUTFIT_DELAY,
+	INTEREST_SKULL_DELAY,
 	INVENTORY_GLOW,
 	IP,
 	KICK_AFTER_MINUTES,
+	KV_BACKEND,
+	KV_FILE,
+	LAZY_DEPOT_LOADING,
 	LOCATION,
+	LOGIN_BATCH_SIZE,
+	LOGIN_CRYPTO_QUEUE_LIMIT,
 	LOGIN_PORT,
+	LOGIN_PREFETCH_SECTIONS,
 	LOGLEVEL,
+	LOG_ASYNC,
+	LOG_ASYNC_DROP_WHEN_FULL,
+	LOG_ASYNC_QUEUE_SIZE,
 	LOOTPOUCH_MAXLIMIT,
 	LOW_LEVEL_BONUS_EXP,
 	LOYALTY_BONUS_PERCENTAGE_MULTIPLIER,
@@ -131,11 +156,22 @@ enum ConfigKey_t : uint16_t {
 	LOYALTY_POINTS_PER_CREATION_DAY,
 	LOYALTY_POINTS_PER_PREMIUM_DAY_PURCHASED,
 	LOYALTY_POINTS_PER_PREMIUM_DAY_SPENT,
+	LUA_BYTECODE_CACHE_DIRECTORY,
+	LUA_GC_GENERATIONAL,
+	LUA_GC_IDLE_TIME,
+	LUA_GC_PAUSE,
+	LUA_GC_STEP_MULTIPLIER,
+	LUA_WORKER_INSTRUCTION_LIMIT,
+	LUA_WORKER_STATES,
 	M_CONST,
 	MAINTAIN_MODE_MESSAGE,
 	MAP_AUTHOR,
+	MAP_CLEAN_BATCH_SIZE,
+	MAP_CLEAN_DELAY,
 	MAP_DOWNLOAD_URL,
 	MAP_NAME,
+	MAP_SNAPSHOT,
+	MAP_TILE_EVICTION_TIME,
 	MARKET_OFFER_DURATION,
 	MARKET_REFRESH_PRICES,
 	MARKET_PREMIUM,
@@ -151,6 +187,7 @@ enum ConfigKey_t : uint16_t {
 	MAX_PLAYERS_PER_ACCOUNT,
 	MAX_PLAYERS,
 	MAX_SPEED_ATTACKONFIST,
+	MEMORY_CENSUS_INTERVAL,
 	METRICS_ENABLE_OSTREAM,
 	METRICS_ENABLE_PROMETHEUS,
 	METRICS_OSTREAM_INTERVAL,
@@ -166,8 +203,17 @@ enum ConfigKey_t : uint16_t {
 	MYSQL_DB,
 	MYSQL_HOST,
 	MYSQL_PASS,
+	MYSQL_POOL_SIZE,
+	MYSQL_REPLICA_HOST,
+	MYSQL_REPLICA_MAX_LAG,
+	MYSQL_REPLICA_POOL_SIZE,
+	MYSQL_REPLICA_PORT,
 	MYSQL_SOCK,
 	MYSQL_USER,
+	NETWORK_IO_THREADS,
+	NETWORK_WRITE_BATCH,
+	OFFLINE_PLAYER_CACHE_SIZE,
+	OFFLINE_PLAYER_CACHE_TIME,
 	OLD_PROTOCOL,
 	ONE_PLAYER_ON_ACCOUNT,
 	ONLY_INVITED_CAN_MOVE_HOUSE_ITEMS,
@@ -179,12 +225,24 @@ enum ConfigKey_t : uint16_t {
 	ORANGE_SKULL_DURATION,
 	OWNER_EMAIL,
 	OWNER_NAME,
+	PACKET_COMPRESSION_MAX_COST,
+	PACKET_COMPRESSION_MIN_SIZE,
+	PACKET_RATE_LIMIT_COST,
+	PACKET_RATE_LIMITS,
 	PARALLELISM,
 	PARTY_AUTO_SHARE_EXPERIENCE,
 	PARTY_SHARE_RANGE_MULTIPLIER,
 	PARTY_LIST_MAX_DISTANCE,
 	PARTY_SHARE_LOOT_BOOSTS_DIMINISHING_FACTOR,
 	PARTY_SHARE_LOOT_BOOSTS,
+	PATHFINDING_CACHE_TIME,
+	PATHFINDING_CACHE_TOLERANCE,
+	PATHFINDING_HIERARCHICAL_DISTANCE,
+	PATHFINDING_LONG_DISTANCE,
+	PATHFINDING_LONG_MAX_NODES,
+	PERSISTENCE_JOURNAL,
+	PERSISTENCE_JOURNAL_COMPACT_INTERVAL,
+	PERSISTENCE_JOURNAL_FILE,
 	PREMIUM_DEPOT_LIMIT,
 	PREY_BONUS_REROLL_PRICE,
 	PREY_BONUS_TIME,
@@ -242,12 +300,20 @@ enum ConfigKey_t : uint16_t {
 	RUSE_CHANCE_FORMULA_C,
 	SAVE_INTERVAL_TIME,
 	SAVE_INTERVAL_TYPE,
+	SAVE_PLAYERS_SPREAD_INTERVAL,
+	SAVE_PLAYERS_TIME_BUDGET,
 	SCRIPTS_CONSOLE_LOGS,
 	SERVER_MOTD,
 	SERVER_NAME,
 	SHOW_LOOTS_IN_BESTIARY,
+	SHUTDOWN_SAVE_TIMEOUT,
 	SKULLED_DEATH_LOSE_STORE_ITEM,
+	SLOW_QUERY_EXPLAIN,
+	SLOW_QUERY_THRESHOLD,
 	SORT_LOOT_BY_CHANCE,
+	SPAWN_ACTIVITY_FILE,
+	SPAWN_ACTIVITY_INTERVAL,
+	SPAWN_ACTIVITY_SECTOR_SIZE,
 	SQL_PORT,
 	STAIRHOP_DELAY,
 	STAMINA_GREEN_DELAY,
@@ -261,6 +327,7 @@ enum ConfigKey_t : uint16_t {
 	START_STREAK_LEVEL,
 	STASH_ITEMS,
 	STASH_MOVING,
+	STATUS_CACHE_TIME,
 	STATUS_PORT,
 	STATUSQUERY_TIMEOUT,
 	STORE_COIN_PACKET,
@@ -276,9 +343,17 @@ enum ConfigKey_t : uint16_t {
 	TASK_HUNTING_SELECTION_LIST_PRICE,
 	TELEPORT_PLAYER_TO_VOCATION_ROOM,
 	TELEPORT_SUMMONS,
+	THREAD_AFFINITY_GAME_CORE,
+	THREAD_AFFINITY_NUMA_NODE,
+	THREAD_AFFINITY_WORKER_CORES,
+	THREAD_POOL_CRYPTO_THREADS,
+	THREAD_POOL_DATABASE_THREADS,
+	THREAD_POOL_NETWORK_THREADS,
+	THREAD_POOL_SAVE_THREADS,
 	TIBIADROME_CONCOCTION_COOLDOWN,
 	TIBIADROME_CONCOCTION_DURATION,
 	TIBIADROME_CONCOCTION_TICK_TYPE,
+	TILE_DESCRIPTION_CACHE_SIZE,
 	TOGGLE_ATTACK_SPEED_ONFIST,
 	TOGGLE_CHAIN_SYSTEM,
 	TOGGLE_DOWNLOAD_MAP,
@@ -323,6 +398,7 @@ enum ConfigKey_t : uint16_t {
 	WHEEL_ATELIER_ROTATE_REGULAR_COST,
 	WHEEL_POINTS_PER_LEVEL,
 	WHITE_SKULL_TIME,
+	WORLD_SNAPSHOT_INTERVAL,
 	WORLD_TYPE,
 	XP_DISPLAY_MODE
 };
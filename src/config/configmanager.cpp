@@ -37,6 +37,13 @@ bool ConfigManager::load() {
 		return false;
 	}
 
+	// The keys loaded only once keep their values
+	auto next = std::make_unique<ConfigValues>();
+	if (const auto* current = configs.load(std::memory_order_acquire)) {
+		*next = *current;
+	}
+	loadingConfigs = next.get();
+
 #ifndef DEBUG_LOG
 	g_logger().setLevel(loadStringConfig(L, LOGLEVEL, "logLevel", "info"));
 #endif
@@ -46,8 +53,13 @@ bool ConfigManager::load() {
 	if (!loaded) {
 		loadBoolConfig(L, BIND_ONLY_GLOBAL_ADDRESS, "bindOnlyGlobalAddress", false);
 		loadBoolConfig(L, DISABLE_LEGACY_RAIDS, "disableLegacyRaids", false);
+		loadBoolConfig(L, DISPATCHER_TIMING_WHEEL, "dispatcherTimingWheel", false);
+		loadBoolConfig(L, LOG_ASYNC, "logAsync", true);
+		loadBoolConfig(L, LOG_ASYNC_DROP_WHEN_FULL, "logAsyncDropWhenFull", true);
+		loadBoolConfig(L, MAP_SNAPSHOT, "mapSnapshot", false);
 		loadBoolConfig(L, OLD_PROTOCOL, "allowOldProtocol", true);
 		loadBoolConfig(L, OPTIMIZE_DATABASE, "startupDatabaseOptimization", true);
+		loadBoolConfig(L, PERSISTENCE_JOURNAL, "persistenceJournal", true);
 		loadBoolConfig(L, RANDOM_MONSTER_SPAWN, "randomMonsterSpawn", false);
 		loadBoolConfig(L, RESET_SESSIONS_ON_STARTUP, "resetSessionsOnStartup", false);
 		loadBoolConfig(L, TOGGLE_MAINTAIN_MODE, "toggleMaintainMode", false);
@@ -60,16 +72,36 @@ bool ConfigManager::load() {
 		loadIntConfig(L, FREE_DEPOT_LIMIT, "freeDepotLimit", 2000);
 		loadIntConfig(L, GAME_PORT, "gameProtocolPort", 7172);
 		loadIntConfig(L, LOGIN_PORT, "loginProtocolPort", 7171);
+		loadIntConfig(L, LOG_ASYNC_QUEUE_SIZE, "logAsyncQueueSize", 8192);
+		loadIntConfig(L, LUA_WORKER_INSTRUCTION_LIMIT, "luaWorkerInstructionLimit", 10000000);
+		loadIntConfig(L, LUA_WORKER_STATES, "luaWorkerStates", 2);
+		loadIntConfig(L, FRAME_PROFILER_FRAMES, "frameProfilerFrames", 300);
+		loadIntConfig(L, MAP_TILE_EVICTION_TIME, "mapTileEvictionTime", 0);
 		loadIntConfig(L, MARKET_OFFER_DURATION, "marketOfferDuration", 30 * 24 * 60 * 60);
 		loadIntConfig(L, MARKET_REFRESH_PRICES, "marketRefreshPricesInterval", 30);
+		loadIntConfig(L, MEMORY_CENSUS_INTERVAL, "memoryCensusInterval", 0);
+		loadIntConfig(L, MYSQL_POOL_SIZE, "mysqlPoolSize", 4);
+		loadIntConfig(L, MYSQL_REPLICA_POOL_SIZE, "mysqlReplicaPoolSize", 2);
+		loadIntConfig(L, MYSQL_REPLICA_PORT, "mysqlReplicaPort", 3306);
+		loadIntConfig(L, PERSISTENCE_JOURNAL_COMPACT_INTERVAL, "persistenceJournalCompactInterval", 60);
+		loadIntConfig(L, SAVE_PLAYERS_SPREAD_INTERVAL, "savePlayersSpreadInterval", 0);
 		loadIntConfig(L, PREMIUM_DEPOT_LIMIT, "premiumDepotLimit", 8000);
+		loadIntConfig(L, SPAWN_ACTIVITY_INTERVAL, "spawnActivityInterval", 0);
 		loadIntConfig(L, SQL_PORT, "mysqlPort", 3306);
 		loadIntConfig(L, STASH_ITEMS, "stashItemCount", 5000);
 		loadIntConfig(L, STATUS_PORT, "statusProtocolPort", 7171);
+		loadIntConfig(L, THREAD_AFFINITY_GAME_CORE, "threadAffinityGameCore", -1);
+		loadIntConfig(L, THREAD_AFFINITY_NUMA_NODE, "threadAffinityNumaNode", -1);
+		loadIntConfig(L, THREAD_POOL_CRYPTO_THREADS, "threadPoolCryptoThreads", 2);
+		loadIntConfig(L, THREAD_POOL_DATABASE_THREADS, "threadPoolDatabaseThreads", 2);
+		loadIntConfig(L, THREAD_POOL_NETWORK_THREADS, "threadPoolNetworkThreads", 1);
+		loadIntConfig(L, THREAD_POOL_SAVE_THREADS, "threadPoolSaveThreads", 1);
 
 		loadStringConfig(L, AUTH_TYPE, "authType", "password");
 		loadStringConfig(L, HOUSE_RENT_PERIOD, "houseRentPeriod", "never");
 		loadStringConfig(L, IP, "ip", "127.0.0.1");
+		loadStringConfig(L, KV_BACKEND, "kvBackend", "sql");
+		loadStringConfig(L, KV_FILE, "kvFile", "kv.data");
 		loadStringConfig(L, MAINTAIN_MODE_MESSAGE, "maintainModeMessage", "");
 		loadStringConfig(L, MAP_AUTHOR, "mapAuthor", "Eduardo Dantas");
 		loadStringConfig(L, MAP_DOWNLOAD_URL, "mapDownloadUrl", "");
@@ -77,8 +109,12 @@ bool ConfigManager::load() {
 		loadStringConfig(L, MYSQL_DB, "mysqlDatabase", "canary");
 		loadStringConfig(L, MYSQL_HOST, "mysqlHost", "127.0.0.1");
 		loadStringConfig(L, MYSQL_PASS, "mysqlPass", "");
+		loadStringConfig(L, MYSQL_REPLICA_HOST, "mysqlReplicaHost", "");
 		loadStringConfig(L, MYSQL_SOCK, "mysqlSock", "");
 		loadStringConfig(L, MYSQL_USER, "mysqlUser", "root");
+		loadStringConfig(L, PERSISTENCE_JOURNAL_FILE, "persistenceJournalFile", "persistence.journal");
+		loadStringConfig(L, SPAWN_ACTIVITY_FILE, "spawnActivityFile", "spawn_activity.csv");
+		loadStringConfig(L, THREAD_AFFINITY_WORKER_CORES, "threadAffinityWorkerCores", "");
 	}
 
 	loadBoolConfig(L, AIMBOT_HOTKEY_ENABLED, "hotkeyAimbotEnabled", true);
@@ -87,11 +123,15 @@ bool ConfigManager::load() {
 	loadBoolConfig(L, AUTOBANK, "autoBank", false);
 	loadBoolConfig(L, AUTOLOOT, "autoLoot", false);
 	loadBoolConfig(L, BOOSTED_BOSS_SLOT, "boostedBossSlot", true);
+	loadBoolConfig(L, BROADCAST_PARALLEL_DELIVERY, "broadcastParallelDelivery", true);
 	loadBoolConfig(L, CLASSIC_ATTACK_SPEED, "classicAttackSpeed", false);
 	loadBoolConfig(L, CLEAN_PROTECTION_ZONES, "cleanProtectionZones", false);
 	loadBoolConfig(L, CONVERT_UNSAFE_SCRIPTS, "convertUnsafeScripts", true);
 	loadBoolConfig(L, DISABLE_MONSTER_ARMOR, "disableMonsterArmor", false);
 	loadBoolConfig(L, DISCORD_SEND_FOOTER, "discordSendFooter", true);
+	loadBoolConfig(L, DISPATCHER_PROFILER, "dispatcherProfiler", false);
+	loadBoolConfig(L, DISPATCHER_WORK_STEALING, "dispatcherWorkStealing", true);
+	loadBoolConfig(L, SLOW_QUERY_EXPLAIN, "slowQueryExplain", false);
 	loadBoolConfig(L, EMOTE_SPELLS, "emoteSpells", false);
 	loadBoolConfig(L, ENABLE_PLAYER_PUT_ITEM_IN_AMMO_SLOT, "enablePlayerPutItemInAmmoSlot", false);
 	loadBoolConfig(L, ENABLE_SUPPORT_OUTFIT, "enableSupportOutfit", true);
@@ -104,7 +144,10 @@ bool ConfigManager::load() {
 	loadBoolConfig(L, HOUSE_OWNED_BY_ACCOUNT, "houseOwnedByAccount", false);
 	loadBoolConfig(L, HOUSE_PURSHASED_SHOW_PRICE, "housePurchasedShowPrice", false);
 	loadBoolConfig(L, INVENTORY_GLOW, "inventoryGlowOnFiveBless", false);
+	loadBoolConfig(L, LAZY_DEPOT_LOADING, "lazyDepotLoading", true);
+	loadBoolConfig(L, LOGIN_PREFETCH_SECTIONS, "loginPrefetchSections", true);
 	loadBoolConfig(L, LOYALTY_ENABLED, "loyaltyEnabled", true);
+	loadBoolConfig(L, LUA_GC_GENERATIONAL, "luaGarbageCollectorGenerational", false);
 	loadBoolConfig(L, MARKET_PREMIUM, "premiumToCreateMarketOffer", true);
 	loadBoolConfig(L, METRICS_ENABLE_OSTREAM, "metricsEnableOstream", false);
 	loadBoolConfig(L, METRICS_ENABLE_PROMETHEUS, "metricsEnablePrometheus", false);
@@ -225,9 +268,12 @@ bool ConfigManager::load() {
 	loadIntConfig(L, DEFAULT_DESPAWNRANGE, "deSpawnRange", 2);
 	loadIntConfig(L, DEPOTCHEST, "depotChest", 4);
 	loadIntConfig(L, DISCORD_WEBHOOK_DELAY_MS, "discordWebhookDelayMs", Webhook::DEFAULT_DELAY_MS);
+	loadIntConfig(L, DISCORD_WEBHOOK_MAX_QUEUE, "discordWebhookMaxQueue", Webhook::DEFAULT_MAX_QUEUE);
+	loadIntConfig(L, DISPATCHER_CYCLE_BUDGET, "dispatcherCycleBudget", 0);
 	loadIntConfig(L, EX_ACTIONS_DELAY_INTERVAL, "timeBetweenExActions", 1000);
 	loadIntConfig(L, EXP_FROM_PLAYERS_LEVEL_RANGE, "expFromPlayersLevelRange", 75);
 	loadIntConfig(L, FAMILIAR_TIME, "familiarTime", 30);
+	loadIntConfig(L, FLOW_FIELD_RADIUS, "flowFieldRadius", 10);
 	loadIntConfig(L, FORGE_BASE_SUCCESS_RATE, "forgeBaseSuccessRate", 50);
 	loadIntConfig(L, FORGE_BONUS_SUCCESS_RATE, "forgeBonusSuccessRate", 15);
 	loadIntConfig(L, FORGE_CONVERGENCE_FUSION_DUST_COST, "forgeConvergenceFusionDustCost", 130);
@@ -246,6 +292,12 @@ bool ConfigManager::load() {
 	loadIntConfig(L, FORGE_TRANSFER_DUST_COST, "forgeTransferDustCost", 100);
 	loadIntConfig(L, FRAG_TIME, "timeToDecreaseFrags", 24 * 60 * 60 * 1000);
 	loadIntConfig(L, FREE_QUEST_STAGE, "freeQuestStage", 1);
+	loadIntConfig(L, FRAME_DUMP_THRESHOLD, "frameDumpThreshold", 100);
+	loadIntConfig(L, SLOW_QUERY_THRESHOLD, "slowQueryThreshold", 0);
+	loadIntConfig(L, GLOBAL_EVENT_BUDGET, "globalEventBudget", 20);
+	loadIntConfig(L, LUA_GC_IDLE_TIME, "luaGarbageCollectorIdleTime", 2);
+	loadIntConfig(L, LUA_GC_PAUSE, "luaGarbageCollectorPause", 200);
+	loadIntConfig(L, LUA_GC_STEP_MULTIPLIER, "luaGarbageCollectorStepMultiplier", 200);
 	loadIntConfig(L, GLOBAL_SERVER_SAVE_NOTIFY_DURATION, "globalServerSaveNotifyDuration", 5);
 	loadIntConfig(L, HAZARD_CRITICAL_CHANCE, "hazardCriticalChance", 750);
 	loadIntConfig(L, HAZARD_CRITICAL_INTERVAL, "hazardCriticalInterval", 2000);
@@ -262,12 +314,23 @@ bool ConfigManager::load() {
 	loadIntConfig(L, HOUSE_BUY_LEVEL, "houseBuyLevel", 0);
 	loadIntConfig(L, HOUSE_LOSE_AFTER_INACTIVITY, "houseLoseAfterInactivity", 0);
 	loadIntConfig(L, HOUSE_PRICE_PER_SQM, "housePriceEachSQM", 1000);
+	loadIntConfig(L, INTEREST_EDGE_DISTANCE, "interestEdgeDistance", 0);
+	loadIntConfig(L, INTEREST_ICONS_DELAY, "interestIconsDelay", 500);
+	loadIntConfig(L, INTEREST_LIGHT_DELAY, "interestLightDelay", 1000);
+	loadIntConfig(L, INTEREST_OUTFIT_DELAY, "interestOutfitDelay", 500);
+	loadIntConfig(L, INTEREST_SKULL_DELAY, "interestSkullDelay", 0);
 	loadIntConfig(L, KICK_AFTER_MINUTES, "kickIdlePlayerAfterMinutes", 15);
+	loadIntConfig(L, LOGIN_BATCH_SIZE, "loginBatchSize", 20);
+	loadIntConfig(L, LOGIN_CRYPTO_QUEUE_LIMIT, "loginCryptoQueueLimit", 500);
+	loadIntConfig(L, OFFLINE_PLAYER_CACHE_SIZE, "offlinePlayerCacheSize", 64);
+	loadIntConfig(L, OFFLINE_PLAYER_CACHE_TIME, "offlinePlayerCacheTime", 30000);
 	loadIntConfig(L, LOOTPOUCH_MAXLIMIT, "lootPouchMaxLimit", 2000);
 	loadIntConfig(L, LOW_LEVEL_BONUS_EXP, "lowLevelBonusExp", 50);
 	loadIntConfig(L, LOYALTY_POINTS_PER_CREATION_DAY, "loyaltyPointsPerCreationDay", 1);
 	loadIntConfig(L, LOYALTY_POINTS_PER_PREMIUM_DAY_PURCHASED, "loyaltyPointsPerPremiumDayPurchased", 0);
 	loadIntConfig(L, LOYALTY_POINTS_PER_PREMIUM_DAY_SPENT, "loyaltyPointsPerPremiumDaySpent", 0);
+	loadIntConfig(L, MAP_CLEAN_BATCH_SIZE, "mapCleanBatchSize", 100);
+	loadIntConfig(L, MAP_CLEAN_DELAY, "mapCleanDelay", 0);
 	loadIntConfig(L, MAX_ALLOWED_ON_A_DUMMY, "maxAllowedOnADummy", 1);
 	loadIntConfig(L, MAX_CONTAINER_ITEM, "maxItem", 5000);
 	loadIntConfig(L, MAX_CONTAINER, "maxContainer", 500);
@@ -286,9 +349,20 @@ bool ConfigManager::load() {
 	loadIntConfig(L, MIN_TOWN_ID_TO_BANK_TRANSFER, "minTownIdToBankTransfer", 3);
 	loadIntConfig(L, MONTH_KILLS_TO_RED, "monthKillsToRedSkull", 10);
 	loadIntConfig(L, MULTIPLIER_ATTACKONFIST, "multiplierSpeedOnFist", 5);
+	loadIntConfig(L, MYSQL_REPLICA_MAX_LAG, "mysqlReplicaMaxLag", 5);
+	loadIntConfig(L, NETWORK_IO_THREADS, "networkIoThreads", 1);
+	loadIntConfig(L, NETWORK_WRITE_BATCH, "networkWriteBatch", 32);
 	loadIntConfig(L, ORANGE_SKULL_DURATION, "orangeSkullDuration", 7);
+	loadIntConfig(L, PACKET_COMPRESSION_MAX_COST, "packetCompressionMaxCost", 200);
+	loadIntConfig(L, PACKET_COMPRESSION_MIN_SIZE, "packetCompressionMinSize", 128);
+	loadIntConfig(L, PACKET_RATE_LIMIT_COST, "packetRateLimitCost", 1000);
 	loadIntConfig(L, PARALLELISM, "parallelism", 2);
 	loadIntConfig(L, PARTY_LIST_MAX_DISTANCE, "partyListMaxDistance", 0);
+	loadIntConfig(L, PATHFINDING_CACHE_TIME, "pathfindingCacheTime", 1000);
+	loadIntConfig(L, PATHFINDING_CACHE_TOLERANCE, "pathfindingCacheTolerance", 1);
+	loadIntConfig(L, PATHFINDING_HIERARCHICAL_DISTANCE, "pathfindingHierarchicalDistance", 48);
+	loadIntConfig(L, PATHFINDING_LONG_DISTANCE, "pathfindingLongDistance", 20);
+	loadIntConfig(L, PATHFINDING_LONG_MAX_NODES, "pathfindingLongMaxNodes", 4096);
 	loadIntConfig(L, PREY_BONUS_REROLL_PRICE, "preyBonusRerollPrice", 1);
 	loadIntConfig(L, PREY_BONUS_TIME, "preyBonusTime", 7200);
 	loadIntConfig(L, PREY_FREE_REROLL_TIME, "preyFreeRerollTime", 72000);
@@ -308,6 +382,9 @@ bool ConfigManager::load() {
 	loadIntConfig(L, RED_SKULL_DURATION, "redSkullDuration", 30);
 	loadIntConfig(L, REWARD_CHEST_MAX_COLLECT_ITEMS, "rewardChestMaxCollectItems", 200);
 	loadIntConfig(L, SAVE_INTERVAL_TIME, "saveIntervalTime", 1);
+	loadIntConfig(L, SAVE_PLAYERS_TIME_BUDGET, "savePlayersTimeBudget", 200);
+	loadIntConfig(L, SHUTDOWN_SAVE_TIMEOUT, "shutdownSaveTimeout", 60);
+	loadIntConfig(L, SPAWN_ACTIVITY_SECTOR_SIZE, "spawnActivitySectorSize", 32);
 	loadIntConfig(L, STAIRHOP_DELAY, "stairJumpExhaustion", 2000);
 	loadIntConfig(L, STAMINA_GREEN_DELAY, "staminaGreenDelay", 5);
 	loadIntConfig(L, STAMINA_ORANGE_DELAY, "staminaOrangeDelay", 1);
@@ -316,6 +393,7 @@ bool ConfigManager::load() {
 	loadIntConfig(L, STAMINA_TRAINER_GAIN, "staminaTrainerGain", 1);
 	loadFloatConfig(L, PARTY_SHARE_RANGE_MULTIPLIER, "partyShareRangeMultiplier", 1.5f);
 	loadIntConfig(L, START_STREAK_LEVEL, "startStreakLevel", 0);
+	loadIntConfig(L, STATUS_CACHE_TIME, "statusCacheTime", 5000);
 	loadIntConfig(L, STATUSQUERY_TIMEOUT, "statusTimeout", 5000);
 	loadIntConfig(L, STORE_COIN_PACKET, "coinPacketSize", 25);
 	loadIntConfig(L, STOREINBOX_MAXLIMIT, "storeInboxMaxLimit", 2000);
@@ -327,6 +405,7 @@ bool ConfigManager::load() {
 	loadIntConfig(L, TASK_HUNTING_SELECTION_LIST_PRICE, "taskHuntingSelectListPrice", 5);
 	loadIntConfig(L, TIBIADROME_CONCOCTION_COOLDOWN, "tibiadromeConcoctionCooldown", 24 * 60 * 60);
 	loadIntConfig(L, TIBIADROME_CONCOCTION_DURATION, "tibiadromeConcoctionDuration", 1 * 60 * 60);
+	loadIntConfig(L, TILE_DESCRIPTION_CACHE_SIZE, "tileDescriptionCacheSize", 262144);
 	loadIntConfig(L, TRANSCENDANCE_AVATAR_DURATION, "transcendanceAvatarDuration", 7000);
 	loadIntConfig(L, VIP_BONUS_EXP, "vipBonusExp", 0);
 	loadIntConfig(L, VIP_BONUS_LOOT, "vipBonusLoot", 0);
@@ -341,6 +420,7 @@ bool ConfigManager::load() {
 	loadIntConfig(L, WHEEL_ATELIER_ROTATE_REGULAR_COST, "wheelAtelierRotateRegularCost", 250000);
 	loadIntConfig(L, WHEEL_POINTS_PER_LEVEL, "wheelPointsPerLevel", 1);
 	loadIntConfig(L, WHITE_SKULL_TIME, "whiteSkullTime", 15 * 60 * 1000);
+	loadIntConfig(L, WORLD_SNAPSHOT_INTERVAL, "worldSnapshotInterval", 1000);
 	loadIntConfig(L, AUGMENT_INCREASED_DAMAGE_PERCENT, "augmentIncreasedDamagePercent", 5);
 	loadIntConfig(L, AUGMENT_POWERFUL_IMPACT_PERCENT, "augmentPowerfulImpactPercent", 10);
 	loadIntConfig(L, AUGMENT_STRONG_IMPACT_PERCENT, "augmentStrongImpactPercent", 7);
@@ -351,12 +431,15 @@ bool ConfigManager::load() {
 	loadStringConfig(L, DISCORD_WEBHOOK_URL, "discordWebhookURL", "");
 	loadStringConfig(L, FORGE_FIENDISH_INTERVAL_TIME, "forgeFiendishIntervalTime", "1");
 	loadStringConfig(L, FORGE_FIENDISH_INTERVAL_TYPE, "forgeFiendishIntervalType", "hour");
+	loadStringConfig(L, FRAME_DUMP_FILE, "frameDumpFile", "slow_frames.csv");
 	loadStringConfig(L, GLOBAL_SERVER_SAVE_TIME, "globalServerSaveTime", "06:00");
 	loadStringConfig(L, LOCATION, "location", "");
+	loadStringConfig(L, LUA_BYTECODE_CACHE_DIRECTORY, "luaBytecodeCacheDirectory", "cache/lua");
 	loadStringConfig(L, M_CONST, "memoryConst", "1<<16");
 	loadStringConfig(L, METRICS_PROMETHEUS_ADDRESS, "metricsPrometheusAddress", "localhost:9464");
 	loadStringConfig(L, OWNER_EMAIL, "ownerEmail", "");
 	loadStringConfig(L, OWNER_NAME, "ownerName", "");
+	loadStringConfig(L, PACKET_RATE_LIMITS, "packetRateLimits", "0x94:4:10,0xAE:2:5,0xAF:2:5,0xB1:1:3,0xC0:1:3,0xCD:2:5,0xE1:2:5,0xE2:2:5,0xE3:2:5,0xE5:2:5,0xF5:4:10");
 	loadStringConfig(L, SAVE_INTERVAL_TYPE, "saveIntervalType", "");
 	loadStringConfig(L, SERVER_MOTD, "serverMotd", "");
 	loadStringConfig(L, SERVER_NAME, "serverName", "");
@@ -365,6 +448,10 @@ bool ConfigManager::load() {
 	loadStringConfig(L, URL, "url", "");
 	loadStringConfig(L, WORLD_TYPE, "worldType", "pvp");
 
+	configs.store(next.get(), std::memory_order_release);
+	configGenerations.emplace_back(std::move(next));
+	loadingConfigs = nullptr;
+
 	loaded = true;
 	lua_close(L);
 	return true;
@@ -390,7 +477,7 @@ std::string ConfigManager::loadStringConfig(lua_State* L, const ConfigKey_t &key
 	} else {
 		missingConfigWarning(identifier);
 	}
-	configs[key] = value;
+	(*loadingConfigs)[key] = value;
 	lua_pop(L, 1);
 	return value;
 }
@@ -403,7 +490,7 @@ int32_t ConfigManager::loadIntConfig(lua_State* L, const ConfigKey_t &key, const
 	} else {
 		missingConfigWarning(identifier);
 	}
-	configs[key] = value;
+	(*loadingConfigs)[key] = value;
 	lua_pop(L, 1);
 	return value;
 }
@@ -416,7 +503,7 @@ bool ConfigManager::loadBoolConfig(lua_State* L, const ConfigKey_t &key, const c
 	} else {
 		missingConfigWarning(identifier);
 	}
-	configs[key] = value;
+	(*loadingConfigs)[key] = value;
 	lua_pop(L, 1);
 	return value;
 }
@@ -429,39 +516,48 @@ float ConfigManager::loadFloatConfig(lua_State* L, const ConfigKey_t &key, const
 	} else {
 		missingConfigWarning(identifier);
 	}
-	configs[key] = value;
+	(*loadingConfigs)[key] = value;
 	lua_pop(L, 1);
 	return value;
 }
 
+template <typename T>
+const T* ConfigManager::getValue(ConfigKey_t key) const {
+	const auto* values = configs.load(std::memory_order_acquire);
+	if (!values || key >= values->size()) {
+		return nullptr;
+	}
+	return std::get_if<T>(&(*values)[key]);
+}
+
 const std::string &ConfigManager::getString(const ConfigKey_t &key, std::string_view context) const {
 	static const std::string dummyStr;
-	if (configs.contains(key) && std::holds_alternative<std::string>(configs.at(key))) {
-		return std::get<std::string>(configs.at(key));
+	if (const auto* value = getValue<std::string>(key)) {
+		return *value;
 	}
 	g_logger().warn("[ConfigManager::getString] - Accessing invalid or wrong type index: {}[{}], Function: {}", magic_enum::enum_name(key), fmt::underlying(key), context);
 	return dummyStr;
 }
 
 int32_t ConfigManager::getNumber(const ConfigKey_t &key, std::string_view context) const {
-	if (configs.contains(key) && std::holds_alternative<int32_t>(configs.at(key))) {
-		return std::get<int32_t>(configs.at(key));
+	if (const auto* value = getValue<int32_t>(key)) {
+		return *value;
 	}
 	g_logger().warn("[ConfigManager::getNumber] - Accessing invalid or wrong type index: {}[{}], Function: {}", magic_enum::enum_name(key), fmt::underlying(key), context);
 	return 0;
 }
 
 bool ConfigManager::getBoolean(const ConfigKey_t &key, std::string_view context) const {
-	if (configs.contains(key) && std::holds_alternative<bool>(configs.at(key))) {
-		return std::get<bool>(configs.at(key));
+	if (const auto* value = getValue<bool>(key)) {
+		return *value;
 	}
 	g_logger().warn("[ConfigManager::getBoolean] - Accessing invalid or wrong type index: {}[{}], Function: {}", magic_enum::enum_name(key), fmt::underlying(key), context);
 	return false;
 }
 
 float ConfigManager::getFloat(const ConfigKey_t &key, std::string_view context) const {
-	if (configs.contains(key) && std::holds_alternative<float>(configs.at(key))) {
-		return std::get<float>(configs.at(key));
+	if (const auto* value = getValue<float>(key)) {
+		return *value;
 	}
 	g_logger().warn("[ConfigManager::getFloat] - Accessing invalid or wrong type index: {}[{}], Function: {}", magic_enum::enum_name(key), fmt::underlying(key), context);
 	return 0.0f;
@@ -11,7 +11,8 @@
 
 #include "config_enums.hpp"
 
-using ConfigValue = std::variant<std::string, int32_t, bool, float>;
+// std::monostate until the key is loaded
+using ConfigValue = std::variant<std::monostate, std::string, int32_t, bool, float>;
 
 class ConfigManager {
 public:
@@ -26,6 +27,10 @@ public:
 	bool load();
 	bool reload();
 
+	[[nodiscard]] bool isLoaded() const {
+		return loaded;
+	}
+
 	void missingConfigWarning(const char* identifier);
 
 	const std::string &setConfigFileLua(const std::string &what) {
@@ -42,7 +47,21 @@ public:
 	[[nodiscard]] float getFloat(const ConfigKey_t &key, std::string_view context) const;
 
 private:
-	phmap::flat_hash_map<ConfigKey_t, ConfigValue> configs;
+	// Indexed by the key, the keys are numbered from 0
+	using ConfigValues = std::array<ConfigValue, magic_enum::enum_count<ConfigKey_t>()>;
+	static_assert(magic_enum::enum_count<ConfigKey_t>() == XP_DISPLAY_MODE + 1, "ConfigKey_t must be contiguous and in the range of magic_enum");
+
+	/**
+	 * The values are read from every thread, a load fills a copy of them and then publishes it.
+	 * The previous copies are never freed, getString hands out references, there is one per reload.
+	 */
+	std::atomic<const ConfigValues*> configs = nullptr;
+	std::vector<std::unique_ptr<ConfigValues>> configGenerations;
+	ConfigValues* loadingConfigs = nullptr;
+
+	template <typename T>
+	const T* getValue(ConfigKey_t key) const;
+
 	std::string loadStringConfig(lua_State* L, const ConfigKey_t &key, const char* identifier, const std::string &defaultValue);
 	int32_t loadIntConfig(lua_State* L, const ConfigKey_t &key, const char* identifier, const int32_t &defaultValue);
 	bool loadBoolConfig(lua_State* L, const ConfigKey_t &key, const char* identifier, const bool &defaultValue);
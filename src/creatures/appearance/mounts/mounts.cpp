@@ -16,6 +16,8 @@
 
 bool Mounts::reload() {
 	mounts.clear();
+	mountsById.clear();
+	mountsByClientId.clear();
 	return loadFromXml();
 }
 
@@ -35,24 +37,24 @@ bool Mounts::loadFromXml() {
 			continue;
 		}
 
-		mounts.emplace(std::make_shared<Mount>(
+		const auto mount = std::make_shared<Mount>(
 			static_cast<uint8_t>(pugi::cast<uint16_t>(mountNode.attribute("id").value())),
 			lookType,
 			mountNode.attribute("name").as_string(),
 			pugi::cast<int32_t>(mountNode.attribute("speed").value()),
 			mountNode.attribute("premium").as_bool(),
 			mountNode.attribute("type").as_string()
-		));
+		);
+		mounts.emplace(mount);
+		mountsById.try_emplace(mount->id, mount);
+		mountsByClientId.try_emplace(mount->clientId, mount);
 	}
 	return true;
 }
 
 std::shared_ptr<Mount> Mounts::getMountByID(uint8_t id) {
-	auto it = std::find_if(mounts.begin(), mounts.end(), [id](const std::shared_ptr<Mount> &mount) {
-		return mount->id == id; // Note the use of -> operator to access the members of the Mount object
-	});
-
-	return it != mounts.end() ? *it : nullptr; // Returning the shared_ptr to the Mount object
+	const auto it = mountsById.find(id);
+	return it != mountsById.end() ? it->second : nullptr;
 }
 
 std::shared_ptr<Mount> Mounts::getMountByName(const std::string &name) {
@@ -65,9 +67,6 @@ std::shared_ptr<Mount> Mounts::getMountByName(const std::string &name) {
 }
 
 std::shared_ptr<Mount> Mounts::getMountByClientID(uint16_t clientId) {
-	auto it = std::find_if(mounts.begin(), mounts.end(), [clientId](const std::shared_ptr<Mount> &mount) {
-		return mount->clientId == clientId; // Note the use of -> operator to access the members of the Mount object
-	});
-
-	return it != mounts.end() ? *it : nullptr; // Returning the shared_ptr to the Mount object
+	const auto it = mountsByClientId.find(clientId);
+	return it != mountsByClientId.end() ? it->second : nullptr;
 }
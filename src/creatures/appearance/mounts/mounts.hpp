@@ -36,4 +36,7 @@ public:
 
 private:
 	phmap::parallel_flat_hash_set<std::shared_ptr<Mount>> mounts;
+	// The same mounts by id and by client id, the first one of each as in the file
+	phmap::flat_hash_map<uint8_t, std::shared_ptr<Mount>> mountsById;
+	phmap::flat_hash_map<uint16_t, std::shared_ptr<Mount>> mountsByClientId;
 };
@@ -22,6 +22,9 @@ bool Outfits::reload() {
 	for (auto &outfitsVector : outfits) {
 		outfitsVector.clear();
 	}
+	for (auto &lookTypeMap : outfitsByLookType) {
+		lookTypeMap.clear();
+	}
 	return loadFromXml();
 }
 
@@ -64,13 +67,14 @@ bool Outfits::loadFromXml() {
 			continue;
 		}
 
-		outfits[type].emplace_back(std::make_shared<Outfit>(
+		const auto &outfit = outfits[type].emplace_back(std::make_shared<Outfit>(
 			outfitNode.attribute("name").as_string(),
 			pugi::cast<uint16_t>(lookTypeAttribute.value()),
 			outfitNode.attribute("premium").as_bool(),
 			outfitNode.attribute("unlocked").as_bool(true),
 			outfitNode.attribute("from").as_string()
 		));
+		outfitsByLookType[type].try_emplace(outfit->lookType, outfit);
 	}
 	for (uint8_t sex = PLAYERSEX_FEMALE; sex <= PLAYERSEX_LAST; ++sex) {
 		outfits[sex].shrink_to_fit();
@@ -94,12 +98,6 @@ std::shared_ptr<Outfit> Outfits::getOutfitByLookType(const std::shared_ptr<const
 		sex = (sex == PLAYERSEX_MALE) ? PLAYERSEX_FEMALE : PLAYERSEX_MALE;
 	}
 
-	auto it = std::ranges::find_if(outfits[sex], [&lookType](const auto &outfit) {
-		return outfit->lookType == lookType;
-	});
-
-	if (it != outfits[sex].end()) {
-		return *it;
-	}
-	return nullptr;
+	const auto it = outfitsByLookType[sex].find(lookType);
+	return it != outfitsByLookType[sex].end() ? it->second : nullptr;
 }
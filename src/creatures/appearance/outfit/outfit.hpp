@@ -14,14 +14,6 @@
 
 class Player;
 
-struct OutfitEntry {
-	constexpr explicit OutfitEntry(uint16_t initLookType, uint8_t initAddons) :
-		lookType(initLookType), addons(initAddons) { }
-
-	uint16_t lookType;
-	uint8_t addons;
-};
-
 struct Outfit {
 	Outfit(std::string initName, uint16_t initLookType, bool initPremium, bool initUnlocked, std::string initFrom) :
 		name(std::move(initName)), lookType(initLookType), premium(initPremium), unlocked(initUnlocked), from(std::move(initFrom)) { }
@@ -66,4 +58,6 @@ public:
 
 private:
 	std::vector<std::shared_ptr<Outfit>> outfits[PLAYERSEX_LAST + 1];
+	// The same outfits by look type, the first one of each look type as in the file
+	phmap::flat_hash_map<uint16_t, std::shared_ptr<Outfit>> outfitsByLookType[PLAYERSEX_LAST + 1];
 };
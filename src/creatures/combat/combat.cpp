@@ -11,6 +11,7 @@
 
 #include "declarations.hpp"
 #include "creatures/combat/combat.hpp"
+#include "creatures/combat/combat_trace.hpp"
 #include "lua/creature/events.hpp"
 #include "lua/callbacks/event_callback.hpp"
 #include "lua/callbacks/events_callbacks.hpp"
@@ -33,7 +34,7 @@ int32_t Combat::getLevelFormula(std::shared_ptr<Player> player, const std::share
 
 	uint32_t magicLevelSkill = player->getMagicLevel();
 	// Wheel of destiny - Runic Mastery
-	if (player->wheel()->getInstant("Runic Mastery") && wheelSpell && damage.instantSpellName.empty() && normal_random(0, 100) <= 25) {
+	if (player->wheel()->getInstant(WheelInstant_t::RUNIC_MASTERY) && wheelSpell && damage.instantSpellName.empty() && normal_random(0, 100) <= 25) {
 		const auto conjuringSpell = g_spells().getInstantSpellByName(damage.runeSpellName);
 		if (conjuringSpell && conjuringSpell != wheelSpell) {
 			uint32_t castResult = conjuringSpell->canCast(player) ? 20 : 10;
@@ -186,7 +187,7 @@ ConditionType_t Combat::DamageToConditionType(CombatType_t type) {
 	}
 }
 
-bool Combat::isPlayerCombat(std::shared_ptr<Creature> target) {
+bool Combat::isPlayerCombat(const std::shared_ptr<Creature> &target) {
 	if (target->getPlayer()) {
 		return true;
 	}
@@ -246,7 +247,7 @@ ReturnValue Combat::canTargetCreature(std::shared_ptr<Player> player, std::share
 	return Combat::canDoCombat(player, target, true);
 }
 
-ReturnValue Combat::canDoCombat(std::shared_ptr<Creature> caster, std::shared_ptr<Tile> tile, bool aggressive) {
+ReturnValue Combat::canDoCombat(const std::shared_ptr<Creature> &caster, const std::shared_ptr<Tile> &tile, bool aggressive) {
 	if (tile->hasProperty(CONST_PROP_BLOCKPROJECTILE)) {
 		return RETURNVALUE_NOTENOUGHROOM;
 	}
@@ -284,7 +285,7 @@ ReturnValue Combat::canDoCombat(std::shared_ptr<Creature> caster, std::shared_pt
 	return ret;
 }
 
-bool Combat::isInPvpZone(std::shared_ptr<Creature> attacker, std::shared_ptr<Creature> target) {
+bool Combat::isInPvpZone(const std::shared_ptr<Creature> &attacker, const std::shared_ptr<Creature> &target) {
 	return attacker->getZoneType() == ZONE_PVP && target->getZoneType() == ZONE_PVP;
 }
 
@@ -305,7 +306,7 @@ bool Combat::isProtected(std::shared_ptr<Player> attacker, std::shared_ptr<Playe
 	return false;
 }
 
-ReturnValue Combat::canDoCombat(std::shared_ptr<Creature> attacker, std::shared_ptr<Creature> target, bool aggressive) {
+ReturnValue Combat::canDoCombat(const std::shared_ptr<Creature> &attacker, const std::shared_ptr<Creature> &target, bool aggressive) {
 	if (!aggressive) {
 		return RETURNVALUE_NOERROR;
 	}
@@ -616,7 +617,7 @@ void Combat::CombatHealthFunc(std::shared_ptr<Creature> caster, std::shared_ptr<
 			}
 		}
 
-		damage.damageMultiplier += attackerPlayer->wheel()->getMajorStatConditional("Divine Empowerment", WheelMajor_t::DAMAGE);
+		damage.damageMultiplier += attackerPlayer->wheel()->getMajorStatConditional(WheelStage_t::DIVINE_EMPOWERMENT, WheelMajor_t::DAMAGE);
 		g_logger().trace("Wheel Divine Empowerment damage multiplier {}", damage.damageMultiplier);
 	}
 
@@ -1092,6 +1093,10 @@ bool Combat::doCombat(std::shared_ptr<Creature> caster, std::shared_ptr<Creature
 }
 
 bool Combat::doCombat(std::shared_ptr<Creature> caster, std::shared_ptr<Creature> target, const Position &origin, int affected /* = 1 */) const {
+	if (CombatTrace::isRecording() && target) {
+		g_combatTrace().recordTarget(origin, target->getPosition(), params);
+	}
+
 	// target combat callback function
 	if (params.combatType != COMBAT_NONE) {
 		CombatDamage damage = getCombatDamage(caster, target);
@@ -1138,6 +1143,10 @@ void Combat::CombatFunc(std::shared_ptr<Creature> caster, const Position &origin
 		getCombatArea(pos, pos, area, tileList);
 	}
 
+	if (CombatTrace::isRecording()) {
+		g_combatTrace().recordArea(origin, pos, tileList, params);
+	}
+
 	uint32_t maxX = 0;
 	uint32_t maxY = 0;
 
@@ -1159,12 +1168,22 @@ void Combat::CombatFunc(std::shared_ptr<Creature> caster, const Position &origin
 	const int32_t rangeX = maxX + MAP_MAX_VIEW_PORT_X;
 	const int32_t rangeY = maxY + MAP_MAX_VIEW_PORT_Y;
 
+	// The targets are collected once per cast, so the area events run once per tile and the creatures are not copied again to apply the combat
+	struct AreaTargets {
+		std::shared_ptr<Tile> tile;
+		std::vector<std::shared_ptr<Creature>> creatures;
+	};
+	std::vector<AreaTargets> areaTargets;
+	areaTargets.reserve(tileList.size());
+
 	int affected = 0;
 	for (const std::shared_ptr<Tile> &tile : tileList) {
 		if (canDoCombat(caster, tile, params.aggressive) != RETURNVALUE_NOERROR) {
 			continue;
 		}
 
+		auto &targets = areaTargets.emplace_back();
+		targets.tile = tile;
 		if (CreatureVector* creatures = tile->getCreatures()) {
 			const std::shared_ptr<Creature> topCreature = tile->getTopCreature();
 			// A copy of the tile's creature list is made because modifications to this vector, such as adding or removing creatures through a Lua callback, may occur during the iteration within the for loop.
@@ -1181,10 +1200,14 @@ void Combat::CombatFunc(std::shared_ptr<Creature> caster, const Position &origin
 				}
 
 				if (!params.aggressive || (caster != creature && Combat::canDoCombat(caster, creature, params.aggressive) == RETURNVALUE_NOERROR)) {
-					affected++;
+					targets.creatures.emplace_back(creature);
+					if (params.targetCasterOrTopMost) {
+						break;
+					}
 				}
 			}
 		}
+		affected += static_cast<int>(targets.creatures.size());
 	}
 
 	CombatDamage tmpDamage;
@@ -1211,46 +1234,27 @@ void Combat::CombatFunc(std::shared_ptr<Creature> caster, const Position &origin
 	}
 
 	// Wheel of destiny get beam affected total
-	auto spectators = Spectators().find<Player>(pos, true, rangeX, rangeX, rangeY, rangeY);
+	// The effects and the health updates of every target are sent to these
+	const SpectatorScope spectators(pos, rangeX, rangeY);
 	std::shared_ptr<Player> casterPlayer = caster ? caster->getPlayer() : nullptr;
 	uint8_t beamAffectedTotal = casterPlayer ? casterPlayer->wheel()->getBeamAffectedTotal(tmpDamage) : 0;
 	uint8_t beamAffectedCurrent = 0;
 
 	tmpDamage.affected = affected;
-	for (const std::shared_ptr<Tile> &tile : tileList) {
-		if (canDoCombat(caster, tile, params.aggressive) != RETURNVALUE_NOERROR) {
-			continue;
-		}
-
-		if (CreatureVector* creatures = tile->getCreatures()) {
-			const std::shared_ptr<Creature> topCreature = tile->getTopCreature();
-			// A copy of the tile's creature list is made because modifications to this vector, such as adding or removing creatures through a Lua callback, may occur during the iteration within the for loop.
-			CreatureVector creaturesCopy = *creatures;
-			for (auto &creature : creaturesCopy) {
-				if (params.targetCasterOrTopMost) {
-					if (caster && caster->getTile() == tile) {
-						if (creature != caster) {
-							continue;
-						}
-					} else if (creature != topCreature) {
-						continue;
-					}
-				}
-
-				if (!params.aggressive || (caster != creature && Combat::canDoCombat(caster, creature, params.aggressive) == RETURNVALUE_NOERROR)) {
-					// Wheel of destiny update beam mastery damage
-					if (casterPlayer) {
-						casterPlayer->wheel()->updateBeamMasteryDamage(tmpDamage, beamAffectedTotal, beamAffectedCurrent);
-					}
-					func(caster, creature, params, &tmpDamage);
-					if (params.targetCallback) {
-						params.targetCallback->onTargetCombat(caster, creature);
-					}
+	for (const auto &[tile, creatures] : areaTargets) {
+		for (const auto &creature : creatures) {
+			// Skips the ones killed or moved by the combat applied to the previous targets
+			if (creature->isRemoved() || creature->getTile() != tile) {
+				continue;
+			}
 
-					if (params.targetCasterOrTopMost) {
-						break;
-					}
-				}
+			// Wheel of destiny update beam mastery damage
+			if (casterPlayer) {
+				casterPlayer->wheel()->updateBeamMasteryDamage(tmpDamage, beamAffectedTotal, beamAffectedCurrent);
+			}
+			func(caster, creature, params, &tmpDamage);
+			if (params.targetCallback) {
+				params.targetCallback->onTargetCombat(caster, creature);
 			}
 		}
 		combatTileEffects(spectators.data(), caster, tile, params);
@@ -1467,28 +1471,43 @@ std::vector<std::pair<Position, std::vector<uint32_t>>> Combat::pickChainTargets
 		maxTargets++;
 	}
 
+	// A single search for the whole chain, no hop is further than chainDistance from the previous one
+	const auto &origin = targets.back()->getPosition();
+	const int32_t chainRange = static_cast<int32_t>(chainDistance) * (maxTargets + 1);
+	const auto candidates = Spectators().find<Creature>(origin, false, chainRange, chainRange, chainRange, chainRange);
+
+	std::vector<std::pair<double, std::shared_ptr<Creature>>> nearby;
 	int backtrackingAttempts = 10;
 	while (!targets.empty() && targets.size() <= maxTargets && backtrackingAttempts > 0) {
 		auto currentTarget = targets.back();
-		auto spectators = Spectators().find<Creature>(currentTarget->getPosition(), false, chainDistance, chainDistance, chainDistance, chainDistance);
-		g_logger().debug("Combat::pickChainTargets: currentTarget: {}, spectators: {}", currentTarget->getName(), spectators.size());
+		const auto &currentPosition = currentTarget->getPosition();
 
-		double closestDistance = std::numeric_limits<double>::max();
-		std::shared_ptr<Creature> closestSpectator = nullptr;
-		for (const auto &spectator : spectators) {
-			if (!spectator || visited.contains(spectator->getID())) {
+		nearby.clear();
+		for (const auto &candidate : candidates) {
+			if (!candidate || visited.contains(candidate->getID())) {
 				continue;
 			}
+
+			const auto &position = candidate->getPosition();
+			if (position.z != currentPosition.z || Position::getDistanceX(position, currentPosition) > chainDistance || Position::getDistanceY(position, currentPosition) > chainDistance) {
+				continue;
+			}
+			nearby.emplace_back(Position::getEuclideanDistance(currentPosition, position), candidate);
+		}
+		g_logger().debug("Combat::pickChainTargets: currentTarget: {}, spectators: {}", currentTarget->getName(), nearby.size());
+
+		// Closest first, so the first valid one is the target and the ones behind it are not checked
+		std::ranges::stable_sort(nearby, {}, &std::pair<double, std::shared_ptr<Creature>>::first);
+
+		std::shared_ptr<Creature> closestSpectator = nullptr;
+		for (const auto &[distance, spectator] : nearby) {
 			if (!isValidChainTarget(caster, currentTarget, spectator, params, aggressive)) {
 				visited.insert(spectator->getID());
 				continue;
 			}
 
-			double distance = Position::getEuclideanDistance(currentTarget->getPosition(), spectator->getPosition());
-			if (distance < closestDistance) {
-				closestDistance = distance;
-				closestSpectator = spectator;
-			}
+			closestSpectator = spectator;
+			break;
 		}
 
 		if (closestSpectator) {
@@ -1523,10 +1542,10 @@ std::vector<std::pair<Position, std::vector<uint32_t>>> Combat::pickChainTargets
 }
 
 bool Combat::isValidChainTarget(std::shared_ptr<Creature> caster, std::shared_ptr<Creature> currentTarget, std::shared_ptr<Creature> potentialTarget, const CombatParams &params, bool aggressive) {
-	bool canCombat = canDoCombat(caster, potentialTarget, aggressive) == RETURNVALUE_NOERROR;
-	bool pick = params.chainPickerCallback ? params.chainPickerCallback->onChainCombat(caster, potentialTarget) : true;
-	bool hasSight = g_game().isSightClear(currentTarget->getPosition(), potentialTarget->getPosition(), true);
-	return canCombat && pick && hasSight;
+	// Cheapest checks first, the picker calls the script
+	return canDoCombat(caster, potentialTarget, aggressive) == RETURNVALUE_NOERROR
+	    && g_game().isSightClear(currentTarget->getPosition(), potentialTarget->getPosition(), true)
+	    && (!params.chainPickerCallback || params.chainPickerCallback->onChainCombat(caster, potentialTarget));
 }
 
 //**********************************************************//
@@ -1538,7 +1557,7 @@ uint32_t ValueCallback::getMagicLevelSkill(std::shared_ptr<Player> player, const
 
 	uint32_t magicLevelSkill = player->getMagicLevel();
 	// Wheel of destiny
-	if (player && player->wheel()->getInstant("Runic Mastery") && damage.instantSpellName.empty()) {
+	if (player && player->wheel()->getInstant(WheelInstant_t::RUNIC_MASTERY) && damage.instantSpellName.empty()) {
 		const std::shared_ptr<Spell> spell = g_spells().getRuneSpellByName(damage.runeSpellName);
 		// Rune conjuring spell have the same name as the rune item spell.
 		const std::shared_ptr<InstantSpell> conjuringSpell = g_spells().getInstantSpellByName(damage.runeSpellName);
@@ -1552,6 +1571,18 @@ uint32_t ValueCallback::getMagicLevelSkill(std::shared_ptr<Player> player, const
 }
 
 void ValueCallback::getMinMaxValues(std::shared_ptr<Player> player, CombatDamage &damage, bool useCharges) const {
+	if (linear) {
+		const double level = player->getLevel();
+		const double magicLevel = getMagicLevelSkill(player, damage);
+		damage.primary.value = normal_random(
+			static_cast<int32_t>(linearMin.evaluate(level, magicLevel)),
+			static_cast<int32_t>(linearMax.evaluate(level, magicLevel))
+		);
+		damage.secondary.type = COMBAT_NONE;
+		damage.secondary.value = 0;
+		return;
+	}
+
 	// onGetPlayerMinMaxValues(...)
 	if (!scriptInterface->reserveScriptEnv()) {
 		g_logger().error("[ValueCallback::getMinMaxValues - Player {} formula {}] "
@@ -1642,6 +1673,86 @@ void ValueCallback::getMinMaxValues(std::shared_ptr<Player> player, CombatDamage
 	scriptInterface->resetScriptEnv();
 }
 
+bool ValueCallback::callLevelMagicFormula(int32_t level, int32_t magicLevel, double &min, double &max) const {
+	// onGetPlayerMinMaxValues(nil, level, maglevel)
+	if (!scriptInterface->reserveScriptEnv()) {
+		return false;
+	}
+
+	ScriptEnvironment* env = scriptInterface->getScriptEnv();
+	if (!env->setCallbackId(scriptId, scriptInterface)) {
+		scriptInterface->resetScriptEnv();
+		return false;
+	}
+
+	lua_State* L = scriptInterface->getLuaState();
+	const int top = lua_gettop(L);
+
+	scriptInterface->pushFunction(scriptId);
+	lua_pushnil(L);
+	lua_pushnumber(L, level);
+	lua_pushnumber(L, magicLevel);
+
+	// The formulas that use the player fail here, they are not reported since they stay on the script
+	bool success = lua_pcall(L, 3, 2, 0) == 0 && lua_isnumber(L, -2) && lua_isnumber(L, -1);
+	if (success) {
+		min = lua_tonumber(L, -2);
+		max = lua_tonumber(L, -1);
+	}
+
+	lua_settop(L, top);
+	scriptInterface->resetScriptEnv();
+	return success;
+}
+
+void ValueCallback::detectLinearFormula() {
+	linear = false;
+	if (type != COMBAT_FORMULA_LEVELMAGIC || !scriptInterface) {
+		return;
+	}
+
+	double baseMin, baseMax, levelMin, levelMax, magicMin, magicMax;
+	if (!callLevelMagicFormula(0, 0, baseMin, baseMax)
+	    || !callLevelMagicFormula(1, 0, levelMin, levelMax)
+	    || !callLevelMagicFormula(0, 1, magicMin, magicMax)) {
+		return;
+	}
+
+	const LinearFormula candidateMin { levelMin - baseMin, magicMin - baseMin, baseMin };
+	const LinearFormula candidateMax { levelMax - baseMax, magicMax - baseMax, baseMax };
+
+	// Spread over the levels and magic levels players have, so thresholds and rounding are noticed
+	static constexpr std::array<std::pair<int32_t, int32_t>, 10> samples = { {
+		{ 8, 0 },
+		{ 0, 7 },
+		{ 13, 3 },
+		{ 55, 21 },
+		{ 130, 47 },
+		{ 387, 89 },
+		{ 699, 113 },
+		{ 1001, 131 },
+		{ 1777, 151 },
+		{ 2999, 199 },
+	} };
+
+	const auto matches = [](const LinearFormula &formula, int32_t level, int32_t magicLevel, double value) {
+		return std::abs(formula.evaluate(level, magicLevel) - value) <= 1e-6 * std::max(1.0, std::abs(value));
+	};
+
+	for (const auto &[level, magicLevel] : samples) {
+		double min, max;
+		if (!callLevelMagicFormula(level, magicLevel, min, max)
+		    || !matches(candidateMin, level, magicLevel, min)
+		    || !matches(candidateMax, level, magicLevel, max)) {
+			return;
+		}
+	}
+
+	linearMin = candidateMin;
+	linearMax = candidateMax;
+	linear = true;
+}
+
 //**********************************************************//
 
 void TileCallback::onTileCombat(std::shared_ptr<Creature> creature, std::shared_ptr<Tile> tile) const {
@@ -1830,42 +1941,39 @@ bool ChainPickerCallback::onChainCombat(std::shared_ptr<Creature> creature, std:
 //**********************************************************//
 
 void AreaCombat::clear() {
-	std::ranges::fill(areas, nullptr);
-}
-
-AreaCombat::AreaCombat(const AreaCombat &rhs) {
-	hasExtArea = rhs.hasExtArea;
-	for (uint_fast8_t i = 0; i <= Direction::DIRECTION_LAST; ++i) {
-		if (const auto &area = rhs.areas[i]) {
-			areas[i] = area->clone();
-		}
+	for (auto &area : areas) {
+		area.clear();
 	}
 }
 
-void AreaCombat::getList(const Position &centerPos, const Position &targetPos, std::vector<std::shared_ptr<Tile>> &list) const {
-	const std::unique_ptr<MatrixArea> &area = getArea(centerPos, targetPos);
-	if (!area) {
-		return;
-	}
-
+void AreaCombat::setArea(Direction dir, const std::unique_ptr<MatrixArea> &area) {
 	uint32_t centerY;
 	uint32_t centerX;
 	area->getCenter(centerY, centerX);
 
-	const uint32_t rows = area->getRows();
-	const uint32_t cols = area->getCols();
-	list.reserve(rows * cols);
-
-	Position tmpPos(targetPos.x - centerX, targetPos.y - centerY, targetPos.z);
-	for (uint32_t y = 0; y < rows; ++y, ++tmpPos.y, tmpPos.x -= cols) {
-		for (uint32_t x = 0; x < cols; ++x, ++tmpPos.x) {
-			if (area->getValue(y, x) != 0) {
-				if (g_game().isSightClear(targetPos, tmpPos, true)) {
-					list.emplace_back(g_game().map.getOrCreateTile(tmpPos));
-				}
+	auto &offsets = areas[dir];
+	offsets.clear();
+	// Row by row, so consecutive tiles are looked up in the same map sector
+	for (uint32_t y = 0, rows = area->getRows(); y < rows; ++y) {
+		for (uint32_t x = 0, cols = area->getCols(); x < cols; ++x) {
+			if (area->getValue(y, x)) {
+				offsets.push_back({ static_cast<int16_t>(x - centerX), static_cast<int16_t>(y - centerY) });
 			}
 		}
 	}
+	offsets.shrink_to_fit();
+}
+
+void AreaCombat::getList(const Position &centerPos, const Position &targetPos, std::vector<std::shared_ptr<Tile>> &list) const {
+	const auto &offsets = getArea(centerPos, targetPos);
+	list.reserve(list.size() + offsets.size());
+
+	for (const auto &offset : offsets) {
+		const Position tmpPos(targetPos.x + offset.x, targetPos.y + offset.y, targetPos.z);
+		if (g_game().isSightClear(targetPos, tmpPos, true)) {
+			list.emplace_back(g_game().map.getOrCreateTile(tmpPos));
+		}
+	}
 }
 
 void AreaCombat::copyArea(const std::unique_ptr<MatrixArea> &input, const std::unique_ptr<MatrixArea> &output, MatrixOperation_t op) const {
@@ -1995,10 +2103,10 @@ void AreaCombat::setupArea(const std::list<uint32_t> &list, uint32_t rows) {
 	auto westArea = std::make_unique<MatrixArea>(maxOutput, maxOutput);
 	copyArea(northArea, westArea, MATRIXOPERATION_ROTATE270);
 
-	areas[DIRECTION_NORTH] = std::move(northArea);
-	areas[DIRECTION_SOUTH] = std::move(southArea);
-	areas[DIRECTION_EAST] = std::move(eastArea);
-	areas[DIRECTION_WEST] = std::move(westArea);
+	setArea(DIRECTION_NORTH, northArea);
+	setArea(DIRECTION_SOUTH, southArea);
+	setArea(DIRECTION_EAST, eastArea);
+	setArea(DIRECTION_WEST, westArea);
 }
 
 void AreaCombat::setupArea(int32_t length, int32_t spread) {
@@ -2093,10 +2201,10 @@ void AreaCombat::setupExtArea(const std::list<uint32_t> &list, uint32_t rows) {
 	auto seArea = std::make_unique<MatrixArea>(maxOutput, maxOutput);
 	copyArea(swArea, seArea, MATRIXOPERATION_MIRROR);
 
-	areas[DIRECTION_NORTHWEST] = std::move(nwArea);
-	areas[DIRECTION_SOUTHWEST] = std::move(swArea);
-	areas[DIRECTION_NORTHEAST] = std::move(neArea);
-	areas[DIRECTION_SOUTHEAST] = std::move(seArea);
+	setArea(DIRECTION_NORTHWEST, nwArea);
+	setArea(DIRECTION_SOUTHWEST, swArea);
+	setArea(DIRECTION_NORTHEAST, neArea);
+	setArea(DIRECTION_SOUTHEAST, seArea);
 }
 
 //**********************************************************//
@@ -38,8 +38,31 @@ public:
 	uint32_t getMagicLevelSkill(std::shared_ptr<Player> player, const CombatDamage &damage) const;
 	void getMinMaxValues(std::shared_ptr<Player> player, CombatDamage &damage, bool useCharges) const;
 
+	/**
+	 * @brief Checks if the level and magic level formula is linear and ignores the player.
+	 *
+	 * The script is called at a few levels and magic levels without a player, when the results
+	 * are the same linear function of them every time, the hits evaluate it instead of calling the script.
+	 */
+	void detectLinearFormula();
+
 private:
+	struct LinearFormula {
+		double level = 0;
+		double magicLevel = 0;
+		double base = 0;
+
+		double evaluate(double forLevel, double forMagicLevel) const {
+			return level * forLevel + magicLevel * forMagicLevel + base;
+		}
+	};
+
+	bool callLevelMagicFormula(int32_t level, int32_t magicLevel, double &min, double &max) const;
+
 	formulaType_t type;
+	bool linear = false;
+	LinearFormula linearMin;
+	LinearFormula linearMax;
 };
 
 class TileCallback final : public CallBack {
@@ -210,10 +233,7 @@ class AreaCombat {
 public:
 	AreaCombat() = default;
 
-	AreaCombat(const AreaCombat &rhs);
-	~AreaCombat() {
-		clear();
-	}
+	AreaCombat(const AreaCombat &rhs) = default;
 
 	// non-assignable
 	AreaCombat &operator=(const AreaCombat &) = delete;
@@ -234,7 +254,20 @@ private:
 	std::unique_ptr<MatrixArea> createArea(const std::list<uint32_t> &list, uint32_t rows);
 	void copyArea(const std::unique_ptr<MatrixArea> &input, const std::unique_ptr<MatrixArea> &output, MatrixOperation_t op) const;
 
-	const std::unique_ptr<MatrixArea> &getArea(const Position &centerPos, const Position &targetPos) const {
+	// A tile of the area, relative to the target position
+	struct AreaOffset {
+		int16_t x;
+		int16_t y;
+	};
+	using AreaOffsets = std::vector<AreaOffset>;
+
+	/**
+	 * Compiles the tiles of the matrix for a direction, so a cast only walks the tiles of the area
+	 * instead of every cell of the rotated matrix, most of them empty.
+	 */
+	void setArea(Direction dir, const std::unique_ptr<MatrixArea> &area);
+
+	const AreaOffsets &getArea(const Position &centerPos, const Position &targetPos) const {
 		int32_t dx = Position::getOffsetX(targetPos, centerPos);
 		int32_t dy = Position::getOffsetY(targetPos, centerPos);
 
@@ -264,7 +297,7 @@ private:
 		return areas[dir];
 	}
 
-	std::array<std::unique_ptr<MatrixArea>, Direction::DIRECTION_LAST + 1> areas {};
+	std::array<AreaOffsets, Direction::DIRECTION_LAST + 1> areas {};
 	bool hasExtArea = false;
 };
 
@@ -292,14 +325,14 @@ public:
 
 	static void getCombatArea(const Position &centerPos, const Position &targetPos, const std::unique_ptr<AreaCombat> &area, std::vector<std::shared_ptr<Tile>> &list);
 
-	static bool isInPvpZone(std::shared_ptr<Creature> attacker, std::shared_ptr<Creature> target);
+	static bool isInPvpZone(const std::shared_ptr<Creature> &attacker, const std::shared_ptr<Creature> &target);
 	static bool isProtected(std::shared_ptr<Player> attacker, std::shared_ptr<Player> target);
-	static bool isPlayerCombat(std::shared_ptr<Creature> target);
+	static bool isPlayerCombat(const std::shared_ptr<Creature> &target);
 	static CombatType_t ConditionToDamageType(ConditionType_t type);
 	static ConditionType_t DamageToConditionType(CombatType_t type);
 	static ReturnValue canTargetCreature(std::shared_ptr<Player> attacker, std::shared_ptr<Creature> target);
-	static ReturnValue canDoCombat(std::shared_ptr<Creature> caster, std::shared_ptr<Tile> tile, bool aggressive);
-	static ReturnValue canDoCombat(std::shared_ptr<Creature> attacker, std::shared_ptr<Creature> target, bool aggressive);
+	static ReturnValue canDoCombat(const std::shared_ptr<Creature> &caster, const std::shared_ptr<Tile> &tile, bool aggressive);
+	static ReturnValue canDoCombat(const std::shared_ptr<Creature> &attacker, const std::shared_ptr<Creature> &target, bool aggressive);
 	static void postCombatEffects(std::shared_ptr<Creature> caster, const Position &origin, const Position &pos, const CombatParams &params);
 
 	static void addDistanceEffect(std::shared_ptr<Creature> caster, const Position &fromPos, const Position &toPos, uint16_t effect);
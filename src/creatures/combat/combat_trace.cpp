@@ -0,0 +1,295 @@
+/**
+ * Canary - A free and open-source MMORPG server emulator
+ * Copyright (©) 2019-2024 OpenTibiaBR <opentibiabr@outlook.com>
+ * Repository: https://github.com/opentibiabr/canary
+ * License: https://github.com/opentibiabr/canary/blob/main/LICENSE
+ * Contributors: https://github.com/opentibiabr/canary/graphs/contributors
+ * Website: https://docs.opentibiabr.com/
+ */
+
+#include "pch.hpp"
+
+#include "creatures/combat/combat_trace.hpp"
+#include "creatures/combat/combat.hpp"
+#include "game/game.hpp"
+#include "lib/di/container.hpp"
+#include "map/spectators.hpp"
+#include "server/network/message/networkmessage.hpp"
+#include "server/network/protocol/protocolgame.hpp"
+
+namespace {
+	template <typename T>
+	void append(std::vector<uint8_t> &buffer, T value) {
+		const auto size = buffer.size();
+		buffer.resize(size + sizeof(T));
+		std::memcpy(buffer.data() + size, &value, sizeof(T));
+	}
+
+	void appendPosition(std::vector<uint8_t> &buffer, const Position &pos) {
+		append<uint16_t>(buffer, pos.x);
+		append<uint16_t>(buffer, pos.y);
+		append<uint8_t>(buffer, pos.z);
+	}
+
+	class TraceReader {
+	public:
+		explicit TraceReader(const std::vector<uint8_t> &data) :
+			data(data) { }
+
+		bool atEnd() const {
+			return position == data.size();
+		}
+
+		template <typename T>
+		bool read(T &value) {
+			if (data.size() - position < sizeof(T)) {
+				return false;
+			}
+			std::memcpy(&value, data.data() + position, sizeof(T));
+			position += sizeof(T);
+			return true;
+		}
+
+		bool readPosition(Position &pos) {
+			return read(pos.x) && read(pos.y) && read(pos.z);
+		}
+
+	private:
+		const std::vector<uint8_t> &data;
+		size_t position = 0;
+	};
+
+	uint64_t getMicroseconds(std::chrono::steady_clock::time_point start) {
+		return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count());
+	}
+
+	CombatTracePhase makePhase(std::string_view name, std::vector<uint64_t> &samples) {
+		CombatTracePhase phase { name };
+		if (samples.empty()) {
+			return phase;
+		}
+
+		phase.totalTime = std::accumulate(samples.begin(), samples.end(), uint64_t { 0 });
+		const auto percentile = [&samples](size_t percent) {
+			const auto index = std::min(samples.size() - 1, samples.size() * percent / 100);
+			std::nth_element(samples.begin(), samples.begin() + index, samples.end());
+			return samples[index];
+		};
+		phase.p50Time = percentile(50);
+		phase.p99Time = percentile(99);
+		return phase;
+	}
+}
+
+CombatTrace::~CombatTrace() {
+	if (file) {
+		std::fclose(file);
+	}
+}
+
+CombatTrace &CombatTrace::getInstance() {
+	return inject<CombatTrace>();
+}
+
+bool CombatTrace::start(const std::string &tracePath) {
+	std::scoped_lock lock(mutex);
+	if (file) {
+		return false;
+	}
+
+	file = std::fopen(tracePath.c_str(), "wb");
+	if (!file) {
+		g_logger().error("[{}] - Failed to create the combat trace {}", __FUNCTION__, tracePath);
+		return false;
+	}
+
+	path = tracePath;
+	startTime = OTSYS_TIME();
+	buffer.clear();
+	append(buffer, MAGIC);
+	recording.store(true, std::memory_order_relaxed);
+	g_logger().info("Recording combats to {}", path);
+	return true;
+}
+
+bool CombatTrace::stop() {
+	std::scoped_lock lock(mutex);
+	if (!file) {
+		return false;
+	}
+
+	recording.store(false, std::memory_order_relaxed);
+	flush();
+	std::fclose(file);
+	file = nullptr;
+	g_logger().info("Stopped recording combats to {}", path);
+	return true;
+}
+
+void CombatTrace::recordArea(const Position &origin, const Position &pos, const std::vector<std::shared_ptr<Tile>> &tiles, const CombatParams &params) {
+	std::vector<Offset> offsets;
+	offsets.reserve(tiles.size());
+	for (const auto &tile : tiles) {
+		const auto &tilePos = tile->getPosition();
+		const auto offsetX = Position::getOffsetX(tilePos, pos);
+		const auto offsetY = Position::getOffsetY(tilePos, pos);
+		if (offsetX < std::numeric_limits<int8_t>::min() || offsetX > std::numeric_limits<int8_t>::max() || offsetY < std::numeric_limits<int8_t>::min() || offsetY > std::numeric_limits<int8_t>::max()) {
+			continue;
+		}
+		offsets.push_back({ static_cast<int8_t>(offsetX), static_cast<int8_t>(offsetY) });
+	}
+	writeEvent(origin, pos, params, FLAG_AREA, offsets);
+}
+
+void CombatTrace::recordTarget(const Position &origin, const Position &pos, const CombatParams &params) {
+	writeEvent(origin, pos, params, 0, { Offset {} });
+}
+
+void CombatTrace::writeEvent(const Position &origin, const Position &pos, const CombatParams &params, uint8_t flags, const std::vector<Offset> &eventOffsets) {
+	std::scoped_lock lock(mutex);
+	if (!file) {
+		return;
+	}
+
+	if (params.aggressive) {
+		flags |= FLAG_AGGRESSIVE;
+	}
+
+	append<uint32_t>(buffer, static_cast<uint32_t>(OTSYS_TIME() - startTime));
+	appendPosition(buffer, origin);
+	appendPosition(buffer, pos);
+	append<uint16_t>(buffer, params.impactEffect);
+	append<uint16_t>(buffer, params.distanceEffect);
+	append<uint8_t>(buffer, flags);
+	append<uint16_t>(buffer, static_cast<uint16_t>(std::min<size_t>(eventOffsets.size(), std::numeric_limits<uint16_t>::max())));
+	for (size_t i = 0; i < eventOffsets.size() && i < std::numeric_limits<uint16_t>::max(); ++i) {
+		append<int8_t>(buffer, eventOffsets[i].x);
+		append<int8_t>(buffer, eventOffsets[i].y);
+	}
+
+	if (buffer.size() >= FLUSH_SIZE) {
+		flush();
+	}
+}
+
+void CombatTrace::flush() {
+	if (!buffer.empty() && std::fwrite(buffer.data(), 1, buffer.size(), file) != buffer.size()) {
+		g_logger().error("[{}] - Failed to write to the combat trace {}", __FUNCTION__, path);
+	}
+	buffer.clear();
+}
+
+std::optional<CombatTraceReport> CombatTrace::replay(const std::string &tracePath) const {
+	std::ifstream input(tracePath, std::ios::binary);
+	if (!input) {
+		g_logger().error("[{}] - Failed to open the combat trace {}", __FUNCTION__, tracePath);
+		return std::nullopt;
+	}
+
+	const std::vector<uint8_t> data((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+	TraceReader reader(data);
+
+	uint32_t magic = 0;
+	if (!reader.read(magic) || magic != MAGIC) {
+		g_logger().error("[{}] - {} is not a combat trace", __FUNCTION__, tracePath);
+		return std::nullopt;
+	}
+
+	CombatTraceReport report;
+	std::vector<uint64_t> combatSamples;
+	std::vector<uint64_t> spectatorSamples;
+	std::vector<uint64_t> networkSamples;
+	std::vector<Position> positions;
+	uint32_t firstTime = 0;
+	uint32_t lastTime = 0;
+
+	const auto replayStart = std::chrono::steady_clock::now();
+	while (!reader.atEnd()) {
+		uint32_t time;
+		Position origin;
+		Position pos;
+		uint16_t impactEffect;
+		uint16_t distanceEffect;
+		uint8_t flags;
+		uint16_t count;
+		if (!reader.read(time) || !reader.readPosition(origin) || !reader.readPosition(pos) || !reader.read(impactEffect) || !reader.read(distanceEffect) || !reader.read(flags) || !reader.read(count)) {
+			g_logger().warn("[{}] - The combat trace {} is truncated, replayed {} events", __FUNCTION__, tracePath, report.events);
+			break;
+		}
+
+		positions.clear();
+		int32_t maxX = 0;
+		int32_t maxY = 0;
+		bool truncated = false;
+		for (uint16_t i = 0; i < count; ++i) {
+			int8_t offsetX, offsetY;
+			if (!reader.read(offsetX) || !reader.read(offsetY)) {
+				truncated = true;
+				break;
+			}
+			positions.emplace_back(static_cast<uint16_t>(pos.x + offsetX), static_cast<uint16_t>(pos.y + offsetY), pos.z);
+			maxX = std::max<int32_t>(maxX, std::abs(offsetX));
+			maxY = std::max<int32_t>(maxY, std::abs(offsetY));
+		}
+		if (truncated) {
+			g_logger().warn("[{}] - The combat trace {} is truncated, replayed {} events", __FUNCTION__, tracePath, report.events);
+			break;
+		}
+
+		if (report.events == 0) {
+			firstTime = time;
+		}
+		lastTime = time;
+		++report.events;
+
+		// The tiles that accept the combat and the creatures on them
+		const bool aggressive = flags & FLAG_AGGRESSIVE;
+		auto phaseStart = std::chrono::steady_clock::now();
+		for (const auto &tilePos : positions) {
+			if ((flags & FLAG_AREA) && !g_game().map.isSightClear(pos, tilePos, true)) {
+				continue;
+			}
+
+			const auto &tile = g_game().map.getTile(tilePos);
+			if (!tile || Combat::canDoCombat(nullptr, tile, aggressive) != RETURNVALUE_NOERROR) {
+				continue;
+			}
+
+			++report.tiles;
+			if (const CreatureVector* creatures = tile->getCreatures()) {
+				report.creatures += creatures->size();
+			}
+		}
+		combatSamples.emplace_back(getMicroseconds(phaseStart));
+
+		// The players that see it, with the range of CombatFunc
+		phaseStart = std::chrono::steady_clock::now();
+		const int32_t rangeX = maxX + MAP_MAX_VIEW_PORT_X;
+		const int32_t rangeY = maxY + MAP_MAX_VIEW_PORT_Y;
+		report.spectators += Spectators().find<Player>(pos, true, rangeX, rangeX, rangeY, rangeY).size();
+		spectatorSamples.emplace_back(getMicroseconds(phaseStart));
+
+		// The effects, once per protocol version as the broadcasts build them
+		phaseStart = std::chrono::steady_clock::now();
+		for (const bool oldProtocol : { false, true }) {
+			NetworkMessage msg;
+			if (distanceEffect != CONST_ANI_NONE) {
+				ProtocolGame::addDistanceShoot(msg, origin, pos, distanceEffect, oldProtocol);
+			}
+			if (impactEffect != CONST_ME_NONE) {
+				for (const auto &tilePos : positions) {
+					ProtocolGame::addMagicEffect(msg, tilePos, impactEffect, oldProtocol);
+				}
+			}
+			report.bytes += msg.getLength();
+		}
+		networkSamples.emplace_back(getMicroseconds(phaseStart));
+	}
+
+	report.replayTime = getMicroseconds(replayStart);
+	report.recordedTime = lastTime - firstTime;
+	report.phases.emplace_back(makePhase("combat", combatSamples));
+	report.phases.emplace_back(makePhase("spectators", spectatorSamples));
+	report.phases.emplace_back(makePhase("network", networkSamples));
+	return report;
+}
@@ -0,0 +1,107 @@
+/**
+ * Canary - A free and open-source MMORPG server emulator
+ * Copyright (©) 2019-2024 OpenTibiaBR <opentibiabr@outlook.com>
+ * Repository: https://github.com/opentibiabr/canary
+ * License: https://github.com/opentibiabr/canary/blob/main/LICENSE
+ * Contributors: https://github.com/opentibiabr/canary/graphs/contributors
+ * Website: https://docs.opentibiabr.com/
+ */
+
+#pragma once
+
+#include "game/movement/position.hpp"
+
+class Tile;
+struct CombatParams;
+
+struct CombatTracePhase {
+	std::string_view name;
+	// microseconds
+	uint64_t totalTime = 0;
+	uint64_t p50Time = 0;
+	uint64_t p99Time = 0;
+};
+
+struct CombatTraceReport {
+	uint64_t events = 0;
+	uint64_t tiles = 0;
+	uint64_t creatures = 0;
+	uint64_t spectators = 0;
+	uint64_t bytes = 0;
+	// milliseconds between the first and the last recorded event
+	uint64_t recordedTime = 0;
+	// microseconds
+	uint64_t replayTime = 0;
+	std::vector<CombatTracePhase> phases;
+};
+
+/**
+ * Records the combats of a live server (positions, area tiles and effects, with their time) to a binary file,
+ * and replays such a file against the loaded map, without clients, timing each part of the combat:
+ * the tiles and creatures of the area, the players that see it and the serialization of the effects.
+ * The replay runs as fast as it can, so recorded fights can be compared between builds.
+ */
+class CombatTrace {
+public:
+	CombatTrace() = default;
+	~CombatTrace();
+
+	// Non copyable
+	CombatTrace(const CombatTrace &) = delete;
+	CombatTrace &operator=(const CombatTrace &) = delete;
+
+	static CombatTrace &getInstance();
+
+	static bool isRecording() {
+		return recording.load(std::memory_order_relaxed);
+	}
+
+	/**
+	 * Starts recording to path, replacing what it had.
+	 * @return false if it is already recording or the file could not be created.
+	 */
+	bool start(const std::string &path);
+
+	/**
+	 * @return false if it was not recording.
+	 */
+	bool stop();
+
+	void recordArea(const Position &origin, const Position &pos, const std::vector<std::shared_ptr<Tile>> &tiles, const CombatParams &params);
+	void recordTarget(const Position &origin, const Position &pos, const CombatParams &params);
+
+	/**
+	 * Replays a recorded file on the calling thread, expects the dispatcher.
+	 * @return nothing if the file could not be read.
+	 */
+	std::optional<CombatTraceReport> replay(const std::string &path) const;
+
+private:
+	static constexpr uint32_t MAGIC = 0x31525443; // "CTR1"
+	static constexpr size_t FLUSH_SIZE = 64 * 1024;
+
+	enum Flags : uint8_t {
+		FLAG_AGGRESSIVE = 1 << 0,
+		FLAG_AREA = 1 << 1,
+	};
+
+	struct Offset {
+		int8_t x = 0;
+		int8_t y = 0;
+	};
+
+	void writeEvent(const Position &origin, const Position &pos, const CombatParams &params, uint8_t flags, const std::vector<Offset> &offsets);
+	// Expects the lock
+	void flush();
+
+	inline static std::atomic_bool recording = false;
+
+	// Combats are recorded from the dispatcher, the lock only guards against a stop from elsewhere
+	std::mutex mutex;
+	std::FILE* file = nullptr;
+	std::string path;
+	int64_t startTime = 0;
+	std::vector<uint8_t> buffer;
+};
+
+constexpr auto g_combatTrace = CombatTrace::getInstance;
@@ -22,6 +22,9 @@
 bool Condition::setParam(ConditionParam_t param, int32_t value) {
 	switch (param) {
 		case CONDITION_PARAM_TICKS: {
+			if (ticks == -1 && value != -1) {
+				++permanentEpoch;
+			}
 			ticks = value;
 			return true;
 		}
@@ -43,6 +46,7 @@ bool Condition::setParam(ConditionParam_t param, int32_t value) {
 
 		case CONDITION_PARAM_SOUND_TICK: {
 			tickSound = static_cast<SoundEffect_t>(value);
+			++permanentEpoch;
 			return true;
 		}
 
@@ -176,6 +180,9 @@ void Condition::serialize(PropWriteStream &propWriteStream) {
 }
 
 void Condition::setTicks(int32_t newTicks) {
+	if (ticks == -1 && newTicks != -1) {
+		++permanentEpoch;
+	}
 	ticks = newTicks;
 	endTime = ticks + OTSYS_TIME();
 }
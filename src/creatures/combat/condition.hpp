@@ -29,6 +29,33 @@ public:
 	virtual bool startCondition(std::shared_ptr<Creature> creature);
 	virtual bool executeCondition(std::shared_ptr<Creature> creature, int32_t interval);
 	virtual void endCondition(std::shared_ptr<Creature> creature) = 0;
+
+	/**
+	 * Conditions without periodic effects (most buffs, cooldowns, outfits...) only need their timer updated,
+	 * Creature::executeConditions ticks them with tickTimer instead of executeCondition.
+	 */
+	bool hasPeriodicEffect() const {
+		return periodicEffect || tickSound != SoundEffect_t::SILENCE;
+	}
+
+	/**
+	 * Changes every time a condition stops being permanent or may get a periodic effect, a creature whose conditions
+	 * are all permanent and without periodic effects skips their walk until it changes (see Creature::executeConditions).
+	 */
+	static uint32_t getPermanentEpoch() {
+		return permanentEpoch;
+	}
+
+	// Timer part of executeCondition, returns false once the condition expired
+	bool tickTimer(int32_t interval, int64_t now) {
+		if (ticks == -1) {
+			return true;
+		}
+
+		// Not using set ticks here since it would reset endTime
+		ticks = std::max<int32_t>(0, ticks - interval);
+		return endTime >= now;
+	}
 	virtual void addCondition(std::shared_ptr<Creature> creature, std::shared_ptr<Condition> condition) = 0;
 	virtual std::unordered_set<PlayerIcon> getIcons() const;
 	ConditionId_t getId() const {
@@ -74,10 +101,14 @@ protected:
 	ConditionId_t id {};
 	bool isBuff {};
 	bool m_isPersistent {};
+	// Set by the conditions that do work on every tick, the others only tick their timer
+	bool periodicEffect = false;
 
 	virtual bool updateCondition(std::shared_ptr<Condition> addCondition);
 
 private:
+	inline static uint32_t permanentEpoch = 0;
+
 	SoundEffect_t tickSound = SoundEffect_t::SILENCE;
 	SoundEffect_t addSound = SoundEffect_t::SILENCE;
 
@@ -171,7 +202,9 @@ private:
 class ConditionRegeneration final : public ConditionGeneric {
 public:
 	ConditionRegeneration(ConditionId_t initId, ConditionType_t initType, int32_t iniTicks, bool initBuff = false, uint32_t initSubId = 0) :
-		ConditionGeneric(initId, initType, iniTicks, initBuff, initSubId) { }
+		ConditionGeneric(initId, initType, iniTicks, initBuff, initSubId) {
+		periodicEffect = true;
+	}
 
 	bool startCondition(std::shared_ptr<Creature> creature) override;
 	void endCondition(std::shared_ptr<Creature> creature) override;
@@ -228,7 +261,9 @@ private:
 class ConditionSoul final : public ConditionGeneric {
 public:
 	ConditionSoul(ConditionId_t initId, ConditionType_t initType, int32_t iniTicks, bool initBuff = false, uint32_t initSubId = 0) :
-		ConditionGeneric(initId, initType, iniTicks, initBuff, initSubId) { }
+		ConditionGeneric(initId, initType, iniTicks, initBuff, initSubId) {
+		periodicEffect = true;
+	}
 
 	void addCondition(std::shared_ptr<Creature> creature, std::shared_ptr<Condition> addCondition) override;
 	bool executeCondition(std::shared_ptr<Creature> creature, int32_t interval) override;
@@ -264,9 +299,13 @@ public:
 
 class ConditionDamage final : public Condition {
 public:
-	ConditionDamage() = default;
+	ConditionDamage() {
+		periodicEffect = true;
+	}
 	ConditionDamage(ConditionId_t intiId, ConditionType_t initType, bool initBuff = false, uint32_t initSubId = 0) :
-		Condition(intiId, initType, 0, initBuff, initSubId) { }
+		Condition(intiId, initType, 0, initBuff, initSubId) {
+		periodicEffect = true;
+	}
 
 	static void generateDamageList(int32_t amount, int32_t start, std::list<int32_t> &list);
 
@@ -317,9 +356,13 @@ private:
 
 class ConditionFeared final : public Condition {
 public:
-	ConditionFeared() = default;
+	ConditionFeared() {
+		periodicEffect = true;
+	}
 	ConditionFeared(ConditionId_t intiId, ConditionType_t initType, int32_t initTicks, bool initBuff, uint32_t initSubId) :
-		Condition(intiId, initType, initTicks, initBuff, initSubId) { }
+		Condition(intiId, initType, initTicks, initBuff, initSubId) {
+		periodicEffect = true;
+	}
 
 	bool startCondition(std::shared_ptr<Creature> creature) override;
 	bool executeCondition(std::shared_ptr<Creature> creature, int32_t interval) override;
@@ -419,7 +462,9 @@ private:
 class ConditionLight final : public Condition {
 public:
 	ConditionLight(ConditionId_t initId, ConditionType_t initType, int32_t initTicks, bool initBuff, uint32_t initSubId, uint8_t initLightlevel, uint8_t initLightcolor) :
-		Condition(initId, initType, initTicks, initBuff, initSubId), lightInfo(initLightlevel, initLightcolor) { }
+		Condition(initId, initType, initTicks, initBuff, initSubId), lightInfo(initLightlevel, initLightcolor) {
+		periodicEffect = true;
+	}
 
 	bool startCondition(std::shared_ptr<Creature> creature) override;
 	bool executeCondition(std::shared_ptr<Creature> creature, int32_t interval) override;
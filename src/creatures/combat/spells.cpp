@@ -104,6 +104,28 @@ TalkActionResult_t Spells::playerSaySpell(std::shared_ptr<Player> player, std::s
 void Spells::clear() {
 	instants.clear();
 	runes.clear();
+	instantIndexOutdated = true;
+	runeIndexOutdated = true;
+}
+
+void Spells::buildInstantIndex() {
+	instantsByWords.clear();
+	instantsByName.clear();
+	instantsById.clear();
+	instantWordLengths.clear();
+
+	for (const auto &[key, instant] : instants) {
+		const std::string &instantWords = instant->getWords();
+		instantsByWords.try_emplace(asLowerCaseString(instantWords), instant);
+		instantsByName.try_emplace(asLowerCaseString(instant->getName()), instant);
+		instantsById.try_emplace(instant->getSpellId(), instant);
+		instantWordLengths.emplace_back(instantWords.length());
+	}
+
+	std::ranges::sort(instantWordLengths, std::greater<>());
+	const auto [first, last] = std::ranges::unique(instantWordLengths);
+	instantWordLengths.erase(first, last);
+	instantIndexOutdated = false;
 }
 
 bool Spells::hasInstantSpell(const std::string &word) const {
@@ -142,6 +164,7 @@ bool Spells::registerRuneLuaEvent(const std::shared_ptr<RuneSpell> rune) {
 	if (rune) {
 		uint16_t id = rune->getRuneItemId();
 		auto result = runes.emplace(rune->getRuneItemId(), rune);
+		runeIndexOutdated = true;
 		if (!result.second) {
 			g_logger().warn(
 				"[{}] duplicate registered rune with id: {}, for script: {}",
@@ -196,27 +219,36 @@ std::shared_ptr<RuneSpell> Spells::getRuneSpell(uint16_t id) {
 }
 
 std::shared_ptr<RuneSpell> Spells::getRuneSpellByName(const std::string &name) {
-	for (auto &it : runes) {
-		if (strcasecmp(it.second->getName().c_str(), name.c_str()) == 0) {
-			return it.second;
+	if (runeIndexOutdated) {
+		runesByName.clear();
+		for (const auto &[id, rune] : runes) {
+			runesByName.try_emplace(asLowerCaseString(rune->getName()), rune);
 		}
+		runeIndexOutdated = false;
+	}
+
+	if (auto it = runesByName.find(asLowerCaseString(name)); it != runesByName.end()) {
+		return it->second;
 	}
 	return nullptr;
 }
 
 std::shared_ptr<InstantSpell> Spells::getInstantSpell(const std::string &words) {
+	if (instantIndexOutdated) {
+		buildInstantIndex();
+	}
+
+	// The longest words that start the text
 	std::shared_ptr<InstantSpell> result = nullptr;
+	const std::string lowerWords = asLowerCaseString(words);
+	for (const auto spellLen : instantWordLengths) {
+		if (spellLen > lowerWords.length()) {
+			continue;
+		}
 
-	for (auto &it : instants) {
-		const std::string &instantSpellWords = it.second->getWords();
-		size_t spellLen = instantSpellWords.length();
-		if (strncasecmp(instantSpellWords.c_str(), words.c_str(), spellLen) == 0) {
-			if (!result || spellLen > result->getWords().length()) {
-				result = it.second;
-				if (words.length() == spellLen) {
-					break;
-				}
-			}
+		if (auto it = instantsByWords.find(std::string_view(lowerWords).substr(0, spellLen)); it != instantsByWords.end()) {
+			result = it->second;
+			break;
 		}
 	}
 
@@ -239,21 +271,21 @@ std::shared_ptr<InstantSpell> Spells::getInstantSpell(const std::string &words)
 }
 
 std::shared_ptr<InstantSpell> Spells::getInstantSpellById(uint16_t spellId) {
-	for (auto &it : instants) {
-		if (it.second->getSpellId() == spellId) {
-			return it.second;
-		}
+	if (instantIndexOutdated) {
+		buildInstantIndex();
 	}
-	return nullptr;
+
+	auto it = instantsById.find(spellId);
+	return it != instantsById.end() ? it->second : nullptr;
 }
 
 std::shared_ptr<InstantSpell> Spells::getInstantSpellByName(const std::string &name) {
-	for (auto &it : instants) {
-		if (strcasecmp(it.second->getName().c_str(), name.c_str()) == 0) {
-			return it.second;
-		}
+	if (instantIndexOutdated) {
+		buildInstantIndex();
 	}
-	return nullptr;
+
+	auto it = instantsByName.find(asLowerCaseString(name));
+	return it != instantsByName.end() ? it->second : nullptr;
 }
 
 Position Spells::getCasterPosition(std::shared_ptr<Creature> creature, Direction dir) {
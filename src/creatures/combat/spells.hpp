@@ -60,6 +60,7 @@ public:
 
 	void setInstantSpell(const std::string &word, const std::shared_ptr<InstantSpell> instant) {
 		instants.try_emplace(word, instant);
+		instantIndexOutdated = true;
 	}
 
 	void clear();
@@ -70,6 +71,21 @@ private:
 	std::map<uint16_t, std::shared_ptr<RuneSpell>> runes;
 	std::map<std::string, std::shared_ptr<InstantSpell>> instants;
 
+	void buildInstantIndex();
+
+	// The instants by their lowercase words, name and id, rebuilt on the first lookup after they change.
+	// Where several share one, the first of the instants map wins, as it did with the scans.
+	phmap::flat_hash_map<std::string, std::shared_ptr<InstantSpell>> instantsByWords;
+	phmap::flat_hash_map<std::string, std::shared_ptr<InstantSpell>> instantsByName;
+	phmap::flat_hash_map<uint16_t, std::shared_ptr<InstantSpell>> instantsById;
+	// The distinct lengths of the words, longest first
+	std::vector<size_t> instantWordLengths;
+	bool instantIndexOutdated = true;
+
+	// The runes by their lowercase name, looked up for every spell of the monster types
+	phmap::flat_hash_map<std::string, std::shared_ptr<RuneSpell>> runesByName;
+	bool runeIndexOutdated = true;
+
 	friend class CombatSpell;
 };
 
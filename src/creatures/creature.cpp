@@ -16,6 +16,7 @@
 #include "creatures/monsters/monster.hpp"
 #include "game/zones/zone.hpp"
 #include "map/spectators.hpp"
+#include "map/utils/flowfield.hpp"
 #include "lib/metrics/metrics.hpp"
 
 Creature::Creature() {
@@ -54,7 +55,7 @@ bool Creature::canSee(const Position &pos) {
 	return canSee(getPosition(), pos, MAP_MAX_VIEW_PORT_X, MAP_MAX_VIEW_PORT_Y);
 }
 
-bool Creature::canSeeCreature(std::shared_ptr<Creature> creature) const {
+bool Creature::canSeeCreature(const std::shared_ptr<Creature> &creature) const {
 	if (!canSeeInvisibility() && creature->isInvisible()) {
 		return false;
 	}
@@ -173,6 +174,8 @@ void Creature::onCreatureWalk() {
 					player->sendCancelWalk();
 				}
 
+				// The cached path goes through where the creature could not step
+				followPathCache.expiresAt = 0;
 				forceUpdateFollowPath = true;
 			}
 		} else {
@@ -257,6 +260,13 @@ void Creature::addEventWalk(bool firstStep) {
 			g_game().checkCreatureWalk(self->getID());
 		}
 
+		// The players step on time, the other creatures are batched with the steps due around the same time
+		self->eventWalkBatched = !self->getPlayer();
+		if (self->eventWalkBatched) {
+			self->eventWalk = g_game().addCreatureWalkBatch(self->getID(), ticks);
+			return;
+		}
+
 		self->eventWalk = g_dispatcher().scheduleEvent(
 			static_cast<uint32_t>(ticks),
 			[creatureId = self->getID()] { g_game().checkCreatureWalk(creatureId); }, "Game::checkCreatureWalk"
@@ -266,7 +276,10 @@ void Creature::addEventWalk(bool firstStep) {
 
 void Creature::stopEventWalk() {
 	if (eventWalk != 0) {
-		g_dispatcher().stopEvent(eventWalk);
+		// A batched step is skipped once the token no longer matches
+		if (!eventWalkBatched) {
+			g_dispatcher().stopEvent(eventWalk);
+		}
 		eventWalk = 0;
 	}
 }
@@ -290,7 +303,10 @@ void Creature::updateMapCache() {
 void Creature::updateTileCache(std::shared_ptr<Tile> newTile, int32_t dx, int32_t dy) {
 	metrics::method_latency measure(__METHOD_NAME__);
 	if (std::abs(dx) <= maxWalkCacheWidth && std::abs(dy) <= maxWalkCacheHeight) {
-		localMapCache[maxWalkCacheHeight + dy][maxWalkCacheWidth + dx] = newTile && newTile->queryAdd(0, getCreature(), 1, FLAG_PATHFINDING | FLAG_IGNOREFIELDDAMAGE) == RETURNVALUE_NOERROR;
+		const bool walkable = newTile && newTile->queryAdd(0, getCreature(), 1, FLAG_PATHFINDING | FLAG_IGNOREFIELDDAMAGE) == RETURNVALUE_NOERROR;
+		auto &row = localMapCache[maxWalkCacheHeight + dy];
+		const uint32_t bit = 1u << (maxWalkCacheWidth + dx);
+		row = walkable ? row | bit : row & ~bit;
 	}
 }
 
@@ -322,7 +338,7 @@ int32_t Creature::getWalkCache(const Position &pos) {
 	if (std::abs(dx) <= maxWalkCacheWidth) {
 		int32_t dy = Position::getOffsetY(pos, myPos);
 		if (std::abs(dy) <= maxWalkCacheHeight) {
-			return localMapCache[maxWalkCacheHeight + dy][maxWalkCacheWidth + dx];
+			return (localMapCache[maxWalkCacheHeight + dy] >> (maxWalkCacheWidth + dx)) & 1;
 		}
 	}
 
@@ -509,9 +525,7 @@ void Creature::onCreatureMove(const std::shared_ptr<Creature> &creature, const s
 
 				if (oldPos.y > newPos.y) { // north
 					// shift y south
-					for (int32_t y = mapWalkHeight - 1; --y >= 0;) {
-						memcpy(localMapCache[y + 1], localMapCache[y], sizeof(localMapCache[y]));
-					}
+					std::shift_right(localMapCache.begin(), localMapCache.end(), 1);
 
 					// update 0
 					for (int32_t x = -maxWalkCacheWidth; x <= maxWalkCacheWidth; ++x) {
@@ -520,9 +534,7 @@ void Creature::onCreatureMove(const std::shared_ptr<Creature> &creature, const s
 					}
 				} else if (oldPos.y < newPos.y) { // south
 					// shift y north
-					for (int32_t y = 0; y <= mapWalkHeight - 2; ++y) {
-						memcpy(localMapCache[y], localMapCache[y + 1], sizeof(localMapCache[y]));
-					}
+					std::shift_left(localMapCache.begin(), localMapCache.end(), 1);
 
 					// update mapWalkHeight - 1
 					for (int32_t x = -maxWalkCacheWidth; x <= maxWalkCacheWidth; ++x) {
@@ -544,9 +556,7 @@ void Creature::onCreatureMove(const std::shared_ptr<Creature> &creature, const s
 					}
 
 					for (int32_t y = starty; y <= endy; ++y) {
-						for (int32_t x = 0; x <= mapWalkWidth - 2; ++x) {
-							localMapCache[y][x] = localMapCache[y][x + 1];
-						}
+						localMapCache[y] >>= 1;
 					}
 
 					// update mapWalkWidth - 1
@@ -567,9 +577,7 @@ void Creature::onCreatureMove(const std::shared_ptr<Creature> &creature, const s
 					}
 
 					for (int32_t y = starty; y <= endy; ++y) {
-						for (int32_t x = mapWalkWidth - 1; --x >= 0;) {
-							localMapCache[y][x + 1] = localMapCache[y][x];
-						}
+						localMapCache[y] = (localMapCache[y] << 1) & mapWalkRowMask;
 					}
 
 					// update 0
@@ -625,6 +633,14 @@ void Creature::onCreatureMove(const std::shared_ptr<Creature> &creature, const s
 	}
 }
 
+bool Creature::wantsCreatureMove(const std::shared_ptr<Creature> &creature) {
+	if (creature.get() == this || isMapLoaded) {
+		return true;
+	}
+	// Only the moves of what it follows or attacks are looked at
+	return creature == getFollowCreature() || creature == getAttackedCreature();
+}
+
 void Creature::onDeath() {
 	metrics::method_latency measure(__METHOD_NAME__);
 	bool lastHitUnjustified = false;
@@ -1101,7 +1117,13 @@ void Creature::goToFollowCreature() {
 	}
 
 	if (listDir.empty()) {
-		hasFollowPath = getPathTo(followCreature->getPosition(), listDir, fpp);
+		const auto &targetPos = followCreature->getPosition();
+		if (getFlowFieldStep(targetPos, fpp, listDir)) {
+			hasFollowPath = true;
+		} else if (!getCachedFollowPath(targetPos, fpp, listDir)) {
+			hasFollowPath = getPathTo(targetPos, listDir, fpp);
+			setCachedFollowPath(targetPos, fpp, listDir, hasFollowPath);
+		}
 	}
 
 	startAutoWalk(listDir);
@@ -1111,6 +1133,108 @@ void Creature::goToFollowCreature() {
 	}
 }
 
+bool Creature::getFlowFieldStep(const Position &targetPos, const FindPathParams &fpp, std::vector<Direction> &dirList) {
+	// Only plain melee chasing, ranged and fleeing monsters look for a specific distance
+	if (!getMonster() || isSummon() || fpp.keepDistance || fpp.maxTargetDist != 1) {
+		return false;
+	}
+
+	const auto radius = g_configManager().getNumber(FLOW_FIELD_RADIUS, __FUNCTION__);
+	const auto &myPos = getPosition();
+	const auto distance = std::max(Position::getDistanceX(myPos, targetPos), Position::getDistanceY(myPos, targetPos));
+	if (radius <= 0 || myPos.z != targetPos.z || distance <= 1 || distance > radius) {
+		return false;
+	}
+
+	Direction dir;
+	if (!FlowField::get(targetPos, radius)->getNextStep(getCreature(), dir)) {
+		return false;
+	}
+
+	dirList.emplace_back(dir);
+	return true;
+}
+
+bool Creature::getCachedFollowPath(const Position &targetPos, const FindPathParams &fpp, std::vector<Direction> &dirList) {
+	const auto tolerance = g_configManager().getNumber(PATHFINDING_CACHE_TOLERANCE, __FUNCTION__);
+	auto &cache = followPathCache;
+	if (tolerance <= 0 || cache.expiresAt < OTSYS_TIME() || cache.fpp != fpp || cache.target.z != targetPos.z) {
+		return false;
+	}
+
+	// The creature may have walked part of the path already, the steps are taken from the back
+	const auto &myPos = getPosition();
+	Position pos = cache.from;
+	auto remaining = cache.dirs.size();
+	while (pos != myPos) {
+		if (remaining == 0) {
+			return false;
+		}
+		pos = getNextPosition(cache.dirs[--remaining], pos);
+	}
+
+	const auto moved = std::max(Position::getDistanceX(cache.target, targetPos), Position::getDistanceY(cache.target, targetPos));
+	if (moved == 1 && repairCachedFollowPath(targetPos, remaining)) {
+		dirList = cache.dirs;
+		hasFollowPath = true;
+		return true;
+	}
+
+	if (moved > tolerance) {
+		return false;
+	}
+
+	dirList.assign(cache.dirs.begin(), cache.dirs.begin() + remaining);
+	hasFollowPath = cache.found;
+	return true;
+}
+
+bool Creature::repairCachedFollowPath(const Position &targetPos, size_t remaining) {
+	// Only paths that end next to the target, the ones that keep a distance take the best tile of a search
+	auto &cache = followPathCache;
+	const auto &fpp = cache.fpp;
+	if (!cache.found || fpp.keepDistance || fpp.maxTargetDist != 1) {
+		return false;
+	}
+
+	const auto &myPos = getPosition();
+	Position endPos = myPos;
+	for (auto i = remaining; i > 0; --i) {
+		endPos = getNextPosition(cache.dirs[i - 1], endPos);
+	}
+
+	// The end of the path may still be next to the target, or a step towards it may be
+	const FrozenPathingConditionCall condition(targetPos);
+	int32_t bestMatchDist = 0;
+	if (!condition(myPos, endPos, fpp, bestMatchDist)) {
+		const Direction dir = getDirectionTo(endPos, targetPos, false);
+		const Position stepPos = getNextPosition(dir, endPos);
+		if (stepPos == targetPos || !condition(myPos, stepPos, fpp, bestMatchDist) || !g_game().map.canWalkTo(getCreature(), stepPos)) {
+			return false;
+		}
+		// The last step is the first one of the list
+		cache.dirs.insert(cache.dirs.begin(), dir);
+		++remaining;
+	}
+
+	// Drops the steps that were walked already
+	cache.dirs.resize(remaining);
+	cache.from = myPos;
+	cache.target = targetPos;
+	return true;
+}
+
+void Creature::setCachedFollowPath(const Position &targetPos, const FindPathParams &fpp, const std::vector<Direction> &dirList, bool found) {
+	const auto cacheTime = g_configManager().getNumber(PATHFINDING_CACHE_TIME, __FUNCTION__);
+	auto &cache = followPathCache;
+	cache.from = getPosition();
+	cache.target = targetPos;
+	cache.fpp = fpp;
+	cache.dirs = dirList;
+	cache.found = found;
+	cache.expiresAt = OTSYS_TIME() + cacheTime;
+}
+
 bool Creature::canFollowMaster() {
 	auto master = getMaster();
 	if (!master) {
@@ -1368,6 +1492,7 @@ bool Creature::addCondition(std::shared_ptr<Condition> condition, bool attackerP
 
 	if (condition->startCondition(getCreature())) {
 		conditions.push_back(condition);
+		conditionsIdle = false;
 		onAddCondition(condition->getType());
 		return true;
 	}
@@ -1489,21 +1614,38 @@ std::vector<std::shared_ptr<Condition>> Creature::getConditionsByType(ConditionT
 
 void Creature::executeConditions(uint32_t interval) {
 	metrics::method_latency measure(__METHOD_NAME__);
+	// Permanent conditions without periodic effects do nothing when ticked
+	if (conditionsIdle && conditionsIdleEpoch == Condition::getPermanentEpoch()) {
+		return;
+	}
+
+	const auto self = getCreature();
+	// Conditions without periodic effects share the tick time and skip the virtual execute
+	const auto now = OTSYS_TIME();
+	bool idle = true;
+
 	auto it = conditions.begin(), end = conditions.end();
 	while (it != end) {
 		std::shared_ptr<Condition> condition = *it;
-		if (!condition->executeCondition(getCreature(), interval)) {
+		const bool periodic = condition->hasPeriodicEffect();
+		const bool active = periodic ? condition->executeCondition(self, interval) : condition->tickTimer(interval, now);
+		if (!active) {
 			ConditionType_t type = condition->getType();
 
 			it = conditions.erase(it);
 
-			condition->endCondition(getCreature());
+			condition->endCondition(self);
 
 			onEndCondition(type);
 		} else {
+			idle = idle && !periodic && condition->getTicks() == -1;
 			++it;
 		}
 	}
+
+	// The conditions added while walking were walked too, the list is iterated up to its end
+	conditionsIdle = idle;
+	conditionsIdleEpoch = Condition::getPermanentEpoch();
 }
 
 bool Creature::hasCondition(ConditionType_t type, uint32_t subId /* = 0*/) const {
@@ -1742,6 +1884,11 @@ bool Creature::isInvisible() const {
 
 bool Creature::getPathTo(const Position &targetPos, std::vector<Direction> &dirList, const FindPathParams &fpp) {
 	metrics::method_latency measure(__METHOD_NAME__);
+	if (const auto &monster = getMonster()) {
+		if (const auto activity = monster->getSpawnActivity()) {
+			activity->pathSearches.fetch_add(1, std::memory_order_relaxed);
+		}
+	}
 	if (fpp.maxSearchDist != 0 || fpp.keepDistance) {
 		return g_game().map.getPathMatchingCond(getCreature(), targetPos, dirList, FrozenPathingConditionCall(targetPos), fpp);
 	}
@@ -1889,7 +2036,7 @@ void Creature::setIncreasePercent(CombatType_t combat, int32_t value) {
 	}
 }
 
-std::unordered_set<std::shared_ptr<Zone>> Creature::getZones() {
+ZoneVector Creature::getZones() {
 	if (const auto &tile = getTile()) {
 		return tile->getZones();
 	}
@@ -117,7 +117,7 @@ public:
 	virtual void addList() = 0;
 
 	virtual bool canSee(const Position &pos);
-	virtual bool canSeeCreature(std::shared_ptr<Creature> creature) const;
+	virtual bool canSeeCreature(const std::shared_ptr<Creature> &creature) const;
 
 	virtual RaceType_t getRace() const {
 		return RACE_NONE;
@@ -298,7 +298,7 @@ public:
 		return ZONE_NORMAL;
 	}
 
-	std::unordered_set<std::shared_ptr<Zone>> getZones();
+	ZoneVector getZones();
 
 	// walk functions
 	void startAutoWalk(const std::vector<Direction> &listDir, bool ignoreConditions = false);
@@ -408,6 +408,14 @@ public:
 	void executeConditions(uint32_t interval);
 	bool hasCondition(ConditionType_t type, uint32_t subId = 0) const;
 
+	/**
+	 * @return true if the conditions do not need to be ticked: there are none,
+	 * or the last walk found only permanent ones without periodic effects.
+	 */
+	bool hasIdleConditions() const {
+		return conditions.empty() || (conditionsIdle && conditionsIdleEpoch == Condition::getPermanentEpoch());
+	}
+
 	virtual bool isImmune([[maybe_unused]] CombatType_t type) const {
 		return false;
 	}
@@ -474,6 +482,11 @@ public:
 	virtual void setNormalCreatureLight();
 	void setCreatureLight(LightInfo lightInfo);
 
+	/**
+	 * Decide phase of Game::checkCreatures, it runs in parallel for every creature of the bucket
+	 * before onThink, so it must not change any game state, only cache what onThink is going to use.
+	 */
+	virtual void onThinkDecide(uint32_t) { }
 	virtual void onThink(uint32_t interval);
 	void onAttacking(uint32_t interval);
 	virtual void onCreatureWalk();
@@ -498,11 +511,20 @@ public:
 	 */
 	void checkSummonMove(const Position &newPos, bool teleportSummon = false);
 	virtual void onCreatureMove(const std::shared_ptr<Creature> &creature, const std::shared_ptr<Tile> &newTile, const Position &newPos, const std::shared_ptr<Tile> &oldTile, const Position &oldPos, bool teleport);
+	/**
+	 * Whether onCreatureMove does anything for a move of the creature, Map::moveCreature skips the spectators that would ignore it.
+	 * Read from the state it depends on (what it follows and attacks), so it never goes stale.
+	 */
+	virtual bool wantsCreatureMove(const std::shared_ptr<Creature> &creature);
 
 	virtual void onAttackedCreatureDisappear(bool) { }
 	virtual void onFollowCreatureDisappear(bool) { }
 
 	virtual void onCreatureSay(std::shared_ptr<Creature>, SpeakClasses, const std::string &) { }
+	// Same for onCreatureSay, skipped by Game::internalCreatureSay
+	virtual bool wantsCreatureSay(const std::shared_ptr<Creature> &) const {
+		return false;
+	}
 
 	virtual void onPlacedCreature() { }
 
@@ -555,9 +577,9 @@ public:
 			m_tile = newParent;
 
 			if (newParent->getGround()) {
-				const auto &it = Item::items[newParent->getGround()->getID()];
-				if (it.speed > 0) {
-					walk.groundSpeed = it.speed;
+				const auto speed = Item::items.getHot(newParent->getGround()->getID()).speed;
+				if (speed > 0) {
+					walk.groundSpeed = speed;
 				}
 			}
 		}
@@ -727,6 +749,9 @@ protected:
 	std::vector<std::shared_ptr<Creature>> m_summons;
 	CreatureEventList eventsList;
 	ConditionList conditions;
+	// Set when every condition is permanent and without periodic effects, see Condition::getPermanentEpoch
+	bool conditionsIdle = false;
+	uint32_t conditionsIdleEpoch = 0;
 
 	std::vector<Direction> listWalkDir;
 
@@ -780,7 +805,10 @@ protected:
 	Direction direction = DIRECTION_SOUTH;
 	Skulls_t skull = SKULL_NONE;
 
-	bool localMapCache[mapWalkHeight][mapWalkWidth] = { { false } };
+	// A row of the walk cache per y, bit x set when the tile at that x is walkable for this creature
+	static_assert(mapWalkWidth <= 32);
+	static constexpr uint32_t mapWalkRowMask = (1ull << mapWalkWidth) - 1;
+	std::array<uint32_t, mapWalkHeight> localMapCache {};
 	bool isInternalRemoved = false;
 	bool isMapLoaded = false;
 	bool isUpdatingPath = false;
@@ -789,6 +817,8 @@ protected:
 	bool skillLoss = true;
 	bool lootDrop = true;
 	bool cancelNextWalk = false;
+	// eventWalk is a token of Game::addCreatureWalkBatch and not a dispatcher event
+	bool eventWalkBatched = false;
 	bool forceUpdateFollowPath = false;
 	bool hiddenHealth = false;
 	bool floorChange = false;
@@ -837,7 +867,27 @@ protected:
 	friend class CreatureFunctions;
 
 private:
+	// Last follow path, reused while the target stays close to where it was (see pathfindingCacheTolerance)
+	struct FollowPathCache {
+		Position from;
+		Position target;
+		FindPathParams fpp;
+		std::vector<Direction> dirs;
+		int64_t expiresAt = 0;
+		bool found = false;
+	};
+	FollowPathCache followPathCache;
+
 	bool canFollowMaster();
+	bool getFlowFieldStep(const Position &targetPos, const FindPathParams &fpp, std::vector<Direction> &dirList);
+	bool getCachedFollowPath(const Position &targetPos, const FindPathParams &fpp, std::vector<Direction> &dirList);
+	void setCachedFollowPath(const Position &targetPos, const FindPathParams &fpp, const std::vector<Direction> &dirList, bool found);
+	/**
+	 * Follows a target that moved one tile with the rest of the cached path, extended by a step when it no longer ends next to it.
+	 * @param remaining the steps of the cached path that were not walked yet
+	 * @return false if the path can not be repaired and has to be searched again.
+	 */
+	bool repairCachedFollowPath(const Position &targetPos, size_t remaining);
 	bool isLostSummon();
 	void handleLostSummon(bool teleportSummons);
 
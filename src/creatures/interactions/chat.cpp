@@ -94,6 +94,7 @@ bool ChatChannel::addUser(const std::shared_ptr<Player> &player) {
 	}
 
 	users[player->getID()] = player;
+	members.emplace_back(player);
 	return true;
 }
 
@@ -104,6 +105,7 @@ bool ChatChannel::removeUser(const std::shared_ptr<Player> &player) {
 	}
 
 	users.erase(iter);
+	std::erase(members, player);
 
 	if (!publicChannel) {
 		for (const auto &it : users) {
@@ -120,8 +122,11 @@ bool ChatChannel::hasUser(const std::shared_ptr<Player> &player) {
 }
 
 void ChatChannel::sendToAll(const std::string &message, SpeakClasses type) const {
-	for (const auto &it : users) {
-		it.second->sendChannelMessage("", message, type, id);
+	BroadcastMessage broadcast([&message, type, channelId = id](NetworkMessage &msg, bool) {
+		ProtocolGame::addChannelMessage(msg, "", message, type, channelId);
+	});
+	for (const auto &member : members) {
+		member->sendBroadcast(broadcast);
 	}
 }
 
@@ -130,8 +135,12 @@ bool ChatChannel::talk(const std::shared_ptr<Player> &fromPlayer, SpeakClasses t
 		return false;
 	}
 
-	for (const auto &it : users) {
-		it.second->sendToChannel(fromPlayer, type, text, id);
+	// Serialized once per protocol version, the members only copy it
+	BroadcastMessage message([&fromPlayer, type, &text, channelId = id](NetworkMessage &msg, bool oldProtocol) {
+		ProtocolGame::addToChannel(msg, fromPlayer, type, text, channelId, oldProtocol);
+	});
+	for (const auto &member : members) {
+		member->sendBroadcast(message);
 	}
 	return true;
 }
@@ -302,6 +311,8 @@ bool Chat::load() {
 			}
 
 			UsersMap tempUserMap = std::move(channel->users);
+			channel->users.clear();
+			channel->members.clear();
 			for (const auto &pair : tempUserMap) {
 				channel->addUser(pair.second);
 			}
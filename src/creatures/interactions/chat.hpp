@@ -63,6 +63,8 @@ public:
 
 protected:
 	UsersMap users;
+	// The values of users, walked by the messages to every user
+	std::vector<std::shared_ptr<Player>> members;
 
 	std::string name;
 
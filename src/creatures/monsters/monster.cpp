@@ -21,7 +21,6 @@
 int32_t Monster::despawnRange;
 int32_t Monster::despawnRadius;
 
-uint32_t Monster::monsterAutoID = 0x50000001;
 
 std::shared_ptr<Monster> Monster::createMonster(const std::string &name) {
 	const auto mType = g_monsters().getMonsterType(name);
@@ -56,6 +55,10 @@ Monster::Monster(const std::shared_ptr<MonsterType> mType) :
 	}
 }
 
+void Monster::setID() {
+	id = g_game().reserveMonsterID(id);
+}
+
 void Monster::addList() {
 	g_game().addMonster(static_self_cast<Monster>());
 }
@@ -481,9 +484,18 @@ void Monster::updateTargetList() {
 		return !target || target->getHealth() <= 0 || !canSee(target->getPosition());
 	});
 
+	// The callers update the idle status once the list is complete, not for every creature found
 	for (const auto &spectator : Spectators().find<Creature>(position, true)) {
-		if (spectator.get() != this && canSee(spectator->getPosition())) {
-			onCreatureFound(spectator);
+		if (spectator.get() == this || !canSee(spectator->getPosition())) {
+			continue;
+		}
+
+		if (isFriend(spectator)) {
+			addFriend(spectator);
+		}
+
+		if (isOpponent(spectator)) {
+			addTarget(spectator);
 		}
 	}
 }
@@ -595,13 +607,32 @@ bool Monster::searchTarget(TargetSearchType_t searchType /*= TARGETSEARCH_DEFAUL
 	std::vector<std::shared_ptr<Creature>> resultList;
 	const Position &myPos = getPosition();
 
-	for (const auto &cref : targetList) {
-		const auto &creature = cref.lock();
-		if (creature && isTarget(creature)) {
-			if ((static_self_cast<Monster>()->targetDistance == 1) || canUseAttack(myPos, creature)) {
+	if (decidedTargetsCycle == g_dispatcher().getDispatcherCycle() && decidedTargetsPosition == myPos && decidedTargetsDistance == targetDistance
+	    && decidedSightLinesVersion == Map::getSightLinesVersion()) {
+		// The line of sight was already checked by onThinkDecide for the targets that did not move since then
+		for (const auto &cref : targetList) {
+			const auto &creature = cref.lock();
+			if (!creature || !isTarget(creature)) {
+				continue;
+			}
+
+			const auto it = std::ranges::find(decidedTargets, creature, &DecidedTarget::creature);
+			const bool attackable = it != decidedTargets.end() && it->position == creature->getPosition()
+				? it->attackable
+				: targetDistance == 1 || canUseAttack(myPos, creature);
+			if (attackable) {
 				resultList.push_back(creature);
 			}
 		}
+	} else {
+		for (const auto &cref : targetList) {
+			const auto &creature = cref.lock();
+			if (creature && isTarget(creature)) {
+				if ((static_self_cast<Monster>()->targetDistance == 1) || canUseAttack(myPos, creature)) {
+					resultList.push_back(creature);
+				}
+			}
+		}
 	}
 
 	if (resultList.empty()) {
@@ -741,7 +772,7 @@ BlockType_t Monster::blockHit(std::shared_ptr<Creature> attacker, CombatType_t c
 
 		// Wheel of destiny
 		std::shared_ptr<Player> player = attacker ? attacker->getPlayer() : nullptr;
-		if (player && player->wheel()->getInstant("Ballistic Mastery")) {
+		if (player && player->wheel()->getInstant(WheelInstant_t::BALLISTIC_MASTERY)) {
 			elementMod -= player->wheel()->checkElementSensitiveReduction(combatType);
 		}
 
@@ -817,7 +848,8 @@ void Monster::setIdle(bool idle) {
 
 void Monster::updateIdleStatus() {
 	bool idle = false;
-	if (conditions.empty()) {
+	// Permanent conditions are not ticked while idle, they keep the monster from sleeping only when they need to
+	if (hasIdleConditions()) {
 		if (!isSummon() && targetList.empty()) {
 			if (isInSpawnLocation()) {
 				idle = true;
@@ -856,6 +888,34 @@ void Monster::onEndCondition(ConditionType_t type) {
 	onConditionStatusChange(type);
 }
 
+void Monster::onThinkDecide(uint32_t) {
+	decidedTargets.clear();
+	decidedTargetsCycle = 0;
+	decidedAttackedId = 0;
+	if (isIdle || isSummon() || targetList.empty()) {
+		return;
+	}
+
+	const Position &myPos = getPosition();
+	if (const auto &attackedCreature = getAttackedCreature()) {
+		decidedAttackedId = attackedCreature->getID();
+		decidedAttackedPosition = attackedCreature->getPosition();
+		decidedAttackable = canUseAttack(myPos, attackedCreature);
+	}
+
+	decidedSightLinesVersion = Map::getSightLinesVersion();
+	for (const auto &cref : targetList) {
+		const auto &creature = cref.lock();
+		if (creature && isTarget(creature)) {
+			decidedTargets.push_back({ creature, creature->getPosition(), targetDistance == 1 || canUseAttack(myPos, creature) });
+		}
+	}
+
+	decidedTargetsCycle = g_dispatcher().getDispatcherCycle();
+	decidedTargetsPosition = myPos;
+	decidedTargetsDistance = targetDistance;
+}
+
 void Monster::onThink(uint32_t interval) {
 	Creature::onThink(interval);
 
@@ -929,12 +989,12 @@ void Monster::onThink(uint32_t interval) {
 		}
 	} else if (!targetList.empty()) {
 		const bool attackedCreatureIsDisconnected = attackedCreature && attackedCreature->getPlayer() && attackedCreature->getPlayer()->isDisconnected();
-		const bool attackedCreatureIsUnattackable = attackedCreature && !canUseAttack(getPosition(), attackedCreature);
+		const bool attackedCreatureIsUnattackable = attackedCreature && !canUseAttackOnAttacked(attackedCreature);
 		const bool attackedCreatureIsUnreachable = targetDistance <= 1 && attackedCreature && followCreature && !hasFollowPath;
 		if (!attackedCreature || attackedCreatureIsDisconnected || attackedCreatureIsUnattackable || attackedCreatureIsUnreachable) {
 			if (!followCreature || !hasFollowPath || attackedCreatureIsDisconnected) {
 				searchTarget(TARGETSEARCH_NEAREST);
-			} else if (attackedCreature && isFleeing() && !canUseAttack(getPosition(), attackedCreature)) {
+			} else if (attackedCreature && isFleeing() && !canUseAttackOnAttacked(attackedCreature)) {
 				searchTarget(TARGETSEARCH_DEFAULT);
 			}
 		}
@@ -981,6 +1041,9 @@ void Monster::doAttacking(uint32_t interval) {
 				}
 
 				spellBlock.spell->castSpell(getMonster(), attackedCreature);
+				if (const auto activity = getSpawnActivity()) {
+					activity->combats.fetch_add(1, std::memory_order_relaxed);
+				}
 
 				if (spellBlock.isMelee) {
 					extraMeleeAttack = false;
@@ -1017,6 +1080,15 @@ bool Monster::canUseAttack(const Position &pos, const std::shared_ptr<Creature>
 	return true;
 }
 
+bool Monster::canUseAttackOnAttacked(const std::shared_ptr<Creature> &attackedCreature) const {
+	if (decidedTargetsCycle == g_dispatcher().getDispatcherCycle() && decidedAttackedId == attackedCreature->getID()
+	    && decidedTargetsPosition == getPosition() && decidedAttackedPosition == attackedCreature->getPosition()
+	    && decidedSightLinesVersion == Map::getSightLinesVersion()) {
+		return decidedAttackable;
+	}
+	return canUseAttack(getPosition(), attackedCreature);
+}
+
 bool Monster::canUseSpell(const Position &pos, const Position &targetPos, const spellBlock_t &sb, uint32_t interval, bool &inRange, bool &resetTicks) {
 	inRange = true;
 
@@ -1117,6 +1189,9 @@ void Monster::onThinkDefense(uint32_t interval) {
 			minCombatValue = spellBlock.minCombatValue;
 			maxCombatValue = spellBlock.maxCombatValue;
 			spellBlock.spell->castSpell(getMonster(), getMonster());
+			if (const auto activity = getSpawnActivity()) {
+				activity->combats.fetch_add(1, std::memory_order_relaxed);
+			}
 		}
 	}
 
@@ -2035,6 +2110,13 @@ std::shared_ptr<Item> Monster::getCorpse(std::shared_ptr<Creature> lastHitCreatu
 	return corpse;
 }
 
+SpawnMonsterActivity* Monster::getSpawnActivity() const {
+	if (!spawnMonster || !SpawnMonster::isTrackingActivity()) {
+		return nullptr;
+	}
+	return &spawnMonster->getActivity();
+}
+
 bool Monster::isInSpawnRange(const Position &pos) const {
 	if (!spawnMonster) {
 		return true;
@@ -2158,7 +2240,8 @@ void Monster::setNormalCreatureLight() {
 void Monster::drainHealth(std::shared_ptr<Creature> attacker, int32_t damage) {
 	Creature::drainHealth(attacker, damage);
 
-	if (damage > 0 && randomStepping) {
+	// The cache only changes when the fields stop being avoided, not on every hit taken
+	if (damage > 0 && randomStepping && !ignoreFieldDamage) {
 		ignoreFieldDamage = true;
 		updateMapCache();
 	}
@@ -15,6 +15,7 @@
 
 class Creature;
 class Game;
+struct SpawnMonsterActivity;
 
 class Monster final : public Creature {
 public:
@@ -35,11 +36,7 @@ public:
 		return static_self_cast<Monster>();
 	}
 
-	void setID() override {
-		if (id == 0) {
-			id = monsterAutoID++;
-		}
-	}
+	void setID() override;
 
 	void addList() override;
 	void removeList() override;
@@ -133,6 +130,10 @@ public:
 	void setSpawnMonster(SpawnMonster* newSpawnMonster) {
 		this->spawnMonster = newSpawnMonster;
 	}
+	/**
+	 * @return the activity counters of the spawn of the monster, nullptr if it has none or the activity is not reported.
+	 */
+	SpawnMonsterActivity* getSpawnActivity() const;
 
 	double_t getReflectPercent(CombatType_t combatType, bool useCharges = false) const override;
 	uint32_t getHealingCombatValue(CombatType_t healingType) const;
@@ -145,7 +146,14 @@ public:
 	void onCreatureAppear(std::shared_ptr<Creature> creature, bool isLogin) override;
 	void onRemoveCreature(std::shared_ptr<Creature> creature, bool isLogout) override;
 	void onCreatureMove(const std::shared_ptr<Creature> &creature, const std::shared_ptr<Tile> &newTile, const Position &newPos, const std::shared_ptr<Tile> &oldTile, const Position &oldPos, bool teleport) override;
+	// Keeps its target and friend lists from every move it sees
+	bool wantsCreatureMove(const std::shared_ptr<Creature> &) override {
+		return true;
+	}
 	void onCreatureSay(std::shared_ptr<Creature> creature, SpeakClasses type, const std::string &text) override;
+	bool wantsCreatureSay(const std::shared_ptr<Creature> &) const override {
+		return mType->info.creatureSayEvent != -1;
+	}
 	void onAttackedByPlayer(std::shared_ptr<Player> attackerPlayer);
 	void onSpawn();
 
@@ -154,6 +162,7 @@ public:
 	bool getNextStep(Direction &direction, uint32_t &flags) override;
 	void onFollowCreatureComplete(const std::shared_ptr<Creature> &creature) override;
 
+	void onThinkDecide(uint32_t interval) override;
 	void onThink(uint32_t interval) override;
 
 	bool challengeCreature(std::shared_ptr<Creature> creature, int targetChangeCooldown) override;
@@ -288,7 +297,9 @@ public:
 
 	BlockType_t blockHit(std::shared_ptr<Creature> attacker, CombatType_t combatType, int32_t &damage, bool checkDefense = false, bool checkArmor = false, bool field = false) override;
 
-	static uint32_t monsterAutoID;
+	// The monster ids, they are the slots of the monsters in the game list (Game::reserveMonsterID)
+	static constexpr uint32_t FIRST_ID = 0x50000000;
+	static constexpr uint32_t ID_COUNT = 0x30000000;
 
 	void configureForgeSystem();
 
@@ -376,6 +387,23 @@ private:
 	std::unordered_map<uint32_t, std::weak_ptr<Creature>> friendList;
 	std::deque<std::weak_ptr<Creature>> targetList;
 
+	// canUseAttack on the targets by onThinkDecide with the position they had, valid for the dispatcher cycle,
+	// position, target distance and sight lines they were computed with
+	struct DecidedTarget {
+		std::shared_ptr<Creature> creature;
+		Position position;
+		bool attackable = false;
+	};
+	std::vector<DecidedTarget> decidedTargets;
+	uint64_t decidedTargetsCycle = 0;
+	Position decidedTargetsPosition;
+	int32_t decidedTargetsDistance = 0;
+	uint32_t decidedSightLinesVersion = 0;
+	// canUseAttack on the attacked creature, computed by onThinkDecide too
+	uint32_t decidedAttackedId = 0;
+	Position decidedAttackedPosition;
+	bool decidedAttackable = false;
+
 	time_t timeToChangeFiendish = 0;
 
 	// Forge System
@@ -451,6 +479,8 @@ private:
 	void onEndCondition(ConditionType_t type) override;
 
 	bool canUseAttack(const Position &pos, const std::shared_ptr<Creature> &target) const;
+	// canUseAttack on the attacked creature, from onThinkDecide while neither of them moved
+	bool canUseAttackOnAttacked(const std::shared_ptr<Creature> &attackedCreature) const;
 	bool canUseSpell(const Position &pos, const Position &targetPos, const spellBlock_t &sb, uint32_t interval, bool &inRange, bool &resetTicks);
 	bool getRandomStep(const Position &creaturePos, Direction &direction);
 	bool getDanceStep(const Position &creaturePos, Direction &direction, bool keepAttack = true, bool keepDistance = true);
@@ -17,6 +17,7 @@
 #include "items/weapons/weapons.hpp"
 
 void MonsterType::loadLoot(const std::shared_ptr<MonsterType> monsterType, LootBlock lootBlock) {
+	monsterType->lootRevision = ++lastLootRevision;
 	if (lootBlock.childLoot.empty()) {
 		bool isContainer = Item::items[lootBlock.id].isContainer();
 		if (isContainer) {
@@ -83,16 +84,14 @@ bool Monsters::deserializeSpell(const std::shared_ptr<MonsterSpell> spell, spell
 	if (spell->length > 0) {
 		spell->spread = std::max<int32_t>(0, spell->spread);
 
-		auto area = std::make_unique<AreaCombat>();
-		area->setupArea(spell->length, spell->spread);
+		auto area = getLineArea(spell->length, spell->spread)->clone();
 		combatPtr->setArea(area);
 
 		spell->needDirection = true;
 	}
 
 	if (spell->radius > 0) {
-		auto area = std::make_unique<AreaCombat>();
-		area->setupArea(spell->radius);
+		auto area = getRadiusArea(spell->radius)->clone();
 		combatPtr->setArea(area);
 	}
 
@@ -309,6 +308,24 @@ bool MonsterType::loadCallback(LuaScriptInterface* scriptInterface) {
 	return true;
 }
 
+const std::shared_ptr<AreaCombat> &Monsters::getLineArea(int32_t length, int32_t spread) {
+	auto &area = lineAreas[{ length, spread }];
+	if (!area) {
+		area = std::make_shared<AreaCombat>();
+		area->setupArea(length, spread);
+	}
+	return area;
+}
+
+const std::shared_ptr<AreaCombat> &Monsters::getRadiusArea(int32_t radius) {
+	auto &area = radiusAreas[radius];
+	if (!area) {
+		area = std::make_shared<AreaCombat>();
+		area->setupArea(radius);
+	}
+	return area;
+}
+
 std::shared_ptr<MonsterType> Monsters::getMonsterType(const std::string &name, bool silent /* = false*/) const {
 	std::string lowerCaseName = asLowerCaseString(name);
 	if (auto it = monsters.find(lowerCaseName);
@@ -324,12 +341,13 @@ std::shared_ptr<MonsterType> Monsters::getMonsterType(const std::string &name, b
 }
 
 std::shared_ptr<MonsterType> Monsters::getMonsterTypeByRaceId(uint16_t raceId, bool isBoss /* = false*/) const {
-	auto bossType = g_ioBosstiary().getMonsterTypeByBossRaceId(raceId);
-	if (isBoss && bossType) {
-		return bossType;
+	if (isBoss) {
+		if (auto bossType = g_ioBosstiary().getMonsterTypeByBossRaceId(raceId)) {
+			return bossType;
+		}
 	}
 
-	auto monster_race_map = g_game().getBestiaryList();
+	const auto &monster_race_map = g_game().getBestiaryList();
 	auto it = monster_race_map.find(raceId);
 	if (it == monster_race_map.end()) {
 		return nullptr;
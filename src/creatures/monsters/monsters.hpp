@@ -25,6 +25,7 @@ public:
 };
 
 class BaseSpell;
+class AreaCombat;
 struct spellBlock_t {
 	constexpr spellBlock_t() = default;
 	~spellBlock_t() = default;
@@ -207,7 +208,19 @@ public:
 
 	void loadLoot(std::shared_ptr<MonsterType> monsterType, LootBlock lootblock);
 
+	/**
+	 * Changes with every loot added to any monster type, so it names this loot list until it changes.
+	 * The loot rolls keep what they compile from the list by it.
+	 */
+	uint32_t getLootRevision() const {
+		return lootRevision;
+	}
+
 	bool canSpawn(const Position &pos);
+
+private:
+	inline static uint32_t lastLootRevision = 0;
+	uint32_t lootRevision = 0;
 };
 
 class MonsterSpell {
@@ -283,6 +296,16 @@ public:
 
 private:
 	std::shared_ptr<ConditionDamage> getDamageCondition(ConditionType_t conditionType, int32_t maxDamage, int32_t minDamage, int32_t startDamage, uint32_t tickInterval);
+
+	/**
+	 * The areas of the spells defined by a length and spread or by a radius, each one is built once
+	 * and copied to the spells that use it instead of building it again for every monster.
+	 */
+	const std::shared_ptr<AreaCombat> &getLineArea(int32_t length, int32_t spread);
+	const std::shared_ptr<AreaCombat> &getRadiusArea(int32_t radius);
+
+	std::map<std::pair<int32_t, int32_t>, std::shared_ptr<AreaCombat>> lineAreas;
+	std::map<int32_t, std::shared_ptr<AreaCombat>> radiusAreas;
 };
 
 constexpr auto g_monsters = Monsters::getInstance;
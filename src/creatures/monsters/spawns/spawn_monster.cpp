@@ -19,6 +19,8 @@
 #include "lua/callbacks/events_callbacks.hpp"
 #include "utils/pugicast.hpp"
 #include "game/zones/zone.hpp"
+#include "lib/di/container.hpp"
+#include "lib/metrics/metrics.hpp"
 #include "map/spectators.hpp"
 
 static constexpr int32_t MONSTER_MINSPAWN_INTERVAL = 1000; // 1 second
@@ -117,6 +119,7 @@ void SpawnsMonster::startup() {
 		spawnMonster.startup();
 	}
 
+	g_spawnMonsterScheduler().startActivityReport();
 	started = true;
 }
 
@@ -139,11 +142,49 @@ bool SpawnsMonster::isInZone(const Position &centerPos, int32_t radius, const Po
 	return ((pos.getX() >= centerPos.getX() - radius) && (pos.getX() <= centerPos.getX() + radius) && (pos.getY() >= centerPos.getY() - radius) && (pos.getY() <= centerPos.getY() + radius));
 }
 
+SpawnMonster::SpawnMonster(Position initPos, int32_t initRadius) :
+	centerPos(initPos), radius(initRadius), schedulerId(g_spawnMonsterScheduler().registerSpawn(this)) { }
+
+SpawnMonster::SpawnMonster(SpawnMonster &&rhs) noexcept :
+	spawnedMonsterMap(std::move(rhs.spawnedMonsterMap)),
+	spawnMonsterMap(std::move(rhs.spawnMonsterMap)),
+	activity(std::move(rhs.activity)),
+	centerPos(rhs.centerPos), radius(rhs.radius), interval(rhs.interval), checkSpawnMonsterEvent(rhs.checkSpawnMonsterEvent), schedulerId(rhs.schedulerId) {
+	rhs.checkSpawnMonsterEvent = 0;
+	rhs.schedulerId = 0;
+	g_spawnMonsterScheduler().moveSpawn(schedulerId, this);
+	for (const auto &[_, monster] : spawnedMonsterMap) {
+		monster->setSpawnMonster(this);
+	}
+}
+
+SpawnMonster &SpawnMonster::operator=(SpawnMonster &&rhs) noexcept {
+	if (this != &rhs) {
+		g_spawnMonsterScheduler().unregisterSpawn(schedulerId);
+
+		spawnMonsterMap = std::move(rhs.spawnMonsterMap);
+		spawnedMonsterMap = std::move(rhs.spawnedMonsterMap);
+		activity = std::move(rhs.activity);
+
+		checkSpawnMonsterEvent = rhs.checkSpawnMonsterEvent;
+		centerPos = rhs.centerPos;
+		radius = rhs.radius;
+		interval = rhs.interval;
+		schedulerId = rhs.schedulerId;
+
+		rhs.checkSpawnMonsterEvent = 0;
+		rhs.schedulerId = 0;
+		g_spawnMonsterScheduler().moveSpawn(schedulerId, this);
+		for (const auto &[_, monster] : spawnedMonsterMap) {
+			monster->setSpawnMonster(this);
+		}
+	}
+	return *this;
+}
+
 void SpawnMonster::startSpawnMonsterCheck() {
 	if (checkSpawnMonsterEvent == 0) {
-		checkSpawnMonsterEvent = g_dispatcher().scheduleEvent(
-			getInterval(), [this] { checkSpawnMonster(); }, "SpawnMonster::checkSpawnMonster"
-		);
+		checkSpawnMonsterEvent = g_spawnMonsterScheduler().scheduleCheck(schedulerId, getInterval());
 	}
 }
 
@@ -153,6 +194,7 @@ SpawnMonster::~SpawnMonster() {
 	}
 	stopEvent();
 	spawnMonsterMap.clear();
+	g_spawnMonsterScheduler().unregisterSpawn(schedulerId);
 }
 
 bool SpawnMonster::findPlayer(const Position &pos) {
@@ -189,13 +231,16 @@ bool SpawnMonster::spawnMonster(uint32_t spawnMonsterId, spawnBlock_t &sb, const
 
 	spawnedMonsterMap[spawnMonsterId] = monster;
 	sb.lastSpawn = OTSYS_TIME();
+	if (isTrackingActivity()) {
+		activity->respawns.fetch_add(1, std::memory_order_relaxed);
+	}
 	g_events().eventMonsterOnSpawn(monster, sb.pos);
 	monster->onSpawn();
 	g_callbacks().executeCallback(EventCallback_t::monsterOnSpawn, &EventCallback::monsterOnSpawn, monster, sb.pos);
 	return true;
 }
 
-void SpawnMonster::startup(bool delayed) {
+void SpawnMonster::startup() {
 	if (g_configManager().getBoolean(RANDOM_MONSTER_SPAWN, __FUNCTION__)) {
 		for (auto it = spawnMonsterMap.begin(); it != spawnMonsterMap.end(); ++it) {
 			auto &[spawnMonsterId, sb] = *it;
@@ -225,11 +270,7 @@ void SpawnMonster::startup(bool delayed) {
 		if (!mType) {
 			continue;
 		}
-		if (delayed) {
-			g_dispatcher().addEvent([this, spawnMonsterId, &sb, mType] { scheduleSpawn(spawnMonsterId, sb, mType, 0, true); }, "SpawnMonster::startup");
-		} else {
-			scheduleSpawn(spawnMonsterId, sb, mType, 0, true);
-		}
+		g_spawnMonsterScheduler().scheduleSpawn(schedulerId, spawnMonsterId, mType, 0, 0, true);
 	}
 }
 
@@ -266,9 +307,7 @@ void SpawnMonster::checkSpawnMonster() {
 	}
 
 	if (spawnedMonsterMap.size() < spawnMonsterMap.size()) {
-		checkSpawnMonsterEvent = g_dispatcher().scheduleEvent(
-			getInterval(), [this] { checkSpawnMonster(); }, "SpawnMonster::checkSpawnMonster"
-		);
+		checkSpawnMonsterEvent = g_spawnMonsterScheduler().scheduleCheck(schedulerId, getInterval());
 	}
 }
 
@@ -277,9 +316,7 @@ void SpawnMonster::scheduleSpawn(uint32_t spawnMonsterId, spawnBlock_t &sb, cons
 		spawnMonster(spawnMonsterId, sb, mType, startup);
 	} else {
 		g_game().addMagicEffect(sb.pos, CONST_ME_TELEPORT);
-		g_dispatcher().scheduleEvent(
-			NONBLOCKABLE_SPAWN_MONSTER_INTERVAL, [=, this, &sb] { scheduleSpawn(spawnMonsterId, sb, mType, interval - NONBLOCKABLE_SPAWN_MONSTER_INTERVAL, startup); }, "SpawnMonster::scheduleSpawn"
-		);
+		g_spawnMonsterScheduler().scheduleSpawn(schedulerId, spawnMonsterId, mType, NONBLOCKABLE_SPAWN_MONSTER_INTERVAL, interval - NONBLOCKABLE_SPAWN_MONSTER_INTERVAL, startup);
 	}
 }
 
@@ -396,7 +433,7 @@ void SpawnMonster::setMonsterVariant(const std::string &variant) {
 
 void SpawnMonster::stopEvent() {
 	if (checkSpawnMonsterEvent != 0) {
-		g_dispatcher().stopEvent(checkSpawnMonsterEvent);
+		// The scheduled check skips the spawn once it no longer holds its ticket
 		checkSpawnMonsterEvent = 0;
 	}
 }
@@ -439,3 +476,175 @@ bool spawnBlock_t::hasBoss() const {
 		return monsterType->isBoss();
 	});
 }
+
+SpawnMonsterScheduler &SpawnMonsterScheduler::getInstance() {
+	return inject<SpawnMonsterScheduler>();
+}
+
+uint32_t SpawnMonsterScheduler::registerSpawn(SpawnMonster* spawn) {
+	const auto spawnId = ++lastSpawnId;
+	spawns[spawnId] = spawn;
+	return spawnId;
+}
+
+void SpawnMonsterScheduler::moveSpawn(uint32_t spawnId, SpawnMonster* spawn) {
+	if (auto it = spawns.find(spawnId); it != spawns.end()) {
+		it->second = spawn;
+	}
+}
+
+void SpawnMonsterScheduler::unregisterSpawn(uint32_t spawnId) {
+	spawns.erase(spawnId);
+}
+
+uint32_t SpawnMonsterScheduler::scheduleCheck(uint32_t spawnId, uint32_t delay) {
+	if (++lastTicket == 0) {
+		++lastTicket;
+	}
+
+	Entry entry;
+	entry.spawnId = spawnId;
+	entry.ticket = lastTicket;
+	add(std::move(entry), delay);
+	return lastTicket;
+}
+
+void SpawnMonsterScheduler::scheduleSpawn(uint32_t spawnId, uint32_t spawnMonsterId, const std::shared_ptr<MonsterType> &monsterType, uint32_t delay, uint16_t interval, bool startup) {
+	Entry entry;
+	entry.spawnId = spawnId;
+	entry.spawnMonsterId = spawnMonsterId;
+	entry.interval = interval;
+	entry.startup = startup;
+	entry.monsterType = monsterType;
+	add(std::move(entry), delay);
+}
+
+void SpawnMonsterScheduler::startActivityReport() {
+	const auto interval = g_configManager().getNumber(SPAWN_ACTIVITY_INTERVAL, __FUNCTION__);
+	if (interval <= 0 || reportEvent != 0) {
+		return;
+	}
+
+	SpawnMonster::trackActivity.store(true, std::memory_order_relaxed);
+	reportEvent = g_dispatcher().cycleEvent(
+		static_cast<uint32_t>(interval), [this] { reportActivity(); }, "SpawnMonsterScheduler::reportActivity"
+	);
+}
+
+void SpawnMonsterScheduler::add(Entry &&entry, uint32_t delay) {
+	const auto tick = (OTSYS_TIME() + delay + TICK_INTERVAL - 1) / TICK_INTERVAL;
+	if (processEvent == 0) {
+		currentTick = OTSYS_TIME() / TICK_INTERVAL;
+		processEvent = g_dispatcher().cycleEvent(
+			TICK_INTERVAL, [this] { process(); }, "SpawnMonsterScheduler::process"
+		);
+	}
+
+	entry.dueTick = tick;
+	if (tick <= currentTick) {
+		dueEntries.emplace_back(std::move(entry));
+	} else {
+		slots[tick % SLOT_COUNT].emplace_back(std::move(entry));
+	}
+}
+
+void SpawnMonsterScheduler::process() {
+	// Slots of the ticks that passed, an entry more than a turn of the wheel away stays in its slot
+	const auto nowTick = OTSYS_TIME() / TICK_INTERVAL;
+	while (currentTick < nowTick) {
+		auto &slot = slots[++currentTick % SLOT_COUNT];
+		std::erase_if(slot, [this](Entry &entry) {
+			if (entry.dueTick > currentTick) {
+				return false;
+			}
+			dueEntries.emplace_back(std::move(entry));
+			return true;
+		});
+	}
+
+	for (size_t i = 0; i < BATCH_SIZE && !dueEntries.empty(); ++i) {
+		const auto entry = std::move(dueEntries.front());
+		dueEntries.pop_front();
+		run(entry);
+	}
+}
+
+void SpawnMonsterScheduler::run(const Entry &entry) {
+	auto it = spawns.find(entry.spawnId);
+	if (it == spawns.end()) {
+		return;
+	}
+
+	SpawnMonster* spawn = it->second;
+	if (entry.spawnMonsterId == 0) {
+		if (spawn->checkSpawnMonsterEvent == entry.ticket) {
+			spawn->checkSpawnMonster();
+		}
+		return;
+	}
+
+	auto blockIt = spawn->spawnMonsterMap.find(entry.spawnMonsterId);
+	if (blockIt == spawn->spawnMonsterMap.end()) {
+		return;
+	}
+
+	// Spawns of the startup that are spread until after the server opened are announced to the players that see them
+	auto &sb = blockIt->second;
+	const bool startup = entry.startup && Spectators().find<Player>(sb.pos, true).empty();
+	spawn->scheduleSpawn(entry.spawnMonsterId, sb, entry.monsterType, entry.interval, startup);
+}
+
+void SpawnMonsterScheduler::reportActivity() const {
+	struct Sector {
+		uint32_t spawns = 0;
+		uint64_t respawns = 0;
+		uint64_t thinkTime = 0;
+		uint64_t pathSearches = 0;
+		uint64_t combats = 0;
+	};
+
+	const auto sectorSize = static_cast<uint16_t>(std::max<int32_t>(1, g_configManager().getNumber(SPAWN_ACTIVITY_SECTOR_SIZE, __FUNCTION__)));
+	std::map<Position, Sector> sectors;
+	for (const auto &[_, spawn] : spawns) {
+		const auto &pos = spawn->getCenterPos();
+		auto &sector = sectors[Position(static_cast<uint16_t>(pos.x / sectorSize * sectorSize), static_cast<uint16_t>(pos.y / sectorSize * sectorSize), pos.z)];
+		auto &activity = spawn->getActivity();
+		++sector.spawns;
+		sector.respawns += activity.respawns.exchange(0, std::memory_order_relaxed);
+		sector.thinkTime += activity.thinkTime.exchange(0, std::memory_order_relaxed);
+		sector.pathSearches += activity.pathSearches.exchange(0, std::memory_order_relaxed);
+		sector.combats += activity.combats.exchange(0, std::memory_order_relaxed);
+	}
+
+	std::string report = "x,y,z,spawns,respawns,think_us,path_searches,combats\n";
+	for (const auto &[pos, sector] : sectors) {
+		report += fmt::format("{},{},{},{},{},{},{},{}\n", pos.x, pos.y, pos.z, sector.spawns, sector.respawns, sector.thinkTime, sector.pathSearches, sector.combats);
+		if (sector.respawns == 0 && sector.thinkTime == 0 && sector.pathSearches == 0 && sector.combats == 0) {
+			continue;
+		}
+
+		const std::map<std::string, std::string> attrs = { { "sector", fmt::format("{}/{}/{}", pos.x, pos.y, pos.z) } };
+		g_metrics().addCounter("spawn_respawns", static_cast<double>(sector.respawns), attrs);
+		g_metrics().addCounter("spawn_think_time", static_cast<double>(sector.thinkTime), attrs);
+		g_metrics().addCounter("spawn_path_searches", static_cast<double>(sector.pathSearches), attrs);
+		g_metrics().addCounter("spawn_combats", static_cast<double>(sector.combats), attrs);
+	}
+
+	// Written aside and renamed, so what renders the heatmap never reads half a report
+	const std::filesystem::path path = g_configManager().getString(SPAWN_ACTIVITY_FILE, __FUNCTION__);
+	auto temporaryPath = path;
+	temporaryPath += ".tmp";
+	{
+		std::ofstream file(temporaryPath, std::ios::trunc);
+		if (!file || !file.write(report.data(), static_cast<std::streamsize>(report.size()))) {
+			g_logger().warn("[{}] - Could not write the spawn activity to {}", __FUNCTION__, temporaryPath.string());
+			return;
+		}
+	}
+
+	std::error_code error;
+	std::filesystem::rename(temporaryPath, path, error);
+	if (error) {
+		g_logger().warn("[{}] - Could not save the spawn activity to {}: {}", __FUNCTION__, path.string(), error.message());
+	}
+}
@@ -26,34 +26,29 @@ struct spawnBlock_t {
 	bool hasBoss() const;
 };
 
+/**
+ * What the monsters of a spawn cost since the last activity report, the path searches run on other threads.
+ */
+struct SpawnMonsterActivity {
+	std::atomic<uint64_t> respawns = 0;
+	// microseconds
+	std::atomic<uint64_t> thinkTime = 0;
+	std::atomic<uint64_t> pathSearches = 0;
+	std::atomic<uint64_t> combats = 0;
+};
+
 class SpawnMonster {
 public:
-	SpawnMonster(Position initPos, int32_t initRadius) :
-		centerPos(initPos), radius(initRadius) { }
+	SpawnMonster(Position initPos, int32_t initRadius);
 	~SpawnMonster();
 
 	// non-copyable
 	SpawnMonster(const SpawnMonster &) = delete;
 	SpawnMonster &operator=(const SpawnMonster &) = delete;
 
-	// moveable
-	SpawnMonster(SpawnMonster &&rhs) noexcept :
-		spawnMonsterMap(std::move(rhs.spawnMonsterMap)),
-		spawnedMonsterMap(std::move(rhs.spawnedMonsterMap)),
-		checkSpawnMonsterEvent(rhs.checkSpawnMonsterEvent), centerPos(rhs.centerPos), radius(rhs.radius), interval(rhs.interval) { }
-
-	SpawnMonster &operator=(SpawnMonster &&rhs) noexcept {
-		if (this != &rhs) {
-			spawnMonsterMap = std::move(rhs.spawnMonsterMap);
-			spawnedMonsterMap = std::move(rhs.spawnedMonsterMap);
-
-			checkSpawnMonsterEvent = rhs.checkSpawnMonsterEvent;
-			centerPos = rhs.centerPos;
-			radius = rhs.radius;
-			interval = rhs.interval;
-		}
-		return *this;
-	}
+	// moveable, the scheduler follows the spawn to its new address
+	SpawnMonster(SpawnMonster &&rhs) noexcept;
+	SpawnMonster &operator=(SpawnMonster &&rhs) noexcept;
 
 	bool addMonster(const std::string &name, const Position &pos, Direction dir, uint32_t interval, uint32_t weight = 1);
 	void removeMonster(std::shared_ptr<Monster> monster);
@@ -62,7 +57,7 @@ public:
 	uint32_t getInterval() const {
 		return interval;
 	}
-	void startup(bool delayed = false);
+	void startup();
 
 	void startSpawnMonsterCheck();
 	void stopEvent();
@@ -76,9 +71,22 @@ public:
 
 	void setMonsterVariant(const std::string &variant);
 
+	static bool isTrackingActivity() {
+		return trackActivity.load(std::memory_order_relaxed);
+	}
+	// Kept apart from the spawn, so it stays where it is when the spawn list grows
+	SpawnMonsterActivity &getActivity() const {
+		return *activity;
+	}
+
 private:
+	friend class SpawnMonsterScheduler;
+
+	inline static std::atomic_bool trackActivity = false;
+	std::unique_ptr<SpawnMonsterActivity> activity = std::make_unique<SpawnMonsterActivity>();
+
 	// map of the spawned creatures
-	std::map<uint32_t, std::shared_ptr<Monster>> spawnedMonsterMap;
+	phmap::flat_hash_map<uint32_t, std::shared_ptr<Monster>> spawnedMonsterMap;
 
 	// map of creatures in the spawn
 	std::map<uint32_t, spawnBlock_t> spawnMonsterMap;
@@ -87,7 +95,9 @@ private:
 	int32_t radius;
 
 	uint32_t interval = 30000;
+	// The ticket of the scheduled check, 0 if none
 	uint32_t checkSpawnMonsterEvent = 0;
+	uint32_t schedulerId = 0;
 
 	static bool findPlayer(const Position &pos);
 	bool spawnMonster(uint32_t spawnMonsterId, spawnBlock_t &sb, std::shared_ptr<MonsterType> monsterType, bool startup = false);
@@ -95,6 +105,81 @@ private:
 	void scheduleSpawn(uint32_t spawnMonsterId, spawnBlock_t &sb, std::shared_ptr<MonsterType> monsterType, uint16_t interval, bool startup = false);
 };
 
+/**
+ * Runs the checks and the delayed spawns of every monster spawn from a single dispatcher event,
+ * keeping them in a timing wheel of TICK_INTERVAL slots instead of scheduling a dispatcher event for each one.
+ * At most BATCH_SIZE of them run per tick and the rest wait for the next ticks,
+ * so the spawns of the startup are spread over several ticks instead of running at once.
+ * Spawns are referenced by id, the ones removed before their turn are skipped.
+ */
+class SpawnMonsterScheduler {
+public:
+	SpawnMonsterScheduler() = default;
+
+	// Ensures that we don't accidentally copy it
+	SpawnMonsterScheduler(const SpawnMonsterScheduler &) = delete;
+	SpawnMonsterScheduler &operator=(const SpawnMonsterScheduler &) = delete;
+
+	static SpawnMonsterScheduler &getInstance();
+
+	uint32_t registerSpawn(SpawnMonster* spawn);
+	void moveSpawn(uint32_t spawnId, SpawnMonster* spawn);
+	void unregisterSpawn(uint32_t spawnId);
+
+	/**
+	 * Checks the spawn after delay milliseconds.
+	 * @return the ticket of the check, the check is skipped if the spawn no longer holds it.
+	 */
+	uint32_t scheduleCheck(uint32_t spawnId, uint32_t delay);
+
+	/**
+	 * Spawns the block after delay milliseconds, with the teleport effects of the remaining interval.
+	 */
+	void scheduleSpawn(uint32_t spawnId, uint32_t spawnMonsterId, const std::shared_ptr<MonsterType> &monsterType, uint32_t delay, uint16_t interval, bool startup);
+
+	/**
+	 * Reports the activity of the spawns every spawnActivityInterval, does nothing if it is 0 or already reporting.
+	 */
+	void startActivityReport();
+
+private:
+	static constexpr uint32_t TICK_INTERVAL = 100;
+	static constexpr size_t SLOT_COUNT = 1024;
+	static constexpr size_t BATCH_SIZE = 256;
+
+	struct Entry {
+		int64_t dueTick = 0;
+		uint32_t spawnId = 0;
+		// The block to spawn, 0 for a check of the spawn
+		uint32_t spawnMonsterId = 0;
+		uint32_t ticket = 0;
+		uint16_t interval = 0;
+		bool startup = false;
+		std::shared_ptr<MonsterType> monsterType;
+	};
+
+	void add(Entry &&entry, uint32_t delay);
+	void process();
+	void run(const Entry &entry);
+	/**
+	 * Adds up and resets the activity of the spawns per sector and floor,
+	 * writes it to spawnActivityFile (one line per sector, for a heatmap) and to the metrics.
+	 */
+	void reportActivity() const;
+
+	std::array<std::vector<Entry>, SLOT_COUNT> slots;
+	// Entries that are due, in order, waiting for a tick with room for them
+	std::deque<Entry> dueEntries;
+	phmap::flat_hash_map<uint32_t, SpawnMonster*> spawns;
+	int64_t currentTick = 0;
+	uint32_t lastSpawnId = 0;
+	uint32_t lastTicket = 0;
+	uint64_t processEvent = 0;
+	uint64_t reportEvent = 0;
+};
+
+constexpr auto g_spawnMonsterScheduler = SpawnMonsterScheduler::getInstance;
+
 class SpawnsMonster {
 public:
 	static bool isInZone(const Position &centerPos, int32_t radius, const Position &pos);
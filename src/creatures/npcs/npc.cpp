@@ -21,7 +21,6 @@
 int32_t Npc::despawnRange;
 int32_t Npc::despawnRadius;
 
-uint32_t Npc::npcAutoID = 0x80000000;
 
 std::shared_ptr<Npc> Npc::createNpc(const std::string &name) {
 	const auto &npcType = g_npcs().getNpcType(name);
@@ -52,6 +51,10 @@ Npc::Npc(const std::shared_ptr<NpcType> &npcType) :
 	}
 }
 
+void Npc::setID() {
+	id = g_game().reserveNpcID(id);
+}
+
 void Npc::addList() {
 	g_game().addNpc(static_self_cast<Npc>());
 }
@@ -136,6 +139,10 @@ void Npc::onCreatureMove(const std::shared_ptr<Creature> &creature, const std::s
 	}
 }
 
+bool Npc::wantsCreatureMove(const std::shared_ptr<Creature> &creature) {
+	return Creature::wantsCreatureMove(creature) || creature->getPlayer() || npcType->info.creatureMoveEvent != -1;
+}
+
 void Npc::manageIdle() {
 	if (creatureCheck && playerSpectators.empty()) {
 		Game::removeCreatureCheck(static_self_cast<Npc>());
@@ -531,7 +538,12 @@ void Npc::onThinkWalk(uint32_t interval) {
 
 void Npc::onCreatureWalk() {
 	Creature::onCreatureWalk();
+	const auto spectators = playerSpectators.size();
 	phmap::erase_if(playerSpectators, [this](const auto &creature) { return !this->canSee(creature->getPosition()); });
+	// The npc walked away from the players, it sleeps if it walked away from all of them
+	if (playerSpectators.size() != spectators) {
+		manageIdle();
+	}
 }
 
 void Npc::onPlacedCreature() {
@@ -43,11 +43,7 @@ public:
 		return static_self_cast<Npc>();
 	}
 
-	void setID() override {
-		if (id == 0) {
-			id = npcAutoID++;
-		}
-	}
+	void setID() override;
 
 	void removeList() override;
 	void addList() override;
@@ -106,6 +102,20 @@ public:
 		return npcType->info.shopItemVector;
 	}
 
+	/**
+	 * @return the serialized shop of the npc type, nullptr when the player was given a shop list of its own.
+	 */
+	ShopCatalog* getShopCatalog(uint32_t playerGUID) const {
+		if (playerGUID != 0) {
+			auto it = shopPlayers.find(playerGUID);
+			if (it != shopPlayers.end() && !it->second.empty()) {
+				return nullptr;
+			}
+		}
+
+		return &npcType->info.shopCatalog;
+	}
+
 	bool isPushable() override {
 		return npcType->info.pushable;
 	}
@@ -147,7 +157,12 @@ public:
 	void onCreatureAppear(std::shared_ptr<Creature> creature, bool isLogin) override;
 	void onRemoveCreature(std::shared_ptr<Creature> creature, bool isLogout) override;
 	void onCreatureMove(const std::shared_ptr<Creature> &creature, const std::shared_ptr<Tile> &newTile, const Position &newPos, const std::shared_ptr<Tile> &oldTile, const Position &oldPos, bool teleport) override;
+	bool wantsCreatureMove(const std::shared_ptr<Creature> &creature) override;
 	void onCreatureSay(std::shared_ptr<Creature> creature, SpeakClasses type, const std::string &text) override;
+	// Only the players are heard
+	bool wantsCreatureSay(const std::shared_ptr<Creature> &creature) const override {
+		return creature->getPlayer() != nullptr;
+	}
 	void onThink(uint32_t interval) override;
 	void onPlayerBuyItem(std::shared_ptr<Player> player, uint16_t itemid, uint8_t count, uint16_t amount, bool ignore, bool inBackpacks);
 	void onPlayerSellAllLoot(uint32_t playerId, uint16_t itemid, bool ignore, uint64_t totalPrice);
@@ -171,7 +186,9 @@ public:
 	void removeShopPlayer(uint32_t playerGUID);
 	void closeAllShopWindows();
 
-	static uint32_t npcAutoID;
+	// The npc ids, they are the slots of the npcs in the game list (Game::reserveNpcID)
+	static constexpr uint32_t FIRST_ID = 0x80000000;
+	static constexpr uint32_t ID_COUNT = 0x7FF00000;
 
 	void onCreatureWalk() override;
 
@@ -99,6 +99,7 @@ void NpcType::loadShop(const std::shared_ptr<NpcType> &npcType, ShopBlock shopBl
 		}
 	}
 	npcType->info.shopItemVector.push_back(shopBlock);
+	npcType->info.shopCatalog = {};
 
 	info.speechBubble = SPEECHBUBBLE_TRADE;
 }
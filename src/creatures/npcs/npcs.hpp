@@ -23,6 +23,12 @@ public:
 	ShopBlock shopBlock;
 };
 
+// Each shop item from its offset to the next one
+struct ShopCatalog {
+	std::string bytes;
+	std::vector<uint32_t> offsets;
+};
+
 class NpcType : public SharedObject {
 	struct NpcInfo {
 		LuaScriptInterface* scriptInterface {};
@@ -69,6 +75,8 @@ class NpcType : public SharedObject {
 		// We need to keep the order of scripts, so we use a set isntead of an unordered_set
 		std::set<std::string> scripts;
 		std::vector<ShopBlock> shopItemVector;
+		// The shop items as the shop window sends them, built on the first window and reset with the shop
+		ShopCatalog shopCatalog;
 
 		NpcsEvent_t eventType = NPCS_EVENT_NONE;
 	};
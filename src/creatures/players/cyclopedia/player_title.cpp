@@ -11,6 +11,7 @@
 
 #include "player_title.hpp"
 
+#include "creatures/players/highscore_index.hpp"
 #include "creatures/players/player.hpp"
 #include "game/game.hpp"
 #include "kv/kv.hpp"
@@ -220,12 +221,8 @@ bool PlayerTitle::checkHighscore(uint8_t skill) {
 			// todo check if player is the most killer of Goshnar and his aspects.
 			return false;
 		default:
-			std::string skillName = g_game().getSkillNameById(skill);
-			query = fmt::format(
-				"SELECT * FROM `players` WHERE `group_id` < {} AND `{}` > 10 ORDER BY `{}` DESC LIMIT 1",
-				static_cast<int>(GROUP_TYPE_GAMEMASTER), skillName, skillName
-			);
-			break;
+			g_game().getSkillNameById(skill);
+			return g_highscoreIndex().getTopCharacter(skill, 10) == m_player.getGUID();
 	}
 
 	DBResult_ptr result = db.storeQuery(query);
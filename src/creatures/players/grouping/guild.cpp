@@ -14,14 +14,17 @@
 
 void Guild::addMember(const std::shared_ptr<Player> &player) {
 	membersOnline.push_back(player);
-	for (const auto &member : getMembersOnline()) {
+	for (const auto &member : membersOnline) {
 		g_game().updatePlayerHelpers(member);
 	}
 }
 
 void Guild::removeMember(const std::shared_ptr<Player> &player) {
 	// loop over to udpate all members and delete the player from the list
-	membersOnline.remove(player);
+	if (const auto it = std::ranges::find(membersOnline, player); it != membersOnline.end()) {
+		*it = std::move(membersOnline.back());
+		membersOnline.pop_back();
+	}
 	for (const auto &member : membersOnline) {
 		g_game().updatePlayerHelpers(member);
 	}
@@ -49,7 +49,7 @@ public:
 	const std::string &getName() const {
 		return name;
 	}
-	std::list<std::shared_ptr<Player>> getMembersOnline() const {
+	const std::vector<std::shared_ptr<Player>> &getMembersOnline() const {
 		return membersOnline;
 	}
 	uint32_t getMemberCountOnline() const {
@@ -67,6 +67,13 @@ public:
 	void setBankBalance(uint64_t balance) override {
 		bankBalance = balance;
 	}
+	// The balance in the database, IOGuild::saveGuild writes nothing while it matches
+	uint64_t getSavedBankBalance() const {
+		return savedBankBalance;
+	}
+	void setSavedBankBalance(uint64_t balance) {
+		savedBankBalance = balance;
+	}
 
 	const std::vector<GuildRank_ptr> &getRanks() const {
 		return ranks;
@@ -85,10 +92,11 @@ public:
 	}
 
 private:
-	std::list<std::shared_ptr<Player>> membersOnline;
+	std::vector<std::shared_ptr<Player>> membersOnline;
 	std::vector<GuildRank_ptr> ranks;
 	std::string name;
 	uint64_t bankBalance = 0;
+	std::atomic<uint64_t> savedBankBalance = 0;
 	std::string motd;
 	uint32_t id;
 	uint32_t memberCount = 0;
@@ -13,6 +13,7 @@
 
 #include "creatures/players/grouping/party.hpp"
 #include "game/game.hpp"
+#include "game/scheduling/dispatcher.hpp"
 #include "lua/creature/events.hpp"
 #include "lua/callbacks/event_callback.hpp"
 #include "lua/callbacks/events_callbacks.hpp"
@@ -21,6 +22,7 @@ std::shared_ptr<Party> Party::create(std::shared_ptr<Player> leader) {
 	auto party = std::make_shared<Party>();
 	party->m_leader = leader;
 	leader->setParty(party);
+	party->updateLevelRange();
 	if (g_configManager().getBoolean(PARTY_AUTO_SHARE_EXPERIENCE, __FUNCTION__)) {
 		party->setSharedExperience(leader, true);
 	}
@@ -143,7 +145,7 @@ bool Party::leaveParty(std::shared_ptr<Player> player) {
 
 	player->sendTextMessage(MESSAGE_PARTY_MANAGEMENT, "You have left the party.");
 
-	updateSharedExperience();
+	updateLevelRange();
 
 	clearPlayerPoints(player);
 
@@ -184,7 +186,7 @@ bool Party::passPartyLeadership(std::shared_ptr<Player> player) {
 
 	memberList.insert(memberList.begin(), oldLeader);
 
-	updateSharedExperience();
+	updateLevelRange();
 	updateTrackerAnalyzer();
 
 	for (const auto &member : getMembers()) {
@@ -251,7 +253,7 @@ bool Party::joinParty(const std::shared_ptr<Player> &player) {
 	updatePlayerStatus(player);
 
 	player->removePartyInvitation(getParty());
-	updateSharedExperience();
+	updateLevelRange();
 
 	const std::string &leaderName = leader->getName();
 	ss.str(std::string());
@@ -356,11 +358,25 @@ bool Party::isPlayerInvited(const std::shared_ptr<Player> &player) const {
 }
 
 void Party::updateAllPartyIcons() {
+	if (iconsUpdateScheduled) {
+		return;
+	}
+	iconsUpdateScheduled = true;
+	g_dispatcher().addEvent([weakParty = std::weak_ptr<Party>(getParty())] {
+		if (const auto party = weakParty.lock()) {
+			party->iconsUpdateScheduled = false;
+			party->sendAllPartyIcons();
+		}
+	},
+	                        "Party::updateAllPartyIcons");
+}
+
+void Party::sendAllPartyIcons() {
 	auto leader = getLeader();
 	if (!leader) {
 		return;
 	}
-	auto members = getMembers();
+	const auto &members = getMembers();
 	for (const auto &member : members) {
 		for (const auto &otherMember : members) {
 			member->sendPartyCreatureShield(otherMember);
@@ -391,6 +407,11 @@ void Party::broadcastPartyMessage(MessageClasses msgClass, const std::string &ms
 	}
 }
 
+void Party::updateLevelRange() {
+	minLevel = getMinLevel();
+	updateSharedExperience();
+}
+
 void Party::updateSharedExperience() {
 	if (sharedExpActive) {
 		bool result = getSharedExperienceStatus() == SHAREDEXP_OK;
@@ -475,7 +496,6 @@ SharedExpStatus_t Party::getMemberSharedExperienceStatus(std::shared_ptr<Player>
 		return SHAREDEXP_EMPTYPARTY;
 	}
 
-	uint32_t minLevel = getMinLevel();
 	if (player->getLevel() < minLevel) {
 		return SHAREDEXP_LEVELDIFFTOOLARGE;
 	}
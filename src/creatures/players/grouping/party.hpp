@@ -37,13 +37,15 @@ public:
 	}
 	std::vector<std::shared_ptr<Player>> getPlayers() const {
 		std::vector<std::shared_ptr<Player>> players;
+		players.reserve(memberList.size() + 1);
 		for (auto &member : memberList) {
 			players.push_back(member);
 		}
 		players.push_back(getLeader());
 		return players;
 	}
-	std::vector<std::shared_ptr<Player>> getMembers() {
+	// Copy it to join, leave or disband the party while walking it
+	const std::vector<std::shared_ptr<Player>> &getMembers() const {
 		return memberList;
 	}
 	std::vector<std::shared_ptr<Player>> getInvitees() {
@@ -66,6 +68,7 @@ public:
 	bool removeInvite(const std::shared_ptr<Player> &player, bool removeFromPlayer = true);
 
 	bool isPlayerInvited(const std::shared_ptr<Player> &player) const;
+	// Sends them once the current task ends, so the changes of a task send them once
 	void updateAllPartyIcons();
 	void broadcastPartyMessage(MessageClasses msgClass, const std::string &msg, bool sendToInvitations = false);
 	bool empty() const {
@@ -84,6 +87,8 @@ public:
 	bool canUseSharedExperience(std::shared_ptr<Player> player);
 	SharedExpStatus_t getMemberSharedExperienceStatus(std::shared_ptr<Player> player);
 	void updateSharedExperience();
+	// Recomputes the share range, on joins, leaves, leadership changes and level changes
+	void updateLevelRange();
 
 	void updatePlayerTicks(std::shared_ptr<Player> player, uint32_t points);
 	void clearPlayerPoints(std::shared_ptr<Player> player);
@@ -126,6 +131,7 @@ public:
 	std::vector<std::shared_ptr<PartyAnalyzer>> membersData;
 
 private:
+	void sendAllPartyIcons();
 	const char* getSharedExpReturnMessage(SharedExpStatus_t value);
 	bool isPlayerActive(std::shared_ptr<Player> player);
 	SharedExpStatus_t getSharedExperienceStatus();
@@ -142,6 +148,10 @@ private:
 
 	std::weak_ptr<Player> m_leader;
 
+	// The lowest level sharing experience, getMinLevel() as of the last updateLevelRange()
+	uint32_t minLevel = 0;
+
 	bool sharedExpActive = false;
 	bool sharedExpEnabled = false;
+	bool iconsUpdateScheduled = false;
 };
@@ -0,0 +1,209 @@
+/**
+ * Canary - A free and open-source MMORPG server emulator
+ * Copyright (©) 2019-2024 OpenTibiaBR <opentibiabr@outlook.com>
+ * Repository: https://github.com/opentibiabr/canary
+ * License: https://github.com/opentibiabr/canary/blob/main/LICENSE
+ * Contributors: https://github.com/opentibiabr/canary/graphs/contributors
+ * Website: https://docs.opentibiabr.com/
+ */
+
+#include "pch.hpp"
+
+#include "creatures/players/highscore_index.hpp"
+#include "creatures/players/grouping/groups.hpp"
+#include "creatures/players/player.hpp"
+#include "creatures/players/vocations/vocation.hpp"
+#include "database/database.hpp"
+#include "enums/account_group_type.hpp"
+#include "lib/di/container.hpp"
+
+namespace {
+	// The players columns of the ranked categories
+	constexpr std::array<std::pair<HighscoreCategories_t, std::string_view>, 10> categoryColumns = { {
+		{ HighscoreCategories_t::EXPERIENCE, "experience" },
+		{ HighscoreCategories_t::FIST_FIGHTING, "skill_fist" },
+		{ HighscoreCategories_t::CLUB_FIGHTING, "skill_club" },
+		{ HighscoreCategories_t::SWORD_FIGHTING, "skill_sword" },
+		{ HighscoreCategories_t::AXE_FIGHTING, "skill_axe" },
+		{ HighscoreCategories_t::DISTANCE_FIGHTING, "skill_dist" },
+		{ HighscoreCategories_t::SHIELDING, "skill_shielding" },
+		{ HighscoreCategories_t::FISHING, "skill_fishing" },
+		{ HighscoreCategories_t::MAGIC_LEVEL, "maglevel" },
+		{ HighscoreCategories_t::BOSS_POINTS, "boss_points" },
+	} };
+
+	uint16_t getBaseVocation(uint16_t vocationId) {
+		const auto &vocation = g_vocations().getVocation(vocationId);
+		return vocation ? static_cast<uint16_t>(vocation->getFromVocation()) : vocationId;
+	}
+}
+
+HighscoreIndex &HighscoreIndex::getInstance() {
+	return inject<HighscoreIndex>();
+}
+
+bool HighscoreIndex::isRanked(uint8_t category) {
+	return std::ranges::any_of(categoryColumns, [category](const auto &column) {
+		return static_cast<uint8_t>(column.first) == category;
+	});
+}
+
+void HighscoreIndex::load() {
+	std::string query = "SELECT `id`, `name`, `level`, `vocation`";
+	for (const auto &[category, column] : categoryColumns) {
+		query += fmt::format(", `{}`", column);
+	}
+	query += fmt::format(" FROM `players` WHERE `group_id` < {}", static_cast<int>(GROUP_TYPE_GAMEMASTER));
+
+	DBResult_ptr result;
+	{
+		// A ranking a few seconds old is fine, it is rebuilt from the saved rows anyway
+		DBReadOnly readOnly;
+		result = Database::getInstance().storeQuery(query);
+	}
+
+	std::scoped_lock lock(mutex);
+	characters.clear();
+	rankings = {};
+	if (!result) {
+		return;
+	}
+
+	do {
+		Character character;
+		character.name = result->getString("name");
+		character.level = result->getNumber<uint16_t>("level");
+		character.vocation = result->getNumber<uint16_t>("vocation");
+		character.baseVocation = getBaseVocation(character.vocation);
+		for (const auto &[category, column] : categoryColumns) {
+			character.points[static_cast<uint8_t>(category)] = result->getNumber<uint64_t>(std::string(column));
+		}
+		insert(result->getNumber<uint32_t>("id"), std::move(character));
+	} while (result->next());
+
+	g_logger().debug("[{}] - Ranked {} characters", __FUNCTION__, characters.size());
+}
+
+void HighscoreIndex::update(const Player &player) {
+	const auto guid = player.getGUID();
+	const auto &group = player.getGroup();
+	if (!group || group->id >= GROUP_TYPE_GAMEMASTER) {
+		remove(guid);
+		return;
+	}
+
+	Character character;
+	character.name = player.getName();
+	character.level = static_cast<uint16_t>(player.getLevel());
+	character.vocation = player.getVocationId();
+	character.baseVocation = getBaseVocation(character.vocation);
+	auto &points = character.points;
+	points[static_cast<uint8_t>(HighscoreCategories_t::EXPERIENCE)] = player.getExperience();
+	points[static_cast<uint8_t>(HighscoreCategories_t::FIST_FIGHTING)] = player.getBaseSkill(SKILL_FIST);
+	points[static_cast<uint8_t>(HighscoreCategories_t::CLUB_FIGHTING)] = player.getBaseSkill(SKILL_CLUB);
+	points[static_cast<uint8_t>(HighscoreCategories_t::SWORD_FIGHTING)] = player.getBaseSkill(SKILL_SWORD);
+	points[static_cast<uint8_t>(HighscoreCategories_t::AXE_FIGHTING)] = player.getBaseSkill(SKILL_AXE);
+	points[static_cast<uint8_t>(HighscoreCategories_t::DISTANCE_FIGHTING)] = player.getBaseSkill(SKILL_DISTANCE);
+	points[static_cast<uint8_t>(HighscoreCategories_t::SHIELDING)] = player.getBaseSkill(SKILL_SHIELD);
+	points[static_cast<uint8_t>(HighscoreCategories_t::FISHING)] = player.getBaseSkill(SKILL_FISHING);
+	points[static_cast<uint8_t>(HighscoreCategories_t::MAGIC_LEVEL)] = player.getBaseMagicLevel();
+	points[static_cast<uint8_t>(HighscoreCategories_t::BOSS_POINTS)] = player.getBossPoints();
+
+	std::scoped_lock lock(mutex);
+	erase(guid);
+	insert(guid, std::move(character));
+}
+
+void HighscoreIndex::remove(uint32_t guid) {
+	std::scoped_lock lock(mutex);
+	erase(guid);
+}
+
+void HighscoreIndex::insert(uint32_t guid, Character character) {
+	for (const auto &[category, column] : categoryColumns) {
+		const auto points = character.points[static_cast<uint8_t>(category)];
+		auto &ranking = rankings[static_cast<uint8_t>(category)];
+		ranking.all.insert({ points, guid });
+		ranking.byVocation[character.baseVocation].insert({ points, guid });
+		if (ranking.scoreCounts[points]++ == 0) {
+			ranking.scores.insert(points);
+		}
+	}
+	characters.insert_or_assign(guid, std::move(character));
+}
+
+void HighscoreIndex::erase(uint32_t guid) {
+	auto it = characters.find(guid);
+	if (it == characters.end()) {
+		return;
+	}
+
+	const auto &character = it->second;
+	for (const auto &[category, column] : categoryColumns) {
+		const auto points = character.points[static_cast<uint8_t>(category)];
+		auto &ranking = rankings[static_cast<uint8_t>(category)];
+		ranking.all.erase({ points, guid });
+		ranking.byVocation[character.baseVocation].erase({ points, guid });
+		if (auto countIt = ranking.scoreCounts.find(points); countIt != ranking.scoreCounts.end() && --countIt->second == 0) {
+			ranking.scoreCounts.erase(countIt);
+			ranking.scores.erase(points);
+		}
+	}
+	characters.erase(it);
+}
+
+bool HighscoreIndex::getPage(uint8_t category, uint32_t vocation, uint16_t &page, uint8_t entriesPerPage, uint32_t ourGuid, std::vector<HighscoreCharacter> &result, uint32_t &pages) const {
+	if (entriesPerPage == 0 || !isRanked(category)) {
+		return false;
+	}
+
+	std::scoped_lock lock(mutex);
+	const auto &ranking = rankings[category];
+	const EntryList* entries = &ranking.all;
+	if (vocation != ALL_VOCATIONS) {
+		auto it = ranking.byVocation.find(static_cast<uint16_t>(vocation));
+		if (it == ranking.byVocation.end()) {
+			return false;
+		}
+		entries = &it->second;
+	}
+
+	if (ourGuid != 0) {
+		page = 1;
+		if (auto it = characters.find(ourGuid); it != characters.end()) {
+			const Entry entry { it->second.points[category], ourGuid };
+			if (entries->contains(entry)) {
+				page = static_cast<uint16_t>(entries->rank(entry) / entriesPerPage + 1);
+			}
+		}
+	}
+
+	pages = static_cast<uint32_t>((entries->size() + entriesPerPage - 1) / entriesPerPage);
+
+	const size_t first = static_cast<size_t>(std::max<uint16_t>(page, 1) - 1) * entriesPerPage;
+	if (first >= entries->size()) {
+		return false;
+	}
+
+	result.reserve(entriesPerPage);
+	entries->forEach(first, entriesPerPage, [&](const Entry &entry) {
+		const auto &character = characters.at(entry.second);
+		const auto &voc = g_vocations().getVocation(character.vocation);
+		const auto rank = static_cast<uint32_t>(ranking.scores.rank(entry.first) + 1);
+		result.emplace_back(character.name, entry.first, entry.second, rank, character.level, voc ? voc->getClientId() : 0, "");
+	});
+	return true;
+}
+
+uint32_t HighscoreIndex::getTopCharacter(uint8_t category, uint64_t minPoints) const {
+	if (!isRanked(category)) {
+		return 0;
+	}
+
+	std::scoped_lock lock(mutex);
+	const auto &entries = rankings[category].all;
+	if (entries.empty() || entries.at(0).first <= minPoints) {
+		return 0;
+	}
+	return entries.at(0).second;
+}
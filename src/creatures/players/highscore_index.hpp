@@ -0,0 +1,92 @@
+/**
+ * Canary - A free and open-source MMORPG server emulator
+ * Copyright (©) 2019-2024 OpenTibiaBR <opentibiabr@outlook.com>
+ * Repository: https://github.com/opentibiabr/canary
+ * License: https://github.com/opentibiabr/canary/blob/main/LICENSE
+ * Contributors: https://github.com/opentibiabr/canary/graphs/contributors
+ * Website: https://docs.opentibiabr.com/
+ */
+
+#pragma once
+
+#include "game/game_definitions.hpp"
+#include "server/server_definitions.hpp"
+#include "utils/order_statistic_list.hpp"
+
+class Player;
+
+/**
+ * The rankings of the highscores window, kept in memory instead of being ranked by the database per request.
+ * They are read from the players table at startup and updated when a player levels, advances a skill or is saved,
+ * the players table stays the only thing that is persisted.
+ * It is updated from the save threads too, every access takes the lock.
+ */
+class HighscoreIndex {
+public:
+	HighscoreIndex() = default;
+
+	// Ensures that we don't accidentally copy it
+	HighscoreIndex(const HighscoreIndex &) = delete;
+	HighscoreIndex &operator=(const HighscoreIndex &) = delete;
+
+	static HighscoreIndex &getInstance();
+
+	void load();
+
+	void update(const Player &player);
+	void remove(uint32_t guid);
+
+	/**
+	 * Fills characters with a page of the category, ranked the way the highscores query ranked them:
+	 * the rank counts the distinct scores of every vocation, the pages only have the requested one.
+	 * @param vocation the base vocation, 0xFFFFFFFF for all of them
+	 * @param ourGuid when not 0, the page is the one of this player (the first one if it is not ranked)
+	 * @return false if the page has no entries.
+	 */
+	bool getPage(uint8_t category, uint32_t vocation, uint16_t &page, uint8_t entriesPerPage, uint32_t ourGuid, std::vector<HighscoreCharacter> &characters, uint32_t &pages) const;
+
+	/**
+	 * @return the guid of the best ranked player of the category with more than minPoints, 0 if none.
+	 */
+	uint32_t getTopCharacter(uint8_t category, uint64_t minPoints) const;
+
+private:
+	static constexpr uint8_t CATEGORY_COUNT = static_cast<uint8_t>(HighscoreCategories_t::BOSS_POINTS) + 1;
+	static constexpr uint32_t ALL_VOCATIONS = 0xFFFFFFFF;
+
+	struct Character {
+		std::string name;
+		uint16_t level = 0;
+		uint16_t vocation = 0;
+		uint16_t baseVocation = 0;
+		std::array<uint64_t, CATEGORY_COUNT> points {};
+	};
+
+	// Best scores first, ties by guid
+	using Entry = std::pair<uint64_t, uint32_t>;
+	struct EntryCompare {
+		bool operator()(const Entry &lhs, const Entry &rhs) const {
+			return lhs.first != rhs.first ? lhs.first > rhs.first : lhs.second < rhs.second;
+		}
+	};
+	using EntryList = stdext::order_statistic_list<Entry, EntryCompare>;
+
+	struct Ranking {
+		EntryList all;
+		phmap::flat_hash_map<uint16_t, EntryList> byVocation;
+		// The distinct scores, for the rank, with the number of players that have each one
+		stdext::order_statistic_list<uint64_t, std::greater<>> scores;
+		phmap::flat_hash_map<uint64_t, uint32_t> scoreCounts;
+	};
+
+	static bool isRanked(uint8_t category);
+
+	void insert(uint32_t guid, Character character);
+	void erase(uint32_t guid);
+
+	mutable std::mutex mutex;
+	phmap::flat_hash_map<uint32_t, Character> characters;
+	std::array<Ranking, CATEGORY_COUNT> rankings;
+};
+
+constexpr auto g_highscoreIndex = HighscoreIndex::getInstance;
@@ -0,0 +1,48 @@
+/**
+ * Canary - A free and open-source MMORPG server emulator
+ * Copyright (©) 2019-2024 OpenTibiaBR <opentibiabr@outlook.com>
+ * Repository: https://github.com/opentibiabr/canary
+ * License: https://github.com/opentibiabr/canary/blob/main/LICENSE
+ * Contributors: https://github.com/opentibiabr/canary/graphs/contributors
+ * Website: https://docs.opentibiabr.com/
+ */
+
+#include "pch.hpp"
+
+#include "creatures/players/management/login_queue.hpp"
+#include "config/configmanager.hpp"
+#include "game/scheduling/dispatcher.hpp"
+
+LoginQueue &LoginQueue::getInstance() {
+	return inject<LoginQueue>();
+}
+
+void LoginQueue::push(std::function<void(void)> enter) {
+	g_dispatcher().addEvent([this, enter = std::move(enter)]() mutable {
+		ready.emplace_back(std::move(enter));
+		if (!processing) {
+			processing = true;
+			processBatch();
+		}
+	},
+	                        "LoginQueue::push");
+}
+
+void LoginQueue::processBatch() {
+	const auto batchSize = static_cast<size_t>(std::max<int32_t>(g_configManager().getNumber(LOGIN_BATCH_SIZE, __FUNCTION__), 0));
+	for (size_t entered = 0; !ready.empty() && (batchSize == 0 || entered < batchSize); ++entered) {
+		auto enter = std::move(ready.front());
+		ready.pop_front();
+		--pending;
+		enter();
+	}
+
+	if (ready.empty()) {
+		processing = false;
+		return;
+	}
+
+	g_dispatcher().scheduleEvent(
+		SCHEDULER_MINTICKS, [this] { processBatch(); }, "LoginQueue::processBatch"
+	);
+}
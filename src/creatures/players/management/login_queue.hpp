@@ -0,0 +1,45 @@
+/**
+ * Canary - A free and open-source MMORPG server emulator
+ * Copyright (©) 2019-2024 OpenTibiaBR <opentibiabr@outlook.com>
+ * Repository: https://github.com/opentibiabr/canary
+ * License: https://github.com/opentibiabr/canary/blob/main/LICENSE
+ * Contributors: https://github.com/opentibiabr/canary/graphs/contributors
+ * Website: https://docs.opentibiabr.com/
+ */
+
+#pragma once
+
+/**
+ * Logins accepted by the WaitingList whose characters are loaded off the dispatcher.
+ * Once loaded they enter the world in batches of at most loginBatchSize per tick,
+ * so a reconnect storm is spread over several ticks instead of stalling one.
+ */
+class LoginQueue {
+public:
+	static LoginQueue &getInstance();
+
+	/**
+	 * Logins reserved and not in the world yet, the WaitingList counts them as online.
+	 */
+	size_t size() const {
+		return pending;
+	}
+
+	// Must be called from the dispatcher, before the character load starts
+	void reserve() {
+		++pending;
+	}
+
+	/**
+	 * Queues the entry of a reserved login, enter is called from the dispatcher within the next batches.
+	 * Can be called from any thread.
+	 */
+	void push(std::function<void(void)> enter);
+
+private:
+	void processBatch();
+
+	std::deque<std::function<void(void)>> ready;
+	size_t pending = 0;
+	bool processing = false;
+};
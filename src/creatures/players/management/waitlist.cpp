@@ -10,6 +10,7 @@
 #include "pch.hpp"
 
 #include "creatures/players/management/waitlist.hpp"
+#include "creatures/players/management/login_queue.hpp"
 #include "game/game.hpp"
 
 #include "enums/account_type.hpp"
@@ -20,27 +21,31 @@ constexpr std::size_t SLOT_LIMIT_THREE = 20;
 constexpr std::size_t SLOT_LIMIT_FOUR = 50;
 constexpr std::size_t TIMEOUT_EXTRA = 15;
 
-WaitingList::WaitingList() :
-	info(new WaitListInfo) { }
-
 WaitingList &WaitingList::getInstance() {
 	return inject<WaitingList>();
 }
 
-void WaitingList::cleanupList(WaitList &list) {
-	int64_t time = OTSYS_TIME();
-
-	auto it = list.begin();
-	while (it != list.end()) {
-		auto timeout = static_cast<int64_t>(it->timeout);
-		g_logger().warn("time: {}", timeout - time);
-		if ((timeout - time) <= 0) {
-			info->playerReferences.erase(it->playerGUID);
-			it = list.erase(it);
-		} else {
-			++it;
+void WaitingList::dropExpired(Queue &list, int64_t now) {
+	while (!list.guids.empty()) {
+		const auto it = entries.find(list.guids.front());
+		// The guid may have left this place and joined again later, with a newer ticket
+		const bool left = it == entries.end() || it->second.ticket != list.headTicket || &list != (it->second.priority ? &priorityQueue : &queue);
+		if (!left && it->second.expiresAt > now) {
+			break;
+		}
+		if (!left) {
+			entries.erase(it);
 		}
+		list.guids.pop_front();
+		++list.headTicket;
+	}
+}
+
+std::size_t WaitingList::getSlot(const Entry &entry) const {
+	if (entry.priority) {
+		return entry.ticket - priorityQueue.headTicket + 1;
 	}
+	return priorityQueue.guids.size() + entry.ticket - queue.headTicket + 1;
 }
 
 std::size_t WaitingList::getTimeout(std::size_t slot) {
@@ -67,63 +72,55 @@ bool WaitingList::clientLogin(std::shared_ptr<Player> player) {
 	}
 
 	auto maxPlayers = static_cast<uint32_t>(g_configManager().getNumber(MAX_PLAYERS, __FUNCTION__));
-	if (maxPlayers == 0 || (info->priorityWaitList.empty() && info->waitList.empty() && g_game().getPlayersOnline() < maxPlayers)) {
+	// The logins still being loaded already took their place
+	const auto playersOnline = g_game().getPlayersOnline() + LoginQueue::getInstance().size();
+	if (maxPlayers == 0 || (entries.empty() && playersOnline < maxPlayers)) {
 		return true;
 	}
 
-	cleanupList(info->priorityWaitList);
-	cleanupList(info->waitList);
+	const auto now = OTSYS_TIME();
+	dropExpired(priorityQueue, now);
+	dropExpired(queue, now);
 
-	addPlayerToList(player);
-
-	auto it = info->playerReferences.find(player->getGUID());
-	std::size_t slot = it->second.second;
-	if ((g_game().getPlayersOnline() + slot) <= maxPlayers) {
+	const auto slot = addPlayerToList(player);
+	if ((playersOnline + slot) <= maxPlayers) {
 		// should be able to login now
-		info->waitList.erase(it->second.first);
-		info->playerReferences.erase(it);
+		removePlayer(entries.find(player->getGUID()));
 		return true;
 	}
 	return false;
 }
 
-void WaitingList::addPlayerToList(std::shared_ptr<Player> player) {
-	auto it = info->playerReferences.find(player->getGUID());
-	if (it != info->playerReferences.end()) {
-		std::size_t slot;
-		if (player->isPremium()) {
-			slot = std::distance(info->priorityWaitList.begin(), it->second.first) + 1;
-		} else {
-			slot = info->priorityWaitList.size() + std::distance(info->waitList.begin(), it->second.first) + 1;
-		}
-		it->second.second = slot;
-		it->second.first->timeout = OTSYS_TIME() + (getTimeout(slot) * 1000);
-	} else {
-		std::size_t slot = info->priorityWaitList.size();
-		if (player->isPremium()) {
-			info->priorityWaitList.emplace_back(OTSYS_TIME() + (getTimeout(slot + 1) * 1000), player->getGUID());
-			auto insertedIt = std::prev(info->priorityWaitList.end());
-			info->playerReferences[player->getGUID()] = { insertedIt, slot + 1 };
-		} else {
-			slot += info->waitList.size();
-			info->waitList.emplace_back(OTSYS_TIME() + (getTimeout(slot + 1) * 1000), player->getGUID());
-			auto insertedIt = std::prev(info->waitList.end());
-			info->playerReferences[player->getGUID()] = { insertedIt, slot + 1 };
-		}
+std::size_t WaitingList::addPlayerToList(const std::shared_ptr<Player> &player) {
+	const auto now = OTSYS_TIME();
+	auto it = entries.find(player->getGUID());
+	if (it == entries.end()) {
+		auto &list = player->isPremium() ? priorityQueue : queue;
+		it = entries.try_emplace(player->getGUID(), Entry { &list == &priorityQueue, list.headTicket + list.guids.size(), 0 }).first;
+		list.guids.emplace_back(player->getGUID());
 	}
+
+	const auto slot = getSlot(it->second);
+	it->second.expiresAt = now + static_cast<int64_t>(getTimeout(slot) * 1000);
+	return slot;
 }
 
-std::size_t WaitingList::getClientSlot(std::shared_ptr<Player> player) {
-	auto it = info->playerReferences.find(player->getGUID());
-	if (it == info->playerReferences.end()) {
-		return 0;
+void WaitingList::removePlayer(phmap::flat_hash_map<uint32_t, Entry>::iterator it) {
+	auto &list = it->second.priority ? priorityQueue : queue;
+	const auto ticket = it->second.ticket;
+	entries.erase(it);
+	// The head leaves at once, a place further back is dropped once it reaches the head
+	if (ticket == list.headTicket) {
+		list.guids.pop_front();
+		++list.headTicket;
+		dropExpired(list, OTSYS_TIME());
 	}
+}
 
-	std::size_t slot;
-	if (player->isPremium()) {
-		slot = std::distance(info->priorityWaitList.begin(), it->second.first) + 1;
-	} else {
-		slot = info->priorityWaitList.size() + std::distance(info->waitList.begin(), it->second.first) + 1;
+std::size_t WaitingList::getClientSlot(std::shared_ptr<Player> player) {
+	auto it = entries.find(player->getGUID());
+	if (it == entries.end()) {
+		return 0;
 	}
-	return slot;
+	return getSlot(it->second);
 }
@@ -11,36 +11,43 @@
 
 class Player;
 
-struct WaitListInfo;
-
-struct Wait {
-	constexpr Wait(std::size_t initTimeout, uint32_t initPlayerGUID) :
-		timeout(initTimeout), playerGUID(initPlayerGUID) { }
-
-	std::size_t timeout;
-	uint32_t playerGUID;
-};
-
-using WaitList = std::list<Wait>;
-
-struct WaitListInfo {
-	WaitList priorityWaitList;
-	WaitList waitList;
-
-	phmap::flat_hash_map<uint32_t, std::pair<WaitList::iterator, std::size_t>> playerReferences;
-};
-
+/**
+ * The players waiting for a free place, the premium ones before the others.
+ * Each player holds a ticket in the order it joined, its place is the distance from the ticket at the head,
+ * so a retry finds it in O(1) whatever the length of the list.
+ * The players that left or stopped retrying keep their place until they reach the head, where they are dropped,
+ * so the places behind them can be a few too high meanwhile.
+ */
 class WaitingList {
 public:
-	WaitingList();
+	WaitingList() = default;
 	static WaitingList &getInstance();
 	bool clientLogin(std::shared_ptr<Player> player);
 	std::size_t getClientSlot(std::shared_ptr<Player> player);
 	static std::size_t getTime(std::size_t slot);
 
 private:
-	void cleanupList(WaitList &list);
+	struct Queue {
+		// The guids by ticket, from headTicket on
+		std::deque<uint32_t> guids;
+		uint64_t headTicket = 0;
+	};
+
+	struct Entry {
+		bool priority = false;
+		uint64_t ticket = 0;
+		int64_t expiresAt = 0;
+	};
+
+	// Drops the left and expired players from the head of the queue
+	void dropExpired(Queue &list, int64_t now);
+	std::size_t getSlot(const Entry &entry) const;
 	std::size_t getTimeout(std::size_t slot);
-	void addPlayerToList(std::shared_ptr<Player> player);
-	std::unique_ptr<WaitListInfo> info;
+	// The place of the player, added at the end if it is not waiting yet
+	std::size_t addPlayerToList(const std::shared_ptr<Player> &player);
+	void removePlayer(phmap::flat_hash_map<uint32_t, Entry>::iterator it);
+
+	Queue priorityQueue;
+	Queue queue;
+	phmap::flat_hash_map<uint32_t, Entry> entries;
 };
@@ -14,6 +14,7 @@
 #include "creatures/monsters/monster.hpp"
 #include "creatures/monsters/monsters.hpp"
 #include "creatures/players/player.hpp"
+#include "creatures/players/highscore_index.hpp"
 #include "creatures/players/wheel/player_wheel.hpp"
 #include "creatures/players/achievement/player_achievement.hpp"
 #include "creatures/players/cyclopedia/player_badge.hpp"
@@ -32,6 +33,9 @@
 #include "lua/callbacks/events_callbacks.hpp"
 #include "lua/creature/movement.hpp"
 #include "io/iologindata.hpp"
+#include "io/functions/iologindata_load_player.hpp"
+#include "io/functions/iologindata_save_player.hpp"
+#include "io/persistence_journal.hpp"
 #include "items/bed.hpp"
 #include "items/weapons/weapons.hpp"
 #include "core.hpp"
@@ -49,7 +53,7 @@ Player::Player(ProtocolGame_ptr p) :
 	Creature(),
 	lastPing(OTSYS_TIME()),
 	lastPong(lastPing),
-	inbox(std::make_shared<Inbox>(ITEM_INBOX)),
+	inbox(makeItemShared<Inbox>(ITEM_INBOX)),
 	client(std::move(p)) {
 	m_playerVIP = std::make_unique<PlayerVIP>(*this);
 	m_wheelPlayer = std::make_unique<PlayerWheel>(*this);
@@ -77,6 +81,10 @@ Player::~Player() {
 	setWriteItem(nullptr);
 	setEditHouse(nullptr);
 	logged = false;
+
+	if (kvScope) {
+		g_kv().forgetPrefetch(fmt::format("player.{}", guid));
+	}
 }
 
 bool Player::setVocation(uint16_t vocId) {
@@ -98,8 +106,8 @@ bool Player::isPushable() {
 	return Creature::isPushable();
 }
 
-std::shared_ptr<Task> Player::createPlayerTask(uint32_t delay, std::function<void(void)> f, std::string context) {
-	return std::make_shared<Task>(std::move(f), std::move(context), delay);
+std::shared_ptr<Task> Player::createPlayerTask(uint32_t delay, std::function<void(void)> f, std::string_view context) {
+	return Task::create(std::move(f), context, delay);
 }
 
 uint32_t Player::playerFirstID = 0x10000000;
@@ -422,7 +430,7 @@ int32_t Player::getDefense() const {
 		defenseValue = weapon != nullptr ? shield->getDefense() + weapon->getExtraDefense() : shield->getDefense();
 		// Wheel of destiny - Combat Mastery
 		if (shield->getDefense() > 0) {
-			defenseValue += wheel()->getMajorStatConditional("Combat Mastery", WheelMajor_t::DEFENSE);
+			defenseValue += wheel()->getMajorStatConditional(WheelStage_t::COMBAT_MASTERY, WheelMajor_t::DEFENSE);
 		}
 		defenseSkill = getSkillLevel(SKILL_SHIELD);
 	}
@@ -559,6 +567,17 @@ void Player::updateInventoryWeight() {
 }
 
 void Player::updateInventoryImbuement() {
+	// The whole seconds since the last decay, from the timestamps so a late check does not lose time
+	const int64_t now = OTSYS_TIME();
+	if (lastImbuementDecay == 0) {
+		lastImbuementDecay = now - EVENT_IMBUEMENT_INTERVAL;
+	}
+	const auto elapsed = static_cast<uint32_t>((now - lastImbuementDecay) / 1000);
+	if (elapsed == 0) {
+		return;
+	}
+	lastImbuementDecay += static_cast<int64_t>(elapsed) * 1000;
+
 	// Get the tile the player is currently on
 	std::shared_ptr<Tile> playerTile = getTile();
 	// Check if the player is in a protection zone
@@ -566,12 +585,26 @@ void Player::updateInventoryImbuement() {
 	// Check if the player is in fight mode
 	bool isInFightMode = hasCondition(CONDITION_INFIGHT);
 	bool nonAggressiveFightOnly = g_configManager().getBoolean(TOGGLE_IMBUEMENT_NON_AGGRESSIVE_FIGHT_ONLY, __FUNCTION__);
+	const auto &self = getPlayer();
 
 	// Iterate through all items in the player's inventory
-	for (auto [key, item] : getAllSlotItems()) {
-		// Iterate through all imbuement slots on the item
+	for (int32_t i = CONST_SLOT_FIRST; i <= CONST_SLOT_LAST; ++i) {
+		const auto &item = inventory[i];
+		if (!item) {
+			continue;
+		}
+
+		const uint8_t imbuementSlots = item->getImbuementSlot();
+		if (imbuementSlots == 0) {
+			continue;
+		}
+
+		// Parent of the imbued item
+		auto parent = item->getParent();
+		bool isInBackpack = parent && parent->getContainer();
 
-		for (uint8_t slotid = 0; slotid < item->getImbuementSlot(); slotid++) {
+		// Iterate through all imbuement slots on the item
+		for (uint8_t slotid = 0; slotid < imbuementSlots; slotid++) {
 			ImbuementInfo imbuementInfo;
 			// Get the imbuement information for the current slot
 			if (!item->getImbuementInfo(slotid, &imbuementInfo)) {
@@ -583,35 +616,24 @@ void Player::updateInventoryImbuement() {
 			auto imbuement = imbuementInfo.imbuement;
 			// Get the category of the imbuement
 			const CategoryImbuement* categoryImbuement = g_imbuements().getCategoryByID(imbuement->getCategory());
-			// Parent of the imbued item
-			auto parent = item->getParent();
-			bool isInBackpack = parent && parent->getContainer();
 			// If the imbuement is aggressive and the player is not in fight mode or is in a protection zone, or the item is in a container, ignore it.
 			if (categoryImbuement && (categoryImbuement->agressive || nonAggressiveFightOnly) && (isInProtectionZone || !isInFightMode || isInBackpack)) {
 				continue;
 			}
 			// If the item is not in the backpack slot and it's not a agressive imbuement, ignore it.
-			if (categoryImbuement && !categoryImbuement->agressive && parent && parent != getPlayer()) {
-				continue;
-			}
-
-			// If the imbuement's duration is 0, remove its stats and continue to the next slot
-			if (imbuementInfo.duration == 0) {
-				removeItemImbuementStats(imbuement);
-				updateImbuementTrackerStats();
+			if (categoryImbuement && !categoryImbuement->agressive && parent && parent != self) {
 				continue;
 			}
 
 			g_logger().trace("Decaying imbuement {} from item {} of player {}", imbuement->getName(), item->getName(), getName());
 			// Calculate the new duration of the imbuement, making sure it doesn't go below 0
-			uint32_t duration = std::max<uint32_t>(0, imbuementInfo.duration - EVENT_IMBUEMENT_INTERVAL / 1000);
+			uint32_t duration = imbuementInfo.duration > elapsed ? imbuementInfo.duration - elapsed : 0;
 			// Update the imbuement's duration in the item
 			item->decayImbuementTime(slotid, imbuement->getID(), duration);
 
 			if (duration == 0) {
 				removeItemImbuementStats(imbuement);
 				updateImbuementTrackerStats();
-				continue;
 			}
 		}
 	}
@@ -632,7 +654,7 @@ phmap::flat_hash_map<uint8_t, std::shared_ptr<Item>> Player::getAllSlotItems() c
 }
 
 void Player::setTraining(bool value) {
-	for (const auto &[key, player] : g_game().getPlayers()) {
+	for (const auto &player : g_game().getVipWatchers(getGUID())) {
 		if (!this->isInGhostMode() || player->isAccessPlayer()) {
 			player->vip()->notifyStatusChange(static_self_cast<Player>(), value ? VipStatus_t::Training : VipStatus_t::Online, false);
 		}
@@ -642,6 +664,18 @@ void Player::setTraining(bool value) {
 }
 
 uint16_t Player::getLoyaltySkill(skills_t skill) const {
+	if (skill < SKILL_FIRST || skill > SKILL_LAST) {
+		return calculateLoyaltySkill(skill);
+	}
+
+	auto &cached = loyaltyLevels[skill];
+	if (cached.vocation != vocation.get() || cached.level != skills[skill].level || cached.progress != skills[skill].tries || cached.bonus != getLoyaltyBonus()) {
+		cached = { vocation.get(), skills[skill].tries, skills[skill].level, getLoyaltyBonus(), calculateLoyaltySkill(skill) };
+	}
+	return static_cast<uint16_t>(cached.loyaltyLevel);
+}
+
+uint16_t Player::calculateLoyaltySkill(skills_t skill) const {
 	uint16_t level = getBaseSkill(skill);
 	absl::uint128 currReqTries = vocation->getReqSkillTries(skill, level);
 	absl::uint128 nextReqTries = vocation->getReqSkillTries(skill, level + 1);
@@ -699,6 +733,7 @@ void Player::addSkillAdvance(skills_t skill, uint64_t count) {
 		}
 
 		g_creatureEvents().playerAdvance(static_self_cast<Player>(), skill, (skills[skill].level - 1), skills[skill].level);
+		g_highscoreIndex().update(*this);
 
 		sendUpdateSkills = true;
 		currReqTries = nextReqTries;
@@ -878,10 +913,7 @@ uint16_t Player::getLookCorpse() const {
 void Player::addStorageValue(const uint32_t key, const int32_t value, const bool isLogin /* = false*/) {
 	if (IS_IN_KEYRANGE(key, RESERVED_RANGE)) {
 		if (IS_IN_KEYRANGE(key, OUTFITS_RANGE)) {
-			outfits.emplace_back(
-				value >> 16,
-				value & 0xFF
-			);
+			outfits.try_emplace(value >> 16, value & 0xFF);
 			return;
 		} else if (IS_IN_KEYRANGE(key, MOUNTS_RANGE)) {
 			// do nothing
@@ -948,7 +980,7 @@ bool Player::canSee(const Position &pos) {
 	return client->canSee(pos);
 }
 
-bool Player::canSeeCreature(std::shared_ptr<Creature> creature) const {
+bool Player::canSeeCreature(const std::shared_ptr<Creature> &creature) const {
 	if (creature.get() == this) {
 		return true;
 	}
@@ -1228,6 +1260,10 @@ bool Player::isNearDepotBox() {
 }
 
 std::shared_ptr<DepotChest> Player::getDepotChest(uint32_t depotId, bool autoCreate) {
+	if (hasPendingDepotItems()) {
+		IOLoginDataLoad::loadPendingDepotItems(getPlayer());
+	}
+
 	auto it = depotChests.find(depotId);
 	if (it != depotChests.end()) {
 		return it->second;
@@ -1239,13 +1275,13 @@ std::shared_ptr<DepotChest> Player::getDepotChest(uint32_t depotId, bool autoCre
 
 	std::shared_ptr<DepotChest> depotChest;
 	if (depotId > 0 && depotId < 18) {
-		depotChest = std::make_shared<DepotChest>(ITEM_DEPOT_NULL + depotId);
+		depotChest = makeItemShared<DepotChest>(ITEM_DEPOT_NULL + depotId);
 	} else if (depotId == 18) {
-		depotChest = std::make_shared<DepotChest>(ITEM_DEPOT_XVIII);
+		depotChest = makeItemShared<DepotChest>(ITEM_DEPOT_XVIII);
 	} else if (depotId == 19) {
-		depotChest = std::make_shared<DepotChest>(ITEM_DEPOT_XIX);
+		depotChest = makeItemShared<DepotChest>(ITEM_DEPOT_XIX);
 	} else {
-		depotChest = std::make_shared<DepotChest>(ITEM_DEPOT_XX);
+		depotChest = makeItemShared<DepotChest>(ITEM_DEPOT_XX);
 	}
 
 	depotChests[depotId] = depotChest;
@@ -1267,7 +1303,7 @@ std::shared_ptr<DepotLocker> Player::getDepotLocker(uint32_t depotId) {
 	// We need to make room for supply stash on 12+ protocol versions and remove it for 10x.
 	bool createSupplyStash = !client->oldProtocol;
 
-	std::shared_ptr<DepotLocker> depotLocker = std::make_shared<DepotLocker>(ITEM_LOCKER, createSupplyStash ? 4 : 3);
+	std::shared_ptr<DepotLocker> depotLocker = makeItemShared<DepotLocker>(ITEM_LOCKER, createSupplyStash ? 4 : 3);
 	depotLocker->setDepotId(depotId);
 	depotLocker->internalAddThing(Item::CreateItem(ITEM_MARKET));
 	depotLocker->internalAddThing(inbox);
@@ -1290,7 +1326,7 @@ std::shared_ptr<RewardChest> Player::getRewardChest() {
 		return rewardChest;
 	}
 
-	rewardChest = std::make_shared<RewardChest>(ITEM_REWARD_CHEST);
+	rewardChest = makeItemShared<RewardChest>(ITEM_REWARD_CHEST);
 	return rewardChest;
 }
 
@@ -1303,7 +1339,7 @@ std::shared_ptr<Reward> Player::getReward(const uint64_t rewardId, const bool au
 		return nullptr;
 	}
 
-	auto reward = std::make_shared<Reward>();
+	auto reward = makeItemShared<Reward>();
 	reward->setAttribute(ItemAttribute_t::DATE, rewardId);
 	rewardMap[rewardId] = reward;
 	g_game().internalAddItem(getRewardChest(), reward, INDEX_WHEREEVER, FLAG_NOLIMIT);
@@ -2332,6 +2368,7 @@ void Player::addManaSpent(uint64_t amount) {
 
 		g_creatureEvents().playerAdvance(static_self_cast<Player>(), SKILL_MAGLEVEL, magLevel - 1, magLevel);
 		sendTakeScreenshot(SCREENSHOT_TYPE_SKILLUP);
+		g_highscoreIndex().update(*this);
 
 		sendUpdateStats = true;
 		currReqMana = nextReqMana;
@@ -2453,6 +2490,7 @@ void Player::addExperience(std::shared_ptr<Creature> target, uint64_t exp, bool
 	if (prevLevel != level) {
 		health = healthMax;
 		mana = manaMax;
+		g_highscoreIndex().update(*this);
 
 		updateBaseSpeed();
 		setBaseSpeed(getBaseSpeed());
@@ -2461,9 +2499,10 @@ void Player::addExperience(std::shared_ptr<Creature> target, uint64_t exp, bool
 		g_game().addPlayerMana(static_self_cast<Player>());
 
 		if (m_party) {
-			m_party->updateSharedExperience();
+			m_party->updateLevelRange();
 		}
 
+		g_saveManager().setSavePriority(static_self_cast<Player>());
 		g_creatureEvents().playerAdvance(static_self_cast<Player>(), SKILL_LEVEL, prevLevel, level);
 
 		std::ostringstream ss;
@@ -2539,6 +2578,7 @@ void Player::removeExperience(uint64_t exp, bool sendText /* = false*/) {
 	if (oldLevel != level) {
 		health = healthMax;
 		mana = manaMax;
+		g_highscoreIndex().update(*this);
 
 		updateBaseSpeed();
 		setBaseSpeed(getBaseSpeed());
@@ -2548,7 +2588,7 @@ void Player::removeExperience(uint64_t exp, bool sendText /* = false*/) {
 		g_game().addPlayerMana(static_self_cast<Player>());
 
 		if (m_party) {
-			m_party->updateSharedExperience();
+			m_party->updateLevelRange();
 		}
 
 		std::ostringstream ss;
@@ -3001,7 +3041,7 @@ void Player::despawn() {
 	g_game().removePlayer(static_self_cast<Player>());
 
 	// show player as pending
-	for (const auto &[key, player] : g_game().getPlayers()) {
+	for (const auto &player : g_game().getVipWatchers(getGUID())) {
 		player->vip()->notifyStatusChange(static_self_cast<Player>(), VipStatus_t::Pending, false);
 	}
 
@@ -3055,13 +3095,13 @@ void Player::addInFightTicks(bool pzlock /*= false*/) {
 void Player::removeList() {
 	g_game().removePlayer(static_self_cast<Player>());
 
-	for (const auto &[key, player] : g_game().getPlayers()) {
+	for (const auto &player : g_game().getVipWatchers(getGUID())) {
 		player->vip()->notifyStatusChange(static_self_cast<Player>(), VipStatus_t::Offline);
 	}
 }
 
 void Player::addList() {
-	for (const auto &[key, player] : g_game().getPlayers()) {
+	for (const auto &player : g_game().getVipWatchers(getGUID())) {
 		player->vip()->notifyStatusChange(static_self_cast<Player>(), vip()->getStatus());
 	}
 
@@ -3594,6 +3634,7 @@ void Player::updateThing(std::shared_ptr<Thing> thing, uint16_t itemId, uint32_t
 
 	item->setID(itemId);
 	item->setSubType(count);
+	invalidateCyclopediaPayload(CYCLOPEDIA_CHARACTERINFO_ITEMSUMMARY);
 
 	// send to client
 	sendInventoryItem(static_cast<Slots_t>(index), item);
@@ -3616,6 +3657,7 @@ void Player::replaceThing(uint32_t index, std::shared_ptr<Thing> thing) {
 	if (!item) {
 		return /*RETURNVALUE_NOTPOSSIBLE*/;
 	}
+	invalidateCyclopediaPayload(CYCLOPEDIA_CHARACTERINFO_ITEMSUMMARY);
 
 	// send to client
 	sendInventoryItem(static_cast<Slots_t>(index), item);
@@ -3701,6 +3743,11 @@ uint32_t Player::getItemTypeCount(uint16_t itemId, int32_t subType /*= -1*/) con
 		}
 
 		if (std::shared_ptr<Container> container = item->getContainer()) {
+			if (subType == -1) {
+				count += container->getContentItemCount(itemId);
+				continue;
+			}
+
 			for (ContainerIterator it = container->iterator(); it.hasNext(); it.advance()) {
 				if ((*it)->getID() == itemId) {
 					count += Item::countByType(*it, subType);
@@ -4003,6 +4050,9 @@ ItemsTierCountList Player::getStoreInboxItemsId() const {
 
 ItemsTierCountList Player::getDepotChestItemsId() const {
 	ItemsTierCountList itemMap;
+	if (hasPendingDepotItems()) {
+		IOLoginDataLoad::loadPendingDepotItems(std::const_pointer_cast<Player>(getPlayer()));
+	}
 
 	for (const auto &[index, depot] : depotChests) {
 		const std::shared_ptr<Container> &container = depot->getContainer();
@@ -4112,28 +4162,98 @@ std::vector<std::shared_ptr<Item>> Player::getEquippedItems() const {
 }
 
 std::map<uint32_t, uint32_t> &Player::getAllItemTypeCount(std::map<uint32_t, uint32_t> &countMap) const {
-	for (const auto &item : getAllInventoryItems()) {
+	for (int32_t i = CONST_SLOT_FIRST; i <= CONST_SLOT_LAST; ++i) {
+		const auto &item = inventory[i];
+		if (!item) {
+			continue;
+		}
+
 		countMap[static_cast<uint32_t>(item->getID())] += Item::countByType(item, -1);
+		if (const auto &container = item->getContainer()) {
+			container->forEachContentItemCount([&countMap](uint16_t itemId, uint32_t amount) {
+				countMap[static_cast<uint32_t>(itemId)] += amount;
+			});
+		}
 	}
 	return countMap;
 }
 
 std::map<uint16_t, uint16_t> &Player::getAllSaleItemIdAndCount(std::map<uint16_t, uint16_t> &countMap) const {
-	for (const auto &item : getAllInventoryItems(false, true)) {
-		countMap[item->getID()] += item->getItemCount();
+	for (int32_t i = CONST_SLOT_FIRST; i <= CONST_SLOT_LAST; ++i) {
+		const auto &item = inventory[i];
+		if (!item) {
+			continue;
+		}
+
+		const auto &container = item->getContainer();
+		if (!container) {
+			continue;
+		}
+
+		// Only the items that can be forged have a tier, the counts of the others are kept by the container
+		bool hasClassified = false;
+		container->forEachContentItemCount([&countMap, &hasClassified](uint16_t itemId, uint32_t amount) {
+			if (Item::items[itemId].upgradeClassification > 0) {
+				hasClassified = true;
+				return;
+			}
+			countMap[itemId] += static_cast<uint16_t>(amount);
+		});
+		if (!hasClassified) {
+			continue;
+		}
+
+		for (ContainerIterator it = container->iterator(); it.hasNext(); it.advance()) {
+			const auto &content = *it;
+			if (Item::items[content->getID()].upgradeClassification > 0 && content->getTier() == 0) {
+				countMap[content->getID()] += content->getItemCount();
+			}
+		}
 	}
 
 	return countMap;
 }
 
 void Player::getAllItemTypeCountAndSubtype(std::map<uint32_t, uint32_t> &countMap) const {
-	for (const auto &item : getAllInventoryItems()) {
+	const auto addItem = [&countMap](const std::shared_ptr<Item> &item) {
 		uint16_t itemId = item->getID();
 		if (Item::items[itemId].isFluidContainer()) {
 			countMap[static_cast<uint32_t>(itemId) | (item->getAttribute<uint32_t>(ItemAttribute_t::FLUIDTYPE)) << 16] += item->getItemCount();
 		} else {
 			countMap[static_cast<uint32_t>(itemId)] += item->getItemCount();
 		}
+	};
+
+	for (int32_t i = CONST_SLOT_FIRST; i <= CONST_SLOT_LAST; ++i) {
+		const auto &item = inventory[i];
+		if (!item) {
+			continue;
+		}
+
+		addItem(item);
+		const auto &container = item->getContainer();
+		if (!container) {
+			continue;
+		}
+
+		// Only the fluid containers are counted by subtype, the counts of the others are kept by the container
+		bool hasFluids = false;
+		container->forEachContentItemCount([&countMap, &hasFluids](uint16_t itemId, uint32_t amount) {
+			if (Item::items[itemId].isFluidContainer()) {
+				hasFluids = true;
+				return;
+			}
+			countMap[static_cast<uint32_t>(itemId)] += amount;
+		});
+		if (!hasFluids) {
+			continue;
+		}
+
+		for (ContainerIterator it = container->iterator(); it.hasNext(); it.advance()) {
+			if (Item::items[(*it)->getID()].isFluidContainer()) {
+				addItem(*it);
+			}
+		}
 	}
 }
 
@@ -4159,6 +4279,7 @@ std::shared_ptr<Thing> Player::getThing(size_t index) const {
 }
 
 void Player::postAddNotification(std::shared_ptr<Thing> thing, std::shared_ptr<Cylinder> oldParent, int32_t index, CylinderLink_t link /*= LINK_OWNER*/) {
+	invalidateCyclopediaPayload(CYCLOPEDIA_CHARACTERINFO_ITEMSUMMARY);
 	if (link == LINK_OWNER) {
 		// calling movement scripts
 		g_moveEvents().onPlayerEquip(getPlayer(), thing->getItem(), static_cast<Slots_t>(index), false);
@@ -4212,6 +4333,7 @@ void Player::postAddNotification(std::shared_ptr<Thing> thing, std::shared_ptr<C
 }
 
 void Player::postRemoveNotification(std::shared_ptr<Thing> thing, std::shared_ptr<Cylinder> newParent, int32_t index, CylinderLink_t link /*= LINK_OWNER*/) {
+	invalidateCyclopediaPayload(CYCLOPEDIA_CHARACTERINFO_ITEMSUMMARY);
 	if (link == LINK_OWNER) {
 		// calling movement scripts
 		g_moveEvents().onPlayerDeEquip(getPlayer(), thing->getItem(), static_cast<Slots_t>(index));
@@ -4936,13 +5058,8 @@ bool Player::canWear(uint16_t lookType, uint8_t addons) const {
 		return true;
 	}
 
-	for (const OutfitEntry &outfitEntry : outfits) {
-		if (outfitEntry.lookType != lookType) {
-			continue;
-		}
-		return (outfitEntry.addons & addons) == addons;
-	}
-	return false;
+	const auto it = outfits.find(lookType);
+	return it != outfits.end() && (it->second & addons) == addons;
 }
 
 bool Player::canLogout() {
@@ -4969,8 +5086,8 @@ bool Player::canLogout() {
 void Player::genReservedStorageRange() {
 	// generate outfits range
 	uint32_t outfits_key = PSTRG_OUTFITS_RANGE_START;
-	for (const OutfitEntry &entry : outfits) {
-		storageMap[++outfits_key] = (entry.lookType << 16) | entry.addons;
+	for (const auto &[lookType, addons] : outfits) {
+		storageMap[++outfits_key] = (lookType << 16) | addons;
 	}
 	// generate familiars range
 	uint32_t familiar_key = PSTRG_FAMILIARS_RANGE_START;
@@ -4980,34 +5097,43 @@ void Player::genReservedStorageRange() {
 }
 
 void Player::addOutfit(uint16_t lookType, uint8_t addons) {
-	for (OutfitEntry &outfitEntry : outfits) {
-		if (outfitEntry.lookType == lookType) {
-			outfitEntry.addons |= addons;
-			return;
-		}
-	}
-	outfits.emplace_back(lookType, addons);
+	invalidateCyclopediaPayload(CYCLOPEDIA_CHARACTERINFO_OUTFITSMOUNTS);
+	outfits[lookType] |= addons;
 }
 
 bool Player::removeOutfit(uint16_t lookType) {
-	for (auto it = outfits.begin(), end = outfits.end(); it != end; ++it) {
-		OutfitEntry &entry = *it;
-		if (entry.lookType == lookType) {
-			outfits.erase(it);
-			return true;
-		}
+	if (outfits.erase(lookType) == 0) {
+		return false;
 	}
-	return false;
+	invalidateCyclopediaPayload(CYCLOPEDIA_CHARACTERINFO_OUTFITSMOUNTS);
+	return true;
 }
 
 bool Player::removeOutfitAddon(uint16_t lookType, uint8_t addons) {
-	for (OutfitEntry &outfitEntry : outfits) {
-		if (outfitEntry.lookType == lookType) {
-			outfitEntry.addons &= ~addons;
-			return true;
-		}
+	const auto it = outfits.find(lookType);
+	if (it == outfits.end()) {
+		return false;
 	}
-	return false;
+	it->second &= ~addons;
+	invalidateCyclopediaPayload(CYCLOPEDIA_CHARACTERINFO_OUTFITSMOUNTS);
+	return true;
+}
+
+uint64_t Player::getCyclopediaPayloadKey(CyclopediaCharacterInfoType_t type) const {
+	uint64_t key = cyclopediaVersions[type];
+	if (type != CYCLOPEDIA_CHARACTERINFO_OUTFITSMOUNTS) {
+		return key;
+	}
+
+	// The payload also shows the colors of the current outfit and mount, and what is unlocked by the premium, the sex and the vocation
+	const auto &outfit = defaultOutfit;
+	const uint64_t looks = (static_cast<uint64_t>(outfit.lookType) << 32) | (outfit.lookHead << 24) | (outfit.lookBody << 16) | (outfit.lookLegs << 8) | outfit.lookFeet;
+	const uint64_t mountLooks = (static_cast<uint64_t>(outfit.lookMountHead) << 24) | (outfit.lookMountBody << 16) | (outfit.lookMountLegs << 8) | outfit.lookMountFeet;
+	const uint64_t unlocks = (static_cast<uint64_t>(isPremium()) << 40) | (static_cast<uint64_t>(group->access) << 32) | (static_cast<uint64_t>(getSex()) << 16) | getVocationId();
+	for (const auto value : { looks, mountLooks, unlocks }) {
+		key = (key ^ value) * 0x9E3779B97F4A7C15;
+	}
+	return key;
 }
 
 bool Player::getOutfitAddons(const std::shared_ptr<Outfit> &outfit, uint8_t &addons) const {
@@ -5020,12 +5146,8 @@ bool Player::getOutfitAddons(const std::shared_ptr<Outfit> &outfit, uint8_t &add
 		return false;
 	}
 
-	for (const OutfitEntry &outfitEntry : outfits) {
-		if (outfitEntry.lookType != outfit->lookType) {
-			continue;
-		}
-
-		addons = outfitEntry.addons;
+	if (const auto it = outfits.find(outfit->lookType); it != outfits.end()) {
+		addons = it->second;
 		return true;
 	}
 
@@ -5070,6 +5192,7 @@ void Player::addFamiliar(uint16_t lookType) {
 		}
 	}
 	familiars.emplace_back(lookType);
+	invalidateCyclopediaPayload(CYCLOPEDIA_CHARACTERINFO_OUTFITSMOUNTS);
 }
 
 bool Player::removeFamiliar(uint16_t lookType) {
@@ -5077,6 +5200,7 @@ bool Player::removeFamiliar(uint16_t lookType) {
 		FamiliarEntry &entry = *it;
 		if (entry.lookType == lookType) {
 			familiars.erase(it);
+			invalidateCyclopediaPayload(CYCLOPEDIA_CHARACTERINFO_OUTFITSMOUNTS);
 			return true;
 		}
 	}
@@ -5286,13 +5410,19 @@ double Player::getLostPercent() const {
 }
 
 void Player::learnInstantSpell(const std::string &spellName) {
-	if (!hasLearnedInstantSpell(spellName)) {
+	if (learnedInstantSpells.emplace(asLowerCaseString(spellName)).second) {
 		learnedInstantSpellList.emplace_back(spellName);
 	}
 }
 
 void Player::forgetInstantSpell(const std::string &spellName) {
-	std::erase(learnedInstantSpellList, spellName);
+	const auto lowerName = asLowerCaseString(spellName);
+	if (learnedInstantSpells.erase(lowerName) == 0) {
+		return;
+	}
+	std::erase_if(learnedInstantSpellList, [&lowerName](const std::string &learnedSpellName) {
+		return asLowerCaseString(learnedSpellName) == lowerName;
+	});
 }
 
 bool Player::hasLearnedInstantSpell(const std::string &spellName) const {
@@ -5304,12 +5434,7 @@ bool Player::hasLearnedInstantSpell(const std::string &spellName) const {
 		return true;
 	}
 
-	for (const auto &learnedSpellName : learnedInstantSpellList) {
-		if (strcasecmp(learnedSpellName.c_str(), spellName.c_str()) == 0) {
-			return true;
-		}
-	}
-	return false;
+	return learnedInstantSpells.contains(asLowerCaseString(spellName));
 }
 
 bool Player::isInWar(std::shared_ptr<Player> player) const {
@@ -5331,13 +5456,20 @@ bool Player::isInWarList(uint32_t guildId) const {
 
 uint32_t Player::getMagicLevel() const {
 	uint32_t magic = std::max<int32_t>(0, getLoyaltyMagicLevel() + varStats[STAT_MAGICPOINTS]);
-	// Wheel of destiny magic bonus
-	magic += m_wheelPlayer->getStat(WheelStat_t::MAGIC); // Regular bonus
-	magic += m_wheelPlayer->getMajorStatConditional("Positional Tatics", WheelMajor_t::MAGIC); // Revelation bonus
+	// Wheel of destiny magic bonus, the regular and the revelation one
+	magic += m_wheelPlayer->getSkillBonus(SKILL_MAGLEVEL);
 	return magic;
 }
 
 uint32_t Player::getLoyaltyMagicLevel() const {
+	auto &cached = loyaltyLevels[SKILL_MAGLEVEL];
+	if (cached.vocation != vocation.get() || cached.level != magLevel || cached.progress != manaSpent || cached.bonus != getLoyaltyBonus()) {
+		cached = { vocation.get(), manaSpent, magLevel, getLoyaltyBonus(), calculateLoyaltyMagicLevel() };
+	}
+	return cached.loyaltyLevel;
+}
+
+uint32_t Player::calculateLoyaltyMagicLevel() const {
 	uint32_t level = getBaseMagicLevel();
 	absl::uint128 currReqMana = vocation->getReqMana(level);
 	absl::uint128 nextReqMana = vocation->getReqMana(level + 1);
@@ -5391,31 +5523,14 @@ uint16_t Player::getSkillLevel(skills_t skill) const {
 	}
 
 	// Wheel of destiny
-	if (skill >= SKILL_CLUB && skill <= SKILL_AXE) {
-		skillLevel += m_wheelPlayer->getStat(WheelStat_t::MELEE);
-		skillLevel += m_wheelPlayer->getMajorStatConditional("Battle Instinct", WheelMajor_t::MELEE);
-	} else if (skill == SKILL_DISTANCE) {
-		skillLevel += m_wheelPlayer->getMajorStatConditional("Positional Tatics", WheelMajor_t::DISTANCE);
-		skillLevel += m_wheelPlayer->getStat(WheelStat_t::DISTANCE);
-	} else if (skill == SKILL_SHIELD) {
-		skillLevel += m_wheelPlayer->getMajorStatConditional("Battle Instinct", WheelMajor_t::SHIELD);
-	} else if (skill == SKILL_MAGLEVEL) {
-		skillLevel += m_wheelPlayer->getMajorStatConditional("Positional Tatics", WheelMajor_t::MAGIC);
-		skillLevel += m_wheelPlayer->getStat(WheelStat_t::MAGIC);
-	} else if (skill == SKILL_LIFE_LEECH_AMOUNT) {
-		skillLevel += m_wheelPlayer->getStat(WheelStat_t::LIFE_LEECH);
-	} else if (skill == SKILL_MANA_LEECH_AMOUNT) {
-		skillLevel += m_wheelPlayer->getStat(WheelStat_t::MANA_LEECH);
-	} else if (skill == SKILL_CRITICAL_HIT_DAMAGE) {
-		skillLevel += m_wheelPlayer->getStat(WheelStat_t::CRITICAL_DAMAGE);
-		skillLevel += m_wheelPlayer->getMajorStatConditional("Combat Mastery", WheelMajor_t::CRITICAL_DMG_2);
-		skillLevel += m_wheelPlayer->getMajorStatConditional("Ballistic Mastery", WheelMajor_t::CRITICAL_DMG);
+	skillLevel += m_wheelPlayer->getSkillBonus(skill);
+	if (skill == SKILL_CRITICAL_HIT_DAMAGE) {
 		skillLevel += m_wheelPlayer->checkAvatarSkill(WheelAvatarSkill_t::CRITICAL_DAMAGE);
-	}
-
-	int32_t avatarCritChance = m_wheelPlayer->checkAvatarSkill(WheelAvatarSkill_t::CRITICAL_CHANCE);
-	if (skill == SKILL_CRITICAL_HIT_CHANCE && avatarCritChance > 0) {
-		skillLevel = avatarCritChance; // 100%
+	} else if (skill == SKILL_CRITICAL_HIT_CHANCE) {
+		int32_t avatarCritChance = m_wheelPlayer->checkAvatarSkill(WheelAvatarSkill_t::CRITICAL_CHANCE);
+		if (avatarCritChance > 0) {
+			skillLevel = avatarCritChance; // 100%
+		}
 	}
 
 	return std::min<uint16_t>(std::numeric_limits<uint16_t>::max(), std::max<uint16_t>(0, static_cast<uint16_t>(skillLevel)));
@@ -5795,7 +5910,7 @@ void Player::setCurrentMount(uint8_t mount) {
 }
 
 bool Player::hasAnyMount() const {
-	const auto mounts = g_game().mounts.getMounts();
+	const auto &mounts = g_game().mounts.getMounts();
 	for (const auto &mount : mounts) {
 		if (hasMount(mount)) {
 			return true;
@@ -5806,7 +5921,7 @@ bool Player::hasAnyMount() const {
 
 uint8_t Player::getRandomMountId() const {
 	std::vector<uint8_t> playerMounts;
-	const auto mounts = g_game().mounts.getMounts();
+	const auto &mounts = g_game().mounts.getMounts();
 	for (const auto &mount : mounts) {
 		if (hasMount(mount)) {
 			playerMounts.push_back(mount->id);
@@ -5912,6 +6027,7 @@ bool Player::tameMount(uint8_t mountId) {
 	}
 
 	addStorageValue(key, value);
+	invalidateCyclopediaPayload(CYCLOPEDIA_CHARACTERINFO_OUTFITSMOUNTS);
 	return true;
 }
 
@@ -5930,6 +6046,7 @@ bool Player::untameMount(uint8_t mountId) {
 
 	value &= ~(1 << (tmpMountId % 31));
 	addStorageValue(key, value);
+	invalidateCyclopediaPayload(CYCLOPEDIA_CHARACTERINFO_OUTFITSMOUNTS);
 
 	if (getCurrentMount() == mountId) {
 		if (isMounted()) {
@@ -6144,16 +6261,17 @@ void Player::clearModalWindows() {
 
 uint16_t Player::getHelpers() const {
 	if (guild && m_party) {
-		const auto &guildMembers = guild->getMembersOnline();
-
+		// The online guild members plus the party ones from other guilds, without copying the guild list
 		stdext::vector_set<std::shared_ptr<Player>> helperSet;
-		helperSet.insert(helperSet.end(), guildMembers.begin(), guildMembers.end());
 		helperSet.insertAll(m_party->getMembers());
 		helperSet.insertAll(m_party->getInvitees());
-
 		helperSet.emplace(m_party->getLeader());
 
-		return static_cast<uint16_t>(helperSet.size());
+		const auto first = helperSet.begin();
+		const auto outsiders = std::count_if(first, helperSet.end(), [this](const auto &helper) {
+			return !helper || helper->getGuild() != guild;
+		});
+		return static_cast<uint16_t>(guild->getMemberCountOnline() + outsiders);
 	}
 
 	if (guild) {
@@ -6320,6 +6438,29 @@ std::vector<std::shared_ptr<Condition>> Player::getMuteConditions() const {
 	return muteConditions;
 }
 
+void Player::setBankBalance(uint64_t balance) {
+	bankBalance = balance;
+	if (guid != 0) {
+		scheduleJournal();
+		g_saveManager().setSavePriority(static_self_cast<Player>());
+	}
+}
+
+void Player::scheduleJournal() {
+	if (guid == 0 || journalScheduled || !g_persistenceJournal().isOpen()) {
+		return;
+	}
+
+	// After the task, so the record never holds half of a change (e.g. the new balance without the coins it was withdrawn to)
+	journalScheduled = true;
+	g_dispatcher().addEvent([playerGUID = guid] {
+		if (const auto player = g_game().getPlayerByGUID(playerGUID)) {
+			player->journalScheduled = false;
+			IOLoginDataSave::journalPlayer(player);
+		}
+	}, "IOLoginDataSave::journalPlayer");
+}
+
 void Player::setGuild(const std::shared_ptr<Guild> newGuild) {
 	if (newGuild == guild) {
 		return;
@@ -6805,49 +6946,41 @@ void Player::requestDepotItems() {
 		return;
 	}
 
+	const auto addItemCount = [&itemMap, &count](uint16_t itemId, uint8_t tier, uint32_t itemCount) {
+		const auto &[it, inserted] = itemMap[itemId].try_emplace(tier, 0);
+		if (inserted) {
+			count++;
+		}
+		it->second += itemCount;
+	};
+
+	// From the content counts of the depot containers, only the items with tiers are looked up
 	for (const std::shared_ptr<Item> &locker : depotLocker->getItemList()) {
 		std::shared_ptr<Container> c = locker->getContainer();
 		if (!c || c->empty()) {
 			continue;
 		}
 
-		for (ContainerIterator it = c->iterator(); it.hasNext(); it.advance()) {
-			auto itemMap_it = itemMap.find((*it)->getID());
-
-			uint8_t itemTier = Item::items[(*it)->getID()].upgradeClassification > 0 ? (*it)->getTier() + 1 : 0;
-			if (itemMap_it == itemMap.end()) {
-				std::map<uint8_t, uint32_t> itemTierMap;
-				itemTierMap[itemTier] = Item::countByType((*it), -1);
-				itemMap[(*it)->getID()] = itemTierMap;
-				count++;
-			} else if (auto itemTier_it = itemMap[(*it)->getID()].find(itemTier); itemTier_it == itemMap[(*it)->getID()].end()) {
-				itemMap[(*it)->getID()][itemTier] = Item::countByType((*it), -1);
-				count++;
-			} else {
-				itemMap[(*it)->getID()][itemTier] += Item::countByType((*it), -1);
+		c->forEachContentItemCount([&c, &addItemCount](uint16_t itemId, uint32_t amount) {
+			if (Item::items[itemId].upgradeClassification == 0) {
+				addItemCount(itemId, 0, amount);
+				return;
 			}
-		}
+
+			c->forEachContentItem(itemId, [itemId, &addItemCount](const std::shared_ptr<Item> &item) {
+				addItemCount(itemId, item->getTier() + 1, Item::countByType(item, -1));
+			});
+		});
 	}
 
 	for (const auto &[itemId, itemCount] : getStashItems()) {
-		auto itemMap_it = itemMap.find(itemId);
 		// Stackable items not have upgrade classification
 		if (Item::items[itemId].upgradeClassification > 0) {
 			g_logger().error("{} - Player {} have wrong item with id {} on stash with upgrade classification", __FUNCTION__, getName(), itemId);
 			continue;
 		}
 
-		if (itemMap_it == itemMap.end()) {
-			std::map<uint8_t, uint32_t> itemTierMap;
-			itemTierMap[0] = itemCount;
-			itemMap[itemId] = itemTierMap;
-			count++;
-		} else if (auto itemTier_it = itemMap[itemId].find(0); itemTier_it == itemMap[itemId].end()) {
-			itemMap[itemId][0] = itemCount;
-			count++;
-		} else {
-			itemMap[itemId][0] += itemCount;
-		}
+		addItemCount(itemId, 0, itemCount);
 	}
 
 	setDepotSearchIsOpen(1, 0);
@@ -6877,13 +7010,13 @@ void Player::requestDepotSearchItem(uint16_t itemId, uint8_t tier) {
 			continue;
 		}
 
-		for (ContainerIterator it = c->iterator(); it.hasNext(); it.advance()) {
-			std::shared_ptr<Item> item = *it;
-			if (!item || item->getID() != itemId || item->getTier() != tier) {
-				continue;
+		const bool isInbox = c->isInbox();
+		c->forEachContentItem(itemId, [&](const std::shared_ptr<Item> &item) {
+			if (item->getTier() != tier) {
+				return;
 			}
 
-			if (c->isInbox()) {
+			if (isInbox) {
 				if (inboxItems.size() < 255) {
 					inboxItems.push_back(item);
 				}
@@ -6894,7 +7027,7 @@ void Player::requestDepotSearchItem(uint16_t itemId, uint8_t tier) {
 				}
 				depotCount += Item::countByType(item, -1);
 			}
-		}
+		});
 	}
 
 	setDepotSearchIsOpen(itemId, tier);
@@ -6918,16 +7051,11 @@ void Player::retrieveAllItemsFromDepotSearch(uint16_t itemId, uint8_t tier, bool
 			continue;
 		}
 
-		for (ContainerIterator it = c->iterator(); it.hasNext(); it.advance()) {
-			std::shared_ptr<Item> item = *it;
-			if (!item) {
-				continue;
-			}
-
-			if (item->getID() == itemId && item->getTier() == depotSearchOnItem.second) {
+		c->forEachContentItem(itemId, [this, &itemsVector](const std::shared_ptr<Item> &item) {
+			if (item->getTier() == depotSearchOnItem.second) {
 				itemsVector.push_back(item);
 			}
-		}
+		});
 	}
 
 	ReturnValue ret = RETURNVALUE_NOERROR;
@@ -6976,7 +7104,9 @@ std::shared_ptr<Item> Player::getItemFromDepotSearch(uint16_t itemId, const Posi
 		return nullptr;
 	}
 
+	// The same order as the items sent by requestDepotSearchItem
 	uint8_t index = 0;
+	std::shared_ptr<Item> found;
 	for (const std::shared_ptr<Item> &locker : depotLocker->getItemList()) {
 		std::shared_ptr<Container> c = locker->getContainer();
 		if (!c || c->empty() || (c->isInbox() && pos.y != 0x21) || // From inbox.
@@ -6984,16 +7114,18 @@ std::shared_ptr<Item> Player::getItemFromDepotSearch(uint16_t itemId, const Posi
 			continue;
 		}
 
-		for (ContainerIterator it = c->iterator(); it.hasNext(); it.advance()) {
-			std::shared_ptr<Item> item = *it;
-			if (!item || item->getID() != itemId || item->getTier() != depotSearchOnItem.second) {
-				continue;
+		c->forEachContentItem(itemId, [this, &pos, &index, &found](const std::shared_ptr<Item> &item) {
+			if (found || item->getTier() != depotSearchOnItem.second) {
+				return;
 			}
 
 			if (pos.z == index) {
-				return item;
+				found = item;
 			}
 			index++;
+		});
+		if (found) {
+			return found;
 		}
 	}
 
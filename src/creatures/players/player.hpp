@@ -40,6 +40,7 @@
 #include "creatures/players/cyclopedia/player_cyclopedia.hpp"
 #include "creatures/players/cyclopedia/player_title.hpp"
 #include "creatures/players/vip/player_vip.hpp"
+#include "lib/metrics/measured_lock.hpp"
 
 class House;
 class NetworkMessage;
@@ -98,6 +99,15 @@ struct OpenContainer {
 	uint16_t index;
 };
 
+// An item row as stored in the player item tables, not turned into an Item yet
+struct PendingItemRow {
+	uint32_t sid;
+	uint32_t pid;
+	uint16_t type;
+	uint16_t count;
+	std::string attributes;
+};
+
 using MuteCountMap = std::map<uint32_t, uint32_t>;
 
 static constexpr uint16_t PLAYER_MAX_SPEED = std::numeric_limits<uint16_t>::max();
@@ -108,19 +118,14 @@ class Player final : public Creature, public Cylinder, public Bankable {
 public:
 	class PlayerLock {
 	public:
-		explicit PlayerLock(const std::shared_ptr<Player> &p) :
-			player(p) {
-			player->mutex.lock();
-		}
+		// The site names the caller in the lock metrics, see metrics::measured_lock
+		explicit PlayerLock(const std::shared_ptr<Player> &p, std::string_view site = "Player::PlayerLock") :
+			lock(p->mutex, site) { }
 
 		PlayerLock(const PlayerLock &) = delete;
 
-		~PlayerLock() {
-			player->mutex.unlock();
-		}
-
 	private:
-		const std::shared_ptr<Player> &player;
+		metrics::measured_lock<std::mutex> lock;
 	};
 
 	explicit Player(ProtocolGame_ptr p);
@@ -137,7 +142,7 @@ public:
 		return static_self_cast<Player>();
 	}
 
-	static std::shared_ptr<Task> createPlayerTask(uint32_t delay, std::function<void(void)> f, std::string context);
+	static std::shared_ptr<Task> createPlayerTask(uint32_t delay, std::function<void(void)> f, std::string_view context);
 
 	void setID() override;
 
@@ -217,6 +222,7 @@ public:
 
 	void setGUID(uint32_t newGuid) {
 		this->guid = newGuid;
+		kvScope = g_kv().makeScope(fmt::format("player.{}", newGuid));
 	}
 	uint32_t getGUID() const {
 		return guid;
@@ -275,9 +281,10 @@ public:
 	uint64_t getBankBalance() const override {
 		return bankBalance;
 	}
-	void setBankBalance(uint64_t balance) override {
-		bankBalance = balance;
-	}
+	void setBankBalance(uint64_t balance) override;
+
+	// Records the balance and items of the player in the persistence journal once the current task ends
+	void scheduleJournal();
 
 	[[nodiscard]] std::shared_ptr<Guild> getGuild() const {
 		return guild;
@@ -527,6 +534,9 @@ public:
 	void addStorageValueByName(const std::string &storageName, const int32_t value, const bool isLogin = false);
 
 	std::shared_ptr<KV> kv() const {
+		if (kvScope) {
+			return kvScope;
+		}
 		return g_kv().scoped("player")->scoped(fmt::format("{}", getGUID()));
 	}
 
@@ -713,6 +723,7 @@ public:
 	bool removeItemCountById(uint16_t itemId, uint32_t itemAmount, bool removeFromStash = true);
 
 	void addItemOnStash(uint16_t itemId, uint32_t amount) {
+		invalidateCyclopediaPayload(CYCLOPEDIA_CHARACTERINFO_ITEMSUMMARY);
 		auto it = stashItems.find(itemId);
 		if (it != stashItems.end()) {
 			stashItems[itemId] += amount;
@@ -738,6 +749,7 @@ public:
 			} else {
 				return false;
 			}
+			invalidateCyclopediaPayload(CYCLOPEDIA_CHARACTERINFO_ITEMSUMMARY);
 			return true;
 		}
 		return false;
@@ -804,6 +816,10 @@ public:
 	std::vector<std::shared_ptr<Item>> getRewardsFromContainer(std::shared_ptr<Container> container) const;
 
 	std::shared_ptr<DepotChest> getDepotChest(uint32_t depotId, bool autoCreate);
+	// True while the depot chests still wait for their items, see lazyDepotLoading
+	bool hasPendingDepotItems() const {
+		return !pendingDepotItems.empty();
+	}
 	std::shared_ptr<DepotLocker> getDepotLocker(uint32_t depotId);
 	void onReceiveMail();
 	bool isNearDepotBox();
@@ -813,7 +829,7 @@ public:
 	void setMainBackpackUnassigned(std::shared_ptr<Container> container);
 
 	bool canSee(const Position &pos) override;
-	bool canSeeCreature(std::shared_ptr<Creature> creature) const override;
+	bool canSeeCreature(const std::shared_ptr<Creature> &creature) const override;
 
 	bool canWalkthrough(std::shared_ptr<Creature> creature);
 	bool canWalkthroughEx(std::shared_ptr<Creature> creature);
@@ -1439,6 +1455,11 @@ public:
 			client->sendMagicEffect(pos, type);
 		}
 	}
+	void sendBroadcast(BroadcastMessage &message) const {
+		if (client) {
+			client->sendBroadcast(message);
+		}
+	}
 	void removeMagicEffect(const Position &pos, uint16_t type) const {
 		if (client) {
 			client->removeMagicEffect(pos, type);
@@ -1665,6 +1686,18 @@ public:
 			client->sendCyclopediaCharacterOutfitsMounts();
 		}
 	}
+	/**
+	 * Sends the payload the client built last time for the type, if nothing it depends on changed since.
+	 * \returns false if there is no such payload and it must be built.
+	 */
+	bool sendCachedCyclopediaCharacterInfo(CyclopediaCharacterInfoType_t type) {
+		return client && client->sendCachedCyclopediaCharacterInfo(type, getCyclopediaPayloadKey(type));
+	}
+	// Called by the changes a cached cyclopedia payload of the type depends on
+	void invalidateCyclopediaPayload(CyclopediaCharacterInfoType_t type) {
+		++cyclopediaVersions[type];
+	}
+	uint64_t getCyclopediaPayloadKey(CyclopediaCharacterInfoType_t type) const;
 	void sendCyclopediaCharacterStoreSummary() {
 		if (client) {
 			client->sendCyclopediaCharacterStoreSummary();
@@ -2671,14 +2704,18 @@ private:
 
 	void checkLootContainers(std::shared_ptr<Container> item);
 
+	uint16_t calculateLoyaltySkill(skills_t skill) const;
+	uint32_t calculateLoyaltyMagicLevel() const;
+
 	void gainExperience(uint64_t exp, std::shared_ptr<Creature> target);
 	void addExperience(std::shared_ptr<Creature> target, uint64_t exp, bool sendText = false);
 	void removeExperience(uint64_t exp, bool sendText = false);
 
 	void updateInventoryWeight();
 	/**
-	 * @brief Starts checking the imbuements in the item so that the time decay is performed
-	 * Registers the player in an unordered_map in game.h so that the function can be initialized by the task
+	 * @brief Decays the imbuements of the equipped items by the seconds elapsed since the last call,
+	 * called by Game::checkImbuements. The items without imbuement slots are skipped without reading
+	 * their attributes and the stats are only updated when an imbuement runs out.
 	 */
 	void updateInventoryImbuement();
 
@@ -2717,7 +2754,10 @@ private:
 
 	// This function is a override function of base class
 	std::map<uint32_t, uint32_t> &getAllItemTypeCount(std::map<uint32_t, uint32_t> &countMap) const override;
-	// Function from player class with correct type sizes (uint16_t)
+	/**
+	 * Function from player class with correct type sizes (uint16_t), the items a shop can buy from the player: the ones in the containers of the inventory, without a tier.
+	 * Read from the content counts of the containers, only the items that can be forged are walked to check their tier.
+	 */
 	std::map<uint16_t, uint16_t> &getAllSaleItemIdAndCount(std::map<uint16_t, uint16_t> &countMap) const;
 	void getAllItemTypeCountAndSubtype(std::map<uint32_t, uint32_t> &countMap) const;
 	std::shared_ptr<Item> getForgeItemFromId(uint16_t itemId, uint8_t tier);
@@ -2735,8 +2775,10 @@ private:
 	std::map<uint8_t, OpenContainer> openContainers;
 	std::map<uint32_t, std::shared_ptr<DepotLocker>> depotLockerMap;
 	std::map<uint32_t, std::shared_ptr<DepotChest>> depotChests;
+	// Depot chest rows read at login, the items are created the first time a depot chest is needed
+	std::vector<PendingItemRow> pendingDepotItems;
 	std::map<uint8_t, int64_t> moduleDelayMap;
-	std::map<uint32_t, int32_t> storageMap;
+	phmap::flat_hash_map<uint32_t, int32_t> storageMap;
 	std::map<uint16_t, uint64_t> itemPriceMap;
 
 	std::map<uint8_t, uint16_t> maxValuePerSkill = {
@@ -2752,7 +2794,8 @@ private:
 
 	std::vector<uint16_t> quickLootListItemIds;
 
-	std::vector<OutfitEntry> outfits;
+	// The addons of the unlocked outfits by look type
+	phmap::flat_hash_map<uint16_t, uint8_t> outfits;
 	std::vector<FamiliarEntry> familiars;
 
 	std::vector<std::unique_ptr<PreySlot>> preys;
@@ -2763,17 +2806,35 @@ private:
 	std::vector<std::shared_ptr<Party>> invitePartyList;
 	std::vector<uint32_t> modalWindows;
 	std::vector<std::string> learnedInstantSpellList;
+	// The same names in lower case, for hasLearnedInstantSpell on every cast
+	phmap::flat_hash_set<std::string> learnedInstantSpells;
 	// TODO: This variable is only temporarily used when logging in, get rid of it somehow.
 	std::vector<std::shared_ptr<Condition>> storedConditionList;
 
 	std::unordered_set<std::shared_ptr<MonsterType>> m_bestiaryMonsterTracker;
 	std::unordered_set<std::shared_ptr<MonsterType>> m_bosstiaryMonsterTracker;
+	// Items whose decay starts once a player loaded off the dispatcher is finished, see IOLoginData::finishLoadPlayer
+	std::vector<std::shared_ptr<Item>> loadingDecayItems;
+	// Scope of the player in the KV store, made once the guid is known, so kv() does not build it on every call
+	std::shared_ptr<KV> kvScope;
+	// Hash of the rows last written to each item table, the tables that did not change are skipped on save, see DBInsert::replace
+	std::unordered_map<std::string, uint64_t> savedRowsHash;
+	bool journalScheduled = false;
 
 	std::string name;
 	std::string guildNick;
 	std::string loyaltyTitle;
 
 	Skill skills[SKILL_LAST + 1];
+	// The loyalty levels are read on every hit, they are kept while what they were calculated from is the same
+	struct LoyaltyLevel {
+		const Vocation* vocation = nullptr;
+		uint64_t progress = 0;
+		uint32_t level = 0;
+		uint16_t bonus = 0;
+		uint32_t loyaltyLevel = 0;
+	};
+	mutable std::array<LoyaltyLevel, SKILL_MAGLEVEL + 1> loyaltyLevels {};
 	LightInfo itemsLight;
 	Position loginPosition;
 	Position lastWalkthroughPosition;
@@ -2803,6 +2864,8 @@ private:
 	int64_t lastUIInteraction = 0;
 	int64_t lastPing;
 	int64_t lastPong;
+	// When the imbuements were last decayed, they are decayed by the whole seconds since then
+	int64_t lastImbuementDecay = 0;
 	int64_t nextAction = 0;
 	int64_t nextPotionAction = 0;
 	int64_t lastQuickLootNotification = 0;
@@ -2879,6 +2942,7 @@ private:
 	uint16_t staminaXpBoost = 100;
 	int16_t lastDepotId = -1;
 	StashItemList stashItems; // [ItemID] = amount
+	std::array<uint32_t, CYCLOPEDIA_CHARACTERINFO_TITLES + 1> cyclopediaVersions {};
 	uint32_t movedItems = 0;
 
 	// Depot search system
@@ -2934,6 +2998,7 @@ private:
 	bool ghostMode = false;
 	bool pzLocked = false;
 	bool isConnecting = false;
+	bool loadingAsync = false;
 	bool addAttackSkillPoint = false;
 	bool inventoryAbilities[CONST_SLOT_LAST + 1] = {};
 	bool quickLootFallbackToMainContainer = false;
@@ -25,10 +25,10 @@ public:
 
 	bool loadFromXML();
 
-	const std::map<std::string, uint32_t> &getStorageMap() const;
+	const phmap::flat_hash_map<std::string, uint32_t> &getStorageMap() const;
 
 private:
-	std::map<std::string, uint32_t> m_storageMap;
+	phmap::flat_hash_map<std::string, uint32_t> m_storageMap;
 };
 
 constexpr auto g_storages = Storages::getInstance;
@@ -63,7 +63,7 @@ bool PlayerVIP::remove(uint32_t vipGuid) {
 		return false;
 	}
 
-	vipGuids.erase(vipGuid);
+	g_game().removeVipWatcher(vipGuid, m_player.getID());
 	if (m_player.account) {
 		IOLoginData::removeVIPEntry(m_player.account->getID(), vipGuid);
 	}
@@ -81,6 +81,7 @@ bool PlayerVIP::add(uint32_t vipGuid, const std::string &vipName, VipStatus_t st
 		m_player.sendTextMessage(MESSAGE_FAILURE, "This player is already in your list.");
 		return false;
 	}
+	g_game().addVipWatcher(vipGuid, m_player.getID());
 
 	if (m_player.account) {
 		IOLoginData::addVIPEntry(m_player.account->getID(), vipGuid, "", 0, false);
@@ -65,6 +65,10 @@ public:
 		return vipGroups;
 	}
 
+	[[nodiscard]] const phmap::flat_hash_set<uint32_t> &getGuids() const {
+		return vipGuids;
+	}
+
 private:
 	Player &m_player;
 
@@ -141,6 +141,38 @@ namespace {
 		{ 43949, "extended", 13 },
 		{ 43950, "advanced", 20 },
 	};
+
+	// The instants and the stages by the names the scripts and the combat use, looked up once per call instead of compared one by one
+	struct WheelInstantName {
+		bool isStage;
+		uint8_t type;
+	};
+
+	const phmap::flat_hash_map<std::string_view, WheelInstantName> &wheelInstantNames() {
+		static const phmap::flat_hash_map<std::string_view, WheelInstantName> names {
+			{ "Battle Instinct", { false, static_cast<uint8_t>(WheelInstant_t::BATTLE_INSTINCT) } },
+			{ "Battle Healing", { false, static_cast<uint8_t>(WheelInstant_t::BATTLE_HEALING) } },
+			{ "Positional Tatics", { false, static_cast<uint8_t>(WheelInstant_t::POSITIONAL_TATICS) } },
+			{ "Ballistic Mastery", { false, static_cast<uint8_t>(WheelInstant_t::BALLISTIC_MASTERY) } },
+			{ "Healing Link", { false, static_cast<uint8_t>(WheelInstant_t::HEALING_LINK) } },
+			{ "Runic Mastery", { false, static_cast<uint8_t>(WheelInstant_t::RUNIC_MASTERY) } },
+			{ "Focus Mastery", { false, static_cast<uint8_t>(WheelInstant_t::FOCUS_MASTERY) } },
+			{ "Beam Mastery", { true, static_cast<uint8_t>(WheelStage_t::BEAM_MASTERY) } },
+			{ "Combat Mastery", { true, static_cast<uint8_t>(WheelStage_t::COMBAT_MASTERY) } },
+			{ "Gift of Life", { true, static_cast<uint8_t>(WheelStage_t::GIFT_OF_LIFE) } },
+			{ "Blessing of the Grove", { true, static_cast<uint8_t>(WheelStage_t::BLESSING_OF_THE_GROVE) } },
+			{ "Drain Body", { true, static_cast<uint8_t>(WheelStage_t::DRAIN_BODY) } },
+			{ "Divine Empowerment", { true, static_cast<uint8_t>(WheelStage_t::DIVINE_EMPOWERMENT) } },
+			{ "Divine Grenade", { true, static_cast<uint8_t>(WheelStage_t::DIVINE_GRENADE) } },
+			{ "Twin Burst", { true, static_cast<uint8_t>(WheelStage_t::TWIN_BURST) } },
+			{ "Executioner's Throw", { true, static_cast<uint8_t>(WheelStage_t::EXECUTIONERS_THROW) } },
+			{ "Avatar of Light", { true, static_cast<uint8_t>(WheelStage_t::AVATAR_OF_LIGHT) } },
+			{ "Avatar of Nature", { true, static_cast<uint8_t>(WheelStage_t::AVATAR_OF_NATURE) } },
+			{ "Avatar of Steel", { true, static_cast<uint8_t>(WheelStage_t::AVATAR_OF_STEEL) } },
+			{ "Avatar of Storm", { true, static_cast<uint8_t>(WheelStage_t::AVATAR_OF_STORM) } },
+		};
+		return names;
+	}
 } // namespace
 
 PlayerWheel::PlayerWheel(Player &initPlayer) :
@@ -1982,13 +2014,13 @@ WheelStageEnum_t PlayerWheel::getPlayerSliceStage(const std::string &color) cons
 void PlayerWheel::checkAbilities() {
 	// Wheel of destiny
 	bool reloadClient = false;
-	if (getInstant("Battle Instinct") && getOnThinkTimer(WheelOnThink_t::BATTLE_INSTINCT) < OTSYS_TIME() && checkBattleInstinct()) {
+	if (getInstant(WheelInstant_t::BATTLE_INSTINCT) && getOnThinkTimer(WheelOnThink_t::BATTLE_INSTINCT) < OTSYS_TIME() && checkBattleInstinct()) {
 		reloadClient = true;
 	}
-	if (getInstant("Positional Tatics") && getOnThinkTimer(WheelOnThink_t::POSITIONAL_TATICS) < OTSYS_TIME() && checkPositionalTatics()) {
+	if (getInstant(WheelInstant_t::POSITIONAL_TATICS) && getOnThinkTimer(WheelOnThink_t::POSITIONAL_TATICS) < OTSYS_TIME() && checkPositionalTatics()) {
 		reloadClient = true;
 	}
-	if (getInstant("Ballistic Mastery") && getOnThinkTimer(WheelOnThink_t::BALLISTIC_MASTERY) < OTSYS_TIME() && checkBallisticMastery()) {
+	if (getInstant(WheelInstant_t::BALLISTIC_MASTERY) && getOnThinkTimer(WheelOnThink_t::BALLISTIC_MASTERY) < OTSYS_TIME() && checkBallisticMastery()) {
 		reloadClient = true;
 	}
 
@@ -2408,13 +2440,13 @@ int32_t PlayerWheel::checkAvatarSkill(WheelAvatarSkill_t skill) const {
 
 	uint8_t stage = 0;
 	if (getOnThinkTimer(WheelOnThink_t::AVATAR_SPELL) > OTSYS_TIME()) {
-		if (getInstant("Avatar of Light")) {
+		if (getStage(WheelStage_t::AVATAR_OF_LIGHT) > 0) {
 			stage = getStage(WheelStage_t::AVATAR_OF_LIGHT);
-		} else if (getInstant("Avatar of Steel")) {
+		} else if (getStage(WheelStage_t::AVATAR_OF_STEEL) > 0) {
 			stage = getStage(WheelStage_t::AVATAR_OF_STEEL);
-		} else if (getInstant("Avatar of Nature")) {
+		} else if (getStage(WheelStage_t::AVATAR_OF_NATURE) > 0) {
 			stage = getStage(WheelStage_t::AVATAR_OF_NATURE);
-		} else if (getInstant("Avatar of Storm")) {
+		} else if (getStage(WheelStage_t::AVATAR_OF_STORM) > 0) {
 			stage = getStage(WheelStage_t::AVATAR_OF_STORM);
 		} else {
 			return 0;
@@ -2456,9 +2488,9 @@ int32_t PlayerWheel::checkFocusMasteryDamage() {
 int32_t PlayerWheel::checkElementSensitiveReduction(CombatType_t type) const {
 	int32_t rt = 0;
 	if (type == COMBAT_PHYSICALDAMAGE) {
-		rt += getMajorStatConditional("Ballistic Mastery", WheelMajor_t::PHYSICAL_DMG);
+		rt += getMajorStatConditional(WheelInstant_t::BALLISTIC_MASTERY, WheelMajor_t::PHYSICAL_DMG);
 	} else if (type == COMBAT_HOLYDAMAGE) {
-		rt += getMajorStatConditional("Ballistic Mastery", WheelMajor_t::HOLY_DMG);
+		rt += getMajorStatConditional(WheelInstant_t::BALLISTIC_MASTERY, WheelMajor_t::HOLY_DMG);
 	}
 	return rt;
 }
@@ -2470,7 +2502,7 @@ void PlayerWheel::onThink(bool force /* = false*/) {
 	if (getGiftOfCooldown() > 0 /*getInstant("Gift of Life")*/ && getOnThinkTimer(WheelOnThink_t::GIFT_OF_LIFE) <= OTSYS_TIME()) {
 		decreaseGiftOfCooldown(1);
 	}
-	if (!m_player.hasCondition(CONDITION_INFIGHT) || m_player.getZoneType() == ZONE_PROTECTION || (!getInstant("Battle Instinct") && !getInstant("Positional Tatics") && !getInstant("Ballistic Mastery") && !getInstant("Gift of Life") && !getInstant("Combat Mastery") && !getInstant("Divine Empowerment") && getGiftOfCooldown() == 0)) {
+	if (!m_player.hasCondition(CONDITION_INFIGHT) || m_player.getZoneType() == ZONE_PROTECTION || (!getInstant(WheelInstant_t::BATTLE_INSTINCT) && !getInstant(WheelInstant_t::POSITIONAL_TATICS) && !getInstant(WheelInstant_t::BALLISTIC_MASTERY) && getStage(WheelStage_t::GIFT_OF_LIFE) == 0 && getStage(WheelStage_t::COMBAT_MASTERY) == 0 && getStage(WheelStage_t::DIVINE_EMPOWERMENT) == 0 && getGiftOfCooldown() == 0)) {
 		bool mustReset = false;
 		for (int i = 0; i < static_cast<int>(WheelMajor_t::TOTAL_COUNT); i++) {
 			if (getMajorStat(static_cast<WheelMajor_t>(i)) != 0) {
@@ -2492,23 +2524,23 @@ void PlayerWheel::onThink(bool force /* = false*/) {
 		}
 	}
 	// Battle Instinct
-	if (getInstant("Battle Instinct") && (force || getOnThinkTimer(WheelOnThink_t::BATTLE_INSTINCT) < OTSYS_TIME()) && checkBattleInstinct()) {
+	if (getInstant(WheelInstant_t::BATTLE_INSTINCT) && (force || getOnThinkTimer(WheelOnThink_t::BATTLE_INSTINCT) < OTSYS_TIME()) && checkBattleInstinct()) {
 		updateClient = true;
 	}
 	// Positional Tatics
-	if (getInstant("Positional Tatics") && (force || getOnThinkTimer(WheelOnThink_t::POSITIONAL_TATICS) < OTSYS_TIME()) && checkPositionalTatics()) {
+	if (getInstant(WheelInstant_t::POSITIONAL_TATICS) && (force || getOnThinkTimer(WheelOnThink_t::POSITIONAL_TATICS) < OTSYS_TIME()) && checkPositionalTatics()) {
 		updateClient = true;
 	}
 	// Ballistic Mastery
-	if (getInstant("Ballistic Mastery") && (force || getOnThinkTimer(WheelOnThink_t::BALLISTIC_MASTERY) < OTSYS_TIME()) && checkBallisticMastery()) {
+	if (getInstant(WheelInstant_t::BALLISTIC_MASTERY) && (force || getOnThinkTimer(WheelOnThink_t::BALLISTIC_MASTERY) < OTSYS_TIME()) && checkBallisticMastery()) {
 		updateClient = true;
 	}
 	// Combat Mastery
-	if (getInstant("Combat Mastery") && (force || getOnThinkTimer(WheelOnThink_t::COMBAT_MASTERY) < OTSYS_TIME()) && checkCombatMastery()) {
+	if (getStage(WheelStage_t::COMBAT_MASTERY) > 0 && (force || getOnThinkTimer(WheelOnThink_t::COMBAT_MASTERY) < OTSYS_TIME()) && checkCombatMastery()) {
 		updateClient = true;
 	}
 	// Divine Empowerment
-	if (getInstant("Divine Empowerment") && (force || getOnThinkTimer(WheelOnThink_t::DIVINE_EMPOWERMENT) < OTSYS_TIME()) && checkDivineEmpowerment()) {
+	if (getStage(WheelStage_t::DIVINE_EMPOWERMENT) > 0 && (force || getOnThinkTimer(WheelOnThink_t::DIVINE_EMPOWERMENT) < OTSYS_TIME()) && checkDivineEmpowerment()) {
 		updateClient = true;
 	}
 	if (updateClient) {
@@ -2585,20 +2617,24 @@ std::shared_ptr<Spell> PlayerWheel::getCombatDataSpell(CombatDamage &damage) {
 		if (getHealingLinkUpgrade(spell->getName())) {
 			damage.healingLink += 10;
 		}
-		if (spell->getSecondaryGroup() == SPELLGROUP_FOCUS && getInstant("Focus Mastery")) {
+		if (spell->getSecondaryGroup() == SPELLGROUP_FOCUS && getInstant(WheelInstant_t::FOCUS_MASTERY)) {
 			setOnThinkTimer(WheelOnThink_t::FOCUS_MASTERY, (OTSYS_TIME() + 12000));
 		}
 
 		if (spell->getWheelOfDestinyUpgraded()) {
-			damage.criticalDamage += spell->getWheelOfDestinyBoost(WheelSpellBoost_t::CRITICAL_DAMAGE, spellGrade) + getSpellBonus(spell->getName(), WheelSpellBoost_t::CRITICAL_DAMAGE);
-			damage.criticalChance += spell->getWheelOfDestinyBoost(WheelSpellBoost_t::CRITICAL_CHANCE, spellGrade) + getSpellBonus(spell->getName(), WheelSpellBoost_t::CRITICAL_CHANCE);
-			damage.damageMultiplier += spell->getWheelOfDestinyBoost(WheelSpellBoost_t::DAMAGE, spellGrade) + getSpellBonus(spell->getName(), WheelSpellBoost_t::DAMAGE);
-			damage.damageReductionMultiplier += spell->getWheelOfDestinyBoost(WheelSpellBoost_t::DAMAGE_REDUCTION, spellGrade) + getSpellBonus(spell->getName(), WheelSpellBoost_t::DAMAGE_REDUCTION);
-			damage.healingMultiplier += spell->getWheelOfDestinyBoost(WheelSpellBoost_t::HEAL, spellGrade) + getSpellBonus(spell->getName(), WheelSpellBoost_t::HEAL);
-			damage.manaLeech += spell->getWheelOfDestinyBoost(WheelSpellBoost_t::MANA_LEECH, spellGrade) + getSpellBonus(spell->getName(), WheelSpellBoost_t::MANA_LEECH);
-			damage.manaLeechChance += spell->getWheelOfDestinyBoost(WheelSpellBoost_t::LIFE_LEECH_CHANCE, spellGrade) + getSpellBonus(spell->getName(), WheelSpellBoost_t::LIFE_LEECH_CHANCE);
-			damage.lifeLeech += spell->getWheelOfDestinyBoost(WheelSpellBoost_t::LIFE_LEECH, spellGrade) + getSpellBonus(spell->getName(), WheelSpellBoost_t::LIFE_LEECH);
-			damage.lifeLeechChance += spell->getWheelOfDestinyBoost(WheelSpellBoost_t::LIFE_LEECH_CHANCE, spellGrade) + getSpellBonus(spell->getName(), WheelSpellBoost_t::LIFE_LEECH_CHANCE);
+			// Looked up once for all the boosts of the hit
+			static const WheelSpells::Bonus noBonus {};
+			const auto bonusIt = m_spellsBonuses.find(spell->getName());
+			const auto &bonus = bonusIt != m_spellsBonuses.end() ? bonusIt->second : noBonus;
+			damage.criticalDamage += spell->getWheelOfDestinyBoost(WheelSpellBoost_t::CRITICAL_DAMAGE, spellGrade) + bonus.increase.criticalDamage;
+			damage.criticalChance += spell->getWheelOfDestinyBoost(WheelSpellBoost_t::CRITICAL_CHANCE, spellGrade) + bonus.increase.criticalChance;
+			damage.damageMultiplier += spell->getWheelOfDestinyBoost(WheelSpellBoost_t::DAMAGE, spellGrade) + bonus.increase.damage;
+			damage.damageReductionMultiplier += spell->getWheelOfDestinyBoost(WheelSpellBoost_t::DAMAGE_REDUCTION, spellGrade) + bonus.increase.damageReduction;
+			damage.healingMultiplier += spell->getWheelOfDestinyBoost(WheelSpellBoost_t::HEAL, spellGrade) + bonus.increase.heal;
+			damage.manaLeech += spell->getWheelOfDestinyBoost(WheelSpellBoost_t::MANA_LEECH, spellGrade) + bonus.leech.mana;
+			damage.manaLeechChance += spell->getWheelOfDestinyBoost(WheelSpellBoost_t::LIFE_LEECH_CHANCE, spellGrade);
+			damage.lifeLeech += spell->getWheelOfDestinyBoost(WheelSpellBoost_t::LIFE_LEECH, spellGrade) + bonus.leech.life;
+			damage.lifeLeechChance += spell->getWheelOfDestinyBoost(WheelSpellBoost_t::LIFE_LEECH_CHANCE, spellGrade);
 		}
 	}
 
@@ -2610,6 +2646,7 @@ void PlayerWheel::setStage(WheelStage_t type, uint8_t value) {
 	auto enumValue = static_cast<uint8_t>(type);
 	try {
 		m_stages.at(enumValue) = value;
+		m_skillBonusOutdated = true;
 	} catch (const std::out_of_range &e) {
 		g_logger().error("[{}]. Type {} is out of range. Error message: {}", __FUNCTION__, enumValue, e.what());
 	}
@@ -2628,6 +2665,7 @@ void PlayerWheel::setMajorStat(WheelMajor_t type, int32_t value) {
 	auto enumValue = static_cast<uint8_t>(type);
 	try {
 		m_majorStats.at(enumValue) = value;
+		m_skillBonusOutdated = true;
 	} catch (const std::out_of_range &e) {
 		g_logger().error("[{}]. Type {} is out of range, value {}. Error message: {}", __FUNCTION__, enumValue, value, e.what());
 	}
@@ -2637,6 +2675,7 @@ void PlayerWheel::setInstant(WheelInstant_t type, bool toggle) {
 	auto enumValue = static_cast<uint8_t>(type);
 	try {
 		m_instant.at(enumValue) = toggle;
+		m_skillBonusOutdated = true;
 	} catch (const std::out_of_range &e) {
 		g_logger().error("[{}]. Type {} is out of range. Error message: {}", __FUNCTION__, enumValue, e.what());
 	}
@@ -2649,6 +2688,7 @@ void PlayerWheel::addStat(WheelStat_t type, int32_t value) {
 		return;
 	}
 	m_stats[enumValue] += value;
+	m_skillBonusOutdated = true;
 }
 
 void PlayerWheel::addResistance(CombatType_t type, int32_t value) {
@@ -2782,6 +2822,7 @@ void PlayerWheel::resetStats() {
 	for (int32_t i = 0; i < static_cast<int>(WheelStat_t::TOTAL_COUNT); i++) {
 		m_stats[i] = 0;
 	}
+	m_skillBonusOutdated = true;
 }
 
 // Wheel of destiny - Header get:
@@ -2796,49 +2837,12 @@ bool PlayerWheel::getInstant(WheelInstant_t type) const {
 }
 
 uint8_t PlayerWheel::getStage(const std::string name) const {
-	if (name == "Battle Instinct") {
-		return PlayerWheel::getInstant(WheelInstant_t::BATTLE_INSTINCT);
-	} else if (name == "Battle Healing") {
-		return PlayerWheel::getInstant(WheelInstant_t::BATTLE_HEALING);
-	} else if (name == "Positional Tatics") {
-		return PlayerWheel::getInstant(WheelInstant_t::POSITIONAL_TATICS);
-	} else if (name == "Ballistic Mastery") {
-		return PlayerWheel::getInstant(WheelInstant_t::BALLISTIC_MASTERY);
-	} else if (name == "Healing Link") {
-		return PlayerWheel::getInstant(WheelInstant_t::HEALING_LINK);
-	} else if (name == "Runic Mastery") {
-		return PlayerWheel::getInstant(WheelInstant_t::RUNIC_MASTERY);
-	} else if (name == "Focus Mastery") {
-		return PlayerWheel::getInstant(WheelInstant_t::FOCUS_MASTERY);
-	} else if (name == "Beam Mastery") {
-		return PlayerWheel::getStage(WheelStage_t::BEAM_MASTERY);
-	} else if (name == "Combat Mastery") {
-		return PlayerWheel::getStage(WheelStage_t::COMBAT_MASTERY);
-	} else if (name == "Gift of Life") {
-		return PlayerWheel::getStage(WheelStage_t::GIFT_OF_LIFE);
-	} else if (name == "Blessing of the Grove") {
-		return PlayerWheel::getStage(WheelStage_t::BLESSING_OF_THE_GROVE);
-	} else if (name == "Drain Body") {
-		return PlayerWheel::getStage(WheelStage_t::DRAIN_BODY);
-	} else if (name == "Divine Empowerment") {
-		return PlayerWheel::getStage(WheelStage_t::DIVINE_EMPOWERMENT);
-	} else if (name == "Divine Grenade") {
-		return PlayerWheel::getStage(WheelStage_t::DIVINE_GRENADE);
-	} else if (name == "Twin Burst") {
-		return PlayerWheel::getStage(WheelStage_t::TWIN_BURST);
-	} else if (name == "Executioner's Throw") {
-		return PlayerWheel::getStage(WheelStage_t::EXECUTIONERS_THROW);
-	} else if (name == "Avatar of Light") {
-		return PlayerWheel::getStage(WheelStage_t::AVATAR_OF_LIGHT);
-	} else if (name == "Avatar of Nature") {
-		return PlayerWheel::getStage(WheelStage_t::AVATAR_OF_NATURE);
-	} else if (name == "Avatar of Steel") {
-		return PlayerWheel::getStage(WheelStage_t::AVATAR_OF_STEEL);
-	} else if (name == "Avatar of Storm") {
-		return PlayerWheel::getStage(WheelStage_t::AVATAR_OF_STORM);
+	const auto it = wheelInstantNames().find(name);
+	if (it == wheelInstantNames().end()) {
+		return 0;
 	}
-
-	return false;
+	const auto &[isStage, type] = it->second;
+	return isStage ? getStage(static_cast<WheelStage_t>(type)) : getInstant(static_cast<WheelInstant_t>(type));
 }
 
 uint8_t PlayerWheel::getStage(WheelStage_t type) const {
@@ -2882,12 +2886,8 @@ int32_t PlayerWheel::getResistance(CombatType_t type) const {
 }
 
 WheelSpellGrade_t PlayerWheel::getSpellUpgrade(const std::string &name) const {
-	for (const auto &[name_it, grade_it] : m_spellsSelected) {
-		if (name_it == name) {
-			return grade_it;
-		}
-	}
-	return WheelSpellGrade_t::NONE;
+	const auto it = m_spellsSelected.find(name);
+	return it != m_spellsSelected.end() ? it->second : WheelSpellGrade_t::NONE;
 }
 
 double PlayerWheel::getMitigationMultiplier() const {
@@ -2895,7 +2895,7 @@ double PlayerWheel::getMitigationMultiplier() const {
 }
 
 bool PlayerWheel::getHealingLinkUpgrade(const std::string &spell) const {
-	if (!getInstant("Healing Link")) {
+	if (!getInstant(WheelInstant_t::HEALING_LINK)) {
 		return false;
 	}
 	if (spell == "Nature's Embrace" || spell == "Heal Friend") {
@@ -2908,6 +2908,41 @@ int32_t PlayerWheel::getMajorStatConditional(const std::string &instant, WheelMa
 	return PlayerWheel::getInstant(instant) ? PlayerWheel::getMajorStat(major) : 0;
 }
 
+int32_t PlayerWheel::getMajorStatConditional(WheelInstant_t instant, WheelMajor_t major) const {
+	return getInstant(instant) ? getMajorStat(major) : 0;
+}
+
+int32_t PlayerWheel::getMajorStatConditional(WheelStage_t stage, WheelMajor_t major) const {
+	return getStage(stage) > 0 ? getMajorStat(major) : 0;
+}
+
+int32_t PlayerWheel::getSkillBonus(skills_t skill) const {
+	if (skill < SKILL_FIRST || skill > SKILL_MAGLEVEL) {
+		return 0;
+	}
+
+	if (m_skillBonusOutdated) {
+		const int32_t battleInstinct = getInstant(WheelInstant_t::BATTLE_INSTINCT) ? 1 : 0;
+		const int32_t positionalTatics = getInstant(WheelInstant_t::POSITIONAL_TATICS) ? 1 : 0;
+		const int32_t ballisticMastery = getInstant(WheelInstant_t::BALLISTIC_MASTERY) ? 1 : 0;
+		const int32_t combatMastery = getStage(WheelStage_t::COMBAT_MASTERY) > 0 ? 1 : 0;
+
+		m_skillBonus.fill(0);
+		const int32_t melee = getStat(WheelStat_t::MELEE) + battleInstinct * getMajorStat(WheelMajor_t::MELEE);
+		m_skillBonus[SKILL_CLUB] = melee;
+		m_skillBonus[SKILL_SWORD] = melee;
+		m_skillBonus[SKILL_AXE] = melee;
+		m_skillBonus[SKILL_DISTANCE] = positionalTatics * getMajorStat(WheelMajor_t::DISTANCE) + getStat(WheelStat_t::DISTANCE);
+		m_skillBonus[SKILL_SHIELD] = battleInstinct * getMajorStat(WheelMajor_t::SHIELD);
+		m_skillBonus[SKILL_MAGLEVEL] = positionalTatics * getMajorStat(WheelMajor_t::MAGIC) + getStat(WheelStat_t::MAGIC);
+		m_skillBonus[SKILL_LIFE_LEECH_AMOUNT] = getStat(WheelStat_t::LIFE_LEECH);
+		m_skillBonus[SKILL_MANA_LEECH_AMOUNT] = getStat(WheelStat_t::MANA_LEECH);
+		m_skillBonus[SKILL_CRITICAL_HIT_DAMAGE] = getStat(WheelStat_t::CRITICAL_DAMAGE) + combatMastery * getMajorStat(WheelMajor_t::CRITICAL_DMG_2) + ballisticMastery * getMajorStat(WheelMajor_t::CRITICAL_DMG);
+		m_skillBonusOutdated = false;
+	}
+	return m_skillBonus[skill];
+}
+
 int64_t PlayerWheel::getOnThinkTimer(WheelOnThink_t type) const {
 	auto enumValue = static_cast<uint8_t>(type);
 	try {
@@ -2920,49 +2955,7 @@ int64_t PlayerWheel::getOnThinkTimer(WheelOnThink_t type) const {
 }
 
 bool PlayerWheel::getInstant(const std::string name) const {
-	if (name == "Battle Instinct") {
-		return PlayerWheel::getInstant(WheelInstant_t::BATTLE_INSTINCT);
-	} else if (name == "Battle Healing") {
-		return PlayerWheel::getInstant(WheelInstant_t::BATTLE_HEALING);
-	} else if (name == "Positional Tatics") {
-		return PlayerWheel::getInstant(WheelInstant_t::POSITIONAL_TATICS);
-	} else if (name == "Ballistic Mastery") {
-		return PlayerWheel::getInstant(WheelInstant_t::BALLISTIC_MASTERY);
-	} else if (name == "Healing Link") {
-		return PlayerWheel::getInstant(WheelInstant_t::HEALING_LINK);
-	} else if (name == "Runic Mastery") {
-		return PlayerWheel::getInstant(WheelInstant_t::RUNIC_MASTERY);
-	} else if (name == "Focus Mastery") {
-		return PlayerWheel::getInstant(WheelInstant_t::FOCUS_MASTERY);
-	} else if (name == "Beam Mastery") {
-		return PlayerWheel::getStage(WheelStage_t::BEAM_MASTERY);
-	} else if (name == "Combat Mastery") {
-		return PlayerWheel::getStage(WheelStage_t::COMBAT_MASTERY);
-	} else if (name == "Gift of Life") {
-		return PlayerWheel::getStage(WheelStage_t::GIFT_OF_LIFE);
-	} else if (name == "Blessing of the Grove") {
-		return PlayerWheel::getStage(WheelStage_t::BLESSING_OF_THE_GROVE);
-	} else if (name == "Drain Body") {
-		return PlayerWheel::getStage(WheelStage_t::DRAIN_BODY);
-	} else if (name == "Divine Empowerment") {
-		return PlayerWheel::getStage(WheelStage_t::DIVINE_EMPOWERMENT);
-	} else if (name == "Divine Grenade") {
-		return PlayerWheel::getStage(WheelStage_t::DIVINE_GRENADE);
-	} else if (name == "Twin Burst") {
-		return PlayerWheel::getStage(WheelStage_t::TWIN_BURST);
-	} else if (name == "Executioner's Throw") {
-		return PlayerWheel::getStage(WheelStage_t::EXECUTIONERS_THROW);
-	} else if (name == "Avatar of Light") {
-		return PlayerWheel::getStage(WheelStage_t::AVATAR_OF_LIGHT);
-	} else if (name == "Avatar of Nature") {
-		return PlayerWheel::getStage(WheelStage_t::AVATAR_OF_NATURE);
-	} else if (name == "Avatar of Steel") {
-		return PlayerWheel::getStage(WheelStage_t::AVATAR_OF_STEEL);
-	} else if (name == "Avatar of Storm") {
-		return PlayerWheel::getStage(WheelStage_t::AVATAR_OF_STORM);
-	}
-
-	return false;
+	return getStage(name) > 0;
 }
 
 // Wheel of destiny - Specific functions
@@ -3056,7 +3049,7 @@ void PlayerWheel::setWheelBonusData(const PlayerWheelMethodsBonusData &newBonusD
 // Functions used to Manage Combat
 uint8_t PlayerWheel::getBeamAffectedTotal(const CombatDamage &tmpDamage) const {
 	uint8_t beamAffectedTotal = 0; // Removed const
-	if (tmpDamage.runeSpellName == "Beam Mastery" && getInstant("Beam Mastery")) {
+	if (tmpDamage.runeSpellName == "Beam Mastery" && getStage(WheelStage_t::BEAM_MASTERY) > 0) {
 		beamAffectedTotal = 3;
 	}
 	return beamAffectedTotal;
@@ -3071,7 +3064,7 @@ void PlayerWheel::updateBeamMasteryDamage(CombatDamage &tmpDamage, uint8_t &beam
 }
 
 void PlayerWheel::healIfBattleHealingActive() const {
-	if (getInstant("Battle Healing")) {
+	if (getInstant(WheelInstant_t::BATTLE_HEALING)) {
 		CombatDamage damage;
 		damage.primary.value = checkBattleHealingAmount();
 		damage.primary.type = COMBAT_HEALING;
@@ -3123,7 +3116,7 @@ float PlayerWheel::calculateMitigation() const {
 		defenseValue = shield->getDefense();
 		// Wheel of destiny
 		if (shield->getDefense() > 0) {
-			defenseValue += getMajorStatConditional("Combat Mastery", WheelMajor_t::DEFENSE);
+			defenseValue += getMajorStatConditional(WheelStage_t::COMBAT_MASTERY, WheelMajor_t::DEFENSE);
 		}
 	}
 
@@ -329,6 +329,16 @@ public:
 	int32_t getStat(WheelStat_t type) const;
 	int32_t getResistance(CombatType_t type) const;
 	int32_t getMajorStatConditional(const std::string &instant, WheelMajor_t major) const;
+	// The same by type, for the combat, without looking the name up
+	int32_t getMajorStatConditional(WheelInstant_t instant, WheelMajor_t major) const;
+	int32_t getMajorStatConditional(WheelStage_t stage, WheelMajor_t major) const;
+	/**
+	 * @brief The skill bonus of the stats and of the major stats of the active instants, read on every hit.
+	 * @details It is kept per skill and rebuilt after the stages, instants or stats change.
+	 * The avatar bonus depends on the time and is not part of it.
+	 * @param skill The skill, SKILL_MAGLEVEL for the magic level.
+	 */
+	int32_t getSkillBonus(skills_t skill) const;
 	int64_t getOnThinkTimer(WheelOnThink_t type) const;
 	bool getInstant(const std::string name) const;
 	double getMitigationMultiplier() const;
@@ -423,10 +433,11 @@ public:
 	}
 
 	int32_t getSpellBonus(const std::string &spellName, WheelSpellBoost_t boost) const {
-		if (!m_spellsBonuses.contains(spellName)) {
+		const auto it = m_spellsBonuses.find(spellName);
+		if (it == m_spellsBonuses.end()) {
 			return 0;
 		}
-		auto bonus = m_spellsBonuses.at(spellName);
+		const auto &bonus = it->second;
 		switch (boost) {
 			case WheelSpellBoost_t::COOLDOWN:
 				return bonus.decrease.cooldown;
@@ -474,6 +485,9 @@ private:
 	std::array<bool, static_cast<size_t>(WheelInstant_t::TOTAL_COUNT)> m_instant = { false };
 	std::array<int32_t, COMBAT_COUNT> m_resistance = { 0 };
 
+	mutable std::array<int32_t, SKILL_MAGLEVEL + 1> m_skillBonus = { 0 };
+	mutable bool m_skillBonusOutdated = true;
+
 	int32_t m_creaturesNearby = 0;
 	std::map<std::string, WheelSpellGrade_t> m_spellsSelected;
 	std::vector<std::string> m_learnedSpellsSelected;
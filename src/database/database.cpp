@@ -11,12 +11,76 @@
 
 #include "config/configmanager.hpp"
 #include "database/database.hpp"
+#include "database/databasetasks.hpp"
+#include "game/scheduling/dispatcher.hpp"
 #include "lib/di/container.hpp"
 #include "lib/metrics/metrics.hpp"
+#include "lib/metrics/measured_lock.hpp"
+
+namespace {
+	// my_bool in MariaDB Connector/C, bool in MySQL 8
+	using mysql_bool = decltype(MYSQL_BIND::is_null_value);
+
+	bool isIntegerField(enum_field_types type) {
+		switch (type) {
+			case MYSQL_TYPE_TINY:
+			case MYSQL_TYPE_SHORT:
+			case MYSQL_TYPE_INT24:
+			case MYSQL_TYPE_LONG:
+			case MYSQL_TYPE_LONGLONG:
+			case MYSQL_TYPE_YEAR:
+				return true;
+			default:
+				return false;
+		}
+	}
+
+	MYSQL* openHandle(const std::string &host, const std::string &user, const std::string &password, const std::string &database, uint32_t port, const std::string &sock) {
+		// connection handle initialization
+		MYSQL* handle = mysql_init(nullptr);
+		if (!handle) {
+			g_logger().error("Failed to initialize MySQL connection handle.");
+			return nullptr;
+		}
+
+		// automatic reconnect
+		bool reconnect = true;
+		mysql_options(handle, MYSQL_OPT_RECONNECT, &reconnect);
+
+		// connects to database
+		if (!mysql_real_connect(handle, host.c_str(), user.c_str(), password.c_str(), database.c_str(), port, sock.c_str(), 0)) {
+			g_logger().error("MySQL Error Message: {}", mysql_error(handle));
+			mysql_close(handle);
+			return nullptr;
+		}
+		return handle;
+	}
+
+	// How often the replication lag is read, by the thread that needs a replica connection when it is due
+	constexpr int64_t REPLICA_CHECK_INTERVAL = 1000;
+
+	bool isBlobField(enum_field_types type) {
+		switch (type) {
+			case MYSQL_TYPE_TINY_BLOB:
+			case MYSQL_TYPE_MEDIUM_BLOB:
+			case MYSQL_TYPE_LONG_BLOB:
+			case MYSQL_TYPE_BLOB:
+				return true;
+			default:
+				return false;
+		}
+	}
+}
 
 Database::~Database() {
-	if (handle != nullptr) {
-		mysql_close(handle);
+	for (auto &connection : replicaConnections) {
+		connections.emplace_back(std::move(connection));
+	}
+	for (const auto &connection : connections) {
+		for (const auto &[query, stmt] : connection->statements) {
+			mysql_stmt_close(stmt);
+		}
+		mysql_close(connection->handle);
 	}
 }
 
@@ -25,85 +89,321 @@ Database &Database::getInstance() {
 }
 
 bool Database::connect() {
-	return connect(&g_configManager().getString(MYSQL_HOST, __FUNCTION__), &g_configManager().getString(MYSQL_USER, __FUNCTION__), &g_configManager().getString(MYSQL_PASS, __FUNCTION__), &g_configManager().getString(MYSQL_DB, __FUNCTION__), g_configManager().getNumber(SQL_PORT, __FUNCTION__), &g_configManager().getString(MYSQL_SOCK, __FUNCTION__));
+	const auto poolSize = static_cast<uint16_t>(std::max<int32_t>(1, g_configManager().getNumber(MYSQL_POOL_SIZE, __FUNCTION__)));
+	return connect(&g_configManager().getString(MYSQL_HOST, __FUNCTION__), &g_configManager().getString(MYSQL_USER, __FUNCTION__), &g_configManager().getString(MYSQL_PASS, __FUNCTION__), &g_configManager().getString(MYSQL_DB, __FUNCTION__), g_configManager().getNumber(SQL_PORT, __FUNCTION__), &g_configManager().getString(MYSQL_SOCK, __FUNCTION__), poolSize);
 }
 
-bool Database::connect(const std::string* host, const std::string* user, const std::string* password, const std::string* database, uint32_t port, const std::string* sock) {
-	// connection handle initialization
-	handle = mysql_init(nullptr);
-	if (!handle) {
-		g_logger().error("Failed to initialize MySQL connection handle.");
-		return false;
-	}
-
+bool Database::connect(const std::string* host, const std::string* user, const std::string* password, const std::string* database, uint32_t port, const std::string* sock, uint16_t poolSize /* = 1*/) {
 	if (host->empty() || user->empty() || password->empty() || database->empty() || port <= 0) {
 		g_logger().warn("MySQL host, user, password, database or port not provided");
 	}
 
-	// automatic reconnect
-	bool reconnect = true;
-	mysql_options(handle, MYSQL_OPT_RECONNECT, &reconnect);
+	for (uint16_t i = 0; i < poolSize; ++i) {
+		MYSQL* handle = openHandle(*host, *user, *password, *database, port, *sock);
+		if (!handle) {
+			return false;
+		}
 
-	// connects to database
-	if (!mysql_real_connect(handle, host->c_str(), user->c_str(), password->c_str(), database->c_str(), port, sock->c_str(), 0)) {
-		g_logger().error("MySQL Error Message: {}", mysql_error(handle));
-		return false;
+		auto &connection = connections.emplace_back(std::make_unique<Connection>());
+		connection->handle = handle;
+		std::scoped_lock lock(poolMutex);
+		idleConnections.emplace_back(connection.get());
 	}
+	g_logger().debug("MySQL connection pool opened with {} connections", connections.size());
 
 	DBResult_ptr result = storeQuery("SHOW VARIABLES LIKE 'max_allowed_packet'");
 	if (result) {
 		maxPacketSize = result->getNumber<uint64_t>("Value");
 	}
+
+	if (const auto &replicaHost = g_configManager().getString(MYSQL_REPLICA_HOST, __FUNCTION__); !replicaHost.empty()) {
+		const auto replicaPoolSize = static_cast<uint16_t>(std::max<int32_t>(1, g_configManager().getNumber(MYSQL_REPLICA_POOL_SIZE, __FUNCTION__)));
+		connectReplica(replicaHost, g_configManager().getNumber(MYSQL_REPLICA_PORT, __FUNCTION__), replicaPoolSize);
+	}
 	return true;
 }
 
-bool Database::beginTransaction() {
-	if (!executeQuery("BEGIN")) {
-		return false;
+bool Database::connectReplica(const std::string &host, uint32_t port, uint16_t poolSize) {
+	const auto &user = g_configManager().getString(MYSQL_USER, __FUNCTION__);
+	const auto &password = g_configManager().getString(MYSQL_PASS, __FUNCTION__);
+	const auto &database = g_configManager().getString(MYSQL_DB, __FUNCTION__);
+	std::vector<std::unique_ptr<Connection>> opened;
+	for (uint16_t i = 0; i < poolSize; ++i) {
+		MYSQL* handle = openHandle(host, user, password, database, port, "");
+		if (!handle) {
+			g_logger().warn("[Database::connectReplica] - Could not connect to the read replica at {}:{}, every query goes to the primary.", host, port);
+			for (const auto &connection : opened) {
+				mysql_close(connection->handle);
+			}
+			return false;
+		}
+		opened.emplace_back(std::make_unique<Connection>())->handle = handle;
+	}
+
+	std::scoped_lock lock(replicaMutex);
+	for (auto &connection : opened) {
+		idleReplicas.emplace_back(connection.get());
+		replicaConnections.emplace_back(std::move(connection));
+	}
+	g_logger().info("MySQL read replica pool opened with {} connections to {}:{}", replicaConnections.size(), host, port);
+	return true;
+}
+
+Database::LocalConnection &Database::localConnection() {
+	thread_local LocalConnection local;
+	return local;
+}
+
+Database::Connection* Database::acquire() {
+	auto &local = localConnection();
+	if (local.connection) {
+		++local.depth;
+		return local.connection;
 	}
+
+	if (connections.empty()) {
+		return nullptr;
+	}
+
 	metrics::lock_latency measureLock("database");
-	databaseLock.lock();
+	std::unique_lock lock(poolMutex);
+	poolSignal.wait(lock, [this] { return !idleConnections.empty(); });
 	measureLock.stop();
 
+	local.connection = idleConnections.back();
+	local.depth = 1;
+	idleConnections.pop_back();
+	return local.connection;
+}
+
+void Database::release() {
+	auto &local = localConnection();
+	if (!local.connection || --local.depth > 0) {
+		return;
+	}
+
+	{
+		metrics::measured_lock lock(poolMutex, __METHOD_NAME__);
+		idleConnections.emplace_back(local.connection);
+	}
+	local.connection = nullptr;
+	poolSignal.notify_one();
+}
+
+Database::Connection* Database::acquireReplica() {
+	if (replicaConnections.empty() || localConnection().connection) {
+		return nullptr;
+	}
+
+	const auto now = OTSYS_TIME();
+	auto checkedAt = replicaCheckedAt.load();
+	const bool checkDue = now - checkedAt >= REPLICA_CHECK_INTERVAL && replicaCheckedAt.compare_exchange_strong(checkedAt, now);
+	if (!checkDue && !replicaUsable) {
+		return nullptr;
+	}
+
+	Connection* connection;
+	{
+		metrics::lock_latency measureLock("database_replica");
+		std::unique_lock lock(replicaMutex);
+		replicaSignal.wait(lock, [this] { return !idleReplicas.empty(); });
+		measureLock.stop();
+		connection = idleReplicas.back();
+		idleReplicas.pop_back();
+	}
+
+	if (checkDue) {
+		const auto lag = queryReplicaLag(connection->handle);
+		setReplicaUsable(lag >= 0 && lag <= g_configManager().getNumber(MYSQL_REPLICA_MAX_LAG, __FUNCTION__), lag);
+	}
+	if (!replicaUsable) {
+		releaseReplica(connection);
+		return nullptr;
+	}
+	return connection;
+}
+
+void Database::releaseReplica(Connection* connection) {
+	{
+		std::scoped_lock lock(replicaMutex);
+		idleReplicas.emplace_back(connection);
+	}
+	replicaSignal.notify_one();
+}
+
+int64_t Database::queryReplicaLag(MYSQL* handle) const {
+	// SHOW REPLICA STATUS since MySQL 8.0.22 and MariaDB 10.5.1, SHOW SLAVE STATUS before
+	for (const auto* query : { "SHOW REPLICA STATUS", "SHOW SLAVE STATUS" }) {
+		if (mysql_query(handle, query) != 0) {
+			continue;
+		}
+
+		MYSQL_RES* res = mysql_store_result(handle);
+		if (!res) {
+			return -1;
+		}
+
+		// Seconds_Behind_Source on MySQL, Seconds_Behind_Master on MariaDB, NULL while the replication is stopped
+		int64_t lag = -1;
+		if (MYSQL_ROW row = mysql_fetch_row(res)) {
+			const auto* fields = mysql_fetch_fields(res);
+			for (unsigned int i = 0; i < mysql_num_fields(res); ++i) {
+				const std::string_view name(fields[i].name);
+				if ((name == "Seconds_Behind_Source" || name == "Seconds_Behind_Master") && row[i]) {
+					std::from_chars(row[i], row[i] + std::strlen(row[i]), lag);
+				}
+			}
+		}
+		mysql_free_result(res);
+		return lag;
+	}
+
+	g_logger().error("[Database::queryReplicaLag] - MySQL error [{}]: {}", mysql_errno(handle), mysql_error(handle));
+	return -1;
+}
+
+void Database::setReplicaUsable(bool usable, int64_t lag) {
+	if (replicaUsable.exchange(usable) == usable) {
+		return;
+	}
+
+	if (usable) {
+		g_logger().info("[Database::setReplicaUsable] - Read replica is {} seconds behind, the read-only queries go to it.", lag);
+	} else if (lag < 0) {
+		g_logger().warn("[Database::setReplicaUsable] - Read replica is not replicating or failed, the read-only queries go to the primary.");
+	} else {
+		g_logger().warn("[Database::setReplicaUsable] - Read replica is {} seconds behind, the read-only queries go to the primary.", lag);
+	}
+}
+
+uint64_t Database::getLastInsertId() const {
+	return localConnection().lastInsertId;
+}
+
+bool Database::beginTransaction() {
+	// Kept checked out by this thread until commit or rollback
+	if (!acquire()) {
+		g_logger().error("Database not initialized!");
+		return false;
+	}
+
+	if (!executeQuery("BEGIN")) {
+		release();
+		return false;
+	}
 	return true;
 }
 
 bool Database::rollback() {
-	if (!handle) {
+	auto* connection = localConnection().connection;
+	if (!connection) {
 		g_logger().error("Database not initialized!");
 		return false;
 	}
 
-	if (mysql_rollback(handle) != 0) {
-		g_logger().error("Message: {}", mysql_error(handle));
-		databaseLock.unlock();
-		return false;
+	const bool success = mysql_rollback(connection->handle) == 0;
+	if (!success) {
+		g_logger().error("Message: {}", mysql_error(connection->handle));
 	}
 
-	databaseLock.unlock();
-	return true;
+	release();
+	return success;
 }
 
 bool Database::commit() {
-	if (!handle) {
+	auto* connection = localConnection().connection;
+	if (!connection) {
 		g_logger().error("Database not initialized!");
 		return false;
 	}
-	if (mysql_commit(handle) != 0) {
-		g_logger().error("Message: {}", mysql_error(handle));
-		databaseLock.unlock();
-		return false;
+
+	const bool success = mysql_commit(connection->handle) == 0;
+	if (!success) {
+		g_logger().error("Message: {}", mysql_error(connection->handle));
 	}
 
-	databaseLock.unlock();
-	return true;
+	release();
+	return success;
 }
 
 bool Database::isRecoverableError(unsigned int error) const {
 	return error == CR_SERVER_LOST || error == CR_SERVER_GONE_ERROR || error == CR_CONN_HOST_ERROR || error == 1053 /*ER_SERVER_SHUTDOWN*/ || error == CR_CONNECTION_ERROR;
 }
 
+Database::SlowQueryTimer::SlowQueryTimer(Database &db, std::string_view query, bool explainable) :
+	db(db), query(query), threshold(g_configManager().getNumber(SLOW_QUERY_THRESHOLD, __FUNCTION__)), explainable(explainable) {
+	if (threshold.count() > 0) {
+		start = std::chrono::steady_clock::now();
+	}
+}
+
+Database::SlowQueryTimer::~SlowQueryTimer() {
+	if (threshold.count() <= 0) {
+		return;
+	}
+
+	const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+	if (elapsed >= threshold) {
+		db.onSlowQuery(query, elapsed, explainable);
+	}
+}
+
+void Database::onSlowQuery(std::string_view query, std::chrono::milliseconds elapsed, bool explainable) {
+	g_logger().warn("[Database::onSlowQuery] - Query of {} ms, for {}: {}", elapsed.count(), DBQueryOrigin::current(), query);
+	g_metrics().addCounter("slow_queries", 1, { { "truncated_query", std::string(query.substr(0, 50)) } });
+
+	if (explainable && g_configManager().getBoolean(SLOW_QUERY_EXPLAIN, __FUNCTION__)) {
+		explain(query);
+	}
+}
+
+void Database::explain(std::string_view query) {
+	const auto start = query.find_first_not_of(" \t\r\n(");
+	if (start == std::string_view::npos) {
+		return;
+	}
+
+	// EXPLAIN also takes INSERT and REPLACE, their plans are only the one of a SELECT inside, which is rare here
+	const auto verb = asLowerCaseString(std::string(query.substr(start, 6)));
+	if (verb != "select" && verb != "update" && verb != "delete") {
+		return;
+	}
+
+	{
+		std::scoped_lock lock(explainedMutex);
+		// Bounded, a query explained long ago may be explained again
+		if (explained.size() >= 1000) {
+			explained.clear();
+		}
+		if (!explained.emplace(query).second) {
+			return;
+		}
+	}
+
+	g_databaseTasks().store(fmt::format("EXPLAIN {}", query), [query = std::string(query)](DBResult_ptr result, bool) {
+		if (!result) {
+			g_logger().warn("[Database::explain] - No plan for the slow query: {}", query);
+			return;
+		}
+
+		g_logger().warn("[Database::explain] - Plan of the slow query: {}", query);
+		do {
+			// A type of ALL is a full scan, no index was used
+			g_logger().warn("[Database::explain] - table: {}, type: {}, possible keys: {}, key: {}, rows: {}, extra: {}", result->getString("table"), result->getString("type"), result->getString("possible_keys"), result->getString("key"), result->getString("rows"), result->getString("Extra"));
+		} while (result->next());
+	});
+}
+
 bool Database::retryQuery(const std::string_view &query, int retries) {
+	ConnectionGuard connection(*this);
+	if (!connection.get()) {
+		g_logger().error("Database not initialized!");
+		return false;
+	}
+	return retryQuery(connection.get()->handle, query, retries);
+}
+
+bool Database::retryQuery(MYSQL* handle, const std::string_view &query, int retries) {
 	while (retries > 0 && mysql_query(handle, query.data()) != 0) {
 		g_logger().error("Query: {}", query.substr(0, 256));
 		g_logger().error("MySQL error [{}]: {}", mysql_errno(handle), mysql_error(handle));
@@ -122,48 +422,75 @@ bool Database::retryQuery(const std::string_view &query, int retries) {
 }
 
 bool Database::executeQuery(const std::string_view &query) {
-	if (!handle) {
-		g_logger().error("Database not initialized!");
-		return false;
+	if (auto* capture = DBCapture::current()) {
+		capture->add(std::string(query));
+		return true;
 	}
 
 	g_logger().trace("Executing Query: {}", query);
 
-	metrics::lock_latency measureLock("database");
-	std::scoped_lock lock { databaseLock };
-	measureLock.stop();
+	ConnectionGuard connection(*this);
+	if (!connection.get()) {
+		g_logger().error("Database not initialized!");
+		return false;
+	}
 
+	MYSQL* handle = connection.get()->handle;
 	metrics::query_latency measure(query.substr(0, 50));
-	bool success = retryQuery(query, 10);
+	SlowQueryTimer slowQuery(*this, query, true);
+	bool success = retryQuery(handle, query, 10);
 	mysql_free_result(mysql_store_result(handle));
+	if (success) {
+		localConnection().lastInsertId = static_cast<uint64_t>(mysql_insert_id(handle));
+	}
 
 	return success;
 }
 
 DBResult_ptr Database::storeQuery(const std::string_view &query) {
-	if (!handle) {
-		g_logger().error("Database not initialized!");
-		return nullptr;
+	if (auto* prefetch = DBPrefetch::current()) {
+		if (DBResult_ptr result; prefetch->take(query, result)) {
+			return result;
+		}
 	}
+
 	g_logger().trace("Storing Query: {}", query);
 
-	metrics::lock_latency measureLock("database");
-	std::scoped_lock lock { databaseLock };
-	measureLock.stop();
+	bool failed = false;
+	if (DBReadOnly::isActive()) {
+		if (auto* replica = acquireReplica()) {
+			// Not retried there, a failed read goes to the primary until the next lag check
+			auto result = storeQuery(replica->handle, query, false, failed);
+			releaseReplica(replica);
+			if (!failed) {
+				return result;
+			}
+			setReplicaUsable(false, -1);
+		}
+	}
 
+	ConnectionGuard connection(*this);
+	if (!connection.get()) {
+		g_logger().error("Database not initialized!");
+		return nullptr;
+	}
+	return storeQuery(connection.get()->handle, query, true, failed);
+}
+
+DBResult_ptr Database::storeQuery(MYSQL* handle, const std::string_view &query, bool retry, bool &failed) {
 	metrics::query_latency measure(query.substr(0, 50));
-retry:
-	if (mysql_query(handle, query.data()) != 0) {
+	SlowQueryTimer slowQuery(*this, query, true);
+	while (mysql_query(handle, query.data()) != 0) {
 		g_logger().error("Query: {}", query);
 		g_logger().error("Message: {}", mysql_error(handle));
-		if (!isRecoverableError(mysql_errno(handle))) {
+		if (!retry || !isRecoverableError(mysql_errno(handle))) {
+			failed = true;
 			return nullptr;
 		}
 		std::this_thread::sleep_for(std::chrono::seconds(1));
-		goto retry;
 	}
 
-	// Retrieving results of query
+	// Retrieving results of query, the result is buffered so the connection can go back to the pool
 	MYSQL_RES* res = mysql_store_result(handle);
 	if (res != nullptr) {
 		DBResult_ptr result = std::make_shared<DBResult>(res);
@@ -175,6 +502,236 @@ retry:
 	return nullptr;
 }
 
+std::vector<DBResult_ptr> Database::storeQueries(const std::vector<std::string> &queries) {
+	if (queries.empty()) {
+		return {};
+	}
+
+	const auto query = fmt::format("{}", fmt::join(queries, ";"));
+	g_logger().trace("Storing Queries: {}", query);
+
+	ConnectionGuard connection(*this);
+	if (!connection.get()) {
+		g_logger().error("Database not initialized!");
+		return {};
+	}
+
+	MYSQL* handle = connection.get()->handle;
+	metrics::query_latency measure(std::string_view(query).substr(0, 50));
+	SlowQueryTimer slowQuery(*this, query, false);
+	// Only enabled for this query, everything else keeps running one statement per query
+	if (mysql_set_server_option(handle, MYSQL_OPTION_MULTI_STATEMENTS_ON) != 0) {
+		g_logger().error("Message: {}", mysql_error(handle));
+		return {};
+	}
+
+	std::vector<DBResult_ptr> results;
+	results.reserve(queries.size());
+	if (mysql_real_query(handle, query.data(), static_cast<unsigned long>(query.size())) == 0) {
+		int status = 0;
+		do {
+			MYSQL_RES* res = mysql_store_result(handle);
+			DBResult_ptr result = res ? std::make_shared<DBResult>(res) : nullptr;
+			results.emplace_back(result && result->hasNext() ? std::move(result) : nullptr);
+		} while ((status = mysql_next_result(handle)) == 0);
+
+		if (status > 0) {
+			g_logger().error("Query: {}", queries[std::min(results.size(), queries.size() - 1)]);
+			g_logger().error("Message: {}", mysql_error(handle));
+			results.clear();
+		}
+	} else {
+		g_logger().error("Query: {}", query.substr(0, 256));
+		g_logger().error("Message: {}", mysql_error(handle));
+	}
+
+	mysql_set_server_option(handle, MYSQL_OPTION_MULTI_STATEMENTS_OFF);
+	if (results.size() != queries.size()) {
+		return {};
+	}
+	return results;
+}
+
+MYSQL_STMT* Database::getStatement(Connection &connection, const std::string &query, unsigned int &error) {
+	if (auto it = connection.statements.find(query); it != connection.statements.end()) {
+		return it->second;
+	}
+
+	MYSQL_STMT* stmt = mysql_stmt_init(connection.handle);
+	if (!stmt) {
+		error = mysql_errno(connection.handle);
+		g_logger().error("Failed to initialize MySQL statement handle: {}", mysql_error(connection.handle));
+		return nullptr;
+	}
+
+	if (mysql_stmt_prepare(stmt, query.data(), static_cast<unsigned long>(query.size())) != 0) {
+		error = mysql_stmt_errno(stmt);
+		g_logger().error("Statement: {}", query.substr(0, 256));
+		g_logger().error("MySQL error [{}]: {}", error, mysql_stmt_error(stmt));
+		mysql_stmt_close(stmt);
+		return nullptr;
+	}
+
+	// Lets the stored result report the longest value of each column, the result buffers are sized from it
+	mysql_bool updateMaxLength = 1;
+	mysql_stmt_attr_set(stmt, STMT_ATTR_UPDATE_MAX_LENGTH, &updateMaxLength);
+
+	connection.statements.emplace(query, stmt);
+	return stmt;
+}
+
+void Database::dropStatement(Connection &connection, const std::string &query) {
+	if (auto it = connection.statements.find(query); it != connection.statements.end()) {
+		mysql_stmt_close(it->second);
+		connection.statements.erase(it);
+	}
+}
+
+MYSQL_STMT* Database::runStatement(Connection &connection, const DBStatement &statement, int retries /* = 10*/) {
+	// The bound values are read from the statement itself, nothing is copied
+	std::vector<MYSQL_BIND> binds(statement.params.size());
+	for (size_t i = 0; i < binds.size(); ++i) {
+		auto &bind = binds[i];
+		std::visit(
+			[&bind](const auto &value) {
+				using T = std::decay_t<decltype(value)>;
+				if constexpr (std::is_same_v<T, std::monostate>) {
+					bind.buffer_type = MYSQL_TYPE_NULL;
+				} else if constexpr (std::is_same_v<T, std::string>) {
+					bind.buffer_type = MYSQL_TYPE_STRING;
+					bind.buffer = const_cast<char*>(value.data());
+					bind.buffer_length = static_cast<unsigned long>(value.size());
+				} else if constexpr (std::is_same_v<T, double>) {
+					bind.buffer_type = MYSQL_TYPE_DOUBLE;
+					bind.buffer = const_cast<double*>(&value);
+				} else {
+					bind.buffer_type = MYSQL_TYPE_LONGLONG;
+					bind.buffer = const_cast<T*>(&value);
+					bind.is_unsigned = std::is_same_v<T, uint64_t>;
+				}
+			},
+			statement.params[i]
+		);
+	}
+
+	for (int attempts = retries; attempts > 0; --attempts) {
+		unsigned int error = 0;
+		MYSQL_STMT* stmt = getStatement(connection, statement.query, error);
+		if (stmt) {
+			if (mysql_stmt_param_count(stmt) != binds.size()) {
+				g_logger().error("Statement: {}", statement.query.substr(0, 256));
+				g_logger().error("Statement expects {} values, {} were bound", mysql_stmt_param_count(stmt), binds.size());
+				return nullptr;
+			}
+
+			if ((binds.empty() || mysql_stmt_bind_param(stmt, binds.data()) == 0) && mysql_stmt_execute(stmt) == 0) {
+				return stmt;
+			}
+
+			error = mysql_stmt_errno(stmt);
+			g_logger().error("Statement: {}", statement.query.substr(0, 256));
+			g_logger().error("MySQL error [{}]: {}", error, mysql_stmt_error(stmt));
+
+			// Statements do not survive a reconnect, it is prepared again on the next try
+			dropStatement(connection, statement.query);
+			if (error == 1243 /*ER_UNKNOWN_STMT_HANDLER*/ || error == 1615 /*ER_NEED_REPREPARE*/) {
+				continue;
+			}
+		}
+
+		if (!isRecoverableError(error)) {
+			return nullptr;
+		}
+		if (attempts > 1) {
+			std::this_thread::sleep_for(std::chrono::seconds(1));
+		}
+	}
+
+	g_logger().error("Statement {} failed after {} retries.", statement.query.substr(0, 256), retries);
+	return nullptr;
+}
+
+bool Database::executeQuery(const DBStatement &statement) {
+	if (auto* capture = DBCapture::current()) {
+		capture->add(statement);
+		return true;
+	}
+
+	g_logger().trace("Executing Statement: {}", statement.query);
+
+	ConnectionGuard connection(*this);
+	if (!connection.get()) {
+		g_logger().error("Database not initialized!");
+		return false;
+	}
+
+	metrics::query_latency measure(std::string_view(statement.query).substr(0, 50));
+	// The values are bound with placeholders, there is no query text to explain
+	SlowQueryTimer slowQuery(*this, statement.query, false);
+	MYSQL_STMT* stmt = runStatement(*connection.get(), statement);
+	if (!stmt) {
+		return false;
+	}
+
+	localConnection().lastInsertId = static_cast<uint64_t>(mysql_stmt_insert_id(stmt));
+	mysql_stmt_free_result(stmt);
+	return true;
+}
+
+DBResult_ptr Database::storeQuery(const DBStatement &statement) {
+	g_logger().trace("Storing Statement: {}", statement.query);
+
+	bool failed = false;
+	if (DBReadOnly::isActive()) {
+		if (auto* replica = acquireReplica()) {
+			auto result = storeStatement(*replica, statement, 1, failed);
+			releaseReplica(replica);
+			if (!failed) {
+				return result;
+			}
+			setReplicaUsable(false, -1);
+		}
+	}
+
+	ConnectionGuard connection(*this);
+	if (!connection.get()) {
+		g_logger().error("Database not initialized!");
+		return nullptr;
+	}
+	return storeStatement(*connection.get(), statement, 10, failed);
+}
+
+DBResult_ptr Database::storeStatement(Connection &connection, const DBStatement &statement, int retries, bool &failed) {
+	metrics::query_latency measure(std::string_view(statement.query).substr(0, 50));
+	SlowQueryTimer slowQuery(*this, statement.query, false);
+	MYSQL_STMT* stmt = runStatement(connection, statement, retries);
+	if (!stmt) {
+		failed = true;
+		return nullptr;
+	}
+
+	MYSQL_RES* metadata = mysql_stmt_result_metadata(stmt);
+	if (!metadata) {
+		return nullptr;
+	}
+
+	if (mysql_stmt_store_result(stmt) != 0) {
+		g_logger().error("Statement: {}", statement.query.substr(0, 256));
+		g_logger().error("MySQL error [{}]: {}", mysql_stmt_errno(stmt), mysql_stmt_error(stmt));
+		mysql_free_result(metadata);
+		failed = true;
+		return nullptr;
+	}
+
+	DBResult_ptr result = std::make_shared<DBResult>(stmt, metadata);
+	mysql_free_result(metadata);
+	mysql_stmt_free_result(stmt);
+	if (!result->hasNext()) {
+		return nullptr;
+	}
+	return result;
+}
+
 std::string Database::escapeString(const std::string &s) const {
 	std::string::size_type len = s.length();
 	auto length = static_cast<uint32_t>(len);
@@ -194,7 +751,8 @@ std::string Database::escapeBlob(const char* s, uint32_t length) const {
 
 	if (length != 0) {
 		std::string output(maxLength, '\0');
-		size_t escapedLength = mysql_real_escape_string(handle, &output[0], s, length);
+		// Only reads the character set of the connection, any of them will do
+		size_t escapedLength = connections.empty() ? mysql_escape_string(&output[0], s, length) : mysql_real_escape_string(connections.front()->handle, &output[0], s, length);
 		output.resize(escapedLength);
 		escaped.append(output);
 	}
@@ -215,8 +773,93 @@ DBResult::DBResult(MYSQL_RES* res) {
 	row = mysql_fetch_row(handle);
 }
 
+DBResult::DBResult(MYSQL_STMT* stmt, MYSQL_RES* metadata) {
+	columns = mysql_num_fields(metadata);
+
+	const MYSQL_FIELD* fields = mysql_fetch_fields(metadata);
+	columnNames.reserve(columns);
+	for (size_t i = 0; i < columns; i++) {
+		columnNames.emplace_back(fields[i].name, fields[i].name_length);
+	}
+	for (size_t i = 0; i < columns; i++) {
+		listNames[columnNames[i]] = i;
+	}
+
+	std::vector<MYSQL_BIND> binds(columns);
+	std::vector<int64_t> integers(columns);
+	std::vector<double> reals(columns);
+	std::vector<std::string> buffers(columns);
+	std::vector<unsigned long> lengths(columns);
+	std::unique_ptr<mysql_bool[]> nulls(new mysql_bool[columns]());
+	for (size_t i = 0; i < columns; i++) {
+		auto &bind = binds[i];
+		bind.length = &lengths[i];
+		bind.is_null = &nulls[i];
+		if (isIntegerField(fields[i].type)) {
+			bind.buffer_type = MYSQL_TYPE_LONGLONG;
+			bind.buffer = &integers[i];
+			bind.is_unsigned = (fields[i].flags & UNSIGNED_FLAG) != 0;
+		} else if (fields[i].type == MYSQL_TYPE_FLOAT || fields[i].type == MYSQL_TYPE_DOUBLE) {
+			bind.buffer_type = MYSQL_TYPE_DOUBLE;
+			bind.buffer = &reals[i];
+		} else {
+			// Longer values are fetched again below, max_length is not reported for every type
+			buffers[i].resize(std::max<unsigned long>(fields[i].max_length, 64));
+			bind.buffer_type = isBlobField(fields[i].type) ? MYSQL_TYPE_BLOB : MYSQL_TYPE_STRING;
+			bind.buffer = buffers[i].data();
+			bind.buffer_length = static_cast<unsigned long>(buffers[i].size());
+		}
+	}
+
+	if (mysql_stmt_bind_result(stmt, binds.data()) != 0) {
+		g_logger().error("MySQL error [{}]: {}", mysql_stmt_errno(stmt), mysql_stmt_error(stmt));
+		return;
+	}
+
+	values.reserve(static_cast<size_t>(mysql_stmt_num_rows(stmt)) * columns);
+	while (true) {
+		const int status = mysql_stmt_fetch(stmt);
+		if (status == MYSQL_NO_DATA) {
+			break;
+		}
+		if (status != 0 && status != MYSQL_DATA_TRUNCATED) {
+			g_logger().error("MySQL error [{}]: {}", mysql_stmt_errno(stmt), mysql_stmt_error(stmt));
+			break;
+		}
+
+		for (size_t i = 0; i < columns; i++) {
+			auto &value = values.emplace_back();
+			if (nulls[i]) {
+				continue;
+			}
+
+			const auto &bind = binds[i];
+			if (bind.buffer_type == MYSQL_TYPE_LONGLONG) {
+				value.kind = bind.is_unsigned ? BinaryValue::Kind::Unsigned : BinaryValue::Kind::Signed;
+				value.integer = integers[i];
+			} else if (bind.buffer_type == MYSQL_TYPE_DOUBLE) {
+				value.kind = BinaryValue::Kind::Real;
+				value.real = reals[i];
+			} else if (lengths[i] > bind.buffer_length) {
+				value.kind = BinaryValue::Kind::Bytes;
+				value.bytes.resize(lengths[i]);
+				MYSQL_BIND column {};
+				column.buffer_type = bind.buffer_type;
+				column.buffer = value.bytes.data();
+				column.buffer_length = lengths[i];
+				mysql_stmt_fetch_column(stmt, &column, static_cast<unsigned int>(i), 0);
+			} else {
+				value.kind = BinaryValue::Kind::Bytes;
+				value.bytes.assign(buffers[i].data(), lengths[i]);
+			}
+		}
+	}
+}
+
 DBResult::~DBResult() {
-	mysql_free_result(handle);
+	if (handle) {
+		mysql_free_result(handle);
+	}
 }
 
 std::string DBResult::getString(const std::string &s) const {
@@ -225,6 +868,23 @@ std::string DBResult::getString(const std::string &s) const {
 		g_logger().error("Column '{}' does not exist in result set", s);
 		return std::string();
 	}
+
+	if (!handle) {
+		const auto &value = values[current + it->second];
+		switch (value.kind) {
+			case BinaryValue::Kind::Signed:
+				return std::to_string(value.integer);
+			case BinaryValue::Kind::Unsigned:
+				return std::to_string(static_cast<uint64_t>(value.integer));
+			case BinaryValue::Kind::Real:
+				return fmt::format("{}", value.real);
+			case BinaryValue::Kind::Bytes:
+				return value.bytes;
+			default:
+				return std::string();
+		}
+	}
+
 	if (row[it->second] == nullptr) {
 		return std::string();
 	}
@@ -239,6 +899,16 @@ const char* DBResult::getStream(const std::string &s, unsigned long &size) const
 		return nullptr;
 	}
 
+	if (!handle) {
+		const auto &value = values[current + it->second];
+		if (value.kind != BinaryValue::Kind::Bytes) {
+			size = 0;
+			return nullptr;
+		}
+		size = static_cast<unsigned long>(value.bytes.size());
+		return value.bytes.data();
+	}
+
 	if (row[it->second] == nullptr) {
 		size = 0;
 		return nullptr;
@@ -269,14 +939,25 @@ int8_t DBResult::getInt8FromString(const std::string &string, const std::string
 }
 
 size_t DBResult::countResults() const {
+	if (!handle) {
+		return columns == 0 ? 0 : values.size() / columns;
+	}
 	return static_cast<size_t>(mysql_num_rows(handle));
 }
 
 bool DBResult::hasNext() const {
+	if (!handle) {
+		return current < values.size();
+	}
 	return row != nullptr;
 }
 
 bool DBResult::next() {
+	if (!handle && columns != 0) {
+		current += columns;
+		return current < values.size();
+	}
+
 	if (!handle) {
 		g_logger().error("Database not initialized!");
 		return false;
@@ -290,12 +971,26 @@ DBInsert::DBInsert(std::string insertQuery) :
 	this->length = this->query.length();
 }
 
+void DBInsert::replace(std::string table, std::string ownerColumn, uint64_t owner, uint64_t* rowsHash) {
+	replaceTable = std::move(table);
+	replaceColumn = std::move(ownerColumn);
+	replaceOwner = owner;
+	savedHash = rowsHash;
+	batch = DBBatch::current();
+}
+
+void DBInsert::capture(std::vector<std::string> &queries) {
+	captured = &queries;
+	batch = nullptr;
+}
+
 bool DBInsert::addRow(std::string_view row) {
 	const size_t rowLength = row.length();
 	length += rowLength;
 	auto max_packet_size = Database::getInstance().getMaxPacketSize();
 
-	if (length > max_packet_size && !execute()) {
+	// A batch splits the rows itself when it writes them
+	if (!batch && length > max_packet_size && !execute()) {
 		return false;
 	}
 
@@ -314,6 +1009,19 @@ bool DBInsert::addRow(std::string_view row) {
 	return true;
 }
 
+bool DBInsert::addValues(std::string_view rows) {
+	length += rows.length();
+	if (length > Database::getInstance().getMaxPacketSize() && !execute()) {
+		return false;
+	}
+
+	if (!values.empty()) {
+		values.push_back(',');
+	}
+	values.append(rows);
+	return true;
+}
+
 bool DBInsert::addRow(std::ostringstream &row) {
 	bool ret = addRow(row.str());
 	row.str(std::string());
@@ -325,6 +1033,47 @@ void DBInsert::upsert(const std::vector<std::string> &columns) {
 }
 
 bool DBInsert::execute() {
+	if (savedHash) {
+		// Before the first write every row is still in values, after it only the rest is, so nothing is known
+		uint64_t hash = 0;
+		if (!ownerDeleted) {
+			hash = std::max<uint64_t>(std::hash<std::string_view> {}(values), 1);
+			if (hash == *savedHash && (batch || !DBBatch::isPending(replaceTable, replaceOwner))) {
+				values.clear();
+				length = query.length();
+				return true;
+			}
+		}
+		*savedHash = hash;
+	}
+
+	if (batch) {
+		batch->add(*this);
+		values.clear();
+		length = query.length();
+		return true;
+	}
+
+	const auto run = [this](std::string statement) {
+		if (captured) {
+			captured->emplace_back(std::move(statement));
+			return true;
+		}
+		return Database::getInstance().executeQuery(statement);
+	};
+
+	if (!replaceTable.empty() && !ownerDeleted) {
+		if (auto* capture = DBCapture::current(); capture && !captured) {
+			capture->claim(replaceOwner);
+		} else if (!captured && !DBBatch::drop(replaceOwner)) {
+			return false;
+		}
+		if (!run(fmt::format("DELETE FROM `{}` WHERE `{}` = {}", replaceTable, replaceColumn, replaceOwner))) {
+			return false;
+		}
+		ownerDeleted = true;
+	}
+
 	if (values.empty()) {
 		return true;
 	}
@@ -365,10 +1114,309 @@ bool DBInsert::execute() {
 
 		std::ostringstream query;
 		query << baseQuery << " " << batchValues << upsertQuery;
-		if (!Database::getInstance().executeQuery(query.str())) {
+		if (!run(query.str())) {
 			return false;
 		}
 	}
 
+	values.clear();
+	length = query.length();
+	return true;
+}
+
+namespace {
+	std::mutex &batchRegistryMutex() {
+		static std::mutex mutex;
+		return mutex;
+	}
+
+	std::vector<DBBatch*> &batchRegistry() {
+		static std::vector<DBBatch*> registry;
+		return registry;
+	}
+
+	DBBatch*& currentBatch() {
+		thread_local DBBatch* batch = nullptr;
+		return batch;
+	}
+
+	DBCapture*& currentCapture() {
+		thread_local DBCapture* capture = nullptr;
+		return capture;
+	}
+
+	DBPrefetch*& currentPrefetch() {
+		thread_local DBPrefetch* prefetch = nullptr;
+		return prefetch;
+	}
+
+	uint32_t &readOnlyDepth() {
+		thread_local uint32_t depth = 0;
+		return depth;
+	}
+
+	DBQueryOrigin*& currentOrigin() {
+		thread_local DBQueryOrigin* origin = nullptr;
+		return origin;
+	}
+
+	// Owners per DELETE ... IN statement
+	constexpr size_t BATCH_DELETE_CHUNK = 1000;
+}
+
+DBBatch::DBBatch() :
+	previous(currentBatch()) {
+	currentBatch() = this;
+	std::scoped_lock lock(batchRegistryMutex());
+	batchRegistry().emplace_back(this);
+}
+
+DBBatch::~DBBatch() {
+	currentBatch() = previous;
+	std::scoped_lock lock(batchRegistryMutex());
+	std::erase(batchRegistry(), this);
+}
+
+DBBatch* DBBatch::current() {
+	return currentBatch();
+}
+
+size_t DBBatch::getOwnerCount() const {
+	std::scoped_lock lock(mutex);
+	phmap::flat_hash_set<uint64_t> owners;
+	for (const auto &[name, table] : tables) {
+		for (const auto &[owner, rows] : table.rows) {
+			owners.emplace(owner);
+		}
+	}
+	return owners.size();
+}
+
+void DBBatch::add(const DBInsert &insert) {
+	std::scoped_lock lock(mutex);
+	// Already written directly, by a save that is at least as recent
+	if (claimedOwners.contains(insert.replaceOwner)) {
+		return;
+	}
+
+	auto &table = tables[insert.replaceTable];
+	if (table.insertQuery.empty()) {
+		table.ownerColumn = insert.replaceColumn;
+		table.insertQuery = insert.query;
+		table.upsertColumns = insert.upsertColumns;
+	}
+	table.rows[insert.replaceOwner] = insert.values;
+}
+
+void DBBatch::claim(uint64_t owner) {
+	std::scoped_lock registryLock(batchRegistryMutex());
+	for (auto* batch : batchRegistry()) {
+		std::unique_lock lock(batch->mutex);
+		batch->flushed.wait(lock, [batch, owner] { return !batch->flushingOwners.contains(owner); });
+		batch->claimedOwners.emplace(owner);
+		for (auto &[name, table] : batch->tables) {
+			table.rows.erase(owner);
+		}
+	}
+}
+
+bool DBBatch::drop(uint64_t owner) {
+	std::scoped_lock registryLock(batchRegistryMutex());
+	// Checked in every batch first, the rows of a failed drop stay in their batches
+	for (auto* batch : batchRegistry()) {
+		std::scoped_lock lock(batch->mutex);
+		if (batch->flushingOwners.contains(owner)) {
+			g_logger().error("[{}] - Rows of owner {} are being flushed, it must be claimed before the transaction", __FUNCTION__, owner);
+			return false;
+		}
+	}
+	for (auto* batch : batchRegistry()) {
+		std::scoped_lock lock(batch->mutex);
+		batch->claimedOwners.emplace(owner);
+		for (auto &[name, table] : batch->tables) {
+			table.rows.erase(owner);
+		}
+	}
+	return true;
+}
+
+bool DBBatch::isPending(const std::string &table, uint64_t owner) {
+	std::scoped_lock registryLock(batchRegistryMutex());
+	for (auto* batch : batchRegistry()) {
+		std::scoped_lock lock(batch->mutex);
+		if (batch->flushingOwners.contains(owner)) {
+			return true;
+		}
+		if (auto it = batch->tables.find(table); it != batch->tables.end() && it->second.rows.contains(owner)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+bool DBBatch::flush() {
+	phmap::flat_hash_map<std::string, Table> pending;
+	{
+		std::scoped_lock lock(mutex);
+		pending.swap(tables);
+		for (const auto &[name, table] : pending) {
+			for (const auto &[owner, rows] : table.rows) {
+				flushingOwners.emplace(owner);
+			}
+		}
+	}
+
+	const bool success = DBTransaction::executeWithinTransaction([&pending]() {
+		return std::ranges::all_of(pending, [](const auto &entry) {
+			return write(entry.first, entry.second);
+		});
+	});
+
+	{
+		std::scoped_lock lock(mutex);
+		flushingOwners.clear();
+	}
+	flushed.notify_all();
+	return success;
+}
+
+bool DBBatch::write(const std::string &name, const Table &table) {
+	if (table.rows.empty()) {
+		return true;
+	}
+
+	std::vector<uint64_t> owners;
+	owners.reserve(table.rows.size());
+	for (const auto &[owner, rows] : table.rows) {
+		owners.emplace_back(owner);
+	}
+
+	for (size_t i = 0; i < owners.size(); i += BATCH_DELETE_CHUNK) {
+		const auto last = std::min(owners.size(), i + BATCH_DELETE_CHUNK);
+		auto deleteQuery = fmt::format("DELETE FROM `{}` WHERE `{}` IN ({})", name, table.ownerColumn, fmt::join(owners.begin() + i, owners.begin() + last, ","));
+		if (!Database::getInstance().executeQuery(deleteQuery)) {
+			return false;
+		}
+	}
+
+	DBInsert insert(table.insertQuery);
+	insert.upsertColumns = table.upsertColumns;
+	for (const auto &[owner, rows] : table.rows) {
+		if (!rows.empty() && !insert.addValues(rows)) {
+			return false;
+		}
+	}
+	return insert.execute();
+}
+
+DBCapture::Scope::Scope(DBCapture &capture) :
+	previous(currentCapture()) {
+	currentCapture() = &capture;
+}
+
+DBCapture::Scope::~Scope() {
+	currentCapture() = previous;
+}
+
+DBCapture* DBCapture::current() {
+	return currentCapture();
+}
+
+DBReadOnly::DBReadOnly() {
+	++readOnlyDepth();
+}
+
+DBReadOnly::~DBReadOnly() {
+	--readOnlyDepth();
+}
+
+bool DBReadOnly::isActive() {
+	return readOnlyDepth() > 0;
+}
+
+DBQueryOrigin::DBQueryOrigin(std::string origin) :
+	origin(std::move(origin)), previous(currentOrigin()) {
+	currentOrigin() = this;
+}
+
+DBQueryOrigin::~DBQueryOrigin() {
+	currentOrigin() = previous;
+}
+
+std::string DBQueryOrigin::current() {
+	// Empty when it was carried while the slow queries were not logged
+	if (const auto* origin = currentOrigin(); origin && !origin->origin.empty()) {
+		return origin->origin;
+	}
+	return std::string(g_dispatcher().context().getName());
+}
+
+bool DBQueryOrigin::isNeeded() {
+	return g_configManager().getNumber(SLOW_QUERY_THRESHOLD, __FUNCTION__) > 0;
+}
+
+void DBCapture::add(std::string query) {
+	writes.emplace_back(std::move(query));
+}
+
+void DBCapture::add(const DBStatement &statement) {
+	writes.emplace_back(statement);
+}
+
+void DBCapture::claim(uint64_t owner) {
+	if (std::ranges::find(claimedOwners, owner) == claimedOwners.end()) {
+		claimedOwners.emplace_back(owner);
+	}
+}
+
+bool DBCapture::execute() const {
+	// Before the first write, no row of the transaction is locked yet
+	for (const auto owner : claimedOwners) {
+		DBBatch::claim(owner);
+	}
+
+	auto &db = Database::getInstance();
+	for (const auto &write : writes) {
+		const bool success = std::visit([&db](const auto &query) { return db.executeQuery(query); }, write);
+		if (!success) {
+			return false;
+		}
+	}
+	return true;
+}
+
+DBPrefetch::Scope::Scope(DBPrefetch &prefetch) :
+	previous(currentPrefetch()) {
+	currentPrefetch() = &prefetch;
+}
+
+DBPrefetch::Scope::~Scope() {
+	currentPrefetch() = previous;
+}
+
+DBPrefetch* DBPrefetch::current() {
+	return currentPrefetch();
+}
+
+bool DBPrefetch::fetch(const std::vector<std::string> &queries) {
+	auto fetched = Database::getInstance().storeQueries(queries);
+	if (fetched.empty()) {
+		return false;
+	}
+
+	for (size_t i = 0; i < queries.size(); ++i) {
+		results.try_emplace(queries[i], std::move(fetched[i]));
+	}
+	return true;
+}
+
+bool DBPrefetch::take(std::string_view query, DBResult_ptr &result) {
+	const auto it = results.find(std::string(query));
+	if (it == results.end()) {
+		return false;
+	}
+
+	result = std::move(it->second);
+	results.erase(it);
 	return true;
 }
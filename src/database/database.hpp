@@ -14,12 +14,30 @@
 
 #ifndef USE_PRECOMPILED_HEADERS
 	#include <mysql/mysql.h>
+	#include <charconv>
+	#include <condition_variable>
 	#include <mutex>
+	#include <variant>
+	#include <parallel_hashmap/phmap.h>
 #endif
 
 class DBResult;
 using DBResult_ptr = std::shared_ptr<DBResult>;
+class DBStatement;
+class DBBatch;
+class DBCapture;
+class DBPrefetch;
+class DBQueryOrigin;
+class DBReadOnly;
 
+/**
+ * MySQL access over a pool of connections.
+ * Every query checks a connection out for the calling thread and returns it when done,
+ * a thread inside a transaction (or a nested call) keeps the connection it already holds,
+ * so the whole transaction runs on one connection while other threads use the rest of the pool.
+ * With mysqlReplicaHost set, the reads under a DBReadOnly go to a second pool on the replica
+ * while it is at most mysqlReplicaMaxLag seconds behind.
+ */
 class Database {
 public:
 	static const size_t MAX_QUERY_SIZE = 8 * 1024 * 1024; // 8 Mb -- half the default MySQL max_allowed_packet size
@@ -35,20 +53,37 @@ public:
 
 	bool connect();
 
-	bool connect(const std::string* host, const std::string* user, const std::string* password, const std::string* database, uint32_t port, const std::string* sock);
+	bool connect(const std::string* host, const std::string* user, const std::string* password, const std::string* database, uint32_t port, const std::string* sock, uint16_t poolSize = 1);
+
+	/**
+	 * Opens the pool on the read replica, with the credentials of the primary.
+	 * The reads keep going to the primary when it fails.
+	 */
+	bool connectReplica(const std::string &host, uint32_t port, uint16_t poolSize);
 
 	bool retryQuery(const std::string_view &query, int retries);
 	bool executeQuery(const std::string_view &query);
 
 	DBResult_ptr storeQuery(const std::string_view &query);
 
+	// Prepared statement versions, values are sent with the binary protocol instead of being escaped into the query
+	bool executeQuery(const DBStatement &statement);
+	DBResult_ptr storeQuery(const DBStatement &statement);
+
+	/**
+	 * Runs the SELECTs as one multi-statement query, in a single round trip.
+	 * @return a result per query (nullptr for the ones without rows), empty if any of them failed.
+	 */
+	std::vector<DBResult_ptr> storeQueries(const std::vector<std::string> &queries);
+
 	std::string escapeString(const std::string &s) const;
 
 	std::string escapeBlob(const char* s, uint32_t length) const;
 
-	uint64_t getLastInsertId() const {
-		return static_cast<uint64_t>(mysql_insert_id(handle));
-	}
+	/**
+	 * @return the id generated by the last insert executed on the calling thread.
+	 */
+	uint64_t getLastInsertId() const;
 
 	static const char* getClientVersion() {
 		return mysql_get_client_info();
@@ -58,15 +93,122 @@ public:
 		return maxPacketSize;
 	}
 
+	size_t getPoolSize() const {
+		return connections.size();
+	}
+
 private:
+	struct Connection {
+		MYSQL* handle = nullptr;
+		// Prepared once per query text and kept while the connection lives
+		phmap::flat_hash_map<std::string, MYSQL_STMT*> statements;
+	};
+
+	// The connection the calling thread has checked out, shared by nested calls and transactions
+	struct LocalConnection {
+		Connection* connection = nullptr;
+		uint32_t depth = 0;
+		uint64_t lastInsertId = 0;
+	};
+
+	static LocalConnection &localConnection();
+
+	// Checks a connection out for the scope, see acquire()
+	class ConnectionGuard {
+	public:
+		explicit ConnectionGuard(Database &db) :
+			db(db), connection(db.acquire()) { }
+
+		~ConnectionGuard() {
+			if (connection) {
+				db.release();
+			}
+		}
+
+		ConnectionGuard(const ConnectionGuard &) = delete;
+		ConnectionGuard &operator=(const ConnectionGuard &) = delete;
+
+		Connection* get() const {
+			return connection;
+		}
+
+	private:
+		Database &db;
+		Connection* connection;
+	};
+
 	bool beginTransaction();
 	bool rollback();
 	bool commit();
 
+	/**
+	 * Waits for an idle connection, unless the calling thread already holds one.
+	 * @return nullptr if the database is not connected.
+	 */
+	Connection* acquire();
+	void release();
+
+	/**
+	 * Waits for an idle replica connection, checking the replication lag once a second.
+	 * @return nullptr without a replica, inside a transaction (it must read its own writes) or while the replica lags.
+	 */
+	Connection* acquireReplica();
+	void releaseReplica(Connection* connection);
+	// The replication lag in seconds, -1 when the server is not replicating or it could not be read
+	int64_t queryReplicaLag(MYSQL* handle) const;
+	void setReplicaUsable(bool usable, int64_t lag);
+
+	DBResult_ptr storeQuery(MYSQL* handle, const std::string_view &query, bool retry, bool &failed);
+	DBResult_ptr storeStatement(Connection &connection, const DBStatement &statement, int retries, bool &failed);
+
 	bool isRecoverableError(unsigned int error) const;
 
-	MYSQL* handle = nullptr;
-	std::recursive_mutex databaseLock;
+	/**
+	 * Logs the query, with its origin (see DBQueryOrigin), if it runs for slowQueryThreshold or longer.
+	 * An explainable one is also explained once, on the database lane, with slowQueryExplain.
+	 */
+	class SlowQueryTimer {
+	public:
+		SlowQueryTimer(Database &db, std::string_view query, bool explainable);
+		~SlowQueryTimer();
+
+		SlowQueryTimer(const SlowQueryTimer &) = delete;
+		SlowQueryTimer &operator=(const SlowQueryTimer &) = delete;
+
+	private:
+		Database &db;
+		std::string_view query;
+		std::chrono::steady_clock::time_point start;
+		std::chrono::milliseconds threshold;
+		bool explainable;
+	};
+
+	void onSlowQuery(std::string_view query, std::chrono::milliseconds elapsed, bool explainable);
+	// Runs EXPLAIN on the query once, unless it is not a SELECT, UPDATE or DELETE
+	void explain(std::string_view query);
+
+	bool retryQuery(MYSQL* handle, const std::string_view &query, int retries);
+	MYSQL_STMT* getStatement(Connection &connection, const std::string &query, unsigned int &error);
+	void dropStatement(Connection &connection, const std::string &query);
+	MYSQL_STMT* runStatement(Connection &connection, const DBStatement &statement, int retries = 10);
+
+	std::vector<std::unique_ptr<Connection>> connections;
+	std::vector<Connection*> idleConnections;
+	std::mutex poolMutex;
+	std::condition_variable poolSignal;
+
+	std::vector<std::unique_ptr<Connection>> replicaConnections;
+	std::vector<Connection*> idleReplicas;
+	std::mutex replicaMutex;
+	std::condition_variable replicaSignal;
+	std::atomic<bool> replicaUsable = false;
+	// OTSYS_TIME of the last lag check
+	std::atomic<int64_t> replicaCheckedAt = 0;
+
+	// The texts of the slow queries already explained
+	std::mutex explainedMutex;
+	phmap::flat_hash_set<std::string> explained;
+
 	uint64_t maxPacketSize = 1048576;
 
 	friend class DBTransaction;
@@ -77,6 +219,8 @@ constexpr auto g_database = Database::getInstance;
 class DBResult {
 public:
 	explicit DBResult(MYSQL_RES* res);
+	// Fetches every row of an executed statement, the values keep the types they were sent with
+	DBResult(MYSQL_STMT* stmt, MYSQL_RES* metadata);
 	~DBResult();
 
 	// Non copyable
@@ -91,6 +235,10 @@ public:
 			return T();
 		}
 
+		if (!handle) {
+			return getBinaryNumber<T>(values[current + it->second], s);
+		}
+
 		if (row[it->second] == nullptr) {
 			return T();
 		}
@@ -157,11 +305,107 @@ public:
 	bool next();
 
 private:
-	MYSQL_RES* handle;
-	MYSQL_ROW row;
+	struct BinaryValue {
+		enum class Kind : uint8_t {
+			Null,
+			Signed,
+			Unsigned,
+			Real,
+			Bytes,
+		};
+
+		Kind kind = Kind::Null;
+		// The bits of an unsigned value are kept as is
+		int64_t integer = 0;
+		double real = 0;
+		std::string bytes;
+	};
+
+	template <typename T>
+	static T getBinaryNumber(const BinaryValue &value, const std::string &s) {
+		switch (value.kind) {
+			case BinaryValue::Kind::Signed:
+				return static_cast<T>(value.integer);
+			case BinaryValue::Kind::Unsigned:
+				return static_cast<T>(static_cast<uint64_t>(value.integer));
+			case BinaryValue::Kind::Real:
+				return static_cast<T>(value.real);
+			case BinaryValue::Kind::Bytes: {
+				// Decimal and text columns, e.g. SUM() results
+				std::conditional_t<std::is_same_v<T, bool>, uint8_t, T> data {};
+				const auto* end = value.bytes.data() + value.bytes.size();
+				if (std::from_chars(value.bytes.data(), end, data).ec != std::errc()) {
+					g_logger().error("Column '{}' has an invalid value set", s);
+					return T();
+				}
+				return static_cast<T>(data);
+			}
+			default:
+				return T();
+		}
+	}
+
+	MYSQL_RES* handle = nullptr;
+	MYSQL_ROW row = nullptr;
 
 	std::map<std::string_view, size_t> listNames;
 
+	// Statement results, handle is nullptr, rows are stored one after another
+	std::vector<std::string> columnNames;
+	std::vector<BinaryValue> values;
+	size_t columns = 0;
+	size_t current = 0;
+
+	friend class Database;
+};
+
+/**
+ * Prepared statement, the query uses ? for its values and they are bound in order.
+ * The query text is the cache key of the prepared statement, so it should not contain values itself.
+ */
+class DBStatement {
+public:
+	explicit DBStatement(std::string query) :
+		query(std::move(query)) { }
+
+	template <typename T>
+	DBStatement &bind(const T &value) {
+		if constexpr (std::is_enum_v<T>) {
+			return bind(static_cast<std::underlying_type_t<T>>(value));
+		} else if constexpr (std::is_same_v<T, bool>) {
+			params.emplace_back(static_cast<int64_t>(value));
+		} else if constexpr (std::is_integral_v<T> && std::is_signed_v<T>) {
+			params.emplace_back(static_cast<int64_t>(value));
+		} else if constexpr (std::is_integral_v<T>) {
+			params.emplace_back(static_cast<uint64_t>(value));
+		} else if constexpr (std::is_floating_point_v<T>) {
+			params.emplace_back(static_cast<double>(value));
+		} else {
+			params.emplace_back(std::string(value));
+		}
+		return *this;
+	}
+
+	DBStatement &bindBlob(const char* data, size_t length) {
+		params.emplace_back(std::string(data, length));
+		return *this;
+	}
+
+	DBStatement &bindNull() {
+		params.emplace_back(std::monostate());
+		return *this;
+	}
+
+	const std::string &getQuery() const {
+		return query;
+	}
+
+private:
+	using Param = std::variant<std::monostate, int64_t, uint64_t, double, std::string>;
+
+	std::string query;
+	std::vector<Param> params;
+
 	friend class Database;
 };
 
@@ -172,15 +416,40 @@ class DBInsert {
 public:
 	explicit DBInsert(std::string query);
 	void upsert(const std::vector<std::string> &columns);
+
+	/**
+	 * The rows replace every row of the owner in the table, the old ones are deleted before the first insert.
+	 * Inside a DBBatch both are left to the batch, which writes the rows of all its owners together.
+	 * With savedHash, nothing is written when the rows hash to the same value as the last time,
+	 * the new hash is stored there, it must be reset (0) when the transaction fails.
+	 */
+	void replace(std::string table, std::string ownerColumn, uint64_t owner, uint64_t* savedHash = nullptr);
+
+	// execute appends the queries to queries instead of running them, they are run later (e.g. from the persistence journal)
+	void capture(std::vector<std::string> &queries);
+
 	bool addRow(const std::string_view row);
 	bool addRow(std::ostringstream &row);
 	bool execute();
 
 private:
+	// Appends rows that are already in the (...),(...) form
+	bool addValues(std::string_view rows);
+
 	std::vector<std::string> upsertColumns;
 	std::string query;
 	std::string values;
 	size_t length;
+
+	std::string replaceTable;
+	std::string replaceColumn;
+	uint64_t replaceOwner = 0;
+	uint64_t* savedHash = nullptr;
+	bool ownerDeleted = false;
+	std::vector<std::string>* captured = nullptr;
+	DBBatch* batch = nullptr;
+
+	friend class DBBatch;
 };
 
 class DBTransaction {
@@ -222,7 +491,11 @@ private:
 		try {
 			// Start the transaction
 			state = STATE_START;
-			return Database::getInstance().beginTransaction();
+			if (!Database::getInstance().beginTransaction()) {
+				state = STATE_NO_START;
+				return false;
+			}
+			return true;
 		} catch (const std::exception &exception) {
 			// An error occurred while starting the transaction
 			state = STATE_NO_START;
@@ -278,6 +551,210 @@ private:
 	TransactionStates_t state = STATE_NO_START;
 };
 
+/**
+ * Collects the rows of many owners (e.g. all the players of a server save) by table, flush() writes each table
+ * with one DELETE and a few multi-row INSERTs in a single transaction, so the cost follows the number of tables
+ * instead of the number of owners.
+ * A batch is used by the DBInsert::replace calls of the thread that created it.
+ * A direct replace of a pending owner elsewhere (e.g. a logout save) drops the owner from the batch,
+ * so older rows never overwrite newer ones. The save must claim the owner before its transaction takes any row lock:
+ * the flush may be waiting for those rows (the foreign keys of the players row), it cannot be waited for then.
+ */
+class DBBatch {
+public:
+	DBBatch();
+	// Rows that were not flushed are dropped
+	~DBBatch();
+
+	// Non copyable
+	DBBatch(const DBBatch &) = delete;
+	DBBatch &operator=(const DBBatch &) = delete;
+
+	/**
+	 * @return the batch of the calling thread, nullptr outside of one.
+	 */
+	static DBBatch* current();
+
+	bool flush();
+
+	size_t getOwnerCount() const;
+
+	/**
+	 * Drops the rows of the owner from every batch, so they are not written over a direct save of it,
+	 * and waits if they are being flushed. Call it before the transaction of the save takes any row lock.
+	 */
+	static void claim(uint64_t owner);
+
+private:
+	struct Table {
+		std::string ownerColumn;
+		std::string insertQuery;
+		std::vector<std::string> upsertColumns;
+		phmap::flat_hash_map<uint64_t, std::string> rows;
+	};
+
+	void add(const DBInsert &insert);
+
+	/**
+	 * Called by a direct replace of the owner's rows, inside its transaction, so it never waits:
+	 * @return false if the rows are being flushed, the owner was not claimed before the transaction.
+	 */
+	static bool drop(uint64_t owner);
+
+	// Whether rows of the owner are still waiting in a batch (or being flushed), a direct replace must not skip them then
+	static bool isPending(const std::string &table, uint64_t owner);
+
+	static bool write(const std::string &name, const Table &table);
+
+	mutable std::mutex mutex;
+	std::condition_variable flushed;
+	phmap::flat_hash_map<std::string, Table> tables;
+	phmap::flat_hash_set<uint64_t> flushingOwners;
+	phmap::flat_hash_set<uint64_t> claimedOwners;
+	DBBatch* previous = nullptr;
+
+	friend class DBInsert;
+	friend class DBCapture;
+};
+
+/**
+ * Collects the writes of the calling thread instead of running them, while a Scope binds it.
+ * executeQuery (and so DBInsert) stores the query, or the statement with its bound values,
+ * the capture is then a self-contained copy of the writes that execute runs later, on any thread.
+ * Reads are not captured, they still go to the database.
+ */
+class DBCapture {
+public:
+	class Scope {
+	public:
+		explicit Scope(DBCapture &capture);
+		~Scope();
+
+		Scope(const Scope &) = delete;
+		Scope &operator=(const Scope &) = delete;
+
+	private:
+		DBCapture* previous = nullptr;
+	};
+
+	/**
+	 * @return the capture bound to the calling thread, nullptr outside of one.
+	 */
+	static DBCapture* current();
+
+	/**
+	 * Runs the writes in their order, stops at the first one that fails.
+	 * The owners whose rows were replaced are claimed from the pending batches first, as a direct replace does.
+	 */
+	bool execute() const;
+
+	bool empty() const {
+		return writes.empty();
+	}
+
+	size_t size() const {
+		return writes.size();
+	}
+
+private:
+	void add(std::string query);
+	void add(const DBStatement &statement);
+	void claim(uint64_t owner);
+
+	std::vector<std::variant<std::string, DBStatement>> writes;
+	std::vector<uint64_t> claimedOwners;
+
+	friend class Database;
+	friend class DBInsert;
+};
+
+/**
+ * Results fetched ahead with Database::storeQueries, while a Scope binds it
+ * storeQuery answers each of those queries once from here instead of asking the database.
+ */
+class DBPrefetch {
+public:
+	class Scope {
+	public:
+		explicit Scope(DBPrefetch &prefetch);
+		~Scope();
+
+		Scope(const Scope &) = delete;
+		Scope &operator=(const Scope &) = delete;
+
+	private:
+		DBPrefetch* previous = nullptr;
+	};
+
+	/**
+	 * @return the prefetch bound to the calling thread, nullptr outside of one.
+	 */
+	static DBPrefetch* current();
+
+	/**
+	 * @return false if the queries could not be fetched, storeQuery then runs them one by one.
+	 */
+	bool fetch(const std::vector<std::string> &queries);
+
+private:
+	// Whether the query was fetched, its result is moved out to result
+	bool take(std::string_view query, DBResult_ptr &result);
+
+	phmap::flat_hash_map<std::string, DBResult_ptr> results;
+
+	friend class Database;
+};
+
+/**
+ * Marks the reads of the calling thread, while it lives, as fine to answer from the read replica:
+ * they may miss the writes of the last mysqlReplicaMaxLag seconds, so only reads shown to players
+ * (highscores, market history) use it, never one that is written back.
+ */
+class DBReadOnly {
+public:
+	DBReadOnly();
+	~DBReadOnly();
+
+	DBReadOnly(const DBReadOnly &) = delete;
+	DBReadOnly &operator=(const DBReadOnly &) = delete;
+
+	static bool isActive();
+};
+
+/**
+ * Names what the queries of the calling thread are run for, in the slow query log, while it lives.
+ * DatabaseTasks carries the origin of its caller to the database lane, and the Lua db functions add the script.
+ */
+class DBQueryOrigin {
+public:
+	explicit DBQueryOrigin(std::string origin);
+	~DBQueryOrigin();
+
+	DBQueryOrigin(const DBQueryOrigin &) = delete;
+	DBQueryOrigin &operator=(const DBQueryOrigin &) = delete;
+
+	/**
+	 * @return the innermost origin of the calling thread, the context of its dispatcher task without any.
+	 */
+	static std::string current();
+
+	/**
+	 * @return whether the slow queries are logged, the origins are only worth building then.
+	 */
+	static bool isNeeded();
+
+	/**
+	 * @return the current origin to carry to another thread, empty when not needed.
+	 */
+	static std::string capture() {
+		return isNeeded() ? current() : std::string();
+	}
+
+private:
+	std::string origin;
+	DBQueryOrigin* previous = nullptr;
+};
+
 class DatabaseException : public std::exception {
 public:
 	explicit DatabaseException(const std::string &message) :
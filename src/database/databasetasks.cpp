@@ -23,7 +23,8 @@ DatabaseTasks &DatabaseTasks::getInstance() {
 }
 
 void DatabaseTasks::execute(const std::string &query, std::function<void(DBResult_ptr, bool)> callback /* nullptr */) {
-	threadPool.detach_task([this, query, callback]() {
+	threadPool.detachTask(ThreadLane::Database, [this, query, callback, origin = DBQueryOrigin::capture()]() {
+		DBQueryOrigin queryOrigin(origin);
 		bool success = db.executeQuery(query);
 		if (callback != nullptr) {
 			g_dispatcher().addEvent([callback, success]() { callback(nullptr, success); }, "DatabaseTasks::execute");
@@ -32,10 +33,39 @@ void DatabaseTasks::execute(const std::string &query, std::function<void(DBResul
 }
 
 void DatabaseTasks::store(const std::string &query, std::function<void(DBResult_ptr, bool)> callback /* nullptr */) {
-	threadPool.detach_task([this, query, callback]() {
+	threadPool.detachTask(ThreadLane::Database, [this, query, callback, origin = DBQueryOrigin::capture(), readOnly = DBReadOnly::isActive()]() {
+		DBQueryOrigin queryOrigin(origin);
+		std::optional<DBReadOnly> readOnlyScope;
+		if (readOnly) {
+			readOnlyScope.emplace();
+		}
 		DBResult_ptr result = db.storeQuery(query);
 		if (callback != nullptr) {
 			g_dispatcher().addEvent([callback, result]() { callback(result, true); }, "DatabaseTasks::store");
 		}
 	});
 }
+
+void DatabaseTasks::execute(DBStatement statement, std::function<void(DBResult_ptr, bool)> callback /* nullptr */) {
+	threadPool.detachTask(ThreadLane::Database, [this, statement = std::move(statement), callback, origin = DBQueryOrigin::capture()]() {
+		DBQueryOrigin queryOrigin(origin);
+		bool success = db.executeQuery(statement);
+		if (callback != nullptr) {
+			g_dispatcher().addEvent([callback, success]() { callback(nullptr, success); }, "DatabaseTasks::execute");
+		}
+	});
+}
+
+void DatabaseTasks::store(DBStatement statement, std::function<void(DBResult_ptr, bool)> callback /* nullptr */) {
+	threadPool.detachTask(ThreadLane::Database, [this, statement = std::move(statement), callback, origin = DBQueryOrigin::capture(), readOnly = DBReadOnly::isActive()]() {
+		DBQueryOrigin queryOrigin(origin);
+		std::optional<DBReadOnly> readOnlyScope;
+		if (readOnly) {
+			readOnlyScope.emplace();
+		}
+		DBResult_ptr result = db.storeQuery(statement);
+		if (callback != nullptr) {
+			g_dispatcher().addEvent([callback, result]() { callback(result, true); }, "DatabaseTasks::store");
+		}
+	});
+}
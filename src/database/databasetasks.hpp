@@ -10,6 +10,7 @@
 #pragma once
 
 #include "database/database.hpp"
+#include "game/scheduling/game_task.hpp"
 #include "lib/thread/thread_pool.hpp"
 
 class DatabaseTasks {
@@ -24,6 +25,46 @@ public:
 
 	void execute(const std::string &query, std::function<void(DBResult_ptr, bool)> callback = nullptr);
 	void store(const std::string &query, std::function<void(DBResult_ptr, bool)> callback = nullptr);
+	void execute(DBStatement statement, std::function<void(DBResult_ptr, bool)> callback = nullptr);
+	void store(DBStatement statement, std::function<void(DBResult_ptr, bool)> callback = nullptr);
+
+	// Awaitable versions for GameTask coroutines, the coroutine is resumed on the dispatcher thread with the result
+	// The queries carry the origin of the caller, see DBQueryOrigin, and the stores whether it is a DBReadOnly
+	auto asyncExecute(std::string query) {
+		return AsyncAwaiter(threadPool, ThreadLane::Database, [this, query = std::move(query), origin = DBQueryOrigin::capture()] {
+			DBQueryOrigin queryOrigin(origin);
+			return db.executeQuery(query);
+		});
+	}
+
+	auto asyncStore(std::string query) {
+		return AsyncAwaiter(threadPool, ThreadLane::Database, [this, query = std::move(query), origin = DBQueryOrigin::capture(), readOnly = DBReadOnly::isActive()] {
+			DBQueryOrigin queryOrigin(origin);
+			std::optional<DBReadOnly> readOnlyScope;
+			if (readOnly) {
+				readOnlyScope.emplace();
+			}
+			return db.storeQuery(query);
+		});
+	}
+
+	auto asyncExecute(DBStatement statement) {
+		return AsyncAwaiter(threadPool, ThreadLane::Database, [this, statement = std::move(statement), origin = DBQueryOrigin::capture()] {
+			DBQueryOrigin queryOrigin(origin);
+			return db.executeQuery(statement);
+		});
+	}
+
+	auto asyncStore(DBStatement statement) {
+		return AsyncAwaiter(threadPool, ThreadLane::Database, [this, statement = std::move(statement), origin = DBQueryOrigin::capture(), readOnly = DBReadOnly::isActive()] {
+			DBQueryOrigin queryOrigin(origin);
+			std::optional<DBReadOnly> readOnlyScope;
+			if (readOnly) {
+				readOnlyScope.emplace();
+			}
+			return db.storeQuery(statement);
+		});
+	}
 
 private:
 	Database &db;
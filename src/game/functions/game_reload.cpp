@@ -15,9 +15,11 @@
 #include "lua/creature/events.hpp"
 #include "creatures/players/imbuements/imbuements.hpp"
 #include "lua/scripts/lua_environment.hpp"
+#include "lua/scripts/lua_memory.hpp"
 #include "lua/modules/modules.hpp"
 #include "lua/scripts/scripts.hpp"
 #include "game/zones/zone.hpp"
+#include "io/ioprey.hpp"
 
 GameReload::GameReload() = default;
 GameReload::~GameReload() = default;
@@ -58,6 +60,8 @@ bool GameReload::init(Reload_t reloadTypes) {
 			return reloadNpcs();
 		case Reload_t::RELOAD_TYPE_RAIDS:
 			return reloadRaids();
+		case Reload_t::RELOAD_TYPE_SCRIPTS_CHANGED:
+			return reloadChangedScripts();
 		default:
 			return false;
 	}
@@ -89,7 +93,8 @@ bool GameReload::reloadAll() {
 	for (auto value : magic_enum::enum_values<Reload_t>()) {
 		const auto name = magic_enum::enum_name(value);
 		g_logger().info("Reloading: {}", name);
-		if (value != Reload_t::RELOAD_TYPE_ALL) {
+		// The changed scripts are already in the full reload of the scripts
+		if (value != Reload_t::RELOAD_TYPE_ALL && value != Reload_t::RELOAD_TYPE_SCRIPTS_CHANGED) {
 			reloadResults.push_back(init(value));
 		}
 	}
@@ -105,6 +110,9 @@ bool GameReload::reloadChat() {
 
 bool GameReload::reloadConfig() {
 	const bool result = g_configManager().reload();
+	if (result) {
+		LuaMemory::configure();
+	}
 	logReloadStatus("Config", result);
 	return result;
 }
@@ -207,6 +215,7 @@ bool GameReload::reloadMonsters() {
 	const bool monsterScriptsLoaded = g_scripts().loadScripts(datapackFolder + "/monster", false, true);
 
 	if (scriptsLoaded && monsterScriptsLoaded) {
+		g_ioprey().reloadMonsterCandidates();
 		logReloadStatus("Monsters", true);
 		return true;
 	} else {
@@ -226,3 +235,17 @@ bool GameReload::reloadRaids() {
 	logReloadStatus("Raids", result);
 	return result;
 }
+
+bool GameReload::reloadChangedScripts() {
+	const auto &datapackFolder = g_configManager().getString(DATA_DIRECTORY, __FUNCTION__);
+	const auto &coreFolder = g_configManager().getString(CORE_DIRECTORY, __FUNCTION__);
+
+	// Same order as the full reload, the libraries first
+	size_t reloaded = g_scripts().reloadChangedScripts(coreFolder + "/scripts/lib", true);
+	reloaded += g_scripts().reloadChangedScripts(datapackFolder + "/scripts", false);
+	reloaded += g_scripts().reloadChangedScripts(coreFolder + "/scripts", false);
+
+	g_logger().info("Reloaded {} changed script files", reloaded);
+	logReloadStatus("Changed scripts", true);
+	return true;
+}
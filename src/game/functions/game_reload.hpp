@@ -32,6 +32,7 @@ enum class Reload_t : uint8_t {
 	RELOAD_TYPE_MONSTERS,
 	RELOAD_TYPE_NPCS,
 	RELOAD_TYPE_RAIDS,
+	RELOAD_TYPE_SCRIPTS_CHANGED,
 
 	// Every is last
 	RELOAD_TYPE_LAST
@@ -71,6 +72,7 @@ private:
 	static bool reloadMonsters();
 	static bool reloadNpcs();
 	static bool reloadRaids();
+	static bool reloadChangedScripts();
 };
 
 constexpr auto g_gameReload = GameReload::getInstance;
@@ -19,17 +19,24 @@
 #include "lua/callbacks/event_callback.hpp"
 #include "lua/callbacks/events_callbacks.hpp"
 #include "creatures/players/highscore_category.hpp"
+#include "creatures/players/highscore_index.hpp"
 #include "game/zones/zone.hpp"
 #include "lua/global/globalevent.hpp"
 #include "io/iologindata.hpp"
 #include "io/io_wheel.hpp"
 #include "io/iomarket.hpp"
+#include "io/persistence_journal.hpp"
 #include "items/items.hpp"
 #include "lua/scripts/lua_environment.hpp"
 #include "creatures/monsters/monster.hpp"
 #include "lua/creature/movement.hpp"
+#include "game/memory_census.hpp"
 #include "game/scheduling/dispatcher.hpp"
+#include "game/scheduling/frame_profiler.hpp"
 #include "game/scheduling/save_manager.hpp"
+#include "game/scheduling/task_profiler.hpp"
+#include "game/world_snapshot.hpp"
+#include "lib/metrics/allocation_counter.hpp"
 #include "server/server.hpp"
 #include "creatures/combat/spells.hpp"
 #include "lua/creature/talkaction.hpp"
@@ -183,7 +190,9 @@ namespace InternalGame {
 	}
 } // Namespace InternalGame
 
-Game::Game() {
+Game::Game() :
+	npcs(Npc::FIRST_ID, Npc::ID_COUNT),
+	monsters(Monster::FIRST_ID, Monster::ID_COUNT) {
 	offlineTrainingWindow.choices.emplace_back("Sword Fighting and Shielding", SKILL_SWORD);
 	offlineTrainingWindow.choices.emplace_back("Axe Fighting and Shielding", SKILL_AXE);
 	offlineTrainingWindow.choices.emplace_back("Club Fighting and Shielding", SKILL_CLUB);
@@ -198,8 +207,6 @@ Game::Game() {
 	// Create instance of IOWheel to Game class
 	m_IOWheel = std::make_unique<IOWheel>();
 
-	wildcardTree = std::make_shared<WildcardTreeNode>(false);
-
 	m_badges = {
 		Badge(1, CyclopediaBadge_t::ACCOUNT_AGE, "Fledegeling Hero", 1),
 		Badge(2, CyclopediaBadge_t::ACCOUNT_AGE, "Veteran Hero", 5),
@@ -517,9 +524,54 @@ void Game::start(ServiceManager* manager) {
 	g_dispatcher().cycleEvent(
 		EVENT_IMBUEMENT_INTERVAL, [this] { checkImbuements(); }, "Game::checkImbuements"
 	);
+	g_dispatcher().cycleEvent(
+		EVENT_MAP_CLEAN_INTERVAL, [this] { checkTilesToClean(); }, "Game::checkTilesToClean"
+	);
 	g_dispatcher().cycleEvent(
 		EVENT_LUA_GARBAGE_COLLECTION, [this] { g_luaEnvironment().collectGarbage(); }, "Calling GC"
 	);
+	g_dispatcher().cycleEvent(
+		TaskProfiler::SNAPSHOT_INTERVAL, [] { g_taskProfiler().takeSnapshot(); }, "TaskProfiler::takeSnapshot"
+	);
+	if constexpr (allocation_counter::isEnabled()) {
+		g_dispatcher().cycleEvent(
+			1000, [] { allocation_counter::reportMetrics(); }, "allocation_counter::reportMetrics"
+		);
+	}
+	g_dispatcher().cycleEvent(
+		1000, [] { ConnectionManager::getInstance().reportStatistics(); }, "ConnectionManager::reportStatistics"
+	);
+	if (const auto memoryCensusInterval = g_configManager().getNumber(MEMORY_CENSUS_INTERVAL, __FUNCTION__); memoryCensusInterval > 0) {
+		g_dispatcher().cycleEvent(
+			static_cast<uint32_t>(memoryCensusInterval * 1000), [] { g_memoryCensus().reportMetrics(); }, "MemoryCensus::reportMetrics"
+		);
+	}
+	updateWorldSnapshot();
+	g_dispatcher().cycleEvent(
+		static_cast<uint32_t>(std::max<int32_t>(g_configManager().getNumber(WORLD_SNAPSHOT_INTERVAL, __FUNCTION__), SCHEDULER_MINTICKS)), [this] { updateWorldSnapshot(); }, "Game::updateWorldSnapshot"
+	);
+	ProtocolStatus::updateSnapshot();
+	g_dispatcher().cycleEvent(
+		static_cast<uint32_t>(std::max<int32_t>(g_configManager().getNumber(STATUS_CACHE_TIME, __FUNCTION__), SCHEDULER_MINTICKS)), [] { ProtocolStatus::updateSnapshot(); }, "ProtocolStatus::updateSnapshot"
+	);
+	if (g_persistenceJournal().isOpen()) {
+		g_dispatcher().cycleEvent(
+			static_cast<uint32_t>(std::max<int32_t>(g_configManager().getNumber(PERSISTENCE_JOURNAL_COMPACT_INTERVAL, __FUNCTION__), 1) * 1000), [] { g_saveManager().scheduleJournalCompaction(); }, "SaveManager::compactJournal"
+		);
+	}
+	g_saveManager().startSpreadSaves();
+	const auto tileEvictionTime = g_configManager().getNumber(MAP_TILE_EVICTION_TIME, __FUNCTION__);
+	if (tileEvictionTime > 0) {
+		map.setTileEvictionTime(tileEvictionTime * 1000);
+		g_dispatcher().cycleEvent(
+			EVENT_MAP_TILE_EVICTION_INTERVAL, [this] {
+				if (const auto evicted = map.evictIdleTiles(); evicted > 0) {
+					g_logger().debug("[Game::evictIdleTiles] - Evicted {} idle tiles", evicted);
+				}
+			},
+			"Game::evictIdleTiles"
+		);
+	}
 	auto marketItemsPriceIntervalMinutes = g_configManager().getNumber(MARKET_REFRESH_PRICES, __FUNCTION__);
 	if (marketItemsPriceIntervalMinutes > 0) {
 		auto marketItemsPriceIntervalMS = marketItemsPriceIntervalMinutes * 60000;
@@ -586,7 +638,7 @@ void Game::setGameState(GameState_t newState) {
 			g_globalEvents().save();
 			g_globalEvents().shutdown();
 
-			// kick all players that are still online
+			// kick all players that are still online, their saves are captured here and written by saveForShutdown
 			auto it = players.begin();
 			while (it != players.end()) {
 				it->second->removePlayer(true);
@@ -594,7 +646,7 @@ void Game::setGameState(GameState_t newState) {
 			}
 
 			saveMotdNum();
-			g_saveManager().saveAll();
+			g_saveManager().saveForShutdown();
 
 			g_dispatcher().addEvent([this] { shutdown(); }, "Game::shutdown");
 
@@ -651,6 +703,10 @@ void Game::loadMainMap(const std::string &filename) {
 	map.loadMap(g_configManager().getString(DATA_DIRECTORY, __FUNCTION__) + "/world/" + filename + ".otbm", true, true, true, true, true);
 }
 
+void Game::parseMainMap(const std::string &filename) {
+	map.parse(g_configManager().getString(DATA_DIRECTORY, __FUNCTION__) + "/world/" + filename + ".otbm", true);
+}
+
 void Game::loadCustomMaps(const std::filesystem::path &customMapPath) {
 	Monster::despawnRange = g_configManager().getNumber(DEFAULT_DESPAWNRANGE, __FUNCTION__);
 	Monster::despawnRadius = g_configManager().getNumber(DEFAULT_DESPAWNRADIUS, __FUNCTION__);
@@ -886,38 +942,22 @@ void Game::internalGetPosition(std::shared_ptr<Item> item, Position &pos, uint8_
 std::shared_ptr<Creature> Game::getCreatureByID(uint32_t id) {
 	if (id >= Player::getFirstID() && id <= Player::getLastID()) {
 		return getPlayerByID(id);
-	} else if (id <= Monster::monsterAutoID) {
+	} else if (id > Monster::FIRST_ID && id < Npc::FIRST_ID) {
 		return getMonsterByID(id);
-	} else if (id <= Npc::npcAutoID) {
+	} else if (id > Npc::FIRST_ID) {
 		return getNpcByID(id);
 	} else {
-		g_logger().warn("Creature with id {} not exists");
+		g_logger().warn("Creature with id {} not exists", id);
 	}
 	return nullptr;
 }
 
 std::shared_ptr<Monster> Game::getMonsterByID(uint32_t id) {
-	if (id == 0) {
-		return nullptr;
-	}
-
-	auto it = monsters.find(id);
-	if (it == monsters.end()) {
-		return nullptr;
-	}
-	return it->second;
+	return monsters.get(id);
 }
 
 std::shared_ptr<Npc> Game::getNpcByID(uint32_t id) {
-	if (id == 0) {
-		return nullptr;
-	}
-
-	auto it = npcs.find(id);
-	if (it == npcs.end()) {
-		return nullptr;
-	}
-	return it->second;
+	return npcs.get(id);
 }
 
 std::shared_ptr<Player> Game::getPlayerByID(uint32_t id, bool allowOffline /* = false */) {
@@ -929,11 +969,15 @@ std::shared_ptr<Player> Game::getPlayerByID(uint32_t id, bool allowOffline /* =
 	if (!allowOffline) {
 		return nullptr;
 	}
+	if (auto offlinePlayer = getOfflinePlayer(id)) {
+		return offlinePlayer;
+	}
 	std::shared_ptr<Player> tmpPlayer = std::make_shared<Player>(nullptr);
 	if (!IOLoginData::loadPlayerById(tmpPlayer, id)) {
 		return nullptr;
 	}
 	tmpPlayer->setOnline(false);
+	addOfflinePlayer(tmpPlayer);
 	return tmpPlayer;
 }
 
@@ -982,11 +1026,15 @@ std::shared_ptr<Player> Game::getPlayerByName(const std::string &s, bool allowOf
 		return nullptr;
 	}
 
-	auto it = mappedPlayerNames.find(asLowerCaseString(s));
+	const auto lowerCaseName = asLowerCaseString(s);
+	auto it = mappedPlayerNames.find(lowerCaseName);
 	if (it == mappedPlayerNames.end() || it->second.expired()) {
 		if (!allowOffline) {
 			return nullptr;
 		}
+		if (auto offlinePlayer = getOfflinePlayer(lowerCaseName)) {
+			return offlinePlayer;
+		}
 		std::shared_ptr<Player> tmpPlayer = std::make_shared<Player>(nullptr);
 		if (!IOLoginData::loadPlayerByName(tmpPlayer, s)) {
 			if (!isNewName) {
@@ -997,6 +1045,7 @@ std::shared_ptr<Player> Game::getPlayerByName(const std::string &s, bool allowOf
 			return nullptr;
 		}
 		tmpPlayer->setOnline(false);
+		addOfflinePlayer(tmpPlayer);
 		return tmpPlayer;
 	}
 	return it->second.lock();
@@ -1006,22 +1055,93 @@ std::shared_ptr<Player> Game::getPlayerByGUID(const uint32_t &guid, bool allowOf
 	if (guid == 0) {
 		return nullptr;
 	}
-	for (const auto &it : players) {
-		if (guid == it.second->getGUID()) {
-			return it.second;
+	if (const auto it = mappedPlayerGuids.find(guid); it != mappedPlayerGuids.end()) {
+		if (auto player = it->second.lock()) {
+			return player;
 		}
 	}
 	if (!allowOffline) {
 		return nullptr;
 	}
+	if (auto offlinePlayer = getOfflinePlayer(guid)) {
+		return offlinePlayer;
+	}
 	std::shared_ptr<Player> tmpPlayer = std::make_shared<Player>(nullptr);
 	if (!IOLoginData::loadPlayerById(tmpPlayer, guid)) {
 		return nullptr;
 	}
 	tmpPlayer->setOnline(false);
+	addOfflinePlayer(tmpPlayer);
 	return tmpPlayer;
 }
 
+std::shared_ptr<Player> Game::getOfflinePlayer(uint32_t guid) {
+	std::scoped_lock lock(offlinePlayersMutex);
+	const auto it = offlinePlayersByGuid.find(guid);
+	if (it == offlinePlayersByGuid.end()) {
+		return nullptr;
+	}
+
+	if (it->second->expiresAt < OTSYS_TIME()) {
+		eraseOfflinePlayer(guid);
+		return nullptr;
+	}
+
+	offlinePlayers.splice(offlinePlayers.begin(), offlinePlayers, it->second);
+	return it->second->player;
+}
+
+std::shared_ptr<Player> Game::getOfflinePlayer(const std::string &lowerCaseName) {
+	uint32_t guid;
+	{
+		std::scoped_lock lock(offlinePlayersMutex);
+		const auto it = offlinePlayerGuidsByName.find(lowerCaseName);
+		if (it == offlinePlayerGuidsByName.end()) {
+			return nullptr;
+		}
+		guid = it->second;
+	}
+	return getOfflinePlayer(guid);
+}
+
+void Game::addOfflinePlayer(const std::shared_ptr<Player> &player) {
+	const auto maxSize = static_cast<size_t>(g_configManager().getNumber(OFFLINE_PLAYER_CACHE_SIZE, __FUNCTION__));
+	if (maxSize == 0) {
+		return;
+	}
+
+	std::scoped_lock lock(offlinePlayersMutex);
+	eraseOfflinePlayer(player->getGUID());
+	offlinePlayers.push_front({ player, OTSYS_TIME() + g_configManager().getNumber(OFFLINE_PLAYER_CACHE_TIME, __FUNCTION__) });
+	offlinePlayersByGuid[player->getGUID()] = offlinePlayers.begin();
+	offlinePlayerGuidsByName[asLowerCaseString(player->getName())] = player->getGUID();
+	while (offlinePlayers.size() > maxSize) {
+		eraseOfflinePlayer(offlinePlayers.back().player->getGUID());
+	}
+}
+
+void Game::removeOfflinePlayer(uint32_t guid, const std::shared_ptr<Player> &savedPlayer /* = nullptr */) {
+	std::scoped_lock lock(offlinePlayersMutex);
+	if (savedPlayer) {
+		const auto it = offlinePlayersByGuid.find(guid);
+		if (it != offlinePlayersByGuid.end() && it->second->player == savedPlayer) {
+			return;
+		}
+	}
+	eraseOfflinePlayer(guid);
+}
+
+void Game::eraseOfflinePlayer(uint32_t guid) {
+	const auto it = offlinePlayersByGuid.find(guid);
+	if (it == offlinePlayersByGuid.end()) {
+		return;
+	}
+
+	offlinePlayerGuidsByName.erase(asLowerCaseString(it->second->player->getName()));
+	offlinePlayers.erase(it->second);
+	offlinePlayersByGuid.erase(it);
+}
+
 std::string Game::getPlayerNameByGUID(const uint32_t &guid) {
 	if (guid == 0) {
 		return "";
@@ -1046,7 +1166,7 @@ ReturnValue Game::getPlayerByNameWildcard(const std::string &s, std::shared_ptr<
 	if (s.back() == '~') {
 		const std::string &query = asLowerCaseString(s.substr(0, strlen - 1));
 		std::string result;
-		ReturnValue ret = wildcardTree->findOne(query, result);
+		ReturnValue ret = wildcardTree.findOne(query, result);
 		if (ret != RETURNVALUE_NOERROR) {
 			return ret;
 		}
@@ -1820,6 +1940,10 @@ void Game::playerMoveItem(std::shared_ptr<Player> player, const Position &fromPo
 	} else if (toCylinder->getContainer() && fromCylinder->getContainer() && fromCylinder->getContainer()->countsToLootAnalyzerBalance() && toCylinder->getContainer()->getTopParent() == player) {
 		player->sendLootStats(item, count);
 	}
+
+	if (ret == RETURNVALUE_NOERROR && (isInsideDepot(fromCylinder) || isInsideDepot(toCylinder))) {
+		player->scheduleJournal();
+	}
 	player->cancelPush();
 
 	item->checkDecayMapItemOnMove();
@@ -1828,6 +1952,18 @@ void Game::playerMoveItem(std::shared_ptr<Player> player, const Position &fromPo
 	g_callbacks().executeCallback(EventCallback_t::playerOnItemMoved, &EventCallback::playerOnItemMoved, player, item, count, fromPos, toPos, fromCylinder, toCylinder);
 }
 
+bool Game::isInsideDepot(std::shared_ptr<Cylinder> cylinder) const {
+	auto container = cylinder ? cylinder->getContainer() : nullptr;
+	while (container) {
+		if (container->isDepotChest() || container->isInbox() || container->getDepotLocker()) {
+			return true;
+		}
+		const auto parent = container->getParent();
+		container = parent ? parent->getContainer() : nullptr;
+	}
+	return false;
+}
+
 bool Game::isTryingToStow(const Position &toPos, std::shared_ptr<Cylinder> toCylinder) const {
 	return toCylinder->getContainer() && toCylinder->getItem()->getID() == ITEM_LOCKER && toPos.getZ() == ITEM_SUPPLY_STASH_INDEX;
 }
@@ -2390,6 +2526,11 @@ std::tuple<ReturnValue, uint32_t, uint32_t> Game::addItemBatch(const std::shared
 	};
 	auto destination = setupDestination();
 
+	// The player's containers are searched breadth first for a free slot, so an item with the id of the
+	// previous one lands in the container that one went to while it has room, it is added there directly
+	std::shared_ptr<Container> lastContainer;
+	uint16_t lastContainerItemId = 0;
+
 	for (const auto &item : items) {
 		auto container = destination->getContainer();
 		if (container && container->getFreeSlots() == 0) {
@@ -2410,7 +2551,17 @@ std::tuple<ReturnValue, uint32_t, uint32_t> Game::addItemBatch(const std::shared
 				ret = internalCollectManagedItems(player, item, g_game().getObjectCategory(item), false);
 				// If it can't place in the player's backpacks, add normally
 				if (ret != RETURNVALUE_NOERROR) {
-					ret = internalAddItem(destination, item, CONST_SLOT_WHEREEVER, flags, false, remainderCount);
+					const bool searchContainers = player && destination == toCylinder && !item->isStackable();
+					if (searchContainers && lastContainer && lastContainerItemId == item->getID() && lastContainer->size() < lastContainer->capacity() && !lastContainer->isRemoved()) {
+						ret = internalAddItem(lastContainer, item, INDEX_WHEREEVER, flags);
+					}
+					if (ret != RETURNVALUE_NOERROR) {
+						ret = internalAddItem(destination, item, CONST_SLOT_WHEREEVER, flags, false, remainderCount);
+					}
+					if (searchContainers && ret == RETURNVALUE_NOERROR) {
+						lastContainer = item->getParent() ? item->getParent()->getContainer() : nullptr;
+						lastContainerItemId = item->getID();
+					}
 				}
 			}
 
@@ -2428,9 +2579,6 @@ std::tuple<ReturnValue, uint32_t, uint32_t> Game::addItemBatch(const std::shared
 			ret = internalAddItem(destination->getTile(), item, INDEX_WHEREEVER, FLAG_NOLIMIT);
 		}
 
-		if (player && ret == RETURNVALUE_NOERROR) {
-			player->sendForgingData();
-		}
 		if (ret != RETURNVALUE_NOERROR) {
 			break;
 		} else {
@@ -2438,6 +2586,11 @@ std::tuple<ReturnValue, uint32_t, uint32_t> Game::addItemBatch(const std::shared
 		}
 	}
 
+	// Once for the whole batch, it is the full forge table
+	if (player && totalAdded > 0) {
+		player->sendForgingData();
+	}
+
 	return std::make_tuple(ret, totalAdded, containersCreated);
 }
 
@@ -5410,7 +5563,7 @@ void Game::playerQuickLoot(uint32_t playerId, const Position &pos, uint16_t item
 		return;
 	}
 
-	Player::PlayerLock lock(player);
+	Player::PlayerLock lock(player, __METHOD_NAME__);
 	if (!autoLoot) {
 		player->setNextActionTask(nullptr);
 	}
@@ -6213,8 +6366,8 @@ void Game::playerSpeakToNpc(std::shared_ptr<Player> player, const std::string &t
 	player->updateUIExhausted();
 }
 
-std::shared_ptr<Task> Game::createPlayerTask(uint32_t delay, std::function<void(void)> f, std::string context) const {
-	return Player::createPlayerTask(delay, std::move(f), std::move(context));
+std::shared_ptr<Task> Game::createPlayerTask(uint32_t delay, std::function<void(void)> f, std::string_view context) const {
+	return Player::createPlayerTask(delay, std::move(f), context);
 }
 
 //--
@@ -6254,34 +6407,35 @@ bool Game::internalCreatureSay(std::shared_ptr<Creature> creature, SpeakClasses
 		pos = &creature->getPosition();
 	}
 
-	Spectators spectators;
-
+	// The given spectators are used as they are, only searched for when there are none
+	Spectators foundSpectators;
 	if (!spectatorsPtr || spectatorsPtr->empty()) {
-		// This somewhat complex construct ensures that the cached Spectators
-		// is used if available and if it can be used, else a local vector is
-		// used (hopefully the compiler will optimize away the construction of
-		// the temporary when it's not used).
 		if (type != TALKTYPE_YELL && type != TALKTYPE_MONSTER_YELL) {
-			spectators.find<Creature>(*pos, false, MAP_MAX_CLIENT_VIEW_PORT_X, MAP_MAX_CLIENT_VIEW_PORT_X, MAP_MAX_CLIENT_VIEW_PORT_Y, MAP_MAX_CLIENT_VIEW_PORT_Y);
+			foundSpectators.find<Creature>(*pos, false, MAP_MAX_CLIENT_VIEW_PORT_X, MAP_MAX_CLIENT_VIEW_PORT_X, MAP_MAX_CLIENT_VIEW_PORT_Y, MAP_MAX_CLIENT_VIEW_PORT_Y);
 		} else {
-			spectators.find<Creature>(*pos, true, (MAP_MAX_CLIENT_VIEW_PORT_X + 1) * 2, (MAP_MAX_CLIENT_VIEW_PORT_X + 1) * 2, (MAP_MAX_CLIENT_VIEW_PORT_Y + 1) * 2, (MAP_MAX_CLIENT_VIEW_PORT_Y + 1) * 2);
+			foundSpectators.find<Creature>(*pos, true, (MAP_MAX_CLIENT_VIEW_PORT_X + 1) * 2, (MAP_MAX_CLIENT_VIEW_PORT_X + 1) * 2, (MAP_MAX_CLIENT_VIEW_PORT_Y + 1) * 2, (MAP_MAX_CLIENT_VIEW_PORT_Y + 1) * 2);
 		}
-	} else {
-		spectators = (*spectatorsPtr);
+		spectatorsPtr = &foundSpectators;
 	}
+	const auto &spectators = *spectatorsPtr;
 
-	// Send to client
+	// Send to client, the packet is the same for every spectator
+	BroadcastMessage message([&creature, type, &text, pos](NetworkMessage &msg, bool oldProtocol) {
+		ProtocolGame::addCreatureSay(msg, creature, type, text, pos, oldProtocol);
+	});
 	for (const auto &spectator : spectators) {
 		if (const auto &tmpPlayer = spectator->getPlayer()) {
 			if (!ghostMode || tmpPlayer->canSeeCreature(creature)) {
-				tmpPlayer->sendCreatureSay(creature, type, text, pos);
+				tmpPlayer->sendBroadcast(message);
 			}
 		}
 	}
 
 	// event method
 	for (const auto &spectator : spectators) {
-		spectator->onCreatureSay(creature, type, text);
+		if (spectator->wantsCreatureSay(creature)) {
+			spectator->onCreatureSay(creature, type, text);
+		}
 		if (creature != spectator) {
 			g_events().eventCreatureOnHear(spectator, creature, text, type);
 			g_callbacks().executeCallback(EventCallback_t::creatureOnHear, &EventCallback::creatureOnHear, spectator, creature, text, type);
@@ -6291,12 +6445,50 @@ bool Game::internalCreatureSay(std::shared_ptr<Creature> creature, SpeakClasses
 }
 
 void Game::checkCreatureWalk(uint32_t creatureId) {
+	FrameScope scope(FramePhase::Walks);
 	const auto &creature = getCreatureByID(creatureId);
 	if (creature && creature->getHealth() > 0) {
 		creature->onCreatureWalk();
 	}
 }
 
+uint32_t Game::addCreatureWalkBatch(uint32_t creatureId, int64_t delay) {
+	if (++lastCreatureWalkToken == 0) {
+		lastCreatureWalkToken = 1;
+	}
+
+	// Rounded to the nearest slot, so the creatures do not walk slower on average
+	const int64_t now = OTSYS_TIME();
+	const int64_t slot = std::max<int64_t>((now + delay + EVENT_WALK_BATCH_INTERVAL / 2) / EVENT_WALK_BATCH_INTERVAL, now / EVENT_WALK_BATCH_INTERVAL + 1);
+	auto &batch = creatureWalkBatches[slot];
+	if (batch.empty()) {
+		g_dispatcher().scheduleEvent(
+			static_cast<uint32_t>(slot * EVENT_WALK_BATCH_INTERVAL - now), [this, slot] { checkCreatureWalkBatch(slot); }, "Game::checkCreatureWalkBatch"
+		);
+	}
+	batch.emplace_back(creatureId, lastCreatureWalkToken);
+	return lastCreatureWalkToken;
+}
+
+void Game::checkCreatureWalkBatch(int64_t slot) {
+	auto it = creatureWalkBatches.find(slot);
+	if (it == creatureWalkBatches.end()) {
+		return;
+	}
+
+	// The steps taken here queue the next ones in later slots
+	const auto batch = std::move(it->second);
+	creatureWalkBatches.erase(it);
+
+	FrameScope scope(FramePhase::Walks);
+	for (const auto &[creatureId, token] : batch) {
+		const auto &creature = getCreatureByID(creatureId);
+		if (creature && creature->eventWalk == token && creature->getHealth() > 0) {
+			creature->onCreatureWalk();
+		}
+	}
+}
+
 void Game::updateCreatureWalk(uint32_t creatureId) {
 	const auto &creature = getCreatureByID(creatureId);
 	if (creature && creature->getHealth() > 0) {
@@ -6311,6 +6503,15 @@ void Game::checkCreatureAttack(uint32_t creatureId) {
 	}
 }
 
+void Game::countMemory(MemoryCensus &census) const {
+	map.countMemory(census);
+
+	// std::map nodes hold the pair and three pointers and a color
+	census.add("players", players.size(), players.size() * (MemoryCensus::sharedBytes<Player>() + sizeof(std::pair<uint32_t, std::shared_ptr<Player>>) + 1));
+	census.add("monsters", monsters.size(), monsters.size() * MemoryCensus::sharedBytes<Monster>() + monsters.memoryBytes());
+	census.add("npcs", npcs.size(), npcs.size() * MemoryCensus::sharedBytes<Npc>() + npcs.memoryBytes());
+}
+
 void Game::addCreatureCheck(const std::shared_ptr<Creature> &creature) {
 	creature->creatureCheck = true;
 
@@ -6332,21 +6533,16 @@ void Game::removeCreatureCheck(const std::shared_ptr<Creature> &creature) {
 
 void Game::checkCreatures() {
 	metrics::method_latency measure(__METHOD_NAME__);
+	FrameScope scope(FramePhase::CheckCreatures);
 	static size_t index = 0;
 
 	auto &checkCreatureList = checkCreatureLists[index];
+
+	// Remove the creatures that no longer need to be checked
 	size_t it = 0, end = checkCreatureList.size();
 	while (it < end) {
-		auto creature = checkCreatureList[it];
+		const auto &creature = checkCreatureList[it];
 		if (creature && creature->creatureCheck) {
-			if (creature->getHealth() > 0) {
-				creature->onThink(EVENT_CREATURE_THINK_INTERVAL);
-				creature->onAttacking(EVENT_CREATURE_THINK_INTERVAL);
-				creature->executeConditions(EVENT_CREATURE_THINK_INTERVAL);
-			} else {
-				afterCreatureZoneChange(creature, creature->getZones(), {});
-				creature->onDeath();
-			}
 			++it;
 		} else {
 			creature->inCheckCreaturesVector = false;
@@ -6357,6 +6553,41 @@ void Game::checkCreatures() {
 		}
 	}
 
+	// Decide: read-only work (e.g. target search and line of sight) runs in parallel
+	g_dispatcher().asyncWait(checkCreatureList.size(), [&checkCreatureList](size_t i) {
+		const auto &creature = checkCreatureList[i];
+		if (creature->getHealth() > 0) {
+			creature->onThinkDecide(EVENT_CREATURE_THINK_INTERVAL);
+		}
+	});
+
+	// Apply: every mutation happens here, serially and in the bucket order
+	// Creatures added to this bucket while thinking are only checked on its next turn
+	for (size_t i = 0, size = checkCreatureList.size(); i < size; ++i) {
+		const auto creature = checkCreatureList[i];
+		if (!creature->creatureCheck) {
+			continue;
+		}
+
+		if (creature->getHealth() > 0) {
+			const auto &monster = creature->getMonster();
+			const auto activity = monster ? monster->getSpawnActivity() : nullptr;
+			const auto thinkStart = activity ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point {};
+
+			creature->onThink(EVENT_CREATURE_THINK_INTERVAL);
+			creature->onAttacking(EVENT_CREATURE_THINK_INTERVAL);
+			creature->executeConditions(EVENT_CREATURE_THINK_INTERVAL);
+
+			if (activity) {
+				const auto thinkTime = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - thinkStart).count();
+				activity->thinkTime.fetch_add(static_cast<uint64_t>(thinkTime), std::memory_order_relaxed);
+			}
+		} else {
+			afterCreatureZoneChange(creature, creature->getZones(), {});
+			creature->onDeath();
+		}
+	}
+
 	index = (index + 1) % EVENT_CREATURECOUNT;
 }
 
@@ -6367,18 +6598,18 @@ void Game::changeSpeed(std::shared_ptr<Creature> creature, int32_t varSpeedDelta
 	creature->setSpeed(varSpeed);
 
 	// Send to clients
-	for (const auto &spectator : Spectators().find<Player>(creature->getPosition())) {
-		spectator->getPlayer()->sendChangeSpeed(creature, creature->getStepSpeed());
-	}
+	Spectators::forEach<Player>(creature->getPosition(), false, [&creature](Player &spectator) {
+		spectator.sendChangeSpeed(creature, creature->getStepSpeed());
+	});
 }
 
 void Game::setCreatureSpeed(std::shared_ptr<Creature> creature, int32_t speed) {
 	creature->setBaseSpeed(static_cast<uint16_t>(speed));
 
 	// Send creature speed to client
-	for (const auto &spectator : Spectators().find<Player>(creature->getPosition())) {
-		spectator->getPlayer()->sendChangeSpeed(creature, creature->getStepSpeed());
-	}
+	Spectators::forEach<Player>(creature->getPosition(), false, [&creature](Player &spectator) {
+		spectator.sendChangeSpeed(creature, creature->getStepSpeed());
+	});
 }
 
 void Game::changePlayerSpeed(const std::shared_ptr<Player> &player, int32_t varSpeedDelta) {
@@ -6388,9 +6619,9 @@ void Game::changePlayerSpeed(const std::shared_ptr<Player> &player, int32_t varS
 	player->setSpeed(varSpeed);
 
 	// Send new player speed to the spectators
-	for (const auto &creatureSpectator : Spectators().find<Player>(player->getPosition())) {
-		creatureSpectator->getPlayer()->sendChangeSpeed(player, player->getStepSpeed());
-	}
+	Spectators::forEach<Player>(player->getPosition(), false, [&player](Player &spectator) {
+		spectator.sendChangeSpeed(player, player->getStepSpeed());
+	});
 }
 
 void Game::internalCreatureChangeOutfit(std::shared_ptr<Creature> creature, const Outfit_t &outfit) {
@@ -6409,30 +6640,30 @@ void Game::internalCreatureChangeOutfit(std::shared_ptr<Creature> creature, cons
 	}
 
 	// Send to clients
-	for (const auto &spectator : Spectators().find<Player>(creature->getPosition(), true)) {
-		spectator->getPlayer()->sendCreatureChangeOutfit(creature, outfit);
-	}
+	Spectators::forEach<Player>(creature->getPosition(), true, [&creature, &outfit](Player &spectator) {
+		spectator.sendCreatureChangeOutfit(creature, outfit);
+	});
 }
 
 void Game::internalCreatureChangeVisible(std::shared_ptr<Creature> creature, bool visible) {
 	// Send to clients
-	for (const auto &spectator : Spectators().find<Player>(creature->getPosition(), true)) {
-		spectator->getPlayer()->sendCreatureChangeVisible(creature, visible);
-	}
+	Spectators::forEach<Player>(creature->getPosition(), true, [&creature, visible](Player &spectator) {
+		spectator.sendCreatureChangeVisible(creature, visible);
+	});
 }
 
 void Game::changeLight(std::shared_ptr<Creature> creature) {
 	// Send to clients
-	for (const auto &spectator : Spectators().find<Player>(creature->getPosition(), true)) {
-		spectator->getPlayer()->sendCreatureLight(creature);
-	}
+	Spectators::forEach<Player>(creature->getPosition(), true, [&creature](Player &spectator) {
+		spectator.sendCreatureLight(creature);
+	});
 }
 
 void Game::updateCreatureIcon(std::shared_ptr<Creature> creature) {
 	// Send to clients
-	for (const auto &spectator : Spectators().find<Player>(creature->getPosition(), true)) {
-		spectator->getPlayer()->sendCreatureIcon(creature);
-	}
+	Spectators::forEach<Player>(creature->getPosition(), true, [&creature](Player &spectator) {
+		spectator.sendCreatureIcon(creature);
+	});
 }
 
 void Game::reloadCreature(std::shared_ptr<Creature> creature) {
@@ -6874,7 +7105,7 @@ void Game::applyWheelOfDestinyHealing(CombatDamage &damage, std::shared_ptr<Play
 			combatChangeHealth(attackerPlayer, attackerPlayer, tmpDamage);
 		}
 
-		if (attackerPlayer->wheel()->getInstant("Blessing of the Grove")) {
+		if (attackerPlayer->wheel()->getStage(WheelStage_t::BLESSING_OF_THE_GROVE) > 0) {
 			damage.primary.value += (damage.primary.value * attackerPlayer->wheel()->checkBlessingGroveHealingByTarget(target)) / 100.;
 		}
 	}
@@ -6925,7 +7156,7 @@ int32_t Game::applyHealthChange(CombatDamage &damage, std::shared_ptr<Creature>
 
 	// Wheel of destiny (Gift of Life)
 	if (std::shared_ptr<Player> targetPlayer = target->getPlayer()) {
-		if (targetPlayer->wheel()->getInstant("Gift of Life") && targetPlayer->wheel()->getGiftOfCooldown() == 0 && (damage.primary.value + damage.secondary.value) >= targetHealth) {
+		if (targetPlayer->wheel()->getStage(WheelStage_t::GIFT_OF_LIFE) > 0 && targetPlayer->wheel()->getGiftOfCooldown() == 0 && (damage.primary.value + damage.secondary.value) >= targetHealth) {
 			int32_t overkillMultiplier = (damage.primary.value + damage.secondary.value) - targetHealth;
 			overkillMultiplier = (overkillMultiplier * 100) / targetPlayer->getMaxHealth();
 			if (overkillMultiplier <= targetPlayer->wheel()->getGiftOfLifeValue()) {
@@ -7861,27 +8092,41 @@ void Game::addPlayerVocation(std::shared_ptr<Player> target) {
 }
 
 void Game::addMagicEffect(const Position &pos, uint16_t effect) {
-	auto spectators = Spectators().find<Player>(pos, true);
-	addMagicEffect(spectators.data(), pos, effect);
+	BroadcastMessage message(pos, [&pos, effect](NetworkMessage &msg, bool oldProtocol) {
+		ProtocolGame::addMagicEffect(msg, pos, effect, oldProtocol);
+	});
+	Spectators::forEach<Player>(pos, true, [&message](Player &spectator) {
+		spectator.sendBroadcast(message);
+	});
 }
 
 void Game::addMagicEffect(const CreatureVector &spectators, const Position &pos, uint16_t effect) {
+	BroadcastMessage message(pos, [&pos, effect](NetworkMessage &msg, bool oldProtocol) {
+		ProtocolGame::addMagicEffect(msg, pos, effect, oldProtocol);
+	});
 	for (const auto &spectator : spectators) {
 		if (const auto &tmpPlayer = spectator->getPlayer()) {
-			tmpPlayer->sendMagicEffect(pos, effect);
+			tmpPlayer->sendBroadcast(message);
 		}
 	}
 }
 
 void Game::removeMagicEffect(const Position &pos, uint16_t effect) {
-	auto spectators = Spectators().find<Player>(pos, true);
-	removeMagicEffect(spectators.data(), pos, effect);
+	BroadcastMessage message([&pos, effect](NetworkMessage &msg, bool oldProtocol) {
+		ProtocolGame::addRemoveMagicEffect(msg, pos, effect, oldProtocol);
+	});
+	Spectators::forEach<Player>(pos, true, [&message](Player &spectator) {
+		spectator.sendBroadcast(message);
+	});
 }
 
 void Game::removeMagicEffect(const CreatureVector &spectators, const Position &pos, uint16_t effect) {
+	BroadcastMessage message([&pos, effect](NetworkMessage &msg, bool oldProtocol) {
+		ProtocolGame::addRemoveMagicEffect(msg, pos, effect, oldProtocol);
+	});
 	for (const auto &spectator : spectators) {
 		if (const auto &tmpPlayer = spectator->getPlayer()) {
-			tmpPlayer->removeMagicEffect(pos, effect);
+			tmpPlayer->sendBroadcast(message);
 		}
 	}
 }
@@ -7892,9 +8137,12 @@ void Game::addDistanceEffect(const Position &fromPos, const Position &toPos, uin
 }
 
 void Game::addDistanceEffect(const CreatureVector &spectators, const Position &fromPos, const Position &toPos, uint16_t effect) {
+	BroadcastMessage message([&fromPos, &toPos, effect](NetworkMessage &msg, bool oldProtocol) {
+		ProtocolGame::addDistanceShoot(msg, fromPos, toPos, effect, oldProtocol);
+	});
 	for (const auto &spectator : spectators) {
 		if (const auto &tmpPlayer = spectator->getPlayer()) {
-			tmpPlayer->sendDistanceShoot(fromPos, toPos, effect);
+			tmpPlayer->sendBroadcast(message);
 		}
 	}
 }
@@ -7909,6 +8157,55 @@ void Game::checkImbuements() {
 	}
 }
 
+void Game::addTileToClean(std::shared_ptr<Tile> tile) {
+	const int64_t now = OTSYS_TIME();
+	if (tilesToClean.try_emplace(tile, now).second && g_configManager().getNumber(MAP_CLEAN_DELAY, __FUNCTION__) > 0) {
+		tilesToCleanQueue.emplace_back(std::move(tile), now);
+	}
+}
+
+void Game::checkTilesToClean() {
+	const int64_t delay = g_configManager().getNumber(MAP_CLEAN_DELAY, __FUNCTION__) * 1000;
+	if (delay <= 0) {
+		tilesToCleanQueue.clear();
+		return;
+	}
+
+	const int64_t now = OTSYS_TIME();
+	auto tilesLeft = std::max<int32_t>(g_configManager().getNumber(MAP_CLEAN_BATCH_SIZE, __FUNCTION__), 1);
+	ItemVector toRemove;
+	while (tilesLeft > 0 && !tilesToCleanQueue.empty()) {
+		const auto [tile, addedAt] = tilesToCleanQueue.front();
+		if (addedAt + delay > now) {
+			break;
+		}
+		tilesToCleanQueue.pop_front();
+
+		const auto it = tilesToClean.find(tile);
+		if (it == tilesToClean.end() || it->second != addedAt) {
+			continue;
+		}
+		tilesToClean.erase(it);
+		--tilesLeft;
+
+		if (const auto items = tile->getItemList()) {
+			for (const auto &item : *items) {
+				if (item->isCleanable()) {
+					toRemove.emplace_back(item);
+				}
+			}
+		}
+	}
+
+	for (const auto &item : toRemove) {
+		internalRemoveItem(item, -1);
+	}
+
+	if (!toRemove.empty()) {
+		g_logger().trace("[Game::checkTilesToClean] - Removed {} items", toRemove.size());
+	}
+}
+
 void Game::checkLight() {
 	lightHour += lightHourDelta;
 
@@ -7952,16 +8249,27 @@ void Game::checkLight() {
 
 	LightInfo lightInfo = getWorldLightInfo();
 
-	if (lightChange) {
-		for ([[maybe_unused]] const auto &[mapPlayerId, mapPlayer] : getPlayers()) {
-			mapPlayer->sendWorldLight(lightInfo);
-			mapPlayer->sendTibiaTime(lightHour);
+	// Serialized once per protocol version, the staff always see the full light
+	const auto message = std::make_shared<BroadcastMessage>([lightChange, lightInfo, hour = lightHour](NetworkMessage &msg, bool oldProtocol) {
+		if (lightChange) {
+			ProtocolGame::addWorldLight(msg, lightInfo);
 		}
-	} else {
-		for ([[maybe_unused]] const auto &[mapPlayerId, mapPlayer] : getPlayers()) {
-			mapPlayer->sendTibiaTime(lightHour);
+		ProtocolGame::addTibiaTime(msg, hour, oldProtocol);
+	});
+	const auto accessMessage = std::make_shared<BroadcastMessage>([lightChange, color = lightInfo.color, hour = lightHour](NetworkMessage &msg, bool oldProtocol) {
+		if (lightChange) {
+			ProtocolGame::addWorldLight(msg, { 0xFF, color });
 		}
+		ProtocolGame::addTibiaTime(msg, hour, oldProtocol);
+	});
+
+	auto recipients = std::make_shared<std::vector<std::weak_ptr<Player>>>();
+	recipients->reserve(getPlayers().size());
+	for ([[maybe_unused]] const auto &[mapPlayerId, mapPlayer] : getPlayers()) {
+		recipients->emplace_back(mapPlayer);
 	}
+	sendLightBroadcast(recipients, 0, message, accessMessage);
+
 	if (currentLightState != lightState) {
 		currentLightState = lightState;
 		for (const auto &[eventName, globalEvent] : g_globalEvents().getEventMap(GLOBALEVENT_PERIODCHANGE)) {
@@ -7970,6 +8278,57 @@ void Game::checkLight() {
 	}
 }
 
+void Game::sendLightBroadcast(const std::shared_ptr<std::vector<std::weak_ptr<Player>>> &recipients, size_t offset, const std::shared_ptr<BroadcastMessage> &message, const std::shared_ptr<BroadcastMessage> &accessMessage) {
+	const size_t end = std::min(offset + LIGHT_BROADCAST_BATCH_SIZE, recipients->size());
+	for (size_t i = offset; i < end; ++i) {
+		if (const auto &player = (*recipients)[i].lock()) {
+			player->sendBroadcast(player->isAccessPlayer() ? *accessMessage : *message);
+		}
+	}
+
+	// The rest goes out in the next dispatcher cycles, so a full server is not all sent in one
+	if (end < recipients->size()) {
+		g_dispatcher().addEvent([recipients, end, message, accessMessage] { g_game().sendLightBroadcast(recipients, end, message, accessMessage); }, "Game::sendLightBroadcast");
+	}
+}
+
+std::shared_ptr<const WorldSnapshot> Game::getWorldSnapshot() const {
+	std::scoped_lock lock(worldSnapshotMutex);
+	return worldSnapshot;
+}
+
+void Game::updateWorldSnapshot() {
+	auto next = std::make_shared<WorldSnapshot>();
+	next->builtAt = OTSYS_TIME();
+
+	const size_t count = players.size();
+	next->guids.reserve(count);
+	next->names.reserve(count);
+	next->levels.reserve(count);
+	next->vocations.reserve(count);
+	next->guildIds.reserve(count);
+	next->positions.reserve(count);
+	next->ips.reserve(count);
+	for (const auto &[playerId, player] : players) {
+		next->guids.emplace_back(player->getGUID());
+		next->names.emplace_back(player->getName());
+		next->levels.emplace_back(player->getLevel());
+		next->vocations.emplace_back(player->getVocationId());
+		const auto &guild = player->getGuild();
+		next->guildIds.emplace_back(guild ? guild->getId() : 0);
+		next->positions.emplace_back(player->getPosition());
+		next->ips.emplace_back(player->getIP());
+	}
+
+	next->playersRecord = playersRecord;
+	next->monstersOnline = static_cast<uint32_t>(monsters.size());
+	next->npcsOnline = static_cast<uint32_t>(npcs.size());
+	getMapDimensions(next->mapWidth, next->mapHeight);
+
+	std::scoped_lock lock(worldSnapshotMutex);
+	worldSnapshot = std::move(next);
+}
+
 LightInfo Game::getWorldLightInfo() const {
 	return { lightLevel, 0xD7 };
 }
@@ -8002,9 +8361,11 @@ void Game::shutdown() {
 	}
 
 	ConnectionManager::getInstance().closeAll();
+	IOMarket::getInstance().flushWrites();
 
 	g_luaEnvironment().collectGarbage();
 
+	Item::logPoolStats();
 	g_logger().info("Done!");
 }
 
@@ -8322,6 +8683,11 @@ void Game::playerCyclopediaCharacterInfo(std::shared_ptr<Player> player, uint32_
 		return;
 	}
 
+	// The item summary walks every container of the player, the outfits list every outfit and mount
+	if ((characterInfoType == CYCLOPEDIA_CHARACTERINFO_ITEMSUMMARY || characterInfoType == CYCLOPEDIA_CHARACTERINFO_OUTFITSMOUNTS) && player->sendCachedCyclopediaCharacterInfo(characterInfoType)) {
+		return;
+	}
+
 	switch (characterInfoType) {
 		case CYCLOPEDIA_CHARACTERINFO_BASEINFORMATION:
 			player->sendCyclopediaCharacterBaseInformation();
@@ -8372,171 +8738,23 @@ void Game::playerCyclopediaCharacterInfo(std::shared_ptr<Player> player, uint32_
 	}
 }
 
-std::string Game::generateHighscoreQueryForEntries(const std::string &categoryName, uint32_t page, uint8_t entriesPerPage, uint32_t vocation) {
-	std::ostringstream query;
-	uint32_t startPage = (static_cast<uint32_t>(page - 1) * static_cast<uint32_t>(entriesPerPage));
-	uint32_t endPage = startPage + static_cast<uint32_t>(entriesPerPage);
-
-	query << "SELECT *, @row AS `entries`, " << page << " AS `page` FROM (SELECT *, (@row := @row + 1) AS `rn` FROM (SELECT `id`, `name`, `level`, `vocation`, `"
-		  << categoryName << "` AS `points`, @curRank := IF(@prevRank = `" << categoryName << "`, @curRank, IF(@prevRank := `" << categoryName
-		  << "`, @curRank + 1, @curRank + 1)) AS `rank` FROM `players` `p`, (SELECT @curRank := 0, @prevRank := NULL, @row := 0) `r` WHERE `group_id` < "
-		  << static_cast<int>(GROUP_TYPE_GAMEMASTER) << " ORDER BY `" << categoryName << "` DESC) `t`";
-
-	if (vocation != 0xFFFFFFFF) {
-		query << generateVocationConditionHighscore(vocation);
-	}
-	query << ") `T` WHERE `rn` > " << startPage << " AND `rn` <= " << endPage;
-
-	return query.str();
-}
-
-std::string Game::generateHighscoreQueryForOurRank(const std::string &categoryName, uint8_t entriesPerPage, uint32_t playerGUID, uint32_t vocation) {
-	std::ostringstream query;
-	std::string entriesStr = std::to_string(entriesPerPage);
-
-	query << "SELECT *, @row AS `entries`, (@ourRow DIV " << entriesStr << ") + 1 AS `page` FROM (SELECT *, (@row := @row + 1) AS `rn`, @ourRow := IF(`id` = "
-		  << playerGUID << ", @row - 1, @ourRow) AS `rw` FROM (SELECT `id`, `name`, `level`, `vocation`, `" << categoryName << "` AS `points`, @curRank := IF(@prevRank = `"
-		  << categoryName << "`, @curRank, IF(@prevRank := `" << categoryName << "`, @curRank + 1, @curRank + 1)) AS `rank` FROM `players` `p`, (SELECT @curRank := 0, @prevRank := NULL, @row := 0, @ourRow := 0) `r` WHERE `group_id` < "
-		  << static_cast<int>(GROUP_TYPE_GAMEMASTER) << " ORDER BY `" << categoryName << "` DESC) `t`";
-
-	if (vocation != 0xFFFFFFFF) {
-		query << generateVocationConditionHighscore(vocation);
-	}
-	query << ") `T` WHERE `rn` > ((@ourRow DIV " << entriesStr << ") * " << entriesStr << ") AND `rn` <= (((@ourRow DIV " << entriesStr << ") * " << entriesStr << ") + " << entriesStr << ")";
-
-	return query.str();
-}
-
-std::string Game::generateVocationConditionHighscore(uint32_t vocation) {
-	std::ostringstream queryPart;
-	bool firstVocation = true;
-
-	const auto vocationsMap = g_vocations().getVocations();
-	for (const auto &it : vocationsMap) {
-		const auto &voc = it.second;
-		if (voc->getFromVocation() == vocation) {
-			if (firstVocation) {
-				queryPart << " WHERE `vocation` = " << voc->getId();
-				firstVocation = false;
-			} else {
-				queryPart << " OR `vocation` = " << voc->getId();
-			}
-		}
-	}
-
-	return queryPart.str();
-}
-
-void Game::processHighscoreResults(DBResult_ptr result, uint32_t playerID, uint8_t category, uint32_t vocation, uint8_t entriesPerPage) {
-	std::shared_ptr<Player> player = g_game().getPlayerByID(playerID);
-	if (!player) {
+void Game::playerHighscores(std::shared_ptr<Player> player, HighscoreType_t type, uint8_t category, uint32_t vocation, const std::string &, uint16_t page, uint8_t entriesPerPage) {
+	if (type != HIGHSCORE_GETENTRIES && type != HIGHSCORE_OURRANK) {
 		return;
 	}
 
-	player->resetAsyncOngoingTask(PlayerAsyncTask_Highscore);
+	// Normalizes the category, the ones without a ranking are shown as experience
+	getSkillNameById(category);
 
-	if (!result) {
+	std::vector<HighscoreCharacter> characters;
+	uint32_t pages = 0;
+	const uint32_t ourGuid = type == HIGHSCORE_OURRANK ? player->getGUID() : 0;
+	if (!g_highscoreIndex().getPage(category, vocation, page, entriesPerPage, ourGuid, characters, pages)) {
 		player->sendHighscoresNoData();
 		return;
 	}
 
-	uint16_t page = result->getNumber<uint16_t>("page");
-	uint32_t pages = result->getNumber<uint32_t>("entries");
-	pages += entriesPerPage - 1;
-	pages /= entriesPerPage;
-
-	std::ostringstream cacheKeyStream;
-	cacheKeyStream << "Highscore_" << static_cast<int>(category) << "_" << static_cast<int>(vocation) << "_" << static_cast<int>(entriesPerPage) << "_" << page;
-	std::string cacheKey = cacheKeyStream.str();
-
-	auto it = highscoreCache.find(cacheKey);
-	auto now = std::chrono::system_clock::now();
-	if (it != highscoreCache.end() && (now - it->second.timestamp < HIGHSCORE_CACHE_EXPIRATION_TIME)) {
-		auto &cacheEntry = it->second;
-		auto cachedTime = it->second.timestamp;
-		auto durationSinceEpoch = cachedTime.time_since_epoch();
-		auto secondsSinceEpoch = std::chrono::duration_cast<std::chrono::seconds>(durationSinceEpoch).count();
-		auto updateTimer = static_cast<uint32_t>(secondsSinceEpoch);
-		player->sendHighscores(cacheEntry.characters, category, vocation, cacheEntry.page, static_cast<uint16_t>(cacheEntry.entriesPerPage), updateTimer);
-	} else {
-		std::vector<HighscoreCharacter> characters;
-		characters.reserve(result->countResults());
-		if (result) {
-			do {
-				const auto &voc = g_vocations().getVocation(result->getNumber<uint16_t>("vocation"));
-				uint8_t characterVocation = voc ? voc->getClientId() : 0;
-				std::string loyaltyTitle = ""; // todo get loyalty title from player
-				characters.emplace_back(std::move(result->getString("name")), result->getNumber<uint64_t>("points"), result->getNumber<uint32_t>("id"), result->getNumber<uint32_t>("rank"), result->getNumber<uint16_t>("level"), characterVocation, loyaltyTitle);
-			} while (result->next());
-		}
-
-		player->sendHighscores(characters, category, vocation, page, static_cast<uint16_t>(pages), getTimeNow());
-		highscoreCache[cacheKey] = { characters, page, pages, now };
-	}
-}
-
-void Game::cacheQueryHighscore(const std::string &key, const std::string &query, uint32_t page, uint8_t entriesPerPage) {
-	QueryHighscoreCacheEntry queryEntry { query, page, entriesPerPage, std::chrono::steady_clock::now() };
-	queryCache[key] = queryEntry;
-}
-
-std::string Game::generateHighscoreOrGetCachedQueryForEntries(const std::string &categoryName, uint32_t page, uint8_t entriesPerPage, uint32_t vocation) {
-	std::ostringstream cacheKeyStream;
-	cacheKeyStream << "Entries_" << categoryName << "_" << page << "_" << static_cast<int>(entriesPerPage) << "_" << vocation;
-	std::string cacheKey = cacheKeyStream.str();
-
-	if (queryCache.find(cacheKey) != queryCache.end()) {
-		const QueryHighscoreCacheEntry &cachedEntry = queryCache[cacheKey];
-		if (cachedEntry.page == page) {
-			return cachedEntry.query;
-		}
-	}
-
-	std::string newQuery = generateHighscoreQueryForEntries(categoryName, page, entriesPerPage, vocation);
-	cacheQueryHighscore(cacheKey, newQuery, page, entriesPerPage);
-
-	return newQuery;
-}
-
-std::string Game::generateHighscoreOrGetCachedQueryForOurRank(const std::string &categoryName, uint8_t entriesPerPage, uint32_t playerGUID, uint32_t vocation) {
-	std::ostringstream cacheKeyStream;
-	cacheKeyStream << "OurRank_" << categoryName << "_" << static_cast<int>(entriesPerPage) << "_" << playerGUID << "_" << vocation;
-	std::string cacheKey = cacheKeyStream.str();
-
-	if (queryCache.find(cacheKey) != queryCache.end()) {
-		const QueryHighscoreCacheEntry &cachedEntry = queryCache[cacheKey];
-		if (cachedEntry.page == entriesPerPage) {
-			return cachedEntry.query;
-		}
-	}
-
-	std::string newQuery = generateHighscoreQueryForOurRank(categoryName, entriesPerPage, playerGUID, vocation);
-	cacheQueryHighscore(cacheKey, newQuery, entriesPerPage, entriesPerPage);
-
-	return newQuery;
-}
-
-void Game::playerHighscores(std::shared_ptr<Player> player, HighscoreType_t type, uint8_t category, uint32_t vocation, const std::string &, uint16_t page, uint8_t entriesPerPage) {
-	if (player->hasAsyncOngoingTask(PlayerAsyncTask_Highscore)) {
-		return;
-	}
-
-	std::string categoryName = getSkillNameById(category);
-
-	std::string query;
-	if (type == HIGHSCORE_GETENTRIES) {
-		query = generateHighscoreOrGetCachedQueryForEntries(categoryName, page, entriesPerPage, vocation);
-	} else if (type == HIGHSCORE_OURRANK) {
-		query = generateHighscoreOrGetCachedQueryForOurRank(categoryName, entriesPerPage, player->getGUID(), vocation);
-	}
-
-	uint32_t playerID = player->getID();
-	std::function<void(DBResult_ptr, bool)> callback = [this, playerID, category, vocation, entriesPerPage](DBResult_ptr result, bool) {
-		processHighscoreResults(std::move(result), playerID, category, vocation, entriesPerPage);
-	};
-
-	g_databaseTasks().store(query, callback);
-	player->addAsyncOngoingTask(PlayerAsyncTask_Highscore);
+	player->sendHighscores(characters, category, vocation, page, static_cast<uint16_t>(pages), getTimeNow());
 }
 
 std::string Game::getSkillNameById(uint8_t &skill) {
@@ -8935,6 +9153,7 @@ void Game::playerCreateMarketOffer(uint32_t playerId, uint8_t type, uint16_t ite
 
 	// Exhausted for create offert in the market
 	player->updateUIExhausted();
+	player->scheduleJournal();
 	g_saveManager().savePlayer(player);
 }
 
@@ -9017,6 +9236,7 @@ void Game::playerCancelMarketOffer(uint32_t playerId, uint32_t timestamp, uint16
 	player->sendMarketEnter(player->getLastDepotId());
 	// Exhausted for cancel offer in the market
 	player->updateUIExhausted();
+	player->scheduleJournal();
 	g_saveManager().savePlayer(player);
 }
 
@@ -9166,6 +9386,8 @@ void Game::playerAcceptMarketOffer(uint32_t playerId, uint32_t timestamp, uint16
 
 		if (buyerPlayer->isOffline()) {
 			g_saveManager().savePlayer(buyerPlayer);
+		} else {
+			buyerPlayer->scheduleJournal();
 		}
 	} else if (offer.type == MARKETACTION_SELL) {
 		std::shared_ptr<Player> sellerPlayer = getPlayerByGUID(offer.playerId, true);
@@ -9260,6 +9482,8 @@ void Game::playerAcceptMarketOffer(uint32_t playerId, uint32_t timestamp, uint16
 
 		if (sellerPlayer->isOffline()) {
 			g_saveManager().savePlayer(sellerPlayer);
+		} else {
+			sellerPlayer->scheduleJournal();
 		}
 	}
 
@@ -9290,6 +9514,7 @@ void Game::playerAcceptMarketOffer(uint32_t playerId, uint32_t timestamp, uint16
 	player->sendMarketAcceptOffer(offer);
 	// Exhausted for accept offer in the market
 	player->updateUIExhausted();
+	player->scheduleJournal();
 	g_saveManager().savePlayer(player);
 }
 
@@ -9770,31 +9995,98 @@ void Game::updatePlayerSaleItems(uint32_t playerId) {
 void Game::addPlayer(std::shared_ptr<Player> player) {
 	const std::string &lowercase_name = asLowerCaseString(player->getName());
 	mappedPlayerNames[lowercase_name] = player;
-	wildcardTree->insert(lowercase_name);
+	mappedPlayerGuids[player->getGUID()] = player;
+	wildcardTree.insert(lowercase_name);
 	players[player->getID()] = player;
+	for (const auto vipGuid : player->vip()->getGuids()) {
+		addVipWatcher(vipGuid, player->getID());
+	}
+	// The offline copy is outdated from now on
+	removeOfflinePlayer(player->getGUID());
 }
 
 void Game::removePlayer(std::shared_ptr<Player> player) {
 	const std::string &lowercase_name = asLowerCaseString(player->getName());
 	mappedPlayerNames.erase(lowercase_name);
-	wildcardTree->remove(lowercase_name);
+	mappedPlayerGuids.erase(player->getGUID());
+	wildcardTree.remove(lowercase_name);
 	players.erase(player->getID());
+	for (const auto vipGuid : player->vip()->getGuids()) {
+		removeVipWatcher(vipGuid, player->getID());
+	}
+}
+
+void Game::addVipWatcher(uint32_t vipGuid, uint32_t playerId) {
+	vipWatchers[vipGuid].emplace(playerId);
+}
+
+void Game::removeVipWatcher(uint32_t vipGuid, uint32_t playerId) {
+	const auto it = vipWatchers.find(vipGuid);
+	if (it == vipWatchers.end()) {
+		return;
+	}
+
+	it->second.erase(playerId);
+	if (it->second.empty()) {
+		vipWatchers.erase(it);
+	}
+}
+
+std::vector<std::shared_ptr<Player>> Game::getVipWatchers(uint32_t vipGuid) const {
+	std::vector<std::shared_ptr<Player>> watchers;
+	const auto it = vipWatchers.find(vipGuid);
+	if (it == vipWatchers.end()) {
+		return watchers;
+	}
+
+	watchers.reserve(it->second.size());
+	for (const auto playerId : it->second) {
+		if (const auto playerIt = players.find(playerId); playerIt != players.end()) {
+			watchers.emplace_back(playerIt->second);
+		}
+	}
+	return watchers;
 }
 
 void Game::addNpc(std::shared_ptr<Npc> npc) {
-	npcs[npc->getID()] = npc;
+	npcs.set(npc->getID(), npc);
 }
 
 void Game::removeNpc(std::shared_ptr<Npc> npc) {
-	npcs.erase(npc->getID());
+	npcs.release(npc->getID());
 }
 
 void Game::addMonster(std::shared_ptr<Monster> monster) {
-	monsters[monster->getID()] = monster;
+	monsters.set(monster->getID(), monster);
 }
 
 void Game::removeMonster(std::shared_ptr<Monster> monster) {
-	monsters.erase(monster->getID());
+	monsters.release(monster->getID());
+}
+
+uint32_t Game::reserveMonsterID(uint32_t id) {
+	// A monster placed again after its removal gets a new id, its slot may have been reused
+	if (id != 0 && monsters.isReserved(id)) {
+		return id;
+	}
+
+	const auto newId = monsters.reserve();
+	if (newId == 0) {
+		g_logger().error("[{}] - All the monster ids are in use", __FUNCTION__);
+	}
+	return newId;
+}
+
+uint32_t Game::reserveNpcID(uint32_t id) {
+	if (id != 0 && npcs.isReserved(id)) {
+		return id;
+	}
+
+	const auto newId = npcs.reserve();
+	if (newId == 0) {
+		g_logger().error("[{}] - All the npc ids are in use", __FUNCTION__);
+	}
+	return newId;
 }
 
 std::shared_ptr<Guild> Game::getGuild(uint32_t id, bool allowOffline /* = flase */) const {
@@ -10467,73 +10759,81 @@ void Game::setTransferPlayerHouseItems(uint32_t houseId, uint32_t playerId) {
 	transferHouseItemsToPlayer[houseId] = playerId;
 }
 
-template <typename T>
-std::vector<T> setDifference(const std::unordered_set<T> &setA, const std::unordered_set<T> &setB) {
-	std::vector<T> setResult;
-	setResult.reserve(setA.size());
-
-	for (const auto &elem : setA) {
-		if (!setB.contains(elem)) {
-			setResult.emplace_back(elem);
+/**
+ * Calls f for the zones of zonesA that are not in zonesB, both sorted by address, without allocating.
+ * Stops when f returns false.
+ * @return false if f stopped it.
+ */
+template <typename F>
+static bool forEachZoneDifference(const ZoneVector &zonesA, const ZoneVector &zonesB, F &&f) {
+	auto other = zonesB.begin();
+	for (const auto &zone : zonesA) {
+		while (other != zonesB.end() && *other < zone) {
+			++other;
+		}
+		if (other != zonesB.end() && *other == zone) {
+			continue;
+		}
+		if (!f(zone)) {
+			return false;
 		}
 	}
-
-	return setResult;
+	return true;
 }
 
-ReturnValue Game::beforeCreatureZoneChange(std::shared_ptr<Creature> creature, const std::unordered_set<std::shared_ptr<Zone>> &fromZones, const std::unordered_set<std::shared_ptr<Zone>> &toZones, bool force /* = false*/) const {
+ReturnValue Game::beforeCreatureZoneChange(std::shared_ptr<Creature> creature, const ZoneVector &fromZones, const ZoneVector &toZones, bool force /* = false*/) const {
 	if (!creature) {
 		return RETURNVALUE_NOTPOSSIBLE;
 	}
 
-	// fromZones - toZones = zones that creature left
-	const auto &zonesLeaving = setDifference(fromZones, toZones);
-	// toZones - fromZones = zones that creature entered
-	const auto &zonesEntering = setDifference(toZones, fromZones);
-
-	if (zonesLeaving.empty() && zonesEntering.empty()) {
+	// Most moves stay in the same zones, usually none
+	if (std::ranges::equal(fromZones, toZones)) {
 		return RETURNVALUE_NOERROR;
 	}
 
-	for (const auto &zone : zonesLeaving) {
+	// fromZones - toZones = zones that creature left
+	const bool canLeave = forEachZoneDifference(fromZones, toZones, [&](const std::shared_ptr<Zone> &zone) {
 		bool allowed = g_callbacks().checkCallback(EventCallback_t::zoneBeforeCreatureLeave, &EventCallback::zoneBeforeCreatureLeave, zone, creature);
-		if (!force && !allowed) {
-			return RETURNVALUE_NOTPOSSIBLE;
-		}
+		return force || allowed;
+	});
+	if (!canLeave) {
+		return RETURNVALUE_NOTPOSSIBLE;
 	}
 
-	for (const auto &zone : zonesEntering) {
+	// toZones - fromZones = zones that creature entered
+	const bool canEnter = forEachZoneDifference(toZones, fromZones, [&](const std::shared_ptr<Zone> &zone) {
 		bool allowed = g_callbacks().checkCallback(EventCallback_t::zoneBeforeCreatureEnter, &EventCallback::zoneBeforeCreatureEnter, zone, creature);
-		if (!force && !allowed) {
-			return RETURNVALUE_NOTPOSSIBLE;
-		}
+		return force || allowed;
+	});
+	if (!canEnter) {
+		return RETURNVALUE_NOTPOSSIBLE;
 	}
 	return RETURNVALUE_NOERROR;
 }
 
-void Game::afterCreatureZoneChange(std::shared_ptr<Creature> creature, const std::unordered_set<std::shared_ptr<Zone>> &fromZones, const std::unordered_set<std::shared_ptr<Zone>> &toZones) const {
-	if (!creature) {
+void Game::afterCreatureZoneChange(std::shared_ptr<Creature> creature, const ZoneVector &fromZones, const ZoneVector &toZones) const {
+	if (!creature || std::ranges::equal(fromZones, toZones)) {
 		return;
 	}
 
-	// fromZones - toZones = zones that creature left
-	const auto &zonesLeaving = setDifference(fromZones, toZones);
-	// toZones - fromZones = zones that creature entered
-	const auto &zonesEntering = setDifference(toZones, fromZones);
-
-	for (const auto &zone : zonesLeaving) {
+	// fromZones - toZones = zones that creature left, toZones - fromZones = zones that creature entered
+	forEachZoneDifference(fromZones, toZones, [&](const std::shared_ptr<Zone> &zone) {
 		zone->creatureRemoved(creature);
-	}
-	for (const auto &zone : zonesEntering) {
+		return true;
+	});
+	forEachZoneDifference(toZones, fromZones, [&](const std::shared_ptr<Zone> &zone) {
 		zone->creatureAdded(creature);
-	}
+		return true;
+	});
 
-	for (const auto &zone : zonesLeaving) {
+	forEachZoneDifference(fromZones, toZones, [&](const std::shared_ptr<Zone> &zone) {
 		g_callbacks().executeCallback(EventCallback_t::zoneAfterCreatureLeave, &EventCallback::zoneAfterCreatureLeave, zone, creature);
-	}
-	for (const auto &zone : zonesEntering) {
+		return true;
+	});
+	forEachZoneDifference(toZones, fromZones, [&](const std::shared_ptr<Zone> &zone) {
 		g_callbacks().executeCallback(EventCallback_t::zoneAfterCreatureEnter, &EventCallback::zoneAfterCreatureEnter, zone, creature);
-	}
+		return true;
+	});
 }
 
 const std::unordered_map<uint8_t, std::string> &Game::getHighscoreCategoriesName() const {
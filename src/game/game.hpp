@@ -21,6 +21,7 @@
 #include "creatures/players/player.hpp"
 #include "lua/creature/raids.hpp"
 #include "creatures/players/grouping/team_finder.hpp"
+#include "utils/slot_table.hpp"
 #include "utils/wildcardtree.hpp"
 #include "items/items_classification.hpp"
 #include "modal_window/modal_window.hpp"
@@ -47,6 +48,9 @@ class ItemClassification;
 class Guild;
 class Mounts;
 class Spectators;
+class MemoryCensus;
+class BroadcastMessage;
+struct WorldSnapshot;
 
 struct Achievement;
 struct HighscoreCategory;
@@ -56,27 +60,17 @@ struct Title;
 static constexpr uint16_t SERVER_BEAT = 0x32;
 static constexpr int32_t EVENT_MS = 10000;
 static constexpr int32_t EVENT_LIGHTINTERVAL_MS = 10000;
+// Players sent the light and time update per dispatcher cycle
+static constexpr size_t LIGHT_BROADCAST_BATCH_SIZE = 500;
 static constexpr int32_t EVENT_DECAYINTERVAL = 250;
 static constexpr int32_t EVENT_DECAY_BUCKETS = 4;
 static constexpr int32_t EVENT_FORGEABLEMONSTERCHECKINTERVAL = 300000;
 static constexpr int32_t EVENT_LUA_GARBAGE_COLLECTION = 60000 * 10; // 10min
-
-static constexpr std::chrono::minutes CACHE_EXPIRATION_TIME { 10 }; // 10min
-static constexpr std::chrono::minutes HIGHSCORE_CACHE_EXPIRATION_TIME { 10 }; // 10min
-
-struct QueryHighscoreCacheEntry {
-	std::string query;
-	uint32_t page;
-	uint8_t entriesPerPage;
-	std::chrono::time_point<std::chrono::steady_clock> timestamp;
-};
-
-struct HighscoreCacheEntry {
-	std::vector<HighscoreCharacter> characters;
-	uint32_t page;
-	uint32_t entriesPerPage;
-	std::chrono::time_point<std::chrono::system_clock> timestamp;
-};
+static constexpr int32_t EVENT_MAP_TILE_EVICTION_INTERVAL = 60000; // 1min
+// Every run removes the items of up to mapCleanBatchSize tiles
+static constexpr int32_t EVENT_MAP_CLEAN_INTERVAL = 100;
+// The steps of the monsters and npcs due within the same interval are taken by one task
+static constexpr int32_t EVENT_WALK_BATCH_INTERVAL = 10;
 
 class Game {
 public:
@@ -107,6 +101,8 @@ public:
 	 * \returns true if the custom map was loaded successfully
 	 */
 	void loadMainMap(const std::string &filename);
+	// Reads the OTBM of the main map ahead of loadMainMap, see Map::parse
+	void parseMainMap(const std::string &filename);
 	/**
 	 * Load the custom map
 	 * \param filename Is the map custom name (Example: "map".otbm, not is necessary add extension .otbm)
@@ -175,6 +171,13 @@ public:
 
 	std::string getPlayerNameByGUID(const uint32_t &guid);
 
+	/**
+	 * Drops the offline copy of a player kept by getPlayerByName/GUID with allowOffline, called when the player
+	 * logs in or another copy of it is saved. The copy itself is kept when it is the one saved, it holds the latest state.
+	 * Thread safe, the saves call it from their threads.
+	 */
+	void removeOfflinePlayer(uint32_t guid, const std::shared_ptr<Player> &savedPlayer = nullptr);
+
 	ReturnValue getPlayerByNameWildcard(const std::string &s, std::shared_ptr<Player> &player);
 
 	std::vector<std::shared_ptr<Player>> getPlayersByAccount(std::shared_ptr<Account> acc, bool allowOffline = false);
@@ -202,6 +205,14 @@ public:
 		return playersRecord;
 	}
 
+	// The last world snapshot, it can be called from any thread (nullptr before the first one is built)
+	std::shared_ptr<const WorldSnapshot> getWorldSnapshot() const;
+	// Copies the online players into a new snapshot and publishes it, dispatcher thread
+	void updateWorldSnapshot();
+
+	// Adds the map and the creatures, the containers the creatures own are not counted
+	void countMemory(MemoryCensus &census) const;
+
 	void addItemsClassification(ItemClassification* itemsClassification) {
 		itemsClassifications.push_back(itemsClassification);
 	}
@@ -463,10 +474,17 @@ public:
 
 	// Events
 	void checkCreatureWalk(uint32_t creatureId);
+	/**
+	 * Queues the next step of a creature in the batch due in about delay milliseconds.
+	 * @return the token of the step, the step is skipped if the eventWalk of the creature is no longer it.
+	 */
+	uint32_t addCreatureWalkBatch(uint32_t creatureId, int64_t delay);
+	void checkCreatureWalkBatch(int64_t slot);
 	void updateCreatureWalk(uint32_t creatureId);
 	void checkCreatureAttack(uint32_t creatureId);
 	void checkCreatures();
 	void checkLight();
+	void sendLightBroadcast(const std::shared_ptr<std::vector<std::weak_ptr<Player>>> &recipients, size_t offset, const std::shared_ptr<BroadcastMessage> &message, const std::shared_ptr<BroadcastMessage> &accessMessage);
 
 	bool combatBlockHit(CombatDamage &damage, std::shared_ptr<Creature> attacker, std::shared_ptr<Creature> target, bool checkDefense, bool checkArmor, bool field);
 
@@ -540,10 +558,10 @@ public:
 	const phmap::parallel_flat_hash_map<uint32_t, std::shared_ptr<Player>> &getPlayers() const {
 		return players;
 	}
-	const std::map<uint32_t, std::shared_ptr<Monster>> &getMonsters() const {
+	const stdext::slot_table<Monster> &getMonsters() const {
 		return monsters;
 	}
-	const std::map<uint32_t, std::shared_ptr<Npc>> &getNpcs() const {
+	const stdext::slot_table<Npc> &getNpcs() const {
 		return npcs;
 	}
 
@@ -554,12 +572,24 @@ public:
 	void addPlayer(std::shared_ptr<Player> player);
 	void removePlayer(std::shared_ptr<Player> player);
 
+	// Called when an online player adds or removes a guid on their VIP list, addPlayer and removePlayer cover the whole list
+	void addVipWatcher(uint32_t vipGuid, uint32_t playerId);
+	void removeVipWatcher(uint32_t vipGuid, uint32_t playerId);
+	/**
+	 * @brief The online players that have the guid on their VIP list, to notify them of its status.
+	 */
+	std::vector<std::shared_ptr<Player>> getVipWatchers(uint32_t vipGuid) const;
+
 	void addNpc(std::shared_ptr<Npc> npc);
 	void removeNpc(std::shared_ptr<Npc> npc);
 
 	void addMonster(std::shared_ptr<Monster> npc);
 	void removeMonster(std::shared_ptr<Monster> npc);
 
+	// Returns id while its slot is still reserved, otherwise reserves a new one (0 when the table is full)
+	uint32_t reserveMonsterID(uint32_t id);
+	uint32_t reserveNpcID(uint32_t id);
+
 	std::shared_ptr<Guild> getGuild(uint32_t id, bool allowOffline = false) const;
 	std::shared_ptr<Guild> getGuildByName(const std::string &name, bool allowOffline = false) const;
 	void addGuild(const std::shared_ptr<Guild> guild);
@@ -588,18 +618,23 @@ public:
 	Raids raids;
 	std::unique_ptr<Canary::protobuf::appearances::Appearances> m_appearancesPtr;
 
-	auto getTilesToClean() const {
+	// The tiles with cleanable items and the time they got the first one
+	const auto &getTilesToClean() const {
 		return tilesToClean;
 	}
-	void addTileToClean(std::shared_ptr<Tile> tile) {
-		tilesToClean.emplace(tile);
-	}
+	void addTileToClean(std::shared_ptr<Tile> tile);
 	void removeTileToClean(std::shared_ptr<Tile> tile) {
 		tilesToClean.erase(tile);
 	}
 	void clearTilesToClean() {
 		tilesToClean.clear();
+		tilesToCleanQueue.clear();
 	}
+	/**
+	 * Removes the cleanable items of the tiles that have had them for mapCleanDelay seconds, at most
+	 * mapCleanBatchSize tiles per run, oldest first. Only the registered tiles are visited, never the whole map.
+	 */
+	void checkTilesToClean();
 
 	void playerInspectItem(std::shared_ptr<Player> player, const Position &pos);
 	void playerInspectItem(std::shared_ptr<Player> player, uint16_t itemId, uint8_t itemCount, bool cyclopedia);
@@ -704,8 +739,8 @@ public:
 	 */
 	bool tryRetrieveStashItems(std::shared_ptr<Player> player, std::shared_ptr<Item> item);
 
-	ReturnValue beforeCreatureZoneChange(std::shared_ptr<Creature> creature, const std::unordered_set<std::shared_ptr<Zone>> &fromZones, const std::unordered_set<std::shared_ptr<Zone>> &toZones, bool force = false) const;
-	void afterCreatureZoneChange(std::shared_ptr<Creature> creature, const std::unordered_set<std::shared_ptr<Zone>> &fromZones, const std::unordered_set<std::shared_ptr<Zone>> &toZones) const;
+	ReturnValue beforeCreatureZoneChange(std::shared_ptr<Creature> creature, const ZoneVector &fromZones, const ZoneVector &toZones, bool force = false) const;
+	void afterCreatureZoneChange(std::shared_ptr<Creature> creature, const ZoneVector &fromZones, const ZoneVector &toZones) const;
 
 	std::unique_ptr<IOWheel> &getIOWheel();
 	const std::unique_ptr<IOWheel> &getIOWheel() const;
@@ -761,7 +796,7 @@ private:
 	bool playerYell(std::shared_ptr<Player> player, const std::string &text);
 	bool playerSpeakTo(std::shared_ptr<Player> player, SpeakClasses type, const std::string &receiver, const std::string &text);
 	void playerSpeakToNpc(std::shared_ptr<Player> player, const std::string &text);
-	std::shared_ptr<Task> createPlayerTask(uint32_t delay, std::function<void(void)> f, std::string context) const;
+	std::shared_ptr<Task> createPlayerTask(uint32_t delay, std::function<void(void)> f, std::string_view context) const;
 
 	/**
 	 * @brief Finds the managed container for loot or obtain based on the given parameters.
@@ -839,12 +874,38 @@ private:
 	 */
 	ReturnValue collectRewardChestItems(std::shared_ptr<Player> player, uint32_t maxMoveItems = 0);
 
-	phmap::flat_hash_map<std::string, QueryHighscoreCacheEntry> queryCache;
-	phmap::flat_hash_map<std::string, HighscoreCacheEntry> highscoreCache;
 
 	phmap::flat_hash_map<std::string, std::weak_ptr<Player>> m_uniqueLoginPlayerNames;
 	phmap::parallel_flat_hash_map<uint32_t, std::shared_ptr<Player>> players;
 	phmap::flat_hash_map<std::string, std::weak_ptr<Player>> mappedPlayerNames;
+	phmap::flat_hash_map<uint32_t, std::weak_ptr<Player>> mappedPlayerGuids;
+	// The ids of the online players by the guids on their VIP lists
+	phmap::flat_hash_map<uint32_t, phmap::flat_hash_set<uint32_t>> vipWatchers;
+
+	// The offline players loaded with allowOffline, the most recently used first, up to offlinePlayerCacheSize
+	struct OfflinePlayer {
+		std::shared_ptr<Player> player;
+		int64_t expiresAt;
+	};
+	std::mutex offlinePlayersMutex;
+	std::list<OfflinePlayer> offlinePlayers;
+	phmap::flat_hash_map<uint32_t, std::list<OfflinePlayer>::iterator> offlinePlayersByGuid;
+	phmap::flat_hash_map<std::string, uint32_t> offlinePlayerGuidsByName;
+
+	std::shared_ptr<Player> getOfflinePlayer(uint32_t guid);
+	std::shared_ptr<Player> getOfflinePlayer(const std::string &lowerCaseName);
+	void addOfflinePlayer(const std::shared_ptr<Player> &player);
+	// Expects offlinePlayersMutex to be held
+	void eraseOfflinePlayer(uint32_t guid);
+
+	// The queued steps (creature id and token) by slot of EVENT_WALK_BATCH_INTERVAL
+	phmap::flat_hash_map<int64_t, std::vector<std::pair<uint32_t, uint32_t>>> creatureWalkBatches;
+	uint32_t lastCreatureWalkToken = 0;
+
+	// Only held to swap or copy the pointer, the snapshot itself is immutable
+	mutable std::mutex worldSnapshotMutex;
+	std::shared_ptr<const WorldSnapshot> worldSnapshot;
+
 	phmap::parallel_flat_hash_map<uint32_t, std::shared_ptr<Guild>> guilds;
 	phmap::flat_hash_map<uint16_t, std::shared_ptr<Item>> uniqueItems;
 	phmap::parallel_flat_hash_map<uint32_t, std::string> m_playerNameCache;
@@ -868,10 +929,11 @@ private:
 	size_t lastBucket = 0;
 	size_t lastImbuedBucket = 0;
 
-	std::shared_ptr<WildcardTreeNode> wildcardTree;
+	WildcardTree wildcardTree;
 
-	std::map<uint32_t, std::shared_ptr<Npc>> npcs;
-	std::map<uint32_t, std::shared_ptr<Monster>> monsters;
+	// By id, an id is the slot of the creature in its table
+	stdext::slot_table<Npc> npcs;
+	stdext::slot_table<Monster> monsters;
 	std::vector<uint32_t> forgeableMonsters;
 
 	std::map<uint32_t, std::unique_ptr<TeamFinder>> teamFinderMap; // [leaderGUID] = TeamFinder*
@@ -883,7 +945,10 @@ private:
 
 	std::map<uint32_t, std::shared_ptr<BedItem>> bedSleepersMap;
 
-	std::unordered_set<std::shared_ptr<Tile>> tilesToClean;
+	phmap::flat_hash_map<std::shared_ptr<Tile>, int64_t> tilesToClean;
+	// The tiles in the order they were added with their time, an entry whose time is no longer the one
+	// in tilesToClean is left from a tile that was cleaned or emptied since and is skipped
+	std::deque<std::pair<std::shared_ptr<Tile>, int64_t>> tilesToCleanQueue;
 
 	ModalWindow offlineTrainingWindow { std::numeric_limits<uint32_t>::max(), "Choose a Skill", "Please choose a skill:" };
 
@@ -920,6 +985,8 @@ private:
 	std::vector<ItemClassification*> itemsClassifications;
 
 	bool isTryingToStow(const Position &toPos, std::shared_ptr<Cylinder> toCylinder) const;
+	// Whether the cylinder is a depot, inbox or a container somewhere inside one
+	bool isInsideDepot(std::shared_ptr<Cylinder> cylinder) const;
 
 	void sendDamageMessageAndEffects(
 		std::shared_ptr<Creature> attacker, std::shared_ptr<Creature> target, const CombatDamage &damage, const Position &targetPos,
@@ -963,15 +1030,6 @@ private:
 
 	// Variable members (m_)
 	std::unique_ptr<IOWheel> m_IOWheel;
-
-	void cacheQueryHighscore(const std::string &key, const std::string &query, uint32_t page, uint8_t entriesPerPage);
-	void processHighscoreResults(DBResult_ptr result, uint32_t playerID, uint8_t category, uint32_t vocation, uint8_t entriesPerPage);
-
-	std::string generateVocationConditionHighscore(uint32_t vocation);
-	std::string generateHighscoreQueryForEntries(const std::string &categoryName, uint32_t page, uint8_t entriesPerPage, uint32_t vocation);
-	std::string generateHighscoreQueryForOurRank(const std::string &categoryName, uint8_t entriesPerPage, uint32_t playerGUID, uint32_t vocation);
-	std::string generateHighscoreOrGetCachedQueryForEntries(const std::string &categoryName, uint32_t page, uint8_t entriesPerPage, uint32_t vocation);
-	std::string generateHighscoreOrGetCachedQueryForOurRank(const std::string &categoryName, uint8_t entriesPerPage, uint32_t playerGUID, uint32_t vocation);
 };
 
 constexpr auto g_game = Game::getInstance;
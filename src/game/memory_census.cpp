@@ -0,0 +1,64 @@
+/**
+ * Canary - A free and open-source MMORPG server emulator
+ * Copyright (©) 2019-2024 OpenTibiaBR <opentibiabr@outlook.com>
+ * Repository: https://github.com/opentibiabr/canary
+ * License: https://github.com/opentibiabr/canary/blob/main/LICENSE
+ * Contributors: https://github.com/opentibiabr/canary/graphs/contributors
+ * Website: https://docs.opentibiabr.com/
+ */
+
+#include "pch.hpp"
+
+#include "game/memory_census.hpp"
+#include "game/game.hpp"
+#include "game/scheduling/dispatcher.hpp"
+#include "items/item.hpp"
+#include "kv/kv.hpp"
+#include "lib/di/container.hpp"
+#include "lib/metrics/metrics.hpp"
+#include "lua/scripts/lua_memory.hpp"
+#include "lua/scripts/lua_workers.hpp"
+#include "server/network/message/outputmessage.hpp"
+
+MemoryCensus &MemoryCensus::getInstance() {
+	return inject<MemoryCensus>();
+}
+
+std::vector<MemoryCensusCategory> MemoryCensus::take() {
+	categories.clear();
+
+	g_game().countMemory(*this);
+	Item::countMemory(*this);
+	g_kv().countMemory(*this);
+	add("lua_scripts", 1, LuaMemory::getStats().heapBytes);
+	g_luaWorkers().countMemory(*this);
+	OutputMessagePool::getInstance().countMemory(*this);
+	g_dispatcher().countMemory(*this);
+
+	std::ranges::sort(categories, std::greater {}, &MemoryCensusCategory::bytes);
+	return categories;
+}
+
+void MemoryCensus::reportMetrics() {
+	if (!g_metrics().isEnabled()) {
+		return;
+	}
+
+	for (const auto &category : take()) {
+		auto &last = reported[category.name];
+		const std::map<std::string, std::string> attrs { { "category", category.name } };
+		g_metrics().addUpDownCounter("memory_census_bytes", static_cast<int64_t>(category.bytes - last.bytes), attrs);
+		g_metrics().addUpDownCounter("memory_census_objects", static_cast<int64_t>(category.objects - last.objects), attrs);
+		last = category;
+	}
+}
+
+void MemoryCensus::add(std::string_view category, uint64_t objects, uint64_t bytes) {
+	auto it = std::ranges::find(categories, category, &MemoryCensusCategory::name);
+	if (it == categories.end()) {
+		categories.push_back({ std::string(category) });
+		it = std::prev(categories.end());
+	}
+	it->objects += objects;
+	it->bytes += bytes;
+}
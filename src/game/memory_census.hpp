@@ -0,0 +1,69 @@
+/**
+ * Canary - A free and open-source MMORPG server emulator
+ * Copyright (©) 2019-2024 OpenTibiaBR <opentibiabr@outlook.com>
+ * Repository: https://github.com/opentibiabr/canary
+ * License: https://github.com/opentibiabr/canary/blob/main/LICENSE
+ * Contributors: https://github.com/opentibiabr/canary/graphs/contributors
+ * Website: https://docs.opentibiabr.com/
+ */
+
+#pragma once
+
+struct MemoryCensusCategory {
+	std::string name;
+	uint64_t objects = 0;
+	uint64_t bytes = 0;
+};
+
+/**
+ * An approximate breakdown of the memory of the server by subsystem: it walks the big structures
+ * (map sectors and tiles, the map caches, items, creatures, the KV store, the Lua states,
+ * the packets and the dispatcher queues) and adds up the size of their types and the capacity of their containers.
+ * The allocator overhead and the memory of the libraries are not counted, what the census
+ * is short of the RSS is that and what no category covers yet.
+ */
+class MemoryCensus {
+public:
+	MemoryCensus() = default;
+
+	// Singleton - ensures we don't accidentally copy it
+	MemoryCensus(const MemoryCensus &) = delete;
+	void operator=(const MemoryCensus &) = delete;
+
+	static MemoryCensus &getInstance();
+
+	/**
+	 * Walks the structures, it must run on the dispatcher.
+	 * It visits every loaded tile, so it takes a few milliseconds on big maps.
+	 * @return the categories by bytes.
+	 */
+	std::vector<MemoryCensusCategory> take();
+
+	/**
+	 * Takes a census and moves the "memory_census_bytes" and "memory_census_objects" up-down counters,
+	 * by category, to its values. Called every memoryCensusInterval seconds by the dispatcher.
+	 */
+	void reportMetrics();
+
+	// Called by the subsystems while they are walked, a category can be added to more than once
+	void add(std::string_view category, uint64_t objects, uint64_t bytes);
+
+	// The object and the control block of a make_shared
+	template <typename T>
+	static constexpr uint64_t sharedBytes() {
+		return sizeof(T) + 2 * sizeof(void*);
+	}
+
+	// The heap block of a string, none while it fits in the string itself
+	static uint64_t heapBytes(const std::string &text) {
+		return text.capacity() > std::string().capacity() ? text.capacity() + 1 : 0;
+	}
+
+private:
+	std::vector<MemoryCensusCategory> categories;
+
+	// The values of the last report, only the dispatcher reports
+	phmap::flat_hash_map<std::string, MemoryCensusCategory> reported;
+};
+
+constexpr auto g_memoryCensus = MemoryCensus::getInstance;
@@ -10,12 +10,58 @@
 #include "pch.hpp"
 
 #include "game/scheduling/dispatcher.hpp"
+#include "game/scheduling/frame_profiler.hpp"
+#include "game/memory_census.hpp"
 #include "lib/thread/thread_pool.hpp"
 #include "lib/di/container.hpp"
+#include "config/configmanager.hpp"
+#include "lib/metrics/metrics.hpp"
+#include "lib/metrics/profiler.hpp"
+#include "lib/metrics/measured_lock.hpp"
 #include "utils/tools.hpp"
 
 thread_local DispatcherContext Dispatcher::dispacherContext;
 
+namespace {
+	constexpr uint64_t packRange(uint32_t begin, uint32_t end) {
+		return (static_cast<uint64_t>(begin) << 32) | end;
+	}
+
+	constexpr uint32_t rangeBegin(uint64_t range) {
+		return static_cast<uint32_t>(range >> 32);
+	}
+
+	constexpr uint32_t rangeEnd(uint64_t range) {
+		return static_cast<uint32_t>(range);
+	}
+
+	// Takes the next index from the front of the range, only called by the owner of the slot.
+	bool popFront(std::atomic_uint64_t &range, uint32_t &index) {
+		auto current = range.load(std::memory_order_acquire);
+		while (rangeBegin(current) < rangeEnd(current)) {
+			if (range.compare_exchange_weak(current, packRange(rangeBegin(current) + 1, rangeEnd(current)), std::memory_order_acq_rel)) {
+				index = rangeBegin(current);
+				return true;
+			}
+		}
+		return false;
+	}
+
+	// Steals the upper half of another slot's range (or the last index left).
+	bool stealBack(std::atomic_uint64_t &range, uint32_t &begin, uint32_t &end) {
+		auto current = range.load(std::memory_order_acquire);
+		while (rangeBegin(current) < rangeEnd(current)) {
+			const auto mid = rangeBegin(current) + (rangeEnd(current) - rangeBegin(current)) / 2;
+			if (range.compare_exchange_weak(current, packRange(rangeBegin(current), mid), std::memory_order_acq_rel)) {
+				begin = mid;
+				end = rangeEnd(current);
+				return true;
+			}
+		}
+		return false;
+	}
+}
+
 Dispatcher &Dispatcher::getInstance() {
 	return inject<Dispatcher>();
 }
@@ -26,12 +72,27 @@ void Dispatcher::init() {
 	threadPool.detach_task([this] {
 		std::unique_lock asyncLock(dummyMutex);
 
+		auto &frameProfiler = g_frameProfiler();
+		profiler::setThreadName("Dispatcher");
 		while (!threadPool.isStopped()) {
 			UPDATE_OTSYS_TIME();
+			frameProfiler.beginFrame();
 
 			executeEvents();
-			executeScheduledEvents();
-			mergeEvents();
+			{
+				FrameScope scope(FramePhase::ScheduledEvents);
+				executeScheduledEvents();
+			}
+			{
+				FrameScope scope(FramePhase::MergeEvents);
+				mergeEvents();
+			}
+			frameProfiler.endFrame(dispatcherCycle);
+			profiler::frameMark("Dispatcher cycle");
+
+			if (!hasPendingTasks && idleHandler) {
+				idleHandler(timeUntilNextScheduledTask());
+			}
 
 			if (!hasPendingTasks) {
 				signalSchedule.wait_for(asyncLock, timeUntilNextScheduledTask());
@@ -41,21 +102,76 @@ void Dispatcher::init() {
 }
 
 void Dispatcher::executeSerialEvents(std::vector<Task> &tasks) {
+	FrameScope scope(FramePhase::SerialTasks);
 	dispacherContext.group = TaskGroup::Serial;
 	dispacherContext.type = DispatcherType::Event;
 
-	for (const auto &task : tasks) {
+	const auto budget = std::chrono::milliseconds(g_configManager().getNumber(DISPATCHER_CYCLE_BUDGET, __FUNCTION__));
+	const auto startTime = std::chrono::steady_clock::now();
+	bool overBudget = false;
+	size_t deferred = 0;
+
+	for (size_t i = 0; i < tasks.size(); ++i) {
+		auto &task = tasks[i];
+
+		// Once over budget, low priority tasks wait for the next cycle, until they expire.
+		if (overBudget && task.isLowPriority()) {
+			auto &count = getShedCount(task.getContext());
+			if (task.hasExpired()) {
+				++count.dropped;
+				continue;
+			}
+
+			++count.deferred;
+			if (deferred != i) {
+				tasks[deferred] = std::move(task);
+			}
+			++deferred;
+			continue;
+		}
+
 		dispacherContext.taskName = task.getContext();
 		if (task.execute()) {
 			++dispatcherCycle;
 		}
+
+		if (budget.count() > 0 && !overBudget) {
+			overBudget = std::chrono::steady_clock::now() - startTime > budget;
+		}
 	}
-	tasks.clear();
+
+	// Deferred tasks stay at the front, so they run first in the next cycle
+	tasks.erase(tasks.begin() + deferred, tasks.end());
+	reportShedCounts();
 
 	dispacherContext.reset();
 }
 
+Dispatcher::ShedCount &Dispatcher::getShedCount(std::string_view context) {
+	const auto it = std::ranges::find(shedCounts, context, &ShedCount::context);
+	return it != shedCounts.end() ? *it : shedCounts.emplace_back(ShedCount { context });
+}
+
+void Dispatcher::reportShedCounts() {
+	if (shedCounts.empty()) {
+		return;
+	}
+
+	if (g_metrics().isEnabled()) {
+		for (const auto &[context, deferred, dropped] : shedCounts) {
+			if (deferred > 0) {
+				g_metrics().addCounter("dispatcher_shed", deferred, { { "context", std::string(context) }, { "action", "deferred" } });
+			}
+			if (dropped > 0) {
+				g_metrics().addCounter("dispatcher_shed", dropped, { { "context", std::string(context) }, { "action", "dropped" } });
+			}
+		}
+	}
+	shedCounts.clear();
+}
+
 void Dispatcher::executeParallelEvents(std::vector<Task> &tasks, const uint8_t groupId) {
+	FrameScope scope(FramePhase::ParallelTasks);
 	asyncWait(tasks.size(), [groupId, &tasks](size_t i) {
 		dispacherContext.type = DispatcherType::AsyncEvent;
 		dispacherContext.group = static_cast<TaskGroup>(groupId);
@@ -80,6 +196,13 @@ void Dispatcher::asyncWait(size_t requestSize, std::function<void(size_t i)> &&f
 		return;
 	}
 
+	if (requestSize > 1 && requestSize <= std::numeric_limits<uint32_t>::max() && g_configManager().getBoolean(DISPATCHER_WORK_STEALING, __FUNCTION__)) {
+		asyncWaitDisabled = true;
+		asyncWaitStealing(requestSize, f);
+		asyncWaitDisabled = false;
+		return;
+	}
+
 	const auto &partitions = generatePartition(requestSize);
 	const auto pSize = partitions.size();
 
@@ -103,6 +226,54 @@ void Dispatcher::asyncWait(size_t requestSize, std::function<void(size_t i)> &&f
 	}
 }
 
+void Dispatcher::asyncWaitStealing(size_t requestSize, const std::function<void(size_t i)> &f) {
+	const auto slots = std::min<size_t>(requestSize, std::min<size_t>(threadPool.get_thread_count(), threads.size()));
+	const auto sizePerSlot = requestSize / slots;
+	const auto remainder = requestSize % slots;
+
+	uint32_t begin = 0;
+	for (size_t slot = 0; slot < slots; ++slot) {
+		const auto end = static_cast<uint32_t>(begin + sizePerSlot + (slot < remainder ? 1 : 0));
+		threads[slot]->stealRange.store(packRange(begin, end), std::memory_order_release);
+		begin = end;
+	}
+
+	BS::multi_future<void> retFuture;
+	retFuture.reserve(slots - 1);
+	for (size_t slot = 1; slot < slots; ++slot) {
+		retFuture.push_back(threadPool.submit_task([this, slot, slots, &f] { runStealingWorker(slot, slots, f); }));
+	}
+
+	// The dispatcher thread works on the first slot and steals like any other worker.
+	runStealingWorker(0, slots, f);
+
+	retFuture.wait();
+}
+
+void Dispatcher::runStealingWorker(size_t slot, size_t slots, const std::function<void(size_t i)> &f) {
+	auto &ownRange = threads[slot]->stealRange;
+
+	while (true) {
+		uint32_t index;
+		while (popFront(ownRange, index)) {
+			f(index);
+		}
+
+		bool stolen = false;
+		for (size_t i = 1; i < slots && !stolen; ++i) {
+			uint32_t begin, end;
+			if (stealBack(threads[(slot + i) % slots]->stealRange, begin, end)) {
+				ownRange.store(packRange(begin, end), std::memory_order_release);
+				stolen = true;
+			}
+		}
+
+		if (!stolen) {
+			return;
+		}
+	}
+}
+
 void Dispatcher::executeEvents(const TaskGroup startGroup) {
 	for (uint_fast8_t groupId = static_cast<uint8_t>(startGroup); groupId < static_cast<uint8_t>(TaskGroup::Last); ++groupId) {
 		auto &tasks = m_tasks[groupId];
@@ -122,29 +293,26 @@ void Dispatcher::executeEvents(const TaskGroup startGroup) {
 void Dispatcher::executeScheduledEvents() {
 	auto &threadScheduledTasks = getThreadTask()->scheduledTasks;
 
-	auto it = scheduledTasks.begin();
-	while (it != scheduledTasks.end()) {
-		const auto &task = *it;
-		if (task->getTime() > OTSYS_TIME()) {
-			break;
-		}
+	if (timingWheel) {
+		timingWheel->expire(OTSYS_TIME(), [this, &threadScheduledTasks](const std::shared_ptr<Task> &task) {
+			executeScheduledTask(task, threadScheduledTasks);
+		});
+	} else {
+		auto it = scheduledTasks.begin();
+		while (it != scheduledTasks.end()) {
+			const auto &task = *it;
+			if (task->getTime() > OTSYS_TIME()) {
+				break;
+			}
 
-		dispacherContext.type = task->isCycle() ? DispatcherType::CycleEvent : DispatcherType::ScheduledEvent;
-		dispacherContext.group = TaskGroup::Serial;
-		dispacherContext.taskName = task->getContext();
+			executeScheduledTask(task, threadScheduledTasks);
 
-		if (task->execute() && task->isCycle()) {
-			task->updateTime();
-			threadScheduledTasks.emplace_back(task);
-		} else {
-			scheduledTasksRef.erase(task->getId());
+			++it;
 		}
 
-		++it;
-	}
-
-	if (it != scheduledTasks.begin()) {
-		scheduledTasks.erase(scheduledTasks.begin(), it);
+		if (it != scheduledTasks.begin()) {
+			scheduledTasks.erase(scheduledTasks.begin(), it);
+		}
 	}
 
 	dispacherContext.reset();
@@ -153,13 +321,26 @@ void Dispatcher::executeScheduledEvents() {
 	executeEvents(TaskGroup::GenericParallel); // execute async events requested by scheduled events
 }
 
+void Dispatcher::executeScheduledTask(const std::shared_ptr<Task> &task, std::vector<std::shared_ptr<Task>> &threadScheduledTasks) {
+	dispacherContext.type = task->isCycle() ? DispatcherType::CycleEvent : DispatcherType::ScheduledEvent;
+	dispacherContext.group = TaskGroup::Serial;
+	dispacherContext.taskName = task->getContext();
+
+	if (task->execute() && task->isCycle()) {
+		task->updateTime();
+		threadScheduledTasks.emplace_back(task);
+	} else {
+		scheduledTasksRef.erase(task->getId());
+	}
+}
+
 // Merge only async thread events with main dispatch events
 void Dispatcher::mergeAsyncEvents() {
 	constexpr uint8_t start = static_cast<uint8_t>(TaskGroup::GenericParallel);
 	constexpr uint8_t end = static_cast<uint8_t>(TaskGroup::Last);
 
 	for (const auto &thread : threads) {
-		std::scoped_lock lock(thread->mutex);
+		metrics::measured_lock lock(thread->mutex, __METHOD_NAME__);
 		for (uint_fast8_t i = start; i < end; ++i) {
 			if (!thread->tasks[i].empty()) {
 				m_tasks[i].insert(m_tasks[i].end(), make_move_iterator(thread->tasks[i].begin()), make_move_iterator(thread->tasks[i].end()));
@@ -174,14 +355,20 @@ void Dispatcher::mergeEvents() {
 	constexpr uint8_t serial = static_cast<uint8_t>(TaskGroup::Serial);
 
 	for (const auto &thread : threads) {
-		std::scoped_lock lock(thread->mutex);
+		metrics::measured_lock lock(thread->mutex, __METHOD_NAME__);
 		if (!thread->tasks[serial].empty()) {
 			m_tasks[serial].insert(m_tasks[serial].end(), make_move_iterator(thread->tasks[serial].begin()), make_move_iterator(thread->tasks[serial].end()));
 			thread->tasks[serial].clear();
 		}
 
 		if (!thread->scheduledTasks.empty()) {
-			scheduledTasks.insert(make_move_iterator(thread->scheduledTasks.begin()), make_move_iterator(thread->scheduledTasks.end()));
+			if (timingWheel) {
+				for (const auto &task : thread->scheduledTasks) {
+					timingWheel->insert(task);
+				}
+			} else {
+				scheduledTasks.insert(make_move_iterator(thread->scheduledTasks.begin()), make_move_iterator(thread->scheduledTasks.end()));
+			}
 			thread->scheduledTasks.clear();
 		}
 	}
@@ -193,6 +380,15 @@ std::chrono::milliseconds Dispatcher::timeUntilNextScheduledTask() const {
 	constexpr auto CHRONO_0 = std::chrono::milliseconds(0);
 	constexpr auto CHRONO_MILI_MAX = std::chrono::milliseconds::max();
 
+	if (timingWheel) {
+		if (timingWheel->empty()) {
+			return CHRONO_MILI_MAX;
+		}
+
+		const auto timeRemaining = std::chrono::milliseconds(timingWheel->nextExpiration() - OTSYS_TIME());
+		return std::max<std::chrono::milliseconds>(timeRemaining, CHRONO_0);
+	}
+
 	if (scheduledTasks.empty()) {
 		return CHRONO_MILI_MAX;
 	}
@@ -202,16 +398,21 @@ std::chrono::milliseconds Dispatcher::timeUntilNextScheduledTask() const {
 	return std::max<std::chrono::milliseconds>(timeRemaining, CHRONO_0);
 }
 
-void Dispatcher::addEvent(std::function<void(void)> &&f, std::string_view context, uint32_t expiresAfterMs) {
-	const auto &thread = getThreadTask();
-	std::scoped_lock lock(thread->mutex);
-	thread->tasks[static_cast<uint8_t>(TaskGroup::Serial)].emplace_back(expiresAfterMs, std::move(f), context);
-	notify();
+void Dispatcher::enableTimingWheel() {
+	if (timingWheel) {
+		return;
+	}
+
+	timingWheel = std::make_unique<TimingWheel>(OTSYS_TIME());
+	for (const auto &task : scheduledTasks) {
+		timingWheel->insert(task);
+	}
+	scheduledTasks.clear();
 }
 
 uint64_t Dispatcher::scheduleEvent(const std::shared_ptr<Task> &task) {
 	const auto &thread = getThreadTask();
-	std::scoped_lock lock(thread->mutex);
+	metrics::measured_lock lock(thread->mutex, __METHOD_NAME__);
 
 	auto eventId = scheduledTasksRef
 					   .emplace(task->getId(), thread->scheduledTasks.emplace_back(task))
@@ -221,13 +422,6 @@ uint64_t Dispatcher::scheduleEvent(const std::shared_ptr<Task> &task) {
 	return eventId;
 }
 
-void Dispatcher::asyncEvent(std::function<void(void)> &&f, TaskGroup group) {
-	const auto &thread = getThreadTask();
-	std::scoped_lock lock(thread->mutex);
-	thread->tasks[static_cast<uint8_t>(group)].emplace_back(0, std::move(f), dispacherContext.taskName);
-	notify();
-}
-
 void Dispatcher::stopEvent(uint64_t eventId) {
 	const auto &it = scheduledTasksRef.find(eventId);
 	if (it != scheduledTasksRef.end()) {
@@ -236,6 +430,24 @@ void Dispatcher::stopEvent(uint64_t eventId) {
 	}
 }
 
+void Dispatcher::countMemory(MemoryCensus &census) {
+	const auto countQueues = [&census](const auto &queues) {
+		for (const auto &queue : queues) {
+			census.add("dispatcher_tasks", queue.size(), queue.capacity() * sizeof(Task));
+		}
+	};
+
+	for (const auto &thread : threads) {
+		metrics::measured_lock lock(thread->mutex, __METHOD_NAME__);
+		countQueues(thread->tasks);
+		census.add("dispatcher_tasks", 0, thread->scheduledTasks.capacity() * sizeof(std::shared_ptr<Task>));
+	}
+	countQueues(m_tasks);
+
+	const auto scheduled = scheduledTasks.size() + (timingWheel ? timingWheel->size() : 0);
+	census.add("dispatcher_scheduled_tasks", scheduled, scheduled * (MemoryCensus::sharedBytes<Task>() + sizeof(std::shared_ptr<Task>)) + scheduledTasksRef.capacity() * (sizeof(std::pair<uint64_t, std::shared_ptr<Task>>) + 1));
+}
+
 void DispatcherContext::addEvent(std::function<void(void)> &&f) const {
 	g_dispatcher().addEvent(std::move(f), taskName);
 }
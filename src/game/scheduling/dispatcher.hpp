@@ -10,7 +10,11 @@
 #pragma once
 
 #include "task.hpp"
+#include "timing_wheel.hpp"
 #include "lib/thread/thread_pool.hpp"
+#include "lib/metrics/measured_lock.hpp"
+
+class MemoryCensus;
 
 static constexpr uint16_t DISPATCHER_TASK_EXPIRATION = 2000;
 static constexpr uint16_t SCHEDULER_MINTICKS = 50;
@@ -84,7 +88,8 @@ class Dispatcher {
 public:
 	explicit Dispatcher(ThreadPool &threadPool) :
 		threadPool(threadPool) {
-		threads.reserve(threadPool.get_thread_count() + 1);
+		// One slot per pool thread, one for the main thread and a shared one for any other thread
+		threads.reserve(threadPool.get_thread_count() + 2);
 		for (uint_fast16_t i = 0; i < threads.capacity(); ++i) {
 			threads.emplace_back(std::make_unique<ThreadTask>());
 		}
@@ -96,29 +101,47 @@ public:
 
 	static Dispatcher &getInstance();
 
-	void addEvent(std::function<void(void)> &&f, std::string_view context, uint32_t expiresAfterMs = 0);
+	template <typename F>
+	void addEvent(F &&f, std::string_view context, uint32_t expiresAfterMs = 0) {
+		const auto &thread = getThreadTask();
+		// Not __METHOD_NAME__, the signature of a template has the arguments after it
+		metrics::measured_lock lock(thread->mutex, "Dispatcher::addEvent");
+		thread->tasks[static_cast<uint8_t>(TaskGroup::Serial)].emplace_back(expiresAfterMs, std::forward<F>(f), context);
+		notify();
+	}
 
-	uint64_t cycleEvent(uint32_t delay, std::function<void(void)> &&f, std::string_view context) {
-		return scheduleEvent(delay, std::move(f), context, true);
+	template <typename F>
+	uint64_t cycleEvent(uint32_t delay, F &&f, std::string_view context) {
+		return scheduleEvent(delay, std::forward<F>(f), context, true);
 	}
 
 	uint64_t scheduleEvent(const std::shared_ptr<Task> &task);
-	uint64_t scheduleEvent(uint32_t delay, std::function<void(void)> &&f, std::string_view context) {
-		return scheduleEvent(delay, std::move(f), context, false);
+	template <typename F>
+	uint64_t scheduleEvent(uint32_t delay, F &&f, std::string_view context) {
+		return scheduleEvent(delay, std::forward<F>(f), context, false);
+	}
+
+	template <typename F>
+	void asyncEvent(F &&f, TaskGroup group = TaskGroup::GenericParallel) {
+		const auto &thread = getThreadTask();
+		metrics::measured_lock lock(thread->mutex, "Dispatcher::asyncEvent");
+		thread->tasks[static_cast<uint8_t>(group)].emplace_back(0, std::forward<F>(f), dispacherContext.taskName);
+		notify();
 	}
 
-	void asyncEvent(std::function<void(void)> &&f, TaskGroup group = TaskGroup::GenericParallel);
 	void asyncWait(size_t size, std::function<void(size_t i)> &&f);
 
-	uint64_t asyncCycleEvent(uint32_t delay, std::function<void(void)> &&f, TaskGroup group = TaskGroup::GenericParallel) {
+	template <typename F>
+	uint64_t asyncCycleEvent(uint32_t delay, F &&f, TaskGroup group = TaskGroup::GenericParallel) {
 		return scheduleEvent(
-			delay, [this, f = std::move(f), group] { asyncEvent([f] { f(); }, group); }, dispacherContext.taskName, true, false
+			delay, [this, f = std::forward<F>(f), group] { asyncEvent(f, group); }, dispacherContext.taskName, true, false
 		);
 	}
 
-	uint64_t asyncScheduleEvent(uint32_t delay, std::function<void(void)> &&f, TaskGroup group = TaskGroup::GenericParallel) {
+	template <typename F>
+	uint64_t asyncScheduleEvent(uint32_t delay, F &&f, TaskGroup group = TaskGroup::GenericParallel) {
 		return scheduleEvent(
-			delay, [this, f = std::move(f), group] { asyncEvent([f] { f(); }, group); }, dispacherContext.taskName, false, false
+			delay, [this, f = std::forward<F>(f), group] { asyncEvent(f, group); }, dispacherContext.taskName, false, false
 		);
 	}
 
@@ -128,19 +151,36 @@ public:
 
 	void stopEvent(uint64_t eventId);
 
+	// Moves scheduled events to the timing wheel backend, it must be called from the dispatcher thread.
+	void enableTimingWheel();
+
+	/**
+	 * Called by the dispatcher thread when it has no tasks, with the time until the next scheduled one.
+	 * Tasks added meanwhile wait for it, so it must be short. It must be set from the dispatcher thread.
+	 */
+	void setIdleHandler(std::function<void(std::chrono::milliseconds)> handler) {
+		idleHandler = std::move(handler);
+	}
+
 	const auto &context() const {
 		return dispacherContext;
 	}
 
+	// Adds the queued and scheduled tasks and their queues, what the tasks capture is not counted
+	void countMemory(MemoryCensus &census);
+
 private:
 	thread_local static DispatcherContext dispacherContext;
 
 	const auto &getThreadTask() const {
-		return threads[ThreadPool::getThreadId()];
+		// Threads outside the pool (e.g. network or lane threads) share the last slot, always under its mutex
+		const auto id = static_cast<size_t>(ThreadPool::getThreadId());
+		return threads[std::min(id, threads.size() - 1)];
 	}
 
-	uint64_t scheduleEvent(uint32_t delay, std::function<void(void)> &&f, std::string_view context, bool cycle, bool log = true) {
-		return scheduleEvent(std::make_shared<Task>(std::move(f), context, delay, cycle, log));
+	template <typename F>
+	uint64_t scheduleEvent(uint32_t delay, F &&f, std::string_view context, bool cycle, bool log = true) {
+		return scheduleEvent(Task::create(std::forward<F>(f), context, delay, cycle, log));
 	}
 
 	void init();
@@ -152,9 +192,20 @@ private:
 	inline void mergeEvents();
 	inline void executeEvents(const TaskGroup startGroup = TaskGroup::Serial);
 	inline void executeScheduledEvents();
+	inline void executeScheduledTask(const std::shared_ptr<Task> &task, std::vector<std::shared_ptr<Task>> &threadScheduledTasks);
 
 	inline void executeSerialEvents(std::vector<Task> &tasks);
+	// Low priority tasks deferred or dropped by the cycle budget, reported once per cycle and context
+	struct ShedCount {
+		std::string_view context;
+		uint32_t deferred = 0;
+		uint32_t dropped = 0;
+	};
+	ShedCount &getShedCount(std::string_view context);
+	void reportShedCounts();
 	inline void executeParallelEvents(std::vector<Task> &tasks, const uint8_t groupId);
+	inline void asyncWaitStealing(size_t size, const std::function<void(size_t i)> &f);
+	inline void runStealingWorker(size_t slot, size_t slots, const std::function<void(size_t i)> &f);
 	inline std::chrono::milliseconds timeUntilNextScheduledTask() const;
 
 	inline void checkPendingTasks() {
@@ -196,6 +247,7 @@ private:
 	std::condition_variable signalSchedule;
 	std::atomic_bool hasPendingTasks = false;
 	std::mutex dummyMutex; // This is only used for signaling the condition variable and not as an actual lock.
+	std::function<void(std::chrono::milliseconds)> idleHandler;
 
 	// Thread Events
 	struct ThreadTask {
@@ -209,15 +261,22 @@ private:
 		std::array<std::vector<Task>, static_cast<uint8_t>(TaskGroup::Last)> tasks;
 		std::vector<std::shared_ptr<Task>> scheduledTasks;
 		std::mutex mutex;
+
+		// Work-stealing range [begin, end) of the asyncWait index space, packed as two uint32.
+		// The owner pops from the front and idle workers steal the upper half from the back.
+		std::atomic_uint64_t stealRange = 0;
 	};
 	std::vector<std::unique_ptr<ThreadTask>> threads;
 
 	// Main Events
 	std::array<std::vector<Task>, static_cast<uint8_t>(TaskGroup::Last)> m_tasks;
 	phmap::btree_multiset<std::shared_ptr<Task>, Task::Compare> scheduledTasks;
+	std::unique_ptr<TimingWheel> timingWheel;
 	phmap::parallel_flat_hash_map_m<uint64_t, std::shared_ptr<Task>> scheduledTasksRef;
 
 	bool asyncWaitDisabled = false;
+	// Only touched by the serial phase, keeps its capacity between cycles
+	std::vector<ShedCount> shedCounts;
 
 	friend class CanaryServer;
 };
@@ -0,0 +1,152 @@
+/**
+ * Canary - A free and open-source MMORPG server emulator
+ * Copyright (©) 2019-2024 OpenTibiaBR <opentibiabr@outlook.com>
+ * Repository: https://github.com/opentibiabr/canary
+ * License: https://github.com/opentibiabr/canary/blob/main/LICENSE
+ * Contributors: https://github.com/opentibiabr/canary/graphs/contributors
+ * Website: https://docs.opentibiabr.com/
+ */
+
+#include "pch.hpp"
+
+#include "game/scheduling/frame_profiler.hpp"
+
+#include "config/configmanager.hpp"
+#include "lib/di/container.hpp"
+#include "lib/metrics/metrics.hpp"
+#include "lib/thread/thread_pool.hpp"
+
+FrameProfiler &FrameProfiler::getInstance() {
+	return inject<FrameProfiler>();
+}
+
+std::string_view FrameProfiler::getPhaseName(FramePhase phase) {
+	switch (phase) {
+		case FramePhase::MergeEvents:
+			return "merge_events";
+		case FramePhase::SerialTasks:
+			return "serial_tasks";
+		case FramePhase::ParallelTasks:
+			return "parallel_tasks";
+		case FramePhase::ScheduledEvents:
+			return "scheduled_events";
+		case FramePhase::CheckCreatures:
+			return "check_creatures";
+		case FramePhase::Decay:
+			return "decay";
+		case FramePhase::SendMessages:
+			return "send_messages";
+		case FramePhase::Walks:
+			return "walks";
+		default:
+			return "unknown";
+	}
+}
+
+void FrameProfiler::beginFrame() {
+	frameStart = std::chrono::steady_clock::now();
+	frameTime = OTSYS_TIME();
+}
+
+void FrameProfiler::endFrame(uint64_t cycle) {
+	FrameRecord frame;
+	frame.cycle = cycle;
+	frame.time = frameTime;
+	frame.totalTime = static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - frameStart).count());
+	for (size_t phase = 0; phase < frame.phases.size(); ++phase) {
+		frame.phases[phase] = static_cast<uint32_t>(current[phase].exchange(0, std::memory_order_relaxed) / 1000);
+	}
+
+	// The cycles before the config is loaded are not kept, the size of the ring is not known yet
+	if (!g_configManager().isLoaded()) {
+		return;
+	}
+
+	if (frames.empty()) {
+		frames.resize(static_cast<size_t>(std::max<int32_t>(1, g_configManager().getNumber(FRAME_PROFILER_FRAMES, __FUNCTION__))));
+	}
+	frames[next] = frame;
+	next = (next + 1) % frames.size();
+	stored = std::min(stored + 1, frames.size());
+
+	if (metrics::Metrics::isEnabled()) {
+		metrics::Metrics::recordLatency("frame_latency", "phase", "total", frame.totalTime);
+		for (size_t phase = 0; phase < frame.phases.size(); ++phase) {
+			if (frame.phases[phase] > 0) {
+				metrics::Metrics::recordLatency("frame_latency", "phase", getPhaseName(static_cast<FramePhase>(phase)), frame.phases[phase]);
+			}
+		}
+	}
+
+	const auto threshold = g_configManager().getNumber(FRAME_DUMP_THRESHOLD, __FUNCTION__);
+	if (threshold > 0 && frame.totalTime >= static_cast<uint32_t>(threshold) * 1000) {
+		onSlowFrame(frame);
+	}
+}
+
+void FrameProfiler::onSlowFrame(const FrameRecord &frame) {
+	const auto now = OTSYS_TIME();
+	if (now - lastDump < DUMP_INTERVAL) {
+		return;
+	}
+	lastDump = now;
+
+	std::string phases;
+	for (size_t phase = 0; phase < frame.phases.size(); ++phase) {
+		phases += fmt::format(" {}={}", getPhaseName(static_cast<FramePhase>(phase)), frame.phases[phase]);
+	}
+	const auto path = g_configManager().getString(FRAME_DUMP_FILE, __FUNCTION__);
+	g_logger().warn("[{}] - Dispatcher cycle {} took {} us (in us:{}), the last {} cycles are dumped to {}", __FUNCTION__, frame.cycle, frame.totalTime, phases, stored, path);
+
+	// Written on the thread pool, the dispatcher is already late
+	inject<ThreadPool>().detach_task([path, frames = getFrames(stored)] {
+		dump(path, frames);
+	});
+}
+
+std::vector<FrameRecord> FrameProfiler::getFrames(size_t count) const {
+	std::vector<FrameRecord> result;
+	count = std::min(count, stored);
+	result.reserve(count);
+	for (size_t i = 1; i <= count; ++i) {
+		result.emplace_back(frames[(next + frames.size() - i) % frames.size()]);
+	}
+	return result;
+}
+
+bool FrameProfiler::dump(const std::string &path, const std::vector<FrameRecord> &frames) {
+	std::string report = "cycle,time,total_us";
+	for (size_t phase = 0; phase < static_cast<size_t>(FramePhase::Last); ++phase) {
+		report += fmt::format(",{}_us", getPhaseName(static_cast<FramePhase>(phase)));
+	}
+	report += '\n';
+
+	// Oldest first
+	for (auto it = frames.rbegin(); it != frames.rend(); ++it) {
+		report += fmt::format("{},{},{}", it->cycle, it->time, it->totalTime);
+		for (const auto time : it->phases) {
+			report += fmt::format(",{}", time);
+		}
+		report += '\n';
+	}
+
+	// Written aside and renamed, so a reader never sees half a dump
+	const std::filesystem::path target = path;
+	auto temporaryPath = target;
+	temporaryPath += ".tmp";
+	{
+		std::ofstream file(temporaryPath, std::ios::trunc);
+		if (!file || !file.write(report.data(), static_cast<std::streamsize>(report.size()))) {
+			g_logger().warn("[{}] - Could not write the dispatcher frames to {}", __FUNCTION__, temporaryPath.string());
+			return false;
+		}
+	}
+
+	std::error_code error;
+	std::filesystem::rename(temporaryPath, target, error);
+	if (error) {
+		g_logger().warn("[{}] - Could not save the dispatcher frames to {}: {}", __FUNCTION__, target.string(), error.message());
+		return false;
+	}
+	return true;
+}
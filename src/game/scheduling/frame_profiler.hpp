@@ -0,0 +1,108 @@
+/**
+ * Canary - A free and open-source MMORPG server emulator
+ * Copyright (©) 2019-2024 OpenTibiaBR <opentibiabr@outlook.com>
+ * Repository: https://github.com/opentibiabr/canary
+ * License: https://github.com/opentibiabr/canary/blob/main/LICENSE
+ * Contributors: https://github.com/opentibiabr/canary/graphs/contributors
+ * Website: https://docs.opentibiabr.com/
+ */
+
+#pragma once
+
+#include "lib/metrics/profiler.hpp"
+
+/**
+ * The phases of a dispatcher cycle. The first four are the steps of the cycle,
+ * the others are the work they run (checkCreatures and decay are scheduled events, sendAll too...),
+ * so they overlap with the steps and do not add up to the total.
+ */
+enum class FramePhase : uint8_t {
+	MergeEvents,
+	SerialTasks,
+	ParallelTasks,
+	ScheduledEvents,
+	CheckCreatures,
+	Decay,
+	SendMessages,
+	Walks,
+
+	Last
+};
+
+struct FrameRecord {
+	uint64_t cycle = 0;
+	// OTSYS_TIME when it started
+	int64_t time = 0;
+	// microseconds
+	uint32_t totalTime = 0;
+	std::array<uint32_t, static_cast<size_t>(FramePhase::Last)> phases {};
+};
+
+/**
+ * Times the phases of every dispatcher cycle (a frame) and keeps the last frameProfilerFrames of them.
+ * The phases are exported to the "frame_latency" histogram of the metrics, by phase and "total".
+ * A frame longer than frameDumpThreshold dumps the kept frames to frameDumpFile (at most every DUMP_INTERVAL),
+ * so the frames before and around a lag can be read after it.
+ */
+class FrameProfiler {
+public:
+	static constexpr int64_t DUMP_INTERVAL = 10000;
+
+	FrameProfiler() = default;
+
+	// Singleton - ensures we don't accidentally copy it
+	FrameProfiler(const FrameProfiler &) = delete;
+	void operator=(const FrameProfiler &) = delete;
+
+	static FrameProfiler &getInstance();
+
+	static std::string_view getPhaseName(FramePhase phase);
+
+	// Any thread can add, the time goes to the frame that is running
+	static void add(FramePhase phase, std::chrono::nanoseconds elapsed) {
+		current[static_cast<size_t>(phase)].fetch_add(static_cast<uint64_t>(elapsed.count()), std::memory_order_relaxed);
+	}
+
+	// Around a dispatcher cycle, on the dispatcher thread
+	void beginFrame();
+	void endFrame(uint64_t cycle);
+
+	// The last frames, newest first
+	std::vector<FrameRecord> getFrames(size_t count) const;
+
+private:
+	static bool dump(const std::string &path, const std::vector<FrameRecord> &frames);
+	void onSlowFrame(const FrameRecord &frame);
+
+	inline static std::array<std::atomic_uint64_t, static_cast<size_t>(FramePhase::Last)> current {};
+
+	std::chrono::steady_clock::time_point frameStart;
+	int64_t frameTime = 0;
+	// A ring of the last frames, next is where the next one goes
+	std::vector<FrameRecord> frames;
+	size_t next = 0;
+	size_t stored = 0;
+	int64_t lastDump = 0;
+};
+
+constexpr auto g_frameProfiler = FrameProfiler::getInstance;
+
+// Adds the time until it goes out of scope to a phase of the frame
+class FrameScope {
+public:
+	// Also a zone of the profiler, named after the phase
+	explicit FrameScope(FramePhase phase, const std::source_location &location = std::source_location::current()) :
+		phase(phase), start(std::chrono::steady_clock::now()), zone(FrameProfiler::getPhaseName(phase), location) { }
+
+	~FrameScope() {
+		FrameProfiler::add(phase, std::chrono::steady_clock::now() - start);
+	}
+
+	FrameScope(const FrameScope &) = delete;
+	void operator=(const FrameScope &) = delete;
+
+private:
+	FramePhase phase;
+	std::chrono::steady_clock::time_point start;
+	profiler::Zone zone;
+};
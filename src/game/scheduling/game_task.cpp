@@ -0,0 +1,24 @@
+/**
+ * Canary - A free and open-source MMORPG server emulator
+ * Copyright (©) 2019-2024 OpenTibiaBR <opentibiabr@outlook.com>
+ * Repository: https://github.com/opentibiabr/canary
+ * License: https://github.com/opentibiabr/canary/blob/main/LICENSE
+ * Contributors: https://github.com/opentibiabr/canary/graphs/contributors
+ * Website: https://docs.opentibiabr.com/
+ */
+
+#include "pch.hpp"
+
+#include "game/scheduling/game_task.hpp"
+
+#include "lib/logging/log_with_spd_log.hpp"
+
+void GameTask::promise_type::unhandled_exception() noexcept {
+	try {
+		throw;
+	} catch (const std::exception &e) {
+		g_logger().error("[GameTask] Unhandled exception: {}", e.what());
+	} catch (...) {
+		g_logger().error("[GameTask] Unhandled unknown exception");
+	}
+}
@@ -0,0 +1,104 @@
+/**
+ * Canary - A free and open-source MMORPG server emulator
+ * Copyright (©) 2019-2024 OpenTibiaBR <opentibiabr@outlook.com>
+ * Repository: https://github.com/opentibiabr/canary
+ * License: https://github.com/opentibiabr/canary/blob/main/LICENSE
+ * Contributors: https://github.com/opentibiabr/canary/graphs/contributors
+ * Website: https://docs.opentibiabr.com/
+ */
+
+#pragma once
+
+#include "game/scheduling/dispatcher.hpp"
+
+#include <coroutine>
+
+/**
+ * Fire and forget coroutine for game code that needs to wait for work done outside the dispatcher,
+ * without chaining callbacks. It starts running immediately and every co_await below
+ * resumes it on the dispatcher thread, e.g.:
+ *
+ * GameTask Game::loadSomething(uint32_t playerId) {
+ *     const auto result = co_await g_databaseTasks().asyncStore(query);
+ *     const auto &player = getPlayerByID(playerId); // back on the dispatcher
+ * }
+ *
+ * Parameters must be taken by value, references may dangle after the first co_await.
+ */
+class GameTask {
+public:
+	struct promise_type {
+		GameTask get_return_object() noexcept {
+			return {};
+		}
+
+		std::suspend_never initial_suspend() noexcept {
+			return {};
+		}
+
+		std::suspend_never final_suspend() noexcept {
+			return {};
+		}
+
+		void return_void() noexcept { }
+
+		void unhandled_exception() noexcept;
+	};
+};
+
+/**
+ * Runs f on the thread pool (or one of its lanes) and resumes the awaiting coroutine
+ * on the dispatcher thread with the result of f.
+ */
+template <typename F>
+class AsyncAwaiter {
+public:
+	using Result = std::invoke_result_t<F &>;
+
+	AsyncAwaiter(ThreadPool &threadPool, std::optional<ThreadLane> lane, F f) :
+		threadPool(threadPool), lane(lane), func(std::move(f)) { }
+
+	bool await_ready() const noexcept {
+		return false;
+	}
+
+	void await_suspend(std::coroutine_handle<> handle) {
+		auto work = [this, handle] {
+			if constexpr (std::is_void_v<Result>) {
+				func();
+			} else {
+				result.emplace(func());
+			}
+			g_dispatcher().addEvent([handle] { handle.resume(); }, "GameTask::resume");
+		};
+
+		if (lane) {
+			threadPool.detachTask(*lane, std::move(work));
+		} else {
+			threadPool.detach_task(std::move(work));
+		}
+	}
+
+	Result await_resume() {
+		if constexpr (!std::is_void_v<Result>) {
+			return std::move(*result);
+		}
+	}
+
+private:
+	struct Empty { };
+
+	ThreadPool &threadPool;
+	std::optional<ThreadLane> lane;
+	F func;
+	std::optional<std::conditional_t<std::is_void_v<Result>, Empty, Result>> result;
+};
+
+/**
+ * co_await awaitAsync([] { return expensiveComputation(); }) runs the computation
+ * on the thread pool and resumes on the dispatcher thread with its result.
+ */
+template <typename F>
+AsyncAwaiter<std::decay_t<F>> awaitAsync(F &&f) {
+	return { inject<ThreadPool>(), std::nullopt, std::forward<F>(f) };
+}
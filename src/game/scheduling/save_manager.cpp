@@ -1,8 +1,10 @@
 #include "pch.hpp"
 
 #include "game/game.hpp"
+#include "game/scheduling/dispatcher.hpp"
 #include "game/scheduling/save_manager.hpp"
 #include "io/iologindata.hpp"
+#include "io/persistence_journal.hpp"
 
 SaveManager::SaveManager(ThreadPool &threadPool, KVStore &kvStore, Logger &logger, Game &game) :
 	threadPool(threadPool), kv(kvStore), logger(logger), game(game) { }
@@ -12,13 +14,34 @@ SaveManager &SaveManager::getInstance() {
 }
 
 void SaveManager::saveAll() {
+	saveAll(true);
+}
+
+void SaveManager::saveAll(bool savePlayers) {
 	Benchmark bm_saveAll;
 	logger.info("Saving server...");
-	const auto players = game.getPlayers();
+	// The spread saves cover the players, the server save only writes the rest
+	const auto players = savePlayers ? game.getPlayers() : phmap::parallel_flat_hash_map<uint32_t, std::shared_ptr<Player>> {};
 
+	// The item, storage, etc. rows of every player are written together, table by table
+	const auto journalSequence = g_persistenceJournal().getSequence();
+	std::vector<uint32_t> savedPlayers;
+	DBBatch batch;
 	for (const auto &[_, player] : players) {
 		player->loginPosition = player->getPosition();
-		doSavePlayer(player);
+		if (doSavePlayer(player)) {
+			savedPlayers.emplace_back(player->getGUID());
+		}
+	}
+	if (!savePlayerBatch(batch)) {
+		for (const auto &[_, player] : players) {
+			Player::PlayerLock lock(player, __METHOD_NAME__);
+			player->savedRowsHash.clear();
+		}
+	} else {
+		for (const auto guid : savedPlayers) {
+			g_persistenceJournal().settle(guid, journalSequence);
+		}
 	}
 
 	auto guilds = game.getGuilds();
@@ -31,6 +54,64 @@ void SaveManager::saveAll() {
 	logger.info("Server saved in {} milliseconds.", bm_saveAll.duration());
 }
 
+void SaveManager::saveForShutdown() {
+	using namespace std::chrono;
+	Benchmark bm_saveForShutdown;
+	logger.info("Saving server for shutdown...");
+
+	for (const auto &[_, guild] : game.getGuilds()) {
+		detachShutdownWrite(fmt::format("guild {}", guild->getName()), [this, guild] {
+			saveGuild(guild);
+			return true;
+		});
+	}
+	detachShutdownWrite("houses", [this] { return saveMap(); });
+	detachShutdownWrite("key-value store", [this] { return saveKV(); });
+
+	const auto timeout = seconds(std::max<int64_t>(g_configManager().getNumber(SHUTDOWN_SAVE_TIMEOUT, __FUNCTION__), 1));
+	const auto deadline = steady_clock::now() + timeout;
+	std::unique_lock lock(m_shutdownMutex);
+	const auto done = [this] { return m_shutdownWritesDone == m_shutdownWrites; };
+	while (!m_shutdownSignal.wait_until(lock, std::min(steady_clock::now() + seconds(1), deadline), done)) {
+		if (steady_clock::now() >= deadline) {
+			// The running writes still finish before the thread pool stops, the queued ones are skipped
+			m_shutdownDeadlinePassed = true;
+			logger.error("Final save did not finish in {} seconds, {} of {} writes are left.", timeout.count(), m_shutdownWrites - m_shutdownWritesDone, m_shutdownWrites);
+			return;
+		}
+		logger.info("Final save: {} of {} writes done.", m_shutdownWritesDone, m_shutdownWrites);
+	}
+
+	if (m_shutdownWritesFailed > 0) {
+		logger.error("Final save: {} of {} writes failed.", m_shutdownWritesFailed, m_shutdownWrites);
+	}
+	logger.info("Server saved for shutdown in {} milliseconds, {} writes.", bm_saveForShutdown.duration(), m_shutdownWrites);
+}
+
+void SaveManager::detachShutdownWrite(std::string name, std::function<bool()> write) {
+	{
+		std::scoped_lock lock(m_shutdownMutex);
+		++m_shutdownWrites;
+	}
+
+	// On the whole pool rather than the save lane, the database pool bounds how many run at once
+	threadPool.detach_task([this, name = std::move(name), write = std::move(write)] {
+		bool success = false;
+		if (m_shutdownDeadlinePassed) {
+			logger.error("Skipping the final save of {} because the shutdown deadline has passed.", name);
+		} else {
+			success = write();
+		}
+
+		std::scoped_lock lock(m_shutdownMutex);
+		++m_shutdownWritesDone;
+		if (!success) {
+			++m_shutdownWritesFailed;
+		}
+		m_shutdownSignal.notify_all();
+	});
+}
+
 void SaveManager::scheduleAll() {
 	auto scheduledAt = std::chrono::steady_clock::now();
 	m_scheduledAt = scheduledAt;
@@ -41,15 +122,112 @@ void SaveManager::scheduleAll() {
 		return;
 	}
 
-	threadPool.detach_task([this, scheduledAt]() {
+	const bool savePlayers = !isSpreadingSaves();
+	threadPool.detachTask(ThreadLane::Save, [this, scheduledAt, savePlayers]() {
 		if (m_scheduledAt.load() != scheduledAt) {
 			logger.warn("Skipping save for server because another save has been scheduled.");
 			return;
 		}
-		saveAll();
+		saveAll(savePlayers);
 	});
 }
 
+void SaveManager::startSpreadSaves() {
+	const auto interval = g_configManager().getNumber(SAVE_PLAYERS_SPREAD_INTERVAL, __FUNCTION__);
+	if (interval <= 0 || !g_configManager().getBoolean(TOGGLE_SAVE_ASYNC, __FUNCTION__)) {
+		return;
+	}
+
+	m_spreadInterval = std::chrono::seconds(interval);
+	g_dispatcher().cycleEvent(
+		1000, [this] { saveDuePlayers(); }, "SaveManager::saveDuePlayers"
+	);
+}
+
+bool SaveManager::isSpreadingSaves() const {
+	return m_spreadInterval.count() > 0;
+}
+
+void SaveManager::setSavePriority(const std::shared_ptr<Player> &player) {
+	if (!isSpreadingSaves() || !player || player->getGUID() == 0) {
+		return;
+	}
+	std::scoped_lock lock(m_priorityMutex);
+	m_priorityPlayers.emplace(player->getGUID());
+}
+
+void SaveManager::saveDuePlayers() {
+	using namespace std::chrono;
+	const auto now = steady_clock::now();
+	const auto &players = game.getPlayers();
+	if (players.empty()) {
+		m_lastSpreadSave.clear();
+		return;
+	}
+
+	// Saved up to one second ahead, a budget left unspent while idle does not pile up into a storm
+	const auto budget = std::max<int64_t>(g_configManager().getNumber(SAVE_PLAYERS_TIME_BUDGET, __FUNCTION__), 1) * 1000;
+	auto credits = m_saveCredits.fetch_add(budget) + budget;
+	if (credits > budget) {
+		m_saveCredits -= credits - budget;
+		credits = budget;
+	}
+
+	phmap::flat_hash_set<uint32_t> priority;
+	{
+		std::scoped_lock lock(m_priorityMutex);
+		priority.swap(m_priorityPlayers);
+	}
+
+	// Players seen for the first time get a phase inside the interval, so they do not all come due together
+	const auto intervalMs = duration_cast<milliseconds>(m_spreadInterval).count();
+	phmap::flat_hash_map<uint32_t, steady_clock::time_point> lastSaves;
+	lastSaves.reserve(players.size());
+	std::vector<std::pair<steady_clock::time_point, std::shared_ptr<Player>>> due;
+	for (const auto &[_, player] : players) {
+		const auto guid = player->getGUID();
+		auto it = m_lastSpreadSave.find(guid);
+		const auto lastSave = it != m_lastSpreadSave.end() ? it->second : now - milliseconds(static_cast<int64_t>(guid * 2654435761u % intervalMs));
+		lastSaves.emplace(guid, lastSave);
+		if (priority.contains(guid)) {
+			due.emplace_back(steady_clock::time_point::min(), player);
+		} else if (now - lastSave >= m_spreadInterval) {
+			due.emplace_back(lastSave, player);
+		}
+	}
+	m_lastSpreadSave.swap(lastSaves);
+	if (due.empty() || credits <= 0) {
+		return;
+	}
+
+	// The oldest first, as many as the budget covers at the current save latency
+	std::ranges::sort(due, {}, &decltype(due)::value_type::first);
+	const auto latency = std::max<int64_t>(m_saveLatency.load(), 1);
+	const auto count = std::min<size_t>(due.size(), static_cast<size_t>(std::max<int64_t>(credits / latency, 1)));
+	if (count < due.size() && due[count].first != steady_clock::time_point::min() && now - due[count].first >= m_spreadInterval * 2) {
+		logger.warn("Spread player saves are behind, {} players wait for a budget of {} ms per second.", due.size() - count, budget / 1000);
+	}
+
+	for (size_t i = 0; i < count; ++i) {
+		const auto &player = due[i].second;
+		m_lastSpreadSave[player->getGUID()] = now;
+		const auto snapshot = capturePlayer(player);
+		if (!snapshot) {
+			continue;
+		}
+
+		threadPool.detachTask(ThreadLane::Save, [this, snapshot]() {
+			const auto start = steady_clock::now();
+			writePlayer(*snapshot);
+			const auto spent = duration_cast<microseconds>(steady_clock::now() - start).count();
+			m_saveCredits -= spent;
+			// Weighs the last save by 1/8
+			auto latency = m_saveLatency.load();
+			while (!m_saveLatency.compare_exchange_weak(latency, latency + (spent - latency) / 8)) { }
+		});
+	}
+}
+
 void SaveManager::schedulePlayer(std::weak_ptr<Player> playerPtr) {
 	auto playerToSave = playerPtr.lock();
 	if (!playerToSave) {
@@ -57,6 +235,16 @@ void SaveManager::schedulePlayer(std::weak_ptr<Player> playerPtr) {
 		return;
 	}
 
+	// The players kicked by a shutdown are written in parallel by saveForShutdown, whatever the async config
+	if (game.getGameState() == GAME_STATE_SHUTDOWN) {
+		if (const auto snapshot = capturePlayer(playerToSave)) {
+			detachShutdownWrite(fmt::format("player {}", snapshot->name), [this, snapshot] {
+				return writePlayer(*snapshot);
+			});
+		}
+		return;
+	}
+
 	// Disable save async if the config is set to false
 	if (!g_configManager().getBoolean(TOGGLE_SAVE_ASYNC, __FUNCTION__)) {
 		if (g_game().getGameState() == GAME_STATE_NORMAL) {
@@ -67,19 +255,13 @@ void SaveManager::schedulePlayer(std::weak_ptr<Player> playerPtr) {
 	}
 
 	logger.debug("Scheduling player {} for saving.", playerToSave->getName());
-	auto scheduledAt = std::chrono::steady_clock::now();
-	m_playerMap[playerToSave->getGUID()] = scheduledAt;
-	threadPool.detach_task([this, playerPtr, scheduledAt]() {
-		auto player = playerPtr.lock();
-		if (!player) {
-			logger.debug("Skipping save for player because player is no longer online.");
-			return;
-		}
-		if (m_playerMap[player->getGUID()] != scheduledAt) {
-			logger.warn("Skipping save for player because another save has been scheduled.");
-			return;
-		}
-		doSavePlayer(player);
+	const auto snapshot = capturePlayer(playerToSave);
+	if (!snapshot) {
+		return;
+	}
+
+	threadPool.detachTask(ThreadLane::Save, [this, snapshot]() {
+		writePlayer(*snapshot);
 	});
 }
 
@@ -90,22 +272,104 @@ bool SaveManager::doSavePlayer(std::shared_ptr<Player> player) {
 	}
 
 	Benchmark bm_savePlayer;
-	Player::PlayerLock lock(player);
-	m_playerMap.erase(player->getGUID());
+	Player::PlayerLock lock(player, __METHOD_NAME__);
 	if (g_game().getGameState() == GAME_STATE_NORMAL) {
 		logger.debug("Saving player {}.", player->getName());
 	}
 
+	const auto [state, sequence] = takeSave(player);
+	// Waits for an earlier save that is being written, it must not land after this one
+	std::scoped_lock writeLock(state->write);
+	const auto journalSequence = g_persistenceJournal().getSequence();
 	bool saveSuccess = IOLoginData::savePlayer(player);
 	if (!saveSuccess) {
 		logger.error("Failed to save player {}.", player->getName());
+	} else if (!DBBatch::current()) {
+		// Inside a batch the rows are not written yet, saveAll settles the players once it is flushed
+		g_persistenceJournal().settle(player->getGUID(), journalSequence);
 	}
+	finishSave(player->getGUID(), state, sequence, saveSuccess);
 
 	auto duration = bm_savePlayer.duration();
 	logger.debug("Saving player {} took {} milliseconds.", player->getName(), duration);
 	return saveSuccess;
 }
 
+struct SaveManager::PlayerSnapshot {
+	uint32_t guid = 0;
+	std::string name;
+	std::shared_ptr<SaveState> state;
+	uint64_t sequence = 0;
+	uint64_t journalSequence = 0;
+	DBCapture writes;
+};
+
+std::shared_ptr<SaveManager::PlayerSnapshot> SaveManager::capturePlayer(const std::shared_ptr<Player> &player) {
+	Benchmark bm_capturePlayer;
+	Player::PlayerLock lock(player, __METHOD_NAME__);
+	auto snapshot = std::make_shared<PlayerSnapshot>();
+	snapshot->guid = player->getGUID();
+	snapshot->name = player->getName();
+	std::tie(snapshot->state, snapshot->sequence) = takeSave(player);
+	snapshot->journalSequence = g_persistenceJournal().getSequence();
+	if (!IOLoginData::capturePlayer(player, snapshot->writes)) {
+		logger.error("Failed to capture player {}.", snapshot->name);
+		finishSave(snapshot->guid, snapshot->state, snapshot->sequence, false);
+		return nullptr;
+	}
+
+	logger.debug("Capturing player {} took {} milliseconds, {} writes.", snapshot->name, bm_capturePlayer.duration(), snapshot->writes.size());
+	return snapshot;
+}
+
+bool SaveManager::writePlayer(const PlayerSnapshot &snapshot) {
+	std::scoped_lock writeLock(snapshot.state->write);
+	{
+		std::scoped_lock lock(m_saveStateMutex);
+		if (snapshot.state->taken != snapshot.sequence) {
+			logger.debug("Skipping save for player {} because a newer one has been taken.", snapshot.name);
+			return true;
+		}
+	}
+
+	Benchmark bm_writePlayer;
+	bool saveSuccess = IOLoginData::writePlayer(snapshot.writes);
+	if (!saveSuccess) {
+		logger.error("Failed to save player {}.", snapshot.name);
+	} else {
+		g_persistenceJournal().settle(snapshot.guid, snapshot.journalSequence);
+	}
+	finishSave(snapshot.guid, snapshot.state, snapshot.sequence, saveSuccess);
+
+	logger.debug("Saving player {} took {} milliseconds.", snapshot.name, bm_writePlayer.duration());
+	return saveSuccess;
+}
+
+std::pair<std::shared_ptr<SaveManager::SaveState>, uint64_t> SaveManager::takeSave(const std::shared_ptr<Player> &player) {
+	std::scoped_lock lock(m_saveStateMutex);
+	auto &state = m_saveStates[player->getGUID()];
+	if (!state) {
+		state = std::make_shared<SaveState>();
+	}
+	if (state->written != state->taken) {
+		player->savedRowsHash.clear();
+	}
+	return { state, ++state->taken };
+}
+
+void SaveManager::finishSave(uint32_t guid, const std::shared_ptr<SaveState> &state, uint64_t sequence, bool success) {
+	std::scoped_lock lock(m_saveStateMutex);
+	if (success) {
+		state->written = std::max(state->written, sequence);
+	}
+	// Nothing is pending anymore, a failed save keeps the state so the next one writes every row
+	if (state->written == state->taken) {
+		if (auto it = m_saveStates.find(guid); it != m_saveStates.end() && it->second == state) {
+			m_saveStates.erase(it);
+		}
+	}
+}
+
 bool SaveManager::savePlayer(std::shared_ptr<Player> player) {
 	if (player->isOnline()) {
 		schedulePlayer(player);
@@ -114,6 +378,48 @@ bool SaveManager::savePlayer(std::shared_ptr<Player> player) {
 	return doSavePlayer(player);
 }
 
+bool SaveManager::savePlayerBatch(DBBatch &batch) {
+	Benchmark bm_saveBatch;
+	const auto owners = batch.getOwnerCount();
+	bool saveSuccess = batch.flush();
+	if (!saveSuccess) {
+		logger.error("Failed to save the rows of {} players.", owners);
+	}
+
+	auto duration = bm_saveBatch.duration();
+	logger.debug("Rows of {} players saved in {} milliseconds.", owners, duration);
+	return saveSuccess;
+}
+
+void SaveManager::scheduleJournalCompaction() {
+	threadPool.detachTask(ThreadLane::Save, [this]() {
+		compactJournal();
+	});
+}
+
+void SaveManager::compactJournal() {
+	auto &journal = g_persistenceJournal();
+	if (!journal.isOpen()) {
+		return;
+	}
+
+	Benchmark bm_compactJournal;
+	// Saving the players settles their records, only the ones of players that left are written as they are
+	const auto owners = journal.getPendingOwners();
+	for (const auto guid : owners) {
+		if (const auto player = game.getPlayerByGUID(guid)) {
+			doSavePlayer(player);
+		}
+	}
+
+	if (!journal.compact()) {
+		logger.error("Failed to compact the persistence journal.");
+	}
+
+	auto duration = bm_compactJournal.duration();
+	logger.debug("Persistence journal of {} players compacted in {} milliseconds.", owners.size(), duration);
+}
+
 void SaveManager::saveGuild(std::shared_ptr<Guild> guild) {
 	if (!guild) {
 		logger.debug("Failed to save guild because guild is null.");
@@ -128,7 +434,7 @@ void SaveManager::saveGuild(std::shared_ptr<Guild> guild) {
 	logger.debug("Saving guild {} took {} milliseconds.", guild->getName(), duration);
 }
 
-void SaveManager::saveMap() {
+bool SaveManager::saveMap() {
 	Benchmark bm_saveMap;
 	logger.debug("Saving map...");
 	bool saveSuccess = Map::save();
@@ -138,9 +444,10 @@ void SaveManager::saveMap() {
 
 	auto duration = bm_saveMap.duration();
 	logger.debug("Map saved in {} milliseconds.", duration);
+	return saveSuccess;
 }
 
-void SaveManager::saveKV() {
+bool SaveManager::saveKV() {
 	Benchmark bm_saveKV;
 	logger.debug("Saving key-value store...");
 	bool saveSuccess = kv.saveAll();
@@ -150,4 +457,5 @@ void SaveManager::saveKV() {
 
 	auto duration = bm_saveKV.duration();
 	logger.debug("Key-value store saved in {} milliseconds.", duration);
+	return saveSuccess;
 }
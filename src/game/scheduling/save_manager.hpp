@@ -12,6 +12,8 @@
 #include "lib/thread/thread_pool.hpp"
 #include "kv/kv.hpp"
 
+class DBBatch;
+
 class SaveManager {
 public:
 	explicit SaveManager(ThreadPool &threadPool, KVStore &kvStore, Logger &logger, Game &game);
@@ -24,18 +26,85 @@ public:
 	void saveAll();
 	void scheduleAll();
 
+	/**
+	 * The final save of a shutdown, on the dispatcher once every player was kicked (their saves are captured then).
+	 * The players, the guilds, the houses and the KV store are written by parallel tasks on the thread pool,
+	 * as many at once as the database pool allows, while the dispatcher waits for them, so the world does not change.
+	 * The progress is logged each second, the writes not started within shutdownSaveTimeout seconds are skipped.
+	 */
+	void saveForShutdown();
+
 	bool savePlayer(std::shared_ptr<Player> player);
 	void saveGuild(std::shared_ptr<Guild> guild);
 
+	// Saves the players with records in the persistence journal and shrinks it, on the save lane
+	void scheduleJournalCompaction();
+
+	/**
+	 * Spreads the player saves over the interval instead of saving them all at once with the server.
+	 * Each second the players not saved for an interval are saved, oldest first, as many as the time budget allows:
+	 * the budget is refilled with a fixed share of database time per second and each save spends what it took.
+	 */
+	void startSpreadSaves();
+	bool isSpreadingSaves() const;
+
+	// Saves the player in the next spread round, before the ones that are only due, for changes too valuable to wait
+	void setSavePriority(const std::shared_ptr<Player> &player);
+
 private:
-	void saveMap();
-	void saveKV();
+	bool saveMap();
+	bool saveKV();
+	void compactJournal();
+
+	// The saves taken of a player, in order, a captured one is not written once a newer one was taken
+	struct SaveState {
+		std::mutex write;
+		// Under m_saveStateMutex
+		uint64_t taken = 0;
+		uint64_t written = 0;
+	};
+	// The rows of a player captured on the dispatcher, written on the save lane without the player
+	struct PlayerSnapshot;
 
 	void schedulePlayer(std::weak_ptr<Player> player);
 	bool doSavePlayer(std::shared_ptr<Player> player);
+	std::shared_ptr<PlayerSnapshot> capturePlayer(const std::shared_ptr<Player> &player);
+	bool writePlayer(const PlayerSnapshot &snapshot);
+	/**
+	 * Takes the next save of the player, with the player lock held.
+	 * When an earlier save is not written yet its saved rows hashes are cleared,
+	 * so this one writes every row and the earlier one can be dropped.
+	 */
+	std::pair<std::shared_ptr<SaveState>, uint64_t> takeSave(const std::shared_ptr<Player> &player);
+	void finishSave(uint32_t guid, const std::shared_ptr<SaveState> &state, uint64_t sequence, bool success);
+	bool savePlayerBatch(DBBatch &batch);
+	void saveAll(bool savePlayers);
+	// Called each second on the dispatcher when the saves are spread
+	void saveDuePlayers();
+	// Runs a write of the final save on the thread pool, saveForShutdown waits for it
+	void detachShutdownWrite(std::string name, std::function<bool()> write);
 
 	std::atomic<std::chrono::steady_clock::time_point> m_scheduledAt;
-	phmap::parallel_flat_hash_map<uint32_t, std::chrono::steady_clock::time_point> m_playerMap;
+	std::mutex m_saveStateMutex;
+	phmap::flat_hash_map<uint32_t, std::shared_ptr<SaveState>> m_saveStates;
+
+	// Dispatcher only, the last spread save of each online player
+	phmap::flat_hash_map<uint32_t, std::chrono::steady_clock::time_point> m_lastSpreadSave;
+	std::chrono::seconds m_spreadInterval { 0 };
+	std::mutex m_priorityMutex;
+	phmap::flat_hash_set<uint32_t> m_priorityPlayers;
+	// Database time left to spend on spread saves, in microseconds, the running saves take it below zero
+	std::atomic<int64_t> m_saveCredits = 0;
+	// Moving average of how long a player save takes, in microseconds
+	std::atomic<int64_t> m_saveLatency = 20000;
+
+	// The writes of the final save
+	std::mutex m_shutdownMutex;
+	std::condition_variable m_shutdownSignal;
+	size_t m_shutdownWrites = 0;
+	size_t m_shutdownWritesDone = 0;
+	size_t m_shutdownWritesFailed = 0;
+	std::atomic<bool> m_shutdownDeadlinePassed = false;
 
 	ThreadPool &threadPool;
 	KVStore &kv;
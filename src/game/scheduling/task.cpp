@@ -11,29 +11,20 @@
 
 #include "task.hpp"
 
+#include "game/scheduling/task_profiler.hpp"
 #include "lib/logging/log_with_spd_log.hpp"
+#include "lib/metrics/allocation_counter.hpp"
 #include "lib/metrics/metrics.hpp"
 
 std::atomic_uint_fast64_t Task::LAST_EVENT_ID = 0;
 
-Task::Task(uint32_t expiresAfterMs, std::function<void(void)> &&f, std::string_view context) :
-	func(std::move(f)), context(context), utime(OTSYS_TIME()), expiration(expiresAfterMs > 0 ? OTSYS_TIME() + expiresAfterMs : 0) {
-	if (this->context.empty()) {
+void Task::validateContext() const {
+	if (context.empty()) {
 		g_logger().error("[{}]: task context cannot be empty!", __FUNCTION__);
 		return;
 	}
 
-	assert(!this->context.empty() && "Context cannot be empty!");
-}
-
-Task::Task(std::function<void(void)> &&f, std::string_view context, uint32_t delay, bool cycle /* = false*/, bool log /*= true*/) :
-	func(std::move(f)), context(context), utime(OTSYS_TIME() + delay), delay(delay), cycle(cycle), log(log) {
-	if (this->context.empty()) {
-		g_logger().error("[{}]: task context cannot be empty!", __FUNCTION__);
-		return;
-	}
-
-	assert(!this->context.empty() && "Context cannot be empty!");
+	assert(!context.empty() && "Context cannot be empty!");
 }
 
 bool Task::execute() const {
@@ -55,7 +46,17 @@ bool Task::execute() const {
 		}
 	}
 
+	allocation_counter::Scope allocationScope(allocation_counter::AllocationTag::Dispatcher);
+	if (!TaskProfiler::isEnabled()) {
+		func();
+		return true;
+	}
+
+	const auto allocations = allocation_counter::threadAllocations();
+	const auto start = std::chrono::steady_clock::now();
 	func();
+	const auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+	g_taskProfiler().record(context, elapsed.count(), allocation_counter::threadAllocations() - allocations);
 
 	return true;
 }
@@ -9,16 +9,45 @@
 
 #pragma once
 #include "utils/tools.hpp"
+#include "utils/inline_function.hpp"
+#include "utils/pool_allocator.hpp"
 #include <unordered_set>
 
+// Callables up to this size are stored inside the task, without touching the allocator.
+static constexpr size_t TASK_INLINE_CAPACITY = 64;
+using TaskFunction = stdext::inline_function<void(void), TASK_INLINE_CAPACITY>;
+
+/**
+ * The context must outlive the task, it is expected to be
+ * a string literal or __FUNCTION__.
+ */
 class Task {
 public:
-	Task(uint32_t expiresAfterMs, std::function<void(void)> &&f, std::string_view context);
+	template <typename F>
+		requires std::is_invocable_v<F &>
+	Task(uint32_t expiresAfterMs, F &&f, std::string_view context) :
+		func(std::forward<F>(f)), context(context), utime(OTSYS_TIME()), expiration(expiresAfterMs > 0 ? OTSYS_TIME() + expiresAfterMs : 0) {
+		validateContext();
+	}
 
-	Task(std::function<void(void)> &&f, std::string_view context, uint32_t delay, bool cycle = false, bool log = true);
+	template <typename F>
+		requires std::is_invocable_v<F &>
+	Task(F &&f, std::string_view context, uint32_t delay, bool cycle = false, bool log = true) :
+		func(std::forward<F>(f)), context(context), utime(OTSYS_TIME() + delay), delay(delay), cycle(cycle), log(log) {
+		validateContext();
+	}
 
 	~Task() = default;
 
+	Task(Task &&) noexcept = default;
+	Task &operator=(Task &&) noexcept = default;
+
+	// Scheduled tasks are allocated from a pool, so scheduling does not hit the global allocator.
+	template <typename F>
+	static std::shared_ptr<Task> create(F &&f, std::string_view context, uint32_t delay, bool cycle = false, bool log = true) {
+		return std::allocate_shared<Task>(stdext::pool_allocator<Task>(), std::forward<F>(f), context, delay, cycle, log);
+	}
+
 	uint64_t getId() {
 		if (id == 0) {
 			if (++LAST_EVENT_ID == 0) {
@@ -59,11 +88,24 @@ public:
 		func = nullptr;
 	}
 
+	// Low priority tasks can be deferred (or dropped once expired) when the dispatcher cycle is over budget.
+	bool isLowPriority() const {
+		const static auto lowPriorityContexts = std::unordered_set<std::string_view>({ "Game::playerBrowseMarket",
+		                                                                               "Game::playerBrowseMarketOwnHistory",
+		                                                                               "Game::playerBrowseMarketOwnOffers",
+		                                                                               "Game::playerCyclopediaCharacterInfo",
+		                                                                               "Game::playerHighscores" });
+
+		return lowPriorityContexts.contains(context);
+	}
+
 	bool execute() const;
 
 private:
 	static std::atomic_uint_fast64_t LAST_EVENT_ID;
 
+	void validateContext() const;
+
 	void updateTime() {
 		utime = OTSYS_TIME() + delay;
 	}
@@ -73,9 +115,11 @@ private:
 		                                                                        "Dispatcher::asyncEvent",
 		                                                                        "Game::checkCreatureAttack",
 		                                                                        "Game::checkCreatureWalk",
+		                                                                        "Game::checkCreatureWalkBatch",
 		                                                                        "Game::checkCreatures",
 		                                                                        "Game::checkImbuements",
 		                                                                        "Game::checkLight",
+		                                                                        "Game::checkTilesToClean",
 		                                                                        "Game::createFiendishMonsters",
 		                                                                        "Game::createInfluencedMonsters",
 		                                                                        "Game::updateCreatureWalk",
@@ -103,8 +147,8 @@ private:
 		}
 	};
 
-	std::function<void(void)> func = nullptr;
-	std::string context;
+	TaskFunction func = nullptr;
+	std::string_view context;
 
 	int64_t utime = 0;
 	int64_t expiration = 0;
@@ -0,0 +1,170 @@
+/**
+ * Canary - A free and open-source MMORPG server emulator
+ * Copyright (©) 2019-2024 OpenTibiaBR <opentibiabr@outlook.com>
+ * Repository: https://github.com/opentibiabr/canary
+ * License: https://github.com/opentibiabr/canary/blob/main/LICENSE
+ * Contributors: https://github.com/opentibiabr/canary/graphs/contributors
+ * Website: https://docs.opentibiabr.com/
+ */
+
+#include "pch.hpp"
+
+#include "game/scheduling/task_profiler.hpp"
+
+#include "config/configmanager.hpp"
+#include "lib/di/container.hpp"
+#include "utils/tools.hpp"
+
+#include <bit>
+
+TaskProfiler &TaskProfiler::getInstance() {
+	return inject<TaskProfiler>();
+}
+
+TaskProfiler::Slot* TaskProfiler::findSlot(std::string_view context) {
+	// 0 marks a free slot
+	const auto hash = std::max<uint64_t>(std::hash<std::string_view> {}(context), 1);
+
+	for (size_t probe = 0; probe < MAX_CONTEXTS; ++probe) {
+		auto &slot = slots[(hash + probe) % MAX_CONTEXTS];
+		auto current = slot.hash.load(std::memory_order_acquire);
+		if (current == 0) {
+			if (slot.hash.compare_exchange_strong(current, hash, std::memory_order_acq_rel)) {
+				slot.nameLength.store(context.size(), std::memory_order_relaxed);
+				slot.name.store(context.data(), std::memory_order_release);
+				return &slot;
+			}
+		}
+
+		if (current == hash) {
+			return &slot;
+		}
+	}
+
+	// Table is full, new contexts are not tracked
+	return nullptr;
+}
+
+void TaskProfiler::record(std::string_view context, uint64_t nanoseconds, uint64_t allocations) {
+	auto* slot = findSlot(context);
+	if (!slot) {
+		return;
+	}
+
+	const auto microseconds = nanoseconds / 1000;
+	const auto bucket = std::min<size_t>(std::bit_width(microseconds), HISTOGRAM_BUCKETS - 1);
+
+	slot->count.fetch_add(1, std::memory_order_relaxed);
+	slot->totalTime.fetch_add(nanoseconds, std::memory_order_relaxed);
+	slot->allocations.fetch_add(allocations, std::memory_order_relaxed);
+	slot->histogram[bucket].fetch_add(1, std::memory_order_relaxed);
+}
+
+TaskProfiler::Snapshot TaskProfiler::capture() const {
+	Snapshot snapshot;
+	snapshot.time = OTSYS_TIME();
+
+	for (uint16_t i = 0; i < MAX_CONTEXTS; ++i) {
+		const auto &slot = slots[i];
+		if (slot.name.load(std::memory_order_acquire) == nullptr) {
+			continue;
+		}
+
+		auto &entry = snapshot.slots.emplace_back();
+		entry.slot = i;
+		entry.count = slot.count.load(std::memory_order_relaxed);
+		entry.totalTime = slot.totalTime.load(std::memory_order_relaxed);
+		entry.allocations = slot.allocations.load(std::memory_order_relaxed);
+		for (size_t bucket = 0; bucket < HISTOGRAM_BUCKETS; ++bucket) {
+			entry.histogram[bucket] = slot.histogram[bucket].load(std::memory_order_relaxed);
+		}
+	}
+
+	return snapshot;
+}
+
+void TaskProfiler::takeSnapshot() {
+	enabled = g_configManager().getBoolean(DISPATCHER_PROFILER, __FUNCTION__);
+
+	std::scoped_lock lock(snapshotsMutex);
+	if (!enabled) {
+		snapshots.clear();
+		return;
+	}
+
+	snapshots.emplace_back(capture());
+	while (snapshots.size() > MAX_WINDOW_SECONDS * 1000 / SNAPSHOT_INTERVAL + 1) {
+		snapshots.pop_front();
+	}
+}
+
+std::vector<TaskProfileEntry> TaskProfiler::getTop(size_t count, uint32_t seconds) const {
+	const auto current = capture();
+
+	// The newest snapshot taken at least 'seconds' ago, or the oldest one we have
+	static const Snapshot emptySnapshot;
+	const Snapshot* baseline = &emptySnapshot;
+	std::scoped_lock lock(snapshotsMutex);
+	const auto since = current.time - static_cast<int64_t>(std::min(seconds, MAX_WINDOW_SECONDS)) * 1000;
+	for (auto it = snapshots.rbegin(); it != snapshots.rend(); ++it) {
+		baseline = &*it;
+		if (it->time <= since) {
+			break;
+		}
+	}
+
+	std::vector<TaskProfileEntry> entries;
+	auto previous = baseline->slots.begin();
+	for (const auto &now : current.slots) {
+		while (previous != baseline->slots.end() && previous->slot < now.slot) {
+			++previous;
+		}
+
+		SlotSnapshot delta = now;
+		if (previous != baseline->slots.end() && previous->slot == now.slot) {
+			delta.count -= previous->count;
+			delta.totalTime -= previous->totalTime;
+			delta.allocations -= previous->allocations;
+			for (size_t bucket = 0; bucket < HISTOGRAM_BUCKETS; ++bucket) {
+				delta.histogram[bucket] -= previous->histogram[bucket];
+			}
+		}
+
+		if (delta.count == 0) {
+			continue;
+		}
+
+		uint64_t samples = 0;
+		for (const auto value : delta.histogram) {
+			samples += value;
+		}
+
+		// Upper bound of the bucket that holds the 99th percentile
+		uint64_t p99 = 0;
+		uint64_t accumulated = 0;
+		const auto threshold = (samples * 99 + 99) / 100;
+		for (size_t bucket = 0; bucket < HISTOGRAM_BUCKETS; ++bucket) {
+			accumulated += delta.histogram[bucket];
+			if (accumulated >= threshold) {
+				p99 = uint64_t(1) << bucket;
+				break;
+			}
+		}
+
+		const auto &slot = slots[now.slot];
+		auto &entry = entries.emplace_back();
+		entry.context = std::string_view(slot.name.load(std::memory_order_acquire), slot.nameLength.load(std::memory_order_relaxed));
+		entry.count = delta.count;
+		entry.totalTime = delta.totalTime / 1000;
+		entry.averageTime = entry.totalTime / delta.count;
+		entry.p99Time = p99;
+		entry.allocations = delta.allocations;
+	}
+
+	std::ranges::sort(entries, [](const auto &a, const auto &b) { return a.totalTime > b.totalTime; });
+	if (entries.size() > count) {
+		entries.resize(count);
+	}
+
+	return entries;
+}
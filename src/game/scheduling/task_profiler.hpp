@@ -0,0 +1,98 @@
+/**
+ * Canary - A free and open-source MMORPG server emulator
+ * Copyright (©) 2019-2024 OpenTibiaBR <opentibiabr@outlook.com>
+ * Repository: https://github.com/opentibiabr/canary
+ * License: https://github.com/opentibiabr/canary/blob/main/LICENSE
+ * Contributors: https://github.com/opentibiabr/canary/graphs/contributors
+ * Website: https://docs.opentibiabr.com/
+ */
+
+#pragma once
+
+struct TaskProfileEntry {
+	std::string_view context;
+	uint64_t count = 0;
+	// microseconds
+	uint64_t totalTime = 0;
+	uint64_t averageTime = 0;
+	uint64_t p99Time = 0;
+	uint64_t allocations = 0;
+};
+
+/**
+ * Keeps per task context counters (count, time and allocations) of executed dispatcher tasks.
+ * Recording is lock-free, each context gets a fixed slot on first use.
+ * Once per second a snapshot of the counters is taken, so the top contexts
+ * of the last N seconds can be computed from the difference between two snapshots.
+ */
+class TaskProfiler {
+public:
+	static constexpr uint32_t SNAPSHOT_INTERVAL = 1000;
+	static constexpr uint32_t MAX_WINDOW_SECONDS = 120;
+
+	TaskProfiler() = default;
+
+	// Singleton - ensures we don't accidentally copy it
+	TaskProfiler(const TaskProfiler &) = delete;
+	void operator=(const TaskProfiler &) = delete;
+
+	static TaskProfiler &getInstance();
+
+	static bool isEnabled() {
+		return enabled.load(std::memory_order_relaxed);
+	}
+
+	void record(std::string_view context, uint64_t nanoseconds, uint64_t allocations);
+
+	/**
+	 * Refreshes the enabled state from the config and stores the current counters,
+	 * called every SNAPSHOT_INTERVAL by a dispatcher cycle event.
+	 */
+	void takeSnapshot();
+
+	/**
+	 * @return the contexts with the highest total time over the last seconds (up to MAX_WINDOW_SECONDS).
+	 */
+	std::vector<TaskProfileEntry> getTop(size_t count, uint32_t seconds) const;
+
+private:
+	static constexpr size_t MAX_CONTEXTS = 1024;
+	// bucket i holds times below 2^i microseconds, the last one everything above
+	static constexpr size_t HISTOGRAM_BUCKETS = 24;
+
+	struct Slot {
+		std::atomic_uint64_t hash = 0;
+		std::atomic<const char*> name = nullptr;
+		std::atomic_size_t nameLength = 0;
+		std::atomic_uint64_t count = 0;
+		std::atomic_uint64_t totalTime = 0;
+		std::atomic_uint64_t allocations = 0;
+		std::array<std::atomic_uint32_t, HISTOGRAM_BUCKETS> histogram {};
+	};
+
+	struct SlotSnapshot {
+		uint16_t slot = 0;
+		uint64_t count = 0;
+		uint64_t totalTime = 0;
+		uint64_t allocations = 0;
+		std::array<uint32_t, HISTOGRAM_BUCKETS> histogram {};
+	};
+
+	struct Snapshot {
+		int64_t time = 0;
+		// sorted by slot, only slots in use
+		std::vector<SlotSnapshot> slots;
+	};
+
+	Slot* findSlot(std::string_view context);
+	Snapshot capture() const;
+
+	inline static std::atomic_bool enabled = false;
+
+	std::array<Slot, MAX_CONTEXTS> slots;
+
+	mutable std::mutex snapshotsMutex;
+	std::deque<Snapshot> snapshots;
+};
+
+constexpr auto g_taskProfiler = TaskProfiler::getInstance;
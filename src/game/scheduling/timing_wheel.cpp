@@ -0,0 +1,110 @@
+/**
+ * Canary - A free and open-source MMORPG server emulator
+ * Copyright (©) 2019-2024 OpenTibiaBR <opentibiabr@outlook.com>
+ * Repository: https://github.com/opentibiabr/canary
+ * License: https://github.com/opentibiabr/canary/blob/main/LICENSE
+ * Contributors: https://github.com/opentibiabr/canary/graphs/contributors
+ * Website: https://docs.opentibiabr.com/
+ */
+
+#include "pch.hpp"
+
+#include "game/scheduling/timing_wheel.hpp"
+
+void TimingWheel::insert(const std::shared_ptr<Task> &task) {
+	if (task->getTime() < nextTick) {
+		overdue.emplace_back(task);
+	} else {
+		place(task);
+	}
+	++count;
+}
+
+void TimingWheel::place(const std::shared_ptr<Task> &task) {
+	const auto expires = std::max<int64_t>(task->getTime(), nextTick);
+	const auto delta = std::min<int64_t>(expires - nextTick, MAX_DELTA);
+	const auto slotTime = nextTick + delta;
+
+	uint8_t level = 0;
+	while (level < LEVELS - 1 && delta >= (int64_t(1) << (SLOT_BITS * (level + 1)))) {
+		++level;
+	}
+
+	const auto slot = static_cast<uint8_t>((slotTime >> (SLOT_BITS * level)) & SLOT_MASK);
+	wheel[level][slot].emplace_back(task);
+	occupied[level].set(slot);
+}
+
+void TimingWheel::cascade(int64_t tick) {
+	// The deepest level whose slot boundary is crossed at this tick
+	uint8_t deepest = 1;
+	while (deepest < LEVELS - 1 && ((tick >> (SLOT_BITS * deepest)) & SLOT_MASK) == 0) {
+		++deepest;
+	}
+
+	// Move tasks down from the highest level first, so they reach their final slot in a single pass
+	for (uint8_t level = deepest; level >= 1; --level) {
+		const auto slot = static_cast<uint8_t>((tick >> (SLOT_BITS * level)) & SLOT_MASK);
+		if (!occupied[level].test(slot)) {
+			continue;
+		}
+
+		auto tasks = std::move(wheel[level][slot]);
+		wheel[level][slot].clear();
+		occupied[level].reset(slot);
+
+		for (const auto &task : tasks) {
+			place(task);
+		}
+	}
+}
+
+void TimingWheel::rebuild(int64_t now) {
+	std::vector<std::shared_ptr<Task>> tasks;
+	tasks.reserve(count);
+	for (uint8_t level = 0; level < LEVELS; ++level) {
+		for (auto &slot : wheel[level]) {
+			tasks.insert(tasks.end(), std::make_move_iterator(slot.begin()), std::make_move_iterator(slot.end()));
+			slot.clear();
+		}
+		occupied[level].reset();
+	}
+
+	// Tasks that are already due are moved to expiring, in time order
+	const auto due = std::stable_partition(tasks.begin(), tasks.end(), [now](const auto &task) { return task->getTime() <= now; });
+	std::stable_sort(tasks.begin(), due, [](const auto &a, const auto &b) { return a->getTime() < b->getTime(); });
+	expiring.insert(expiring.end(), std::make_move_iterator(tasks.begin()), std::make_move_iterator(due));
+
+	nextTick = now + 1;
+	for (auto it = due; it != tasks.end(); ++it) {
+		place(*it);
+	}
+}
+
+int64_t TimingWheel::nextExpiration() const {
+	if (count == 0) {
+		return std::numeric_limits<int64_t>::max();
+	}
+
+	if (!overdue.empty()) {
+		return nextTick - 1;
+	}
+
+	// Next time a higher level slot will be cascaded
+	bool hasHigherLevels = false;
+	for (uint8_t level = 1; level < LEVELS; ++level) {
+		hasHigherLevels = hasHigherLevels || occupied[level].any();
+	}
+	const auto nextCascade = hasHigherLevels ? (nextTick + SLOT_MASK) & ~SLOT_MASK : std::numeric_limits<int64_t>::max();
+
+	const auto start = static_cast<uint8_t>(nextTick & SLOT_MASK);
+	if (occupied[0].any()) {
+		for (uint16_t offset = 0; offset < SLOTS; ++offset) {
+			if (occupied[0].test(static_cast<uint8_t>(start + offset))) {
+				return std::min<int64_t>(nextTick + offset, nextCascade);
+			}
+		}
+	}
+
+	return nextCascade;
+}
@@ -0,0 +1,127 @@
+/**
+ * Canary - A free and open-source MMORPG server emulator
+ * Copyright (©) 2019-2024 OpenTibiaBR <opentibiabr@outlook.com>
+ * Repository: https://github.com/opentibiabr/canary
+ * License: https://github.com/opentibiabr/canary/blob/main/LICENSE
+ * Contributors: https://github.com/opentibiabr/canary/graphs/contributors
+ * Website: https://docs.opentibiabr.com/
+ */
+
+#pragma once
+
+#include "task.hpp"
+
+/**
+ * Hierarchical timing wheel used by the Dispatcher to hold scheduled tasks.
+ * Each level has 256 slots, the first level has a resolution of 1ms and each
+ * next level covers 256 times the range of the previous one (256ms, ~65s, ~4.6h, ~49 days).
+ * Insertion is O(1), tasks are cascaded to lower levels when their slot comes due.
+ * Canceled tasks are not removed, they are dropped when their slot expires.
+ */
+class TimingWheel {
+public:
+	explicit TimingWheel(int64_t startTime = 0) :
+		nextTick(startTime) { }
+
+	void insert(const std::shared_ptr<Task> &task);
+
+	/**
+	 * Expires every slot up to (and including) the given time,
+	 * calling f for each task in expiration order.
+	 */
+	template <typename F>
+	void expire(int64_t now, F &&f) {
+		if (!overdue.empty()) {
+			expiring.swap(overdue);
+			count -= expiring.size();
+			for (const auto &task : expiring) {
+				f(task);
+			}
+			expiring.clear();
+		}
+
+		if (count == 0) {
+			nextTick = std::max<int64_t>(nextTick, now + 1);
+			return;
+		}
+
+		// After a long stall it is cheaper to rebuild the wheel than to walk every slot
+		if (now - nextTick > SLOTS * SLOTS) {
+			rebuild(now);
+			count -= expiring.size();
+			for (const auto &task : expiring) {
+				f(task);
+			}
+			expiring.clear();
+		}
+
+		while (nextTick <= now) {
+			const auto tick = nextTick;
+			const auto slot = static_cast<uint8_t>(tick & SLOT_MASK);
+			if (slot == 0) {
+				cascade(tick);
+			}
+
+			// Nothing can expire before the next cascade, skip the whole level
+			if (occupied[0].none()) {
+				nextTick = std::min<int64_t>(now + 1, (tick | SLOT_MASK) + 1);
+				continue;
+			}
+
+			++nextTick;
+
+			if (!occupied[0].test(slot)) {
+				continue;
+			}
+
+			expiring.swap(wheel[0][slot]);
+			occupied[0].reset(slot);
+			count -= expiring.size();
+
+			for (const auto &task : expiring) {
+				f(task);
+			}
+			expiring.clear();
+
+			if (count == 0) {
+				nextTick = std::max<int64_t>(nextTick, now + 1);
+				return;
+			}
+		}
+	}
+
+	/**
+	 * @return the time of the next slot that needs to be processed,
+	 * std::numeric_limits<int64_t>::max() when there are no tasks.
+	 */
+	[[nodiscard]] int64_t nextExpiration() const;
+
+	[[nodiscard]] bool empty() const {
+		return count == 0;
+	}
+
+	[[nodiscard]] size_t size() const {
+		return count;
+	}
+
+private:
+	static constexpr uint8_t LEVELS = 4;
+	static constexpr uint8_t SLOT_BITS = 8;
+	static constexpr uint16_t SLOTS = 1 << SLOT_BITS;
+	static constexpr int64_t SLOT_MASK = SLOTS - 1;
+	static constexpr int64_t MAX_DELTA = (int64_t(1) << (SLOT_BITS * LEVELS)) - 1;
+
+	void place(const std::shared_ptr<Task> &task);
+	void cascade(int64_t tick);
+	void rebuild(int64_t now);
+
+	std::array<std::array<std::vector<std::shared_ptr<Task>>, SLOTS>, LEVELS> wheel;
+	std::array<std::bitset<SLOTS>, LEVELS> occupied;
+	std::vector<std::shared_ptr<Task>> expiring;
+	// tasks scheduled for a tick that was already processed
+	std::vector<std::shared_ptr<Task>> overdue;
+
+	// first tick (in ms) that was not processed yet
+	int64_t nextTick = 0;
+	size_t count = 0;
+};
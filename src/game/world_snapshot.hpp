@@ -0,0 +1,43 @@
+/**
+ * Canary - A free and open-source MMORPG server emulator
+ * Copyright (©) 2019-2024 OpenTibiaBR <opentibiabr@outlook.com>
+ * Repository: https://github.com/opentibiabr/canary
+ * License: https://github.com/opentibiabr/canary/blob/main/LICENSE
+ * Contributors: https://github.com/opentibiabr/canary/graphs/contributors
+ * Website: https://docs.opentibiabr.com/
+ */
+
+#pragma once
+
+#include "game/movement/position.hpp"
+
+/**
+ * A copy of the online players and the world counters, built by the dispatcher every worldSnapshotInterval
+ * milliseconds (Game::updateWorldSnapshot) and never changed after, so any thread can read it without
+ * touching the game state: the status protocol answers from it.
+ * The players are stored by field, a player has the same index in every vector, so a reader that counts
+ * or filters by one field walks a single array.
+ */
+struct WorldSnapshot {
+	// OTSYS_TIME of the build
+	int64_t builtAt = 0;
+
+	std::vector<uint32_t> guids;
+	std::vector<std::string> names;
+	std::vector<uint32_t> levels;
+	std::vector<uint16_t> vocations;
+	// 0 without a guild
+	std::vector<uint32_t> guildIds;
+	std::vector<Position> positions;
+	std::vector<uint32_t> ips;
+
+	uint32_t playersRecord = 0;
+	uint32_t monstersOnline = 0;
+	uint32_t npcsOnline = 0;
+	uint32_t mapWidth = 0;
+	uint32_t mapHeight = 0;
+
+	size_t size() const {
+		return guids.size();
+	}
+};
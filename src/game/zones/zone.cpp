@@ -21,6 +21,18 @@ phmap::parallel_flat_hash_map<std::string, std::shared_ptr<Zone>> Zone::zones =
 phmap::parallel_flat_hash_map<uint32_t, std::shared_ptr<Zone>> Zone::zonesByID = {};
 const static std::shared_ptr<Zone> nullZone = nullptr;
 
+phmap::flat_hash_map<Position, stdext::small_vector<Zone*, 1>> &Zone::positionIndex() {
+	// Never destroyed, the tiles may release their zones after the statics of this file are gone
+	static auto* index = new phmap::flat_hash_map<Position, stdext::small_vector<Zone*, 1>>();
+	return *index;
+}
+
+Zone::~Zone() {
+	for (const auto &position : positions) {
+		unindexPosition(position);
+	}
+}
+
 std::shared_ptr<Zone> Zone::addZone(const std::string &name, uint32_t zoneID /* = 0 */) {
 	if (name == "default") {
 		g_logger().error("Zone name {} is reserved", name);
@@ -46,17 +58,52 @@ std::shared_ptr<Zone> Zone::addZone(const std::string &name, uint32_t zoneID /*
 }
 
 void Zone::addArea(Area area) {
+	const auto self = shared_from_this();
 	for (const auto &pos : area) {
+		if (contains(pos)) {
+			continue;
+		}
 		addPosition(pos);
+		g_game().map.addZone(pos, self);
 	}
-	refresh();
 }
 
 void Zone::subtractArea(Area area) {
+	const auto self = shared_from_this();
 	for (const auto &pos : area) {
+		if (!contains(pos)) {
+			continue;
+		}
 		removePosition(pos);
+		g_game().map.removeZone(pos, self);
+	}
+}
+
+void Zone::addPosition(const Position &position) {
+	if (positions.emplace(position).second) {
+		positionIndex()[position].emplace_back(this);
+	}
+}
+
+void Zone::removePosition(const Position &position) {
+	if (positions.erase(position) != 0) {
+		unindexPosition(position);
+	}
+}
+
+void Zone::unindexPosition(const Position &position) {
+	auto &index = positionIndex();
+	const auto it = index.find(position);
+	if (it == index.end()) {
+		return;
+	}
+	auto &indexed = it->second;
+	if (const auto zone = std::ranges::find(indexed, this); zone != indexed.end()) {
+		indexed.erase(zone);
+	}
+	if (indexed.empty()) {
+		index.erase(it);
 	}
-	refresh();
 }
 
 bool Zone::contains(const Position &pos) const {
@@ -101,23 +148,23 @@ std::vector<Position> Zone::getPositions() const {
 }
 
 std::vector<std::shared_ptr<Creature>> Zone::getCreatures() {
-	return weak::lock(creaturesCache);
+	return creaturesCache.lock();
 }
 
 std::vector<std::shared_ptr<Player>> Zone::getPlayers() {
-	return weak::lock(playersCache);
+	return playersCache.lock();
 }
 
 std::vector<std::shared_ptr<Monster>> Zone::getMonsters() {
-	return weak::lock(monstersCache);
+	return monstersCache.lock();
 }
 
 std::vector<std::shared_ptr<Npc>> Zone::getNpcs() {
-	return weak::lock(npcsCache);
+	return npcsCache.lock();
 }
 
 std::vector<std::shared_ptr<Item>> Zone::getItems() {
-	return weak::lock(itemsCache);
+	return itemsCache.lock();
 }
 
 void Zone::removePlayers() {
@@ -156,18 +203,21 @@ void Zone::clearZones() {
 	}
 }
 
-std::vector<std::shared_ptr<Zone>> Zone::getZones(const Position position) {
-	Benchmark bm_getZones;
-	std::vector<std::shared_ptr<Zone>> result;
-	for (const auto &[_, zone] : zones) {
-		if (zone && zone->contains(position)) {
-			result.push_back(zone);
+ZoneVector Zone::getZones(const Position position) {
+	ZoneVector result;
+	const auto &index = positionIndex();
+	const auto it = index.find(position);
+	if (it == index.end()) {
+		return result;
+	}
+	for (const auto* zone : it->second) {
+		// The zones of the map are only listed once their name is loaded
+		const auto registered = zones.find(zone->name);
+		if (registered != zones.end() && registered->second.get() == zone) {
+			result.emplace_back(registered->second);
 		}
 	}
-	auto duration = bm_getZones.duration();
-	if (duration > 100) {
-		g_logger().warn("Listed {} zones for position {} in {} milliseconds", result.size(), position.toString(), duration);
-	}
+	std::ranges::sort(result);
 	return result;
 }
 
@@ -85,68 +85,71 @@ struct Area {
 };
 
 namespace weak {
+	/**
+	 * The members of a zone by type, kept by the zone as things enter and leave it.
+	 * Keyed by address, so nothing is locked to hash or compare; a thing destroyed without leaving
+	 * is dropped on the next walk, and its address taken by another thing just replaces the entry.
+	 */
 	template <typename T>
-	struct ThingHasher {
-		std::size_t operator()(std::weak_ptr<T> thing) const {
-			if (thing.expired()) {
-				return 0;
+	class set {
+	public:
+		void insert(const std::shared_ptr<T> &thing) {
+			if (thing) {
+				entries.insert_or_assign(thing.get(), thing);
 			}
-			return std::hash<void*> {}(thing.lock().get());
 		}
-	};
 
-	template <typename T>
-	struct ThingComparator {
-		bool operator()(const std::weak_ptr<T> &lhs, const std::weak_ptr<T> &rhs) const {
-			return lhs.lock() == rhs.lock();
+		void erase(const std::shared_ptr<T> &thing) {
+			if (thing) {
+				entries.erase(thing.get());
+			}
 		}
-	};
 
-	template <>
-	struct ThingHasher<Creature> {
-		std::size_t operator()(const std::weak_ptr<Creature> &weakCreature) const {
-			auto locked = weakCreature.lock();
-			if (!locked) {
-				return 0;
-			}
-			return std::hash<uint32_t> {}(locked->getID());
+		void clear() {
+			entries.clear();
 		}
-	};
 
-	template <>
-	struct ThingComparator<Creature> {
-		bool operator()(const std::weak_ptr<Creature> &lhs, const std::weak_ptr<Creature> &rhs) const {
-			if (lhs.expired() || rhs.expired()) {
-				return false;
+		// Does not lock the members, only skips the expired ones
+		size_t count() const {
+			size_t count = 0;
+			for (const auto &[_, thing] : entries) {
+				count += thing.expired() ? 0 : 1;
 			}
-			return lhs.lock()->getID() == rhs.lock()->getID();
+			return count;
 		}
-	};
 
-	template <typename T>
-	using set = std::unordered_set<std::weak_ptr<T>, ThingHasher<T>, ThingComparator<T>>;
-
-	template <typename T>
-	std::vector<std::shared_ptr<T>> lock(set<T> &weakSet) {
-		std::vector<std::shared_ptr<T>> result;
-		for (auto it = weakSet.begin(); it != weakSet.end();) {
-			if (it->expired()) {
-				it = weakSet.erase(it);
-			} else {
-				result.push_back(it->lock());
-				++it;
+		// f must not make things enter or leave the zone, take lock() for that
+		template <typename F>
+		void forEach(F &&f) {
+			for (auto it = entries.begin(); it != entries.end();) {
+				if (const auto thing = it->second.lock()) {
+					f(thing);
+					++it;
+				} else {
+					entries.erase(it++);
+				}
 			}
 		}
-		return result;
-	}
+
+		std::vector<std::shared_ptr<T>> lock() {
+			std::vector<std::shared_ptr<T>> result;
+			result.reserve(entries.size());
+			forEach([&result](const std::shared_ptr<T> &thing) { result.emplace_back(thing); });
+			return result;
+		}
+
+	private:
+		phmap::flat_hash_map<const T*, std::weak_ptr<T>> entries;
+	};
 }
 
-class Zone {
+class Zone : public std::enable_shared_from_this<Zone> {
 public:
 	explicit Zone(const std::string &name, uint32_t id = 0) :
 		name(name), id(id) { }
 	explicit Zone(uint32_t id) :
 		id(id) { }
+	~Zone();
 
 	// Deleted copy constructor and assignment operator.
 	Zone(const Zone &) = delete;
@@ -157,12 +160,8 @@ public:
 	}
 	void addArea(Area area);
 	void subtractArea(Area area);
-	void addPosition(const Position &position) {
-		positions.emplace(position);
-	}
-	void removePosition(const Position &position) {
-		positions.erase(position);
-	}
+	void addPosition(const Position &position);
+	void removePosition(const Position &position);
 	Position getRemoveDestination(const std::shared_ptr<Creature> &creature = nullptr) const;
 	void setRemoveDestination(const Position &position) {
 		removeDestination = position;
@@ -175,6 +174,44 @@ public:
 	std::vector<std::shared_ptr<Npc>> getNpcs();
 	std::vector<std::shared_ptr<Item>> getItems();
 
+	size_t getCreatureCount() const {
+		return creaturesCache.count();
+	}
+	size_t getPlayerCount() const {
+		return playersCache.count();
+	}
+	size_t getMonsterCount() const {
+		return monstersCache.count();
+	}
+	size_t getNpcCount() const {
+		return npcsCache.count();
+	}
+	size_t getItemCount() const {
+		return itemsCache.count();
+	}
+
+	// Walk the members without copying them, f must not make things enter or leave the zone
+	template <typename F>
+	void forEachCreature(F &&f) {
+		creaturesCache.forEach(std::forward<F>(f));
+	}
+	template <typename F>
+	void forEachPlayer(F &&f) {
+		playersCache.forEach(std::forward<F>(f));
+	}
+	template <typename F>
+	void forEachMonster(F &&f) {
+		monstersCache.forEach(std::forward<F>(f));
+	}
+	template <typename F>
+	void forEachNpc(F &&f) {
+		npcsCache.forEach(std::forward<F>(f));
+	}
+	template <typename F>
+	void forEachItem(F &&f) {
+		itemsCache.forEach(std::forward<F>(f));
+	}
+
 	void creatureAdded(const std::shared_ptr<Creature> &creature);
 	void creatureRemoved(const std::shared_ptr<Creature> &creature);
 	void thingAdded(const std::shared_ptr<Thing> &thing);
@@ -185,6 +222,7 @@ public:
 	void removeMonsters();
 	void removeNpcs();
 
+	// Rebuilds the members from every position, addArea and subtractArea only visit the positions they change
 	void refresh();
 
 	void setMonsterVariant(const std::string &variant);
@@ -199,7 +237,8 @@ public:
 	static std::shared_ptr<Zone> addZone(const std::string &name, uint32_t id = 0);
 	static std::shared_ptr<Zone> getZone(const std::string &name);
 	static std::shared_ptr<Zone> getZone(uint32_t id);
-	static std::vector<std::shared_ptr<Zone>> getZones(const Position position);
+	// The registered zones at a position, sorted like the zones of a tile
+	static ZoneVector getZones(const Position position);
 	static std::vector<std::shared_ptr<Zone>> getZones();
 	static void refreshAll() {
 		for (const auto &[_, zone] : zones) {
@@ -212,6 +251,7 @@ public:
 
 protected:
 	bool contains(const Position &position) const;
+	void unindexPosition(const Position &position);
 
 	Position removeDestination = Position();
 	std::string name;
@@ -227,4 +267,10 @@ protected:
 
 	static phmap::parallel_flat_hash_map<std::string, std::shared_ptr<Zone>> zones;
 	static phmap::parallel_flat_hash_map<uint32_t, std::shared_ptr<Zone>> zonesByID;
+
+	/**
+	 * The zones of every position, registered or not, kept by addPosition and removePosition,
+	 * so getZones(position) does not scan every zone. A zone leaves it when destroyed.
+	 */
+	static phmap::flat_hash_map<Position, stdext::small_vector<Zone*, 1>> &positionIndex();
 };
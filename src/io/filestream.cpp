@@ -13,12 +13,16 @@
 
 #include "io/fileloader.hpp"
 
+#ifndef _WIN32
+	#include <sys/mman.h>
+#endif
+
 uint32_t FileStream::tell() const {
 	return m_pos;
 }
 
 void FileStream::seek(uint32_t pos) {
-	if (pos > m_data.size()) {
+	if (pos > m_size) {
 		throw std::ios_base::failure("Seek failed");
 	}
 	m_pos = pos;
@@ -29,19 +33,27 @@ void FileStream::skip(uint32_t len) {
 }
 
 uint32_t FileStream::size() const {
-	std::size_t size = m_data.size();
-	if (size > std::numeric_limits<uint32_t>::max()) {
-		throw std::overflow_error("File size exceeds uint32_t range");
+	return m_size;
+}
+
+void FileStream::adviseSequential() const {
+#ifndef _WIN32
+	if (!m_source.is_mapped() || m_source.mapped_length() == 0) {
+		return;
 	}
 
-	return static_cast<uint32_t>(size);
+	// madvise needs the page aligned start of the mapping, not the (possibly offset) data pointer
+	auto* start = const_cast<char*>(m_source.data()) - (m_source.mapped_length() - m_source.length());
+	madvise(start, m_source.mapped_length(), MADV_SEQUENTIAL);
+	madvise(start, m_source.mapped_length(), MADV_WILLNEED);
+#endif
 }
 
 template <typename T>
 bool FileStream::read(T &ret, bool escape) {
 	const auto size = sizeof(T);
 
-	if (m_pos + size > m_data.size()) {
+	if (m_pos + size > m_size) {
 		throw std::ios_base::failure("Read failed");
 	}
 
@@ -66,7 +78,7 @@ bool FileStream::read(T &ret, bool escape) {
 uint8_t FileStream::getU8() {
 	uint8_t v = 0;
 
-	if (m_pos + 1 > m_data.size()) {
+	if (m_pos + 1 > m_size) {
 		throw std::ios_base::failure("Failed to getU8");
 	}
 
@@ -100,16 +112,20 @@ uint64_t FileStream::getU64() {
 }
 
 std::string FileStream::getString() {
-	std::string str;
+	return std::string(getStringView());
+}
+
+std::string_view FileStream::getStringView() {
+	std::string_view str;
 	if (const uint16_t len = getU16(); len > 0 && len < 8192) {
-		if (m_pos + len > m_data.size()) {
-			throw std::ios_base::failure("[FileStream::getString] - Read failed");
+		if (m_pos + len > m_size) {
+			throw std::ios_base::failure("[FileStream::getStringView] - Read failed");
 		}
 
-		str = { (char*)&m_data[m_pos], len };
+		str = { reinterpret_cast<const char*>(&m_data[m_pos]), len };
 		m_pos += len;
 	} else if (len != 0) {
-		throw std::ios_base::failure("[FileStream::getString] - Read failed because string is too big");
+		throw std::ios_base::failure("[FileStream::getStringView] - Read failed because string is too big");
 	}
 	return str;
 }
@@ -153,3 +169,23 @@ bool FileStream::endNode() {
 	back();
 	return false;
 }
+
+bool FileStream::skipNode() {
+	uint32_t depth = 0;
+	while (m_pos < m_size) {
+		const uint8_t byte = m_data[m_pos++];
+		if (byte == OTB::Node::ESCAPE) {
+			++m_pos;
+		} else if (byte == OTB::Node::START) {
+			++depth;
+		} else if (byte == OTB::Node::END) {
+			if (depth == 0) {
+				--m_nodes;
+				return true;
+			}
+			--depth;
+		}
+	}
+
+	return false;
+}
@@ -9,15 +9,39 @@
 
 #pragma once
 
+/**
+ * Reads OTB nodes directly from memory, nothing is copied out of the source buffer
+ * (strings can also be read as views into it, see getStringView).
+ */
 class FileStream {
 public:
-	FileStream(const char* begin, const char* end) {
-		m_data.insert(m_data.end(), begin, end);
-	}
+	/**
+	 * Stream over [begin, end), the buffer must outlive the stream.
+	 */
+	FileStream(const char* begin, const char* end) :
+		m_data(reinterpret_cast<const uint8_t*>(begin)), m_size(checkSize(end - begin)) { }
 
-	explicit FileStream(mio::mmap_source source) {
-		m_data.insert(m_data.end(), source.begin(), source.end());
-	}
+	/**
+	 * Stream over a memory mapped file, the stream keeps the mapping alive.
+	 */
+	explicit FileStream(mio::mmap_source source) :
+		m_source(std::move(source)), m_data(reinterpret_cast<const uint8_t*>(m_source.data())), m_size(checkSize(m_source.size())) { }
+
+	/**
+	 * Stream over the [begin, end) range of another stream, used to parse nodes independently.
+	 * The parent stream must outlive it.
+	 */
+	FileStream(const FileStream &parent, uint32_t begin, uint32_t end) :
+		m_data(parent.m_data + begin), m_size(end - begin) { }
+
+	FileStream(const FileStream &) = delete;
+	FileStream &operator=(const FileStream &) = delete;
+
+	/**
+	 * Tells the kernel the mapped file is about to be read front to back,
+	 * so it reads ahead aggressively. Does nothing on platforms without madvise.
+	 */
+	void adviseSequential() const;
 
 	void back(uint32_t pos = 1);
 	void seek(uint32_t pos);
@@ -27,6 +51,11 @@ public:
 
 	bool startNode(uint8_t type = 0);
 	bool endNode();
+	/**
+	 * Skips the rest of the current node (including its children) without parsing it,
+	 * must be called right after startNode.
+	 */
+	bool skipNode();
 	bool isProp(uint8_t prop, bool toNext = true);
 
 	uint8_t getU8();
@@ -34,12 +63,25 @@ public:
 	uint32_t getU32();
 	uint64_t getU64();
 	std::string getString();
+	/**
+	 * Same as getString, but the result points into the stream buffer.
+	 */
+	std::string_view getStringView();
 
 private:
+	static uint32_t checkSize(size_t size) {
+		if (size > std::numeric_limits<uint32_t>::max()) {
+			throw std::overflow_error("File size exceeds uint32_t range");
+		}
+		return static_cast<uint32_t>(size);
+	}
+
 	template <typename T>
 	bool read(T &ret, bool escape = false);
 	uint32_t m_nodes { 0 };
 	uint32_t m_pos { 0 };
 
-	std::vector<uint8_t> m_data;
+	mio::mmap_source m_source;
+	const uint8_t* m_data { nullptr };
+	uint32_t m_size { 0 };
 };
@@ -18,6 +18,85 @@
 #include "enums/account_errors.hpp"
 #include "utils/tools.hpp"
 
+namespace {
+	// The queries of the player sections, the loaders run them and IOLoginDataLoad::getSectionQueries fetches them together
+	std::string killsQuery(uint32_t guid) {
+		return fmt::format("SELECT `player_id`, `time`, `target`, `unavenged` FROM `player_kills` WHERE `player_id` = {}", guid);
+	}
+
+	std::string stashQuery(uint32_t guid) {
+		return fmt::format("SELECT `item_count`, `item_id`  FROM `player_stash` WHERE `player_id` = {}", guid);
+	}
+
+	std::string charmsQuery(uint32_t guid) {
+		return fmt::format("SELECT * FROM `player_charms` WHERE `player_guid` = {}", guid);
+	}
+
+	std::string spellsQuery(uint32_t guid) {
+		return fmt::format("SELECT `player_id`, `name` FROM `player_spells` WHERE `player_id` = {}", guid);
+	}
+
+	std::string itemsQuery(std::string_view table, uint32_t guid) {
+		return fmt::format("SELECT `pid`, `sid`, `itemtype`, `count`, `attributes` FROM `{}` WHERE `player_id` = {} ORDER BY `sid` DESC", table, guid);
+	}
+
+	std::string rewardsQuery(uint32_t guid) {
+		return fmt::format("SELECT `pid`, `sid`, `itemtype`, `count`, `attributes` FROM `player_rewards` WHERE `player_id` = {} ORDER BY `pid`, `sid` ASC", guid);
+	}
+
+	std::string storageQuery(uint32_t guid) {
+		return fmt::format("SELECT `key`, `value` FROM `player_storage` WHERE `player_id` = {}", guid);
+	}
+
+	std::string vipListQuery(uint32_t accountId) {
+		return fmt::format("SELECT `player_id` FROM `account_viplist` WHERE `account_id` = {}", accountId);
+	}
+
+	std::string vipGroupsQuery(uint32_t accountId) {
+		return fmt::format("SELECT `id`, `name`, `customizable` FROM `account_vipgroups` WHERE `account_id` = {}", accountId);
+	}
+
+	std::string vipGroupListQuery(uint32_t accountId) {
+		return fmt::format("SELECT `player_id`, `vipgroup_id` FROM `account_vipgrouplist` WHERE `account_id` = {}", accountId);
+	}
+
+	std::string preyQuery(uint32_t guid) {
+		return fmt::format("SELECT * FROM `player_prey` WHERE `player_id` = {}", guid);
+	}
+
+	std::string taskHuntingQuery(uint32_t guid) {
+		return fmt::format("SELECT * FROM `player_taskhunt` WHERE `player_id` = {}", guid);
+	}
+
+	std::string forgeHistoryQuery(uint32_t guid) {
+		return fmt::format("SELECT * FROM `forge_history` WHERE `player_id` = {}", guid);
+	}
+
+	std::string bosstiaryQuery(uint32_t guid) {
+		return fmt::format("SELECT * FROM `player_bosstiary` WHERE `player_id` = {}", guid);
+	}
+}
+
+void IOLoginDataLoad::loadItem(ItemsMap &itemsMap, uint32_t sid, uint32_t pid, uint16_t type, uint16_t count, const char* attr, size_t attrSize, const std::shared_ptr<Player> &player) {
+	PropStream propStream;
+	propStream.init(attr, attrSize);
+
+	try {
+		std::shared_ptr<Item> item = Item::CreateItem(type, count);
+		if (item) {
+			if (!item->unserializeAttr(propStream)) {
+				g_logger().warn("[{}] - Failed to deserialize item attributes {}, from player {}, from account id {}", __FUNCTION__, item->getID(), player->getName(), player->getAccountId());
+				return;
+			}
+			itemsMap[sid] = std::make_pair(item, pid);
+		} else {
+			g_logger().warn("[{}] - Failed to create item of type {} for player {}, from account id {}", __FUNCTION__, type, player->getName(), player->getAccountId());
+		}
+	} catch (const std::exception &e) {
+		g_logger().warn("[{}] - Exception during the creation or deserialization of the item: {}", __FUNCTION__, e.what());
+	}
+}
+
 void IOLoginDataLoad::loadItems(ItemsMap &itemsMap, DBResult_ptr result, const std::shared_ptr<Player> &player) {
 	try {
 		do {
@@ -27,30 +106,21 @@ void IOLoginDataLoad::loadItems(ItemsMap &itemsMap, DBResult_ptr result, const s
 			uint16_t count = result->getNumber<uint16_t>("count");
 			unsigned long attrSize;
 			const char* attr = result->getStream("attributes", attrSize);
-			PropStream propStream;
-			propStream.init(attr, attrSize);
-
-			try {
-				std::shared_ptr<Item> item = Item::CreateItem(type, count);
-				if (item) {
-					if (!item->unserializeAttr(propStream)) {
-						g_logger().warn("[{}] - Failed to deserialize item attributes {}, from player {}, from account id {}", __FUNCTION__, item->getID(), player->getName(), player->getAccountId());
-						continue;
-					}
-					itemsMap[sid] = std::make_pair(item, pid);
-				} else {
-					g_logger().warn("[{}] - Failed to create item of type {} for player {}, from account id {}", __FUNCTION__, type, player->getName(), player->getAccountId());
-				}
-			} catch (const std::exception &e) {
-				g_logger().warn("[{}] - Exception during the creation or deserialization of the item: {}", __FUNCTION__, e.what());
-				continue;
-			}
+			loadItem(itemsMap, sid, pid, type, count, attr, attrSize, player);
 		} while (result->next());
 	} catch (const std::exception &e) {
 		g_logger().error("[{}] - General exception during item loading: {}", __FUNCTION__, e.what());
 	}
 }
 
+void IOLoginDataLoad::startDecaying(const std::shared_ptr<Player> &player, const std::shared_ptr<Item> &item) {
+	if (player->loadingAsync) {
+		player->loadingDecayItems.emplace_back(item);
+		return;
+	}
+	item->startDecaying();
+}
+
 bool IOLoginDataLoad::preLoadPlayer(std::shared_ptr<Player> player, const std::string &name) {
 	Database &db = Database::getInstance();
 
@@ -130,7 +200,8 @@ bool IOLoginDataLoad::loadPlayerFirst(std::shared_ptr<Player> player, DBResult_p
 		return false;
 	}
 
-	player->setBankBalance(result->getNumber<uint64_t>("balance"));
+	// Not setBankBalance, the loaded balance is no change to journal or save
+	player->bankBalance = result->getNumber<uint64_t>("balance");
 	player->quickLootFallbackToMainContainer = result->getNumber<bool>("quickloot_fallback");
 	player->setSex(static_cast<PlayerSex_t>(result->getNumber<uint16_t>("sex")));
 	player->setPronoun(static_cast<PlayerPronoun_t>(result->getNumber<uint16_t>("pronoun")));
@@ -323,9 +394,8 @@ void IOLoginDataLoad::loadPlayerKills(std::shared_ptr<Player> player, DBResult_p
 	}
 
 	Database &db = Database::getInstance();
-	std::ostringstream query;
-	query << "SELECT `player_id`, `time`, `target`, `unavenged` FROM `player_kills` WHERE `player_id` = " << player->getGUID();
-	if ((result = db.storeQuery(query.str()))) {
+	const auto query = killsQuery(player->getGUID());
+	if ((result = db.storeQuery(query))) {
 		do {
 			time_t killTime = result->getNumber<time_t>("time");
 			if ((time(nullptr) - killTime) <= g_configManager().getNumber(FRAG_TIME, __FUNCTION__)) {
@@ -335,15 +405,16 @@ void IOLoginDataLoad::loadPlayerKills(std::shared_ptr<Player> player, DBResult_p
 	}
 }
 
-void IOLoginDataLoad::loadPlayerGuild(std::shared_ptr<Player> player, DBResult_ptr result) {
-	if (!result || !player) {
-		g_logger().warn("[IOLoginData::loadPlayer] - Player or Result nullptr: {}", __FUNCTION__);
+void IOLoginDataLoad::loadPlayerGuild(std::shared_ptr<Player> player) {
+	if (!player) {
+		g_logger().warn("[IOLoginData::loadPlayer] - Player nullptr: {}", __FUNCTION__);
 		return;
 	}
 
 	Database &db = Database::getInstance();
 	std::ostringstream query;
 	query << "SELECT `guild_id`, `rank_id`, `nick` FROM `guild_membership` WHERE `player_id` = " << player->getGUID();
+	DBResult_ptr result;
 	if ((result = db.storeQuery(query.str()))) {
 		uint32_t guildId = result->getNumber<uint32_t>("guild_id");
 		uint32_t playerRankId = result->getNumber<uint32_t>("rank_id");
@@ -392,9 +463,8 @@ void IOLoginDataLoad::loadPlayerStashItems(std::shared_ptr<Player> player, DBRes
 	}
 
 	Database &db = Database::getInstance();
-	std::ostringstream query;
-	query << "SELECT `item_count`, `item_id`  FROM `player_stash` WHERE `player_id` = " << player->getGUID();
-	if ((result = db.storeQuery(query.str()))) {
+	const auto query = stashQuery(player->getGUID());
+	if ((result = db.storeQuery(query))) {
 		do {
 			player->addItemOnStash(result->getNumber<uint16_t>("item_id"), result->getNumber<uint32_t>("item_count"));
 		} while (result->next());
@@ -408,9 +478,8 @@ void IOLoginDataLoad::loadPlayerBestiaryCharms(std::shared_ptr<Player> player, D
 	}
 
 	Database &db = Database::getInstance();
-	std::ostringstream query;
-	query << "SELECT * FROM `player_charms` WHERE `player_guid` = " << player->getGUID();
-	if ((result = db.storeQuery(query.str()))) {
+	const auto query = charmsQuery(player->getGUID());
+	if ((result = db.storeQuery(query))) {
 		player->charmPoints = result->getNumber<uint32_t>("charm_points");
 		player->charmExpansion = result->getNumber<bool>("charm_expansion");
 		player->charmRuneWound = result->getNumber<uint16_t>("rune_wound");
@@ -448,9 +517,7 @@ void IOLoginDataLoad::loadPlayerBestiaryCharms(std::shared_ptr<Player> player, D
 			}
 		}
 	} else {
-		query.str("");
-		query << "INSERT INTO `player_charms` (`player_guid`) VALUES (" << player->getGUID() << ')';
-		Database::getInstance().executeQuery(query.str());
+		db.executeQuery(fmt::format("INSERT INTO `player_charms` (`player_guid`) VALUES ({})", player->getGUID()));
 	}
 }
 
@@ -461,11 +528,10 @@ void IOLoginDataLoad::loadPlayerInstantSpellList(std::shared_ptr<Player> player,
 	}
 
 	Database &db = Database::getInstance();
-	std::ostringstream query;
-	query << "SELECT `player_id`, `name` FROM `player_spells` WHERE `player_id` = " << player->getGUID();
-	if ((result = db.storeQuery(query.str()))) {
+	const auto query = spellsQuery(player->getGUID());
+	if ((result = db.storeQuery(query))) {
 		do {
-			player->learnedInstantSpellList.emplace_back(result->getString("name"));
+			player->learnInstantSpell(result->getString("name"));
 		} while (result->next());
 	}
 }
@@ -478,14 +544,13 @@ void IOLoginDataLoad::loadPlayerInventoryItems(std::shared_ptr<Player> player, D
 
 	bool oldProtocol = g_configManager().getBoolean(OLD_PROTOCOL, __FUNCTION__) && player->getProtocolVersion() < 1200;
 	Database &db = Database::getInstance();
-	std::ostringstream query;
-	query << "SELECT `pid`, `sid`, `itemtype`, `count`, `attributes` FROM `player_items` WHERE `player_id` = " << player->getGUID() << " ORDER BY `sid` DESC";
+	const auto query = itemsQuery("player_items", player->getGUID());
 
 	ItemsMap inventoryItems;
 	std::vector<std::pair<uint8_t, std::shared_ptr<Container>>> openContainersList;
 
 	try {
-		if ((result = db.storeQuery(query.str()))) {
+		if ((result = db.storeQuery(query))) {
 			loadItems(inventoryItems, result, player);
 
 			for (ItemsMap::const_reverse_iterator it = inventoryItems.rbegin(), end = inventoryItems.rend(); it != end; ++it) {
@@ -499,7 +564,7 @@ void IOLoginDataLoad::loadPlayerInventoryItems(std::shared_ptr<Player> player, D
 
 				if (pid >= CONST_SLOT_FIRST && pid <= CONST_SLOT_LAST) {
 					player->internalAddThing(pid, item);
-					item->startDecaying();
+					startDecaying(player, item);
 				} else {
 					ItemsMap::const_iterator it2 = inventoryItems.find(pid);
 					if (it2 == inventoryItems.end()) {
@@ -509,7 +574,7 @@ void IOLoginDataLoad::loadPlayerInventoryItems(std::shared_ptr<Player> player, D
 					std::shared_ptr<Container> container = it2->second.first->getContainer();
 					if (container) {
 						container->internalAddThing(item);
-						item->startDecaying();
+						startDecaying(player, item);
 					}
 				}
 
@@ -570,11 +635,7 @@ void IOLoginDataLoad::loadRewardItems(std::shared_ptr<Player> player) {
 	}
 
 	ItemsMap rewardItems;
-	std::ostringstream query;
-	query.str(std::string());
-	query << "SELECT `pid`, `sid`, `itemtype`, `count`, `attributes` FROM `player_rewards` WHERE `player_id` = "
-		  << player->getGUID() << " ORDER BY `pid`, `sid` ASC";
-	if (auto result = Database::getInstance().storeQuery(query.str())) {
+	if (auto result = Database::getInstance().storeQuery(rewardsQuery(player->getGUID()))) {
 		loadItems(rewardItems, result, player);
 		bindRewardBag(player, rewardItems);
 		insertItemsIntoRewardBag(rewardItems);
@@ -588,33 +649,66 @@ void IOLoginDataLoad::loadPlayerDepotItems(std::shared_ptr<Player> player, DBRes
 	}
 
 	Database &db = Database::getInstance();
+	const auto query = itemsQuery("player_depotitems", player->getGUID());
+	if (!(result = db.storeQuery(query))) {
+		return;
+	}
+
+	if (g_configManager().getBoolean(LAZY_DEPOT_LOADING, __FUNCTION__)) {
+		// Only the rows are kept, most sessions never open the depot
+		do {
+			unsigned long attrSize;
+			const char* attr = result->getStream("attributes", attrSize);
+			player->pendingDepotItems.emplace_back(PendingItemRow {
+				result->getNumber<uint32_t>("sid"),
+				result->getNumber<uint32_t>("pid"),
+				result->getNumber<uint16_t>("itemtype"),
+				result->getNumber<uint16_t>("count"),
+				std::string(attr, attrSize),
+			});
+		} while (result->next());
+		return;
+	}
+
 	ItemsMap depotItems;
-	std::ostringstream query;
-	query << "SELECT `pid`, `sid`, `itemtype`, `count`, `attributes` FROM `player_depotitems` WHERE `player_id` = " << player->getGUID() << " ORDER BY `sid` DESC";
-	if ((result = db.storeQuery(query.str()))) {
-		loadItems(depotItems, result, player);
-		for (ItemsMap::const_reverse_iterator it = depotItems.rbegin(), end = depotItems.rend(); it != end; ++it) {
-			const std::pair<std::shared_ptr<Item>, int32_t> &pair = it->second;
-			std::shared_ptr<Item> item = pair.first;
+	loadItems(depotItems, result, player);
+	placeDepotItems(player, depotItems);
+}
 
-			int32_t pid = pair.second;
-			if (pid >= 0 && pid < 100) {
-				std::shared_ptr<DepotChest> depotChest = player->getDepotChest(pid, true);
-				if (depotChest) {
-					depotChest->internalAddThing(item);
-					item->startDecaying();
-				}
-			} else {
-				ItemsMap::const_iterator it2 = depotItems.find(pid);
-				if (it2 == depotItems.end()) {
-					continue;
-				}
+void IOLoginDataLoad::loadPendingDepotItems(const std::shared_ptr<Player> &player) {
+	// Moved out first, getDepotChest loads the pending items itself
+	const auto rows = std::move(player->pendingDepotItems);
+	player->pendingDepotItems.clear();
 
-				std::shared_ptr<Container> container = it2->second.first->getContainer();
-				if (container) {
-					container->internalAddThing(item);
-					item->startDecaying();
-				}
+	ItemsMap depotItems;
+	for (const auto &row : rows) {
+		loadItem(depotItems, row.sid, row.pid, row.type, row.count, row.attributes.data(), row.attributes.size(), player);
+	}
+	placeDepotItems(player, depotItems);
+}
+
+void IOLoginDataLoad::placeDepotItems(const std::shared_ptr<Player> &player, const ItemsMap &depotItems) {
+	for (ItemsMap::const_reverse_iterator it = depotItems.rbegin(), end = depotItems.rend(); it != end; ++it) {
+		const std::pair<std::shared_ptr<Item>, int32_t> &pair = it->second;
+		std::shared_ptr<Item> item = pair.first;
+
+		int32_t pid = pair.second;
+		if (pid >= 0 && pid < 100) {
+			std::shared_ptr<DepotChest> depotChest = player->getDepotChest(pid, true);
+			if (depotChest) {
+				depotChest->internalAddThing(item);
+				startDecaying(player, item);
+			}
+		} else {
+			ItemsMap::const_iterator it2 = depotItems.find(pid);
+			if (it2 == depotItems.end()) {
+				continue;
+			}
+
+			std::shared_ptr<Container> container = it2->second.first->getContainer();
+			if (container) {
+				container->internalAddThing(item);
+				startDecaying(player, item);
 			}
 		}
 	}
@@ -627,9 +721,8 @@ void IOLoginDataLoad::loadPlayerInboxItems(std::shared_ptr<Player> player, DBRes
 	}
 
 	Database &db = Database::getInstance();
-	std::ostringstream query;
-	query << "SELECT `pid`, `sid`, `itemtype`, `count`, `attributes` FROM `player_inboxitems` WHERE `player_id` = " << player->getGUID() << " ORDER BY `sid` DESC";
-	if ((result = db.storeQuery(query.str()))) {
+	const auto query = itemsQuery("player_inboxitems", player->getGUID());
+	if ((result = db.storeQuery(query))) {
 		ItemsMap inboxItems;
 		loadItems(inboxItems, result, player);
 
@@ -639,7 +732,7 @@ void IOLoginDataLoad::loadPlayerInboxItems(std::shared_ptr<Player> player, DBRes
 			int32_t pid = pair.second;
 			if (pid >= 0 && pid < 100) {
 				player->getInbox()->internalAddThing(item);
-				item->startDecaying();
+				startDecaying(player, item);
 			} else {
 				ItemsMap::const_iterator it2 = inboxItems.find(pid);
 				if (it2 == inboxItems.end()) {
@@ -649,7 +742,7 @@ void IOLoginDataLoad::loadPlayerInboxItems(std::shared_ptr<Player> player, DBRes
 				std::shared_ptr<Container> container = it2->second.first->getContainer();
 				if (container) {
 					container->internalAddThing(item);
-					item->startDecaying();
+					startDecaying(player, item);
 				}
 			}
 		}
@@ -663,9 +756,8 @@ void IOLoginDataLoad::loadPlayerStorageMap(std::shared_ptr<Player> player, DBRes
 	}
 
 	Database &db = Database::getInstance();
-	std::ostringstream query;
-	query << "SELECT `key`, `value` FROM `player_storage` WHERE `player_id` = " << player->getGUID();
-	if ((result = db.storeQuery(query.str()))) {
+	const auto query = storageQuery(player->getGUID());
+	if ((result = db.storeQuery(query))) {
 		do {
 			player->addStorageValue(result->getNumber<uint32_t>("key"), result->getNumber<int32_t>("value"), true);
 		} while (result->next());
@@ -681,14 +773,14 @@ void IOLoginDataLoad::loadPlayerVip(std::shared_ptr<Player> player, DBResult_ptr
 	uint32_t accountId = player->getAccountId();
 
 	Database &db = Database::getInstance();
-	std::string query = fmt::format("SELECT `player_id` FROM `account_viplist` WHERE `account_id` = {}", accountId);
+	std::string query = vipListQuery(accountId);
 	if ((result = db.storeQuery(query))) {
 		do {
 			player->vip()->addInternal(result->getNumber<uint32_t>("player_id"));
 		} while (result->next());
 	}
 
-	query = fmt::format("SELECT `id`, `name`, `customizable` FROM `account_vipgroups` WHERE `account_id` = {}", accountId);
+	query = vipGroupsQuery(accountId);
 	if ((result = db.storeQuery(query))) {
 		do {
 			player->vip()->addGroupInternal(
@@ -699,7 +791,7 @@ void IOLoginDataLoad::loadPlayerVip(std::shared_ptr<Player> player, DBResult_ptr
 		} while (result->next());
 	}
 
-	query = fmt::format("SELECT `player_id`, `vipgroup_id` FROM `account_vipgrouplist` WHERE `account_id` = {}", accountId);
+	query = vipGroupListQuery(accountId);
 	if ((result = db.storeQuery(query))) {
 		do {
 			player->vip()->addGuidToGroupInternal(
@@ -718,9 +810,8 @@ void IOLoginDataLoad::loadPlayerPreyClass(std::shared_ptr<Player> player, DBResu
 
 	if (g_configManager().getBoolean(PREY_ENABLED, __FUNCTION__)) {
 		Database &db = Database::getInstance();
-		std::ostringstream query;
-		query << "SELECT * FROM `player_prey` WHERE `player_id` = " << player->getGUID();
-		if (result = db.storeQuery(query.str())) {
+		const auto query = preyQuery(player->getGUID());
+		if (result = db.storeQuery(query)) {
 			do {
 				auto slot = std::make_unique<PreySlot>(static_cast<PreySlot_t>(result->getNumber<uint16_t>("slot")));
 				auto state = static_cast<PreyDataState_t>(result->getNumber<uint16_t>("state"));
@@ -765,9 +856,8 @@ void IOLoginDataLoad::loadPlayerTaskHuntingClass(std::shared_ptr<Player> player,
 
 	if (g_configManager().getBoolean(TASK_HUNTING_ENABLED, __FUNCTION__)) {
 		Database &db = Database::getInstance();
-		std::ostringstream query;
-		query << "SELECT * FROM `player_taskhunt` WHERE `player_id` = " << player->getGUID();
-		if (result = db.storeQuery(query.str())) {
+		const auto query = taskHuntingQuery(player->getGUID());
+		if (result = db.storeQuery(query)) {
 			do {
 				auto slot = std::make_unique<TaskHuntingSlot>(static_cast<PreySlot_t>(result->getNumber<uint16_t>("slot")));
 				auto state = static_cast<PreyTaskDataState_t>(result->getNumber<uint16_t>("state"));
@@ -813,9 +903,8 @@ void IOLoginDataLoad::loadPlayerForgeHistory(std::shared_ptr<Player> player, DBR
 		return;
 	}
 
-	std::ostringstream query;
-	query << "SELECT * FROM `forge_history` WHERE `player_id` = " << player->getGUID();
-	if (result = Database::getInstance().storeQuery(query.str())) {
+	const auto query = forgeHistoryQuery(player->getGUID());
+	if (result = Database::getInstance().storeQuery(query)) {
 		do {
 			auto actionEnum = magic_enum::enum_value<ForgeAction_t>(result->getNumber<uint16_t>("action_type"));
 			ForgeHistory history;
@@ -839,9 +928,8 @@ void IOLoginDataLoad::loadPlayerBosstiary(std::shared_ptr<Player> player, DBResu
 		return;
 	}
 
-	std::ostringstream query;
-	query << "SELECT * FROM `player_bosstiary` WHERE `player_id` = " << player->getGUID();
-	if (result = Database::getInstance().storeQuery(query.str())) {
+	const auto query = bosstiaryQuery(player->getGUID());
+	if (result = Database::getInstance().storeQuery(query)) {
 		do {
 			player->setSlotBossId(1, result->getNumber<uint16_t>("bossIdSlotOne"));
 			player->setSlotBossId(2, result->getNumber<uint16_t>("bossIdSlotTwo"));
@@ -934,3 +1022,34 @@ void IOLoginDataLoad::loadPlayerUpdateSystem(std::shared_ptr<Player> player) {
 	player->updateInventoryWeight();
 	player->updateItemsLight(true);
 }
+
+std::vector<std::string> IOLoginDataLoad::getSectionQueries(const std::shared_ptr<Player> &player, bool disableIrrelevantInfo) {
+	const auto guid = player->getGUID();
+	const auto accountId = player->getAccountId();
+	std::vector<std::string> queries {
+		killsQuery(guid),
+		stashQuery(guid),
+		charmsQuery(guid),
+		itemsQuery("player_items", guid),
+		itemsQuery("player_depotitems", guid),
+		rewardsQuery(guid),
+		itemsQuery("player_inboxitems", guid),
+		storageQuery(guid),
+		vipListQuery(accountId),
+		vipGroupsQuery(accountId),
+		vipGroupListQuery(accountId),
+		spellsQuery(guid),
+	};
+
+	if (g_configManager().getBoolean(PREY_ENABLED, __FUNCTION__)) {
+		queries.emplace_back(preyQuery(guid));
+	}
+	if (g_configManager().getBoolean(TASK_HUNTING_ENABLED, __FUNCTION__)) {
+		queries.emplace_back(taskHuntingQuery(guid));
+	}
+	if (!disableIrrelevantInfo) {
+		queries.emplace_back(forgeHistoryQuery(guid));
+		queries.emplace_back(bosstiaryQuery(guid));
+	}
+	return queries;
+}
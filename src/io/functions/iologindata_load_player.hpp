@@ -22,13 +22,15 @@ public:
 	static void loadPlayerSkullSystem(std::shared_ptr<Player> player, DBResult_ptr result);
 	static void loadPlayerSkill(std::shared_ptr<Player> player, DBResult_ptr result);
 	static void loadPlayerKills(std::shared_ptr<Player> player, DBResult_ptr result);
-	static void loadPlayerGuild(std::shared_ptr<Player> player, DBResult_ptr result);
+	static void loadPlayerGuild(std::shared_ptr<Player> player);
 	static void loadPlayerStashItems(std::shared_ptr<Player> player, DBResult_ptr result);
 	static void loadPlayerBestiaryCharms(std::shared_ptr<Player> player, DBResult_ptr result);
 	static void loadPlayerInstantSpellList(std::shared_ptr<Player> player, DBResult_ptr result);
 	static void loadPlayerInventoryItems(std::shared_ptr<Player> player, DBResult_ptr result);
 	static void loadPlayerStoreInbox(std::shared_ptr<Player> player);
 	static void loadPlayerDepotItems(std::shared_ptr<Player> player, DBResult_ptr result);
+	// Creates the depot items kept as rows by lazyDepotLoading
+	static void loadPendingDepotItems(const std::shared_ptr<Player> &player);
 	static void loadRewardItems(std::shared_ptr<Player> player);
 	static void loadPlayerInboxItems(std::shared_ptr<Player> player, DBResult_ptr result);
 	static void loadPlayerStorageMap(std::shared_ptr<Player> player, DBResult_ptr result);
@@ -40,11 +42,21 @@ public:
 	static void loadPlayerInitializeSystem(std::shared_ptr<Player> player);
 	static void loadPlayerUpdateSystem(std::shared_ptr<Player> player);
 
+	/**
+	 * @return the queries the section loaders of loadPlayer run for the player, after loadPlayerFirst,
+	 * so they can be fetched together (see DBPrefetch).
+	 */
+	static std::vector<std::string> getSectionQueries(const std::shared_ptr<Player> &player, bool disableIrrelevantInfo);
+
 private:
 	using ItemsMap = std::map<uint32_t, std::pair<std::shared_ptr<Item>, uint32_t>>;
 
 	static void bindRewardBag(std::shared_ptr<Player> player, ItemsMap &rewardItemsMap);
 	static void insertItemsIntoRewardBag(const ItemsMap &rewardItemsMap);
 
+	static void loadItem(ItemsMap &itemsMap, uint32_t sid, uint32_t pid, uint16_t type, uint16_t count, const char* attr, size_t attrSize, const std::shared_ptr<Player> &player);
 	static void loadItems(ItemsMap &itemsMap, DBResult_ptr result, const std::shared_ptr<Player> &player);
+	static void placeDepotItems(const std::shared_ptr<Player> &player, const ItemsMap &depotItems);
+	// The decay of a player loaded off the dispatcher starts in finishLoadPlayer
+	static void startDecaying(const std::shared_ptr<Player> &player, const std::shared_ptr<Item> &item);
 };
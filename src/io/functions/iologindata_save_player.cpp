@@ -10,7 +10,9 @@
 #include "pch.hpp"
 
 #include "io/functions/iologindata_save_player.hpp"
+#include "creatures/players/highscore_index.hpp"
 #include "game/game.hpp"
+#include "io/persistence_journal.hpp"
 
 bool IOLoginDataSave::saveItems(std::shared_ptr<Player> player, const ItemBlockList &itemList, DBInsert &query_insert, PropWriteStream &propWriteStream) {
 	if (!player) {
@@ -160,70 +162,93 @@ bool IOLoginDataSave::savePlayerFirst(std::shared_ptr<Player> player) {
 
 	Database &db = Database::getInstance();
 
-	std::ostringstream query;
-	query << "SELECT `save` FROM `players` WHERE `id` = " << player->getGUID();
-	DBResult_ptr result = db.storeQuery(query.str());
-	if (!result) {
-		g_logger().warn("[IOLoginData::savePlayer] - Error for select result query from player: {}", player->getName());
+	// The save flag is checked by the updates themselves, so the save only writes and can be captured (see DBCapture)
+	DBStatement loginUpdate("UPDATE `players` SET `lastlogin` = ?, `lastip` = ? WHERE `id` = ? AND `save` = 0");
+	loginUpdate.bind(player->lastLoginSaved).bind(player->lastIP).bind(player->getGUID());
+	if (!db.executeQuery(loginUpdate)) {
 		return false;
 	}
 
-	if (result->getNumber<uint16_t>("save") == 0) {
-		query.str("");
-		query << "UPDATE `players` SET `lastlogin` = " << player->lastLoginSaved << ", `lastip` = " << player->lastIP << " WHERE `id` = " << player->getGUID();
-		return db.executeQuery(query.str());
-	}
-
-	// First, an UPDATE query to write the player itself
-	query.str("");
-	query << "UPDATE `players` SET ";
-	query << "`name` = " << db.escapeString(player->name) << ",";
-	query << "`level` = " << player->level << ",";
-	query << "`group_id` = " << player->group->id << ",";
-	query << "`vocation` = " << player->getVocationId() << ",";
-	query << "`health` = " << player->health << ",";
-	query << "`healthmax` = " << player->healthMax << ",";
-	query << "`experience` = " << player->experience << ",";
-	query << "`lookbody` = " << static_cast<uint32_t>(player->defaultOutfit.lookBody) << ",";
-	query << "`lookfeet` = " << static_cast<uint32_t>(player->defaultOutfit.lookFeet) << ",";
-	query << "`lookhead` = " << static_cast<uint32_t>(player->defaultOutfit.lookHead) << ",";
-	query << "`looklegs` = " << static_cast<uint32_t>(player->defaultOutfit.lookLegs) << ",";
-	query << "`looktype` = " << player->defaultOutfit.lookType << ",";
-	query << "`lookaddons` = " << static_cast<uint32_t>(player->defaultOutfit.lookAddons) << ",";
-	query << "`lookmountbody` = " << static_cast<uint32_t>(player->defaultOutfit.lookMountBody) << ",";
-	query << "`lookmountfeet` = " << static_cast<uint32_t>(player->defaultOutfit.lookMountFeet) << ",";
-	query << "`lookmounthead` = " << static_cast<uint32_t>(player->defaultOutfit.lookMountHead) << ",";
-	query << "`lookmountlegs` = " << static_cast<uint32_t>(player->defaultOutfit.lookMountLegs) << ",";
-	query << "`lookfamiliarstype` = " << player->defaultOutfit.lookFamiliarsType << ",";
-	query << "`isreward` = " << static_cast<uint16_t>(player->isDailyReward) << ",";
-	query << "`maglevel` = " << player->magLevel << ",";
-	query << "`mana` = " << player->mana << ",";
-	query << "`manamax` = " << player->manaMax << ",";
-	query << "`manaspent` = " << player->manaSpent << ",";
-	query << "`soul` = " << static_cast<uint16_t>(player->soul) << ",";
-	query << "`town_id` = " << player->town->getID() << ",";
+	// First, an UPDATE query to write the player itself, the optional columns only change the query between a few cached variants
+	std::string query = "UPDATE `players` SET `name` = ?, `level` = ?, `group_id` = ?, `vocation` = ?, `health` = ?, `healthmax` = ?, `experience` = ?, "
+						"`lookbody` = ?, `lookfeet` = ?, `lookhead` = ?, `looklegs` = ?, `looktype` = ?, `lookaddons` = ?, "
+						"`lookmountbody` = ?, `lookmountfeet` = ?, `lookmounthead` = ?, `lookmountlegs` = ?, `lookfamiliarstype` = ?, `isreward` = ?, "
+						"`maglevel` = ?, `mana` = ?, `manamax` = ?, `manaspent` = ?, `soul` = ?, `town_id` = ?, `posx` = ?, `posy` = ?, `posz` = ?, "
+						"`prey_wildcard` = ?, `task_points` = ?, `boss_points` = ?, `forge_dusts` = ?, `forge_dust_level` = ?, `randomize_mount` = ?, "
+						"`cap` = ?, `sex` = ?, ";
+	if (player->lastLoginSaved != 0) {
+		query += "`lastlogin` = ?, ";
+	}
+	if (player->lastIP != 0) {
+		query += "`lastip` = ?, ";
+	}
+	query += "`conditions` = ?, ";
 
-	const Position &loginPosition = player->getLoginPosition();
-	query << "`posx` = " << loginPosition.getX() << ",";
-	query << "`posy` = " << loginPosition.getY() << ",";
-	query << "`posz` = " << loginPosition.getZ() << ",";
+	const bool saveSkull = g_game().getWorldType() != WORLD_TYPE_PVP_ENFORCED;
+	if (saveSkull) {
+		query += "`skulltime` = ?, `skull` = ?, ";
+	}
 
-	query << "`prey_wildcard` = " << player->getPreyCards() << ",";
-	query << "`task_points` = " << player->getTaskHuntingPoints() << ",";
-	query << "`boss_points` = " << player->getBossPoints() << ",";
-	query << "`forge_dusts` = " << player->getForgeDusts() << ",";
-	query << "`forge_dust_level` = " << player->getForgeDustLevel() << ",";
-	query << "`randomize_mount` = " << static_cast<uint16_t>(player->isRandomMounted()) << ",";
+	query += "`lastlogout` = ?, `balance` = ?, `offlinetraining_time` = ?, `offlinetraining_skill` = ?, `stamina` = ?, "
+			 "`skill_fist` = ?, `skill_fist_tries` = ?, `skill_club` = ?, `skill_club_tries` = ?, `skill_sword` = ?, `skill_sword_tries` = ?, "
+			 "`skill_axe` = ?, `skill_axe_tries` = ?, `skill_dist` = ?, `skill_dist_tries` = ?, `skill_shielding` = ?, `skill_shielding_tries` = ?, "
+			 "`skill_fishing` = ?, `skill_fishing_tries` = ?, `skill_critical_hit_chance` = ?, `skill_critical_hit_chance_tries` = ?, "
+			 "`skill_critical_hit_damage` = ?, `skill_critical_hit_damage_tries` = ?, `skill_life_leech_chance` = ?, `skill_life_leech_chance_tries` = ?, "
+			 "`skill_life_leech_amount` = ?, `skill_life_leech_amount_tries` = ?, `skill_mana_leech_chance` = ?, `skill_mana_leech_chance_tries` = ?, "
+			 "`skill_mana_leech_amount` = ?, `skill_mana_leech_amount_tries` = ?, `manashield` = ?, `max_manashield` = ?, "
+			 "`xpboost_value` = ?, `xpboost_stamina` = ?, `quickloot_fallback` = ?, ";
+	if (!player->isOffline()) {
+		query += "`onlinetime` = `onlinetime` + ?, ";
+	}
+	query += "`blessings1` = ?, `blessings2` = ?, `blessings3` = ?, `blessings4` = ?, `blessings5` = ?, `blessings6` = ?, `blessings7` = ?, `blessings8` = ? "
+			 "WHERE `id` = ? AND `save` <> 0";
+
+	DBStatement update(std::move(query));
+	update.bind(player->name)
+		.bind(player->level)
+		.bind(player->group->id)
+		.bind(player->getVocationId())
+		.bind(player->health)
+		.bind(player->healthMax)
+		.bind(player->experience)
+		.bind(player->defaultOutfit.lookBody)
+		.bind(player->defaultOutfit.lookFeet)
+		.bind(player->defaultOutfit.lookHead)
+		.bind(player->defaultOutfit.lookLegs)
+		.bind(player->defaultOutfit.lookType)
+		.bind(player->defaultOutfit.lookAddons)
+		.bind(player->defaultOutfit.lookMountBody)
+		.bind(player->defaultOutfit.lookMountFeet)
+		.bind(player->defaultOutfit.lookMountHead)
+		.bind(player->defaultOutfit.lookMountLegs)
+		.bind(player->defaultOutfit.lookFamiliarsType)
+		.bind(player->isDailyReward)
+		.bind(player->magLevel)
+		.bind(player->mana)
+		.bind(player->manaMax)
+		.bind(player->manaSpent)
+		.bind(player->soul)
+		.bind(player->town->getID());
 
-	query << "`cap` = " << (player->capacity / 100) << ",";
-	query << "`sex` = " << static_cast<uint16_t>(player->sex) << ",";
+	const Position &loginPosition = player->getLoginPosition();
+	update.bind(loginPosition.getX())
+		.bind(loginPosition.getY())
+		.bind(loginPosition.getZ())
+		.bind(player->getPreyCards())
+		.bind(player->getTaskHuntingPoints())
+		.bind(player->getBossPoints())
+		.bind(player->getForgeDusts())
+		.bind(player->getForgeDustLevel())
+		.bind(player->isRandomMounted())
+		.bind(player->capacity / 100)
+		.bind(player->sex);
 
 	if (player->lastLoginSaved != 0) {
-		query << "`lastlogin` = " << player->lastLoginSaved << ",";
+		update.bind(player->lastLoginSaved);
 	}
 
 	if (player->lastIP != 0) {
-		query << "`lastip` = " << player->lastIP << ",";
+		update.bind(player->lastIP);
 	}
 
 	// serialize conditions
@@ -237,10 +262,9 @@ bool IOLoginDataSave::savePlayerFirst(std::shared_ptr<Player> player) {
 
 	size_t attributesSize;
 	const char* attributes = propWriteStream.getStream(attributesSize);
+	update.bindBlob(attributes, attributesSize);
 
-	query << "`conditions` = " << db.escapeBlob(attributes, static_cast<uint32_t>(attributesSize)) << ",";
-
-	if (g_game().getWorldType() != WORLD_TYPE_PVP_ENFORCED) {
+	if (saveSkull) {
 		int64_t skullTime = 0;
 
 		if (player->skullTicks > 0) {
@@ -248,69 +272,47 @@ bool IOLoginDataSave::savePlayerFirst(std::shared_ptr<Player> player) {
 			skullTime = now + player->skullTicks;
 		}
 
-		query << "`skulltime` = " << skullTime << ",";
-
 		Skulls_t skull = SKULL_NONE;
 		if (player->skull == SKULL_RED) {
 			skull = SKULL_RED;
 		} else if (player->skull == SKULL_BLACK) {
 			skull = SKULL_BLACK;
 		}
-		query << "`skull` = " << static_cast<int64_t>(skull) << ",";
-	}
-
-	query << "`lastlogout` = " << player->getLastLogout() << ",";
-	query << "`balance` = " << player->bankBalance << ",";
-	query << "`offlinetraining_time` = " << player->getOfflineTrainingTime() / 1000 << ",";
-	query << "`offlinetraining_skill` = " << std::to_string(player->getOfflineTrainingSkill()) << ",";
-	query << "`stamina` = " << player->getStaminaMinutes() << ",";
-	query << "`skill_fist` = " << player->skills[SKILL_FIST].level << ",";
-	query << "`skill_fist_tries` = " << player->skills[SKILL_FIST].tries << ",";
-	query << "`skill_club` = " << player->skills[SKILL_CLUB].level << ",";
-	query << "`skill_club_tries` = " << player->skills[SKILL_CLUB].tries << ",";
-	query << "`skill_sword` = " << player->skills[SKILL_SWORD].level << ",";
-	query << "`skill_sword_tries` = " << player->skills[SKILL_SWORD].tries << ",";
-	query << "`skill_axe` = " << player->skills[SKILL_AXE].level << ",";
-	query << "`skill_axe_tries` = " << player->skills[SKILL_AXE].tries << ",";
-	query << "`skill_dist` = " << player->skills[SKILL_DISTANCE].level << ",";
-	query << "`skill_dist_tries` = " << player->skills[SKILL_DISTANCE].tries << ",";
-	query << "`skill_shielding` = " << player->skills[SKILL_SHIELD].level << ",";
-	query << "`skill_shielding_tries` = " << player->skills[SKILL_SHIELD].tries << ",";
-	query << "`skill_fishing` = " << player->skills[SKILL_FISHING].level << ",";
-	query << "`skill_fishing_tries` = " << player->skills[SKILL_FISHING].tries << ",";
-	query << "`skill_critical_hit_chance` = " << player->skills[SKILL_CRITICAL_HIT_CHANCE].level << ",";
-	query << "`skill_critical_hit_chance_tries` = " << player->skills[SKILL_CRITICAL_HIT_CHANCE].tries << ",";
-	query << "`skill_critical_hit_damage` = " << player->skills[SKILL_CRITICAL_HIT_DAMAGE].level << ",";
-	query << "`skill_critical_hit_damage_tries` = " << player->skills[SKILL_CRITICAL_HIT_DAMAGE].tries << ",";
-	query << "`skill_life_leech_chance` = " << player->skills[SKILL_LIFE_LEECH_CHANCE].level << ",";
-	query << "`skill_life_leech_chance_tries` = " << player->skills[SKILL_LIFE_LEECH_CHANCE].tries << ",";
-	query << "`skill_life_leech_amount` = " << player->skills[SKILL_LIFE_LEECH_AMOUNT].level << ",";
-	query << "`skill_life_leech_amount_tries` = " << player->skills[SKILL_LIFE_LEECH_AMOUNT].tries << ",";
-	query << "`skill_mana_leech_chance` = " << player->skills[SKILL_MANA_LEECH_CHANCE].level << ",";
-	query << "`skill_mana_leech_chance_tries` = " << player->skills[SKILL_MANA_LEECH_CHANCE].tries << ",";
-	query << "`skill_mana_leech_amount` = " << player->skills[SKILL_MANA_LEECH_AMOUNT].level << ",";
-	query << "`skill_mana_leech_amount_tries` = " << player->skills[SKILL_MANA_LEECH_AMOUNT].tries << ",";
-	query << "`manashield` = " << player->getManaShield() << ",";
-	query << "`max_manashield` = " << player->getMaxManaShield() << ",";
-	query << "`xpboost_value` = " << player->getXpBoostPercent() << ",";
-	query << "`xpboost_stamina` = " << player->getXpBoostTime() << ",";
-	query << "`quickloot_fallback` = " << (player->quickLootFallbackToMainContainer ? 1 : 0) << ",";
+		update.bind(skullTime).bind(static_cast<int64_t>(skull));
+	}
+
+	update.bind(player->getLastLogout())
+		.bind(player->bankBalance)
+		.bind(player->getOfflineTrainingTime() / 1000)
+		.bind(player->getOfflineTrainingSkill())
+		.bind(player->getStaminaMinutes());
+
+	for (const auto skill : { SKILL_FIST, SKILL_CLUB, SKILL_SWORD, SKILL_AXE, SKILL_DISTANCE, SKILL_SHIELD, SKILL_FISHING, SKILL_CRITICAL_HIT_CHANCE, SKILL_CRITICAL_HIT_DAMAGE, SKILL_LIFE_LEECH_CHANCE, SKILL_LIFE_LEECH_AMOUNT, SKILL_MANA_LEECH_CHANCE, SKILL_MANA_LEECH_AMOUNT }) {
+		update.bind(player->skills[skill].level).bind(player->skills[skill].tries);
+	}
+
+	update.bind(player->getManaShield())
+		.bind(player->getMaxManaShield())
+		.bind(player->getXpBoostPercent())
+		.bind(player->getXpBoostTime())
+		.bind(player->quickLootFallbackToMainContainer);
 
 	if (!player->isOffline()) {
 		auto now = std::chrono::system_clock::now();
 		auto lastLoginSaved = std::chrono::system_clock::from_time_t(player->lastLoginSaved);
-		query << "`onlinetime` = `onlinetime` + " << std::chrono::duration_cast<std::chrono::seconds>(now - lastLoginSaved).count() << ",";
+		update.bind(std::chrono::duration_cast<std::chrono::seconds>(now - lastLoginSaved).count());
 	}
 
 	for (int i = 1; i <= 8; i++) {
-		query << "`blessings" << i << "`"
-			  << " = " << static_cast<uint32_t>(player->getBlessingCount(static_cast<uint8_t>(i))) << ((i == 8) ? " " : ",");
+		update.bind(player->getBlessingCount(static_cast<uint8_t>(i)));
 	}
-	query << " WHERE `id` = " << player->getGUID();
+	update.bind(player->getGUID());
 
-	if (!db.executeQuery(query.str())) {
+	if (!db.executeQuery(update)) {
 		return false;
 	}
+
+	g_highscoreIndex().update(*player);
 	return true;
 }
 
@@ -320,16 +322,9 @@ bool IOLoginDataSave::savePlayerStash(std::shared_ptr<Player> player) {
 		return false;
 	}
 
-	Database &db = Database::getInstance();
 	std::ostringstream query;
-	query << "DELETE FROM `player_stash` WHERE `player_id` = " << player->getGUID();
-	if (!db.executeQuery(query.str())) {
-		return false;
-	}
-
-	query.str("");
-
 	DBInsert stashQuery("INSERT INTO `player_stash` (`player_id`,`item_id`,`item_count`) VALUES ");
+	stashQuery.replace("player_stash", "player_id", player->getGUID(), &player->savedRowsHash["player_stash"]);
 	for (const auto &[itemId, itemCount] : player->getStashItems()) {
 		query << player->getGUID() << ',' << itemId << ',' << itemCount;
 		if (!stashQuery.addRow(query)) {
@@ -351,14 +346,8 @@ bool IOLoginDataSave::savePlayerSpells(std::shared_ptr<Player> player) {
 
 	Database &db = Database::getInstance();
 	std::ostringstream query;
-	query << "DELETE FROM `player_spells` WHERE `player_id` = " << player->getGUID();
-	if (!db.executeQuery(query.str())) {
-		return false;
-	}
-
-	query.str("");
-
 	DBInsert spellsQuery("INSERT INTO `player_spells` (`player_id`, `name` ) VALUES ");
+	spellsQuery.replace("player_spells", "player_id", player->getGUID());
 	for (const std::string &spellName : player->learnedInstantSpellList) {
 		query << player->getGUID() << ',' << db.escapeString(spellName);
 		if (!spellsQuery.addRow(query)) {
@@ -378,16 +367,9 @@ bool IOLoginDataSave::savePlayerKills(std::shared_ptr<Player> player) {
 		return false;
 	}
 
-	Database &db = Database::getInstance();
 	std::ostringstream query;
-	query << "DELETE FROM `player_kills` WHERE `player_id` = " << player->getGUID();
-	if (!db.executeQuery(query.str())) {
-		return false;
-	}
-
-	query.str("");
-
 	DBInsert killsQuery("INSERT INTO `player_kills` (`player_id`, `target`, `time`, `unavenged`) VALUES");
+	killsQuery.replace("player_kills", "player_id", player->getGUID());
 	for (const auto &kill : player->unjustifiedKills) {
 		query << player->getGUID() << ',' << kill.target << ',' << kill.time << ',' << kill.unavenged;
 		if (!killsQuery.addRow(query)) {
@@ -457,16 +439,9 @@ bool IOLoginDataSave::savePlayerItem(std::shared_ptr<Player> player) {
 		return false;
 	}
 
-	Database &db = Database::getInstance();
 	PropWriteStream propWriteStream;
-	std::ostringstream query;
-	query << "DELETE FROM `player_items` WHERE `player_id` = " << player->getGUID();
-	if (!db.executeQuery(query.str())) {
-		g_logger().warn("[IOLoginData::savePlayer] - Error delete query 'player_items' from player: {}", player->getName());
-		return false;
-	}
-
 	DBInsert itemsQuery("INSERT INTO `player_items` (`player_id`, `pid`, `sid`, `itemtype`, `count`, `attributes`) VALUES ");
+	itemsQuery.replace("player_items", "player_id", player->getGUID(), &player->savedRowsHash["player_items"]);
 
 	ItemBlockList itemList;
 	for (int32_t slotId = CONST_SLOT_FIRST; slotId <= CONST_SLOT_LAST; ++slotId) {
@@ -489,20 +464,12 @@ bool IOLoginDataSave::savePlayerDepotItems(std::shared_ptr<Player> player) {
 		return false;
 	}
 
-	Database &db = Database::getInstance();
 	PropWriteStream propWriteStream;
 	ItemDepotList depotList;
-	if (player->lastDepotId != -1) {
-		std::ostringstream query;
-		query << "DELETE FROM `player_depotitems` WHERE `player_id` = " << player->getGUID();
-
-		if (!db.executeQuery(query.str())) {
-			return false;
-		}
-
-		query.str("");
-
+	// Depot never opened with lazyDepotLoading, the stored rows are still current
+	if (player->lastDepotId != -1 && !player->hasPendingDepotItems()) {
 		DBInsert depotQuery("INSERT INTO `player_depotitems` (`player_id`, `pid`, `sid`, `itemtype`, `count`, `attributes`) VALUES ");
+		depotQuery.replace("player_depotitems", "player_id", player->getGUID(), &player->savedRowsHash["player_depotitems"]);
 
 		for (const auto &[pid, depotChest] : player->depotChests) {
 			for (std::shared_ptr<Item> item : depotChest->getItemList()) {
@@ -524,30 +491,27 @@ bool IOLoginDataSave::saveRewardItems(std::shared_ptr<Player> player) {
 		return false;
 	}
 
-	std::ostringstream query;
-	query << "DELETE FROM `player_rewards` WHERE `player_id` = " << player->getGUID();
-
-	if (!Database::getInstance().executeQuery(query.str())) {
-		return false;
-	}
+	DBInsert rewardQuery("INSERT INTO `player_rewards` (`player_id`, `pid`, `sid`, `itemtype`, `count`, `attributes`) VALUES ");
+	rewardQuery.replace("player_rewards", "player_id", player->getGUID(), &player->savedRowsHash["player_rewards"]);
 
 	std::vector<uint64_t> rewardList;
 	player->getRewardList(rewardList);
+	if (rewardList.empty()) {
+		// Still removes the stored rewards
+		return rewardQuery.execute();
+	}
 
 	ItemRewardList rewardListItems;
-	if (!rewardList.empty()) {
-		for (const auto &rewardId : rewardList) {
-			auto reward = player->getReward(rewardId, false);
-			if (!reward->empty() && (getTimeMsNow() - rewardId <= 1000 * 60 * 60 * 24 * 7)) {
-				rewardListItems.emplace_back(0, reward);
-			}
+	for (const auto &rewardId : rewardList) {
+		auto reward = player->getReward(rewardId, false);
+		if (!reward->empty() && (getTimeMsNow() - rewardId <= 1000 * 60 * 60 * 24 * 7)) {
+			rewardListItems.emplace_back(0, reward);
 		}
+	}
 
-		DBInsert rewardQuery("INSERT INTO `player_rewards` (`player_id`, `pid`, `sid`, `itemtype`, `count`, `attributes`) VALUES ");
-		PropWriteStream propWriteStream;
-		if (!saveItems(player, rewardListItems, rewardQuery, propWriteStream)) {
-			return false;
-		}
+	PropWriteStream propWriteStream;
+	if (!saveItems(player, rewardListItems, rewardQuery, propWriteStream)) {
+		return false;
 	}
 	return true;
 }
@@ -558,26 +522,78 @@ bool IOLoginDataSave::savePlayerInbox(std::shared_ptr<Player> player) {
 		return false;
 	}
 
-	Database &db = Database::getInstance();
 	PropWriteStream propWriteStream;
 	ItemInboxList inboxList;
-	std::ostringstream query;
-	query << "DELETE FROM `player_inboxitems` WHERE `player_id` = " << player->getGUID();
-	if (!db.executeQuery(query.str())) {
+	DBInsert inboxQuery("INSERT INTO `player_inboxitems` (`player_id`, `pid`, `sid`, `itemtype`, `count`, `attributes`) VALUES ");
+	inboxQuery.replace("player_inboxitems", "player_id", player->getGUID(), &player->savedRowsHash["player_inboxitems"]);
+
+	for (const auto &item : player->getInbox()->getItemList()) {
+		inboxList.emplace_back(0, item);
+	}
+
+	if (!saveItems(player, inboxList, inboxQuery, propWriteStream)) {
 		return false;
 	}
+	return true;
+}
+
+void IOLoginDataSave::journalPlayer(std::shared_ptr<Player> player) {
+	if (!player || !g_persistenceJournal().isOpen()) {
+		return;
+	}
+
+	// Same rows as savePlayerFirst (only the balance), savePlayerItem, savePlayerDepotItems and savePlayerInbox, kept as queries instead of being written
+	// Nothing is recorded if one of them fails, a record with only some could replay a move between them by half
+	std::vector<std::string> queries;
+	queries.emplace_back(fmt::format("UPDATE `players` SET `balance` = {} WHERE `id` = {}", player->bankBalance, player->getGUID()));
+
+	PropWriteStream propWriteStream;
+	DBInsert itemsQuery("INSERT INTO `player_items` (`player_id`, `pid`, `sid`, `itemtype`, `count`, `attributes`) VALUES ");
+	itemsQuery.replace("player_items", "player_id", player->getGUID());
+	itemsQuery.capture(queries);
+
+	ItemBlockList itemList;
+	for (int32_t slotId = CONST_SLOT_FIRST; slotId <= CONST_SLOT_LAST; ++slotId) {
+		if (const auto &item = player->inventory[slotId]) {
+			itemList.emplace_back(slotId, item);
+		}
+	}
+
+	if (!saveItems(player, itemList, itemsQuery, propWriteStream)) {
+		return;
+	}
+
+	if (player->lastDepotId != -1 && !player->hasPendingDepotItems()) {
+		DBInsert depotQuery("INSERT INTO `player_depotitems` (`player_id`, `pid`, `sid`, `itemtype`, `count`, `attributes`) VALUES ");
+		depotQuery.replace("player_depotitems", "player_id", player->getGUID());
+		depotQuery.capture(queries);
+
+		ItemDepotList depotList;
+		for (const auto &[pid, depotChest] : player->depotChests) {
+			for (std::shared_ptr<Item> item : depotChest->getItemList()) {
+				depotList.emplace_back(pid, item);
+			}
+		}
+
+		if (!saveItems(player, depotList, depotQuery, propWriteStream)) {
+			return;
+		}
+	}
 
-	query.str("");
 	DBInsert inboxQuery("INSERT INTO `player_inboxitems` (`player_id`, `pid`, `sid`, `itemtype`, `count`, `attributes`) VALUES ");
+	inboxQuery.replace("player_inboxitems", "player_id", player->getGUID());
+	inboxQuery.capture(queries);
 
+	ItemInboxList inboxList;
 	for (const auto &item : player->getInbox()->getItemList()) {
 		inboxList.emplace_back(0, item);
 	}
 
 	if (!saveItems(player, inboxList, inboxQuery, propWriteStream)) {
-		return false;
+		return;
 	}
-	return true;
+
+	g_persistenceJournal().record(player->getGUID(), std::move(queries));
 }
 
 bool IOLoginDataSave::savePlayerPreyClass(std::shared_ptr<Player> player) {
@@ -693,13 +709,8 @@ bool IOLoginDataSave::savePlayerForgeHistory(std::shared_ptr<Player> player) {
 	}
 
 	std::ostringstream query;
-	query << "DELETE FROM `forge_history` WHERE `player_id` = " << player->getGUID();
-	if (!Database::getInstance().executeQuery(query.str())) {
-		return false;
-	}
-
-	query.str("");
 	DBInsert insertQuery("INSERT INTO `forge_history` (`player_id`, `action_type`, `description`, `done_at`, `is_success`) VALUES");
+	insertQuery.replace("forge_history", "player_id", player->getGUID());
 	for (const auto &history : player->getForgeHistory()) {
 		const auto stringDescription = Database::getInstance().escapeString(history.description);
 		auto actionString = magic_enum::enum_integer(history.actionType);
@@ -727,13 +738,8 @@ bool IOLoginDataSave::savePlayerBosstiary(std::shared_ptr<Player> player) {
 	}
 
 	std::ostringstream query;
-	query << "DELETE FROM `player_bosstiary` WHERE `player_id` = " << player->getGUID();
-	if (!Database::getInstance().executeQuery(query.str())) {
-		return false;
-	}
-
-	query.str("");
 	DBInsert insertQuery("INSERT INTO `player_bosstiary` (`player_id`, `bossIdSlotOne`, `bossIdSlotTwo`, `removeTimes`, `tracker`) VALUES");
+	insertQuery.replace("player_bosstiary", "player_id", player->getGUID());
 
 	// Bosstiary tracker
 	PropWriteStream stream;
@@ -770,16 +776,9 @@ bool IOLoginDataSave::savePlayerStorage(std::shared_ptr<Player> player) {
 		return false;
 	}
 
-	Database &db = Database::getInstance();
 	std::ostringstream query;
-	query << "DELETE FROM `player_storage` WHERE `player_id` = " << player->getGUID();
-	if (!db.executeQuery(query.str())) {
-		return false;
-	}
-
-	query.str("");
-
 	DBInsert storageQuery("INSERT INTO `player_storage` (`player_id`, `key`, `value`) VALUES ");
+	storageQuery.replace("player_storage", "player_id", player->getGUID());
 	player->genReservedStorageRange();
 
 	for (const auto &[key, value] : player->storageMap) {
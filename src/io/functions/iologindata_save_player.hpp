@@ -28,6 +28,9 @@ public:
 	static bool savePlayerBosstiary(std::shared_ptr<Player> player);
 	static bool savePlayerStorage(std::shared_ptr<Player> player);
 
+	// Records the balance, inventory, depot and inbox rows of the player in the persistence journal, as one record
+	static void journalPlayer(std::shared_ptr<Player> player);
+
 protected:
 	using ItemBlockList = std::list<std::pair<int32_t, std::shared_ptr<Item>>>;
 	using ItemDepotList = std::list<std::pair<int32_t, std::shared_ptr<Item>>>;
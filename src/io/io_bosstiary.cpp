@@ -154,19 +154,16 @@ uint16_t IOBosstiary::getBoostedBossId() const {
 }
 
 std::shared_ptr<MonsterType> IOBosstiary::getMonsterTypeByBossRaceId(uint16_t raceId) const {
-	for ([[maybe_unused]] const auto &[bossRaceId, bossName] : getBosstiaryMap()) {
-		if (bossRaceId == raceId) {
-			const auto monsterType = g_monsters().getMonsterType(bossName);
-			if (!monsterType) {
-				g_logger().error("[{}] Boss with id {} not found in boss map", __FUNCTION__, raceId);
-				continue;
-			}
-
-			return monsterType;
-		}
+	const auto it = bosstiaryMap.find(raceId);
+	if (it == bosstiaryMap.end()) {
+		return nullptr;
 	}
 
-	return nullptr;
+	const auto monsterType = g_monsters().getMonsterType(it->second);
+	if (!monsterType) {
+		g_logger().error("[{}] Boss with id {} not found in boss map", __FUNCTION__, raceId);
+	}
+	return monsterType;
 }
 
 void IOBosstiary::addBosstiaryKill(std::shared_ptr<Player> player, const std::shared_ptr<MonsterType> mtype, uint32_t amount /*= 1*/) const {
@@ -179,18 +176,21 @@ void IOBosstiary::addBosstiaryKill(std::shared_ptr<Player> player, const std::sh
 		return;
 	}
 
-	auto oldBossLevel = getBossCurrentLevel(player, bossId);
+	// The levels come from the kill stages of the race of the killed type, no boss lookup by id
+	auto bossRace = mtype->info.bosstiaryRace;
+	const std::vector<LevelInfo> &infoForCurrentRace = getBossRaceKillStages(bossRace);
+	uint32_t oldKills = player->getBestiaryKillCount(bossId);
+	auto oldBossLevel = getBossLevel(infoForCurrentRace, oldKills);
 	player->addBestiaryKillCount(bossId, amount);
-	player->refreshCyclopediaMonsterTracker(true);
-	auto newBossLevel = getBossCurrentLevel(player, bossId);
-	if (oldBossLevel == newBossLevel) {
+	if (player->getCyclopediaMonsterTrackerSet(true).contains(mtype)) {
+		player->refreshCyclopediaMonsterTracker(true);
+	}
+	auto newBossLevel = getBossLevel(infoForCurrentRace, oldKills + amount);
+	if (oldBossLevel == newBossLevel || !bosstiaryMap.contains(bossId)) {
 		return;
 	}
 	player->sendBosstiaryEntryChanged(bossId);
 
-	auto bossRace = mtype->info.bosstiaryRace;
-	const std::vector<LevelInfo> &infoForCurrentRace = levelInfos.at(bossRace);
-
 	auto pointsForCurrentLevel = infoForCurrentRace[newBossLevel - 1].points;
 	player->addBossPoints(pointsForCurrentLevel);
 
@@ -281,20 +281,13 @@ uint8_t IOBosstiary::getBossCurrentLevel(std::shared_ptr<Player> player, uint16_
 
 	uint32_t currentKills = player->getBestiaryKillCount(bossId);
 	auto bossRace = mType->info.bosstiaryRace;
-	uint8_t level = 0;
 	if (auto it = levelInfos.find(bossRace);
 	    it != levelInfos.end()) {
-		const std::vector<LevelInfo> &infoForCurrentRace = it->second;
-		for (const auto &raceInfo : infoForCurrentRace) {
-			if (currentKills >= raceInfo.kills) {
-				++level;
-			}
-		}
-	} else {
-		g_logger().warn("[{}] boss with id {} and name {} not found in bossRace", __FUNCTION__, bossId, mType->name);
+		return getBossLevel(it->second, currentKills);
 	}
 
-	return level;
+	g_logger().warn("[{}] boss with id {} and name {} not found in bossRace", __FUNCTION__, bossId, mType->name);
+	return 0;
 }
 
 uint32_t IOBosstiary::calculteRemoveBoss(uint8_t removeTimes) const {
@@ -304,6 +297,16 @@ uint32_t IOBosstiary::calculteRemoveBoss(uint8_t removeTimes) const {
 	return 300000 * removeTimes - 500000;
 }
 
+uint8_t IOBosstiary::getBossLevel(const std::vector<LevelInfo> &stages, uint32_t kills) {
+	uint8_t level = 0;
+	for (const auto &raceInfo : stages) {
+		if (kills >= raceInfo.kills) {
+			++level;
+		}
+	}
+	return level;
+}
+
 const std::vector<LevelInfo> &IOBosstiary::getBossRaceKillStages(BosstiaryRarity_t race) const {
 	auto it = levelInfos.find(race);
 	if (it != levelInfos.end()) {
@@ -65,6 +65,8 @@ public:
 	uint32_t calculateBossPoints(uint16_t lootBonus) const;
 	std::vector<uint16_t> getBosstiaryFinished(const std::shared_ptr<Player> &player, uint8_t level = 1) const;
 	uint8_t getBossCurrentLevel(std::shared_ptr<Player> player, uint16_t bossId) const;
+	// The level reached with the kills, from the kill stages of a race
+	static uint8_t getBossLevel(const std::vector<LevelInfo> &stages, uint32_t kills);
 	uint32_t calculteRemoveBoss(uint8_t removeTimes) const;
 	const std::vector<LevelInfo> &getBossRaceKillStages(BosstiaryRarity_t race) const;
 
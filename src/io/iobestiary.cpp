@@ -220,7 +220,6 @@ void IOBestiary::addBestiaryKill(std::shared_ptr<Player> player, const std::shar
 		return;
 	}
 	uint32_t curCount = player->getBestiaryKillCount(raceid);
-	std::ostringstream ss;
 
 	player->addBestiaryKillCount(raceid, amount);
 
@@ -228,8 +227,7 @@ void IOBestiary::addBestiaryKill(std::shared_ptr<Player> player, const std::shar
 	    (curCount < mtype->info.bestiaryFirstUnlock && (curCount + amount) >= mtype->info.bestiaryFirstUnlock) || // First kill stage reached
 	    (curCount < mtype->info.bestiarySecondUnlock && (curCount + amount) >= mtype->info.bestiarySecondUnlock) || // Second kill stage reached
 	    (curCount < mtype->info.bestiaryToUnlock && (curCount + amount) >= mtype->info.bestiaryToUnlock)) { // Final kill stage reached
-		ss << "You unlocked details for the creature '" << mtype->name << "'";
-		player->sendTextMessage(MESSAGE_STATUS, ss.str());
+		player->sendTextMessage(MESSAGE_STATUS, fmt::format("You unlocked details for the creature '{}'", mtype->name));
 		player->sendBestiaryEntryChanged(raceid);
 
 		if ((curCount + amount) >= mtype->info.bestiaryToUnlock) {
@@ -237,8 +235,10 @@ void IOBestiary::addBestiaryKill(std::shared_ptr<Player> player, const std::shar
 		}
 	}
 
-	// Reload bestiary tracker
-	player->refreshCyclopediaMonsterTracker();
+	// Reload bestiary tracker, only its own races show the kill
+	if (player->getCyclopediaMonsterTrackerSet(false).contains(mtype)) {
+		player->refreshCyclopediaMonsterTracker();
+	}
 }
 
 charmRune_t IOBestiary::getCharmFromTarget(std::shared_ptr<Player> player, const std::shared_ptr<MonsterType> mtype) {
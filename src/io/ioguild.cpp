@@ -20,6 +20,7 @@ std::shared_ptr<Guild> IOGuild::loadGuild(uint32_t guildId) {
 	if (DBResult_ptr result = db.storeQuery(query.str())) {
 		const auto guild = std::make_shared<Guild>(guildId, result->getString("name"));
 		guild->setBankBalance(result->getNumber<uint64_t>("balance"));
+		guild->setSavedBankBalance(guild->getBankBalance());
 		query.str(std::string());
 		query << "SELECT `id`, `name`, `level` FROM `guild_ranks` WHERE `guild_id` = " << guildId;
 
@@ -37,12 +38,20 @@ void IOGuild::saveGuild(const std::shared_ptr<Guild> guild) {
 	if (!guild) {
 		return;
 	}
+	// Only the balance is saved, a guild whose balance did not change since the last save is skipped
+	const auto balance = guild->getBankBalance();
+	if (balance == guild->getSavedBankBalance()) {
+		return;
+	}
+
 	Database &db = Database::getInstance();
 	std::ostringstream updateQuery;
 	updateQuery << "UPDATE `guilds` SET ";
-	updateQuery << "`balance` = " << guild->getBankBalance();
+	updateQuery << "`balance` = " << balance;
 	updateQuery << " WHERE `id` = " << guild->getId();
-	db.executeQuery(updateQuery.str());
+	if (db.executeQuery(updateQuery.str())) {
+		guild->setSavedBankBalance(balance);
+	}
 }
 
 uint32_t IOGuild::getGuildIdByName(const std::string &name) {
@@ -15,6 +15,7 @@
 #include "game/game.hpp"
 #include "creatures/monsters/monster.hpp"
 #include "creatures/players/wheel/player_wheel.hpp"
+#include "kv/kv.hpp"
 #include "lib/metrics/metrics.hpp"
 #include "enums/account_type.hpp"
 #include "enums/account_errors.hpp"
@@ -115,6 +116,13 @@ bool IOLoginData::loadPlayer(std::shared_ptr<Player> player, DBResult_ptr result
 		// First
 		IOLoginDataLoad::loadPlayerFirst(player, result);
 
+		// The sections below answer their queries from this one round trip
+		DBPrefetch prefetch;
+		if (g_configManager().getBoolean(LOGIN_PREFETCH_SECTIONS, __FUNCTION__)) {
+			prefetch.fetch(IOLoginDataLoad::getSectionQueries(player, disableIrrelevantInfo));
+		}
+		DBPrefetch::Scope prefetchScope(prefetch);
+
 		// Experience load
 		IOLoginDataLoad::loadPlayerExperience(player, result);
 
@@ -136,9 +144,6 @@ bool IOLoginData::loadPlayer(std::shared_ptr<Player> player, DBResult_ptr result
 		// kills load
 		IOLoginDataLoad::loadPlayerKills(player, result);
 
-		// guild load
-		IOLoginDataLoad::loadPlayerGuild(player, result);
-
 		// stash load items
 		IOLoginDataLoad::loadPlayerStashItems(player, result);
 
@@ -175,15 +180,44 @@ bool IOLoginData::loadPlayer(std::shared_ptr<Player> player, DBResult_ptr result
 		// Load instant spells list
 		IOLoginDataLoad::loadPlayerInstantSpellList(player, result);
 
-		if (disableIrrelevantInfo) {
-			return true;
+		if (!disableIrrelevantInfo) {
+			// load forge history
+			IOLoginDataLoad::loadPlayerForgeHistory(player, result);
+
+			// load bosstiary
+			IOLoginDataLoad::loadPlayerBosstiary(player, result);
+		}
+	} catch (const std::system_error &error) {
+		g_logger().warn("[{}] Error while load player: {}", __FUNCTION__, error.what());
+		return false;
+	} catch (const std::exception &e) {
+		g_logger().warn("[{}] Error while load player: {}", __FUNCTION__, e.what());
+		return false;
+	}
+
+	// The rest touches the game state, it is left to finishLoadPlayer when loading off the dispatcher
+	if (player->loadingAsync) {
+		// The KV entries of the player come in one query here, instead of one per key on the dispatcher
+		g_kv().prefetch(fmt::format("player.{}", player->getGUID()));
+		return true;
+	}
+	return finishLoadPlayer(player, disableIrrelevantInfo);
+}
+
+bool IOLoginData::finishLoadPlayer(std::shared_ptr<Player> player, bool disableIrrelevantInfo /* = false*/) {
+	try {
+		player->loadingAsync = false;
+		for (const auto &item : player->loadingDecayItems) {
+			item->startDecaying();
 		}
+		player->loadingDecayItems.clear();
 
-		// load forge history
-		IOLoginDataLoad::loadPlayerForgeHistory(player, result);
+		// guild load
+		IOLoginDataLoad::loadPlayerGuild(player);
 
-		// load bosstiary
-		IOLoginDataLoad::loadPlayerBosstiary(player, result);
+		if (disableIrrelevantInfo) {
+			return true;
+		}
 
 		IOLoginDataLoad::loadPlayerInitializeSystem(player);
 		IOLoginDataLoad::loadPlayerUpdateSystem(player);
@@ -199,22 +233,57 @@ bool IOLoginData::loadPlayer(std::shared_ptr<Player> player, DBResult_ptr result
 }
 
 bool IOLoginData::savePlayer(std::shared_ptr<Player> player) {
+	// The rows of a pending server save are dropped before the players row is locked, its flush may be waiting for it
+	if (player && !DBBatch::current()) {
+		DBBatch::claim(player->getGUID());
+	}
+
 	bool success = DBTransaction::executeWithinTransaction([player]() {
 		return savePlayerGuard(player);
 	});
 
 	if (!success) {
 		g_logger().error("[{}] Error occurred saving player", __FUNCTION__);
+		// The rows were rolled back, the next save writes all of them again
+		if (player) {
+			player->savedRowsHash.clear();
+		}
 	}
 
 	return success;
 }
 
+bool IOLoginData::capturePlayer(std::shared_ptr<Player> player, DBCapture &capture) {
+	DBCapture::Scope scope(capture);
+	try {
+		return savePlayerGuard(player);
+	} catch (const std::exception &exception) {
+		g_logger().error("[{}] Error occurred capturing player, error: {}", __FUNCTION__, exception.what());
+		// Some rows may already count as saved, the next save writes all of them again
+		if (player) {
+			player->savedRowsHash.clear();
+		}
+		return false;
+	}
+}
+
+bool IOLoginData::writePlayer(const DBCapture &capture) {
+	return DBTransaction::executeWithinTransaction([&capture]() {
+		if (!capture.execute()) {
+			throw DatabaseException("[IOLoginData::writePlayer] - Failed to write the captured player rows");
+		}
+		return true;
+	});
+}
+
 bool IOLoginData::savePlayerGuard(std::shared_ptr<Player> player) {
 	if (!player) {
 		throw DatabaseException("Player nullptr in function: " + std::string(__FUNCTION__));
 	}
 
+	// An offline copy loaded before this save would be outdated
+	g_game().removeOfflinePlayer(player->getGUID(), player);
+
 	if (!IOLoginDataSave::savePlayerFirst(player)) {
 		throw DatabaseException("[" + std::string(__FUNCTION__) + "] - Failed to save player first: " + player->getName());
 	}
@@ -300,6 +369,29 @@ uint32_t IOLoginData::getGuidByName(const std::string &name) {
 	return result->getNumber<uint32_t>("id");
 }
 
+std::vector<uint32_t> IOLoginData::getGuidsByNames(const std::vector<std::string> &names) {
+	std::vector<uint32_t> guids;
+	if (names.empty()) {
+		return guids;
+	}
+
+	Database &db = Database::getInstance();
+	std::ostringstream query;
+	query << "SELECT `id` FROM `players` WHERE `name` IN (";
+	for (size_t i = 0; i < names.size(); ++i) {
+		query << (i == 0 ? "" : ",") << db.escapeString(names[i]);
+	}
+	query << ')';
+
+	if (const auto &result = db.storeQuery(query.str())) {
+		guids.reserve(result->countResults());
+		do {
+			guids.emplace_back(result->getNumber<uint32_t>("id"));
+		} while (result->next());
+	}
+	return guids;
+}
+
 bool IOLoginData::getGuidByNameEx(uint32_t &guid, bool &specialVip, std::string &name) {
 	Database &db = Database::getInstance();
 
@@ -339,6 +431,8 @@ void IOLoginData::increaseBankBalance(uint32_t guid, uint64_t bankBalance) {
 	std::ostringstream query;
 	query << "UPDATE `players` SET `balance` = `balance` + " << bankBalance << " WHERE `id` = " << guid;
 	Database::getInstance().executeQuery(query.str());
+	// The cached offline copy holds the old balance, a later save of it would undo the credit
+	g_game().removeOfflinePlayer(guid);
 }
 
 bool IOLoginData::hasBiddedOnHouse(uint32_t guid) {
@@ -23,8 +23,21 @@ public:
 	static bool loadPlayerById(std::shared_ptr<Player> player, uint32_t id, bool disableIrrelevantInfo = true);
 	static bool loadPlayerByName(std::shared_ptr<Player> player, const std::string &name, bool disableIrrelevantInfo = true);
 	static bool loadPlayer(std::shared_ptr<Player> player, DBResult_ptr result, bool disableIrrelevantInfo = false);
+	/**
+	 * Loads the guild, the systems and starts the item decay, the part of loadPlayer that touches the game state.
+	 * loadPlayer calls it, unless the player is flagged as loadingAsync, then it must be called from the dispatcher.
+	 */
+	static bool finishLoadPlayer(std::shared_ptr<Player> player, bool disableIrrelevantInfo = false);
 	static bool savePlayer(std::shared_ptr<Player> player);
+	/**
+	 * Runs the save of the player into capture instead of the database, the player is only read here.
+	 * The capture is written by writePlayer afterwards, on any thread and without the player.
+	 */
+	static bool capturePlayer(std::shared_ptr<Player> player, DBCapture &capture);
+	static bool writePlayer(const DBCapture &capture);
 	static uint32_t getGuidByName(const std::string &name);
+	// One query for all the names, the ones without a player are left out
+	static std::vector<uint32_t> getGuidsByNames(const std::vector<std::string> &names);
 	static bool getGuidByNameEx(uint32_t &guid, bool &specialVip, std::string &name);
 	static std::string getNameByGuid(uint32_t guid);
 	static bool formatPlayerName(std::string &name);
@@ -12,6 +12,7 @@
 #include "game/movement/teleport.hpp"
 #include "game/game.hpp"
 #include "io/filestream.hpp"
+#include "lib/thread/thread_pool.hpp"
 
 /*
     OTBM_ROOTV1
@@ -40,11 +41,22 @@
 void IOMap::loadMap(Map* map, const Position &pos) {
 	Benchmark bm_mapLoad;
 
-	const auto &fileByte = mio::mmap_source(map->path.string());
+	// Snapshots only hold maps loaded at their own coordinates
+	const bool useSnapshot = g_configManager().getBoolean(MAP_SNAPSHOT, __FUNCTION__) && pos == Position();
 
-	const auto begin = fileByte.begin() + sizeof(OTB::Identifier { { 'O', 'T', 'B', 'M' } });
+	auto source = mio::mmap_source(map->path.string());
+	const auto snapshotKey = useSnapshot ? getSnapshotKey(source) : 0;
+	if (useSnapshot && loadSnapshot(map, snapshotKey)) {
+		map->flush();
+		map->buildSectorGrid();
 
-	FileStream stream { begin, fileByte.end() };
+		g_logger().debug("Map Loaded {} ({}x{}) from snapshot in {} milliseconds", map->path.filename().string(), map->width, map->height, bm_mapLoad.duration());
+		return;
+	}
+
+	FileStream stream { std::move(source) };
+	stream.adviseSequential();
+	stream.skip(sizeof(OTB::Identifier { { 'O', 'T', 'B', 'M' } }));
 
 	if (!stream.startNode()) {
 		throw IOMapException("Could not read map node.");
@@ -66,16 +78,22 @@ void IOMap::loadMap(Map* map, const Position &pos) {
 		throw IOMapException("This map need to be upgraded by using the latest map editor version to be able to load correctly.");
 	}
 
+	std::vector<TileAreaShard> shards;
 	if (stream.startNode(OTBM_MAP_DATA)) {
 		parseMapDataAttributes(stream, map);
-		parseTileArea(stream, *map, pos);
+		shards = parseTileAreas(stream, *map, pos);
 		stream.endNode();
 	}
 
 	parseTowns(stream, *map);
 	parseWaypoints(stream, *map);
 
+	if (useSnapshot) {
+		saveSnapshot(map, snapshotKey, shards);
+	}
+
 	map->flush();
+	map->buildSectorGrid();
 
 	g_logger().debug("Map Loaded {} ({}x{}) in {} milliseconds", map->path.filename().string(), map->width, map->height, bm_mapLoad.duration());
 }
@@ -116,133 +134,186 @@ void IOMap::parseMapDataAttributes(FileStream &stream, Map* map) {
 	}
 }
 
-void IOMap::parseTileArea(FileStream &stream, Map &map, const Position &pos) {
-	while (stream.startNode(OTBM_TILE_AREA)) {
-		const uint16_t base_x = stream.getU16();
-		const uint16_t base_y = stream.getU16();
-		const uint8_t base_z = stream.getU8();
+std::vector<IOMap::TileAreaShard> IOMap::parseTileAreas(FileStream &stream, Map &map, const Position &pos) {
+	// Only the node boundaries are scanned here, the areas themselves are parsed in parallel
+	std::vector<std::pair<uint32_t, uint32_t>> areas;
+	while (true) {
+		const uint32_t begin = stream.tell();
+		if (!stream.startNode(OTBM_TILE_AREA)) {
+			break;
+		}
 
-		while (stream.startNode()) {
-			const uint8_t tileType = stream.getU8();
-			if (tileType != OTBM_HOUSETILE && tileType != OTBM_TILE) {
-				throw IOMapException("Could not read tile type node.");
+		if (!stream.skipNode()) {
+			throw IOMapException("Could not end node.");
+		}
+		areas.emplace_back(begin, stream.tell());
+	}
+
+	std::vector<TileAreaShard> shards(areas.size());
+	inject<ThreadPool>()
+		.submit_loop(
+			static_cast<size_t>(0), areas.size(),
+			[&](const size_t i) {
+				try {
+					FileStream areaStream(stream, areas[i].first, areas[i].second);
+					parseTileArea(areaStream, map, pos, shards[i]);
+				} catch (...) {
+					shards[i].error = std::current_exception();
+				}
 			}
+		)
+		.wait();
 
-			const auto tile = std::make_shared<BasicTile>();
+	// Merged in file order, so the result is the same as a serial load
+	for (auto &shard : shards) {
+		if (shard.error) {
+			std::rethrow_exception(shard.error);
+		}
+		mergeTileArea(map, shard);
+	}
 
-			const uint8_t tileCoordsX = stream.getU8();
-			const uint8_t tileCoordsY = stream.getU8();
+	return shards;
+}
 
-			const uint16_t x = base_x + tileCoordsX + pos.x;
-			const uint16_t y = base_y + tileCoordsY + pos.y;
-			const uint8_t z = static_cast<uint8_t>(base_z + pos.z);
+void IOMap::parseTileArea(FileStream &stream, Map &map, const Position &pos, TileAreaShard &shard) {
+	if (!stream.startNode(OTBM_TILE_AREA)) {
+		throw IOMapException("Could not read tile area node.");
+	}
 
-			if (tileType == OTBM_HOUSETILE) {
-				tile->houseId = stream.getU32();
-				if (!map.houses.addHouse(tile->houseId)) {
-					throw IOMapException(fmt::format("[x:{}, y:{}, z:{}] Could not create house id: {}", x, y, z, tile->houseId));
-				}
+	const uint16_t base_x = stream.getU16();
+	const uint16_t base_y = stream.getU16();
+	const uint8_t base_z = stream.getU8();
+
+	while (stream.startNode()) {
+		const uint8_t tileType = stream.getU8();
+		if (tileType != OTBM_HOUSETILE && tileType != OTBM_TILE) {
+			throw IOMapException("Could not read tile type node.");
+		}
+
+		const auto tile = std::make_shared<BasicTile>();
+
+		const uint8_t tileCoordsX = stream.getU8();
+		const uint8_t tileCoordsY = stream.getU8();
+
+		const uint16_t x = base_x + tileCoordsX + pos.x;
+		const uint16_t y = base_y + tileCoordsY + pos.y;
+		const uint8_t z = static_cast<uint8_t>(base_z + pos.z);
+
+		if (tileType == OTBM_HOUSETILE) {
+			tile->houseId = stream.getU32();
+		}
+
+		if (stream.isProp(OTBM_ATTR_TILE_FLAGS)) {
+			const uint32_t flags = stream.getU32();
+			if ((flags & OTBM_TILEFLAG_PROTECTIONZONE) != 0) {
+				tile->flags |= TILESTATE_PROTECTIONZONE;
+			} else if ((flags & OTBM_TILEFLAG_NOPVPZONE) != 0) {
+				tile->flags |= TILESTATE_NOPVPZONE;
+			} else if ((flags & OTBM_TILEFLAG_PVPZONE) != 0) {
+				tile->flags |= TILESTATE_PVPZONE;
 			}
 
-			if (stream.isProp(OTBM_ATTR_TILE_FLAGS)) {
-				const uint32_t flags = stream.getU32();
-				if ((flags & OTBM_TILEFLAG_PROTECTIONZONE) != 0) {
-					tile->flags |= TILESTATE_PROTECTIONZONE;
-				} else if ((flags & OTBM_TILEFLAG_NOPVPZONE) != 0) {
-					tile->flags |= TILESTATE_NOPVPZONE;
-				} else if ((flags & OTBM_TILEFLAG_PVPZONE) != 0) {
-					tile->flags |= TILESTATE_PVPZONE;
-				}
+			if ((flags & OTBM_TILEFLAG_NOLOGOUT) != 0) {
+				tile->flags |= TILESTATE_NOLOGOUT;
+			}
+		}
+
+		if (stream.isProp(OTBM_ATTR_ITEM)) {
+			const uint16_t id = stream.getU16();
+			const auto &iType = Item::items[id];
 
-				if ((flags & OTBM_TILEFLAG_NOLOGOUT) != 0) {
-					tile->flags |= TILESTATE_NOLOGOUT;
+			if (!tile->isHouse() || (!iType.isBed() && !iType.isTrashHolder())) {
+
+				BasicItem item;
+				item.id = id;
+
+				if (tile->isHouse() && iType.movable) {
+					g_logger().warn("[IOMap::loadMap] - "
+					                "Movable item with ID: {}, in house: {}, "
+					                "at position: x {}, y {}, z {}",
+					                id, tile->houseId, x, y, z);
+				} else if (iType.isGroundTile()) {
+					tile->ground = map.tryReplaceItemFromCache(std::move(item));
+				} else {
+					tile->items.emplace_back(map.tryReplaceItemFromCache(std::move(item)));
 				}
 			}
+		}
 
-			if (stream.isProp(OTBM_ATTR_ITEM)) {
-				const uint16_t id = stream.getU16();
-				const auto &iType = Item::items[id];
+		while (stream.startNode()) {
+			auto type = stream.getU8();
+			switch (type) {
+				case OTBM_ITEM: {
+					const uint16_t id = stream.getU16();
+
+					const auto &iType = Item::items[id];
 
-				if (!tile->isHouse() || (!iType.isBed() && !iType.isTrashHolder())) {
+					BasicItem item;
+					item.id = id;
 
-					const auto item = std::make_shared<BasicItem>();
-					item->id = id;
+					if (!item.unserializeItemNode(stream, x, y, z)) {
+						throw IOMapException(fmt::format("[x:{}, y:{}, z:{}] Failed to load item {}, Node Type.", x, y, z, id));
+					}
 
-					if (tile->isHouse() && iType.movable) {
+					if (tile->isHouse() && (iType.isBed() || iType.isTrashHolder())) {
+						// nothing
+					} else if (tile->isHouse() && iType.movable) {
 						g_logger().warn("[IOMap::loadMap] - "
 						                "Movable item with ID: {}, in house: {}, "
 						                "at position: x {}, y {}, z {}",
 						                id, tile->houseId, x, y, z);
 					} else if (iType.isGroundTile()) {
-						tile->ground = map.tryReplaceItemFromCache(item);
+						tile->ground = map.tryReplaceItemFromCache(std::move(item));
 					} else {
-						tile->items.emplace_back(map.tryReplaceItemFromCache(item));
+						tile->items.emplace_back(map.tryReplaceItemFromCache(std::move(item)));
 					}
-				}
-			}
-
-			while (stream.startNode()) {
-				auto type = stream.getU8();
-				switch (type) {
-					case OTBM_ITEM: {
-						const uint16_t id = stream.getU16();
-
-						const auto &iType = Item::items[id];
-
-						const auto item = std::make_shared<BasicItem>();
-						item->id = id;
-
-						if (!item->unserializeItemNode(stream, x, y, z)) {
-							throw IOMapException(fmt::format("[x:{}, y:{}, z:{}] Failed to load item {}, Node Type.", x, y, z, id));
-						}
-
-						if (tile->isHouse() && (iType.isBed() || iType.isTrashHolder())) {
-							// nothing
-						} else if (tile->isHouse() && iType.movable) {
-							g_logger().warn("[IOMap::loadMap] - "
-							                "Movable item with ID: {}, in house: {}, "
-							                "at position: x {}, y {}, z {}",
-							                id, tile->houseId, x, y, z);
-						} else if (iType.isGroundTile()) {
-							tile->ground = map.tryReplaceItemFromCache(item);
-						} else {
-							tile->items.emplace_back(map.tryReplaceItemFromCache(item));
-						}
-					} break;
-					case OTBM_TILE_ZONE: {
-						const auto zoneCount = stream.getU16();
-						for (uint16_t i = 0; i < zoneCount; ++i) {
-							const auto zoneId = stream.getU16();
-							if (!zoneId) {
-								throw IOMapException(fmt::format("[x:{}, y:{}, z:{}] Invalid zone id.", x, y, z));
-							}
-							auto zone = Zone::getZone(zoneId);
-							zone->addPosition(Position(x, y, z));
+				} break;
+				case OTBM_TILE_ZONE: {
+					const auto zoneCount = stream.getU16();
+					for (uint16_t i = 0; i < zoneCount; ++i) {
+						const auto zoneId = stream.getU16();
+						if (!zoneId) {
+							throw IOMapException(fmt::format("[x:{}, y:{}, z:{}] Invalid zone id.", x, y, z));
 						}
-					} break;
-					default:
-						throw IOMapException(fmt::format("[x:{}, y:{}, z:{}] Could not read item/zone node.", x, y, z));
-				}
-
-				if (!stream.endNode()) {
-					throw IOMapException(fmt::format("[x:{}, y:{}, z:{}] Could not end node.", x, y, z));
-				}
+						shard.zonePositions.emplace_back(zoneId, Position(x, y, z));
+					}
+				} break;
+				default:
+					throw IOMapException(fmt::format("[x:{}, y:{}, z:{}] Could not read item/zone node.", x, y, z));
 			}
 
 			if (!stream.endNode()) {
 				throw IOMapException(fmt::format("[x:{}, y:{}, z:{}] Could not end node.", x, y, z));
 			}
+		}
 
-			if (tile->isEmpty(true)) {
-				continue;
-			}
+		if (!stream.endNode()) {
+			throw IOMapException(fmt::format("[x:{}, y:{}, z:{}] Could not end node.", x, y, z));
+		}
 
-			map.setBasicTile(x, y, z, tile);
+		if (tile->isEmpty(true)) {
+			continue;
 		}
 
-		if (!stream.endNode()) {
-			throw IOMapException("Could not end node.");
+		shard.tiles.emplace_back(Position(x, y, z), tile);
+	}
+
+	if (!stream.endNode()) {
+		throw IOMapException("Could not end node.");
+	}
+}
+
+void IOMap::mergeTileArea(Map &map, TileAreaShard &shard) {
+	for (auto &[position, tile] : shard.tiles) {
+		if (tile->isHouse() && !map.houses.addHouse(tile->houseId)) {
+			throw IOMapException(fmt::format("[x:{}, y:{}, z:{}] Could not create house id: {}", position.x, position.y, position.z, tile->houseId));
 		}
+		// Keep the shared tile, duplicates are released right away
+		tile = map.setBasicTile(position.x, position.y, position.z, tile);
+	}
+
+	for (const auto &[zoneId, position] : shard.zonePositions) {
+		Zone::getZone(zoneId)->addPosition(position);
 	}
 }
 
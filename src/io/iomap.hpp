@@ -149,10 +149,39 @@ public:
 	}
 
 private:
+	/**
+	 * Tiles of one OTBM tile area, parsed on a worker thread.
+	 * They are only added to the map (together with their houses and zones) afterwards, in file order.
+	 */
+	struct TileAreaShard {
+		struct ParsedTile {
+			Position position;
+			std::shared_ptr<BasicTile> tile;
+		};
+
+		std::vector<ParsedTile> tiles;
+		std::vector<std::pair<uint16_t, Position>> zonePositions;
+		std::exception_ptr error;
+	};
+
 	static void parseMapDataAttributes(FileStream &stream, Map* map);
 	static void parseWaypoints(FileStream &stream, Map &map);
 	static void parseTowns(FileStream &stream, Map &map);
-	static void parseTileArea(FileStream &stream, Map &map, const Position &pos);
+	static std::vector<TileAreaShard> parseTileAreas(FileStream &stream, Map &map, const Position &pos);
+	static void parseTileArea(FileStream &stream, Map &map, const Position &pos, TileAreaShard &shard);
+	static void mergeTileArea(Map &map, TileAreaShard &shard);
+
+	// Binary map snapshots, see iomap_snapshot.cpp
+	static constexpr uint32_t SNAPSHOT_VERSION = 1;
+
+	/**
+	 * Identifies the map file contents and the item definitions the map was built with,
+	 * a snapshot is only used when its key matches.
+	 */
+	static uint64_t getSnapshotKey(const mio::mmap_source &source);
+	static std::filesystem::path getSnapshotPath(const Map* map);
+	static bool loadSnapshot(Map* map, uint64_t key);
+	static void saveSnapshot(const Map* map, uint64_t key, const std::vector<TileAreaShard> &shards);
 };
 
 class IOMapException : public std::exception {
@@ -0,0 +1,409 @@
+/**
+ * Canary - A free and open-source MMORPG server emulator
+ * Copyright (©) 2019-2024 OpenTibiaBR <opentibiabr@outlook.com>
+ * Repository: https://github.com/opentibiabr/canary
+ * License: https://github.com/opentibiabr/canary/blob/main/LICENSE
+ * Contributors: https://github.com/opentibiabr/canary/graphs/contributors
+ * Website: https://docs.opentibiabr.com/
+ */
+
+#include "pch.hpp"
+
+#include "io/iomap.hpp"
+#include "io/filestream.hpp"
+
+/*
+    Snapshot layout (native byte order, no OTB escaping):
+    |--- header: magic "CMSP", version (u32), key (u64)
+    |--- map: width (u16), height (u16), monster/npc/house/zone file (string)
+    |--- items: count (u32), for each: BasicItem fields, text (string), children count (u32) + item indexes (u32)
+    |--- tiles: count (u32), for each: flags (u32), houseId (u32), type (u8), isStatic (u8), ground (u32) + items count (u32) + item indexes (u32)
+    |--- placements: count (u32), for each: x (u16), y (u16), z (u8), tile index (u32)
+    |--- zones: count (u32), for each: zone id (u16), x (u16), y (u16), z (u8)
+    |--- towns: count (u32), for each: id (u32), name (string), temple x (u16), y (u16), z (u8)
+    |--- waypoints: count (u32), for each: name (string), x (u16), y (u16), z (u8)
+
+    Items are written children first, so an item only references items before it.
+*/
+
+namespace {
+	constexpr std::array<char, 4> SNAPSHOT_MAGIC { 'C', 'M', 'S', 'P' };
+	constexpr uint32_t NO_INDEX = std::numeric_limits<uint32_t>::max();
+
+	class SnapshotWriter {
+	public:
+		template <typename T>
+		void write(T value) {
+			buffer.append(reinterpret_cast<const char*>(&value), sizeof(T));
+		}
+
+		void writeString(std::string_view str) {
+			write(static_cast<uint16_t>(str.size()));
+			buffer.append(str);
+		}
+
+		void writePosition(const Position &pos) {
+			write(pos.x);
+			write(pos.y);
+			write(pos.z);
+		}
+
+		const std::string &data() const {
+			return buffer;
+		}
+
+	private:
+		std::string buffer;
+	};
+
+	Position readPosition(FileStream &stream) {
+		const uint16_t x = stream.getU16();
+		const uint16_t y = stream.getU16();
+		const uint8_t z = stream.getU8();
+		return Position(x, y, z);
+	}
+
+	// Every entry takes at least one byte, so a bigger count can only come from a broken file
+	uint32_t readCount(FileStream &stream) {
+		const uint32_t count = stream.getU32();
+		if (count > stream.size() - stream.tell()) {
+			throw IOMapException("Invalid entry count.");
+		}
+		return count;
+	}
+
+	uint64_t mix(uint64_t seed, uint64_t value) {
+		value ^= value >> 33U;
+		value *= UINT64_C(0xff51afd7ed558ccd);
+		value ^= value >> 33U;
+		return seed ^ (value + 0x9e3779b97f4a7c15 + (seed << 6) + (seed >> 2));
+	}
+}
+
+uint64_t IOMap::getSnapshotKey(const mio::mmap_source &source) {
+	uint64_t key = mix(0, SNAPSHOT_VERSION);
+
+	// FNV-1a over 8 byte words, the whole file has to be read anyway
+	uint64_t contents = UINT64_C(14695981039346656037);
+	const auto* data = source.data();
+	const size_t size = source.size();
+	size_t i = 0;
+	for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t)) {
+		uint64_t word;
+		memcpy(&word, data + i, sizeof(uint64_t));
+		contents = (contents ^ word) * UINT64_C(1099511628211);
+	}
+	for (; i < size; ++i) {
+		contents = (contents ^ static_cast<uint8_t>(data[i])) * UINT64_C(1099511628211);
+	}
+	key = mix(key, contents);
+	key = mix(key, size);
+
+	// The item properties the tile parse depends on
+	key = mix(key, Item::items.size());
+	for (size_t id = 0; id < Item::items.size(); ++id) {
+		const auto &iType = Item::items[id];
+		const uint64_t flags = static_cast<uint64_t>(iType.isGroundTile()) | static_cast<uint64_t>(iType.isBed()) << 1 | static_cast<uint64_t>(iType.isTrashHolder()) << 2 | static_cast<uint64_t>(iType.movable) << 3;
+		key = mix(key, flags);
+	}
+
+	return key;
+}
+
+std::filesystem::path IOMap::getSnapshotPath(const Map* map) {
+	auto path = map->path;
+	path += ".snapshot";
+	return path;
+}
+
+bool IOMap::loadSnapshot(Map* map, uint64_t key) {
+	const auto path = getSnapshotPath(map);
+	std::error_code error;
+	if (!std::filesystem::exists(path, error)) {
+		return false;
+	}
+
+	try {
+		FileStream stream { mio::mmap_source(path.string()) };
+		stream.adviseSequential();
+
+		for (const char c : SNAPSHOT_MAGIC) {
+			if (stream.getU8() != static_cast<uint8_t>(c)) {
+				g_logger().warn("[{}] - {} is not a map snapshot, ignoring it", __FUNCTION__, path.string());
+				return false;
+			}
+		}
+
+		if (stream.getU32() != SNAPSHOT_VERSION || stream.getU64() != key) {
+			g_logger().info("Map snapshot {} is outdated, the map will be loaded from the otbm", path.filename().string());
+			return false;
+		}
+
+		// Everything is read before it is applied, so a broken snapshot does not leave a half loaded map
+		const uint16_t width = stream.getU16();
+		const uint16_t height = stream.getU16();
+		std::array<std::string, 4> files;
+		for (auto &file : files) {
+			file = stream.getString();
+		}
+
+		std::vector<std::shared_ptr<BasicItem>> items(readCount(stream));
+		for (auto &item : items) {
+			BasicItem basicItem;
+			basicItem.id = stream.getU16();
+			basicItem.charges = stream.getU16();
+			basicItem.actionId = stream.getU16();
+			basicItem.uniqueId = stream.getU16();
+			basicItem.destX = stream.getU16();
+			basicItem.destY = stream.getU16();
+			basicItem.doorOrDepotId = stream.getU16();
+			basicItem.destZ = stream.getU8();
+			if (const auto text = stream.getStringView(); !text.empty()) {
+				basicItem.text = BasicItem::internText(text);
+			}
+
+			if (const uint32_t children = readCount(stream); children > 0) {
+				basicItem.items = std::make_unique<std::vector<std::shared_ptr<BasicItem>>>();
+				basicItem.items->reserve(children);
+				for (uint32_t i = 0; i < children; ++i) {
+					const uint32_t index = stream.getU32();
+					if (index >= static_cast<uint32_t>(&item - items.data())) {
+						throw IOMapException("Invalid child item index.");
+					}
+					basicItem.items->emplace_back(items[index]);
+				}
+			}
+
+			item = std::make_shared<BasicItem>(std::move(basicItem));
+		}
+
+		const auto getItem = [&items](uint32_t index) {
+			if (index >= items.size()) {
+				throw IOMapException("Invalid item index.");
+			}
+			return items[index];
+		};
+
+		std::vector<std::shared_ptr<BasicTile>> tiles(readCount(stream));
+		for (auto &tile : tiles) {
+			tile = std::make_shared<BasicTile>();
+			tile->flags = stream.getU32();
+			tile->houseId = stream.getU32();
+			tile->type = stream.getU8();
+			tile->isStatic = stream.getU8() != 0;
+			if (const uint32_t ground = stream.getU32(); ground != NO_INDEX) {
+				tile->ground = getItem(ground);
+			}
+
+			const uint32_t tileItems = readCount(stream);
+			tile->items.reserve(tileItems);
+			for (uint32_t i = 0; i < tileItems; ++i) {
+				tile->items.emplace_back(getItem(stream.getU32()));
+			}
+		}
+
+		std::vector<std::pair<Position, uint32_t>> placements(readCount(stream));
+		for (auto &[position, index] : placements) {
+			position = readPosition(stream);
+			index = stream.getU32();
+			if (index >= tiles.size()) {
+				throw IOMapException("Invalid tile index.");
+			}
+		}
+
+		std::vector<std::pair<uint16_t, Position>> zonePositions(readCount(stream));
+		for (auto &[zoneId, position] : zonePositions) {
+			zoneId = stream.getU16();
+			position = readPosition(stream);
+		}
+
+		std::vector<std::tuple<uint32_t, std::string, Position>> towns(readCount(stream));
+		for (auto &[townId, name, templePos] : towns) {
+			townId = stream.getU32();
+			name = stream.getString();
+			templePos = readPosition(stream);
+		}
+
+		std::vector<std::pair<std::string, Position>> waypoints(readCount(stream));
+		for (auto &[name, position] : waypoints) {
+			name = stream.getString();
+			position = readPosition(stream);
+		}
+
+		map->width = width;
+		map->height = height;
+		std::array<std::string*, 4> mapFiles { &map->monsterfile, &map->npcfile, &map->housefile, &map->zonesfile };
+		for (size_t i = 0; i < files.size(); ++i) {
+			if (!files[i].empty()) {
+				*mapFiles[i] = files[i];
+			}
+		}
+
+		for (const auto &[position, index] : placements) {
+			const auto &tile = tiles[index];
+			if (tile->isHouse() && !map->houses.addHouse(tile->houseId)) {
+				throw IOMapException(fmt::format("[x:{}, y:{}, z:{}] Could not create house id: {}", position.x, position.y, position.z, tile->houseId));
+			}
+			map->setBasicTile(position.x, position.y, position.z, tile, true);
+		}
+
+		for (const auto &[zoneId, position] : zonePositions) {
+			Zone::getZone(zoneId)->addPosition(position);
+		}
+
+		for (const auto &[townId, name, templePos] : towns) {
+			auto town = map->towns.getOrCreateTown(townId);
+			town->setName(name);
+			town->setTemplePos(templePos);
+		}
+
+		for (const auto &[name, position] : waypoints) {
+			map->waypoints[name] = position;
+		}
+	} catch (const std::exception &e) {
+		g_logger().warn("[{}] - Failed to read map snapshot {}: {}", __FUNCTION__, path.string(), e.what());
+		return false;
+	}
+
+	return true;
+}
+
+void IOMap::saveSnapshot(const Map* map, uint64_t key, const std::vector<TileAreaShard> &shards) {
+	Benchmark bm_saveSnapshot;
+
+	std::unordered_map<const BasicItem*, uint32_t> itemIndexes;
+	std::vector<const BasicItem*> items;
+	const std::function<uint32_t(const std::shared_ptr<BasicItem> &)> indexItem = [&](const std::shared_ptr<BasicItem> &item) -> uint32_t {
+		if (const auto it = itemIndexes.find(item.get()); it != itemIndexes.end()) {
+			return it->second;
+		}
+
+		if (item->items) {
+			for (const auto &child : *item->items) {
+				indexItem(child);
+			}
+		}
+
+		const auto index = static_cast<uint32_t>(items.size());
+		items.emplace_back(item.get());
+		itemIndexes.emplace(item.get(), index);
+		return index;
+	};
+
+	std::unordered_map<const BasicTile*, uint32_t> tileIndexes;
+	std::vector<const BasicTile*> tiles;
+	size_t placements = 0;
+	size_t zonePositions = 0;
+	for (const auto &shard : shards) {
+		for (const auto &[position, tile] : shard.tiles) {
+			if (tile && tileIndexes.try_emplace(tile.get(), static_cast<uint32_t>(tiles.size())).second) {
+				tiles.emplace_back(tile.get());
+				if (tile->ground) {
+					indexItem(tile->ground);
+				}
+				for (const auto &item : tile->items) {
+					indexItem(item);
+				}
+			}
+		}
+		placements += shard.tiles.size();
+		zonePositions += shard.zonePositions.size();
+	}
+
+	SnapshotWriter writer;
+	for (const char c : SNAPSHOT_MAGIC) {
+		writer.write(c);
+	}
+	writer.write(SNAPSHOT_VERSION);
+	writer.write(key);
+
+	writer.write(static_cast<uint16_t>(map->width));
+	writer.write(static_cast<uint16_t>(map->height));
+	for (const auto* file : { &map->monsterfile, &map->npcfile, &map->housefile, &map->zonesfile }) {
+		writer.writeString(*file);
+	}
+
+	writer.write(static_cast<uint32_t>(items.size()));
+	for (const auto* item : items) {
+		writer.write(item->id);
+		writer.write(item->charges);
+		writer.write(item->actionId);
+		writer.write(item->uniqueId);
+		writer.write(item->destX);
+		writer.write(item->destY);
+		writer.write(item->doorOrDepotId);
+		writer.write(item->destZ);
+		writer.writeString(item->text);
+
+		writer.write(static_cast<uint32_t>(item->items ? item->items->size() : 0));
+		if (item->items) {
+			for (const auto &child : *item->items) {
+				writer.write(itemIndexes.at(child.get()));
+			}
+		}
+	}
+
+	writer.write(static_cast<uint32_t>(tiles.size()));
+	for (const auto* tile : tiles) {
+		writer.write(tile->flags);
+		writer.write(tile->houseId);
+		writer.write(tile->type);
+		writer.write(static_cast<uint8_t>(tile->isStatic));
+		writer.write(tile->ground ? itemIndexes.at(tile->ground.get()) : NO_INDEX);
+		writer.write(static_cast<uint32_t>(tile->items.size()));
+		for (const auto &item : tile->items) {
+			writer.write(itemIndexes.at(item.get()));
+		}
+	}
+
+	writer.write(static_cast<uint32_t>(placements));
+	for (const auto &shard : shards) {
+		for (const auto &[position, tile] : shard.tiles) {
+			writer.writePosition(position);
+			writer.write(tileIndexes.at(tile.get()));
+		}
+	}
+
+	writer.write(static_cast<uint32_t>(zonePositions));
+	for (const auto &shard : shards) {
+		for (const auto &[zoneId, position] : shard.zonePositions) {
+			writer.write(zoneId);
+			writer.writePosition(position);
+		}
+	}
+
+	const auto &towns = map->towns.getTowns();
+	writer.write(static_cast<uint32_t>(towns.size()));
+	for (const auto &[townId, town] : towns) {
+		writer.write(townId);
+		writer.writeString(town->getName());
+		writer.writePosition(town->getTemplePosition());
+	}
+
+	writer.write(static_cast<uint32_t>(map->waypoints.size()));
+	for (const auto &[name, position] : map->waypoints) {
+		writer.writeString(name);
+		writer.writePosition(position);
+	}
+
+	// Written aside and renamed, so a crash while saving never leaves a truncated snapshot behind
+	const auto path = getSnapshotPath(map);
+	auto temporaryPath = path;
+	temporaryPath += ".tmp";
+	{
+		std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+		if (!file || !file.write(writer.data().data(), static_cast<std::streamsize>(writer.data().size()))) {
+			g_logger().warn("[{}] - Could not write map snapshot {}", __FUNCTION__, temporaryPath.string());
+			return;
+		}
+	}
+
+	std::error_code error;
+	std::filesystem::rename(temporaryPath, path, error);
+	if (error) {
+		g_logger().warn("[{}] - Could not save map snapshot {}: {}", __FUNCTION__, path.string(), error.message());
+		return;
+	}
+
+	g_logger().info("Map snapshot {} saved ({} tiles, {} items) in {} milliseconds", path.filename().string(), tiles.size(), items.size(), bm_saveSnapshot.duration());
+}
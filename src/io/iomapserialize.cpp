@@ -63,30 +63,57 @@ void IOMapSerialize::loadHouseItems(Map* map) {
 }
 
 bool IOMapSerialize::saveHouseItems() {
-	bool success = DBTransaction::executeWithinTransaction([]() {
-		return SaveHouseItemsGuard();
+	std::vector<std::shared_ptr<House>> dirtyHouses;
+	for (const auto &[key, house] : g_game().map.houses.getHouses()) {
+		if (house->isItemsDirty()) {
+			dirtyHouses.emplace_back(house);
+		}
+	}
+
+	if (dirtyHouses.empty()) {
+		return true;
+	}
+
+	// Cleared before serializing, so changes made while saving are picked up by the next save
+	for (const auto &house : dirtyHouses) {
+		house->setItemsDirty(false);
+	}
+
+	bool success = DBTransaction::executeWithinTransaction([&dirtyHouses]() {
+		return SaveHouseItemsGuard(dirtyHouses);
 	});
 
 	if (!success) {
+		for (const auto &house : dirtyHouses) {
+			house->setItemsDirty();
+		}
 		g_logger().error("[{}] Error occurred saving houses", __FUNCTION__);
+	} else {
+		g_logger().debug("[{}] Saved items of {} changed houses", __FUNCTION__, dirtyHouses.size());
 	}
 
 	return success;
 }
 
-bool IOMapSerialize::SaveHouseItemsGuard() {
+bool IOMapSerialize::SaveHouseItemsGuard(const std::vector<std::shared_ptr<House>> &houses) {
 	Database &db = Database::getInstance();
 	std::ostringstream query;
 
-	// clear old tile data
-	if (!db.executeQuery("DELETE FROM `tile_store`")) {
+	// clear old tile data of the houses that are rewritten
+	query << "DELETE FROM `tile_store` WHERE `house_id` IN (";
+	for (size_t i = 0; i < houses.size(); ++i) {
+		query << (i == 0 ? "" : ",") << houses[i]->getId();
+	}
+	query << ')';
+	if (!db.executeQuery(query.str())) {
 		return false;
 	}
+	query.str(std::string());
 
 	DBInsert stmt("INSERT INTO `tile_store` (`house_id`, `data`) VALUES ");
 
 	PropWriteStream stream;
-	for (const auto &[key, house] : g_game().map.houses.getHouses()) {
+	for (const auto &house : houses) {
 		// save house items
 		for (const auto &tile : house->getTiles()) {
 			saveTile(stream, tile);
@@ -275,7 +302,8 @@ void IOMapSerialize::saveTile(PropWriteStream &stream, std::shared_ptr<Tile> til
 bool IOMapSerialize::loadHouseInfo() {
 	Database &db = Database::getInstance();
 
-	DBResult_ptr result = db.storeQuery("SELECT `id`, `owner`, `new_owner`, `paid`, `warnings` FROM `houses`");
+	// With the name and account of the owners, instead of a query per house
+	DBResult_ptr result = db.storeQuery("SELECT `houses`.`id`, `houses`.`owner`, `houses`.`new_owner`, `houses`.`paid`, `houses`.`warnings`, `players`.`name` AS `owner_name`, `players`.`account_id` AS `owner_account_id` FROM `houses` LEFT JOIN `players` ON `players`.`id` = `houses`.`owner`");
 	if (!result) {
 		return false;
 	}
@@ -298,7 +326,8 @@ bool IOMapSerialize::loadHouseInfo() {
 					house->setOwner(newOwner);
 				}
 			} else {
-				house->setOwner(owner, false);
+				const HouseOwnerInfo ownerInfo { result->getString("owner_name"), result->getNumber<uint32_t>("owner_account_id") };
+				house->setOwner(owner, false, nullptr, &ownerInfo);
 			}
 			house->setPaidUntil(result->getNumber<time_t>("paid"));
 			house->setPayRentWarnings(result->getNumber<uint32_t>("warnings"));
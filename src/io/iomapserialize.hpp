@@ -20,7 +20,7 @@ public:
 
 private:
 	static bool SaveHouseInfoGuard();
-	static bool SaveHouseItemsGuard();
+	static bool SaveHouseItemsGuard(const std::vector<std::shared_ptr<House>> &houses);
 	static void saveItem(PropWriteStream &stream, std::shared_ptr<Item> item);
 	static void saveTile(PropWriteStream &stream, std::shared_ptr<Tile> tile);
 
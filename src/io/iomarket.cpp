@@ -15,6 +15,7 @@
 #include "game/game.hpp"
 #include "game/scheduling/dispatcher.hpp"
 #include "game/scheduling/save_manager.hpp"
+#include "lib/thread/thread_pool.hpp"
 
 uint8_t IOMarket::getTierFromDatabaseTable(const std::string &string) {
 	auto tier = static_cast<uint8_t>(std::atoi(string.c_str()));
@@ -26,105 +27,173 @@ uint8_t IOMarket::getTierFromDatabaseTable(const std::string &string) {
 	return tier;
 }
 
-MarketOfferList IOMarket::getActiveOffers(MarketAction_t action) {
-	MarketOfferList offerList;
+MarketOffer IOMarket::toMarketOffer(uint32_t id, const BookOffer &offer, int32_t offerDuration, bool withName) {
+	MarketOffer marketOffer;
+	marketOffer.itemId = offer.itemId;
+	marketOffer.amount = offer.amount;
+	marketOffer.price = offer.price;
+	marketOffer.timestamp = offer.created + offerDuration;
+	marketOffer.counter = id & 0xFFFF;
+	marketOffer.tier = offer.tier;
+	if (withName) {
+		marketOffer.playerName = offer.anonymous ? "Anonymous" : offer.playerName;
+	}
+	return marketOffer;
+}
+
+MarketOfferEx IOMarket::toMarketOfferEx(uint32_t id, const BookOffer &offer) {
+	MarketOfferEx marketOffer;
+	marketOffer.id = id;
+	marketOffer.type = offer.type;
+	marketOffer.amount = offer.amount;
+	marketOffer.counter = id & 0xFFFF;
+	marketOffer.timestamp = offer.created;
+	marketOffer.price = offer.price;
+	marketOffer.itemId = offer.itemId;
+	marketOffer.playerId = offer.playerId;
+	marketOffer.tier = offer.tier;
+	marketOffer.playerName = offer.anonymous ? "Anonymous" : offer.playerName;
+	return marketOffer;
+}
+
+void IOMarket::loadOffers() {
+	offersLoaded = true;
 
-	std::string query = fmt::format(
-		"SELECT `id`, `itemtype`, `amount`, `price`, `tier`, `created`, `anonymous`, "
+	DBResult_ptr result = g_database().storeQuery(
+		"SELECT `id`, `player_id`, `sale`, `itemtype`, `amount`, `created`, `anonymous`, `price`, `tier`, "
 		"(SELECT `name` FROM `players` WHERE `id` = `player_id`) AS `player_name` "
-		"FROM `market_offers` WHERE `sale` = {}",
-		action
+		"FROM `market_offers`"
 	);
-
-	DBResult_ptr result = g_database().storeQuery(query);
 	if (!result) {
-		return offerList;
+		return;
 	}
 
-	const int32_t marketOfferDuration = g_configManager().getNumber(MARKET_OFFER_DURATION, __FUNCTION__);
-
 	do {
-		MarketOffer offer;
-		offer.itemId = result->getNumber<uint16_t>("itemtype");
-		offer.amount = result->getNumber<uint16_t>("amount");
-		offer.price = result->getNumber<uint64_t>("price");
-		offer.timestamp = result->getNumber<uint32_t>("created") + marketOfferDuration;
-		offer.counter = result->getNumber<uint32_t>("id") & 0xFFFF;
-		if (result->getNumber<uint16_t>("anonymous") == 0) {
-			offer.playerName = result->getString("player_name");
-		} else {
-			offer.playerName = "Anonymous";
-		}
-		offer.tier = getTierFromDatabaseTable(result->getString("tier"));
-		offerList.push_back(offer);
+		const auto id = result->getNumber<uint32_t>("id");
+		addOffer(
+			id,
+			BookOffer {
+				result->getNumber<uint32_t>("player_id"),
+				result->getNumber<uint32_t>("created"),
+				result->getNumber<uint64_t>("price"),
+				result->getNumber<uint16_t>("amount"),
+				result->getNumber<uint16_t>("itemtype"),
+				getTierFromDatabaseTable(result->getString("tier")),
+				static_cast<MarketAction_t>(result->getNumber<uint16_t>("sale")),
+				result->getNumber<uint16_t>("anonymous") != 0,
+				result->getString("player_name"),
+			}
+		);
+		nextOfferId = std::max(nextOfferId, id + 1);
 	} while (result->next());
-	return offerList;
+
+	g_logger().debug("[{}] - Loaded {} market offers", __FUNCTION__, offers.size());
 }
 
-MarketOfferList IOMarket::getActiveOffers(MarketAction_t action, uint16_t itemId, uint8_t tier) {
-	MarketOfferList offerList;
+void IOMarket::addOffer(uint32_t id, BookOffer offer) {
+	books[getBookKey(offer.itemId, offer.tier, offer.type)].emplace(offer.price, id);
+	playerOffers[offer.playerId].emplace(id);
+	counterIndex[getCounterKey(offer.created, id & 0xFFFF)] = id;
+	offers.try_emplace(id, std::move(offer));
+}
 
-	std::ostringstream query;
-	query << "SELECT `id`, `amount`, `price`, `tier`, `created`, `anonymous`, (SELECT `name` FROM `players` WHERE `id` = `player_id`) AS `player_name` FROM `market_offers` WHERE `sale` = " << action << " AND `itemtype` = " << itemId << " AND `tier` = " << std::to_string(tier);
+void IOMarket::eraseOffer(uint32_t id) {
+	auto it = offers.find(id);
+	if (it == offers.end()) {
+		return;
+	}
 
-	DBResult_ptr result = Database::getInstance().storeQuery(query.str());
-	if (!result) {
-		return offerList;
+	const auto &offer = it->second;
+	if (auto bookIt = books.find(getBookKey(offer.itemId, offer.tier, offer.type)); bookIt != books.end()) {
+		bookIt->second.erase({ offer.price, id });
+		if (bookIt->second.empty()) {
+			books.erase(bookIt);
+		}
 	}
 
-	const int32_t marketOfferDuration = g_configManager().getNumber(MARKET_OFFER_DURATION, __FUNCTION__);
+	if (auto playerIt = playerOffers.find(offer.playerId); playerIt != playerOffers.end()) {
+		playerIt->second.erase(id);
+		if (playerIt->second.empty()) {
+			playerOffers.erase(playerIt);
+		}
+	}
 
-	do {
-		MarketOffer offer;
-		offer.itemId = itemId;
-		offer.amount = result->getNumber<uint16_t>("amount");
-		offer.price = result->getNumber<uint64_t>("price");
-		offer.timestamp = result->getNumber<uint32_t>("created") + marketOfferDuration;
-		offer.counter = result->getNumber<uint32_t>("id") & 0xFFFF;
-		if (result->getNumber<uint16_t>("anonymous") == 0) {
-			offer.playerName = result->getString("player_name");
-		} else {
-			offer.playerName = "Anonymous";
+	// Another offer may have the same counter in the same second
+	if (auto counterIt = counterIndex.find(getCounterKey(offer.created, id & 0xFFFF)); counterIt != counterIndex.end() && counterIt->second == id) {
+		counterIndex.erase(counterIt);
+	}
+
+	offers.erase(it);
+}
+
+MarketOfferList IOMarket::getActiveOffers(MarketAction_t action) {
+	auto &market = getInstance();
+	if (!market.offersLoaded) {
+		market.loadOffers();
+	}
+
+	const int32_t marketOfferDuration = g_configManager().getNumber(MARKET_OFFER_DURATION, __FUNCTION__);
+	MarketOfferList offerList;
+	for (const auto &[id, offer] : market.offers) {
+		if (offer.type == action) {
+			offerList.push_back(toMarketOffer(id, offer, marketOfferDuration, true));
 		}
-		offer.tier = getTierFromDatabaseTable(result->getString("tier"));
-		offerList.push_back(offer);
-	} while (result->next());
+	}
 	return offerList;
 }
 
-MarketOfferList IOMarket::getOwnOffers(MarketAction_t action, uint32_t playerId) {
-	MarketOfferList offerList;
+MarketOfferList IOMarket::getActiveOffers(MarketAction_t action, uint16_t itemId, uint8_t tier) {
+	auto &market = getInstance();
+	if (!market.offersLoaded) {
+		market.loadOffers();
+	}
 
 	const int32_t marketOfferDuration = g_configManager().getNumber(MARKET_OFFER_DURATION, __FUNCTION__);
+	MarketOfferList offerList;
+	auto it = market.books.find(getBookKey(itemId, tier, action));
+	if (it == market.books.end()) {
+		return offerList;
+	}
+
+	for (const auto &[price, id] : it->second) {
+		offerList.push_back(toMarketOffer(id, market.offers.at(id), marketOfferDuration, true));
+	}
+	return offerList;
+}
 
-	std::ostringstream query;
-	query << "SELECT `id`, `amount`, `price`, `created`, `itemtype`, `tier` FROM `market_offers` WHERE `player_id` = " << playerId << " AND `sale` = " << action;
+MarketOfferList IOMarket::getOwnOffers(MarketAction_t action, uint32_t playerId) {
+	auto &market = getInstance();
+	if (!market.offersLoaded) {
+		market.loadOffers();
+	}
 
-	DBResult_ptr result = Database::getInstance().storeQuery(query.str());
-	if (!result) {
+	const int32_t marketOfferDuration = g_configManager().getNumber(MARKET_OFFER_DURATION, __FUNCTION__);
+	MarketOfferList offerList;
+	auto it = market.playerOffers.find(playerId);
+	if (it == market.playerOffers.end()) {
 		return offerList;
 	}
 
-	do {
-		MarketOffer offer;
-		offer.amount = result->getNumber<uint16_t>("amount");
-		offer.price = result->getNumber<uint64_t>("price");
-		offer.timestamp = result->getNumber<uint32_t>("created") + marketOfferDuration;
-		offer.counter = result->getNumber<uint32_t>("id") & 0xFFFF;
-		offer.itemId = result->getNumber<uint16_t>("itemtype");
-		offer.tier = getTierFromDatabaseTable(result->getString("tier"));
-		offerList.push_back(offer);
-	} while (result->next());
+	for (const auto id : it->second) {
+		const auto &offer = market.offers.at(id);
+		if (offer.type == action) {
+			offerList.push_back(toMarketOffer(id, offer, marketOfferDuration, false));
+		}
+	}
 	return offerList;
 }
 
 HistoryMarketOfferList IOMarket::getOwnHistory(MarketAction_t action, uint32_t playerId) {
 	HistoryMarketOfferList offerList;
 
-	std::ostringstream query;
-	query << "SELECT `itemtype`, `amount`, `price`, `expires_at`, `state`, `tier` FROM `market_history` WHERE `player_id` = " << playerId << " AND `sale` = " << action;
+	DBStatement query("SELECT `itemtype`, `amount`, `price`, `expires_at`, `state`, `tier` FROM `market_history` WHERE `player_id` = ? AND `sale` = ?");
+	query.bind(playerId).bind(action);
 
-	DBResult_ptr result = Database::getInstance().storeQuery(query.str());
+	DBResult_ptr result;
+	{
+		DBReadOnly readOnly;
+		result = Database::getInstance().storeQuery(query);
+	}
 	if (!result) {
 		return offerList;
 	}
@@ -149,89 +218,94 @@ HistoryMarketOfferList IOMarket::getOwnHistory(MarketAction_t action, uint32_t p
 	return offerList;
 }
 
-void IOMarket::processExpiredOffers(DBResult_ptr result, bool) {
-	if (!result) {
-		return;
-	}
-
-	do {
-		if (!IOMarket::moveOfferToHistory(result->getNumber<uint32_t>("id"), OFFERSTATE_EXPIRED)) {
-			continue;
+void IOMarket::processExpiredOffer(const MarketOfferEx &offer) {
+	const uint32_t playerId = offer.playerId;
+	const uint16_t amount = offer.amount;
+	const auto tier = offer.tier;
+	if (offer.type == MARKETACTION_SELL) {
+		const ItemType &itemType = Item::items[offer.itemId];
+		if (itemType.id == 0) {
+			return;
 		}
 
-		const uint32_t playerId = result->getNumber<uint32_t>("player_id");
-		const uint16_t amount = result->getNumber<uint16_t>("amount");
-		auto tier = getTierFromDatabaseTable(result->getString("tier"));
-		if (result->getNumber<uint16_t>("sale") == 1) {
-			const ItemType &itemType = Item::items[result->getNumber<uint16_t>("itemtype")];
-			if (itemType.id == 0) {
-				continue;
-			}
-
-			std::shared_ptr<Player> player = g_game().getPlayerByGUID(playerId, true);
-			if (!player) {
-				continue;
-			}
-
-			if (itemType.stackable) {
-				uint16_t tmpAmount = amount;
-				while (tmpAmount > 0) {
-					uint16_t stackCount = std::min<uint16_t>(100, tmpAmount);
-					std::shared_ptr<Item> item = Item::CreateItem(itemType.id, stackCount);
-					if (g_game().internalAddItem(player->getInbox(), item, INDEX_WHEREEVER, FLAG_NOLIMIT) != RETURNVALUE_NOERROR) {
-						g_logger().error("[{}] Ocurred an error to add item with id {} to player {}", __FUNCTION__, itemType.id, player->getName());
+		std::shared_ptr<Player> player = g_game().getPlayerByGUID(playerId, true);
+		if (!player) {
+			return;
+		}
 
-						break;
-					}
+		if (itemType.stackable) {
+			uint16_t tmpAmount = amount;
+			while (tmpAmount > 0) {
+				uint16_t stackCount = std::min<uint16_t>(100, tmpAmount);
+				std::shared_ptr<Item> item = Item::CreateItem(itemType.id, stackCount);
+				if (g_game().internalAddItem(player->getInbox(), item, INDEX_WHEREEVER, FLAG_NOLIMIT) != RETURNVALUE_NOERROR) {
+					g_logger().error("[{}] Ocurred an error to add item with id {} to player {}", __FUNCTION__, itemType.id, player->getName());
 
-					if (tier != 0) {
-						item->setAttribute(ItemAttribute_t::TIER, tier);
-					}
+					break;
+				}
 
-					tmpAmount -= stackCount;
+				if (tier != 0) {
+					item->setAttribute(ItemAttribute_t::TIER, tier);
 				}
+
+				tmpAmount -= stackCount;
+			}
+		} else {
+			int32_t subType;
+			if (itemType.charges != 0) {
+				subType = itemType.charges;
 			} else {
-				int32_t subType;
-				if (itemType.charges != 0) {
-					subType = itemType.charges;
-				} else {
-					subType = -1;
-				}
+				subType = -1;
+			}
 
-				for (uint16_t i = 0; i < amount; ++i) {
-					std::shared_ptr<Item> item = Item::CreateItem(itemType.id, subType);
-					if (g_game().internalAddItem(player->getInbox(), item, INDEX_WHEREEVER, FLAG_NOLIMIT) != RETURNVALUE_NOERROR) {
-						break;
-					}
+			for (uint16_t i = 0; i < amount; ++i) {
+				std::shared_ptr<Item> item = Item::CreateItem(itemType.id, subType);
+				if (g_game().internalAddItem(player->getInbox(), item, INDEX_WHEREEVER, FLAG_NOLIMIT) != RETURNVALUE_NOERROR) {
+					break;
+				}
 
-					if (tier != 0) {
-						item->setAttribute(ItemAttribute_t::TIER, tier);
-					}
+				if (tier != 0) {
+					item->setAttribute(ItemAttribute_t::TIER, tier);
 				}
 			}
+		}
 
-			if (player->isOffline()) {
-				g_saveManager().savePlayer(player);
-			}
-		} else {
-			uint64_t totalPrice = result->getNumber<uint64_t>("price") * amount;
+		if (player->isOffline()) {
+			g_saveManager().savePlayer(player);
+		}
+	} else {
+		uint64_t totalPrice = offer.price * amount;
 
-			std::shared_ptr<Player> player = g_game().getPlayerByGUID(playerId);
-			if (player) {
-				player->setBankBalance(player->getBankBalance() + totalPrice);
-			} else {
-				IOLoginData::increaseBankBalance(playerId, totalPrice);
-			}
+		std::shared_ptr<Player> player = g_game().getPlayerByGUID(playerId);
+		if (player) {
+			player->setBankBalance(player->getBankBalance() + totalPrice);
+		} else {
+			IOLoginData::increaseBankBalance(playerId, totalPrice);
 		}
-	} while (result->next());
+	}
 }
 
 void IOMarket::checkExpiredOffers() {
+	auto &market = getInstance();
+	if (!market.offersLoaded) {
+		market.loadOffers();
+	}
+
 	const time_t lastExpireDate = getTimeNow() - g_configManager().getNumber(MARKET_OFFER_DURATION, __FUNCTION__);
 
-	std::ostringstream query;
-	query << "SELECT `id`, `amount`, `price`, `itemtype`, `player_id`, `sale`, `tier` FROM `market_offers` WHERE `created` <= " << lastExpireDate;
-	g_databaseTasks().store(query.str(), IOMarket::processExpiredOffers);
+	std::vector<uint32_t> expiredOffers;
+	for (const auto &[id, offer] : market.offers) {
+		if (offer.created <= lastExpireDate) {
+			expiredOffers.emplace_back(id);
+		}
+	}
+
+	for (const auto id : expiredOffers) {
+		const auto offer = toMarketOfferEx(id, market.offers.at(id));
+		if (moveOfferToHistory(id, OFFERSTATE_EXPIRED)) {
+			processExpiredOffer(offer);
+		}
+	}
 
 	int32_t checkExpiredMarketOffersEachMinutes = g_configManager().getNumber(CHECK_EXPIRED_MARKET_OFFERS_EACH_MINUTES, __FUNCTION__);
 	if (checkExpiredMarketOffersEachMinutes <= 0) {
@@ -242,103 +316,166 @@ void IOMarket::checkExpiredOffers() {
 }
 
 uint32_t IOMarket::getPlayerOfferCount(uint32_t playerId) {
-	std::ostringstream query;
-	query << "SELECT COUNT(*) AS `count` FROM `market_offers` WHERE `player_id` = " << playerId;
-
-	DBResult_ptr result = Database::getInstance().storeQuery(query.str());
-	if (!result) {
-		return 0;
+	auto &market = getInstance();
+	if (!market.offersLoaded) {
+		market.loadOffers();
 	}
-	return result->getNumber<int32_t>("count");
+
+	auto it = market.playerOffers.find(playerId);
+	return it != market.playerOffers.end() ? static_cast<uint32_t>(it->second.size()) : 0;
 }
 
 MarketOfferEx IOMarket::getOfferByCounter(uint32_t timestamp, uint16_t counter) {
-	MarketOfferEx offer;
-
-	const int32_t created = timestamp - g_configManager().getNumber(MARKET_OFFER_DURATION, __FUNCTION__);
+	auto &market = getInstance();
+	if (!market.offersLoaded) {
+		market.loadOffers();
+	}
 
-	std::ostringstream query;
-	query << "SELECT `id`, `sale`, `itemtype`, `amount`, `created`, `price`, `player_id`, `anonymous`, `tier`, (SELECT `name` FROM `players` WHERE `id` = `player_id`) AS `player_name` FROM `market_offers` WHERE `created` = " << created << " AND (`id` & 65535) = " << counter << " LIMIT 1";
+	const uint32_t created = timestamp - g_configManager().getNumber(MARKET_OFFER_DURATION, __FUNCTION__);
 
-	DBResult_ptr result = Database::getInstance().storeQuery(query.str());
-	if (!result) {
+	auto it = market.counterIndex.find(getCounterKey(created, counter));
+	if (it == market.counterIndex.end()) {
+		MarketOfferEx offer;
 		offer.id = 0;
 		return offer;
 	}
 
-	offer.id = result->getNumber<uint32_t>("id");
-	offer.type = static_cast<MarketAction_t>(result->getNumber<uint16_t>("sale"));
-	offer.amount = result->getNumber<uint16_t>("amount");
-	offer.counter = result->getNumber<uint32_t>("id") & 0xFFFF;
-	offer.timestamp = result->getNumber<uint32_t>("created");
-	offer.price = result->getNumber<uint64_t>("price");
-	offer.itemId = result->getNumber<uint16_t>("itemtype");
-	offer.playerId = result->getNumber<uint32_t>("player_id");
-	offer.tier = getTierFromDatabaseTable(result->getString("tier"));
-	if (result->getNumber<uint16_t>("anonymous") == 0) {
-		offer.playerName = result->getString("player_name");
-	} else {
-		offer.playerName = "Anonymous";
-	}
-	return offer;
+	return toMarketOfferEx(it->second, market.offers.at(it->second));
 }
 
 void IOMarket::createOffer(uint32_t playerId, MarketAction_t action, uint32_t itemId, uint16_t amount, uint64_t price, uint8_t tier, bool anonymous) {
-	std::ostringstream query;
-	query << "INSERT INTO `market_offers` (`player_id`, `sale`, `itemtype`, `amount`, `created`, `anonymous`, `price`, `tier`) VALUES (" << playerId << ',' << action << ',' << itemId << ',' << amount << ',' << getTimeNow() << ',' << anonymous << ',' << price << ',' << std::to_string(tier) << ')';
-	Database::getInstance().executeQuery(query.str());
+	auto &market = getInstance();
+	if (!market.offersLoaded) {
+		market.loadOffers();
+	}
+
+	std::string playerName;
+	if (const auto &player = g_game().getPlayerByGUID(playerId)) {
+		playerName = player->getName();
+	} else {
+		playerName = IOLoginData::getNameByGuid(playerId);
+	}
+
+	// The id is picked here instead of by the database, the offer is usable before it is written
+	const auto id = market.nextOfferId++;
+	const auto created = static_cast<uint32_t>(getTimeNow());
+	market.addOffer(id, BookOffer { playerId, created, price, amount, static_cast<uint16_t>(itemId), tier, action, anonymous, std::move(playerName) });
+
+	DBStatement query("INSERT INTO `market_offers` (`id`, `player_id`, `sale`, `itemtype`, `amount`, `created`, `anonymous`, `price`, `tier`) VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?)");
+	query.bind(id).bind(playerId).bind(action).bind(itemId).bind(amount).bind(created).bind(anonymous).bind(price).bind(tier);
+	market.queueWrite(std::move(query));
 }
 
 void IOMarket::acceptOffer(uint32_t offerId, uint16_t amount) {
-	std::ostringstream query;
-	query << "UPDATE `market_offers` SET `amount` = `amount` - " << amount << " WHERE `id` = " << offerId;
-	Database::getInstance().executeQuery(query.str());
+	auto &market = getInstance();
+	auto it = market.offers.find(offerId);
+	if (it == market.offers.end()) {
+		return;
+	}
+
+	it->second.amount -= std::min(amount, it->second.amount);
+
+	DBStatement query("UPDATE `market_offers` SET `amount` = `amount` - ? WHERE `id` = ?");
+	query.bind(amount).bind(offerId);
+	market.queueWrite(std::move(query));
 }
 
 void IOMarket::deleteOffer(uint32_t offerId) {
-	std::ostringstream query;
-	query << "DELETE FROM `market_offers` WHERE `id` = " << offerId;
-	Database::getInstance().executeQuery(query.str());
+	auto &market = getInstance();
+	market.eraseOffer(offerId);
+
+	DBStatement query("DELETE FROM `market_offers` WHERE `id` = ?");
+	query.bind(offerId);
+	market.queueWrite(std::move(query));
 }
 
 void IOMarket::appendHistory(uint32_t playerId, MarketAction_t type, uint16_t itemId, uint16_t amount, uint64_t price, time_t timestamp, uint8_t tier, MarketOfferState_t state) {
-	std::ostringstream query;
-	query << "INSERT INTO `market_history` (`player_id`, `sale`, `itemtype`, `amount`, `price`, `expires_at`, `inserted`, `state`, `tier`) VALUES ("
-		  << playerId << ',' << type << ',' << itemId << ',' << amount << ',' << price << ','
-		  << timestamp << ',' << getTimeNow() << ',' << state << ',' << std::to_string(tier) << ')';
-	g_databaseTasks().execute(query.str());
+	if (state == OFFERSTATE_ACCEPTED) {
+		getInstance().addStatistics(type, itemId, tier, price);
+	}
+
+	DBStatement query("INSERT INTO `market_history` (`player_id`, `sale`, `itemtype`, `amount`, `price`, `expires_at`, `inserted`, `state`, `tier`) VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?)");
+	query.bind(playerId).bind(type).bind(itemId).bind(amount).bind(price).bind(timestamp).bind(getTimeNow()).bind(state).bind(tier);
+	g_databaseTasks().execute(std::move(query));
 }
 
 bool IOMarket::moveOfferToHistory(uint32_t offerId, MarketOfferState_t state) {
-	Database &db = Database::getInstance();
-
-	std::ostringstream query;
-	query << "SELECT `player_id`, `sale`, `itemtype`, `amount`, `price`, `created`, `tier` FROM `market_offers` WHERE `id` = " << offerId;
-
-	DBResult_ptr result = db.storeQuery(query.str());
-	if (!result) {
-		return false;
+	auto &market = getInstance();
+	if (!market.offersLoaded) {
+		market.loadOffers();
 	}
 
-	query.str(std::string());
-	query << "DELETE FROM `market_offers` WHERE `id` = " << offerId;
-	if (!db.executeQuery(query.str())) {
+	auto it = market.offers.find(offerId);
+	if (it == market.offers.end()) {
 		return false;
 	}
 
-	appendHistory(
-		result->getNumber<uint32_t>("player_id"),
-		static_cast<MarketAction_t>(result->getNumber<uint16_t>("sale")),
-		result->getNumber<uint16_t>("itemtype"),
-		result->getNumber<uint16_t>("amount"),
-		result->getNumber<uint64_t>("price"),
-		getTimeNow(),
-		getTierFromDatabaseTable(result->getString("tier")), state
-	);
+	const auto &offer = it->second;
+	appendHistory(offer.playerId, offer.type, offer.itemId, offer.amount, offer.price, getTimeNow(), offer.tier, state);
+	deleteOffer(offerId);
 	return true;
 }
 
+void IOMarket::queueWrite(DBStatement statement) {
+	pendingWrites.emplace_back(std::move(statement));
+	if (pendingWrites.size() == 1) {
+		// Everything queued until the next dispatcher cycle goes in the same batch
+		g_dispatcher().addEvent([] { getInstance().writeBatch(); }, "IOMarket::writeBatch");
+	}
+}
+
+void IOMarket::writeBatch() {
+	// A single batch at a time keeps the statements in order, the next one is sent when it finishes
+	if (pendingWrites.empty() || writing.exchange(true)) {
+		return;
+	}
+
+	inject<ThreadPool>().detachTask(ThreadLane::Database, [this, batch = std::move(pendingWrites)] {
+		DBTransaction::executeWithinTransaction([&batch] {
+			for (const auto &statement : batch) {
+				if (!g_database().executeQuery(statement)) {
+					g_logger().error("[IOMarket::writeBatch] - Failed to write a market offer change");
+				}
+			}
+			return true;
+		});
+
+		writing = false;
+		writing.notify_all();
+		g_dispatcher().addEvent([] { getInstance().writeBatch(); }, "IOMarket::writeBatch");
+	});
+	pendingWrites.clear();
+}
+
+void IOMarket::flushWrites() {
+	writing.wait(true);
+	for (const auto &statement : pendingWrites) {
+		g_database().executeQuery(statement);
+	}
+	pendingWrites.clear();
+}
+
+void IOMarket::addStatistics(MarketAction_t type, uint16_t itemId, uint8_t tier, uint64_t price) {
+	if (!statisticsLoaded) {
+		return;
+	}
+
+	auto &statistics = type == MARKETACTION_BUY ? purchaseStatistics[itemId][tier] : saleStatistics[itemId][tier];
+	if (statistics.numTransactions == 0 || price < statistics.lowestPrice) {
+		statistics.lowestPrice = price;
+	}
+	statistics.highestPrice = std::max(statistics.highestPrice, price);
+	statistics.totalPrice += price;
+	++statistics.numTransactions;
+}
+
 void IOMarket::updateStatistics() {
+	// Read from the history once, appendHistory keeps them up to date afterwards
+	if (statisticsLoaded) {
+		return;
+	}
+	statisticsLoaded = true;
+
 	auto query = fmt::format(
 		"SELECT sale, itemtype, COUNT(price) AS num, MIN(price) AS min, MAX(price) AS max, SUM(price) AS sum, tier "
 		"FROM market_history "
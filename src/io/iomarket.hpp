@@ -26,7 +26,6 @@ public:
 	static MarketOfferList getOwnOffers(MarketAction_t action, uint32_t playerId);
 	static HistoryMarketOfferList getOwnHistory(MarketAction_t action, uint32_t playerId);
 
-	static void processExpiredOffers(DBResult_ptr result, bool);
 	static void checkExpiredOffers();
 
 	static uint32_t getPlayerOfferCount(uint32_t playerId);
@@ -41,6 +40,11 @@ public:
 
 	void updateStatistics();
 
+	/**
+	 * Writes the offer changes still queued, on the calling thread, after the batch being written finishes.
+	 */
+	void flushWrites();
+
 	using StatisticsMap = std::map<uint16_t, std::map<uint8_t, MarketStatistics>>;
 	const StatisticsMap &getPurchaseStatistics() const {
 		return purchaseStatistics;
@@ -52,6 +56,58 @@ public:
 	static uint8_t getTierFromDatabaseTable(const std::string &string);
 
 private:
+	/**
+	 * The active offers are kept in memory, read from market_offers on first use.
+	 * Changes are applied here and queued as statements, written in order by one batch at a time
+	 * on the database lane, so browsing the market never waits on the database.
+	 */
+	struct BookOffer {
+		uint32_t playerId;
+		uint32_t created;
+		uint64_t price;
+		uint16_t amount;
+		uint16_t itemId;
+		uint8_t tier;
+		MarketAction_t type;
+		bool anonymous;
+		std::string playerName;
+	};
+
+	// Offers of one item, tier and side, sorted by price, then by id
+	using PriceLevels = std::set<std::pair<uint64_t, uint32_t>>;
+
+	static uint32_t getBookKey(uint16_t itemId, uint8_t tier, MarketAction_t action) {
+		return (static_cast<uint32_t>(itemId) << 16) | (static_cast<uint32_t>(tier) << 8) | static_cast<uint32_t>(action);
+	}
+
+	static uint64_t getCounterKey(uint32_t created, uint16_t counter) {
+		return (static_cast<uint64_t>(created) << 16) | counter;
+	}
+
+	static MarketOffer toMarketOffer(uint32_t id, const BookOffer &offer, int32_t offerDuration, bool withName);
+	static MarketOfferEx toMarketOfferEx(uint32_t id, const BookOffer &offer);
+	static void processExpiredOffer(const MarketOfferEx &offer);
+
+	void loadOffers();
+	void addOffer(uint32_t id, BookOffer offer);
+	void eraseOffer(uint32_t id);
+	void addStatistics(MarketAction_t type, uint16_t itemId, uint8_t tier, uint64_t price);
+
+	void queueWrite(DBStatement statement);
+	void writeBatch();
+
+	bool offersLoaded = false;
+	uint32_t nextOfferId = 1;
+	phmap::flat_hash_map<uint32_t, BookOffer> offers;
+	phmap::flat_hash_map<uint32_t, PriceLevels> books;
+	phmap::flat_hash_map<uint32_t, phmap::flat_hash_set<uint32_t>> playerOffers;
+	// created and counter (the low 16 bits of the id) are how the client refers to an offer
+	phmap::flat_hash_map<uint64_t, uint32_t> counterIndex;
+
+	std::vector<DBStatement> pendingWrites;
+	std::atomic_bool writing = false;
+
+	bool statisticsLoaded = false;
 	// [uint16_t = item id, [uint8_t = item tier, MarketStatistics = structure of the statistics]]
 	StatisticsMap purchaseStatistics;
 	StatisticsMap saleStatistics;
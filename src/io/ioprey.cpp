@@ -60,72 +60,7 @@ void PreySlot::reloadMonsterGrid(std::vector<uint16_t> blackList, uint32_t level
 		return;
 	}
 
-	// Disabling prey system if the server have less then 36 registered monsters on bestiary because:
-	// - Impossible to generate random lists without duplications on slots.
-	// - Stress the server with unnecessary loops.
-	std::map<uint16_t, std::string> bestiary = g_game().getBestiaryList();
-	if (bestiary.size() < 36) {
-		return;
-	}
-
-	uint8_t stageOne;
-	uint8_t stageTwo;
-	uint8_t stageThree;
-	uint8_t stageFour;
-	if (auto levelStage = static_cast<uint32_t>(std::floor(level / 100));
-	    levelStage == 0) { // From level 0 to 99
-		stageOne = 3;
-		stageTwo = 3;
-		stageThree = 2;
-		stageFour = 1;
-	} else if (levelStage <= 2) { // From level 100 to 299
-		stageOne = 1;
-		stageTwo = 3;
-		stageThree = 3;
-		stageFour = 2;
-	} else if (levelStage <= 4) { // From level 300 to 499
-		stageOne = 1;
-		stageTwo = 2;
-		stageThree = 3;
-		stageFour = 3;
-	} else { // From level 500 to ...
-		stageOne = 1;
-		stageTwo = 1;
-		stageThree = 3;
-		stageFour = 4;
-	}
-
-	uint8_t tries = 0;
-	auto maxIndex = static_cast<int32_t>(bestiary.size() - 1);
-	while (raceIdList.size() < 9) {
-		uint16_t raceId = (*(std::next(bestiary.begin(), uniform_random(0, maxIndex)))).first;
-		tries++;
-
-		if (std::count(blackList.begin(), blackList.end(), raceId) != 0) {
-			continue;
-		}
-
-		blackList.push_back(raceId);
-		const auto mtype = g_monsters().getMonsterTypeByRaceId(raceId);
-		if (!mtype || mtype->info.experience == 0 || !mtype->info.isPreyable || mtype->info.isPreyExclusive) {
-			continue;
-		} else if (stageOne != 0 && mtype->info.bestiaryStars <= 1) {
-			raceIdList.push_back(raceId);
-			--stageOne;
-		} else if (stageTwo != 0 && mtype->info.bestiaryStars == 2) {
-			raceIdList.push_back(raceId);
-			--stageTwo;
-		} else if (stageThree != 0 && mtype->info.bestiaryStars == 3) {
-			raceIdList.push_back(raceId);
-			--stageThree;
-		} else if (stageFour != 0 && mtype->info.bestiaryStars >= 4) {
-			raceIdList.push_back(raceId);
-			--stageFour;
-		} else if (tries >= 10) {
-			raceIdList.push_back(raceId);
-			tries = 0;
-		}
-	}
+	raceIdList = g_ioprey().getMonsterGrid(std::move(blackList), level);
 }
 
 // Task hunting class
@@ -141,72 +76,7 @@ void TaskHuntingSlot::reloadMonsterGrid(std::vector<uint16_t> blackList, uint32_
 		return;
 	}
 
-	// Disabling task hunting system if the server have less then 36 registered monsters on bestiary because:
-	// - Impossible to generate random lists without duplications on slots.
-	// - Stress the server with unnecessary loops.
-	std::map<uint16_t, std::string> bestiary = g_game().getBestiaryList();
-	if (bestiary.size() < 36) {
-		return;
-	}
-
-	uint8_t stageOne;
-	uint8_t stageTwo;
-	uint8_t stageThree;
-	uint8_t stageFour;
-	if (auto levelStage = static_cast<uint32_t>(std::floor(level / 100));
-	    levelStage == 0) { // From level 0 to 99
-		stageOne = 3;
-		stageTwo = 3;
-		stageThree = 2;
-		stageFour = 1;
-	} else if (levelStage <= 2) { // From level 100 to 299
-		stageOne = 1;
-		stageTwo = 3;
-		stageThree = 3;
-		stageFour = 2;
-	} else if (levelStage <= 4) { // From level 300 to 499
-		stageOne = 1;
-		stageTwo = 2;
-		stageThree = 3;
-		stageFour = 3;
-	} else { // From level 500 to ...
-		stageOne = 1;
-		stageTwo = 1;
-		stageThree = 3;
-		stageFour = 4;
-	}
-
-	uint8_t tries = 0;
-	auto maxIndex = static_cast<int32_t>(bestiary.size() - 1);
-	while (raceIdList.size() < 9) {
-		uint16_t raceId = (*(std::next(bestiary.begin(), uniform_random(0, maxIndex)))).first;
-		tries++;
-
-		if (std::count(blackList.begin(), blackList.end(), raceId) != 0) {
-			continue;
-		}
-
-		blackList.push_back(raceId);
-		const auto mtype = g_monsters().getMonsterTypeByRaceId(raceId);
-		if (!mtype || mtype->info.experience == 0 || !mtype->info.isPreyable || mtype->info.isPreyExclusive) {
-			continue;
-		} else if (stageOne != 0 && mtype->info.bestiaryStars <= 1) {
-			raceIdList.push_back(raceId);
-			--stageOne;
-		} else if (stageTwo != 0 && mtype->info.bestiaryStars == 2) {
-			raceIdList.push_back(raceId);
-			--stageTwo;
-		} else if (stageThree != 0 && mtype->info.bestiaryStars == 3) {
-			raceIdList.push_back(raceId);
-			--stageThree;
-		} else if (stageFour != 0 && mtype->info.bestiaryStars >= 4) {
-			raceIdList.push_back(raceId);
-			--stageFour;
-		} else if (tries >= 10) {
-			raceIdList.push_back(raceId);
-			tries = 0;
-		}
-	}
+	raceIdList = g_ioprey().getMonsterGrid(std::move(blackList), level);
 }
 
 void TaskHuntingSlot::reloadReward() {
@@ -532,6 +402,75 @@ void IOPrey::parseTaskHuntingAction(std::shared_ptr<Player> player, PreySlot_t s
 	player->reloadTaskSlot(slotId);
 }
 
+void IOPrey::reloadMonsterCandidates() {
+	for (auto &candidates : monsterCandidates) {
+		candidates.clear();
+	}
+
+	for (const auto &[raceId, name] : g_game().getBestiaryList()) {
+		const auto mtype = g_monsters().getMonsterType(name);
+		if (!mtype || mtype->info.experience == 0 || !mtype->info.isPreyable || mtype->info.isPreyExclusive) {
+			continue;
+		}
+		monsterCandidates[std::clamp<uint8_t>(mtype->info.bestiaryStars, 1, 4) - 1].push_back(raceId);
+	}
+}
+
+std::vector<uint16_t> IOPrey::getMonsterGrid(std::vector<uint16_t> blackList, uint32_t level) const {
+	std::vector<uint16_t> grid;
+
+	// Disabling prey system if the server have less then 36 registered monsters on bestiary because:
+	// - Impossible to generate random lists without duplications on slots.
+	// - Stress the server with unnecessary loops.
+	if (g_game().getBestiaryList().size() < 36) {
+		return grid;
+	}
+
+	// How many monsters of each bestiary stars (1 or less, 2, 3, 4 or more) the level gets
+	std::array<uint8_t, 4> stages;
+	if (auto levelStage = level / 100;
+	    levelStage == 0) { // From level 0 to 99
+		stages = { 3, 3, 2, 1 };
+	} else if (levelStage <= 2) { // From level 100 to 299
+		stages = { 1, 3, 3, 2 };
+	} else if (levelStage <= 4) { // From level 300 to 499
+		stages = { 1, 2, 3, 3 };
+	} else { // From level 500 to ...
+		stages = { 1, 1, 3, 4 };
+	}
+
+	const auto isFree = [&blackList](uint16_t raceId) {
+		return std::ranges::find(blackList, raceId) == blackList.end();
+	};
+	grid.reserve(9);
+	for (size_t stars = 0; stars < stages.size(); ++stars) {
+		const auto &candidates = monsterCandidates[stars];
+		uint8_t tries = 0;
+		for (uint8_t picked = 0; picked < stages[stars] && !candidates.empty() && tries < 10 * stages[stars]; ++tries) {
+			const uint16_t raceId = candidates[uniform_random(0, static_cast<int32_t>(candidates.size()) - 1)];
+			if (isFree(raceId)) {
+				blackList.push_back(raceId);
+				grid.push_back(raceId);
+				++picked;
+			}
+		}
+	}
+
+	// The stars that ran short are made up with any other monster
+	if (grid.size() < 9) {
+		std::vector<uint16_t> others;
+		for (const auto &candidates : monsterCandidates) {
+			std::ranges::copy_if(candidates, std::back_inserter(others), isFree);
+		}
+		std::ranges::shuffle(others, getRandomGenerator());
+		others.resize(std::min<size_t>(others.size(), 9 - grid.size()));
+		grid.insert(grid.end(), others.begin(), others.end());
+	}
+
+	std::ranges::shuffle(grid, getRandomGenerator());
+	return grid;
+}
+
 void IOPrey::initializeTaskHuntOptions() {
 	if (!g_configManager().getBoolean(TASK_HUNTING_ENABLED, __FUNCTION__)) {
 		return;
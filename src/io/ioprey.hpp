@@ -230,6 +230,14 @@ public:
 
 	void parseTaskHuntingAction(std::shared_ptr<Player> player, PreySlot_t slotId, PreyTaskAction_t action, bool upgrade, uint16_t raceId) const;
 
+	/**
+	 * Sorts the preyable monsters of the bestiary by their stars, called when the monsters are loaded or reloaded.
+	 * The prey and task hunting lists are picked from them without looking any monster type up.
+	 */
+	void reloadMonsterCandidates();
+	// Nine races for a prey or task hunting list of a player of the level, none of the black list
+	std::vector<uint16_t> getMonsterGrid(std::vector<uint16_t> blackList, uint32_t level) const;
+
 	void initializeTaskHuntOptions();
 	const std::unique_ptr<TaskHuntingOption> &getTaskRewardOption(const std::unique_ptr<TaskHuntingSlot> &slot) const;
 
@@ -239,6 +247,9 @@ public:
 
 	NetworkMessage baseDataMessage;
 	std::vector<std::unique_ptr<TaskHuntingOption>> taskOption;
+
+private:
+	std::array<std::vector<uint16_t>, 4> monsterCandidates;
 };
 
 constexpr auto g_ioprey = IOPrey::getInstance;
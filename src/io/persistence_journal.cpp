@@ -0,0 +1,274 @@
+/**
+ * Canary - A free and open-source MMORPG server emulator
+ * Copyright (©) 2019-2024 OpenTibiaBR <opentibiabr@outlook.com>
+ * Repository: https://github.com/opentibiabr/canary
+ * License: https://github.com/opentibiabr/canary/blob/main/LICENSE
+ * Contributors: https://github.com/opentibiabr/canary/graphs/contributors
+ * Website: https://docs.opentibiabr.com/
+ */
+
+#include "pch.hpp"
+
+#include "io/persistence_journal.hpp"
+#include "database/database.hpp"
+
+namespace {
+	// FNV-1a, detects the torn record at the end of the file a crash can leave
+	uint32_t checksum(std::string_view data) {
+		uint32_t hash = 2166136261u;
+		for (const auto c : data) {
+			hash = (hash ^ static_cast<uint8_t>(c)) * 16777619u;
+		}
+		return hash;
+	}
+
+	template <typename T>
+	void append(std::string &buffer, T value) {
+		buffer.append(reinterpret_cast<const char*>(&value), sizeof(T));
+	}
+
+	template <typename T>
+	bool read(std::string_view &data, T &value) {
+		if (data.size() < sizeof(T)) {
+			return false;
+		}
+		std::memcpy(&value, data.data(), sizeof(T));
+		data.remove_prefix(sizeof(T));
+		return true;
+	}
+}
+
+PersistenceJournal::~PersistenceJournal() {
+	if (file) {
+		std::fclose(file);
+	}
+}
+
+PersistenceJournal &PersistenceJournal::getInstance() {
+	return inject<PersistenceJournal>();
+}
+
+bool PersistenceJournal::open(const std::string &journalPath) {
+	std::scoped_lock lock(mutex);
+	path = journalPath;
+	if (std::ifstream input(path, std::ios::binary); input) {
+		replay(input);
+	}
+
+	if (!pending.empty()) {
+		std::vector<Record> records;
+		records.reserve(pending.size());
+		for (const auto &[owner, record] : pending) {
+			records.emplace_back(record);
+		}
+
+		g_logger().info("Replaying {} records of the persistence journal...", records.size());
+		if (!apply(std::move(records))) {
+			g_logger().error("[{}] - Failed to replay the persistence journal {}", __FUNCTION__, path);
+			pending.clear();
+			return false;
+		}
+		pending.clear();
+	}
+
+	return rewrite();
+}
+
+bool PersistenceJournal::isOpen() const {
+	std::scoped_lock lock(mutex);
+	return file != nullptr;
+}
+
+void PersistenceJournal::record(uint32_t owner, std::vector<std::string> queries) {
+	std::scoped_lock lock(mutex);
+	if (!file) {
+		return;
+	}
+
+	Record record { ++sequence, owner, std::move(queries) };
+	if (!write(RecordType::Record, record)) {
+		g_logger().error("[{}] - Failed to write to the persistence journal {}", __FUNCTION__, path);
+	}
+	pending[owner] = std::move(record);
+}
+
+uint64_t PersistenceJournal::getSequence() const {
+	std::scoped_lock lock(mutex);
+	return sequence;
+}
+
+void PersistenceJournal::settle(uint32_t owner, uint64_t settledSequence) {
+	std::scoped_lock lock(mutex);
+	if (!file) {
+		return;
+	}
+
+	if (auto it = pending.find(owner); it != pending.end() && it->second.sequence <= settledSequence) {
+		pending.erase(it);
+		write(RecordType::Settle, Record { settledSequence, owner });
+	}
+}
+
+std::vector<uint32_t> PersistenceJournal::getPendingOwners() const {
+	std::scoped_lock lock(mutex);
+	std::vector<uint32_t> owners;
+	owners.reserve(pending.size());
+	for (const auto &[owner, record] : pending) {
+		owners.emplace_back(owner);
+	}
+	return owners;
+}
+
+bool PersistenceJournal::compact() {
+	std::vector<Record> records;
+	{
+		std::scoped_lock lock(mutex);
+		if (!file) {
+			return true;
+		}
+		records.reserve(pending.size());
+		for (const auto &[owner, record] : pending) {
+			records.emplace_back(record);
+		}
+	}
+
+	// The database is written without holding the lock, records keep coming in meanwhile
+	std::vector<std::pair<uint32_t, uint64_t>> applied;
+	applied.reserve(records.size());
+	for (const auto &record : records) {
+		applied.emplace_back(record.owner, record.sequence);
+	}
+	if (!records.empty() && !apply(std::move(records))) {
+		return false;
+	}
+
+	std::scoped_lock lock(mutex);
+	for (const auto &[owner, appliedSequence] : applied) {
+		if (auto it = pending.find(owner); it != pending.end() && it->second.sequence == appliedSequence) {
+			pending.erase(it);
+		}
+	}
+	return rewrite();
+}
+
+bool PersistenceJournal::apply(std::vector<Record> records) {
+	std::ranges::sort(records, {}, &Record::sequence);
+	return DBTransaction::executeWithinTransaction([&records]() {
+		auto &db = Database::getInstance();
+		for (const auto &record : records) {
+			for (const auto &query : record.queries) {
+				if (!db.executeQuery(query)) {
+					// Rolls the whole replay back
+					throw DatabaseException(fmt::format("Failed to apply the journal record {} of owner {}", record.sequence, record.owner));
+				}
+			}
+		}
+		return true;
+	});
+}
+
+bool PersistenceJournal::write(RecordType type, const Record &record) {
+	// [size][checksum] then the type, sequence, owner and the queries, each one prefixed by its size
+	std::string payload;
+	append(payload, static_cast<uint8_t>(type));
+	append(payload, record.sequence);
+	append(payload, record.owner);
+	append(payload, static_cast<uint32_t>(record.queries.size()));
+	for (const auto &query : record.queries) {
+		append(payload, static_cast<uint32_t>(query.size()));
+		payload.append(query);
+	}
+
+	std::string frame;
+	frame.reserve(payload.size() + 8);
+	append(frame, static_cast<uint32_t>(payload.size()));
+	append(frame, checksum(payload));
+	frame.append(payload);
+
+	// Flushed to the kernel, so the record outlives a crash of the process
+	return std::fwrite(frame.data(), 1, frame.size(), file) == frame.size() && std::fflush(file) == 0;
+}
+
+bool PersistenceJournal::rewrite() {
+	if (file) {
+		std::fclose(file);
+		file = nullptr;
+	}
+
+	// The records still pending go to a new file, which replaces the old one only once complete
+	const auto temporaryPath = path + ".tmp";
+	file = std::fopen(temporaryPath.c_str(), "wb");
+	if (!file) {
+		g_logger().error("[{}] - Failed to create the persistence journal {}", __FUNCTION__, temporaryPath);
+		return false;
+	}
+
+	bool success = true;
+	for (const auto &[owner, record] : pending) {
+		success = success && write(RecordType::Record, record);
+	}
+	std::fclose(file);
+	file = nullptr;
+
+	std::error_code error;
+	if (success) {
+		std::filesystem::rename(temporaryPath, path, error);
+	}
+	if (!success || error) {
+		g_logger().error("[{}] - Failed to rewrite the persistence journal {}", __FUNCTION__, path);
+		std::filesystem::remove(temporaryPath, error);
+	}
+
+	file = std::fopen(path.c_str(), "ab");
+	if (!file) {
+		g_logger().error("[{}] - Failed to open the persistence journal {}", __FUNCTION__, path);
+		return false;
+	}
+	return success;
+}
+
+void PersistenceJournal::replay(std::ifstream &input) {
+	const std::string content { std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>() };
+	std::string_view data = content;
+	while (!data.empty()) {
+		uint32_t size = 0;
+		uint32_t expected = 0;
+		if (!read(data, size) || !read(data, expected) || data.size() < size || checksum(data.substr(0, size)) != expected) {
+			g_logger().warn("[{}] - Ignoring the incomplete end of the persistence journal {}", __FUNCTION__, path);
+			return;
+		}
+
+		auto payload = data.substr(0, size);
+		data.remove_prefix(size);
+
+		uint8_t type = 0;
+		uint32_t count = 0;
+		Record record;
+		if (!read(payload, type) || !read(payload, record.sequence) || !read(payload, record.owner) || !read(payload, count)) {
+			continue;
+		}
+		sequence = std::max(sequence, record.sequence);
+
+		if (static_cast<RecordType>(type) == RecordType::Settle) {
+			if (auto it = pending.find(record.owner); it != pending.end() && it->second.sequence <= record.sequence) {
+				pending.erase(it);
+			}
+			continue;
+		}
+
+		for (uint32_t i = 0; i < count; ++i) {
+			uint32_t length = 0;
+			if (!read(payload, length) || payload.size() < length) {
+				break;
+			}
+			record.queries.emplace_back(payload.substr(0, length));
+			payload.remove_prefix(length);
+		}
+		// A record is replayed whole or not at all
+		if (record.queries.size() != count) {
+			continue;
+		}
+		const auto owner = record.owner;
+		pending[owner] = std::move(record);
+	}
+}
@@ -0,0 +1,83 @@
+/**
+ * Canary - A free and open-source MMORPG server emulator
+ * Copyright (©) 2019-2024 OpenTibiaBR <opentibiabr@outlook.com>
+ * Repository: https://github.com/opentibiabr/canary
+ * License: https://github.com/opentibiabr/canary/blob/main/LICENSE
+ * Contributors: https://github.com/opentibiabr/canary/graphs/contributors
+ * Website: https://docs.opentibiabr.com/
+ */
+
+#pragma once
+
+#include "lib/di/container.hpp"
+
+/**
+ * Append-only file where critical player changes (bank balance, depot and inbox items) are written at once,
+ * as the queries that store them, while the player itself is only saved later.
+ * A record holds every row such a change moves value between (the balance, inventory, depot and inbox rows),
+ * so a replay never writes one side of a move without the other, and a newer record of the owner replaces it.
+ * A successful save of the player settles its record, SaveManager saves the players that still have one
+ * from time to time, and what a crash left unsettled is replayed into the database on the next startup.
+ */
+class PersistenceJournal {
+public:
+	PersistenceJournal() = default;
+	~PersistenceJournal();
+
+	// Non copyable
+	PersistenceJournal(const PersistenceJournal &) = delete;
+	PersistenceJournal &operator=(const PersistenceJournal &) = delete;
+
+	static PersistenceJournal &getInstance();
+
+	/**
+	 * Replays the records a previous run left unsettled, then starts an empty journal at path.
+	 * @return false if they could not be written to the database, the file is left as it is then.
+	 */
+	bool open(const std::string &path);
+
+	bool isOpen() const;
+
+	// Replaces the pending record of the owner, the queries must be idempotent
+	void record(uint32_t owner, std::vector<std::string> queries);
+
+	// A save that starts after reading it covers every record up to this sequence
+	uint64_t getSequence() const;
+
+	// Drops the records of the owner up to sequence, once its save is committed
+	void settle(uint32_t owner, uint64_t sequence);
+
+	std::vector<uint32_t> getPendingOwners() const;
+
+	/**
+	 * Writes the pending records to the database and rewrites the file with the ones recorded meanwhile.
+	 */
+	bool compact();
+
+private:
+	enum class RecordType : uint8_t {
+		Record,
+		Settle,
+	};
+
+	struct Record {
+		uint64_t sequence = 0;
+		uint32_t owner = 0;
+		std::vector<std::string> queries;
+	};
+
+	// Runs the queries of the records in sequence order, in one transaction
+	static bool apply(std::vector<Record> records);
+
+	bool write(RecordType type, const Record &record);
+	bool rewrite();
+	void replay(std::ifstream &input);
+
+	mutable std::mutex mutex;
+	std::string path;
+	std::FILE* file = nullptr;
+	uint64_t sequence = 0;
+	std::map<uint32_t, Record> pending;
+};
+
+constexpr auto g_persistenceJournal = PersistenceJournal::getInstance;
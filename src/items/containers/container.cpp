@@ -38,21 +38,22 @@ Container::Container(uint16_t initType, uint16_t initSize, bool initUnlocked /*=
 	pagination(initPagination) { }
 
 std::shared_ptr<Container> Container::create(uint16_t type) {
-	return std::make_shared<Container>(type);
+	return makeItemShared<Container>(type);
 }
 
 std::shared_ptr<Container> Container::create(uint16_t type, uint16_t size, bool unlocked /*= true*/, bool pagination /*= false*/) {
-	return std::make_shared<Container>(type, size, unlocked, pagination);
+	return makeItemShared<Container>(type, size, unlocked, pagination);
 }
 
 std::shared_ptr<Container> Container::create(std::shared_ptr<Tile> tile) {
-	auto container = std::make_shared<Container>(ITEM_BROWSEFIELD, 30, false, true);
+	auto container = makeItemShared<Container>(ITEM_BROWSEFIELD, 30, false, true);
 	TileItemVector* itemVector = tile->getItemList();
 	if (itemVector) {
 		for (auto &item : *itemVector) {
 			if (((item->getContainer() || item->hasProperty(CONST_PROP_MOVABLE)) || (item->isWrapable() && !item->hasProperty(CONST_PROP_MOVABLE) && !item->hasProperty(CONST_PROP_BLOCKPATH))) && !item->hasAttribute(ItemAttribute_t::UNIQUEID)) {
 				container->itemlist.push_front(item);
 				item->setParent(container);
+				container->updateContentCounts(item, 1);
 			}
 		}
 	}
@@ -126,6 +127,7 @@ bool Container::hasParent() {
 void Container::addItem(std::shared_ptr<Item> item) {
 	itemlist.push_back(item);
 	item->setParent(getContainer());
+	updateContentCounts(item, 1);
 }
 
 StashContainerList Container::getStowableItems() const {
@@ -213,6 +215,26 @@ void Container::updateItemWeight(int32_t diff) {
 	}
 }
 
+void Container::updateContentCount(uint16_t itemId, int32_t items, int32_t amount) {
+	for (auto container = getContainer(); container; container = container->getParentContainer()) {
+		auto &count = container->contentCounts[itemId];
+		count.items += items;
+		count.amount += amount;
+		if (count.items == 0) {
+			container->contentCounts.erase(itemId);
+		}
+	}
+}
+
+void Container::updateContentCounts(const std::shared_ptr<Item> &item, int32_t sign) {
+	updateContentCount(item->getID(), sign, sign * item->getItemCount());
+	if (const auto &container = item->getContainer()) {
+		for (const auto &[itemId, count] : container->contentCounts) {
+			updateContentCount(itemId, sign * static_cast<int32_t>(count.items), sign * static_cast<int32_t>(count.amount));
+		}
+	}
+}
+
 uint32_t Container::getWeight() const {
 	return Item::getWeight() + totalWeight;
 }
@@ -366,13 +388,7 @@ bool Container::isHoldingItem(std::shared_ptr<Item> item) {
 }
 
 bool Container::isHoldingItemWithId(const uint16_t id) {
-	for (ContainerIterator it = iterator(); it.hasNext(); it.advance()) {
-		std::shared_ptr<Item> item = *it;
-		if (item->getID() == id) {
-			return true;
-		}
-	}
-	return false;
+	return contentCounts.contains(id);
 }
 
 bool Container::isInsideContainerWithId(const uint16_t id) {
@@ -399,6 +415,8 @@ bool Container::isBrowseFieldAndHoldsRewardChest() {
 }
 
 void Container::onAddContainerItem(std::shared_ptr<Item> item) {
+	markHouseItemsDirty();
+
 	auto spectators = Spectators().find<Player>(getPosition(), false, 2, 2, 2, 2);
 
 	// send to client
@@ -413,6 +431,8 @@ void Container::onAddContainerItem(std::shared_ptr<Item> item) {
 }
 
 void Container::onUpdateContainerItem(uint32_t index, std::shared_ptr<Item> oldItem, std::shared_ptr<Item> newItem) {
+	markHouseItemsDirty();
+
 	auto spectators = Spectators().find<Player>(getPosition(), false, 2, 2, 2, 2);
 
 	// send to client
@@ -427,6 +447,8 @@ void Container::onUpdateContainerItem(uint32_t index, std::shared_ptr<Item> oldI
 }
 
 void Container::onRemoveContainerItem(uint32_t index, std::shared_ptr<Item> item) {
+	markHouseItemsDirty();
+
 	auto spectators = Spectators().find<Player>(getPosition(), false, 2, 2, 2, 2);
 
 	// send change to client
@@ -700,6 +722,7 @@ void Container::addThing(int32_t index, std::shared_ptr<Thing> thing) {
 	item->setParent(getContainer());
 	itemlist.push_front(item);
 	updateItemWeight(item->getWeight());
+	updateContentCounts(item, 1);
 
 	// send change to client
 	if (getParent() && (getParent() != VirtualCylinder::virtualCylinder)) {
@@ -750,9 +773,11 @@ void Container::replaceThing(uint32_t index, std::shared_ptr<Thing> thing) {
 		return /*RETURNVALUE_NOTPOSSIBLE*/;
 	}
 
+	updateContentCounts(replacedItem, -1);
 	itemlist[index] = item;
 	item->setParent(getContainer());
 	updateItemWeight(-static_cast<int32_t>(replacedItem->getWeight()) + item->getWeight());
+	updateContentCounts(item, 1);
 
 	// send change to client
 	if (getParent()) {
@@ -791,6 +816,7 @@ void Container::removeThing(std::shared_ptr<Thing> thing, uint32_t count) {
 			onRemoveContainerItem(index, item);
 		}
 
+		updateContentCounts(item, -1);
 		item->resetParent();
 		itemlist.erase(itemlist.begin() + index);
 	}
@@ -895,6 +921,7 @@ void Container::internalAddThing(uint32_t, std::shared_ptr<Thing> thing) {
 	item->setParent(getContainer());
 	itemlist.push_front(item);
 	updateItemWeight(item->getWeight());
+	updateContentCounts(item, 1);
 }
 
 void Container::startDecaying() {
@@ -949,6 +976,7 @@ void Container::removeItem(std::shared_ptr<Thing> thing, bool sendUpdateToClient
 			onRemoveContainerItem(thingIndex, itemToRemove);
 		}
 
+		updateContentCounts(itemToRemove, -1);
 		itemlist.erase(it);
 		itemToRemove->resetParent();
 	}
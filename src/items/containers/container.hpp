@@ -125,6 +125,46 @@ public:
 	bool isHoldingItem(std::shared_ptr<Item> item);
 	bool isHoldingItemWithId(const uint16_t id);
 
+	/**
+	 * @return the summed count of the items with the id inside the container, nested containers included.
+	 * Kept up to date on every add and remove, so it does not walk the content.
+	 */
+	uint32_t getContentItemCount(uint16_t itemId) const {
+		const auto it = contentCounts.find(itemId);
+		return it != contentCounts.end() ? it->second.amount : 0;
+	}
+	// Calls f(itemId, amount) for every item id inside the container, nested containers included
+	template <typename F>
+	void forEachContentItemCount(F &&f) const {
+		for (const auto &[itemId, count] : contentCounts) {
+			f(itemId, count.amount);
+		}
+	}
+	/**
+	 * Calls f(item) for the items with the id inside the container, nested containers included, in the order of iterator().
+	 * It only walks into the containers that hold one, so it costs the path to them and not the whole content.
+	 */
+	template <typename F>
+	void forEachContentItem(uint16_t itemId, F &&f) {
+		if (getContentItemCount(itemId) == 0) {
+			return;
+		}
+
+		std::vector<std::shared_ptr<Container>> containers { static_self_cast<Container>() };
+		for (size_t i = 0; i < containers.size(); ++i) {
+			for (const auto &item : containers[i]->itemlist) {
+				if (item->getID() == itemId) {
+					f(item);
+				}
+				if (const auto &container = item->getContainer(); container && container->getContentItemCount(itemId) > 0) {
+					containers.emplace_back(container);
+				}
+			}
+		}
+	}
+	// Called by the items of this container when their id or count changes in place
+	void updateContentCount(uint16_t itemId, int32_t items, int32_t amount);
+
 	uint32_t getItemHoldingCount();
 	uint32_t getContainerHoldingCount();
 	uint16_t getFreeSlots();
@@ -187,6 +227,9 @@ protected:
 	ItemDeque itemlist;
 	uint32_t serializationCount = 0;
 
+	// Adds (sign 1) or removes (sign -1) the item and its whole content from the content counts
+	void updateContentCounts(const std::shared_ptr<Item> &item, int32_t sign);
+
 	bool unlocked;
 	bool pagination;
 
@@ -201,6 +244,13 @@ private:
 	std::shared_ptr<Container> getTopParentContainer();
 	void updateItemWeight(int32_t diff);
 
+	struct ContentCount {
+		uint32_t items = 0;
+		uint32_t amount = 0;
+	};
+	// Every item inside, nested containers included, by id
+	phmap::flat_hash_map<uint16_t, ContentCount> contentCounts;
+
 	friend class ContainerIterator;
 	friend class IOMapSerialize;
 };
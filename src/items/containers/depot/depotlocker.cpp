@@ -47,5 +47,6 @@ void DepotLocker::removeInbox(std::shared_ptr<Inbox> inbox) {
 	if (cit == itemlist.end()) {
 		return;
 	}
+	updateContentCounts(inbox, -1);
 	itemlist.erase(cit);
 }
@@ -14,6 +14,7 @@
 #include "lib/di/container.hpp"
 #include "game/game.hpp"
 #include "game/scheduling/dispatcher.hpp"
+#include "game/scheduling/frame_profiler.hpp"
 
 Decay &Decay::getInstance() {
 	return inject<Decay>();
@@ -45,63 +46,33 @@ void Decay::startDecay(std::shared_ptr<Item> item) {
 			stopDecay(item);
 		}
 
-		int64_t timestamp = OTSYS_TIME() + duration;
-		if (decayMap.empty()) {
-			eventId = g_dispatcher().scheduleEvent(
-				std::max<int32_t>(SCHEDULER_MINTICKS, duration), [this] { checkDecay(); }, "Decay::checkDecay"
+		const int64_t now = OTSYS_TIME();
+		if (!started) {
+			started = true;
+			wheel.setNextTick(now / TICK_MS);
+			g_dispatcher().cycleEvent(
+				TICK_MS, [this] { checkDecay(); }, "Decay::checkDecay"
 			);
-		} else {
-			if (timestamp < decayMap.begin()->first) {
-				g_dispatcher().stopEvent(eventId);
-				eventId = g_dispatcher().scheduleEvent(
-					std::max<int32_t>(SCHEDULER_MINTICKS, duration), [this] { checkDecay(); }, "Decay::checkDecay"
-				);
-			}
 		}
 
+		int64_t timestamp = now + duration;
 		item->setDecaying(DECAYING_TRUE);
 		item->setAttribute(ItemAttribute_t::DURATION_TIMESTAMP, timestamp);
-		decayMap[timestamp].push_back(item);
+		wheel.schedule(item, ItemDueTick {}(item));
 	}
 }
 
 void Decay::stopDecay(std::shared_ptr<Item> item) {
 	if (item->hasAttribute(ItemAttribute_t::DECAYSTATE)) {
-		auto timestamp = item->getAttribute<int64_t>(ItemAttribute_t::DURATION_TIMESTAMP);
 		if (item->hasAttribute(ItemAttribute_t::DURATION_TIMESTAMP)) {
-			auto it = decayMap.find(timestamp);
-			if (it != decayMap.end()) {
-				auto &decayItems = it->second;
-
-				size_t i = 0, end = decayItems.size();
-				auto decayItem = decayItems[i];
-				if (end == 1) {
-					if (item == decayItem) {
-						if (item->hasAttribute(ItemAttribute_t::DURATION)) {
-							// Incase we removed duration attribute don't assign new duration
-							item->setDuration(item->getDuration());
-						}
-						item->removeAttribute(ItemAttribute_t::DECAYSTATE);
-
-						decayMap.erase(it);
-					}
-					return;
-				}
-				while (i < end) {
-					decayItem = decayItems[i];
-					if (item == decayItem) {
-						if (item->hasAttribute(ItemAttribute_t::DURATION)) {
-							// Incase we removed duration attribute don't assign new duration
-							item->setDuration(item->getDuration());
-						}
-						item->removeAttribute(ItemAttribute_t::DECAYSTATE);
-
-						decayItems[i] = decayItems.back();
-						decayItems.pop_back();
-						return;
-					}
-					++i;
+			if (item->decayBucket != Wheel::NO_BUCKET) {
+				if (item->hasAttribute(ItemAttribute_t::DURATION)) {
+					// Incase we removed duration attribute don't assign new duration
+					item->setDuration(item->getDuration());
 				}
+				item->removeAttribute(ItemAttribute_t::DECAYSTATE);
+				wheel.unschedule(item);
+				return;
 			}
 			item->removeAttribute(ItemAttribute_t::DURATION_TIMESTAMP);
 		} else {
@@ -110,26 +81,17 @@ void Decay::stopDecay(std::shared_ptr<Item> item) {
 	}
 }
 
+int64_t Decay::ItemDueTick::operator()(const std::shared_ptr<Item> &item) const {
+	const auto timestamp = item->getAttribute<int64_t>(ItemAttribute_t::DURATION_TIMESTAMP);
+	return (timestamp + TICK_MS - 1) / TICK_MS;
+}
+
 void Decay::checkDecay() {
-	int64_t timestamp = OTSYS_TIME();
+	FrameScope scope(FramePhase::Decay);
 
+	// Decaying an item may start or stop other decays, so the due items are taken out of the wheel first
 	std::vector<std::shared_ptr<Item>> tempItems;
-	tempItems.reserve(32); // Small preallocation
-
-	auto it = decayMap.begin(), end = decayMap.end();
-	while (it != end) {
-		if (it->first > timestamp) {
-			break;
-		}
-
-		// Iterating here is unsafe so let's copy our items into temporary vector
-		auto &decayItems = it->second;
-		tempItems.reserve(tempItems.size() + decayItems.size());
-		for (auto &decayItem : decayItems) {
-			tempItems.push_back(decayItem);
-		}
-		it = decayMap.erase(it);
-	}
+	wheel.expire(OTSYS_TIME() / TICK_MS, tempItems);
 
 	for (const auto &item : tempItems) {
 		if (!item->canDecay()) {
@@ -140,12 +102,6 @@ void Decay::checkDecay() {
 			internalDecayItem(item);
 		}
 	}
-
-	if (it != end) {
-		eventId = g_dispatcher().scheduleEvent(
-			std::max<int32_t>(SCHEDULER_MINTICKS, static_cast<int32_t>(it->first - timestamp)), [this] { checkDecay(); }, "Decay::checkDecay"
-		);
-	}
 }
 
 void Decay::internalDecayItem(std::shared_ptr<Item> item) {
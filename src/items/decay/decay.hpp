@@ -9,8 +9,14 @@
 
 #pragma once
 
+#include "items/decay/decay_wheel.hpp"
+
 class Item;
 
+/**
+ * The decaying items live in a timing wheel of TICK_MS buckets (see DecayWheel),
+ * one cycle event expires the current bucket each tick.
+ */
 class Decay {
 public:
 	Decay() = default;
@@ -24,12 +30,19 @@ public:
 	void stopDecay(std::shared_ptr<Item> item);
 
 private:
+	static constexpr int64_t TICK_MS = 50;
+
+	// The tick of the DURATION_TIMESTAMP, rounded up, an item never decays before its timestamp
+	struct ItemDueTick {
+		int64_t operator()(const std::shared_ptr<Item> &item) const;
+	};
+
 	void checkDecay();
 	void internalDecayItem(std::shared_ptr<Item> item);
 
-	uint32_t eventId { 0 };
-	// order is important, so we use an std::map
-	std::map<int64_t, std::vector<std::shared_ptr<Item>>> decayMap;
+	using Wheel = DecayWheel<Item, ItemDueTick>;
+	Wheel wheel;
+	bool started = false;
 };
 
 constexpr auto g_decay = Decay::getInstance;
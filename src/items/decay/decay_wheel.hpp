@@ -0,0 +1,115 @@
+/**
+ * Canary - A free and open-source MMORPG server emulator
+ * Copyright (©) 2019-2024 OpenTibiaBR <opentibiabr@outlook.com>
+ * Repository: https://github.com/opentibiabr/canary
+ * License: https://github.com/opentibiabr/canary/blob/main/LICENSE
+ * Contributors: https://github.com/opentibiabr/canary/graphs/contributors
+ * Website: https://docs.opentibiabr.com/
+ */
+
+#pragma once
+
+/**
+ * The timing wheel of Decay, the items keep their bucket and index (decayBucket and decayIndex),
+ * so scheduling and unscheduling are O(1) and each tick only looks at its own bucket.
+ * Items due further than the first level go to coarse buckets (one per first level turn),
+ * which are spread over the first level when their turn comes, the ones beyond both levels wait in a far bucket.
+ * DueTick returns the tick an item is due at, it is asked again when the item moves to a closer level.
+ */
+template <typename T, typename DueTick>
+class DecayWheel {
+public:
+	// 4096 ticks, a bit more than 3 minutes of 50ms ticks
+	static constexpr uint32_t WHEEL_BITS = 12;
+	static constexpr uint32_t WHEEL_SIZE = 1 << WHEEL_BITS;
+	// 1024 turns of the first level, about 58 hours of 50ms ticks
+	static constexpr uint32_t COARSE_SIZE = 1024;
+	static constexpr uint32_t FAR_BUCKET = WHEEL_SIZE + COARSE_SIZE;
+	static constexpr uint32_t NO_BUCKET = std::numeric_limits<uint32_t>::max();
+
+	// The next tick expire processes, every scheduled item is due at it or later
+	int64_t getNextTick() const {
+		return nextTick;
+	}
+
+	void setNextTick(int64_t tick) {
+		nextTick = tick;
+	}
+
+	// Adds the item to the bucket of the tick it is due at, a tick already processed is the next one
+	void schedule(const std::shared_ptr<T> &item, int64_t dueTick) {
+		dueTick = std::max(dueTick, nextTick);
+		uint32_t bucket;
+		if (dueTick - nextTick < WHEEL_SIZE) {
+			bucket = static_cast<uint32_t>(dueTick & (WHEEL_SIZE - 1));
+		} else if ((dueTick >> WHEEL_BITS) - (nextTick >> WHEEL_BITS) < COARSE_SIZE) {
+			bucket = WHEEL_SIZE + static_cast<uint32_t>((dueTick >> WHEEL_BITS) % COARSE_SIZE);
+		} else {
+			bucket = FAR_BUCKET;
+		}
+
+		auto &items = buckets[bucket];
+		item->decayBucket = bucket;
+		item->decayIndex = static_cast<uint32_t>(items.size());
+		items.emplace_back(item);
+	}
+
+	// Removes the item from its bucket, the last item of the bucket takes its place
+	void unschedule(const std::shared_ptr<T> &item) {
+		auto &items = buckets[item->decayBucket];
+		const auto index = item->decayIndex;
+		if (index != items.size() - 1) {
+			items[index] = std::move(items.back());
+			items[index]->decayIndex = index;
+		}
+		items.pop_back();
+		item->decayBucket = NO_BUCKET;
+	}
+
+	/**
+	 * Moves the items due up to currentTick to expired and takes them out of the wheel,
+	 * catching up on the ticks a slow cycle skipped.
+	 */
+	void expire(int64_t currentTick, std::vector<std::shared_ptr<T>> &expired) {
+		const auto firstExpired = expired.size();
+		for (; nextTick <= currentTick; ++nextTick) {
+			if ((nextTick & (WHEEL_SIZE - 1)) == 0) {
+				// A new turn of the first level, its coarse bucket is spread over it, and each coarse turn the far items come closer
+				const auto turn = nextTick >> WHEEL_BITS;
+				if (turn % COARSE_SIZE == 0) {
+					reschedule(FAR_BUCKET);
+				}
+				reschedule(WHEEL_SIZE + static_cast<uint32_t>(turn % COARSE_SIZE));
+			}
+
+			auto &bucket = buckets[nextTick & (WHEEL_SIZE - 1)];
+			if (bucket.empty()) {
+				continue;
+			}
+			if (expired.empty()) {
+				expired = std::move(bucket);
+			} else {
+				expired.insert(expired.end(), std::make_move_iterator(bucket.begin()), std::make_move_iterator(bucket.end()));
+			}
+			bucket.clear();
+		}
+
+		for (auto i = firstExpired; i < expired.size(); ++i) {
+			expired[i]->decayBucket = NO_BUCKET;
+		}
+	}
+
+private:
+	// Moves the items of the bucket to the buckets of their due ticks
+	void reschedule(uint32_t bucket) {
+		auto items = std::move(buckets[bucket]);
+		buckets[bucket].clear();
+		for (const auto &item : items) {
+			schedule(item, dueTickOf(item));
+		}
+	}
+
+	std::array<std::vector<std::shared_ptr<T>>, FAR_BUCKET + 1> buckets;
+	int64_t nextTick = 0;
+	[[no_unique_address]] DueTick dueTickOf;
+};
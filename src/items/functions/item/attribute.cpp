@@ -44,26 +44,27 @@ const int64_t &ItemAttribute::getAttributeValue(ItemAttribute_t type) const {
 	return attribute->getInteger();
 }
 
+namespace {
+	bool attributeTypeLess(const Attributes &attribute, ItemAttribute_t type) {
+		return attribute.getAttributeType() < type;
+	}
+}
+
 const Attributes* ItemAttribute::getAttribute(ItemAttribute_t type) const {
-	if (hasAttribute(type)) {
-		for (const Attributes &attribute : attributeVector) {
-			if (attribute.getAttributeType() == type) {
-				return &attribute;
-			}
-		}
+	const auto it = std::lower_bound(attributeVector.begin(), attributeVector.end(), type, attributeTypeLess);
+	if (it != attributeVector.end() && it->getAttributeType() == type) {
+		return &*it;
 	}
 	return nullptr;
 }
 
 Attributes &ItemAttribute::getAttributesByType(ItemAttribute_t type) {
-	for (Attributes &attribute : attributeVector) {
-		if (attribute.getAttributeType() == type) {
-			return attribute;
-		}
+	const auto it = std::lower_bound(attributeVector.begin(), attributeVector.end(), type, attributeTypeLess);
+	if (it != attributeVector.end() && it->getAttributeType() == type) {
+		return *it;
 	}
 
-	attributeVector.emplace_back(type);
-	return attributeVector.back();
+	return *attributeVector.emplace(it, type);
 }
 
 void ItemAttribute::setAttribute(ItemAttribute_t type, int64_t value) {
@@ -87,14 +88,13 @@ void ItemAttribute::setAttribute(ItemAttribute_t type, const std::string &value)
 }
 
 bool ItemAttribute::removeAttribute(ItemAttribute_t type) {
-	for (auto it = attributeVector.begin(); it != attributeVector.end(); ++it) {
-		if (it->getAttributeType() == type) {
-			*it = std::move(attributeVector.back());
-			attributeVector.pop_back();
-			return true;
-		}
+	const auto it = std::lower_bound(attributeVector.begin(), attributeVector.end(), type, attributeTypeLess);
+	if (it == attributeVector.end() || it->getAttributeType() != type) {
+		return false;
 	}
-	return false;
+
+	attributeVector.erase(it);
+	return true;
 }
 
 /*
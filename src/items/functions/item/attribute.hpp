@@ -158,12 +158,11 @@ public:
 	}
 
 	bool hasAttribute(ItemAttribute_t type) const {
-		for (const auto &attr : attributeVector) {
-			if (attr.getAttributeType() == type) {
-				return true;
-			}
-		}
-		return false;
+		return getAttribute(type) != nullptr;
+	}
+
+	bool empty() const {
+		return attributeVector.empty() && customAttributeMap.empty();
 	}
 
 	const Attributes* getAttribute(ItemAttribute_t type) const;
@@ -172,5 +171,6 @@ public:
 
 private:
 	std::map<std::string, CustomAttribute, std::less<>> customAttributeMap;
+	// Sorted by type
 	std::vector<Attributes> attributeVector;
 };
@@ -17,6 +17,7 @@
 #include "items/containers/mailbox/mailbox.hpp"
 #include "map/house/house.hpp"
 #include "game/game.hpp"
+#include "game/memory_census.hpp"
 #include "items/bed.hpp"
 #include "containers/rewards/rewardchest.hpp"
 #include "creatures/players/imbuements/imbuements.hpp"
@@ -27,6 +28,101 @@
 
 Items Item::items;
 
+void ItemProperties::removeAttribute(ItemAttribute_t type) {
+	if (const auto slot = findInlineAttribute(type); slot != INLINE_ATTRIBUTES) {
+		inlineAttributes[slot] = 0;
+		return;
+	}
+
+	if (attributePtr && attributePtr->removeAttribute(type) && attributePtr->empty()) {
+		attributePtr.reset();
+	}
+}
+
+void ItemProperties::setIntegerAttribute(ItemAttribute_t type, int64_t value) {
+	const bool fits = isAttributeInteger(type) && value >= 0 && value <= INLINE_VALUE_MAX;
+	const auto packed = static_cast<uint32_t>(type << INLINE_VALUE_BITS) | static_cast<uint32_t>(value);
+	if (const auto slot = findInlineAttribute(type); slot != INLINE_ATTRIBUTES) {
+		if (fits) {
+			inlineAttributes[slot] = packed;
+			return;
+		}
+		inlineAttributes[slot] = 0;
+	} else if (fits && (!attributePtr || !attributePtr->hasAttribute(type))) {
+		if (const auto free = std::ranges::find(inlineAttributes, 0u); free != inlineAttributes.end()) {
+			*free = packed;
+			return;
+		}
+	}
+
+	initAttributePtr()->setAttribute(type, value);
+}
+
+void Item::onAttributeChanged(ItemAttribute_t type) {
+	// The decay timers change all the time, the transformation they end with marks the house anyway
+	if (type == ItemAttribute_t::DURATION || type == ItemAttribute_t::DURATION_TIMESTAMP || type == ItemAttribute_t::DECAYSTATE) {
+		return;
+	}
+	markHouseItemsDirty();
+}
+
+void Item::markHouseItemsDirty() {
+	// Items being created or loaded are not in a house yet
+	if (!getParent()) {
+		return;
+	}
+
+	if (const auto &tile = getTile()) {
+		if (const auto house = tile->getHouse()) {
+			house->setItemsDirty();
+		}
+	}
+}
+
+void Item::logPoolStats() {
+	const auto log = [](std::string_view name, const ItemPoolStats &stats) {
+		g_logger().info("[Item::logPoolStats] {}: {} live, {} freed", name, stats.live.load(std::memory_order_relaxed), stats.freed.load(std::memory_order_relaxed));
+	};
+	log("Item", itemPoolStats<Item>);
+	log("Container", itemPoolStats<Container>);
+	log("DepotLocker", itemPoolStats<DepotLocker>);
+	log("DepotChest", itemPoolStats<DepotChest>);
+	log("Inbox", itemPoolStats<Inbox>);
+	log("Reward", itemPoolStats<Reward>);
+	log("RewardChest", itemPoolStats<RewardChest>);
+	log("Teleport", itemPoolStats<Teleport>);
+	log("MagicField", itemPoolStats<MagicField>);
+	log("Door", itemPoolStats<Door>);
+	log("TrashHolder", itemPoolStats<TrashHolder>);
+	log("Mailbox", itemPoolStats<Mailbox>);
+	log("BedItem", itemPoolStats<BedItem>);
+}
+
+namespace {
+	template <typename T>
+	void countItemClass(MemoryCensus &census) {
+		const auto live = itemPoolStats<T>.live.load(std::memory_order_relaxed);
+		census.add("items", live, live * MemoryCensus::sharedBytes<T>());
+	}
+}
+
+void Item::countMemory(MemoryCensus &census) {
+	countItemClass<Item>(census);
+	countItemClass<Container>(census);
+	countItemClass<DepotLocker>(census);
+	countItemClass<DepotChest>(census);
+	countItemClass<Inbox>(census);
+	countItemClass<Reward>(census);
+	countItemClass<RewardChest>(census);
+	countItemClass<Teleport>(census);
+	countItemClass<MagicField>(census);
+	countItemClass<Door>(census);
+	countItemClass<TrashHolder>(census);
+	countItemClass<Mailbox>(census);
+	countItemClass<BedItem>(census);
+	items.countMemory(census);
+}
+
 std::shared_ptr<Item> Item::CreateItem(const uint16_t type, uint16_t count /*= 0*/, Position* itemPosition /*= nullptr*/) {
 	// A map which contains items that, when on creating, should be transformed to the default type.
 	static const phmap::flat_hash_map<ItemID_t, ItemID_t> ItemTransformationMap = {
@@ -51,29 +147,29 @@ std::shared_ptr<Item> Item::CreateItem(const uint16_t type, uint16_t count /*= 0
 
 	if (it.id != 0) {
 		if (it.isDepot()) {
-			newItem = std::make_shared<DepotLocker>(type, 4);
+			newItem = makeItemShared<DepotLocker>(type, 4);
 		} else if (it.isRewardChest()) {
-			newItem = std::make_shared<RewardChest>(type);
+			newItem = makeItemShared<RewardChest>(type);
 		} else if (it.isContainer()) {
-			newItem = std::make_shared<Container>(type);
+			newItem = makeItemShared<Container>(type);
 		} else if (it.isTeleport()) {
-			newItem = std::make_shared<Teleport>(type);
+			newItem = makeItemShared<Teleport>(type);
 		} else if (it.isMagicField()) {
-			newItem = std::make_shared<MagicField>(type);
+			newItem = makeItemShared<MagicField>(type);
 		} else if (it.isDoor()) {
-			newItem = std::make_shared<Door>(type);
+			newItem = makeItemShared<Door>(type);
 		} else if (it.isTrashHolder()) {
-			newItem = std::make_shared<TrashHolder>(type);
+			newItem = makeItemShared<TrashHolder>(type);
 		} else if (it.isMailbox()) {
-			newItem = std::make_shared<Mailbox>(type);
+			newItem = makeItemShared<Mailbox>(type);
 		} else if (it.isBed()) {
-			newItem = std::make_shared<BedItem>(type);
+			newItem = makeItemShared<BedItem>(type);
 		} else {
 			auto itemMap = ItemTransformationMap.find(static_cast<ItemID_t>(it.id));
 			if (itemMap != ItemTransformationMap.end()) {
-				newItem = std::make_shared<Item>(itemMap->second, count);
+				newItem = makeItemShared<Item>(itemMap->second, count);
 			} else {
-				newItem = std::make_shared<Item>(type, count);
+				newItem = makeItemShared<Item>(type, count);
 			}
 		}
 	} else if (type > 0 && itemPosition) {
@@ -153,7 +249,7 @@ std::shared_ptr<Container> Item::CreateItemAsContainer(const uint16_t type, uint
 		return nullptr;
 	}
 
-	std::shared_ptr<Container> newItem = std::make_shared<Container>(type, size);
+	std::shared_ptr<Container> newItem = makeItemShared<Container>(type, size);
 	return newItem;
 }
 
@@ -220,6 +316,7 @@ Item::Item(const uint16_t itemId, uint16_t itemCount /*= 0*/) :
 
 Item::Item(const std::shared_ptr<Item> &i) :
 	Thing(), id(i->id), count(i->count), loadedFromMap(i->loadedFromMap) {
+	inlineAttributes = i->inlineAttributes;
 	if (i->attributePtr) {
 		attributePtr = std::make_unique<ItemAttribute>(*i->attributePtr);
 	}
@@ -232,8 +329,9 @@ std::shared_ptr<Item> Item::clone() const {
 		return nullptr;
 	}
 
-	if (attributePtr) {
-		item->attributePtr = std::make_unique<ItemAttribute>(*attributePtr);
+	if (hasAttributes()) {
+		item->inlineAttributes = inlineAttributes;
+		item->attributePtr = attributePtr ? std::make_unique<ItemAttribute>(*attributePtr) : nullptr;
 	}
 
 	return item;
@@ -256,27 +354,19 @@ bool Item::equals(std::shared_ptr<Item> compareItem) const {
 		return false;
 	}
 
-	for (const auto &attribute : getAttributeVector()) {
-		if (attribute.getAttributeType() == ItemAttribute_t::STORE) {
-			continue;
+	bool equal = true;
+	forEachAttribute([&](ItemAttribute_t type) {
+		if (!equal || type == ItemAttribute_t::STORE || !compareItem->hasAttribute(type)) {
+			return;
 		}
 
-		for (const auto &compareAttribute : compareItem->getAttributeVector()) {
-			if (attribute.getAttributeType() != compareAttribute.getAttributeType()) {
-				continue;
-			}
-
-			if (isAttributeInteger(attribute.getAttributeType()) && attribute.getInteger() != compareAttribute.getInteger()) {
-				return false;
-			}
-
-			if (isAttributeString(attribute.getAttributeType()) && attribute.getString() != compareAttribute.getString()) {
-				return false;
-			}
+		if (isAttributeInteger(type) && getInteger(type) != compareItem->getInteger(type)) {
+			equal = false;
+		} else if (isAttributeString(type) && attributePtr->getAttribute(type)->getString() != compareItem->attributePtr->getAttribute(type)->getString()) {
+			equal = false;
 		}
-	}
-
-	return true;
+	});
+	return equal;
 }
 
 void Item::setDefaultSubtype() {
@@ -304,6 +394,10 @@ void Item::onRemoved() {
 
 void Item::setID(uint16_t newid) {
 	const ItemType &prevIt = Item::items[id];
+	if (newid != id) {
+		updateParentContentCount(id, -1, -static_cast<int32_t>(count));
+		updateParentContentCount(newid, 1, count);
+	}
 	id = newid;
 
 	const ItemType &it = Item::items[newid];
@@ -327,6 +421,17 @@ void Item::setID(uint16_t newid) {
 	}
 }
 
+void Item::updateParentContentCount(uint16_t itemId, int32_t items, int32_t amount) {
+	const auto &parent = getParent();
+	if (!parent) {
+		return;
+	}
+
+	if (const auto &container = parent->getContainer()) {
+		container->updateContentCount(itemId, items, amount);
+	}
+}
+
 bool Item::isOwner(uint32_t ownerId) const {
 	if (getOwnerId() == ownerId) {
 		return true;
@@ -1072,32 +1177,32 @@ std::string Item::getOwnerName() const {
 }
 
 bool Item::hasProperty(ItemProperty prop) const {
-	const ItemType &it = items[id];
+	const ItemTypeHot &it = items.getHot(id);
 	switch (prop) {
 		case CONST_PROP_BLOCKSOLID:
-			return it.blockSolid;
+			return it.has(ItemTypeHot::BLOCK_SOLID);
 		case CONST_PROP_MOVABLE:
 			return canBeMoved();
 		case CONST_PROP_HASHEIGHT:
-			return it.hasHeight;
+			return it.has(ItemTypeHot::HAS_HEIGHT);
 		case CONST_PROP_BLOCKPROJECTILE:
-			return it.blockProjectile;
+			return it.has(ItemTypeHot::BLOCK_PROJECTILE);
 		case CONST_PROP_BLOCKPATH:
-			return it.blockPathFind;
+			return it.has(ItemTypeHot::BLOCK_PATHFIND);
 		case CONST_PROP_ISVERTICAL:
-			return it.isVertical;
+			return it.has(ItemTypeHot::IS_VERTICAL);
 		case CONST_PROP_ISHORIZONTAL:
-			return it.isHorizontal;
+			return it.has(ItemTypeHot::IS_HORIZONTAL);
 		case CONST_PROP_IMMOVABLEBLOCKSOLID:
-			return it.blockSolid && !canBeMoved();
+			return it.has(ItemTypeHot::BLOCK_SOLID) && !canBeMoved();
 		case CONST_PROP_IMMOVABLEBLOCKPATH:
-			return it.blockPathFind && !canBeMoved();
+			return it.has(ItemTypeHot::BLOCK_PATHFIND) && !canBeMoved();
 		case CONST_PROP_IMMOVABLENOFIELDBLOCKPATH:
-			return !it.isMagicField() && it.blockPathFind && !canBeMoved();
+			return !it.has(ItemTypeHot::MAGIC_FIELD) && it.has(ItemTypeHot::BLOCK_PATHFIND) && !canBeMoved();
 		case CONST_PROP_NOFIELDBLOCKPATH:
-			return !it.isMagicField() && it.blockPathFind;
+			return !it.has(ItemTypeHot::MAGIC_FIELD) && it.has(ItemTypeHot::BLOCK_PATHFIND);
 		case CONST_PROP_SUPPORTHANGABLE:
-			return it.isHorizontal || it.isVertical;
+			return it.has(ItemTypeHot::IS_HORIZONTAL) || it.has(ItemTypeHot::IS_VERTICAL);
 		default:
 			return false;
 	}
@@ -3260,22 +3365,20 @@ std::shared_ptr<Item> Item::transform(uint16_t itemId, uint16_t itemCount /*= -1
 }
 
 bool Item::hasMarketAttributes() const {
-	if (!isInitializedAttributePtr()) {
+	if (!hasAttributes()) {
 		return true;
 	}
 
-	for (const auto &attribute : getAttributeVector()) {
-		if (attribute.getAttributeType() == ItemAttribute_t::CHARGES && static_cast<uint16_t>(attribute.getInteger()) != items[id].charges) {
-			return false;
-		}
+	if (hasAttribute(ItemAttribute_t::CHARGES) && static_cast<uint16_t>(getInteger(ItemAttribute_t::CHARGES)) != items[id].charges) {
+		return false;
+	}
 
-		if (attribute.getAttributeType() == ItemAttribute_t::DURATION && static_cast<uint32_t>(attribute.getInteger()) != getDefaultDuration()) {
-			return false;
-		}
+	if (hasAttribute(ItemAttribute_t::DURATION) && static_cast<uint32_t>(getInteger(ItemAttribute_t::DURATION)) != getDefaultDuration()) {
+		return false;
+	}
 
-		if (attribute.getAttributeType() == ItemAttribute_t::TIER && static_cast<uint8_t>(attribute.getInteger()) != getTier()) {
-			return false;
-		}
+	if (hasAttribute(ItemAttribute_t::TIER) && static_cast<uint8_t>(getInteger(ItemAttribute_t::TIER)) != getTier()) {
+		return false;
 	}
 
 	return !hasImbuements() && !isStoreItem() && !hasOwner();
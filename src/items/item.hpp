@@ -14,6 +14,7 @@
 #include "enums/item_attribute.hpp"
 #include "items/items.hpp"
 #include "items/functions/item/attribute.hpp"
+#include "items/item_pool.hpp"
 #include "lua/scripts/luascript.hpp"
 #include "utils/tools.hpp"
 #include "io/fileloader.hpp"
@@ -30,8 +31,11 @@ class MagicField;
 class BedItem;
 class Imbuement;
 class Item;
+class MemoryCensus;
 
 // This class ItemProperties that serves as an interface to access and modify attributes of an item. The item's attributes are stored in an instance of ItemAttribute. The class ItemProperties has methods to get and set integer and string attributes, check if an attribute exists, remove an attribute, get the underlying attribute bits, and get a vector of attributes. It also has methods to get and set custom attributes, which are stored in a std::map<std::string, CustomAttribute, std::less<>>. The class has a data member attributePtr of type std::unique_ptr<ItemAttribute> that stores a pointer to the item's attributes methods.
+// Small integer attributes (charges, action id, duration, decay state, ...) are kept in a few inline slots instead,
+// an item that only has those never allocates the ItemAttribute block.
 class ItemProperties {
 public:
 	template <typename T>
@@ -50,29 +54,32 @@ public:
 	}
 
 	bool hasAttribute(ItemAttribute_t type) const {
+		if (findInlineAttribute(type) != INLINE_ATTRIBUTES) {
+			return true;
+		}
 		if (!attributePtr) {
 			return false;
 		}
 
 		return attributePtr->hasAttribute(type);
 	}
-	void removeAttribute(ItemAttribute_t type) {
-		if (attributePtr) {
-			attributePtr->removeAttribute(type);
-		}
-	}
+	void removeAttribute(ItemAttribute_t type);
 
 	template <typename GenericAttribute>
 	void setAttribute(ItemAttribute_t type, GenericAttribute genericAttribute) {
-		initAttributePtr()->setAttribute(type, genericAttribute);
+		if constexpr (std::is_arithmetic_v<GenericAttribute> || std::is_enum_v<GenericAttribute>) {
+			setIntegerAttribute(type, static_cast<int64_t>(genericAttribute));
+		} else {
+			initAttributePtr()->setAttribute(type, genericAttribute);
+		}
 	}
 
 	bool isAttributeInteger(ItemAttribute_t type) const {
-		return initAttributePtr()->isAttributeInteger(type);
+		return ItemAttributeHelper().isAttributeInteger(type);
 	}
 
 	bool isAttributeString(ItemAttribute_t type) const {
-		return initAttributePtr()->isAttributeString(type);
+		return ItemAttributeHelper().isAttributeString(type);
 	}
 
 	// Custom Attributes
@@ -164,27 +171,28 @@ protected:
 
 		return attributePtr;
 	}
-	const std::unique_ptr<ItemAttribute> &initAttributePtr() const {
-		if (!attributePtr) {
-			std::bit_cast<ItemProperties*>(this)->attributePtr = std::make_unique<ItemAttribute>();
-		}
-
-		return attributePtr;
-	}
 
-	const std::vector<Attributes> &getAttributeVector() const {
-		static std::vector<Attributes> emptyVector = {};
-		if (!attributePtr) {
-			return emptyVector;
+	// Calls f with the type of each attribute the item has, the inline ones first
+	template <typename F>
+	void forEachAttribute(F &&f) const {
+		for (const auto slot : inlineAttributes) {
+			if (slot != 0) {
+				f(static_cast<ItemAttribute_t>(slot >> INLINE_VALUE_BITS));
+			}
+		}
+		if (attributePtr) {
+			for (const auto &attribute : attributePtr->getAttributeVector()) {
+				f(attribute.getAttributeType());
+			}
 		}
-
-		return attributePtr->getAttributeVector();
 	}
 
-	const int64_t &getInteger(ItemAttribute_t type) const {
-		static int64_t emptyInt;
+	int64_t getInteger(ItemAttribute_t type) const {
+		if (const auto slot = findInlineAttribute(type); slot != INLINE_ATTRIBUTES) {
+			return inlineAttributes[slot] & INLINE_VALUE_MAX;
+		}
 		if (!attributePtr) {
-			return emptyInt;
+			return 0;
 		}
 
 		return attributePtr->getAttributeValue(type);
@@ -198,15 +206,31 @@ protected:
 		return attributePtr->getAttributeString(type);
 	}
 
-	bool isInitializedAttributePtr() const {
-		if (!attributePtr) {
-			return false;
-		}
-
-		return true;
+	bool hasAttributes() const {
+		return attributePtr || std::ranges::any_of(inlineAttributes, [](uint32_t slot) { return slot != 0; });
 	}
 
 private:
+	// A slot holds the type in the high bits and the value in the low ones, 0 is a free slot
+	static constexpr size_t INLINE_ATTRIBUTES = 4;
+	static constexpr uint32_t INLINE_VALUE_BITS = 26;
+	static constexpr int64_t INLINE_VALUE_MAX = (int64_t { 1 } << INLINE_VALUE_BITS) - 1;
+	static_assert(ItemAttribute_t::AUGMENTS < (1 << (32 - INLINE_VALUE_BITS)));
+
+	// @return the slot of the type, INLINE_ATTRIBUTES if it is not inline
+	size_t findInlineAttribute(ItemAttribute_t type) const {
+		for (size_t i = 0; i < INLINE_ATTRIBUTES; ++i) {
+			if (inlineAttributes[i] != 0 && (inlineAttributes[i] >> INLINE_VALUE_BITS) == type) {
+				return i;
+			}
+		}
+		return INLINE_ATTRIBUTES;
+	}
+
+	// Inline if the value fits and the type is not already in the attribute block
+	void setIntegerAttribute(ItemAttribute_t type, int64_t value);
+
+	std::array<uint32_t, INLINE_ATTRIBUTES> inlineAttributes {};
 	std::unique_ptr<ItemAttribute> attributePtr;
 
 	friend class Item;
@@ -220,6 +244,11 @@ public:
 	static std::shared_ptr<Item> CreateItem(uint16_t itemId, Position &itemPosition);
 	static Items items;
 
+	// Logs the live/freed counters of the pooled item classes
+	static void logPoolStats();
+	// Adds the live items of each pooled class and the item types, the attributes out of line are not counted
+	static void countMemory(MemoryCensus &census);
+
 	// Constructor for items
 	Item(const uint16_t type, uint16_t count = 0);
 	Item(const std::shared_ptr<Item> &i);
@@ -232,6 +261,33 @@ public:
 
 	bool equals(std::shared_ptr<Item> compareItem) const;
 
+	// The attribute setters of ItemProperties, they also mark the house the item is in as changed (see House::setItemsDirty)
+	template <typename GenericAttribute>
+	void setAttribute(ItemAttribute_t type, GenericAttribute genericAttribute) {
+		ItemProperties::setAttribute(type, genericAttribute);
+		onAttributeChanged(type);
+	}
+	void removeAttribute(ItemAttribute_t type) {
+		ItemProperties::removeAttribute(type);
+		onAttributeChanged(type);
+	}
+	template <typename GenericType>
+	void setCustomAttribute(const std::string &key, GenericType value) {
+		ItemProperties::setCustomAttribute(key, value);
+		markHouseItemsDirty();
+	}
+	void addCustomAttribute(const std::string &key, const CustomAttribute &customAttribute) {
+		ItemProperties::addCustomAttribute(key, customAttribute);
+		markHouseItemsDirty();
+	}
+	bool removeCustomAttribute(const std::string &attributeName) {
+		if (!ItemProperties::removeCustomAttribute(attributeName)) {
+			return false;
+		}
+		markHouseItemsDirty();
+		return true;
+	}
+
 	std::shared_ptr<Item> getItem() override final {
 		return static_self_cast<Item>();
 	}
@@ -352,7 +408,7 @@ public:
 		if (hasAttribute(ItemAttribute_t::WEIGHT)) {
 			return getAttribute<uint32_t>(ItemAttribute_t::WEIGHT);
 		}
-		return items[id].weight;
+		return items.getHot(id).weight;
 	}
 
 	int32_t getCleavePercent() const {
@@ -471,22 +527,22 @@ public:
 
 	bool hasProperty(ItemProperty prop) const;
 	bool isBlocking() const {
-		return items[id].blockSolid;
+		return items.getHot(id).has(ItemTypeHot::BLOCK_SOLID);
 	}
 	bool isStackable() const {
-		return items[id].stackable;
+		return items.getHot(id).has(ItemTypeHot::STACKABLE);
 	}
 	bool isStowable() const {
 		return items[id].stackable && items[id].wareId > 0;
 	}
 	bool isAlwaysOnTop() const {
-		return items[id].alwaysOnTopOrder != 0;
+		return items.getHot(id).alwaysOnTopOrder != 0;
 	}
 	bool isGroundTile() const {
-		return items[id].isGroundTile();
+		return items.getHot(id).has(ItemTypeHot::GROUND);
 	}
 	bool isMagicField() const {
-		return items[id].isMagicField();
+		return items.getHot(id).has(ItemTypeHot::MAGIC_FIELD);
 	}
 	bool isWrapContainer() const {
 		return items[id].wrapContainer;
@@ -498,13 +554,13 @@ public:
 		return items[id].isCorpse;
 	}
 	bool isPickupable() const {
-		return items[id].pickupable;
+		return items.getHot(id).has(ItemTypeHot::PICKUPABLE);
 	}
 	bool isMultiUse() const {
 		return items[id].multiUse;
 	}
 	bool isHangable() const {
-		return items[id].isHangable;
+		return items.getHot(id).has(ItemTypeHot::HANGABLE);
 	}
 	bool isRotatable() const {
 		return items[id].rotatable && items[id].rotateTo;
@@ -594,7 +650,11 @@ public:
 		return count;
 	}
 	void setItemCount(uint8_t n) {
-		count = n;
+		if (n != count) {
+			const auto diff = static_cast<int32_t>(n) - count;
+			count = n;
+			updateParentContentCount(id, 0, diff);
+		}
 	}
 
 	static uint32_t countByType(std::shared_ptr<Item> item, int32_t subType) {
@@ -630,6 +690,9 @@ public:
 		return true;
 	}
 	virtual void onRemoved();
+	// Marks the house of the item as changed, for the house items save
+	void markHouseItemsDirty();
+	void onAttributeChanged(ItemAttribute_t type);
 	virtual void onTradeEvent(TradeEvents_t, std::shared_ptr<Player>) { }
 
 	virtual void startDecaying();
@@ -791,6 +854,9 @@ public:
 	void checkDecayMapItemOnMove();
 
 protected:
+	// Keeps the content counts of the container holding this item in sync
+	void updateParentContentCount(uint16_t itemId, int32_t items, int32_t amount);
+
 	std::weak_ptr<Cylinder> m_parent;
 
 	uint16_t id; // the same id as in ItemType
@@ -800,12 +866,18 @@ protected:
 	bool isLootTrackeable = false;
 	bool decayDisabled = false;
 
+	// The place of the item in the decay wheel, only used by Decay
+	uint32_t decayBucket = std::numeric_limits<uint32_t>::max();
+	uint32_t decayIndex = 0;
+
 private:
 	void setImbuement(uint8_t slot, uint16_t imbuementId, uint32_t duration);
 	// Don't add variables here, use the ItemAttribute class.
 	std::string getWeightDescription(uint32_t weight) const;
 
 	friend class Decay;
+	template <typename, typename>
+	friend class DecayWheel;
 	friend class MapCache;
 };
 
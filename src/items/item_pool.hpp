@@ -0,0 +1,79 @@
+/**
+ * Canary - A free and open-source MMORPG server emulator
+ * Copyright (©) 2019-2024 OpenTibiaBR <opentibiabr@outlook.com>
+ * Repository: https://github.com/opentibiabr/canary
+ * License: https://github.com/opentibiabr/canary/blob/main/LICENSE
+ * Contributors: https://github.com/opentibiabr/canary/graphs/contributors
+ * Website: https://docs.opentibiabr.com/
+ */
+
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+
+#include "utils/pool_allocator.hpp"
+
+/**
+ * Items are created and destroyed at a high rate (corpses, loot, createItemBatch),
+ * they are allocated together with their control block from a shared_block_pool,
+ * items are often freed on another thread than the dispatcher that created them.
+ * Each item class keeps its own live/freed counters.
+ */
+struct ItemPoolStats {
+	std::atomic<uint64_t> live = 0;
+	std::atomic<uint64_t> freed = 0;
+};
+
+// Keyed by the item class, allocate_shared rebinds the allocator to its control block type
+template <typename T>
+inline ItemPoolStats itemPoolStats;
+
+template <typename T, typename Counted = T>
+class ItemPoolAllocator {
+public:
+	using value_type = T;
+
+	template <typename U>
+	struct rebind {
+		using other = ItemPoolAllocator<U, Counted>;
+	};
+
+	ItemPoolAllocator() noexcept = default;
+
+	template <typename U>
+	ItemPoolAllocator(const ItemPoolAllocator<U, Counted> &) noexcept { }
+
+	T* allocate(size_t n) {
+		itemPoolStats<Counted>.live.fetch_add(1, std::memory_order_relaxed);
+		if (n != 1) {
+			return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t(alignof(T))));
+		}
+		return static_cast<T*>(Pool::allocate());
+	}
+
+	void deallocate(T* ptr, size_t n) noexcept {
+		itemPoolStats<Counted>.live.fetch_sub(1, std::memory_order_relaxed);
+		itemPoolStats<Counted>.freed.fetch_add(1, std::memory_order_relaxed);
+		if (n != 1) {
+			::operator delete(ptr, std::align_val_t(alignof(T)));
+			return;
+		}
+		Pool::deallocate(ptr);
+	}
+
+	template <typename U>
+	bool operator==(const ItemPoolAllocator<U, Counted> &) const noexcept {
+		return true;
+	}
+
+private:
+	// Bigger batches than the default, map load and mass cleanups free items by the thousands
+	using Pool = stdext::shared_block_pool<sizeof(T), alignof(T), 64, 256>;
+};
+
+template <typename T, typename... Args>
+std::shared_ptr<T> makeItemShared(Args &&... args) {
+	return std::allocate_shared<T>(ItemPoolAllocator<T>(), std::forward<Args>(args)...);
+}
@@ -14,6 +14,8 @@
 #include "items/weapons/weapons.hpp"
 #include "lua/creature/movement.hpp"
 #include "game/game.hpp"
+#include "game/memory_census.hpp"
+#include "lib/thread/thread_pool.hpp"
 #include "utils/pugicast.hpp"
 
 #include <appearances.pb.h>
@@ -22,6 +24,7 @@ Items::Items() = default;
 
 void Items::clear() {
 	items.clear();
+	hot.clear();
 	ladders.clear();
 	dummys.clear();
 	nameToItems.clear();
@@ -29,6 +32,19 @@ void Items::clear() {
 	g_weapons().clear(true);
 }
 
+void Items::countMemory(MemoryCensus &census) const {
+	uint64_t bytes = items.capacity() * sizeof(ItemType) + hot.capacity() * sizeof(ItemTypeHot);
+	for (const auto &itemType : items) {
+		for (const auto* text : { &itemType.name, &itemType.article, &itemType.pluralName, &itemType.description, &itemType.runeSpellName, &itemType.vocationString }) {
+			bytes += MemoryCensus::heapBytes(*text);
+		}
+		if (itemType.abilities) {
+			bytes += sizeof(Abilities);
+		}
+	}
+	census.add("item_types", items.size(), bytes);
+}
+
 using LootTypeNames = phmap::flat_hash_map<std::string, ItemTypes_t>;
 
 LootTypeNames lootTypeNames = {
@@ -120,120 +136,140 @@ bool Items::reload() {
 }
 
 void Items::loadFromProtobuf() {
-	using namespace Canary::protobuf::appearances;
-
-	bool supportAnimation = g_configManager().getBoolean(OLD_PROTOCOL, __FUNCTION__);
-	for (uint32_t it = 0; it < g_game().m_appearancesPtr->object_size(); ++it) {
-		Appearance object = g_game().m_appearancesPtr->object(it);
+	const auto &appearances = *g_game().m_appearancesPtr;
+	const bool supportAnimation = g_configManager().getBoolean(OLD_PROTOCOL, __FUNCTION__);
 
+	// Sized up front, so the objects can be decoded in parallel, each one only writes its own ItemType
+	size_t requiredSize = items.size();
+	for (const auto &object : appearances.object()) {
 		// This scenario should never happen but on custom assets this can break the loader.
 		if (!object.has_flags()) {
 			g_logger().warn("[Items::loadFromProtobuf] - Item with id '{}' is invalid and was ignored.", object.id());
 			continue;
 		}
 
-		if (object.id() >= items.size()) {
-			items.resize(object.id() + 1);
-		}
+		requiredSize = std::max<size_t>(requiredSize, object.id() + 1);
+	}
+	items.resize(requiredSize);
+
+	inject<ThreadPool>()
+		.submit_loop(
+			0, appearances.object_size(),
+			[&](const int index) {
+				parseAppearance(appearances.object(index), supportAnimation);
+			}
+		)
+		.wait();
 
-		if (!object.has_id()) {
+	// Filled in file order, so the name lookups match a serial load
+	for (const auto &object : appearances.object()) {
+		if (!object.has_flags() || !object.has_id()) {
 			continue;
 		}
 
-		ItemType &iType = items[object.id()];
-		if (object.flags().container()) {
-			iType.type = ITEM_TYPE_CONTAINER;
-			iType.group = ITEM_GROUP_CONTAINER;
-		} else if (object.flags().has_bank()) {
-			iType.group = ITEM_GROUP_GROUND;
-		} else if (object.flags().liquidcontainer()) {
-			iType.group = ITEM_GROUP_FLUID;
-		} else if (object.flags().liquidpool()) {
-			iType.group = ITEM_GROUP_SPLASH;
+		const ItemType &iType = items[object.id()];
+		if (!iType.name.empty()) {
+			nameToItems.insert({ asLowerCaseString(iType.name), iType.id });
 		}
+	}
+
+	items.shrink_to_fit();
+}
+
+void Items::parseAppearance(const Canary::protobuf::appearances::Appearance &object, bool supportAnimation) {
+	using namespace Canary::protobuf::appearances;
+
+	if (!object.has_flags() || !object.has_id()) {
+		return;
+	}
 
-		// This attribute is only used on 10x protocol, so we should not waste our time iterating it when it's disabled.
-		if (supportAnimation) {
-			for (uint32_t frame_it = 0; frame_it < object.frame_group_size(); ++frame_it) {
-				FrameGroup objectFrame = object.frame_group(frame_it);
-				if (!objectFrame.has_sprite_info()) {
-					continue;
-				}
-
-				if (!objectFrame.sprite_info().has_animation()) {
-					continue;
-				}
-
-				if (objectFrame.sprite_info().animation().random_start_phase()) {
-					iType.animationType = ANIMATION_RANDOM;
-				} else {
-					iType.animationType = ANIMATION_DESYNC;
-				}
+	ItemType &iType = items[object.id()];
+	if (object.flags().container()) {
+		iType.type = ITEM_TYPE_CONTAINER;
+		iType.group = ITEM_GROUP_CONTAINER;
+	} else if (object.flags().has_bank()) {
+		iType.group = ITEM_GROUP_GROUND;
+	} else if (object.flags().liquidcontainer()) {
+		iType.group = ITEM_GROUP_FLUID;
+	} else if (object.flags().liquidpool()) {
+		iType.group = ITEM_GROUP_SPLASH;
+	}
+
+	// This attribute is only used on 10x protocol, so we should not waste our time iterating it when it's disabled.
+	if (supportAnimation) {
+		for (uint32_t frame_it = 0; frame_it < object.frame_group_size(); ++frame_it) {
+			const FrameGroup &objectFrame = object.frame_group(frame_it);
+			if (!objectFrame.has_sprite_info()) {
+				continue;
 			}
-		}
 
-		if (object.flags().clip()) {
-			iType.alwaysOnTopOrder = 1;
-		} else if (object.flags().top()) {
-			iType.alwaysOnTopOrder = 3;
-		} else if (object.flags().bottom()) {
-			iType.alwaysOnTopOrder = 2;
-		}
+			if (!objectFrame.sprite_info().has_animation()) {
+				continue;
+			}
 
-		if (object.flags().has_clothes()) {
-			iType.slotPosition |= static_cast<SlotPositionBits>(1 << (object.flags().clothes().slot() - 1));
+			if (objectFrame.sprite_info().animation().random_start_phase()) {
+				iType.animationType = ANIMATION_RANDOM;
+			} else {
+				iType.animationType = ANIMATION_DESYNC;
+			}
 		}
+	}
 
-		if (object.flags().has_market()) {
-			iType.type = static_cast<ItemTypes_t>(object.flags().market().category());
-		}
+	if (object.flags().clip()) {
+		iType.alwaysOnTopOrder = 1;
+	} else if (object.flags().top()) {
+		iType.alwaysOnTopOrder = 3;
+	} else if (object.flags().bottom()) {
+		iType.alwaysOnTopOrder = 2;
+	}
 
-		iType.name = object.name();
-		iType.description = object.description();
-
-		iType.upgradeClassification = object.flags().has_upgradeclassification() ? static_cast<uint8_t>(object.flags().upgradeclassification().upgrade_classification()) : 0;
-		iType.lightLevel = object.flags().has_light() ? static_cast<uint8_t>(object.flags().light().brightness()) : 0;
-		iType.lightColor = object.flags().has_light() ? static_cast<uint8_t>(object.flags().light().color()) : 0;
-
-		iType.id = static_cast<uint16_t>(object.id());
-		iType.speed = object.flags().has_bank() ? static_cast<uint16_t>(object.flags().bank().waypoints()) : 0;
-		iType.wareId = object.flags().has_market() ? static_cast<uint16_t>(object.flags().market().trade_as_object_id()) : 0;
-
-		iType.isCorpse = object.flags().corpse() || object.flags().player_corpse();
-		iType.forceUse = object.flags().forceuse();
-		iType.hasHeight = object.flags().has_height();
-		iType.blockSolid = object.flags().unpass();
-		iType.blockProjectile = object.flags().unsight();
-		iType.blockPathFind = object.flags().avoid();
-		iType.pickupable = object.flags().take();
-		iType.rotatable = object.flags().rotate();
-		iType.wrapContainer = object.flags().wrap() || object.flags().unwrap();
-		if (iType.wrapContainer) {
-			iType.wrapableTo = ITEM_DECORATION_KIT;
-			iType.wrapable = true;
-		}
-		iType.multiUse = object.flags().multiuse();
-		iType.movable = object.flags().unmove() == false;
-		iType.canReadText = (object.flags().has_lenshelp() && object.flags().lenshelp().id() == 1112) || (object.flags().has_write() && object.flags().write().max_text_length() != 0) || (object.flags().has_write_once() && object.flags().write_once().max_text_length_once() != 0);
-		iType.canReadText = object.flags().has_write() || object.flags().has_write_once();
-		iType.isVertical = object.flags().has_hook() && object.flags().hook().direction() == HOOK_TYPE_SOUTH;
-		iType.isHorizontal = object.flags().has_hook() && object.flags().hook().direction() == HOOK_TYPE_EAST;
-		iType.isHangable = object.flags().hang();
-		iType.lookThrough = object.flags().ignore_look();
-		iType.stackable = object.flags().cumulative();
-		iType.isPodium = object.flags().show_off_socket();
-		iType.wearOut = object.flags().wearout();
-		iType.clockExpire = object.flags().clockexpire();
-		iType.expire = object.flags().expire();
-		iType.expireStop = object.flags().expirestop();
-		iType.isWrapKit = object.flags().wrapkit();
+	if (object.flags().has_clothes()) {
+		iType.slotPosition |= static_cast<SlotPositionBits>(1 << (object.flags().clothes().slot() - 1));
+	}
 
-		if (!iType.name.empty()) {
-			nameToItems.insert({ asLowerCaseString(iType.name), iType.id });
-		}
+	if (object.flags().has_market()) {
+		iType.type = static_cast<ItemTypes_t>(object.flags().market().category());
 	}
 
-	items.shrink_to_fit();
+	iType.name = object.name();
+	iType.description = object.description();
+
+	iType.upgradeClassification = object.flags().has_upgradeclassification() ? static_cast<uint8_t>(object.flags().upgradeclassification().upgrade_classification()) : 0;
+	iType.lightLevel = object.flags().has_light() ? static_cast<uint8_t>(object.flags().light().brightness()) : 0;
+	iType.lightColor = object.flags().has_light() ? static_cast<uint8_t>(object.flags().light().color()) : 0;
+
+	iType.id = static_cast<uint16_t>(object.id());
+	iType.speed = object.flags().has_bank() ? static_cast<uint16_t>(object.flags().bank().waypoints()) : 0;
+	iType.wareId = object.flags().has_market() ? static_cast<uint16_t>(object.flags().market().trade_as_object_id()) : 0;
+
+	iType.isCorpse = object.flags().corpse() || object.flags().player_corpse();
+	iType.forceUse = object.flags().forceuse();
+	iType.hasHeight = object.flags().has_height();
+	iType.blockSolid = object.flags().unpass();
+	iType.blockProjectile = object.flags().unsight();
+	iType.blockPathFind = object.flags().avoid();
+	iType.pickupable = object.flags().take();
+	iType.rotatable = object.flags().rotate();
+	iType.wrapContainer = object.flags().wrap() || object.flags().unwrap();
+	if (iType.wrapContainer) {
+		iType.wrapableTo = ITEM_DECORATION_KIT;
+		iType.wrapable = true;
+	}
+	iType.multiUse = object.flags().multiuse();
+	iType.movable = object.flags().unmove() == false;
+	iType.canReadText = (object.flags().has_lenshelp() && object.flags().lenshelp().id() == 1112) || (object.flags().has_write() && object.flags().write().max_text_length() != 0) || (object.flags().has_write_once() && object.flags().write_once().max_text_length_once() != 0);
+	iType.canReadText = object.flags().has_write() || object.flags().has_write_once();
+	iType.isVertical = object.flags().has_hook() && object.flags().hook().direction() == HOOK_TYPE_SOUTH;
+	iType.isHorizontal = object.flags().has_hook() && object.flags().hook().direction() == HOOK_TYPE_EAST;
+	iType.isHangable = object.flags().hang();
+	iType.lookThrough = object.flags().ignore_look();
+	iType.stackable = object.flags().cumulative();
+	iType.isPodium = object.flags().show_off_socket();
+	iType.wearOut = object.flags().wearout();
+	iType.clockExpire = object.flags().clockexpire();
+	iType.expire = object.flags().expire();
+	iType.expireStop = object.flags().expirestop();
+	iType.isWrapKit = object.flags().wrapkit();
 }
 
 bool Items::loadFromXml() {
@@ -271,9 +307,40 @@ bool Items::loadFromXml() {
 			parseItemNode(itemNode, id++);
 		}
 	}
+
+	buildHotTable();
 	return true;
 }
 
+void Items::buildHotTable() {
+	hot.assign(items.size(), {});
+	for (size_t id = 0; id < items.size(); ++id) {
+		const ItemType &type = items[id];
+		auto &entry = hot[id];
+		const auto setFlag = [&entry](ItemTypeHot::Flag flag, bool value) {
+			if (value) {
+				entry.flags |= flag;
+			}
+		};
+		setFlag(ItemTypeHot::BLOCK_SOLID, type.blockSolid);
+		setFlag(ItemTypeHot::HAS_HEIGHT, type.hasHeight);
+		setFlag(ItemTypeHot::BLOCK_PROJECTILE, type.blockProjectile);
+		setFlag(ItemTypeHot::BLOCK_PATHFIND, type.blockPathFind);
+		setFlag(ItemTypeHot::IS_VERTICAL, type.isVertical);
+		setFlag(ItemTypeHot::IS_HORIZONTAL, type.isHorizontal);
+		setFlag(ItemTypeHot::PICKUPABLE, type.pickupable);
+		setFlag(ItemTypeHot::STACKABLE, type.stackable);
+		setFlag(ItemTypeHot::GROUND, type.isGroundTile());
+		setFlag(ItemTypeHot::MAGIC_FIELD, type.isMagicField());
+		setFlag(ItemTypeHot::TRASH_HOLDER, type.isTrashHolder());
+		setFlag(ItemTypeHot::HANGABLE, type.isHangable);
+		entry.weight = type.weight;
+		entry.floorChange = type.floorChange;
+		entry.speed = type.speed;
+		entry.alwaysOnTopOrder = type.alwaysOnTopOrder;
+	}
+}
+
 void Items::buildInventoryList() {
 	inventory.reserve(items.size());
 	for (const auto &type : items) {
@@ -304,10 +371,12 @@ void Items::parseItemNode(const pugi::xml_node &itemNode, uint16_t id) {
 	if (std::string xmlName = itemNode.attribute("name").as_string();
 	    !xmlName.empty() && itemType.name != xmlName) {
 		if (!itemType.name.empty()) {
-			if (auto it = std::find_if(nameToItems.begin(), nameToItems.end(), [id](const auto nameMapIt) {
+			// Looked up by the old name, scanning the whole map for every item made the load quadratic
+			auto [begin, end] = nameToItems.equal_range(asLowerCaseString(itemType.name));
+			if (auto it = std::find_if(begin, end, [id](const auto &nameMapIt) {
 					return nameMapIt.second == id;
 				});
-			    it != nameToItems.end()) {
+			    it != end) {
 				nameToItems.erase(it);
 			}
 		}
@@ -14,6 +14,15 @@
 #include "declarations.hpp"
 #include "game/movement/position.hpp"
 
+// Forward declaration for protobuf class
+namespace Canary {
+	namespace protobuf {
+		namespace appearances {
+			class Appearance;
+		} // namespace appearances
+	} // namespace protobuf
+} // namespace Canary
+
 struct Abilities {
 public:
 	std::array<ConditionType_t, ConditionType_t::CONDITION_COUNT> conditionImmunities = {};
@@ -101,6 +110,7 @@ private:
 };
 
 class ConditionDamage;
+class MemoryCensus;
 
 class ItemType {
 public:
@@ -382,6 +392,38 @@ public:
 	bool m_canBeUsedByGuests = false;
 };
 
+/**
+ * The ItemType fields read by the tile flags, queryAdd and walking code, packed per item id.
+ * ItemType is a large class, these checks would otherwise touch a cold cache line each.
+ * Only holds fields scripts do not change after loading, it is rebuilt with items.xml.
+ */
+struct ItemTypeHot {
+	enum Flag : uint16_t {
+		BLOCK_SOLID = 1 << 0,
+		HAS_HEIGHT = 1 << 1,
+		BLOCK_PROJECTILE = 1 << 2,
+		BLOCK_PATHFIND = 1 << 3,
+		IS_VERTICAL = 1 << 4,
+		IS_HORIZONTAL = 1 << 5,
+		PICKUPABLE = 1 << 6,
+		STACKABLE = 1 << 7,
+		GROUND = 1 << 8,
+		MAGIC_FIELD = 1 << 9,
+		TRASH_HOLDER = 1 << 10,
+		HANGABLE = 1 << 11,
+	};
+
+	bool has(Flag flag) const {
+		return (flags & flag) != 0;
+	}
+
+	int32_t weight = 0;
+	uint32_t floorChange = TILESTATE_NONE;
+	uint16_t flags = 0;
+	uint16_t speed = 0;
+	uint8_t alwaysOnTopOrder = 0;
+};
+
 class Items {
 public:
 	using NameMap = std::unordered_multimap<std::string, uint16_t>;
@@ -404,6 +446,11 @@ public:
 	const ItemType &getItemType(size_t id) const;
 	ItemType &getItemType(size_t id);
 
+	const ItemTypeHot &getHot(size_t id) const {
+		static const ItemTypeHot empty;
+		return id < hot.size() ? hot[id] : empty;
+	}
+
 	/**
 	 * @brief Check if the itemid "hasId" is stored on "items", if not, return false
 	 *
@@ -421,6 +468,7 @@ public:
 	void parseItemNode(const pugi::xml_node &itemNode, uint16_t id);
 
 	void buildInventoryList();
+	void buildHotTable();
 	const InventoryVector &getInventory() const {
 		return inventory;
 	}
@@ -429,6 +477,9 @@ public:
 		return items.size();
 	}
 
+	// Adds the item types, their texts and abilities
+	void countMemory(MemoryCensus &census) const;
+
 	NameMap nameToItems;
 
 	void addLadderId(uint16_t newId) {
@@ -458,7 +509,11 @@ public:
 	}
 
 private:
+	// Only writes the ItemType of the object id, it runs on the thread pool workers
+	void parseAppearance(const Canary::protobuf::appearances::Appearance &object, bool supportAnimation);
+
 	std::vector<ItemType> items;
+	std::vector<ItemTypeHot> hot;
 	std::vector<uint16_t> ladders;
 	std::unordered_map<uint16_t, uint16_t> dummys;
 	InventoryVector inventory;
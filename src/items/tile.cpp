@@ -21,6 +21,8 @@
 #include "items/trashholder.hpp"
 #include "io/iomap.hpp"
 #include "map/spectators.hpp"
+#include "map/utils/flowfield.hpp"
+#include "map/utils/hierarchicalpath.hpp"
 #include "enums/account_type.hpp"
 
 auto real_nullptr_tile = std::make_shared<StaticTile>(0xFFFF, 0xFFFF, 0xFF);
@@ -252,7 +254,7 @@ std::shared_ptr<Creature> Tile::getBottomCreature() const {
 	return nullptr;
 }
 
-std::shared_ptr<Creature> Tile::getTopVisibleCreature(std::shared_ptr<Creature> creature) const {
+std::shared_ptr<Creature> Tile::getTopVisibleCreature(const std::shared_ptr<Creature> &creature) const {
 	if (const CreatureVector* creatures = getCreatures()) {
 		if (creature) {
 			std::shared_ptr<Player> player = creature->getPlayer();
@@ -279,7 +281,7 @@ std::shared_ptr<Creature> Tile::getTopVisibleCreature(std::shared_ptr<Creature>
 	return nullptr;
 }
 
-std::shared_ptr<Creature> Tile::getBottomVisibleCreature(std::shared_ptr<Creature> creature) const {
+std::shared_ptr<Creature> Tile::getBottomVisibleCreature(const std::shared_ptr<Creature> &creature) const {
 	if (const CreatureVector* creatures = getCreatures()) {
 		if (creature) {
 			std::shared_ptr<Player> player = creature->getPlayer();
@@ -327,8 +329,8 @@ std::shared_ptr<Item> Tile::getItemByTopOrder(int32_t topOrder) {
 	// 3: doors etc
 	// 4: creatures
 	if (TileItemVector* items = getItemList()) {
-		for (auto it = ItemVector::const_reverse_iterator(items->getEndTopItem()), end = ItemVector::const_reverse_iterator(items->getBeginTopItem()); it != end; ++it) {
-			if (Item::items[(*it)->getID()].alwaysOnTopOrder == topOrder) {
+		for (auto it = TileItemVector::const_reverse_iterator(items->getEndTopItem()), end = TileItemVector::const_reverse_iterator(items->getBeginTopItem()); it != end; ++it) {
+			if (Item::items.getHot((*it)->getID()).alwaysOnTopOrder == topOrder) {
 				return (*it);
 			}
 		}
@@ -336,7 +338,7 @@ std::shared_ptr<Item> Tile::getItemByTopOrder(int32_t topOrder) {
 	return nullptr;
 }
 
-std::shared_ptr<Thing> Tile::getTopVisibleThing(std::shared_ptr<Creature> creature) {
+std::shared_ptr<Thing> Tile::getTopVisibleThing(const std::shared_ptr<Creature> &creature) {
 	std::shared_ptr<Thing> thing = getTopVisibleCreature(creature);
 	if (thing) {
 		return thing;
@@ -344,14 +346,14 @@ std::shared_ptr<Thing> Tile::getTopVisibleThing(std::shared_ptr<Creature> creatu
 
 	TileItemVector* items = getItemList();
 	if (items) {
-		for (ItemVector::const_iterator it = items->getBeginDownItem(), end = items->getEndDownItem(); it != end; ++it) {
+		for (TileItemVector::const_iterator it = items->getBeginDownItem(), end = items->getEndDownItem(); it != end; ++it) {
 			const ItemType &iit = Item::items[(*it)->getID()];
 			if (!iit.lookThrough) {
 				return (*it);
 			}
 		}
 
-		for (auto it = ItemVector::const_reverse_iterator(items->getEndTopItem()), end = ItemVector::const_reverse_iterator(items->getBeginTopItem()); it != end; ++it) {
+		for (auto it = TileItemVector::const_reverse_iterator(items->getEndTopItem()), end = TileItemVector::const_reverse_iterator(items->getBeginTopItem()); it != end; ++it) {
 			const ItemType &iit = Item::items[(*it)->getID()];
 			if (!iit.lookThrough) {
 				return (*it);
@@ -363,6 +365,10 @@ std::shared_ptr<Thing> Tile::getTopVisibleThing(std::shared_ptr<Creature> creatu
 }
 
 void Tile::onAddTileItem(std::shared_ptr<Item> item) {
+	if (const auto house = getHouse()) {
+		house->setItemsDirty();
+	}
+
 	if ((item->hasProperty(CONST_PROP_MOVABLE) || item->getContainer()) || (item->isWrapable() && !item->hasProperty(CONST_PROP_MOVABLE) && !item->hasProperty(CONST_PROP_BLOCKPATH))) {
 		auto it = g_game().browseFields.find(static_self_cast<Tile>());
 		if (it != g_game().browseFields.end()) {
@@ -436,6 +442,10 @@ void Tile::onAddTileItem(std::shared_ptr<Item> item) {
 }
 
 void Tile::onUpdateTileItem(std::shared_ptr<Item> oldItem, const ItemType &oldType, std::shared_ptr<Item> newItem, const ItemType &newType) {
+	if (const auto house = getHouse()) {
+		house->setItemsDirty();
+	}
+
 	if ((newItem->hasProperty(CONST_PROP_MOVABLE) || newItem->getContainer()) || (newItem->isWrapable() && newItem->hasProperty(CONST_PROP_MOVABLE) && !oldItem->hasProperty(CONST_PROP_BLOCKPATH))) {
 		auto it = g_game().browseFields.find(getTile());
 		if (it != g_game().browseFields.end()) {
@@ -478,6 +488,10 @@ void Tile::onUpdateTileItem(std::shared_ptr<Item> oldItem, const ItemType &oldTy
 }
 
 void Tile::onRemoveTileItem(const CreatureVector &spectators, const std::vector<int32_t> &oldStackPosVector, std::shared_ptr<Item> item) {
+	if (const auto house = getHouse()) {
+		house->setItemsDirty();
+	}
+
 	if ((item->hasProperty(CONST_PROP_MOVABLE) || item->getContainer()) || (item->isWrapable() && !item->hasProperty(CONST_PROP_MOVABLE) && !item->hasProperty(CONST_PROP_BLOCKPATH))) {
 		auto it = g_game().browseFields.find(getTile());
 		if (it != g_game().browseFields.end()) {
@@ -744,16 +758,14 @@ ReturnValue Tile::queryAdd(int32_t, const std::shared_ptr<Thing> &thing, uint32_
 		} else {
 			// FLAG_IGNOREBLOCKITEM is set
 			if (ground) {
-				const ItemType &iiType = Item::items[ground->getID()];
-				if (iiType.blockSolid && (!iiType.movable || ground->hasAttribute(ItemAttribute_t::UNIQUEID))) {
+				if (ground->isBlocking() && (!ground->isMovable() || ground->hasAttribute(ItemAttribute_t::UNIQUEID))) {
 					return RETURNVALUE_NOTPOSSIBLE;
 				}
 			}
 
 			if (const auto items = getItemList()) {
 				for (auto &item : *items) {
-					const ItemType &iiType = Item::items[item->getID()];
-					if (iiType.blockSolid && (!iiType.movable || item->hasAttribute(ItemAttribute_t::UNIQUEID))) {
+					if (item->isBlocking() && (!item->isMovable() || item->hasAttribute(ItemAttribute_t::UNIQUEID))) {
 						return RETURNVALUE_NOTPOSSIBLE;
 					}
 				}
@@ -789,14 +801,14 @@ ReturnValue Tile::queryAdd(int32_t, const std::shared_ptr<Thing> &thing, uint32_
 			}
 		} else {
 			if (ground) {
-				const ItemType &iiType = Item::items[ground->getID()];
-				if (iiType.blockSolid) {
-					if ((!iiType.pickupable && iiType.type != ITEM_TYPE_TRASHHOLDER) || item->isMagicField() || item->isBlocking()) {
+				const ItemTypeHot &iiType = Item::items.getHot(ground->getID());
+				if (iiType.has(ItemTypeHot::BLOCK_SOLID)) {
+					if ((!iiType.has(ItemTypeHot::PICKUPABLE) && !iiType.has(ItemTypeHot::TRASH_HOLDER)) || item->isMagicField() || item->isBlocking()) {
 						if (!item->isPickupable() && !item->isCarpet()) {
 							return RETURNVALUE_NOTENOUGHROOM;
 						}
 
-						if (!iiType.hasHeight) {
+						if (!iiType.has(ItemTypeHot::HAS_HEIGHT)) {
 							return RETURNVALUE_NOTENOUGHROOM;
 						}
 					}
@@ -805,12 +817,12 @@ ReturnValue Tile::queryAdd(int32_t, const std::shared_ptr<Thing> &thing, uint32_
 
 			if (items) {
 				for (auto &tileItem : *items) {
-					const ItemType &iiType = Item::items[tileItem->getID()];
-					if (!iiType.blockSolid || iiType.type == ITEM_TYPE_TRASHHOLDER) {
+					const ItemTypeHot &iiType = Item::items.getHot(tileItem->getID());
+					if (!iiType.has(ItemTypeHot::BLOCK_SOLID) || iiType.has(ItemTypeHot::TRASH_HOLDER)) {
 						continue;
 					}
 
-					if (iiType.pickupable && !item->isMagicField() && !item->isBlocking()) {
+					if (iiType.has(ItemTypeHot::PICKUPABLE) && !item->isMagicField() && !item->isBlocking()) {
 						continue;
 					}
 
@@ -818,7 +830,7 @@ ReturnValue Tile::queryAdd(int32_t, const std::shared_ptr<Thing> &thing, uint32_
 						return RETURNVALUE_NOTENOUGHROOM;
 					}
 
-					if (!iiType.hasHeight || iiType.pickupable) {
+					if (!iiType.has(ItemTypeHot::HAS_HEIGHT) || iiType.has(ItemTypeHot::PICKUPABLE)) {
 						return RETURNVALUE_NOTENOUGHROOM;
 					}
 				}
@@ -992,9 +1004,10 @@ void Tile::addThing(int32_t, std::shared_ptr<Thing> thing) {
 		return /*RETURNVALUE_NOTPOSSIBLE*/;
 	}
 
+	updateVersion();
+
 	std::shared_ptr<Creature> creature = thing->getCreature();
 	if (creature) {
-		Spectators::clearCache();
 		creature->setParent(static_self_cast<Tile>());
 
 		CreatureVector* creatures = makeCreatures();
@@ -1016,6 +1029,7 @@ void Tile::addThing(int32_t, std::shared_ptr<Thing> thing) {
 		if (itemType.isGroundTile()) {
 			if (ground == nullptr) {
 				ground = item;
+				updatePathBlock();
 				onAddTileItem(item);
 			} else {
 				const ItemType &oldType = Item::items[ground->getID()];
@@ -1031,7 +1045,7 @@ void Tile::addThing(int32_t, std::shared_ptr<Thing> thing) {
 		} else if (item->isAlwaysOnTop()) {
 			if (itemType.isSplash() && items) {
 				// remove old splash if exists
-				for (ItemVector::const_iterator it = items->getBeginTopItem(), end = items->getEndTopItem(); it != end; ++it) {
+				for (TileItemVector::const_iterator it = items->getBeginTopItem(), end = items->getEndTopItem(); it != end; ++it) {
 					std::shared_ptr<Item> oldSplash = *it;
 					if (!Item::items[oldSplash->getID()].isSplash()) {
 						continue;
@@ -1049,7 +1063,7 @@ void Tile::addThing(int32_t, std::shared_ptr<Thing> thing) {
 			if (items) {
 				for (auto it = items->getBeginTopItem(), end = items->getEndTopItem(); it != end; ++it) {
 					// Note: this is different from internalAddThing
-					if (itemType.alwaysOnTopOrder <= Item::items[(*it)->getID()].alwaysOnTopOrder) {
+					if (itemType.alwaysOnTopOrder <= Item::items.getHot((*it)->getID()).alwaysOnTopOrder) {
 						items->insert(it, item);
 						isInserted = true;
 						break;
@@ -1068,7 +1082,7 @@ void Tile::addThing(int32_t, std::shared_ptr<Thing> thing) {
 			if (itemType.isMagicField()) {
 				// remove old field item if exists
 				if (items) {
-					for (ItemVector::const_iterator it = items->getBeginDownItem(), end = items->getEndDownItem(); it != end; ++it) {
+					for (TileItemVector::const_iterator it = items->getBeginDownItem(), end = items->getEndDownItem(); it != end; ++it) {
 						std::shared_ptr<MagicField> oldField = (*it)->getMagicField();
 						if (oldField) {
 							if (oldField->isReplaceable()) {
@@ -1106,6 +1120,7 @@ void Tile::updateThing(std::shared_ptr<Thing> thing, uint16_t itemId, uint32_t c
 		return /*RETURNVALUE_NOTPOSSIBLE*/;
 	}
 
+	updateVersion();
 	const ItemType &oldType = Item::items[item->getID()];
 	const ItemType &newType = Item::items[itemId];
 	resetTileFlags(item);
@@ -1123,6 +1138,7 @@ void Tile::replaceThing(uint32_t index, std::shared_ptr<Thing> thing) {
 		return /*RETURNVALUE_NOTPOSSIBLE*/;
 	}
 
+	updateVersion();
 	std::shared_ptr<Item> oldItem = nullptr;
 	bool isInserted = false;
 
@@ -1187,13 +1203,13 @@ void Tile::replaceThing(uint32_t index, std::shared_ptr<Thing> thing) {
 }
 
 void Tile::removeThing(std::shared_ptr<Thing> thing, uint32_t count) {
+	updateVersion();
 	std::shared_ptr<Creature> creature = thing->getCreature();
 	if (creature) {
 		CreatureVector* creatures = getCreatures();
 		if (creatures) {
 			auto it = std::find(creatures->begin(), creatures->end(), thing);
 			if (it != creatures->end()) {
-				Spectators::clearCache();
 				creatures->erase(it);
 			}
 		}
@@ -1213,6 +1229,7 @@ void Tile::removeThing(std::shared_ptr<Thing> thing, uint32_t count) {
 	if (item == ground) {
 		ground->resetParent();
 		ground = nullptr;
+		updatePathBlock();
 
 		auto spectators = Spectators().find<Creature>(getPosition(), true);
 		onRemoveTileItem(spectators.data(), std::vector<int32_t>(spectators.size(), 0), item);
@@ -1272,7 +1289,7 @@ void Tile::removeThing(std::shared_ptr<Thing> thing, uint32_t count) {
 }
 
 void Tile::removeCreature(std::shared_ptr<Creature> creature) {
-	g_game().map.getMapSector(tilePos.x, tilePos.y)->removeCreature(creature);
+	g_game().map.getMapSector(tilePos.x, tilePos.y)->removeCreature(creature, tilePos.z);
 	removeThing(creature, 0);
 }
 
@@ -1327,7 +1344,7 @@ int32_t Tile::getThingIndex(std::shared_ptr<Thing> thing) const {
 	return -1;
 }
 
-int32_t Tile::getClientIndexOfCreature(std::shared_ptr<Player> player, std::shared_ptr<Creature> creature) const {
+int32_t Tile::getClientIndexOfCreature(const std::shared_ptr<Player> &player, const std::shared_ptr<Creature> &creature) const {
 	int32_t n;
 	if (ground) {
 		n = 1;
@@ -1352,7 +1369,7 @@ int32_t Tile::getClientIndexOfCreature(std::shared_ptr<Player> player, std::shar
 	return -1;
 }
 
-int32_t Tile::getStackposOfCreature(std::shared_ptr<Player> player, std::shared_ptr<Creature> creature) const {
+int32_t Tile::getStackposOfCreature(const std::shared_ptr<Player> &player, const std::shared_ptr<Creature> &creature) const {
 	int32_t n;
 	if (ground) {
 		n = 1;
@@ -1382,7 +1399,7 @@ int32_t Tile::getStackposOfCreature(std::shared_ptr<Player> player, std::shared_
 	return -1;
 }
 
-int32_t Tile::getStackposOfItem(std::shared_ptr<Player> player, std::shared_ptr<Item> item) const {
+int32_t Tile::getStackposOfItem(const std::shared_ptr<Player> &player, const std::shared_ptr<Item> &item) const {
 	int32_t n = 0;
 	if (ground) {
 		if (ground == item) {
@@ -1575,6 +1592,8 @@ void Tile::internalAddThing(uint32_t, std::shared_ptr<Thing> thing) {
 	if (!thing) {
 		return;
 	}
+
+	updateVersion();
 	for (const auto &zone : getZones()) {
 		zone->thingAdded(thing);
 	}
@@ -1583,8 +1602,6 @@ void Tile::internalAddThing(uint32_t, std::shared_ptr<Thing> thing) {
 
 	std::shared_ptr<Creature> creature = thing->getCreature();
 	if (creature) {
-		Spectators::clearCache();
-
 		CreatureVector* creatures = makeCreatures();
 		creatures->insert(creatures->begin(), creature);
 	} else {
@@ -1610,7 +1627,7 @@ void Tile::internalAddThing(uint32_t, std::shared_ptr<Thing> thing) {
 		if (item->isAlwaysOnTop()) {
 			bool isInserted = false;
 			for (auto it = items->getBeginTopItem(), end = items->getEndTopItem(); it != end; ++it) {
-				if (Item::items[(*it)->getID()].alwaysOnTopOrder > itemType.alwaysOnTopOrder) {
+				if (Item::items.getHot((*it)->getID()).alwaysOnTopOrder > itemType.alwaysOnTopOrder) {
 					items->insert(it, item);
 					isInserted = true;
 					break;
@@ -1635,10 +1652,14 @@ void Tile::updateTileFlags(const std::shared_ptr<Item> &item) {
 }
 
 void Tile::setTileFlags(const std::shared_ptr<Item> &item) {
+	if (item->isGroundTile() || item->hasProperty(CONST_PROP_BLOCKPROJECTILE)) {
+		Map::invalidateSightLines();
+	}
+
 	if (!hasFlag(TILESTATE_FLOORCHANGE)) {
-		const auto &it = Item::items[item->getID()];
-		if (it.floorChange != 0) {
-			setFlag(it.floorChange);
+		const auto floorChange = Item::items.getHot(item->getID()).floorChange;
+		if (floorChange != 0) {
+			setFlag(floorChange);
 		}
 	}
 
@@ -1719,11 +1740,16 @@ void Tile::setTileFlags(const std::shared_ptr<Item> &item) {
 	if (item->hasProperty(CONST_PROP_SUPPORTHANGABLE)) {
 		setFlag(TILESTATE_SUPPORTS_HANGABLE);
 	}
+
+	updatePathBlock();
 }
 
 void Tile::resetTileFlags(const std::shared_ptr<Item> &item) {
-	const ItemType &it = Item::items[item->getID()];
-	if (it.floorChange != 0) {
+	if (item->isGroundTile() || item->hasProperty(CONST_PROP_BLOCKPROJECTILE)) {
+		Map::invalidateSightLines();
+	}
+
+	if (Item::items.getHot(item->getID()).floorChange != 0) {
 		resetFlag(TILESTATE_FLOORCHANGE);
 	}
 
@@ -1800,6 +1826,31 @@ void Tile::resetTileFlags(const std::shared_ptr<Item> &item) {
 	if (item->hasProperty(CONST_PROP_SUPPORTHANGABLE)) {
 		resetFlag(TILESTATE_SUPPORTS_HANGABLE);
 	}
+
+	updatePathBlock();
+}
+
+void Tile::updateVersion() {
+	static std::atomic_uint32_t lastVersion = 0;
+	version = lastVersion.fetch_add(1, std::memory_order_relaxed) + 1;
+}
+
+void Tile::updatePathBlock() const {
+	const auto sector = g_game().map.getMapSector(tilePos.x, tilePos.y);
+	if (!sector) {
+		return;
+	}
+
+	const auto &floor = sector->getFloor(tilePos.z);
+	if (!floor) {
+		return;
+	}
+
+	floor->setPathBlocked(tilePos.x, tilePos.y, isPathBlocked());
+	if (floor->setWalkBlocked(tilePos.x, tilePos.y, isWalkBlocked())) {
+		FlowField::invalidate(tilePos);
+		HierarchicalPath::invalidate(tilePos);
+	}
 }
 
 bool Tile::isMovableBlocking() const {
@@ -1838,7 +1889,9 @@ std::shared_ptr<Item> Tile::getDoorItem() const {
 }
 
 void Tile::addZone(std::shared_ptr<Zone> zone) {
-	zones.emplace(zone);
+	if (const auto it = std::ranges::lower_bound(zones, zone); it == zones.end() || *it != zone) {
+		zones.insert(it, zone);
+	}
 	const auto &items = getItemList();
 	if (items) {
 		for (const auto &item : *items) {
@@ -1853,13 +1906,33 @@ void Tile::addZone(std::shared_ptr<Zone> zone) {
 	}
 }
 
+void Tile::removeZone(const std::shared_ptr<Zone> &zone) {
+	const auto it = std::ranges::lower_bound(zones, zone);
+	if (it == zones.end() || *it != zone) {
+		return;
+	}
+	const auto &items = getItemList();
+	if (items) {
+		for (const auto &item : *items) {
+			zone->itemRemoved(item);
+		}
+	}
+	const auto &creatures = getCreatures();
+	if (creatures) {
+		for (const auto &creature : *creatures) {
+			zone->creatureRemoved(creature);
+		}
+	}
+	zones.erase(it);
+}
+
 void Tile::clearZones() {
-	std::vector<std::shared_ptr<Zone>> zonesToRemove;
-	for (const auto &zone : zones) {
+	for (auto it = zones.begin(); it != zones.end();) {
+		const auto &zone = *it;
 		if (zone->isStatic()) {
+			++it;
 			continue;
 		}
-		zonesToRemove.emplace_back(zone);
 		const auto &items = getItemList();
 		if (items) {
 			for (const auto &item : *items) {
@@ -1872,8 +1945,6 @@ void Tile::clearZones() {
 				zone->creatureRemoved(creature);
 			}
 		}
-	}
-	for (const auto &zone : zonesToRemove) {
-		zones.erase(zone);
+		it = zones.erase(it);
 	}
 }
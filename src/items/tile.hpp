@@ -13,6 +13,7 @@
 #include "declarations.hpp"
 #include "items/item.hpp"
 #include "utils/tools.hpp"
+#include "utils/small_vector.hpp"
 
 class Creature;
 class Teleport;
@@ -25,25 +26,75 @@ class Zone;
 
 using CreatureVector = std::vector<std::shared_ptr<Creature>>;
 using ItemVector = std::vector<std::shared_ptr<Item>>;
+// Sorted by address, so the zones of two tiles are compared and diffed in one pass
+using ZoneVector = stdext::small_vector<std::shared_ptr<Zone>, 1>;
+
+/**
+ * Most tiles hold only a few items, up to TILE_INLINE_ITEMS are stored inline, without a heap block.
+ * The down item count is kept next to the storage, so the top/down lookups stay in the same cache lines.
+ */
+class TileItemVector {
+	static constexpr size_t TILE_INLINE_ITEMS = 4;
+	using Storage = stdext::small_vector<std::shared_ptr<Item>, TILE_INLINE_ITEMS>;
 
-class TileItemVector : private ItemVector {
 public:
-	using ItemVector::at;
-	using ItemVector::begin;
-	using ItemVector::clear;
-	using ItemVector::const_iterator;
-	using ItemVector::const_reverse_iterator;
-	using ItemVector::empty;
-	using ItemVector::end;
-	using ItemVector::erase;
-	using ItemVector::insert;
-	using ItemVector::iterator;
-	using ItemVector::push_back;
-	using ItemVector::rbegin;
-	using ItemVector::rend;
-	using ItemVector::reverse_iterator;
-	using ItemVector::size;
-	using ItemVector::value_type;
+	using value_type = Storage::value_type;
+	using iterator = Storage::iterator;
+	using const_iterator = Storage::const_iterator;
+	using reverse_iterator = Storage::reverse_iterator;
+	using const_reverse_iterator = Storage::const_reverse_iterator;
+
+	iterator begin() {
+		return items.begin();
+	}
+	const_iterator begin() const {
+		return items.begin();
+	}
+	iterator end() {
+		return items.end();
+	}
+	const_iterator end() const {
+		return items.end();
+	}
+	reverse_iterator rbegin() {
+		return items.rbegin();
+	}
+	const_reverse_iterator rbegin() const {
+		return items.rbegin();
+	}
+	reverse_iterator rend() {
+		return items.rend();
+	}
+	const_reverse_iterator rend() const {
+		return items.rend();
+	}
+
+	size_t size() const {
+		return items.size();
+	}
+	bool empty() const {
+		return items.empty();
+	}
+	void clear() {
+		items.clear();
+	}
+
+	const std::shared_ptr<Item> &at(size_t index) const {
+		return items.at(index);
+	}
+	std::shared_ptr<Item> &at(size_t index) {
+		return items.at(index);
+	}
+
+	void push_back(const std::shared_ptr<Item> &item) {
+		items.push_back(item);
+	}
+	iterator insert(const_iterator pos, const std::shared_ptr<Item> &item) {
+		return items.insert(pos, item);
+	}
+	iterator erase(const_iterator pos) {
+		return items.erase(pos);
+	}
 
 	iterator getBeginDownItem() {
 		return begin();
@@ -97,6 +148,7 @@ public:
 
 private:
 	uint32_t downItemCount = 0;
+	Storage items;
 };
 
 class Tile : public Cylinder, public SharedObject {
@@ -144,13 +196,13 @@ public:
 
 	std::shared_ptr<Creature> getTopCreature() const;
 	std::shared_ptr<Creature> getBottomCreature() const;
-	std::shared_ptr<Creature> getTopVisibleCreature(std::shared_ptr<Creature> creature) const;
+	std::shared_ptr<Creature> getTopVisibleCreature(const std::shared_ptr<Creature> &creature) const;
 
-	std::shared_ptr<Creature> getBottomVisibleCreature(std::shared_ptr<Creature> creature) const;
+	std::shared_ptr<Creature> getBottomVisibleCreature(const std::shared_ptr<Creature> &creature) const;
 	std::shared_ptr<Item> getTopTopItem() const;
 	std::shared_ptr<Item> getTopDownItem() const;
 	bool isMovableBlocking() const;
-	std::shared_ptr<Thing> getTopVisibleThing(std::shared_ptr<Creature> creature);
+	std::shared_ptr<Thing> getTopVisibleThing(const std::shared_ptr<Creature> &creature);
 	std::shared_ptr<Item> getItemByTopOrder(int32_t topOrder);
 
 	size_t getThingCount() const {
@@ -179,9 +231,10 @@ public:
 		this->flags &= ~flag;
 	}
 	void addZone(std::shared_ptr<Zone> zone);
+	void removeZone(const std::shared_ptr<Zone> &zone);
 	void clearZones();
 
-	auto getZones() const {
+	const ZoneVector &getZones() const {
 		return zones;
 	}
 
@@ -202,9 +255,9 @@ public:
 
 	std::string getDescription(int32_t lookDistance) override final;
 
-	int32_t getClientIndexOfCreature(std::shared_ptr<Player> player, std::shared_ptr<Creature> creature) const;
-	int32_t getStackposOfCreature(std::shared_ptr<Player> player, std::shared_ptr<Creature> creature) const;
-	int32_t getStackposOfItem(std::shared_ptr<Player> player, std::shared_ptr<Item> item) const;
+	int32_t getClientIndexOfCreature(const std::shared_ptr<Player> &player, const std::shared_ptr<Creature> &creature) const;
+	int32_t getStackposOfCreature(const std::shared_ptr<Player> &player, const std::shared_ptr<Creature> &creature) const;
+	int32_t getStackposOfItem(const std::shared_ptr<Player> &player, const std::shared_ptr<Item> &item) const;
 
 	// cylinder implementations
 	ReturnValue queryAdd(int32_t index, const std::shared_ptr<Thing> &thing, uint32_t count, uint32_t flags, std::shared_ptr<Creature> actor = nullptr) override;
@@ -241,6 +294,15 @@ public:
 		return tilePos;
 	}
 
+	/**
+	 * Changes each time an item or creature is added, updated or removed,
+	 * so what was serialized from the tile can be checked against it.
+	 * Versions are unique among all tiles, a tile recreated at the same position never repeats one.
+	 */
+	uint32_t getVersion() const {
+		return version;
+	}
+
 	bool isRemoved() override final {
 		return false;
 	}
@@ -261,6 +323,26 @@ public:
 		}
 	}
 
+	/**
+	 * No creature can path through this tile, regardless of who is walking.
+	 */
+	bool isPathBlocked() const {
+		return ground == nullptr || hasFlag(TILESTATE_FLOORCHANGE | TILESTATE_TELEPORT);
+	}
+
+	/**
+	 * Static obstacle the flow fields and portal graphs route around.
+	 */
+	bool isWalkBlocked() const {
+		return ground == nullptr || hasFlag(TILESTATE_BLOCKSOLID | TILESTATE_IMMOVABLEBLOCKPATH | TILESTATE_FLOORCHANGE | TILESTATE_TELEPORT | TILESTATE_PROTECTIONZONE);
+	}
+
+	/**
+	 * Mirrors isPathBlocked and isWalkBlocked into the bits of the floor (see Floor::isPathBlocked),
+	 * the flow fields and portal graphs around the tile are only dropped when isWalkBlocked flips.
+	 */
+	void updatePathBlock() const;
+
 private:
 	void onAddTileItem(std::shared_ptr<Item> item);
 	void onUpdateTileItem(std::shared_ptr<Item> oldItem, const ItemType &oldType, std::shared_ptr<Item> newItem, const ItemType &newType);
@@ -269,6 +351,7 @@ private:
 
 	void setTileFlags(const std::shared_ptr<Item> &item);
 	void resetTileFlags(const std::shared_ptr<Item> &item);
+	void updateVersion();
 	bool hasHarmfulField() const;
 	ReturnValue checkNpcCanWalkIntoTile() const;
 
@@ -276,7 +359,9 @@ protected:
 	std::shared_ptr<Item> ground = nullptr;
 	Position tilePos;
 	uint32_t flags = 0;
-	std::unordered_set<std::shared_ptr<Zone>> zones;
+	// Fits in the padding before zones
+	uint32_t version = 0;
+	ZoneVector zones;
 };
 
 // Used for walkable tiles, where there is high likeliness of
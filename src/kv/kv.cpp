@@ -10,7 +10,11 @@
 #include "pch.hpp"
 
 #include "kv/kv.hpp"
+#include "game/memory_census.hpp"
+#include "kv/value_wrapper_flat.hpp"
+#include "utils/tools.hpp"
 #include "lib/di/container.hpp"
+#include "lib/metrics/measured_lock.hpp"
 
 int64_t KV::lastTimestamp_ = 0;
 uint64_t KV::counter_ = 0;
@@ -30,59 +34,388 @@ void KVStore::set(const std::string &key, const std::initializer_list<std::pair<
 	set(key, wrappedInitList);
 }
 
-void KVStore::set(const std::string &key, const ValueWrapper &value) {
-	std::scoped_lock lock(mutex_);
-	return setLocked(key, value);
+namespace {
+	const std::string &fullKey(const std::string &key) {
+		return key;
+	}
+
+	std::string fullKey(const KVScopedKey &key) {
+		return key.str();
+	}
+
+	IntType clampCounter(int64_t value) {
+		return static_cast<IntType>(std::clamp<int64_t>(value, std::numeric_limits<IntType>::min(), std::numeric_limits<IntType>::max()));
+	}
+
+	IntType toCounter(const ValueWrapper &value) {
+		if (const auto* number = std::get_if<IntType>(&value.getVariant())) {
+			return *number;
+		}
+		// Numbers set from Lua are doubles
+		return clampCounter(std::llround(value.getNumber()));
+	}
 }
 
-void KVStore::setLocked(const std::string &key, const ValueWrapper &value) {
+void KVStore::set(const std::string &key, const ValueWrapper &value) {
 	logger.trace("KVStore::set({})", key);
-	auto it = store_.find(key);
-	if (it != store_.end()) {
-		it->second.first = value;
-		lruQueue_.splice(lruQueue_.begin(), lruQueue_, it->second.second);
+	auto &shard = shardFor(key);
+	metrics::measured_lock lock(shard.mutex, __METHOD_NAME__);
+	return setLocked(shard, key, value);
+}
+
+void KVStore::set(const KVScopedKey &key, const ValueWrapper &value) {
+	auto &shard = shardFor(key);
+	metrics::measured_lock lock(shard.mutex, __METHOD_NAME__);
+	return setLocked(shard, key, value);
+}
+
+template <typename Key>
+void KVStore::setLocked(Shard &shard, const Key &key, const ValueWrapper &value, bool dirty /*= true*/) {
+	auto it = shard.entries.find(key);
+	if (it != shard.entries.end()) {
+		releaseValue(shard, it->second);
+		storeValue(shard, it->second, value);
+		it->second.referenced = true;
+		if (dirty) {
+			markDirty(it->second);
+		}
+		return;
+	}
+
+	Entry entry;
+	entry.dirty = dirty;
+	std::optional<size_t> slot;
+	if (shard.entries.size() >= MAX_SHARD_SIZE) {
+		logger.debug("KVStore::set() - MAX_SIZE reached, removing an old element");
+		slot = evictLocked(shard);
+	}
+
+	storeValue(shard, entry, value);
+	auto [inserted, _] = shard.entries.try_emplace(fullKey(key), std::move(entry));
+	if (slot) {
+		shard.clock[*slot] = &inserted->first;
 	} else {
-		if (store_.size() >= MAX_SIZE) {
-			logger.debug("KVStore::set() - MAX_SIZE reached, removing last element");
-			auto last = lruQueue_.end();
-			last--;
-			save(*last, store_[*last].first);
-			store_.erase(*last);
-			lruQueue_.pop_back();
+		// Over the limit until the save in progress commits
+		shard.clock.emplace_back(&inserted->first);
+	}
+}
+
+void KVStore::storeValue(Shard &shard, Entry &entry, const ValueWrapper &value) {
+	entry.timestamp = value.getTimestamp();
+	entry.deleted = value.isDeleted();
+	if (entry.deleted) {
+		return;
+	}
+
+	if (const auto* number = std::get_if<IntType>(&value.getVariant())) {
+		entry.number = *number;
+		entry.isInteger = true;
+		return;
+	}
+
+	if (FlatSerializable::isScalar(value)) {
+		thread_local std::string buffer;
+		buffer.clear();
+		if (FlatSerializable::encode(value, buffer) && buffer.size() <= KVArena::MAX_BLOCK) {
+			entry.flat = shard.arena.allocate(buffer.size());
+			entry.flatSize = static_cast<uint32_t>(buffer.size());
+			std::memcpy(entry.flat, buffer.data(), buffer.size());
+			return;
+		}
+	}
+	entry.boxed = std::make_unique<ValueWrapper>(value);
+}
+
+void KVStore::releaseValue(Shard &shard, Entry &entry) {
+	if (entry.flat) {
+		shard.arena.deallocate(entry.flat, entry.flatSize);
+		entry.flat = nullptr;
+		entry.flatSize = 0;
+	}
+	entry.boxed.reset();
+	entry.isInteger = false;
+}
+
+ValueWrapper KVStore::valueOf(const Entry &entry) {
+	if (entry.deleted) {
+		return ValueWrapper::deleted();
+	}
+	if (entry.isInteger) {
+		return ValueWrapper(entry.number, entry.timestamp);
+	}
+	if (entry.flat) {
+		// Encoded by storeValue, it is always valid
+		return FlatSerializable::decode(entry.flat, entry.flatSize, entry.timestamp).value_or(ValueWrapper(entry.timestamp));
+	}
+	return entry.boxed ? *entry.boxed : ValueWrapper(entry.timestamp);
+}
+
+std::optional<size_t> KVStore::evictLocked(Shard &shard) {
+	// Ends within two rounds, the first one clears every flag
+	for (size_t step = 0; step < shard.clock.size() * 2; ++step) {
+		if (shard.hand >= shard.clock.size()) {
+			shard.hand = 0;
+		}
+		const auto slot = shard.hand++;
+		auto it = shard.entries.find(*shard.clock[slot]);
+		if (it->second.referenced) {
+			it->second.referenced = false;
+			continue;
+		}
+		if (it->second.saving > 0) {
+			continue;
 		}
 
-		lruQueue_.push_front(key);
-		store_.try_emplace(key, std::make_pair(value, lruQueue_.begin()));
+		if (it->second.dirty) {
+			save(it->first, valueOf(it->second));
+		}
+		++evictions_;
+		invalidatePrefetched(it->first);
+		releaseValue(shard, it->second);
+		shard.entries.erase(it);
+		return slot;
 	}
+	return std::nullopt;
 }
 
 std::optional<ValueWrapper> KVStore::get(const std::string &key, bool forceLoad /*= false */) {
 	logger.trace("KVStore::get({})", key);
-	std::scoped_lock lock(mutex_);
-	if (forceLoad || !store_.contains(key)) {
-		auto value = load(key);
+	auto &shard = shardFor(key);
+	metrics::measured_lock lock(shard.mutex, __METHOD_NAME__);
+	return getLocked(shard, key, forceLoad);
+}
+
+std::optional<ValueWrapper> KVStore::get(const KVScopedKey &key, bool forceLoad /*= false */) {
+	auto &shard = shardFor(key);
+	metrics::measured_lock lock(shard.mutex, __METHOD_NAME__);
+	return getLocked(shard, key, forceLoad);
+}
+
+template <typename Key>
+std::optional<ValueWrapper> KVStore::getLocked(Shard &shard, const Key &key, bool forceLoad) {
+	auto it = forceLoad ? shard.entries.end() : shard.entries.find(key);
+	if (it == shard.entries.end()) {
+		const auto &loadKey = fullKey(key);
+		if (!forceLoad && isPrefetched(loadKey)) {
+			return std::nullopt;
+		}
+		auto value = load(loadKey);
 		if (value) {
-			setLocked(key, *value);
+			setLocked(shard, loadKey, *value, false);
 		}
 		return value;
 	}
 
-	auto &[value, lruIt] = store_[key];
-	if (value.isDeleted()) {
-		lruQueue_.splice(lruQueue_.end(), lruQueue_, lruIt);
+	auto &entry = it->second;
+	if (entry.deleted) {
+		// Left for the hand to evict first
+		entry.referenced = false;
 		return std::nullopt;
 	}
-	lruQueue_.splice(lruQueue_.begin(), lruQueue_, lruIt);
-	return value;
+	entry.referenced = true;
+	return valueOf(entry);
+}
+
+IntType KVStore::increment(const std::string &key, IntType delta /*= 1*/) {
+	auto &shard = shardFor(key);
+	metrics::measured_lock lock(shard.mutex, __METHOD_NAME__);
+	return updateCounterLocked(shard, key, CounterOp::Add, delta);
+}
+
+IntType KVStore::updateMax(const std::string &key, IntType value) {
+	auto &shard = shardFor(key);
+	metrics::measured_lock lock(shard.mutex, __METHOD_NAME__);
+	return updateCounterLocked(shard, key, CounterOp::Max, value);
+}
+
+IntType KVStore::updateMin(const std::string &key, IntType value) {
+	auto &shard = shardFor(key);
+	metrics::measured_lock lock(shard.mutex, __METHOD_NAME__);
+	return updateCounterLocked(shard, key, CounterOp::Min, value);
+}
+
+IntType KVStore::updateCounter(const KVScopedKey &key, CounterOp op, IntType operand) {
+	auto &shard = shardFor(key);
+	metrics::measured_lock lock(shard.mutex, __METHOD_NAME__);
+	return updateCounterLocked(shard, key, op, operand);
+}
+
+template <typename Key>
+IntType KVStore::updateCounterLocked(Shard &shard, const Key &key, CounterOp op, IntType operand) {
+	std::optional<IntType> current;
+	auto it = shard.entries.find(key);
+	if (it == shard.entries.end()) {
+		if (auto loaded = getLocked(shard, key, false)) {
+			current = toCounter(*loaded);
+		}
+		it = shard.entries.find(key);
+	} else if (!it->second.deleted) {
+		current = it->second.isInteger ? it->second.number : toCounter(valueOf(it->second));
+	}
+
+	IntType result = operand;
+	if (op == CounterOp::Add) {
+		result = clampCounter(static_cast<int64_t>(current.value_or(0)) + operand);
+	} else if (current) {
+		result = op == CounterOp::Max ? std::max(*current, operand) : std::min(*current, operand);
+	}
+
+	if (it == shard.entries.end() || !it->second.isInteger) {
+		setLocked(shard, key, ValueWrapper(result));
+		return result;
+	}
+
+	auto &entry = it->second;
+	entry.referenced = true;
+	// Unchanged counters are not written again
+	if (entry.number != result) {
+		entry.number = result;
+		entry.timestamp = static_cast<uint64_t>(getTimeMsNow());
+		markDirty(entry);
+	}
+	return result;
+}
+
+void KVStore::prefetch(const std::string &prefix) {
+	const auto evictions = evictions_.load();
+	for (const auto &[key, value] : loadPrefixValues(prefix + ".")) {
+		auto &shard = shardFor(key);
+		metrics::measured_lock lock(shard.mutex, __METHOD_NAME__);
+		// What is in memory is newer than the database
+		if (!shard.entries.contains(key)) {
+			setLocked(shard, key, value, false);
+		}
+	}
+
+	// An eviction meanwhile may have dropped one of the entries just loaded
+	std::scoped_lock lock(prefetchMutex_);
+	if (evictions_.load() == evictions) {
+		prefetched_.emplace(prefix);
+	}
+}
+
+void KVStore::forgetPrefetch(const std::string &prefix) {
+	std::scoped_lock lock(prefetchMutex_);
+	prefetched_.erase(prefix);
+}
+
+bool KVStore::isPrefetched(std::string_view key) {
+	std::scoped_lock lock(prefetchMutex_);
+	if (prefetched_.empty()) {
+		return false;
+	}
+	for (auto pos = key.find('.'); pos != std::string_view::npos; pos = key.find('.', pos + 1)) {
+		if (prefetched_.contains(key.substr(0, pos))) {
+			return true;
+		}
+	}
+	return false;
+}
+
+void KVStore::invalidatePrefetched(std::string_view key) {
+	std::scoped_lock lock(prefetchMutex_);
+	for (auto pos = key.find('.'); pos != std::string_view::npos && !prefetched_.empty(); pos = key.find('.', pos + 1)) {
+		if (auto it = prefetched_.find(key.substr(0, pos)); it != prefetched_.end()) {
+			prefetched_.erase(it);
+		}
+	}
+}
+
+void KVStore::flush() {
+	saveAll();
+	for (auto &shard : shards_) {
+		metrics::measured_lock lock(shard.mutex, __METHOD_NAME__);
+		phmap::erase_if(shard.entries, [this, &shard](auto &entry) {
+			auto &cached = entry.second;
+			// Changed meanwhile (or not saved) entries are kept for the next save, the ones another save is writing until it commits
+			if (cached.dirty || cached.referenced || cached.saving > 0) {
+				cached.referenced = false;
+				return false;
+			}
+			++evictions_;
+			invalidatePrefetched(entry.first);
+			releaseValue(shard, cached);
+			return true;
+		});
+
+		shard.clock.clear();
+		shard.hand = 0;
+		for (const auto &[key, entry] : shard.entries) {
+			shard.clock.emplace_back(&key);
+		}
+	}
+}
+
+void KVStore::clear() {
+	{
+		std::scoped_lock lock(prefetchMutex_);
+		prefetched_.clear();
+	}
+	for (auto &shard : shards_) {
+		metrics::measured_lock lock(shard.mutex, __METHOD_NAME__);
+		shard.entries.clear();
+		shard.clock.clear();
+		shard.hand = 0;
+		shard.arena.clear();
+	}
+}
+
+void KVStore::countMemory(MemoryCensus &census) {
+	for (auto &shard : shards_) {
+		metrics::measured_lock lock(shard.mutex, __METHOD_NAME__);
+		// A node holds the key and the entry, the table one pointer and a control byte per slot
+		uint64_t bytes = shard.entries.capacity() * (sizeof(void*) + 1) + shard.clock.capacity() * sizeof(const std::string*) + shard.arena.reserved();
+		for (const auto &[key, entry] : shard.entries) {
+			bytes += sizeof(std::pair<const std::string, Entry>) + MemoryCensus::heapBytes(key);
+			if (entry.boxed) {
+				bytes += sizeof(ValueWrapper);
+			}
+		}
+		census.add("kv", shard.entries.size(), bytes);
+	}
+}
+
+KVStore::DirtyEntries KVStore::takeDirty() {
+	DirtyEntries dirty;
+	for (auto &shard : shards_) {
+		metrics::measured_lock lock(shard.mutex, __METHOD_NAME__);
+		for (auto &[key, entry] : shard.entries) {
+			if (entry.dirty) {
+				dirty.entries.emplace_back(key, valueOf(entry));
+				dirty.versions.emplace_back(entry.version);
+				++entry.saving;
+			}
+		}
+	}
+	return dirty;
+}
+
+void KVStore::releaseDirty(const DirtyEntries &taken, bool saved) {
+	for (size_t i = 0; i < taken.entries.size(); ++i) {
+		const auto &key = taken.entries[i].first;
+		auto &shard = shardFor(key);
+		metrics::measured_lock lock(shard.mutex, __METHOD_NAME__);
+		// Pinned by takeDirty, only clear drops it meanwhile
+		auto it = shard.entries.find(key);
+		if (it == shard.entries.end() || it->second.saving == 0) {
+			continue;
+		}
+		auto &entry = it->second;
+		--entry.saving;
+		if (saved && entry.version == taken.versions[i]) {
+			entry.dirty = false;
+		}
+	}
 }
 
 std::unordered_set<std::string> KVStore::keys(const std::string &prefix /*= ""*/) {
-	std::scoped_lock lock(mutex_);
 	std::unordered_set<std::string> keys;
-	for (const auto &[key, value] : store_) {
-		if (key.find(prefix) == 0) {
-			std::string suffix = key.substr(prefix.size());
-			keys.insert(suffix);
+	for (auto &shard : shards_) {
+		metrics::measured_lock lock(shard.mutex, __METHOD_NAME__);
+		for (const auto &[key, entry] : shard.entries) {
+			if (key.find(prefix) == 0) {
+				keys.insert(key.substr(prefix.size()));
+			}
 		}
 	}
 	for (const auto &key : loadPrefix(prefix)) {
@@ -96,6 +429,19 @@ void KV::remove(const std::string &key) {
 }
 
 std::shared_ptr<KV> KVStore::scoped(const std::string &scope) {
+	std::scoped_lock lock(scopesMutex_);
+	if (auto it = scopes_.find(scope); it != scopes_.end()) {
+		return it->second;
+	}
+
 	logger.trace("KVStore::scoped({})", scope);
-	return std::make_shared<ScopedKV>(logger, *this, scope);
+	auto handle = makeScope(scope);
+	if (scopes_.size() < MAX_CACHED_SCOPES) {
+		scopes_.try_emplace(scope, handle);
+	}
+	return handle;
+}
+
+std::shared_ptr<KV> KVStore::makeScope(const std::string &prefix) {
+	return std::make_shared<ScopedKV>(logger, *this, prefix);
 }
@@ -17,11 +17,69 @@
 	#include <optional>
 	#include <unordered_set>
 	#include <iomanip>
-	#include <list>
+	#include <array>
+	#include <vector>
 #endif
 
 #include "lib/logging/logger.hpp"
 #include "kv/value_wrapper.hpp"
+#include "kv/kv_arena.hpp"
+
+class MemoryCensus;
+
+/**
+ * A key inside a scope, looked up without joining the prefix and the key into a new string.
+ * prefixHash already covers "prefix.", so only the key itself is hashed on each access.
+ */
+struct KVScopedKey {
+	std::string_view prefix;
+	uint64_t prefixHash = 0;
+	std::string_view key;
+
+	std::string str() const {
+		return fmt::format("{}.{}", prefix, key);
+	}
+};
+
+// Hashes keys as a stream of bytes (FNV-1a), so a full key and the same key split in a KVScopedKey hash alike
+struct KVKeyHash {
+	using is_transparent = void;
+
+	static constexpr uint64_t SEED = 14695981039346656037ull;
+
+	static uint64_t append(uint64_t hash, std::string_view data) {
+		for (const auto c : data) {
+			hash = (hash ^ static_cast<uint8_t>(c)) * 1099511628211ull;
+		}
+		return hash;
+	}
+
+	static uint64_t scopeHash(std::string_view prefix) {
+		return append(append(SEED, prefix), ".");
+	}
+
+	size_t operator()(std::string_view key) const {
+		return append(SEED, key);
+	}
+	size_t operator()(const KVScopedKey &key) const {
+		return append(key.prefixHash, key.key);
+	}
+};
+
+struct KVKeyEqual {
+	using is_transparent = void;
+
+	bool operator()(std::string_view lhs, std::string_view rhs) const {
+		return lhs == rhs;
+	}
+	bool operator()(std::string_view full, const KVScopedKey &key) const {
+		return full.size() == key.prefix.size() + 1 + key.key.size() && full.starts_with(key.prefix)
+			&& full[key.prefix.size()] == '.' && full.ends_with(key.key);
+	}
+	bool operator()(const KVScopedKey &key, std::string_view full) const {
+		return (*this)(full, key);
+	}
+};
 
 class KV : public std::enable_shared_from_this<KV> {
 public:
@@ -31,6 +89,15 @@ public:
 
 	virtual std::optional<ValueWrapper> get(const std::string &key, bool forceLoad = false) = 0;
 
+	/**
+	 * Counters, updated in place under the lock and kept as integers, so there is no get and set round trip.
+	 * A missing key starts from 0 for increment and from value for the others, a double is rounded first.
+	 * @return the value after the update.
+	 */
+	virtual IntType increment(const std::string &key, IntType delta = 1) = 0;
+	virtual IntType updateMax(const std::string &key, IntType value) = 0;
+	virtual IntType updateMin(const std::string &key, IntType value) = 0;
+
 	virtual bool saveAll() {
 		return true;
 	}
@@ -85,57 +152,185 @@ public:
 
 	std::optional<ValueWrapper> get(const std::string &key, bool forceLoad = false) override;
 
-	void flush() override {
-		std::scoped_lock lock(mutex_);
-		KV::flush();
-		store_.clear();
-	}
+	IntType increment(const std::string &key, IntType delta = 1) override;
+	IntType updateMax(const std::string &key, IntType value) override;
+	IntType updateMin(const std::string &key, IntType value) override;
+
+	// Used by ScopedKV, the full key is only built when it is not in memory yet
+	void set(const KVScopedKey &key, const ValueWrapper &value);
+	std::optional<ValueWrapper> get(const KVScopedKey &key, bool forceLoad = false);
+
+	enum class CounterOp : uint8_t {
+		Add,
+		Max,
+		Min,
+	};
+	IntType updateCounter(const KVScopedKey &key, CounterOp op, IntType operand);
+
+	// Saves the changed entries and drops the ones not used since the last flush, the hot ones stay loaded
+	void flush() override;
+
+	// Drops every entry, changes that were not saved are lost
+	void clear();
+
+	// Adds the entries in memory, their keys, values and the shard arenas
+	void countMemory(MemoryCensus &census);
 
 	std::shared_ptr<KV> scoped(const std::string &scope) override final;
 	std::unordered_set<std::string> keys(const std::string &prefix = "");
 
-protected:
-	phmap::parallel_flat_hash_map<std::string, std::pair<ValueWrapper, std::list<std::string>::iterator>> getStore() {
-		std::scoped_lock lock(mutex_);
-		phmap::parallel_flat_hash_map<std::string, std::pair<ValueWrapper, std::list<std::string>::iterator>> copy;
-		for (const auto &[key, value] : store_) {
-			copy.try_emplace(key, value);
-		}
-		return copy;
+	// A scope that is not kept by the store, for the ones owned by an object (e.g. a player)
+	std::shared_ptr<KV> makeScope(const std::string &prefix);
+
+	/**
+	 * Loads every entry of the scope prefix in one query. Until forgetPrefetch, or until one of them is evicted,
+	 * keys of the scope that are not in memory do not exist, so a get for them does not reach the backend either.
+	 */
+	void prefetch(const std::string &prefix);
+	void forgetPrefetch(const std::string &prefix);
+
+	// Moves the persistence to an embedded file at path, for the backends that support one
+	virtual bool useEmbeddedStorage(const std::string &path) {
+		return false;
 	}
 
+protected:
+	// The changed entries taken by takeDirty and the version each one had then
+	struct DirtyEntries {
+		std::vector<std::pair<std::string, ValueWrapper>> entries;
+		std::vector<uint32_t> versions;
+	};
+
+	/**
+	 * The changed entries, copied shard by shard, only one shard is locked at a time.
+	 * They stay dirty and are not evicted until releaseDirty, so a reload never reads what is not committed yet.
+	 */
+	DirtyEntries takeDirty();
+	// Releases the entries taken by takeDirty, the ones not changed since are marked as saved if the commit succeeded
+	void releaseDirty(const DirtyEntries &taken, bool saved);
+
 protected:
 	Logger &logger;
 
 	virtual std::optional<ValueWrapper> load(const std::string &key) = 0;
 	virtual bool save(const std::string &key, const ValueWrapper &value) = 0;
 	virtual std::vector<std::string> loadPrefix(const std::string &prefix = "") = 0;
+	// The keys and values starting with prefix, the keys are returned whole
+	virtual std::vector<std::pair<std::string, ValueWrapper>> loadPrefixValues(const std::string &prefix) {
+		return {};
+	}
 
 private:
-	void setLocked(const std::string &key, const ValueWrapper &value);
+	// The scopes asked for by name are kept and handed out again, up to MAX_CACHED_SCOPES per parent
+	static constexpr size_t MAX_CACHED_SCOPES = 64;
+
+	static constexpr size_t SHARD_COUNT = 16;
+	static constexpr size_t MAX_SHARD_SIZE = MAX_SIZE / SHARD_COUNT;
+
+	/**
+	 * Integers are kept as they are, so counters are updated in place, other scalars flat encoded
+	 * (see FlatSerializable) in the shard arena, the rest as a ValueWrapper.
+	 * Maps stay whole, their items are shared with the callers that set and got them.
+	 */
+	struct Entry {
+		std::unique_ptr<ValueWrapper> boxed;
+		char* flat = nullptr;
+		uint32_t flatSize = 0;
+		// Bumped on every change, so a save only settles the value it took
+		uint32_t version = 0;
+		IntType number = 0;
+		uint64_t timestamp = 0;
+		bool isInteger = false;
+		bool deleted = false;
+		// Set on every access, the eviction hand clears it and evicts the entries found without it
+		bool referenced = true;
+		// Changed since it was loaded or last saved
+		bool dirty = false;
+		// Saves taking it right now, it can not be evicted until they commit
+		uint8_t saving = 0;
+	};
+
+	/**
+	 * Each shard has its own lock and evicts with CLOCK: keys are kept in a ring and a hand walks it,
+	 * so reads only set a flag instead of moving the key in a list.
+	 */
+	struct Shard {
+		std::mutex mutex;
+		// Node based, the ring points to the keys
+		phmap::node_hash_map<std::string, Entry, KVKeyHash, KVKeyEqual> entries;
+		std::vector<const std::string*> clock;
+		size_t hand = 0;
+		KVArena arena;
+	};
+
+	static void storeValue(Shard &shard, Entry &entry, const ValueWrapper &value);
+	// Frees what the entry holds in the arena, before it is erased or overwritten
+	static void releaseValue(Shard &shard, Entry &entry);
+	static ValueWrapper valueOf(const Entry &entry);
+
+	template <typename Key>
+	Shard &shardFor(const Key &key) {
+		// The high bits, the low ones pick the bucket inside the shard
+		return shards_[(KVKeyHash {}(key) >> 32) % SHARD_COUNT];
+	}
+
+	template <typename Key>
+	void setLocked(Shard &shard, const Key &key, const ValueWrapper &value, bool dirty = true);
+	template <typename Key>
+	std::optional<ValueWrapper> getLocked(Shard &shard, const Key &key, bool forceLoad);
+	template <typename Key>
+	IntType updateCounterLocked(Shard &shard, const Key &key, CounterOp op, IntType operand);
+	// Saves and removes an entry the hand finds unreferenced, returns its place in the ring or nullopt if every entry is being saved
+	std::optional<size_t> evictLocked(Shard &shard);
+	static void markDirty(Entry &entry) {
+		entry.dirty = true;
+		++entry.version;
+	}
+
+	std::mutex scopesMutex_;
+	phmap::flat_hash_map<std::string, std::shared_ptr<KV>> scopes_;
 
-	phmap::parallel_flat_hash_map<std::string, std::pair<ValueWrapper, std::list<std::string>::iterator>> store_;
-	std::list<std::string> lruQueue_;
-	std::mutex mutex_;
+	friend class ScopedKV;
+
+	// Whether key is in a prefetched scope, so it does not exist if it is not in memory
+	bool isPrefetched(std::string_view key);
+	// Called when an entry is evicted, its scopes are not complete in memory anymore
+	void invalidatePrefetched(std::string_view key);
+
+	std::mutex prefetchMutex_;
+	phmap::flat_hash_set<std::string> prefetched_;
+	std::atomic<uint64_t> evictions_ = 0;
+
+	std::array<Shard, SHARD_COUNT> shards_;
 };
 
 class ScopedKV final : public KV {
 public:
 	ScopedKV(Logger &logger, KVStore &rootKV, const std::string &prefix) :
-		logger(logger), rootKV_(rootKV), prefix_(prefix) { }
+		logger(logger), rootKV_(rootKV), prefix_(prefix), prefixHash_(KVKeyHash::scopeHash(prefix_)) { }
 
 	void set(const std::string &key, const std::initializer_list<ValueWrapper> &init_list) override {
-		rootKV_.set(buildKey(key), init_list);
+		rootKV_.set(scopedKey(key), ValueWrapper(init_list));
 	}
 	void set(const std::string &key, const std::initializer_list<std::pair<const std::string, ValueWrapper>> &init_list) override {
-		rootKV_.set(buildKey(key), init_list);
+		rootKV_.set(scopedKey(key), ValueWrapper(init_list));
 	}
 	void set(const std::string &key, const ValueWrapper &value) override {
-		rootKV_.set(buildKey(key), value);
+		rootKV_.set(scopedKey(key), value);
 	}
 
 	std::optional<ValueWrapper> get(const std::string &key, bool forceLoad = false) override {
-		return rootKV_.get(buildKey(key), forceLoad);
+		return rootKV_.get(scopedKey(key), forceLoad);
+	}
+
+	IntType increment(const std::string &key, IntType delta = 1) override {
+		return rootKV_.updateCounter(scopedKey(key), KVStore::CounterOp::Add, delta);
+	}
+	IntType updateMax(const std::string &key, IntType value) override {
+		return rootKV_.updateCounter(scopedKey(key), KVStore::CounterOp::Max, value);
+	}
+	IntType updateMin(const std::string &key, IntType value) override {
+		return rootKV_.updateCounter(scopedKey(key), KVStore::CounterOp::Min, value);
 	}
 
 	template <typename T>
@@ -152,8 +347,17 @@ public:
 	}
 
 	std::shared_ptr<KV> scoped(const std::string &scope) override final {
+		std::scoped_lock lock(childrenMutex_);
+		if (auto it = children_.find(scope); it != children_.end()) {
+			return it->second;
+		}
+
 		logger.trace("ScopedKV::scoped({})", buildKey(scope));
-		return std::make_shared<ScopedKV>(logger, rootKV_, buildKey(scope));
+		auto child = std::make_shared<ScopedKV>(logger, rootKV_, buildKey(scope));
+		if (children_.size() < KVStore::MAX_CACHED_SCOPES) {
+			children_.try_emplace(scope, child);
+		}
+		return child;
 	}
 
 	std::unordered_set<std::string> keys(const std::string &prefix = "") override {
@@ -165,9 +369,17 @@ private:
 		return fmt::format("{}.{}", prefix_, key);
 	}
 
+	KVScopedKey scopedKey(const std::string &key) const {
+		return KVScopedKey { prefix_, prefixHash_, key };
+	}
+
 	Logger &logger;
 	KVStore &rootKV_;
 	std::string prefix_;
+	uint64_t prefixHash_;
+
+	std::mutex childrenMutex_;
+	phmap::flat_hash_map<std::string, std::shared_ptr<KV>> children_;
 };
 
 constexpr auto g_kv = KVStore::getInstance;
@@ -0,0 +1,77 @@
+/**
+ * Canary - A free and open-source MMORPG server emulator
+ * Copyright (©) 2019-2024 OpenTibiaBR <opentibiabr@outlook.com>
+ * Repository: https://github.com/opentibiabr/canary
+ * License: https://github.com/opentibiabr/canary/blob/main/LICENSE
+ * Contributors: https://github.com/opentibiabr/canary/graphs/contributors
+ * Website: https://docs.opentibiabr.com/
+ */
+
+
+#pragma once
+
+/**
+ * Storage for the small values of a KV shard, blocks are carved from big chunks and
+ * recycled through free lists, one per size class, instead of going through the global allocator.
+ * Chunks are only released by clear(). Not thread safe, the shard lock guards it.
+ */
+class KVArena {
+public:
+	static constexpr size_t MAX_BLOCK = 256;
+
+	KVArena() = default;
+	KVArena(const KVArena &) = delete;
+	KVArena &operator=(const KVArena &) = delete;
+
+	char* allocate(size_t size) {
+		const auto index = classOf(size);
+		if (auto* block = freeLists[index]) {
+			freeLists[index] = block->next;
+			return reinterpret_cast<char*>(block);
+		}
+
+		const auto blockSize = (index + 1) * GRANULE;
+		if (chunkUsed + blockSize > CHUNK_SIZE) {
+			chunks.emplace_back(std::make_unique<char[]>(CHUNK_SIZE));
+			chunkUsed = 0;
+		}
+		auto* block = chunks.back().get() + chunkUsed;
+		chunkUsed += blockSize;
+		return block;
+	}
+
+	// size is the one the block was allocated with
+	void deallocate(char* block, size_t size) noexcept {
+		const auto index = classOf(size);
+		auto* freed = reinterpret_cast<FreeBlock*>(block);
+		freed->next = freeLists[index];
+		freeLists[index] = freed;
+	}
+
+	void clear() {
+		chunks.clear();
+		freeLists.fill(nullptr);
+		chunkUsed = CHUNK_SIZE;
+	}
+
+	size_t reserved() const {
+		return chunks.size() * CHUNK_SIZE;
+	}
+
+private:
+	struct FreeBlock {
+		FreeBlock* next;
+	};
+
+	static constexpr size_t GRANULE = sizeof(FreeBlock);
+	static constexpr size_t CLASS_COUNT = MAX_BLOCK / GRANULE;
+	static constexpr size_t CHUNK_SIZE = 64 * 1024;
+
+	static size_t classOf(size_t size) {
+		return size == 0 ? 0 : (size - 1) / GRANULE;
+	}
+
+	std::array<FreeBlock*, CLASS_COUNT> freeLists {};
+	std::vector<std::unique_ptr<char[]>> chunks;
+	size_t chunkUsed = CHUNK_SIZE;
+};
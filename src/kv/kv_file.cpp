@@ -0,0 +1,341 @@
+/**
+ * Canary - A free and open-source MMORPG server emulator
+ * Copyright (©) 2019-2024 OpenTibiaBR <opentibiabr@outlook.com>
+ * Repository: https://github.com/opentibiabr/canary
+ * License: https://github.com/opentibiabr/canary/blob/main/LICENSE
+ * Contributors: https://github.com/opentibiabr/canary/graphs/contributors
+ * Website: https://docs.opentibiabr.com/
+ */
+
+
+#include "pch.hpp"
+
+#include "kv/kv_file.hpp"
+#include "kv/value_wrapper_proto.hpp"
+#include "lib/logging/logger.hpp"
+
+namespace {
+	constexpr size_t FRAME_HEADER_SIZE = sizeof(uint32_t) * 2;
+	constexpr size_t RECORD_HEADER_SIZE = sizeof(uint8_t) + sizeof(uint64_t) + sizeof(uint32_t);
+
+	// FNV-1a, detects the torn record at the end of the file a crash can leave
+	uint32_t checksum(std::string_view data) {
+		uint32_t hash = 2166136261u;
+		for (const auto c : data) {
+			hash = (hash ^ static_cast<uint8_t>(c)) * 16777619u;
+		}
+		return hash;
+	}
+
+	template <typename T>
+	void append(std::string &buffer, T value) {
+		buffer.append(reinterpret_cast<const char*>(&value), sizeof(T));
+	}
+
+	template <typename T>
+	bool read(std::string_view &data, T &value) {
+		if (data.size() < sizeof(T)) {
+			return false;
+		}
+		std::memcpy(&value, data.data(), sizeof(T));
+		data.remove_prefix(sizeof(T));
+		return true;
+	}
+
+	uint64_t recordSize(size_t keySize, size_t valueSize) {
+		return FRAME_HEADER_SIZE + RECORD_HEADER_SIZE + keySize + valueSize;
+	}
+}
+
+KVFileStorage::~KVFileStorage() {
+	closeHandles();
+}
+
+bool KVFileStorage::open(const std::string &filePath) {
+	std::scoped_lock lock(mutex);
+	closeHandles();
+	path = filePath;
+	slots.clear();
+	liveBytes = 0;
+	garbageBytes = 0;
+	fileSize = 0;
+
+	if (auto* input = std::fopen(path.c_str(), "rb")) {
+		const auto validSize = index(input);
+		std::fclose(input);
+
+		std::error_code error;
+		const auto size = static_cast<uint64_t>(std::filesystem::file_size(path, error));
+
+		fileSize = validSize;
+		if (validSize < size) {
+			logger.warn("[{}] - Cutting off the incomplete end of the KV file {}", __FUNCTION__, path);
+			std::filesystem::resize_file(path, validSize, error);
+			if (error) {
+				logger.error("[{}] - Failed to truncate the KV file {}: {}", __FUNCTION__, path, error.message());
+				return false;
+			}
+		}
+	}
+	emptyOnOpen = slots.empty();
+
+	if (garbageBytes >= MIN_COMPACT_GARBAGE && garbageBytes > liveBytes) {
+		logger.info("Compacting the KV file {}, {} of {} bytes are overwritten records...", path, garbageBytes, fileSize);
+		if (!compact()) {
+			return false;
+		}
+	}
+	return openHandles();
+}
+
+bool KVFileStorage::empty() const {
+	std::scoped_lock lock(mutex);
+	return emptyOnOpen;
+}
+
+uint64_t KVFileStorage::index(std::FILE* input) {
+	uint64_t offset = 0;
+	std::string payload;
+	while (true) {
+		char header[FRAME_HEADER_SIZE];
+		if (std::fread(header, 1, sizeof(header), input) != sizeof(header)) {
+			return offset;
+		}
+
+		std::string_view headerData(header, sizeof(header));
+		uint32_t size = 0;
+		uint32_t expected = 0;
+		read(headerData, size);
+		read(headerData, expected);
+		payload.resize(size);
+		if (size < RECORD_HEADER_SIZE || std::fread(payload.data(), 1, size, input) != size || checksum(payload) != expected) {
+			return offset;
+		}
+
+		std::string_view data = payload;
+		uint8_t type = 0;
+		uint64_t timestamp = 0;
+		uint32_t keySize = 0;
+		read(data, type);
+		read(data, timestamp);
+		read(data, keySize);
+		if (data.size() < keySize) {
+			return offset;
+		}
+
+		const std::string key(data.substr(0, keySize));
+		const auto valueSize = static_cast<uint32_t>(data.size() - keySize);
+		const auto frameSize = FRAME_HEADER_SIZE + size;
+		if (auto it = slots.find(key); it != slots.end()) {
+			dropLocked(it);
+		}
+
+		if (static_cast<RecordType>(type) == RecordType::Set) {
+			slots.emplace(key, Slot { offset + frameSize - valueSize, valueSize, timestamp });
+			liveBytes += frameSize;
+		} else {
+			garbageBytes += frameSize;
+		}
+		offset += frameSize;
+	}
+}
+
+void KVFileStorage::dropLocked(std::map<std::string, Slot, std::less<>>::iterator it) {
+	const auto size = recordSize(it->first.size(), it->second.size);
+	liveBytes -= size;
+	garbageBytes += size;
+	slots.erase(it);
+}
+
+bool KVFileStorage::compact() {
+	// The live records go to a new file, which replaces the old one only once complete
+	const auto temporaryPath = path + ".tmp";
+	std::ifstream input(path, std::ios::binary);
+	auto* output = std::fopen(temporaryPath.c_str(), "wb");
+	if (!input || !output) {
+		logger.error("[{}] - Failed to create the compacted KV file {}", __FUNCTION__, temporaryPath);
+		if (output) {
+			std::fclose(output);
+		}
+		return false;
+	}
+
+	bool success = true;
+	uint64_t offset = 0;
+	std::string value;
+	std::string buffer;
+	for (auto &[key, slot] : slots) {
+		value.resize(slot.size);
+		input.seekg(static_cast<std::streamoff>(slot.offset));
+		if (!input.read(value.data(), slot.size)) {
+			success = false;
+			break;
+		}
+
+		buffer.clear();
+		appendRecord(buffer, RecordType::Set, key, slot.timestamp, value);
+		if (std::fwrite(buffer.data(), 1, buffer.size(), output) != buffer.size()) {
+			success = false;
+			break;
+		}
+		slot.offset = offset + buffer.size() - slot.size;
+		offset += buffer.size();
+	}
+	input.close();
+	success = std::fclose(output) == 0 && success;
+
+	std::error_code error;
+	if (success) {
+		std::filesystem::rename(temporaryPath, path, error);
+	}
+	if (!success || error) {
+		logger.error("[{}] - Failed to compact the KV file {}", __FUNCTION__, path);
+		std::filesystem::remove(temporaryPath, error);
+		return false;
+	}
+
+	fileSize = offset;
+	liveBytes = offset;
+	garbageBytes = 0;
+	return true;
+}
+
+bool KVFileStorage::openHandles() {
+	writer = std::fopen(path.c_str(), "ab");
+	reader.open(path, std::ios::binary);
+	if (!writer || !reader.is_open()) {
+		logger.error("[{}] - Failed to open the KV file {}", __FUNCTION__, path);
+		closeHandles();
+		return false;
+	}
+	return true;
+}
+
+void KVFileStorage::closeHandles() {
+	if (writer) {
+		std::fclose(writer);
+		writer = nullptr;
+	}
+	if (reader.is_open()) {
+		reader.close();
+	}
+}
+
+void KVFileStorage::appendRecord(std::string &buffer, RecordType type, const std::string &key, uint64_t timestamp, std::string_view value) {
+	// [size][checksum] then the type, timestamp, key size, key and the value, which takes the rest
+	const auto payloadSize = RECORD_HEADER_SIZE + key.size() + value.size();
+	const auto start = buffer.size();
+	append(buffer, static_cast<uint32_t>(payloadSize));
+	append(buffer, uint32_t {});
+	append(buffer, static_cast<uint8_t>(type));
+	append(buffer, timestamp);
+	append(buffer, static_cast<uint32_t>(key.size()));
+	buffer.append(key);
+	buffer.append(value);
+
+	const auto hash = checksum(std::string_view(buffer).substr(start + FRAME_HEADER_SIZE));
+	std::memcpy(buffer.data() + start + sizeof(uint32_t), &hash, sizeof(hash));
+}
+
+std::optional<ValueWrapper> KVFileStorage::load(const std::string &key) {
+	std::scoped_lock lock(mutex);
+	auto it = slots.find(key);
+	if (it == slots.end()) {
+		return std::nullopt;
+	}
+	return readLocked(key, it->second);
+}
+
+std::optional<ValueWrapper> KVFileStorage::readLocked(const std::string &key, const Slot &slot) {
+	if (!reader.is_open()) {
+		return std::nullopt;
+	}
+
+	thread_local std::string data;
+	data.resize(slot.size);
+	// Cleared first, a failed read leaves the stream unusable otherwise
+	reader.clear();
+	reader.seekg(static_cast<std::streamoff>(slot.offset));
+	if (!reader.read(data.data(), slot.size)) {
+		logger.error("[{}] - Failed to read key {} from the KV file {}", __FUNCTION__, key, path);
+		return std::nullopt;
+	}
+
+	auto value = ProtoSerializable::deserialize(data.data(), data.size(), slot.timestamp);
+	if (!value) {
+		logger.error("Failed to deserialize value for key {}", key);
+	}
+	return value;
+}
+
+std::vector<std::string> KVFileStorage::loadPrefix(const std::string &prefix) {
+	std::vector<std::string> keys;
+	std::scoped_lock lock(mutex);
+	for (auto it = slots.lower_bound(prefix); it != slots.end() && it->first.starts_with(prefix); ++it) {
+		keys.emplace_back(it->first.substr(prefix.size()));
+	}
+	return keys;
+}
+
+std::vector<std::pair<std::string, ValueWrapper>> KVFileStorage::loadPrefixValues(const std::string &prefix) {
+	std::vector<std::pair<std::string, ValueWrapper>> values;
+	std::scoped_lock lock(mutex);
+	for (auto it = slots.lower_bound(prefix); it != slots.end() && it->first.starts_with(prefix); ++it) {
+		if (auto value = readLocked(it->first, it->second)) {
+			values.emplace_back(it->first, std::move(*value));
+		}
+	}
+	return values;
+}
+
+bool KVFileStorage::save(const std::vector<std::pair<std::string, ValueWrapper>> &entries) {
+	std::string buffer;
+	std::string data;
+	std::vector<std::pair<uint64_t, uint32_t>> written;
+	written.reserve(entries.size());
+	for (const auto &[key, value] : entries) {
+		data.clear();
+		if (value.isDeleted()) {
+			appendRecord(buffer, RecordType::Delete, key, value.getTimestamp(), {});
+		} else if (!ProtoSerializable::serialize(value, data)) {
+			logger.error("[{}] - Failed to serialize key {}", __FUNCTION__, key);
+			return false;
+		} else {
+			appendRecord(buffer, RecordType::Set, key, value.getTimestamp(), data);
+		}
+		// Where the value ends, relative to the start of the batch
+		written.emplace_back(buffer.size(), static_cast<uint32_t>(data.size()));
+	}
+
+	std::scoped_lock lock(mutex);
+	if (!writer) {
+		return false;
+	}
+
+	// Flushed to the kernel, so the batch outlives a crash of the process
+	if (std::fwrite(buffer.data(), 1, buffer.size(), writer) != buffer.size() || std::fflush(writer) != 0) {
+		logger.error("[{}] - Failed to write to the KV file {}", __FUNCTION__, path);
+		// What was written of the batch is left to be overwritten by the next one, or cut off on the next start
+		std::error_code error;
+		std::filesystem::resize_file(path, fileSize, error);
+		return false;
+	}
+
+	for (size_t i = 0; i < entries.size(); ++i) {
+		const auto &[key, value] = entries[i];
+		const auto [end, size] = written[i];
+		if (auto it = slots.find(key); it != slots.end()) {
+			dropLocked(it);
+		}
+
+		const auto frameSize = recordSize(key.size(), size);
+		if (value.isDeleted()) {
+			garbageBytes += frameSize;
+		} else {
+			slots.emplace(key, Slot { fileSize + end - size, size, value.getTimestamp() });
+			liveBytes += frameSize;
+		}
+	}
+	fileSize += buffer.size();
+	return true;
+}
@@ -0,0 +1,97 @@
+/**
+ * Canary - A free and open-source MMORPG server emulator
+ * Copyright (©) 2019-2024 OpenTibiaBR <opentibiabr@outlook.com>
+ * Repository: https://github.com/opentibiabr/canary
+ * License: https://github.com/opentibiabr/canary/blob/main/LICENSE
+ * Contributors: https://github.com/opentibiabr/canary/graphs/contributors
+ * Website: https://docs.opentibiabr.com/
+ */
+
+
+#pragma once
+
+#ifndef USE_PRECOMPILED_HEADERS
+	#include <fstream>
+	#include <map>
+	#include <mutex>
+	#include <optional>
+	#include <string>
+	#include <vector>
+#endif
+
+#include "kv/value_wrapper.hpp"
+
+class Logger;
+
+/**
+ * An embedded storage for the KV, kept in a file next to the server instead of the database.
+ * Every change is appended to the file as a checksummed record, and the offset of the live value of each key
+ * is indexed in key order, so prefix scans are range iterations over the index.
+ * The file is rewritten with only the live records when it is opened, once the overwritten ones outweigh them.
+ */
+class KVFileStorage {
+public:
+	explicit KVFileStorage(Logger &logger) :
+		logger(logger) { }
+	~KVFileStorage();
+
+	// Non copyable
+	KVFileStorage(const KVFileStorage &) = delete;
+	KVFileStorage &operator=(const KVFileStorage &) = delete;
+
+	/**
+	 * Indexes the records of the file at path, creating it if it does not exist.
+	 * An incomplete record at the end, left by a crash, is cut off.
+	 */
+	bool open(const std::string &path);
+
+	// Whether the file had no records when it was opened
+	bool empty() const;
+
+	std::optional<ValueWrapper> load(const std::string &key);
+	// The keys starting with prefix, without it
+	std::vector<std::string> loadPrefix(const std::string &prefix);
+	// The keys and values starting with prefix, the keys are returned whole
+	std::vector<std::pair<std::string, ValueWrapper>> loadPrefixValues(const std::string &prefix);
+
+	// Appends every entry in one write, deleted values remove their key, the index is only updated if it succeeds
+	bool save(const std::vector<std::pair<std::string, ValueWrapper>> &entries);
+
+private:
+	enum class RecordType : uint8_t {
+		Set,
+		Delete,
+	};
+
+	struct Slot {
+		uint64_t offset = 0;
+		uint32_t size = 0;
+		uint64_t timestamp = 0;
+	};
+
+	// Starts compacting once the overwritten records are at least this big, and bigger than the live ones
+	static constexpr uint64_t MIN_COMPACT_GARBAGE = 64 * 1024 * 1024;
+
+	static void appendRecord(std::string &buffer, RecordType type, const std::string &key, uint64_t timestamp, std::string_view value);
+
+	// Rebuilds the index from the file, returns where the valid records end
+	uint64_t index(std::FILE* input);
+	bool compact();
+	bool openHandles();
+	void closeHandles();
+	std::optional<ValueWrapper> readLocked(const std::string &key, const Slot &slot);
+	void dropLocked(std::map<std::string, Slot, std::less<>>::iterator it);
+
+	Logger &logger;
+	std::string path;
+
+	mutable std::mutex mutex;
+	std::FILE* writer = nullptr;
+	// Values are read at 64 bit offsets, the writer only appends
+	std::ifstream reader;
+	uint64_t fileSize = 0;
+	uint64_t liveBytes = 0;
+	uint64_t garbageBytes = 0;
+	bool emptyOnOpen = true;
+	std::map<std::string, Slot, std::less<>> slots;
+};
@@ -13,36 +13,64 @@
 #include "kv/value_wrapper_proto.hpp"
 #include "utils/tools.hpp"
 
-#include <kv.pb.h>
-
 std::optional<ValueWrapper> KVSQL::load(const std::string &key) {
-	auto query = fmt::format("SELECT `key_name`, `timestamp`, `value` FROM `kv_store` WHERE `key_name` = {}", db.escapeString(key));
+	if (file) {
+		return file->load(key);
+	}
+
+	DBStatement query("SELECT `key_name`, `timestamp`, `value` FROM `kv_store` WHERE `key_name` = ?");
+	query.bind(key);
 	auto result = db.storeQuery(query);
 	if (result == nullptr) {
 		return std::nullopt;
 	}
+	return parseValue(result, key);
+}
+
+std::vector<std::pair<std::string, ValueWrapper>> KVSQL::loadPrefixValues(const std::string &prefix) {
+	if (file) {
+		return file->loadPrefixValues(prefix);
+	}
+
+	std::vector<std::pair<std::string, ValueWrapper>> values;
+	DBStatement query("SELECT `key_name`, `timestamp`, `value` FROM `kv_store` WHERE `key_name` LIKE ?");
+	query.bind(prefix + "%");
+	auto result = db.storeQuery(query);
+	if (result == nullptr) {
+		return values;
+	}
+
+	do {
+		auto key = result->getString("key_name");
+		if (auto value = parseValue(result, key)) {
+			values.emplace_back(std::move(key), std::move(*value));
+		}
+	} while (result->next());
+	return values;
+}
 
+std::optional<ValueWrapper> KVSQL::parseValue(const DBResult_ptr &result, const std::string &key) {
 	unsigned long size;
 	auto data = result->getStream("value", size);
 	if (data == nullptr) {
 		return std::nullopt;
 	}
 
-	ValueWrapper valueWrapper;
-	auto timestamp = result->getNumber<uint64_t>("timestamp");
-	Canary::protobuf::kv::ValueWrapper protoValue;
-	if (protoValue.ParseFromArray(data, static_cast<int>(size))) {
-		valueWrapper = ProtoSerializable::fromProto(protoValue, timestamp);
-		return valueWrapper;
+	auto value = ProtoSerializable::deserialize(data, size, result->getNumber<uint64_t>("timestamp"));
+	if (!value) {
+		logger.error("Failed to deserialize value for key {}", key);
 	}
-	logger.error("Failed to deserialize value for key {}", key);
-	return std::nullopt;
+	return value;
 }
 
 std::vector<std::string> KVSQL::loadPrefix(const std::string &prefix /* = ""*/) {
+	if (file) {
+		return file->loadPrefix(prefix);
+	}
+
 	std::vector<std::string> keys;
-	std::string keySearch = db.escapeString(prefix + "%");
-	auto query = fmt::format("SELECT `key_name` FROM `kv_store` WHERE `key_name` LIKE {}", keySearch);
+	DBStatement query("SELECT `key_name` FROM `kv_store` WHERE `key_name` LIKE ?");
+	query.bind(prefix + "%");
 	auto result = db.storeQuery(query);
 	if (result == nullptr) {
 		return keys;
@@ -58,42 +86,135 @@ std::vector<std::string> KVSQL::loadPrefix(const std::string &prefix /* = ""*/)
 }
 
 bool KVSQL::save(const std::string &key, const ValueWrapper &value) {
-	auto update = dbUpdate();
-	prepareSave(key, value, update);
-	return update.execute();
+	if (file) {
+		return file->save({ { key, value } });
+	}
+
+	if (value.isDeleted()) {
+		return deleteKey(key);
+	}
+
+	std::string data;
+	if (!ProtoSerializable::serialize(value, data)) {
+		return false;
+	}
+
+	DBStatement query("INSERT INTO `kv_store` (`key_name`, `timestamp`, `value`) VALUES (?, ?, ?) ON DUPLICATE KEY UPDATE `timestamp` = VALUES(`timestamp`), `value` = VALUES(`value`)");
+	query.bind(key).bind(value.getTimestamp()).bindBlob(data.data(), data.size());
+	return db.executeQuery(query);
+}
+
+bool KVSQL::deleteKey(const std::string &key) {
+	DBStatement query("DELETE FROM `kv_store` WHERE `key_name` = ?");
+	query.bind(key);
+	return db.executeQuery(query);
+}
+
+bool KVSQL::deleteKeys(const std::vector<std::string> &keys) {
+	// In chunks, the queries stay far below the packet size
+	constexpr size_t chunkSize = 500;
+	for (size_t first = 0; first < keys.size(); first += chunkSize) {
+		std::string query = "DELETE FROM `kv_store` WHERE `key_name` IN (";
+		const auto last = std::min(first + chunkSize, keys.size());
+		for (size_t i = first; i < last; ++i) {
+			if (i != first) {
+				query.push_back(',');
+			}
+			query.append(db.escapeString(keys[i]));
+		}
+		query.push_back(')');
+		if (!db.executeQuery(query)) {
+			return false;
+		}
+	}
+	return true;
 }
 
 bool KVSQL::prepareSave(const std::string &key, const ValueWrapper &value, DBInsert &update) {
-	auto protoValue = ProtoSerializable::toProto(value);
 	std::string data;
-	if (!protoValue.SerializeToString(&data)) {
+	if (!ProtoSerializable::serialize(value, data)) {
 		return false;
 	}
-	if (value.isDeleted()) {
-		auto query = fmt::format("DELETE FROM `kv_store` WHERE `key_name` = {}", db.escapeString(key));
-		return db.executeQuery(query);
-	}
 
 	update.addRow(fmt::format("{}, {}, {}", db.escapeString(key), value.getTimestamp(), db.escapeString(data)));
 	return true;
 }
 
 bool KVSQL::saveAll() {
-	auto store = getStore();
-	bool success = DBTransaction::executeWithinTransaction([this, &store]() {
+	// Only what changed since the last save, in one multi-row upsert and one delete
+	const auto dirty = takeDirty();
+	if (dirty.entries.empty()) {
+		return true;
+	}
+
+	bool success = file ? file->save(dirty.entries) : DBTransaction::executeWithinTransaction([this, &dirty]() {
 		auto update = dbUpdate();
-		if (!std::ranges::all_of(store, [this, &update](const auto &kv) {
-				const auto &[key, value] = kv;
-				return prepareSave(key, value.first, update);
-			})) {
-			return false;
+		std::vector<std::string> deleted;
+		for (const auto &[key, value] : dirty.entries) {
+			if (value.isDeleted()) {
+				deleted.emplace_back(key);
+			} else if (!prepareSave(key, value, update)) {
+				return false;
+			}
 		}
-		return update.execute();
+		return update.execute() && deleteKeys(deleted);
 	});
 
+	releaseDirty(dirty, success);
 	if (!success) {
-		g_logger().error("[{}] Error occurred saving player", __FUNCTION__);
+		g_logger().error("[{}] Error occurred saving {} changed keys", __FUNCTION__, dirty.entries.size());
 	}
 
 	return success;
 }
+
+bool KVSQL::useEmbeddedStorage(const std::string &path) {
+	auto storage = std::make_unique<KVFileStorage>(logger);
+	if (!storage->open(path)) {
+		return false;
+	}
+
+	const bool seed = storage->empty();
+	file = std::move(storage);
+	if (seed && !importTable()) {
+		file.reset();
+		std::error_code error;
+		std::filesystem::remove(path, error);
+		return false;
+	}
+	return true;
+}
+
+bool KVSQL::importTable() {
+	// Keyset pagination, each page starts after the last key of the previous one
+	constexpr size_t pageSize = 10000;
+	size_t imported = 0;
+	std::string lastKey;
+	while (true) {
+		DBStatement query(fmt::format("SELECT `key_name`, `timestamp`, `value` FROM `kv_store` WHERE `key_name` > ? ORDER BY `key_name` LIMIT {}", pageSize));
+		query.bind(lastKey);
+		auto result = db.storeQuery(query);
+		if (result == nullptr) {
+			break;
+		}
+
+		std::vector<std::pair<std::string, ValueWrapper>> page;
+		do {
+			lastKey = result->getString("key_name");
+			if (auto value = parseValue(result, lastKey)) {
+				page.emplace_back(lastKey, std::move(*value));
+			}
+		} while (result->next());
+
+		if (!file->save(page)) {
+			logger.error("[{}] - Failed to import the kv_store table into the embedded storage", __FUNCTION__);
+			return false;
+		}
+		imported += page.size();
+	}
+
+	if (imported > 0) {
+		logger.info("Imported {} keys from the kv_store table into the embedded storage", imported);
+	}
+	return true;
+}
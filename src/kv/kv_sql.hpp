@@ -10,6 +10,7 @@
 #pragma once
 
 #include "kv/kv.hpp"
+#include "kv/kv_file.hpp"
 
 #include "database/database.hpp"
 #include "lib/logging/logger.hpp"
@@ -24,10 +25,23 @@ public:
 
 	bool saveAll() override;
 
+	/**
+	 * Keeps the entries in an embedded file at path instead of the kv_store table.
+	 * A new file is seeded with what the table has, the table is left as it is.
+	 */
+	bool useEmbeddedStorage(const std::string &path) override;
+
 private:
+	// Copies the kv_store table into the embedded storage, page by page
+	bool importTable();
+
 	std::vector<std::string> loadPrefix(const std::string &prefix = "") override;
 	std::optional<ValueWrapper> load(const std::string &key) override;
+	std::vector<std::pair<std::string, ValueWrapper>> loadPrefixValues(const std::string &prefix) override;
+	std::optional<ValueWrapper> parseValue(const DBResult_ptr &result, const std::string &key);
 	bool save(const std::string &key, const ValueWrapper &value) override;
+	bool deleteKey(const std::string &key);
+	bool deleteKeys(const std::vector<std::string> &keys);
 	bool prepareSave(const std::string &key, const ValueWrapper &value, DBInsert &update);
 
 	DBInsert dbUpdate() {
@@ -37,4 +51,5 @@ private:
 	}
 
 	Database &db;
+	std::unique_ptr<KVFileStorage> file;
 };
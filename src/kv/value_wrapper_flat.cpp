@@ -0,0 +1,209 @@
+/**
+ * Canary - A free and open-source MMORPG server emulator
+ * Copyright (©) 2019-2024 OpenTibiaBR <opentibiabr@outlook.com>
+ * Repository: https://github.com/opentibiabr/canary
+ * License: https://github.com/opentibiabr/canary/blob/main/LICENSE
+ * Contributors: https://github.com/opentibiabr/canary/graphs/contributors
+ * Website: https://docs.opentibiabr.com/
+ */
+
+
+#include "pch.hpp"
+
+#include "kv/value_wrapper_flat.hpp"
+
+#include "kv/value_wrapper.hpp"
+
+namespace {
+	// Doubles are copied as they are in memory
+	static_assert(std::endian::native == std::endian::little);
+
+	enum class FlatType : uint8_t {
+		String,
+		Boolean,
+		Int,
+		Double,
+		Map,
+	};
+
+	void putVarint(std::string &out, uint64_t value) {
+		while (value >= 0x80) {
+			out.push_back(static_cast<char>(value | 0x80));
+			value >>= 7;
+		}
+		out.push_back(static_cast<char>(value));
+	}
+
+	bool getVarint(const char* &pos, const char* end, uint64_t &value) {
+		value = 0;
+		for (int shift = 0; shift < 64 && pos < end; shift += 7) {
+			const auto byte = static_cast<uint8_t>(*pos++);
+			value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+			if ((byte & 0x80) == 0) {
+				return true;
+			}
+		}
+		return false;
+	}
+
+	bool getString(const char* &pos, const char* end, std::string &value) {
+		uint64_t size;
+		if (!getVarint(pos, end, size) || size > static_cast<uint64_t>(end - pos)) {
+			return false;
+		}
+		value.assign(pos, size);
+		pos += size;
+		return true;
+	}
+
+	bool encodeScalar(const ValueVariant &value, std::string &out) {
+		return std::visit(
+			[&out](const auto &arg) {
+				using T = std::decay_t<decltype(arg)>;
+				if constexpr (std::is_same_v<T, StringType>) {
+					out.push_back(static_cast<char>(FlatType::String));
+					putVarint(out, arg.size());
+					out.append(arg);
+				} else if constexpr (std::is_same_v<T, BooleanType>) {
+					out.push_back(static_cast<char>(FlatType::Boolean));
+					out.push_back(arg ? 1 : 0);
+				} else if constexpr (std::is_same_v<T, IntType>) {
+					// Zigzag, small negative numbers stay short too
+					const auto bits = static_cast<uint32_t>(arg);
+					out.push_back(static_cast<char>(FlatType::Int));
+					putVarint(out, (bits << 1) ^ static_cast<uint32_t>(arg >> 31));
+				} else if constexpr (std::is_same_v<T, DoubleType>) {
+					out.push_back(static_cast<char>(FlatType::Double));
+					char bytes[sizeof(DoubleType)];
+					std::memcpy(bytes, &arg, sizeof(bytes));
+					out.append(bytes, sizeof(bytes));
+				} else {
+					return false;
+				}
+				return true;
+			},
+			value
+		);
+	}
+
+	std::optional<ValueVariant> decodeScalar(const char* &pos, const char* end) {
+		if (pos >= end) {
+			return std::nullopt;
+		}
+
+		switch (static_cast<FlatType>(*pos++)) {
+			case FlatType::String: {
+				std::string value;
+				if (!getString(pos, end, value)) {
+					return std::nullopt;
+				}
+				return ValueVariant(std::move(value));
+			}
+			case FlatType::Boolean:
+				if (pos >= end) {
+					return std::nullopt;
+				}
+				return ValueVariant(*pos++ != 0);
+			case FlatType::Int: {
+				uint64_t value;
+				if (!getVarint(pos, end, value)) {
+					return std::nullopt;
+				}
+				const auto bits = static_cast<uint32_t>(value);
+				return ValueVariant(static_cast<IntType>((bits >> 1) ^ (~(bits & 1) + 1)));
+			}
+			case FlatType::Double: {
+				DoubleType value;
+				if (end - pos < static_cast<std::ptrdiff_t>(sizeof(value))) {
+					return std::nullopt;
+				}
+				std::memcpy(&value, pos, sizeof(value));
+				pos += sizeof(value);
+				return ValueVariant(value);
+			}
+			default:
+				return std::nullopt;
+		}
+	}
+}
+
+bool FlatSerializable::encode(const ValueWrapper &value, std::string &out) {
+	const auto size = out.size();
+	out.push_back(static_cast<char>(MARKER));
+
+	const auto* map = std::get_if<MapType>(&value.getVariant());
+	if (!map) {
+		if (encodeScalar(value.getVariant(), out)) {
+			return true;
+		}
+		out.resize(size);
+		return false;
+	}
+
+	if (map->size() > MAX_MAP_SIZE) {
+		out.resize(size);
+		return false;
+	}
+
+	out.push_back(static_cast<char>(FlatType::Map));
+	putVarint(out, map->size());
+	for (const auto &[key, item] : *map) {
+		putVarint(out, key.size());
+		out.append(key);
+		if (!item || !encodeScalar(item->getVariant(), out)) {
+			out.resize(size);
+			return false;
+		}
+	}
+	return true;
+}
+
+bool FlatSerializable::isFlat(const char* data, size_t size) {
+	return size > 0 && static_cast<uint8_t>(data[0]) == MARKER;
+}
+
+std::optional<ValueWrapper> FlatSerializable::decode(const char* data, size_t size, uint64_t timestamp) {
+	if (!isFlat(data, size) || size < 2) {
+		return std::nullopt;
+	}
+
+	const auto* pos = data + 1;
+	const auto* end = data + size;
+	if (static_cast<FlatType>(*pos) != FlatType::Map) {
+		auto value = decodeScalar(pos, end);
+		if (!value || pos != end) {
+			return std::nullopt;
+		}
+		return ValueWrapper(*value, timestamp);
+	}
+
+	++pos;
+	uint64_t count;
+	if (!getVarint(pos, end, count) || count > MAX_MAP_SIZE) {
+		return std::nullopt;
+	}
+
+	MapType map;
+	map.reserve(count);
+	for (uint64_t i = 0; i < count; ++i) {
+		std::string key;
+		if (!getString(pos, end, key)) {
+			return std::nullopt;
+		}
+		auto item = decodeScalar(pos, end);
+		if (!item) {
+			return std::nullopt;
+		}
+		map[std::move(key)] = std::make_shared<ValueWrapper>(*item, timestamp);
+	}
+
+	if (pos != end) {
+		return std::nullopt;
+	}
+	return ValueWrapper(ValueVariant(std::move(map)), timestamp);
+}
+
+bool FlatSerializable::isScalar(const ValueWrapper &value) {
+	const auto &variant = value.getVariant();
+	return !std::holds_alternative<ArrayType>(variant) && !std::holds_alternative<MapType>(variant);
+}
@@ -0,0 +1,30 @@
+/**
+ * Canary - A free and open-source MMORPG server emulator
+ * Copyright (©) 2019-2024 OpenTibiaBR <opentibiabr@outlook.com>
+ * Repository: https://github.com/opentibiabr/canary
+ * License: https://github.com/opentibiabr/canary/blob/main/LICENSE
+ * Contributors: https://github.com/opentibiabr/canary/graphs/contributors
+ * Website: https://docs.opentibiabr.com/
+ */
+
+
+#pragma once
+
+class ValueWrapper;
+
+/**
+ * A compact encoding for the common values: scalars and small maps of scalars.
+ * It starts with MARKER, a byte no protobuf encoded ValueWrapper starts with, so both can be told apart.
+ * Arrays, nested maps and maps bigger than MAX_MAP_SIZE are left to ProtoSerializable.
+ */
+struct FlatSerializable {
+	static constexpr uint8_t MARKER = 0xFF;
+	static constexpr size_t MAX_MAP_SIZE = 16;
+
+	// Appends the encoding of value to out, returns false (out is left as is) if it has no flat encoding
+	static bool encode(const ValueWrapper &value, std::string &out);
+	static bool isFlat(const char* data, size_t size);
+	static std::optional<ValueWrapper> decode(const char* data, size_t size, uint64_t timestamp);
+	// Whether value is a scalar, those are always encoded flat
+	static bool isScalar(const ValueWrapper &value);
+};
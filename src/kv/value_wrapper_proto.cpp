@@ -12,6 +12,7 @@
 #include "kv/value_wrapper_proto.hpp"
 
 #include "kv/value_wrapper.hpp"
+#include "kv/value_wrapper_flat.hpp"
 
 #include <kv.pb.h>
 
@@ -109,3 +110,22 @@ ValueWrapper ProtoSerializable::fromProto(const Canary::protobuf::kv::ValueWrapp
 	}
 	return ValueWrapper(data, timestamp);
 }
+
+bool ProtoSerializable::serialize(const ValueWrapper &obj, std::string &data) {
+	if (FlatSerializable::encode(obj, data)) {
+		return true;
+	}
+	return toProto(obj).SerializeToString(&data);
+}
+
+std::optional<ValueWrapper> ProtoSerializable::deserialize(const char* data, size_t size, uint64_t timestamp) {
+	if (FlatSerializable::isFlat(data, size)) {
+		return FlatSerializable::decode(data, size, timestamp);
+	}
+
+	Canary::protobuf::kv::ValueWrapper protoValue;
+	if (!protoValue.ParseFromArray(data, static_cast<int>(size))) {
+		return std::nullopt;
+	}
+	return fromProto(protoValue, timestamp);
+}
@@ -32,6 +32,10 @@ namespace Canary {
 struct ProtoSerializable {
 	static Canary::protobuf::kv::ValueWrapper toProto(const ValueWrapper &obj);
 	static ValueWrapper fromProto(const Canary::protobuf::kv::ValueWrapper &protoValue, uint64_t timestamp);
+
+	// The stored form of a value, flat encoded (see FlatSerializable) when it can be, otherwise as protobuf
+	static bool serialize(const ValueWrapper &obj, std::string &data);
+	static std::optional<ValueWrapper> deserialize(const char* data, size_t size, uint64_t timestamp);
 };
 
 namespace ProtoHelpers {
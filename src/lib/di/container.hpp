@@ -18,6 +18,8 @@ namespace di = boost::di;
 class DI final {
 private:
 	inline static di::extension::injector<>* testContainer;
+	// Bumped by setTestContainer, the instances cached by get under another generation are resolved again
+	inline static std::atomic<uint32_t> generation = 0;
 	const inline static auto defaultContainer = di::make_injector(
 		di::bind<AccountRepository>().to<AccountRepositoryDB>().in(di::singleton),
 		di::bind<KVStore>().to<KVSQL>().in(di::singleton),
@@ -27,6 +29,7 @@ private:
 public:
 	inline static void setTestContainer(di::extension::injector<>* container) {
 		testContainer = container;
+		generation.fetch_add(1, std::memory_order_release);
 	}
 
 	/**
@@ -43,10 +46,22 @@ public:
 	 * Get returns you a reference of a instance that the DI contains.
 	 * It will always return the same instance, it's used for singletons shared instances.
 	 * Instances acquired with get are managed by the DI and can be merely references.
+	 * The instance is resolved by the container once and cached, so the g_* accessors
+	 * cost two atomic loads instead of a container lookup.
 	 */
 	template <class T>
 	inline static T &get() {
-		return create<T &>();
+		static std::atomic<T*> cached = nullptr;
+		static std::atomic<uint32_t> cachedGeneration = 0;
+
+		const auto current = generation.load(std::memory_order_acquire);
+		auto* instance = cached.load(std::memory_order_acquire);
+		if (!instance || cachedGeneration.load(std::memory_order_relaxed) != current) [[unlikely]] {
+			instance = &create<T &>();
+			cachedGeneration.store(current, std::memory_order_relaxed);
+			cached.store(instance, std::memory_order_release);
+		}
+		return *instance;
 	}
 };
 
@@ -7,6 +7,7 @@
  * Website: https://docs.opentibiabr.com/
  */
 #include <spdlog/spdlog.h>
+#include <spdlog/async.h>
 
 #include "pch.hpp"
 #include "lib/di/container.hpp"
@@ -38,3 +39,19 @@ std::string LogWithSpdLog::getLevel() const {
 void LogWithSpdLog::log(const std::string &lvl, const fmt::basic_string_view<char> msg) const {
 	spdlog::log(spdlog::level::from_str(lvl), msg);
 }
+
+void LogWithSpdLog::setAsync(size_t queueSize, bool dropWhenFull) {
+	const auto current = spdlog::default_logger();
+	if (std::dynamic_pointer_cast<spdlog::async_logger>(current)) {
+		return;
+	}
+
+	// Same sinks, so the pattern and the colors are kept
+	spdlog::init_thread_pool(std::max<size_t>(queueSize, 1), 1);
+	const auto &sinks = current->sinks();
+	const auto policy = dropWhenFull ? spdlog::async_overflow_policy::overrun_oldest : spdlog::async_overflow_policy::block;
+	auto asyncLogger = std::make_shared<spdlog::async_logger>(current->name(), sinks.begin(), sinks.end(), spdlog::thread_pool(), policy);
+	asyncLogger->set_level(current->level());
+	spdlog::set_default_logger(std::move(asyncLogger));
+	info("Logging through a background thread, queue of {} messages{}.", queueSize, dropWhenFull ? ", dropping the oldest when full" : "");
+}
@@ -21,6 +21,8 @@ public:
 	std::string getLevel() const override;
 
 	void log(const std::string &lvl, fmt::basic_string_view<char> msg) const override;
+
+	void setAsync(size_t queueSize, bool dropWhenFull) override;
 };
 
 constexpr auto g_logger = LogWithSpdLog::getInstance;
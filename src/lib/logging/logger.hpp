@@ -12,6 +12,10 @@
 	#include <fmt/format.h>
 #endif
 
+#include <atomic>
+#include <chrono>
+#include <optional>
+
 #define LOG_LEVEL_TRACE \
 	std::string {       \
 		"trace"         \
@@ -37,6 +41,36 @@
 		"critical"         \
 	}
 
+/**
+ * Limits a log call site that can repeat in bursts (a flood of malformed packets, a script failing every tick)
+ * to one message per interval. Declare it static next to the call, the messages skipped in between are
+ * counted and reported with the next one that is allowed. Safe to share between threads.
+ */
+class LogRateLimit {
+public:
+	explicit LogRateLimit(std::chrono::milliseconds interval) :
+		interval(interval.count()) { }
+
+	/**
+	 * @return the number of messages skipped since the last allowed one, or nullopt when this one is skipped.
+	 */
+	std::optional<uint64_t> allow() {
+		const auto now = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+		auto next = nextAllowed.load(std::memory_order_relaxed);
+		if (now >= next && nextAllowed.compare_exchange_strong(next, now + interval, std::memory_order_relaxed)) {
+			return skipped.exchange(0, std::memory_order_relaxed);
+		}
+
+		skipped.fetch_add(1, std::memory_order_relaxed);
+		return std::nullopt;
+	}
+
+private:
+	const int64_t interval;
+	std::atomic<int64_t> nextAllowed = 0;
+	std::atomic<uint64_t> skipped = 0;
+};
+
 class Logger {
 public:
 	Logger() = default;
@@ -50,6 +84,13 @@ public:
 	[[nodiscard]] virtual std::string getLevel() const = 0;
 	virtual void log(const std::string &lvl, fmt::basic_string_view<char> msg) const = 0;
 
+	/**
+	 * Hands the messages to a background thread through a bounded queue, the calling thread only formats them.
+	 * With dropWhenFull a full queue drops its oldest message instead of making the caller wait.
+	 * Loggers without a background thread ignore it.
+	 */
+	virtual void setAsync(size_t queueSize, bool dropWhenFull) { }
+
 	template <typename... Args>
 	void trace(const fmt::format_string<Args...> &fmt, Args &&... args) {
 		trace(fmt::format(fmt, std::forward<Args>(args)...));
@@ -0,0 +1,138 @@
+/**
+ * Canary - A free and open-source MMORPG server emulator
+ * Copyright (©) 2019-2024 OpenTibiaBR <opentibiabr@outlook.com>
+ * Repository: https://github.com/opentibiabr/canary
+ * License: https://github.com/opentibiabr/canary/blob/main/LICENSE
+ * Contributors: https://github.com/opentibiabr/canary/graphs/contributors
+ * Website: https://docs.opentibiabr.com/
+ */
+
+#include "pch.hpp"
+
+#include "lib/metrics/allocation_counter.hpp"
+#include "lib/metrics/metrics.hpp"
+
+using namespace allocation_counter;
+
+namespace {
+	constexpr size_t MAX_SCOPE_DEPTH = 32;
+	constexpr size_t MAX_THREADS = 1024;
+
+	// The counters of a thread, only read by the others
+	struct ThreadTags {
+		std::array<std::atomic_uint64_t, TAGS> allocations {};
+		std::array<std::atomic_uint64_t, TAGS> bytes {};
+	};
+
+	// Plain integer, it must be usable before and after thread locals with destructors
+	thread_local uint64_t allocations = 0;
+
+	// Same for the scopes, a scope deeper than MAX_SCOPE_DEPTH keeps the tag of the last one stored
+	thread_local std::array<AllocationTag, MAX_SCOPE_DEPTH> scopeTags;
+	thread_local size_t scopeDepth = 0;
+
+	/**
+	 * The counters are allocated with malloc, operator new cannot go through itself, and never freed,
+	 * so the allocations of the threads that exited stay in the totals. The threads above MAX_THREADS share the last one.
+	 */
+	thread_local ThreadTags* threadTags = nullptr;
+	std::array<std::atomic<ThreadTags*>, MAX_THREADS> allThreadTags {};
+	std::atomic_size_t threadCount = 0;
+	ThreadTags sharedThreadTags;
+
+	ThreadTags* getThreadTags() noexcept {
+		if (threadTags) {
+			return threadTags;
+		}
+
+		const auto index = threadCount.fetch_add(1, std::memory_order_relaxed);
+		if (index + 1 >= MAX_THREADS) {
+			threadTags = &sharedThreadTags;
+			allThreadTags[MAX_THREADS - 1].store(threadTags, std::memory_order_release);
+			return threadTags;
+		}
+
+		if (void* memory = std::malloc(sizeof(ThreadTags))) {
+			threadTags = new (memory) ThreadTags();
+			allThreadTags[index].store(threadTags, std::memory_order_release);
+		}
+		return threadTags;
+	}
+
+	void count(std::size_t size) noexcept {
+		++allocations;
+
+		auto* tags = getThreadTags();
+		if (!tags) {
+			return;
+		}
+
+		const auto tag = scopeDepth == 0 ? AllocationTag::Untagged : scopeTags[std::min(scopeDepth, MAX_SCOPE_DEPTH) - 1];
+		const auto index = static_cast<size_t>(tag);
+		tags->allocations[index].fetch_add(1, std::memory_order_relaxed);
+		tags->bytes[index].fetch_add(size, std::memory_order_relaxed);
+	}
+}
+
+uint64_t allocation_counter::threadAllocations() noexcept {
+	return allocations;
+}
+
+std::array<TagTotals, TAGS> allocation_counter::tagTotals() noexcept {
+	std::array<TagTotals, TAGS> totals {};
+	for (const auto &slot : allThreadTags) {
+		const auto* tags = slot.load(std::memory_order_acquire);
+		if (!tags) {
+			continue;
+		}
+
+		for (size_t tag = 0; tag < TAGS; ++tag) {
+			totals[tag].allocations += tags->allocations[tag].load(std::memory_order_relaxed);
+			totals[tag].bytes += tags->bytes[tag].load(std::memory_order_relaxed);
+		}
+	}
+	return totals;
+}
+
+void allocation_counter::reportMetrics() {
+	// Only the dispatcher reports
+	static std::array<TagTotals, TAGS> reported {};
+
+	const auto totals = tagTotals();
+	if (g_metrics().isEnabled()) {
+		for (size_t tag = 0; tag < TAGS; ++tag) {
+			const std::map<std::string, std::string> attrs { { "tag", std::string(tagNames[tag]) } };
+			g_metrics().addCounter("allocations", static_cast<double>(totals[tag].allocations - reported[tag].allocations), attrs);
+			g_metrics().addCounter("allocated_bytes", static_cast<double>(totals[tag].bytes - reported[tag].bytes), attrs);
+		}
+	}
+	reported = totals;
+}
+
+Scope::Scope(AllocationTag tag) noexcept {
+	if (scopeDepth < MAX_SCOPE_DEPTH) {
+		scopeTags[scopeDepth] = tag;
+	}
+	++scopeDepth;
+}
+
+Scope::~Scope() {
+	--scopeDepth;
+}
+
+// Array, nothrow and sized variants of the standard library forward to these two
+void* operator new(std::size_t size) {
+	count(size);
+	if (void* ptr = std::malloc(size == 0 ? 1 : size)) {
+		return ptr;
+	}
+	throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept {
+	std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept {
+	std::free(ptr);
+}
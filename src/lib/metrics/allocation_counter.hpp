@@ -0,0 +1,95 @@
+/**
+ * Canary - A free and open-source MMORPG server emulator
+ * Copyright (©) 2019-2024 OpenTibiaBR <opentibiabr@outlook.com>
+ * Repository: https://github.com/opentibiabr/canary
+ * License: https://github.com/opentibiabr/canary/blob/main/LICENSE
+ * Contributors: https://github.com/opentibiabr/canary/graphs/contributors
+ * Website: https://docs.opentibiabr.com/
+ */
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string_view>
+
+/**
+ * Counts heap allocations made through the global operator new per thread.
+ * Counting replaces the global operator new, so it is only compiled with
+ * FEATURE_ALLOCATION_COUNTER, without it the counter always returns 0.
+ *
+ * The allocations are also counted, with their bytes, by the tag of the innermost
+ * Scope of the thread: the subsystem that made them.
+ */
+namespace allocation_counter {
+	enum class AllocationTag : uint8_t {
+		// Outside of any scope
+		Untagged,
+		// Tasks of the dispatcher, the scopes below take the allocations they make themselves
+		Dispatcher,
+		// Calls into Lua scripts
+		Lua,
+		// Reads and writes of the connections
+		Network,
+		// Creatures placed and moved on the map, spectators, paths and map loading
+		Map,
+	};
+
+	constexpr size_t TAGS = 5;
+
+	constexpr std::array<std::string_view, TAGS> tagNames = { "untagged", "dispatcher", "lua", "network", "map" };
+
+	struct TagTotals {
+		uint64_t allocations = 0;
+		uint64_t bytes = 0;
+	};
+
+#ifdef FEATURE_ALLOCATION_COUNTER
+	constexpr bool isEnabled() noexcept {
+		return true;
+	}
+
+	uint64_t threadAllocations() noexcept;
+
+	// Since the start, of all the threads
+	std::array<TagTotals, TAGS> tagTotals() noexcept;
+
+	/**
+	 * Adds the allocations since the previous call to the "allocations" and "allocated_bytes"
+	 * counters of the metrics, with the tag as attribute. Called every second by the dispatcher.
+	 */
+	void reportMetrics();
+
+	// Tags the allocations of the thread until it is destroyed, nested scopes take over
+	class Scope {
+	public:
+		explicit Scope(AllocationTag tag) noexcept;
+		~Scope();
+
+		Scope(const Scope &) = delete;
+		Scope &operator=(const Scope &) = delete;
+	};
+#else
+	constexpr bool isEnabled() noexcept {
+		return false;
+	}
+
+	constexpr uint64_t threadAllocations() noexcept {
+		return 0;
+	}
+
+	constexpr std::array<TagTotals, TAGS> tagTotals() noexcept {
+		return {};
+	}
+
+	inline void reportMetrics() { }
+
+	class Scope {
+	public:
+		constexpr explicit Scope(AllocationTag) noexcept { }
+
+		Scope(const Scope &) = delete;
+		Scope &operator=(const Scope &) = delete;
+	};
+#endif
+}
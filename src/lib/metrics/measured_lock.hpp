@@ -0,0 +1,75 @@
+/**
+ * Canary - A free and open-source MMORPG server emulator
+ * Copyright (©) 2019-2024 OpenTibiaBR <opentibiabr@outlook.com>
+ * Repository: https://github.com/opentibiabr/canary
+ * License: https://github.com/opentibiabr/canary/blob/main/LICENSE
+ * Contributors: https://github.com/opentibiabr/canary/graphs/contributors
+ * Website: https://docs.opentibiabr.com/
+ */
+
+#pragma once
+
+#include <chrono>
+#include <string_view>
+
+namespace metrics {
+#ifdef FEATURE_METRICS
+	// Defined with the metrics, this header is included by the ones metrics.hpp includes
+	bool isLockMeasured() noexcept;
+	void recordLock(std::string_view site, std::chrono::steady_clock::duration wait, std::chrono::steady_clock::duration hold, bool contended);
+#endif
+
+	/**
+	 * A scoped lock that measures, by call site (usually __METHOD_NAME__), the wait to take the mutex
+	 * ("lock_latency"), how long it is held ("lock_hold_latency") and how many times it was already
+	 * taken by another thread ("lock_contentions"). The measurements are recorded once the mutex is
+	 * released, so the metrics never take their own locks under it.
+	 * Without FEATURE_METRICS, or with the metrics disabled, it is a plain scoped lock.
+	 */
+	template <typename Mutex>
+	class measured_lock final {
+	public:
+		measured_lock(Mutex &mutex, std::string_view site) :
+			mutex(mutex) {
+#ifdef FEATURE_METRICS
+			if (isLockMeasured()) {
+				this->site = site;
+				const auto begin = std::chrono::steady_clock::now();
+				contended = !mutex.try_lock();
+				if (contended) {
+					mutex.lock();
+				}
+				acquired = std::chrono::steady_clock::now();
+				wait = acquired - begin;
+				return;
+			}
+#endif
+			mutex.lock();
+		}
+
+		~measured_lock() {
+#ifdef FEATURE_METRICS
+			if (!site.empty()) {
+				const auto released = std::chrono::steady_clock::now();
+				mutex.unlock();
+				recordLock(site, wait, released - acquired, contended);
+				return;
+			}
+#endif
+			mutex.unlock();
+		}
+
+		measured_lock(const measured_lock &) = delete;
+		measured_lock &operator=(const measured_lock &) = delete;
+
+	private:
+		Mutex &mutex;
+#ifdef FEATURE_METRICS
+		// Empty when not measured
+		std::string_view site;
+		std::chrono::steady_clock::time_point acquired;
+		std::chrono::steady_clock::duration wait {};
+		bool contended = false;
+#endif
+	};
+}
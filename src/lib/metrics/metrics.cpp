@@ -9,10 +9,37 @@
  */
 
 	#include "metrics.hpp"
+	#include "lib/metrics/measured_lock.hpp"
 	#include "lib/di/container.hpp"
+	#include "lib/thread/thread_pool.hpp"
 
 using namespace metrics;
 
+// TODO: migrate to ExponentialHistogramIndexer when that's available
+// clang-format off
+const std::vector<double> metrics::latencyBoundaries {
+	// Ultra-fine granularity below 10µs
+	0.0, 1.0, 2.0, 3.0, 4.0, 5.0, 6.0, 7.0, 8.0, 9.0, 10.0,
+	12.0, 14.0, 16.0, 18.0, 20.0, 22.0, 24.0, 26.0, 28.0, 30.0,
+	35.0, 40.0, 45.0, 50.0, 55.0, 60.0, 65.0, 70.0, 75.0, 80.0,
+	85.0, 90.0, 95.0, 100.0,
+	// Fine granularity between 100µs and 500µs
+	120.0, 140.0, 160.0, 180.0, 200.0, 225.0, 250.0, 275.0, 300.0, 325.0, 350.0, 375.0, 400.0, 425.0, 450.0, 475.0, 500.0,
+	// Moderate granularity from 500µs to 1ms (1000µs)
+	550.0, 600.0, 650.0, 700.0, 750.0, 800.0, 850.0, 900.0, 950.0, 1000.0,
+	// Coarser granularity for higher latencies (in microseconds)
+	1100.0, 1200.0, 1300.0, 1400.0, 1500.0, 2000.0, 2500.0, 3000.0, 3500.0, 4000.0, 4500.0, 5000.0, 10000.0,
+	// Very coarse granularity for latencies in milliseconds
+	20000.0, 30000.0, 40000.0, 50000.0, 60000.0,70000.0, 80000.0, 90000.0, 100000.0,
+	200000.0, 300000.0, 400000.0, 500000.0, 600000.0,700000.0, 800000.0, 900000.0, 1000000.0,
+	// Even coarser granularity for latencies in seconds
+	2000000.0, 3000000.0, 4000000.0, 5000000.0, 6000000.0,7000000.0, 8000000.0, 9000000.0, 10000000.0,
+	20000000.0, 30000000.0, 40000000.0, 50000000.0, 60000000.0,70000000.0, 80000000.0, 90000000.0, 100000000.0,
+	// And finally a catch-all for anything else
+	std::numeric_limits<double>::infinity(),
+};
+// clang-format on
+
 Metrics &Metrics::getInstance() {
 	return inject<Metrics>();
 }
@@ -40,6 +67,14 @@ void Metrics::init(Options opts) {
 
 	metrics_api::Provider::SetMeterProvider(std::move(provider));
 	initHistograms();
+
+	enabled = true;
+	g_dispatcher().cycleEvent(
+		FLUSH_INTERVAL, [this] {
+			scheduleFlush();
+		},
+		"Metrics::scheduleFlush"
+	);
 }
 
 void Metrics::initHistograms() {
@@ -48,51 +83,261 @@ void Metrics::initHistograms() {
 		auto meterSelector = metrics_sdk::MeterSelectorFactory::Create("performance", otelVersion, otelSchema);
 
 		auto aggregationConfig = std::make_unique<metrics_sdk::HistogramAggregationConfig>();
-		// TODO: migrate to ExponentialHistogramIndexer when that's available
-		// clang-format off
-		aggregationConfig->boundaries_ = {
-			// Ultra-fine granularity below 10µs
-			0.0, 1.0, 2.0, 3.0, 4.0, 5.0, 6.0, 7.0, 8.0, 9.0, 10.0,
-			12.0, 14.0, 16.0, 18.0, 20.0, 22.0, 24.0, 26.0, 28.0, 30.0,
-			35.0, 40.0, 45.0, 50.0, 55.0, 60.0, 65.0, 70.0, 75.0, 80.0,
-			85.0, 90.0, 95.0, 100.0,
-			// Fine granularity between 100µs and 500µs
-			120.0, 140.0, 160.0, 180.0, 200.0, 225.0, 250.0, 275.0, 300.0, 325.0, 350.0, 375.0, 400.0, 425.0, 450.0, 475.0, 500.0,
-			// Moderate granularity from 500µs to 1ms (1000µs)
-			550.0, 600.0, 650.0, 700.0, 750.0, 800.0, 850.0, 900.0, 950.0, 1000.0,
-			// Coarser granularity for higher latencies (in microseconds)
-			1100.0, 1200.0, 1300.0, 1400.0, 1500.0, 2000.0, 2500.0, 3000.0, 3500.0, 4000.0, 4500.0, 5000.0, 10000.0,
-			// Very coarse granularity for latencies in milliseconds
-			20000.0, 30000.0, 40000.0, 50000.0, 60000.0,70000.0, 80000.0, 90000.0, 100000.0,
-			200000.0, 300000.0, 400000.0, 500000.0, 600000.0,700000.0, 800000.0, 900000.0, 1000000.0,
-			// Even coarser granularity for latencies in seconds
-			2000000.0, 3000000.0, 4000000.0, 5000000.0, 6000000.0,7000000.0, 8000000.0, 9000000.0, 10000000.0,
-			20000000.0, 30000000.0, 40000000.0, 50000000.0, 60000000.0,70000000.0, 80000000.0, 90000000.0, 100000000.0,
-			// And finally a catch-all for anything else
-			std::numeric_limits<double>::infinity(),
-		};
-		// clang-format on
+		aggregationConfig->boundaries_ = latencyBoundaries;
 
 		auto view = metrics_sdk::ViewFactory::Create(name, "Latency", "us", metrics_sdk::AggregationType::kHistogram, std::move(aggregationConfig));
 		auto provider = metrics_api::Provider::GetMeterProvider();
 		auto* p = static_cast<metrics_sdk::MeterProvider*>(provider.get());
 		p->AddView(std::move(instrumentSelector), std::move(meterSelector), std::move(view));
 
-		latencyHistograms[name] = getMeter()->CreateDoubleHistogram(name, "Latency", "us");
+		latencyHistograms[getLatencyId(name)] = getMeter()->CreateDoubleHistogram(name, "Latency", "us");
 	}
 }
 
 void Metrics::shutdown() {
+	enabled = false;
+	std::scoped_lock lock(mutex_);
 	std::shared_ptr<metrics_api::MeterProvider> none;
 	metrics_api::Provider::SetMeterProvider(none);
 }
 
-ScopedLatency::ScopedLatency(const std::string_view &name, const std::string &histogramName, const std::string &scopeKey) :
-	ScopedLatency(name, g_metrics().latencyHistograms[histogramName], { { scopeKey, std::string(name) } }, g_metrics().defaultContext) {
-	if (histogram == nullptr) {
+ThreadMetrics &Metrics::getThreadMetrics() {
+	thread_local std::shared_ptr<ThreadMetrics> local;
+	if (!local) {
+		local = std::make_shared<ThreadMetrics>();
+		std::scoped_lock lock(threadsMutex);
+		threads.emplace_back(local);
+	}
+	return *local;
+}
+
+size_t Metrics::getLatencyId(std::string_view histogramName) {
+	for (size_t id = 0; id < LATENCY_HISTOGRAMS; ++id) {
+		if (latencyNames[id] == histogramName) {
+			return id;
+		}
+	}
+	return LATENCY_HISTOGRAMS;
+}
+
+ThreadMetrics::Latency &Metrics::getLatency(ThreadMetrics &thread, size_t id, std::string_view scope, std::string_view scopeKey) {
+	auto &scopes = thread.latencies[id];
+	auto it = scopes.find(scope);
+	if (it == scopes.end()) {
+		it = scopes.try_emplace(std::string(scope)).first;
+		it->second.scopeKey = scopeKey;
+		it->second.buckets.resize(latencyBoundaries.size(), 0);
+	}
+	return it->second;
+}
+
+void Metrics::countLatency(ThreadMetrics::Latency &latency, double microseconds) {
+	// The bucket (lower, upper] of the histogram, upper being the first boundary not below the value
+	const auto bucket = static_cast<size_t>(std::ranges::lower_bound(latencyBoundaries, microseconds) - latencyBoundaries.begin());
+	++latency.buckets[std::min(bucket, latency.buckets.size() - 1)];
+	++latency.count;
+}
+
+void Metrics::recordLatency(std::string_view histogramName, std::string_view scopeKey, std::string_view scope, double microseconds) {
+	const auto id = getLatencyId(histogramName);
+	if (!isEnabled() || id >= LATENCY_HISTOGRAMS) {
+		return;
+	}
+
+	auto &thread = getThreadMetrics();
+	std::scoped_lock lock(thread.mutex);
+	countLatency(getLatency(thread, id, scope, scopeKey), microseconds);
+}
+
+CounterId Metrics::registerCounter(std::string_view name, bool upDown) {
+	std::scoped_lock lock(mutex_);
+	for (CounterId id = 0; id < registeredCounters.size(); ++id) {
+		if (registeredCounters[id].first == name) {
+			return id;
+		}
+	}
+
+	registeredCounters.emplace_back(std::string(name), upDown);
+	return static_cast<CounterId>(registeredCounters.size() - 1);
+}
+
+void Metrics::addCounter(CounterId id, double value) {
+	if (!isEnabled()) {
+		return;
+	}
+
+	auto &thread = getThreadMetrics();
+	std::scoped_lock lock(thread.mutex);
+	if (id >= thread.registered.size()) {
+		thread.registered.resize(id + 1, 0);
+	}
+	thread.registered[id] += value;
+}
+
+void Metrics::add(std::string_view name, double value, std::map<std::string, std::string> attrs, bool upDown) {
+	if (!isEnabled()) {
+		return;
+	}
+
+	std::string key(name);
+	for (const auto &[attrKey, attrValue] : attrs) {
+		key += '\x1f';
+		key += attrKey;
+		key += '=';
+		key += attrValue;
+	}
+
+	auto &thread = getThreadMetrics();
+	std::scoped_lock lock(thread.mutex);
+	auto [it, inserted] = thread.counters.try_emplace(std::move(key));
+	auto &counter = it->second;
+	if (inserted) {
+		counter.name = name;
+		counter.attrs = std::move(attrs);
+		counter.upDown = upDown;
+	}
+	counter.value += value;
+}
+
+void Metrics::scheduleFlush() {
+	if (flushing.exchange(true)) {
+		return;
+	}
+
+	inject<ThreadPool>().detach_task([this] {
+		flush();
+		flushing = false;
+	});
+}
+
+void Metrics::flush() {
+	struct PendingLatency {
+		size_t histogram = 0;
+		std::string scope;
+		std::string_view scopeKey;
+		std::vector<uint32_t> buckets;
+	};
+
+	std::vector<std::shared_ptr<ThreadMetrics>> snapshot;
+	{
+		std::scoped_lock lock(threadsMutex);
+		snapshot = threads;
+		// Only the list and the snapshot hold the storage of a thread that exited, it is flushed a last time below
+		std::erase_if(threads, [](const auto &thread) {
+			return thread.use_count() == 2;
+		});
+	}
+
+	std::vector<PendingLatency> latencies;
+	phmap::flat_hash_map<std::string, ThreadMetrics::Counter> counters;
+	std::vector<double> registered;
+	for (const auto &thread : snapshot) {
+		// Only the values are taken under the lock of the thread, the instruments are fed after it
+		std::scoped_lock lock(thread->mutex);
+		for (size_t histogram = 0; histogram < LATENCY_HISTOGRAMS; ++histogram) {
+			for (auto &[scope, latency] : thread->latencies[histogram]) {
+				if (latency.count == 0) {
+					continue;
+				}
+
+				auto &pending = latencies.emplace_back();
+				pending.histogram = histogram;
+				pending.scope = scope;
+				pending.scopeKey = latency.scopeKey;
+				pending.buckets = latency.buckets;
+				std::ranges::fill(latency.buckets, 0);
+				latency.count = 0;
+			}
+		}
+
+		for (auto &[key, counter] : thread->counters) {
+			auto [it, inserted] = counters.try_emplace(key);
+			if (inserted) {
+				it->second = std::move(counter);
+			} else {
+				it->second.value += counter.value;
+			}
+		}
+		thread->counters.clear();
+
+		if (registered.size() < thread->registered.size()) {
+			registered.resize(thread->registered.size(), 0);
+		}
+		for (size_t id = 0; id < thread->registered.size(); ++id) {
+			registered[id] += thread->registered[id];
+		}
+		std::ranges::fill(thread->registered, 0);
+	}
+
+	std::scoped_lock lock(mutex_);
+	if (!isEnabled() || !getMeter()) {
+		return;
+	}
+
+	for (const auto &pending : latencies) {
+		auto &histogram = latencyHistograms[pending.histogram];
+		if (histogram == nullptr) {
+			continue;
+		}
+
+		const std::map<std::string, std::string> attrs { { std::string(pending.scopeKey), pending.scope } };
+		auto attrskv = opentelemetry::common::KeyValueIterableView<decltype(attrs)> { attrs };
+		for (size_t bucket = 0; bucket < pending.buckets.size(); ++bucket) {
+			// The middle of the bucket lands in the same bucket of the histogram
+			double value = latencyBoundaries[bucket];
+			if (bucket > 0) {
+				const auto lower = latencyBoundaries[bucket - 1];
+				value = std::isinf(value) ? lower * 2 : (lower + value) / 2;
+			}
+			for (uint32_t i = 0; i < pending.buckets[bucket]; ++i) {
+				histogram->Record(value, attrskv, defaultContext);
+			}
+		}
+	}
+
+	for (const auto &[key, counter] : counters) {
+		flushCounter(counter.name, counter.value, counter.attrs, counter.upDown);
+	}
+
+	for (size_t id = 0; id < registered.size() && id < registeredCounters.size(); ++id) {
+		if (registered[id] != 0) {
+			flushCounter(registeredCounters[id].first, registered[id], {}, registeredCounters[id].second);
+		}
+	}
+}
+
+void Metrics::flushCounter(const std::string &name, double value, const std::map<std::string, std::string> &attrs, bool upDown) {
+	auto attrskv = opentelemetry::common::KeyValueIterableView<std::map<std::string, std::string>> { attrs };
+	if (upDown) {
+		auto &counter = upDownCounters[name];
+		if (!counter) {
+			counter = getMeter()->CreateInt64UpDownCounter(name);
+		}
+		counter->Add(static_cast<int64_t>(value), attrskv);
+		return;
+	}
+
+	auto &counter = counters[name];
+	if (!counter) {
+		counter = getMeter()->CreateDoubleCounter(name);
+	}
+	counter->Add(value, attrskv);
+}
+
+ScopedLatency::ScopedLatency(std::string_view name, std::string_view histogramName, std::string_view scopeKey) {
+	const auto id = Metrics::getLatencyId(histogramName);
+	if (!Metrics::isEnabled() || id >= LATENCY_HISTOGRAMS) {
 		stopped = true;
 		return;
 	}
+
+	// The scope is found now, name can be a temporary
+	thread = &Metrics::getThreadMetrics();
+	{
+		std::scoped_lock lock(thread->mutex);
+		latency = &Metrics::getLatency(*thread, id, name, scopeKey);
+	}
+	begin = std::chrono::steady_clock::now();
 }
 
 ScopedLatency::~ScopedLatency() {
@@ -106,8 +351,25 @@ void ScopedLatency::stop() {
 	stopped = true;
 	auto end = std::chrono::steady_clock::now();
 	double elapsed = static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count()) / 1000;
-	auto attrskv = opentelemetry::common::KeyValueIterableView<decltype(attrs)> { attrs };
-	histogram->Record(elapsed, attrskv, context);
+
+	std::scoped_lock lock(thread->mutex);
+	Metrics::countLatency(*latency, elapsed);
+}
+
+bool metrics::isLockMeasured() noexcept {
+	return Metrics::isEnabled();
+}
+
+void metrics::recordLock(std::string_view site, std::chrono::steady_clock::duration wait, std::chrono::steady_clock::duration hold, bool contended) {
+	const auto toMicroseconds = [](std::chrono::steady_clock::duration duration) {
+		return static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count()) / 1000;
+	};
+
+	Metrics::recordLatency("lock_latency", "scope", site, toMicroseconds(wait));
+	Metrics::recordLatency("lock_hold_latency", "scope", site, toMicroseconds(hold));
+	if (contended) {
+		g_metrics().addCounter("lock_contentions", 1, { { "scope", std::string(site) } });
+	}
 }
 
 #endif // FEATURE_METRICS
@@ -9,6 +9,8 @@
 
 #pragma once
 
+#include "lib/metrics/profiler.hpp"
+
 #ifdef FEATURE_METRICS
 	#include "game/scheduling/dispatcher.hpp"
 	#include <opentelemetry/exporters/ostream/metric_exporter_factory.h>
@@ -52,12 +54,45 @@ namespace metrics {
 		metrics_exporter::PrometheusExporterOptions prometheusOptions;
 	};
 
+	// The latency histograms, latencyNames has their names
+	constexpr size_t LATENCY_HISTOGRAMS = 8;
+
+	// A counter registered once by name, adding to it is one slot of the thread
+	using CounterId = uint32_t;
+
+	/**
+	 * The measurements of one thread since the last flush, pre-aggregated: latencies in the fixed buckets
+	 * of the histograms and the sums of the counters. Only its thread writes it and only the flush reads it,
+	 * so its mutex is only contended while a flush takes the values.
+	 */
+	struct ThreadMetrics {
+		struct Latency {
+			// The attribute of the scope, from the latency class
+			std::string_view scopeKey;
+			// Counts per bucket of latencyBoundaries
+			std::vector<uint32_t> buckets;
+			uint64_t count = 0;
+		};
+
+		struct Counter {
+			std::string name;
+			std::map<std::string, std::string> attrs;
+			double value = 0;
+			bool upDown = false;
+		};
+
+		std::mutex mutex;
+		// By scope, the entries are never erased so a running measurement can keep a pointer to its own
+		std::array<phmap::node_hash_map<std::string, Latency>, LATENCY_HISTOGRAMS> latencies;
+		// By name and attributes
+		phmap::flat_hash_map<std::string, Counter> counters;
+		// By CounterId
+		std::vector<double> registered;
+	};
+
 	class ScopedLatency {
 	public:
-		explicit ScopedLatency(const std::string_view &name, const std::string &histogramName, const std::string &scopeKey);
-		explicit ScopedLatency([[maybe_unused]] const std::string_view &name, Histogram<double> &histogram, std::map<std::string, std::string> attrs = {}, opentelemetry::context::Context context = opentelemetry::context::Context()) :
-			begin(std::chrono::steady_clock::now()), histogram(histogram), attrs(std::move(attrs)), context(std::move(context)) {
-		}
+		explicit ScopedLatency(std::string_view name, std::string_view histogramName, std::string_view scopeKey);
 
 		void stop();
 
@@ -65,17 +100,25 @@ namespace metrics {
 
 	private:
 		std::chrono::steady_clock::time_point begin;
-		Histogram<double> &histogram;
-		std::map<std::string, std::string> attrs;
-		opentelemetry::context::Context context;
+		ThreadMetrics* thread = nullptr;
+		ThreadMetrics::Latency* latency = nullptr;
 		bool stopped { false };
 	};
 
-	#define DEFINE_LATENCY_CLASS(class_name, histogram_name, category)       \
-		class class_name##_latency final : public ScopedLatency {            \
-		public:                                                              \
-			class_name##_latency(std::string_view name) :                    \
-				ScopedLatency(name, histogram_name "_latency", category) { } \
+	// A measurement that is also a zone of the profiler, see profiler::Zone
+	#define DEFINE_LATENCY_CLASS(class_name, histogram_name, category)                                                           \
+		class class_name##_latency final : public ScopedLatency {                                                                \
+		public:                                                                                                                  \
+			class_name##_latency(std::string_view name, const std::source_location &location = std::source_location::current()) : \
+				ScopedLatency(name, histogram_name "_latency", category), zone(name, location) { }                                 \
+                                                                                                                                 \
+			void stop() {                                                                                                        \
+				ScopedLatency::stop();                                                                                           \
+				zone.end();                                                                                                      \
+			}                                                                                                                    \
+                                                                                                                                 \
+		private:                                                                                                                 \
+			profiler::Zone zone;                                                                                                 \
 		}
 
 	DEFINE_LATENCY_CLASS(method, "method", "method");
@@ -90,8 +133,20 @@ namespace metrics {
 		"query_latency",
 		"task_latency",
 		"lock_latency",
+		"frame_latency",
+		"lock_hold_latency",
+		"network_write_latency",
 	};
 
+	// Upper bounds of the latency buckets, in microseconds
+	extern const std::vector<double> latencyBoundaries;
+
+	/**
+	 * The measurements are aggregated per thread (see ThreadMetrics) without a shared lock,
+	 * a flush on the thread pool merges them into the OpenTelemetry instruments every second.
+	 * A latency is replayed into its histogram with the middle value of its bucket,
+	 * so the bucket counts are exact and the sums are close.
+	 */
 	class Metrics final {
 	public:
 		Metrics() = default;
@@ -103,37 +158,33 @@ namespace metrics {
 
 		static Metrics &getInstance();
 
+		static bool isEnabled() {
+			return enabled.load(std::memory_order_relaxed);
+		}
+
+		CounterId registerCounter(std::string_view name, bool upDown = false);
+		void addCounter(CounterId id, double value);
+
 		void addCounter(std::string_view name, double value, std::map<std::string, std::string> attrs = {}) {
-			std::scoped_lock lock(mutex_);
-			if (!getMeter()) {
-				return;
-			}
-			if (counters.find(name) == counters.end()) {
-				std::string nameStr(name);
-				counters[name] = getMeter()->CreateDoubleCounter(nameStr);
-			}
-			auto attrskv = opentelemetry::common::KeyValueIterableView<decltype(attrs)> { attrs };
-			counters[name]->Add(value, attrskv);
+			add(name, value, std::move(attrs), false);
 		}
 
-		void addUpDownCounter(std::string_view name, int value, std::map<std::string, std::string> attrs = {}) {
-			std::scoped_lock lock(mutex_);
-			if (!getMeter()) {
-				return;
-			}
-			if (upDownCounters.find(name) == upDownCounters.end()) {
-				std::string nameStr(name);
-				upDownCounters[name] = getMeter()->CreateInt64UpDownCounter(nameStr);
-			}
-			auto attrskv = opentelemetry::common::KeyValueIterableView<decltype(attrs)> { attrs };
-			upDownCounters[name]->Add(value, attrskv);
+		void addUpDownCounter(std::string_view name, int64_t value, std::map<std::string, std::string> attrs = {}) {
+			add(name, value, std::move(attrs), true);
 		}
 
+		// A latency measured elsewhere, like a ScopedLatency of that long
+		static void recordLatency(std::string_view histogramName, std::string_view scopeKey, std::string_view scope, double microseconds);
+
+		// The storage of the calling thread, created on its first measurement
+		static ThreadMetrics &getThreadMetrics();
+		static size_t getLatencyId(std::string_view histogramName);
+
 		friend class ScopedLatency;
 
 	protected:
 		opentelemetry::context::Context defaultContext {};
-		phmap::parallel_flat_hash_map<std::string, Histogram<double>> latencyHistograms;
+		std::array<Histogram<double>, LATENCY_HISTOGRAMS> latencyHistograms;
 		phmap::flat_hash_map<std::string, UpDownCounter<int64_t>> upDownCounters;
 		phmap::flat_hash_map<std::string, Counter<double>> counters;
 
@@ -146,7 +197,25 @@ namespace metrics {
 		}
 
 	private:
+		static constexpr uint32_t FLUSH_INTERVAL = 1000;
+
+		void add(std::string_view name, double value, std::map<std::string, std::string> attrs, bool upDown);
+		// The entry of scope in the storage of a thread, its mutex must be held
+		static ThreadMetrics::Latency &getLatency(ThreadMetrics &thread, size_t id, std::string_view scope, std::string_view scopeKey);
+		static void countLatency(ThreadMetrics::Latency &latency, double microseconds);
+		// Queues a flush on the thread pool, unless the last one is still running
+		void scheduleFlush();
+		void flush();
+		void flushCounter(const std::string &name, double value, const std::map<std::string, std::string> &attrs, bool upDown);
+
+		inline static std::atomic_bool enabled = false;
+		inline static std::mutex threadsMutex;
+		inline static std::vector<std::shared_ptr<ThreadMetrics>> threads;
+
+		// Guards the instruments, the registered counters and the flush
 		std::mutex mutex_;
+		std::atomic_bool flushing = false;
+		std::vector<std::pair<std::string, bool>> registeredCounters;
 
 		std::string meterName { "stats" };
 		std::string otelVersion { "1.2.0" };
@@ -168,8 +237,7 @@ struct Options {
 
 class ScopedLatency {
 public:
-	explicit ScopedLatency([[maybe_unused]] std::string_view name, [[maybe_unused]] const std::string &histogramName, [[maybe_unused]] const std::string &scopeKey) {};
-	explicit ScopedLatency([[maybe_unused]] std::string_view name, [[maybe_unused]] std::set<double> &histogram, [[maybe_unused]] const std::map<std::string, std::string> &attrs = {}, [[maybe_unused]] const std::string &context = std::string()) {};
+	explicit ScopedLatency([[maybe_unused]] std::string_view name, [[maybe_unused]] std::string_view histogramName, [[maybe_unused]] std::string_view scopeKey) {};
 
 	void stop() {};
 
@@ -177,11 +245,22 @@ public:
 };
 
 namespace metrics {
-	#define DEFINE_LATENCY_CLASS(class_name, histogram_name, category)       \
-		class class_name##_latency final : public ScopedLatency {            \
-		public:                                                              \
-			class_name##_latency(std::string_view name) :                    \
-				ScopedLatency(name, histogram_name "_latency", category) { } \
+	using CounterId = uint32_t;
+
+	// A measurement that is also a zone of the profiler, see profiler::Zone
+	#define DEFINE_LATENCY_CLASS(class_name, histogram_name, category)                                                           \
+		class class_name##_latency final : public ScopedLatency {                                                                \
+		public:                                                                                                                  \
+			class_name##_latency(std::string_view name, const std::source_location &location = std::source_location::current()) : \
+				ScopedLatency(name, histogram_name "_latency", category), zone(name, location) { }                                 \
+                                                                                                                                 \
+			void stop() {                                                                                                        \
+				ScopedLatency::stop();                                                                                           \
+				zone.end();                                                                                                      \
+			}                                                                                                                    \
+                                                                                                                                 \
+		private:                                                                                                                 \
+			profiler::Zone zone;                                                                                                 \
 		}
 
 	DEFINE_LATENCY_CLASS(method, "method", "method");
@@ -196,6 +275,9 @@ namespace metrics {
 		"query_latency",
 		"task_latency",
 		"lock_latency",
+		"frame_latency",
+		"lock_hold_latency",
+		"network_write_latency",
 	};
 
 	class Metrics final {
@@ -211,9 +293,21 @@ namespace metrics {
 			return inject<Metrics>();
 		};
 
+		static bool isEnabled() {
+			return false;
+		}
+
+		CounterId registerCounter([[maybe_unused]] std::string_view name, [[maybe_unused]] bool upDown = false) {
+			return 0;
+		}
+
+		void addCounter([[maybe_unused]] CounterId id, [[maybe_unused]] double value) { }
+
+		static void recordLatency([[maybe_unused]] std::string_view histogramName, [[maybe_unused]] std::string_view scopeKey, [[maybe_unused]] std::string_view scope, [[maybe_unused]] double microseconds) { }
+
 		void addCounter([[maybe_unused]] std::string_view name, [[maybe_unused]] double value, [[maybe_unused]] const std::map<std::string, std::string> &attrs = {}) { }
 
-		void addUpDownCounter([[maybe_unused]] std::string_view name, [[maybe_unused]] int value, [[maybe_unused]] const std::map<std::string, std::string> &attrs = {}) { }
+		void addUpDownCounter([[maybe_unused]] std::string_view name, [[maybe_unused]] int64_t value, [[maybe_unused]] const std::map<std::string, std::string> &attrs = {}) { }
 
 		friend class ScopedLatency;
 	};
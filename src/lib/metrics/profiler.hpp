@@ -0,0 +1,71 @@
+/**
+ * Canary - A free and open-source MMORPG server emulator
+ * Copyright (©) 2019-2024 OpenTibiaBR <opentibiabr@outlook.com>
+ * Repository: https://github.com/opentibiabr/canary
+ * License: https://github.com/opentibiabr/canary/blob/main/LICENSE
+ * Contributors: https://github.com/opentibiabr/canary/graphs/contributors
+ * Website: https://docs.opentibiabr.com/
+ */
+
+#pragma once
+
+#include <source_location>
+#include <string_view>
+
+#ifdef FEATURE_TRACY
+	#include <cstring>
+	#include <optional>
+	#include <tracy/Tracy.hpp>
+#endif
+
+/**
+ * Zones and frames for a continuous profiler: Tracy, when built with FEATURE_TRACY, nothing otherwise.
+ * Tracy is built on demand, so a zone costs a few branches until a profiler connects.
+ * The latency classes of the metrics (DEFINE_LATENCY_CLASS) open a zone too, so the tasks, Lua calls,
+ * queries and measured methods are on the timeline without markers of their own.
+ */
+namespace profiler {
+#ifdef FEATURE_TRACY
+	// A zone named at runtime (the name is copied), at the location of the caller
+	class Zone {
+	public:
+		explicit Zone(std::string_view name, const std::source_location &location = std::source_location::current()) {
+			zone.emplace(location.line(), location.file_name(), std::strlen(location.file_name()), location.function_name(), std::strlen(location.function_name()), name.data(), name.size(), true);
+		}
+
+		// Ends the zone before the destructor, no zone may have been opened inside it since
+		void end() {
+			zone.reset();
+		}
+
+		Zone(const Zone &) = delete;
+		Zone &operator=(const Zone &) = delete;
+
+	private:
+		std::optional<tracy::ScopedZone> zone;
+	};
+
+	// The end of a frame of the timeline, name must be a literal, the same one every frame
+	inline void frameMark(const char* name) {
+		FrameMarkNamed(name);
+	}
+
+	inline void setThreadName(const char* name) {
+		tracy::SetThreadName(name);
+	}
+#else
+	class Zone {
+	public:
+		constexpr explicit Zone(std::string_view, const std::source_location & = std::source_location::current()) noexcept { }
+
+		constexpr void end() noexcept { }
+
+		Zone(const Zone &) = delete;
+		Zone &operator=(const Zone &) = delete;
+	};
+
+	inline void frameMark(const char*) { }
+
+	inline void setThreadName(const char*) { }
+#endif
+}
@@ -0,0 +1,95 @@
+/**
+ * Canary - A free and open-source MMORPG server emulator
+ * Copyright (©) 2019-2024 OpenTibiaBR <opentibiabr@outlook.com>
+ * Repository: https://github.com/opentibiabr/canary
+ * License: https://github.com/opentibiabr/canary/blob/main/LICENSE
+ * Contributors: https://github.com/opentibiabr/canary/graphs/contributors
+ * Website: https://docs.opentibiabr.com/
+ */
+
+#include "pch.hpp"
+
+#include "lib/thread/task_graph.hpp"
+
+#include "lib/thread/thread_pool.hpp"
+#include "utils/tools.hpp"
+
+void TaskGraph::add(std::string name, std::vector<std::string> dependencies, bool background, std::function<void()> task) {
+	Node node { std::move(name), background, std::move(task) };
+	const auto index = nodes.size();
+	for (const auto &dependency : dependencies) {
+		const auto it = std::ranges::find(nodes, dependency, &Node::name);
+		if (it == nodes.end()) {
+			throw std::invalid_argument(fmt::format("Task {} depends on {}, which was not added before it", node.name, dependency));
+		}
+		it->dependents.emplace_back(index);
+		++node.dependencies;
+	}
+	nodes.emplace_back(std::move(node));
+}
+
+void TaskGraph::run() {
+	std::unique_lock lock(mutex);
+	runStartedAt = OTSYS_TIME();
+	for (size_t index = 0; index < nodes.size(); ++index) {
+		if (nodes[index].dependencies == 0) {
+			start(index);
+		}
+	}
+
+	// The queued foreground tasks count as running, so none left running means every task is done or skipped
+	while (true) {
+		changed.wait(lock, [this] { return !foreground.empty() || running == 0; });
+		if (foreground.empty()) {
+			break;
+		}
+
+		const auto index = foreground.back();
+		foreground.pop_back();
+		lock.unlock();
+		execute(index);
+		lock.lock();
+	}
+
+	std::ranges::sort(timeline, {}, &Stage::startedAt);
+	if (failure) {
+		std::rethrow_exception(failure);
+	}
+}
+
+void TaskGraph::start(size_t index) {
+	++running;
+	if (nodes[index].background) {
+		threadPool.detach_task([this, index] { execute(index); });
+	} else {
+		foreground.emplace_back(index);
+	}
+}
+
+void TaskGraph::execute(size_t index) {
+	const auto &node = nodes[index];
+	const auto startedAt = OTSYS_TIME();
+	std::exception_ptr error;
+	try {
+		node.task();
+	} catch (...) {
+		error = std::current_exception();
+	}
+	const auto duration = OTSYS_TIME() - startedAt;
+
+	std::scoped_lock lock(mutex);
+	timeline.push_back({ node.name, node.background, startedAt - runStartedAt, duration });
+	--running;
+	if (error && !failure) {
+		failure = error;
+	}
+
+	if (!failure) {
+		for (const auto dependent : node.dependents) {
+			if (--nodes[dependent].dependencies == 0) {
+				start(dependent);
+			}
+		}
+	}
+	changed.notify_all();
+}
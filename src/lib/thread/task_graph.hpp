@@ -0,0 +1,71 @@
+/**
+ * Canary - A free and open-source MMORPG server emulator
+ * Copyright (©) 2019-2024 OpenTibiaBR <opentibiabr@outlook.com>
+ * Repository: https://github.com/opentibiabr/canary
+ * License: https://github.com/opentibiabr/canary/blob/main/LICENSE
+ * Contributors: https://github.com/opentibiabr/canary/graphs/contributors
+ * Website: https://docs.opentibiabr.com/
+ */
+#pragma once
+
+class ThreadPool;
+
+/**
+ * Runs a set of tasks by their dependencies: a task starts as soon as every task it depends on is done,
+ * so the independent ones overlap. Background tasks run on the thread pool, the others on the thread
+ * that calls run (the ones that need the Lua state or the dispatcher). Used by the server startup.
+ */
+class TaskGraph {
+public:
+	struct Stage {
+		std::string name;
+		bool background = false;
+		// Milliseconds since run was called
+		int64_t startedAt = 0;
+		int64_t duration = 0;
+	};
+
+	explicit TaskGraph(ThreadPool &threadPool) :
+		threadPool(threadPool) { }
+
+	/**
+	 * Adds a task, the tasks it depends on must be added before it.
+	 */
+	void add(std::string name, std::vector<std::string> dependencies, bool background, std::function<void()> task);
+
+	/**
+	 * Runs every task and waits for them. When a task throws the tasks not started yet are skipped
+	 * and the first exception is rethrown once the running ones are done.
+	 */
+	void run();
+
+	// The stages by the time they started, filled by run
+	const std::vector<Stage> &getTimeline() const {
+		return timeline;
+	}
+
+private:
+	struct Node {
+		std::string name;
+		bool background = false;
+		std::function<void()> task;
+		std::vector<size_t> dependents;
+		size_t dependencies = 0;
+	};
+
+	void start(size_t index);
+	void execute(size_t index);
+
+	ThreadPool &threadPool;
+	std::vector<Node> nodes;
+	std::vector<Stage> timeline;
+
+	// Guards everything below and the timeline while run is going
+	std::mutex mutex;
+	std::condition_variable changed;
+	std::vector<size_t> foreground;
+	int64_t runStartedAt = 0;
+	size_t running = 0;
+	size_t finished = 0;
+	std::exception_ptr failure;
+};
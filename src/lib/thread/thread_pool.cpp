@@ -12,6 +12,7 @@
 #include "lib/thread/thread_pool.hpp"
 
 #include "game/game.hpp"
+#include "lib/metrics/metrics.hpp"
 #include "utils/tools.hpp"
 
 /**
@@ -25,6 +26,48 @@
 	#define DEFAULT_NUMBER_OF_THREADS 4
 #endif
 
+namespace {
+	std::thread::native_handle_type currentThread() {
+#if defined(_WIN32)
+		return GetCurrentThread();
+#else
+		return pthread_self();
+#endif
+	}
+
+	bool isCurrentThread(std::thread::native_handle_type handle) {
+#if defined(_WIN32)
+		return GetThreadId(handle) == GetCurrentThreadId();
+#else
+		return pthread_equal(handle, pthread_self()) != 0;
+#endif
+	}
+
+	bool pinThread(std::thread::native_handle_type handle, const std::vector<uint16_t> &cores) {
+#if defined(_WIN32)
+		DWORD_PTR mask = 0;
+		for (const auto core : cores) {
+			if (core < sizeof(DWORD_PTR) * 8) {
+				mask |= DWORD_PTR(1) << core;
+			}
+		}
+		return mask != 0 && SetThreadAffinityMask(handle, mask) != 0;
+#elif defined(__linux__)
+		cpu_set_t set;
+		CPU_ZERO(&set);
+		for (const auto core : cores) {
+			if (core < CPU_SETSIZE) {
+				CPU_SET(core, &set);
+			}
+		}
+		return CPU_COUNT(&set) != 0 && pthread_setaffinity_np(handle, sizeof(set), &set) == 0;
+#else
+		// Thread affinity is not supported on this platform (e.g. macOS)
+		return false;
+#endif
+	}
+}
+
 ThreadPool::ThreadPool(Logger &logger) :
 	BS::thread_pool(std::max<int>(getNumberOfCores(), DEFAULT_NUMBER_OF_THREADS)), logger(logger) {
 	start();
@@ -38,4 +81,107 @@ void ThreadPool::shutdown() {
 	logger.info("Shutting down thread pool...");
 	stopped = true;
 	wait();
+	for (const auto &lane : lanes) {
+		if (lane.owner) {
+			lane.owner->wait();
+		}
+	}
+}
+
+void ThreadPool::setLaneThreads(ThreadLane lane, uint16_t threads) {
+	auto &state = lanes[static_cast<size_t>(lane)];
+	if (threads == 0 || state.owner) {
+		return;
+	}
+
+	state.owner = std::make_unique<BS::thread_pool>(threads);
+	state.pool.store(state.owner.get(), std::memory_order_release);
+	logger.info("Running {} lane with {} threads.", magic_enum::enum_name(lane), threads);
+}
+
+void ThreadPool::onLaneQueued(ThreadLane lane) {
+	lanes[static_cast<size_t>(lane)].queued.fetch_add(1, std::memory_order_relaxed);
+	g_metrics().addUpDownCounter("thread_pool_queue_depth", 1, { { "lane", std::string(magic_enum::enum_name(lane)) } });
+}
+
+void ThreadPool::onLaneStarted(ThreadLane lane) {
+	lanes[static_cast<size_t>(lane)].queued.fetch_sub(1, std::memory_order_relaxed);
+	g_metrics().addUpDownCounter("thread_pool_queue_depth", -1, { { "lane", std::string(magic_enum::enum_name(lane)) } });
+}
+
+void ThreadPool::setAffinity(int32_t gameCore, std::vector<uint16_t> workerCores) {
+	if (gameCore >= 0) {
+		if (workerCores.empty()) {
+			for (uint16_t core = 0; core < getNumberOfCores(); ++core) {
+				workerCores.emplace_back(core);
+			}
+		}
+		std::erase(workerCores, static_cast<uint16_t>(gameCore));
+
+		if (pinThread(currentThread(), { static_cast<uint16_t>(gameCore) })) {
+			logger.info("Game thread pinned to core {}.", gameCore);
+		} else {
+			logger.warn("Failed to pin the game thread to core {}.", gameCore);
+		}
+	}
+
+	if (workerCores.empty()) {
+		return;
+	}
+
+	auto handles = get_native_handles();
+	for (const auto &lane : lanes) {
+		if (lane.owner) {
+			const auto laneHandles = lane.owner->get_native_handles();
+			handles.insert(handles.end(), laneHandles.begin(), laneHandles.end());
+		}
+	}
+
+	size_t pinned = 0;
+	for (const auto &handle : handles) {
+		if (!isCurrentThread(handle) && pinThread(handle, workerCores)) {
+			++pinned;
+		}
+	}
+
+	logger.info("{} worker threads pinned to cores {}.", pinned, fmt::join(workerCores, ","));
+}
+
+std::vector<uint16_t> ThreadPool::parseCoreList(const std::string &list) {
+	std::vector<uint16_t> cores;
+	for (const auto &range : explodeString(list, ",")) {
+		const auto separator = range.find('-');
+		const auto first = std::atoi(range.substr(0, separator).c_str());
+		const auto last = separator == std::string::npos ? first : std::atoi(range.substr(separator + 1).c_str());
+		for (auto core = first; core <= last; ++core) {
+			if (core >= 0 && std::ranges::find(cores, core) == cores.end()) {
+				cores.emplace_back(static_cast<uint16_t>(core));
+			}
+		}
+	}
+	return cores;
+}
+
+std::vector<uint16_t> ThreadPool::getNumaNodeCores(uint16_t node) {
+#if defined(_WIN32)
+	std::vector<uint16_t> cores;
+	ULONGLONG mask = 0;
+	if (GetNumaNodeProcessorMask(static_cast<UCHAR>(node), &mask)) {
+		for (uint16_t core = 0; core < sizeof(mask) * 8; ++core) {
+			if (mask & (ULONGLONG(1) << core)) {
+				cores.emplace_back(core);
+			}
+		}
+	}
+	return cores;
+#elif defined(__linux__)
+	std::ifstream file(fmt::format("/sys/devices/system/node/node{}/cpulist", node));
+	std::string list;
+	if (!file || !std::getline(file, list)) {
+		return {};
+	}
+	return parseCoreList(list);
+#else
+	return {};
+#endif
 }
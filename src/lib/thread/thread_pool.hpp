@@ -9,8 +9,27 @@
 #pragma once
 
 #include "lib/logging/logger.hpp"
+
+// Needed to pin the worker threads to specific cores
+#define BS_THREAD_POOL_NATIVE_HANDLES
 #include "BS_thread_pool.hpp"
 
+/**
+ * Background I/O and CPU-heavy work that can run on its own threads,
+ * so it does not hold the workers the game loop depends on.
+ */
+enum class ThreadLane : uint8_t {
+	Database,
+	Save,
+	Network,
+	// The RSA decryption and the password check of the logins
+	Crypto,
+	// The jobs of the Lua worker states, a thread for each state (see LuaWorkers)
+	Lua,
+
+	Count
+};
+
 class ThreadPool : public BS::thread_pool {
 public:
 	explicit ThreadPool(Logger &logger);
@@ -22,6 +41,55 @@ public:
 	void start();
 	void shutdown();
 
+	/**
+	 * Pins the calling thread (the one running the serial game loop) to gameCore
+	 * and every other worker to workerCores, the game core is never shared with the workers.
+	 * A negative gameCore keeps the calling thread unpinned, an empty workerCores
+	 * means every core except the game one.
+	 */
+	void setAffinity(int32_t gameCore, std::vector<uint16_t> workerCores);
+
+	/**
+	 * Parses a core list like "0-3,6,8-9".
+	 */
+	static std::vector<uint16_t> parseCoreList(const std::string &list);
+
+	/**
+	 * @return the cores of the given NUMA node, empty if the node does not exist
+	 * or the platform does not expose it.
+	 */
+	static std::vector<uint16_t> getNumaNodeCores(uint16_t node);
+
+	/**
+	 * Gives the lane a dedicated sub-pool with the given number of threads.
+	 * Lanes without threads (the default) run their tasks on the main pool.
+	 * Can only be set once, at startup.
+	 */
+	void setLaneThreads(ThreadLane lane, uint16_t threads);
+
+	template <typename F>
+	void detachTask(ThreadLane lane, F &&task) {
+		auto &state = lanes[static_cast<size_t>(lane)];
+		onLaneQueued(lane);
+		auto wrapped = [this, lane, task = std::forward<F>(task)]() mutable {
+			onLaneStarted(lane);
+			task();
+		};
+
+		if (auto* pool = state.pool.load(std::memory_order_acquire)) {
+			pool->detach_task(std::move(wrapped));
+		} else {
+			detach_task(std::move(wrapped));
+		}
+	}
+
+	/**
+	 * @return the number of tasks of the lane waiting for a thread.
+	 */
+	int64_t getLaneQueueDepth(ThreadLane lane) const {
+		return lanes[static_cast<size_t>(lane)].queued.load(std::memory_order_relaxed);
+	}
+
 	static int16_t getThreadId() {
 		static std::atomic_int16_t lastId = -1;
 		thread_local static int16_t id = -1;
@@ -39,6 +107,17 @@ public:
 	}
 
 private:
+	struct Lane {
+		std::unique_ptr<BS::thread_pool> owner;
+		std::atomic<BS::thread_pool*> pool = nullptr;
+		std::atomic_int64_t queued = 0;
+	};
+
+	void onLaneQueued(ThreadLane lane);
+	void onLaneStarted(ThreadLane lane);
+
 	Logger &logger;
 	bool stopped = false;
+
+	std::array<Lane, static_cast<size_t>(ThreadLane::Count)> lanes;
 };
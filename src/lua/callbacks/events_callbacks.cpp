@@ -46,7 +46,26 @@ void EventsCallbacks::addCallback(const std::shared_ptr<EventCallback> &callback
 
 	g_logger().trace("Registering event callback: {}", callback->getName());
 
-	m_callbacks[callback->getName()] = callback;
+	auto &registered = m_callbacks[callback->getName()];
+	const auto replacedType = registered ? registered->getType() : callback->getType();
+	registered = callback;
+
+	rebuildCallbacks(callback->getType());
+	if (replacedType != callback->getType()) {
+		rebuildCallbacks(replacedType);
+	}
+}
+
+void EventsCallbacks::rebuildCallbacks(EventCallback_t type) {
+	auto callbacks = std::make_shared<CallbackList>();
+	for (const auto &[name, callback] : m_callbacks) {
+		if (callback && callback->getType() == type && callback->isLoadedCallback()) {
+			callbacks->emplace_back(callback);
+		}
+	}
+
+	auto &slot = m_callbacksByType[static_cast<size_t>(type)];
+	slot = callbacks->empty() ? nullptr : std::move(callbacks);
 }
 
 std::unordered_map<std::string, std::shared_ptr<EventCallback>> EventsCallbacks::getCallbacks() const {
@@ -68,4 +87,5 @@ std::unordered_map<std::string, std::shared_ptr<EventCallback>> EventsCallbacks:
 
 void EventsCallbacks::clear() {
 	m_callbacks.clear();
+	m_callbacksByType.fill(nullptr);
 }
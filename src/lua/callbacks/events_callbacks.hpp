@@ -88,7 +88,12 @@ public:
 	 */
 	template <typename CallbackFunc, typename... Args>
 	void executeCallback(EventCallback_t eventType, CallbackFunc callbackFunc, Args &&... args) {
-		for (const auto &[name, callback] : getCallbacksByType(eventType)) {
+		const auto callbacks = m_callbacksByType[static_cast<size_t>(eventType)];
+		if (!callbacks) {
+			return;
+		}
+
+		for (const auto &callback : *callbacks) {
 			auto argsCopy = std::make_tuple(args...);
 			if (callback && callback->isLoadedCallback()) {
 				std::apply(
@@ -97,7 +102,7 @@ public:
 					},
 					argsCopy
 				);
-				g_logger().trace("Executed callback: {}", name);
+				g_logger().trace("Executed callback: {}", callback->getName());
 			}
 		}
 	}
@@ -111,7 +116,12 @@ public:
 	template <typename CallbackFunc, typename... Args>
 	ReturnValue checkCallbackWithReturnValue(EventCallback_t eventType, CallbackFunc callbackFunc, Args &&... args) {
 		ReturnValue res = RETURNVALUE_NOERROR;
-		for (const auto &[name, callback] : getCallbacksByType(eventType)) {
+		const auto callbacks = m_callbacksByType[static_cast<size_t>(eventType)];
+		if (!callbacks) {
+			return res;
+		}
+
+		for (const auto &callback : *callbacks) {
 			auto argsCopy = std::make_tuple(args...);
 			if (callback && callback->isLoadedCallback()) {
 				ReturnValue callbackResult = std::apply(
@@ -139,7 +149,12 @@ public:
 	bool checkCallback(EventCallback_t eventType, CallbackFunc callbackFunc, Args &&... args) {
 		bool allCallbacksSucceeded = true;
 
-		for (const auto &[name, callback] : getCallbacksByType(eventType)) {
+		const auto callbacks = m_callbacksByType[static_cast<size_t>(eventType)];
+		if (!callbacks) {
+			return allCallbacksSucceeded;
+		}
+
+		for (const auto &callback : *callbacks) {
 			auto argsCopy = std::make_tuple(args...);
 			if (callback && callback->isLoadedCallback()) {
 				bool callbackResult = std::apply(
@@ -155,8 +170,20 @@ public:
 	}
 
 private:
+	using CallbackList = std::vector<std::shared_ptr<EventCallback>>;
+
+	/**
+	 * @brief Rebuilds the dispatch list of an event type from the registered callbacks.
+	 * @details The list is replaced, not changed, so a callback that registers or reloads scripts
+	 * while the list is being executed does not invalidate it.
+	 * @param type The type of event to rebuild.
+	 */
+	void rebuildCallbacks(EventCallback_t type);
+
 	// Container for storing registered event callbacks.
 	std::unordered_map<std::string, std::shared_ptr<EventCallback>> m_callbacks;
+	// The callbacks of each event type, indexed by the type, nullptr when the type has none
+	std::array<std::shared_ptr<const CallbackList>, magic_enum::enum_count<EventCallback_t>()> m_callbacksByType;
 };
 
 constexpr auto g_callbacks = EventsCallbacks::getInstance;
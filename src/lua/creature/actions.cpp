@@ -27,6 +27,16 @@ void Actions::clear() {
 	actionPositionMap.clear();
 }
 
+void Actions::clearFile(uint32_t fileId) {
+	const auto fromFile = [fileId](const auto &entry) {
+		return entry.second->getFileId() == fileId;
+	};
+	phmap::erase_if(useItemMap, fromFile);
+	phmap::erase_if(uniqueItemMap, fromFile);
+	phmap::erase_if(actionItemMap, fromFile);
+	phmap::erase_if(actionPositionMap, fromFile);
+}
+
 bool Actions::registerLuaItemEvent(const std::shared_ptr<Action> action) {
 	auto itemIdVector = action->getItemIdsVector();
 	if (itemIdVector.empty()) {
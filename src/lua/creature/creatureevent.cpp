@@ -19,6 +19,14 @@ void CreatureEvents::clear() {
 	}
 }
 
+void CreatureEvents::clearFile(uint32_t fileId) {
+	for (auto &[name, event] : creatureEvents) {
+		if (event->isLoaded() && event->getFileId() == fileId) {
+			event->clearEvent();
+		}
+	}
+}
+
 bool CreatureEvents::registerLuaEvent(const std::shared_ptr<CreatureEvent> creatureEvent) {
 	if (creatureEvent->getEventType() == CREATURE_EVENT_NONE) {
 		g_logger().error(
@@ -159,6 +167,7 @@ void CreatureEvent::copyEvent(const std::shared_ptr<CreatureEvent> creatureEvent
 	setScriptId(creatureEvent->getScriptId());
 	setScriptInterface(creatureEvent->getScriptInterface());
 	setLoadedCallback(creatureEvent->isLoadedCallback());
+	setFileId(creatureEvent->getFileId());
 	loaded = creatureEvent->loaded;
 }
 
@@ -87,6 +87,8 @@ public:
 	bool registerLuaEvent(const std::shared_ptr<CreatureEvent> event);
 	void removeInvalidEvents();
 	void clear();
+	// Unloads the events of the script file, creatures keep them until the file registers them again
+	void clearFile(uint32_t fileId);
 
 private:
 	// creature events
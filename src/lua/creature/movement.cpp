@@ -38,6 +38,7 @@ void MoveEvents::clear(bool isFromXML /*= false*/) {
 		if (numRemoved > 0) {
 			g_logger().debug("Removed '{}' MoveEvent from XML.", numRemoved);
 		}
+		rebuildIndex();
 		return;
 	}
 
@@ -45,6 +46,91 @@ void MoveEvents::clear(bool isFromXML /*= false*/) {
 	actionIdMap.clear();
 	itemIdMap.clear();
 	positionsMap.clear();
+	rebuildIndex();
+}
+
+void MoveEvents::clearFile(uint32_t fileId) {
+	const auto clearList = [fileId](MoveEventList &moveEventList) {
+		for (auto &eventList : moveEventList.moveEvent) {
+			eventList.remove_if([fileId](const std::shared_ptr<MoveEvent> &moveEvent) {
+				return moveEvent && moveEvent->getFileId() == fileId;
+			});
+		}
+	};
+
+	for (auto &[id, moveEventList] : itemIdMap) {
+		clearList(moveEventList);
+	}
+	for (auto &[id, moveEventList] : uniqueIdMap) {
+		clearList(moveEventList);
+	}
+	for (auto &[id, moveEventList] : actionIdMap) {
+		clearList(moveEventList);
+	}
+	for (auto &[position, moveEventList] : positionsMap) {
+		clearList(moveEventList);
+	}
+	rebuildIndex();
+}
+
+MoveEvents::EventMask MoveEvents::getMask(const MoveEventList &moveEventList) {
+	EventMask mask = 0;
+	for (int eventType = 0; eventType < MOVE_EVENT_LAST; ++eventType) {
+		if (!moveEventList.moveEvent[eventType].empty()) {
+			mask |= getMask(static_cast<MoveEvent_t>(eventType));
+		}
+	}
+	return mask;
+}
+
+void MoveEvents::indexEvents(std::vector<EventMask> &index, EventMask &indexMask, int32_t id, EventMask mask) {
+	if (id < 0 || static_cast<size_t>(id) >= index.size()) {
+		return;
+	}
+	index[id] |= mask;
+	indexMask |= mask;
+}
+
+void MoveEvents::indexEvents(const Position &position, EventMask mask) {
+	if (mask == 0) {
+		return;
+	}
+	positionEvents[position] |= mask;
+	positionMask |= mask;
+}
+
+void MoveEvents::rebuildIndex() {
+	std::ranges::fill(uniqueIdEvents, 0);
+	std::ranges::fill(actionIdEvents, 0);
+	std::ranges::fill(itemIdEvents, 0);
+	positionEvents.clear();
+	uniqueIdMask = actionIdMask = itemIdMask = positionMask = 0;
+
+	for (const auto &[id, moveEventList] : uniqueIdMap) {
+		indexEvents(uniqueIdEvents, uniqueIdMask, id, moveEventList);
+	}
+	for (const auto &[id, moveEventList] : actionIdMap) {
+		indexEvents(actionIdEvents, actionIdMask, id, moveEventList);
+	}
+	for (const auto &[id, moveEventList] : itemIdMap) {
+		indexEvents(itemIdEvents, itemIdMask, id, moveEventList);
+	}
+	for (const auto &[position, moveEventList] : positionsMap) {
+		indexEvents(position, moveEventList);
+	}
+}
+
+bool MoveEvents::hasEvent(const std::shared_ptr<Item> &item, MoveEvent_t eventType) const {
+	const auto mask = getMask(eventType);
+	if ((itemIdEvents[item->getID()] & mask) != 0) {
+		return true;
+	}
+	if ((actionIdMask & mask) != 0 && item->hasAttribute(ItemAttribute_t::ACTIONID)
+	    && (actionIdEvents[item->getAttribute<uint16_t>(ItemAttribute_t::ACTIONID)] & mask) != 0) {
+		return true;
+	}
+	return (uniqueIdMask & mask) != 0 && item->hasAttribute(ItemAttribute_t::UNIQUEID)
+	    && (uniqueIdEvents[item->getAttribute<uint16_t>(ItemAttribute_t::UNIQUEID)] & mask) != 0;
 }
 
 bool MoveEvents::registerLuaItemEvent(const std::shared_ptr<MoveEvent> moveEvent) {
@@ -65,6 +151,7 @@ bool MoveEvents::registerLuaItemEvent(const std::shared_ptr<MoveEvent> moveEvent
 			it.vocationString = moveEvent->getVocationString();
 		}
 		if (registerEvent(moveEvent, itemId, itemIdMap)) {
+			indexEvents(itemIdEvents, itemIdMask, itemId, getMask(moveEvent->getEventType()));
 			tmpVector.emplace_back(itemId);
 		}
 	}
@@ -84,6 +171,7 @@ bool MoveEvents::registerLuaActionEvent(const std::shared_ptr<MoveEvent> moveEve
 
 	for (const auto &actionId : actionIdVector) {
 		if (registerEvent(moveEvent, actionId, actionIdMap)) {
+			indexEvents(actionIdEvents, actionIdMask, actionId, getMask(moveEvent->getEventType()));
 			tmpVector.emplace_back(actionId);
 		}
 	}
@@ -103,6 +191,7 @@ bool MoveEvents::registerLuaUniqueEvent(const std::shared_ptr<MoveEvent> moveEve
 
 	for (const auto &uniqueId : uniqueIdVector) {
 		if (registerEvent(moveEvent, uniqueId, uniqueIdMap)) {
+			indexEvents(uniqueIdEvents, uniqueIdMask, uniqueId, getMask(moveEvent->getEventType()));
 			tmpVector.emplace_back(uniqueId);
 		}
 	}
@@ -122,6 +211,7 @@ bool MoveEvents::registerLuaPositionEvent(const std::shared_ptr<MoveEvent> moveE
 
 	for (const auto &position : positionVector) {
 		if (registerEvent(moveEvent, position, positionsMap)) {
+			indexEvents(position, getMask(moveEvent->getEventType()));
 			tmpVector.emplace_back(position);
 		}
 	}
@@ -173,6 +263,10 @@ bool MoveEvents::registerEvent(const std::shared_ptr<MoveEvent> moveEvent, int32
 }
 
 std::shared_ptr<MoveEvent> MoveEvents::getEvent(const std::shared_ptr<Item> &item, MoveEvent_t eventType, Slots_t slot) {
+	if (!hasEvent(item, eventType)) {
+		return nullptr;
+	}
+
 	uint32_t slotp;
 	switch (slot) {
 		case CONST_SLOT_HEAD:
@@ -235,6 +329,10 @@ std::shared_ptr<MoveEvent> MoveEvents::getEvent(const std::shared_ptr<Item> &ite
 }
 
 std::shared_ptr<MoveEvent> MoveEvents::getEvent(const std::shared_ptr<Item> &item, MoveEvent_t eventType) {
+	if (!hasEvent(item, eventType)) {
+		return nullptr;
+	}
+
 	std::map<int32_t, MoveEventList>::iterator it;
 	if (item->hasAttribute(ItemAttribute_t::UNIQUEID)) {
 		it = uniqueIdMap.find(item->getAttribute<uint16_t>(ItemAttribute_t::UNIQUEID));
@@ -291,6 +389,13 @@ bool MoveEvents::registerEvent(const std::shared_ptr<MoveEvent> moveEvent, const
 }
 
 std::shared_ptr<MoveEvent> MoveEvents::getEvent(const std::shared_ptr<Tile> &tile, MoveEvent_t eventType) {
+	if ((positionMask & getMask(eventType)) == 0) {
+		return nullptr;
+	}
+	if (auto it = positionEvents.find(tile->getPosition()); it == positionEvents.end() || (it->second & getMask(eventType)) == 0) {
+		return nullptr;
+	}
+
 	if (auto it = positionsMap.find(tile->getPosition());
 	    it != positionsMap.end()) {
 		std::list<std::shared_ptr<MoveEvent>> &moveEventList = it->second.moveEvent[eventType];
@@ -302,6 +407,11 @@ std::shared_ptr<MoveEvent> MoveEvents::getEvent(const std::shared_ptr<Tile> &til
 }
 
 uint32_t MoveEvents::onCreatureMove(const std::shared_ptr<Creature> &creature, const std::shared_ptr<Tile> &tile, MoveEvent_t eventType) {
+	// Nothing registered for this kind of step
+	if (((uniqueIdMask | actionIdMask | itemIdMask | positionMask) & getMask(eventType)) == 0) {
+		return 1;
+	}
+
 	const Position &pos = tile->getPosition();
 
 	uint32_t ret = 1;
@@ -54,7 +54,9 @@ public:
 	}
 
 	void setPosition(Position position, MoveEventList moveEventList) {
-		positionsMap.try_emplace(position, moveEventList);
+		if (positionsMap.try_emplace(position, moveEventList).second) {
+			indexEvents(position, moveEventList);
+		}
 	}
 
 	std::map<int32_t, MoveEventList> getItemIdMap() const {
@@ -70,7 +72,9 @@ public:
 	}
 
 	void setItemId(int32_t itemId, MoveEventList moveEventList) {
-		itemIdMap.try_emplace(itemId, moveEventList);
+		if (itemIdMap.try_emplace(itemId, moveEventList).second) {
+			indexEvents(itemIdEvents, itemIdMask, itemId, moveEventList);
+		}
 	}
 
 	std::map<int32_t, MoveEventList> getUniqueIdMap() const {
@@ -86,7 +90,9 @@ public:
 	}
 
 	void setUniqueId(int32_t uniqueId, MoveEventList moveEventList) {
-		uniqueIdMap.try_emplace(uniqueId, moveEventList);
+		if (uniqueIdMap.try_emplace(uniqueId, moveEventList).second) {
+			indexEvents(uniqueIdEvents, uniqueIdMask, uniqueId, moveEventList);
+		}
 	}
 
 	std::map<int32_t, MoveEventList> getActionIdMap() const {
@@ -102,7 +108,9 @@ public:
 	}
 
 	void setActionId(int32_t actionId, MoveEventList moveEventList) {
-		actionIdMap.try_emplace(actionId, moveEventList);
+		if (actionIdMap.try_emplace(actionId, moveEventList).second) {
+			indexEvents(actionIdEvents, actionIdMask, actionId, moveEventList);
+		}
 	}
 
 	std::shared_ptr<MoveEvent> getEvent(const std::shared_ptr<Item> &item, MoveEvent_t eventType);
@@ -113,11 +121,35 @@ public:
 	bool registerLuaPositionEvent(const std::shared_ptr<MoveEvent> moveEvent);
 	bool registerLuaEvent(const std::shared_ptr<MoveEvent> event);
 	void clear(bool isFromXML = false);
+	// Drops what the script file registered, for an incremental reload
+	void clearFile(uint32_t fileId);
 
 private:
+	// A bit per MoveEvent_t
+	using EventMask = uint8_t;
+	static_assert(MOVE_EVENT_LAST <= std::numeric_limits<EventMask>::digits);
+
+	static EventMask getMask(MoveEvent_t eventType) {
+		return static_cast<EventMask>(1 << eventType);
+	}
+	static EventMask getMask(const MoveEventList &moveEventList);
+
 	void clearMap(std::map<int32_t, MoveEventList> &map) const;
 	void clearPosMap(std::map<Position, MoveEventList> &map);
 
+	void indexEvents(std::vector<EventMask> &index, EventMask &indexMask, int32_t id, EventMask mask);
+	void indexEvents(std::vector<EventMask> &index, EventMask &indexMask, int32_t id, const MoveEventList &moveEventList) {
+		indexEvents(index, indexMask, id, getMask(moveEventList));
+	}
+	void indexEvents(const Position &position, EventMask mask);
+	void indexEvents(const Position &position, const MoveEventList &moveEventList) {
+		indexEvents(position, getMask(moveEventList));
+	}
+	// After events were removed from the maps
+	void rebuildIndex();
+	// Cheap test before the maps, almost every item and tile has no event
+	bool hasEvent(const std::shared_ptr<Item> &item, MoveEvent_t eventType) const;
+
 	bool registerEvent(const std::shared_ptr<MoveEvent> moveEvent, int32_t id, std::map<int32_t, MoveEventList> &moveListMap) const;
 	bool registerEvent(const std::shared_ptr<MoveEvent> moveEvent, const Position &position, std::map<Position, MoveEventList> &moveListMap) const;
 	std::shared_ptr<MoveEvent> getEvent(const std::shared_ptr<Tile> &tile, MoveEvent_t eventType);
@@ -128,6 +160,16 @@ private:
 	std::map<int32_t, MoveEventList> actionIdMap;
 	std::map<int32_t, MoveEventList> itemIdMap;
 	std::map<Position, MoveEventList> positionsMap;
+
+	// The event types registered for every id and position, and the types registered for any of them
+	std::vector<EventMask> uniqueIdEvents = std::vector<EventMask>(std::numeric_limits<uint16_t>::max() + 1);
+	std::vector<EventMask> actionIdEvents = std::vector<EventMask>(std::numeric_limits<uint16_t>::max() + 1);
+	std::vector<EventMask> itemIdEvents = std::vector<EventMask>(std::numeric_limits<uint16_t>::max() + 1);
+	phmap::flat_hash_map<Position, EventMask> positionEvents;
+	EventMask uniqueIdMask = 0;
+	EventMask actionIdMask = 0;
+	EventMask itemIdMask = 0;
+	EventMask positionMask = 0;
 };
 
 constexpr auto g_moveEvents = MoveEvents::getInstance;
@@ -16,6 +16,30 @@
 #include "creatures/monsters/monster.hpp"
 #include "server/network/webhook/webhook.hpp"
 
+namespace {
+	std::shared_ptr<RaidMonsterPool> prepareMonsters(std::vector<std::shared_ptr<MonsterType>> monsterTypes) {
+		auto pool = std::make_shared<RaidMonsterPool>();
+		pool->monsters.reserve(monsterTypes.size());
+		g_dispatcher().asyncEvent([pool, monsterTypes = std::move(monsterTypes)] {
+			for (const auto &monsterType : monsterTypes) {
+				pool->monsters.emplace_back(std::make_shared<Monster>(monsterType));
+			}
+			pool->ready.store(true, std::memory_order_release);
+		});
+		return pool;
+	}
+
+	// The monsters of the pool, nothing if it is still being prepared
+	std::vector<std::shared_ptr<Monster>> takeMonsters(std::shared_ptr<RaidMonsterPool> &pool) {
+		std::vector<std::shared_ptr<Monster>> monsters;
+		if (pool && pool->ready.load(std::memory_order_acquire)) {
+			monsters = std::move(pool->monsters);
+		}
+		pool = nullptr;
+		return monsters;
+	}
+}
+
 Raids::Raids() {
 	scriptInterface.initState();
 }
@@ -223,6 +247,7 @@ void Raid::startRaid() {
 		nextEventEvent = g_dispatcher().scheduleEvent(
 			raidEvent->getDelay(), [this, raidEvent] { executeRaidEvent(raidEvent); }, "Raid::executeRaidEvent"
 		);
+		raidEvent->prepareEvent();
 	} else {
 		g_logger().warn("[raids] Raid {} has no events", name);
 		resetRaid();
@@ -239,6 +264,7 @@ void Raid::executeRaidEvent(const std::shared_ptr<RaidEvent> raidEvent) {
 			nextEventEvent = g_dispatcher().scheduleEvent(
 				ticks, [this, newRaidEvent] { executeRaidEvent(newRaidEvent); }, __FUNCTION__
 			);
+			newRaidEvent->prepareEvent();
 		} else {
 			resetRaid();
 		}
@@ -375,8 +401,15 @@ bool SingleSpawnEvent::configureRaidEvent(const pugi::xml_node &eventNode) {
 	return true;
 }
 
+void SingleSpawnEvent::prepareEvent() {
+	if (const auto monsterType = g_monsters().getMonsterType(monsterName)) {
+		pool = prepareMonsters({ monsterType });
+	}
+}
+
 bool SingleSpawnEvent::executeEvent() {
-	std::shared_ptr<Monster> monster = Monster::createMonster(monsterName);
+	const auto monsters = takeMonsters(pool);
+	std::shared_ptr<Monster> monster = monsters.empty() ? Monster::createMonster(monsterName) : monsters.front();
 	if (!monster) {
 		g_logger().error("{} - Cant create monster {}", __FUNCTION__, monsterName);
 		return false;
@@ -535,33 +568,66 @@ bool AreaSpawnEvent::configureRaidEvent(const pugi::xml_node &eventNode) {
 	return true;
 }
 
-bool AreaSpawnEvent::executeEvent() {
+bool AreaSpawnEvent::getMonsterTypes(std::vector<std::shared_ptr<MonsterType>> &monsterTypes) const {
 	for (const MonsterSpawn &spawn : spawnMonsterList) {
-		uint32_t amount = uniform_random(spawn.minAmount, spawn.maxAmount);
-		for (uint32_t i = 0; i < amount; ++i) {
-			std::shared_ptr<Monster> monster = Monster::createMonster(spawn.name);
-			if (!monster) {
-				g_logger().error("{} - Can't create monster {}", __FUNCTION__, spawn.name);
-				return false;
-			}
+		const auto monsterType = g_monsters().getMonsterType(spawn.name);
+		if (!monsterType) {
+			g_logger().error("{} - Can't create monster {}", __FUNCTION__, spawn.name);
+			return false;
+		}
 
-			bool success = false;
-			for (int32_t tries = 0; tries < MAXIMUM_TRIES_PER_MONSTER; tries++) {
-				std::shared_ptr<Tile> tile = g_game().map.getTile(static_cast<uint16_t>(uniform_random(fromPos.x, toPos.x)), static_cast<uint16_t>(uniform_random(fromPos.y, toPos.y)), static_cast<uint8_t>(uniform_random(fromPos.z, toPos.z)));
-				if (tile && !tile->isMovableBlocking() && !tile->hasFlag(TILESTATE_PROTECTIONZONE) && tile->getTopCreature() == nullptr && g_game().placeCreature(monster, tile->getPosition(), false, true)) {
-					success = true;
-					monster->setForgeMonster(false);
-					break;
-				}
-			}
+		const uint32_t amount = uniform_random(spawn.minAmount, spawn.maxAmount);
+		monsterTypes.insert(monsterTypes.end(), amount, monsterType);
+	}
+	return true;
+}
 
-			if (!success) {
-			}
+void AreaSpawnEvent::prepareEvent() {
+	std::vector<std::shared_ptr<MonsterType>> monsterTypes;
+	if (getMonsterTypes(monsterTypes)) {
+		pool = prepareMonsters(std::move(monsterTypes));
+	}
+}
+
+bool AreaSpawnEvent::executeEvent() {
+	auto monsters = takeMonsters(pool);
+	if (monsters.empty()) {
+		std::vector<std::shared_ptr<MonsterType>> monsterTypes;
+		if (!getMonsterTypes(monsterTypes)) {
+			return false;
+		}
+
+		monsters.reserve(monsterTypes.size());
+		for (const auto &monsterType : monsterTypes) {
+			monsters.emplace_back(std::make_shared<Monster>(monsterType));
 		}
 	}
+
+	placeMonsters(std::make_shared<std::vector<std::shared_ptr<Monster>>>(std::move(monsters)), 0, fromPos, toPos);
 	return true;
 }
 
+void AreaSpawnEvent::placeMonsters(const std::shared_ptr<std::vector<std::shared_ptr<Monster>>> &monsters, size_t first, const Position &fromPos, const Position &toPos) {
+	const size_t last = std::min(monsters->size(), first + RAID_SPAWN_BATCH_SIZE);
+	for (size_t i = first; i < last; ++i) {
+		const auto &monster = (*monsters)[i];
+		for (int32_t tries = 0; tries < MAXIMUM_TRIES_PER_MONSTER; tries++) {
+			std::shared_ptr<Tile> tile = g_game().map.getTile(static_cast<uint16_t>(uniform_random(fromPos.x, toPos.x)), static_cast<uint16_t>(uniform_random(fromPos.y, toPos.y)), static_cast<uint8_t>(uniform_random(fromPos.z, toPos.z)));
+			if (tile && !tile->isMovableBlocking() && !tile->hasFlag(TILESTATE_PROTECTIONZONE) && tile->getTopCreature() == nullptr && g_game().placeCreature(monster, tile->getPosition(), false, true)) {
+				monster->setForgeMonster(false);
+				break;
+			}
+		}
+	}
+
+	// The batches hold the monsters themselves, a reload of the raids does not cut them short
+	if (last < monsters->size()) {
+		g_dispatcher().scheduleEvent(
+			RAID_SPAWN_BATCH_INTERVAL, [monsters, last, fromPos, toPos] { placeMonsters(monsters, last, fromPos, toPos); }, "AreaSpawnEvent::placeMonsters"
+		);
+	}
+}
+
 bool ScriptEvent::configureRaidEvent(const pugi::xml_node &eventNode) {
 	if (!RaidEvent::configureRaidEvent(eventNode)) {
 		return false;
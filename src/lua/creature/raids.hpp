@@ -27,9 +27,23 @@ struct MonsterSpawn {
 static constexpr int32_t MAXIMUM_TRIES_PER_MONSTER = 10;
 static constexpr int32_t CHECK_RAIDS_INTERVAL = 60;
 static constexpr int32_t RAID_MINTICKS = 1000;
+// The monsters of a spawn event are placed this many at a time, one batch every interval
+static constexpr size_t RAID_SPAWN_BATCH_SIZE = 20;
+static constexpr uint32_t RAID_SPAWN_BATCH_INTERVAL = 100;
 
 class Raid;
 class RaidEvent;
+class Monster;
+class MonsterType;
+
+/**
+ * The monsters of a spawn event, created on another thread while the raid waits for the event,
+ * so the event only has to place them.
+ */
+struct RaidMonsterPool {
+	std::vector<std::shared_ptr<Monster>> monsters;
+	std::atomic_bool ready = false;
+};
 
 class Raids {
 public:
@@ -144,6 +158,10 @@ public:
 
 	virtual bool configureRaidEvent(const pugi::xml_node &eventNode);
 
+	/**
+	 * Called when the event is scheduled, ahead of executeEvent.
+	 */
+	virtual void prepareEvent() { }
 	virtual bool executeEvent() = 0;
 	uint32_t getDelay() const {
 		return delay;
@@ -170,22 +188,30 @@ class SingleSpawnEvent final : public RaidEvent {
 public:
 	bool configureRaidEvent(const pugi::xml_node &eventNode) override;
 
+	void prepareEvent() override;
 	bool executeEvent() override;
 
 private:
 	std::string monsterName;
 	Position position;
+	std::shared_ptr<RaidMonsterPool> pool;
 };
 
 class AreaSpawnEvent final : public RaidEvent {
 public:
 	bool configureRaidEvent(const pugi::xml_node &eventNode) override;
 
+	void prepareEvent() override;
 	bool executeEvent() override;
 
 private:
+	// Rolls the amount of each monster, false if one of them does not exist
+	bool getMonsterTypes(std::vector<std::shared_ptr<MonsterType>> &monsterTypes) const;
+	static void placeMonsters(const std::shared_ptr<std::vector<std::shared_ptr<Monster>>> &monsters, size_t first, const Position &fromPos, const Position &toPos);
+
 	std::list<MonsterSpawn> spawnMonsterList;
 	Position fromPos, toPos;
+	std::shared_ptr<RaidMonsterPool> pool;
 };
 
 class ScriptEvent final : public RaidEvent, public Event {
@@ -18,11 +18,32 @@ TalkActions::~TalkActions() = default;
 
 void TalkActions::clear() {
 	talkActions.clear();
+	talkActionsByWord.clear();
+}
+
+void TalkActions::clearFile(uint32_t fileId) {
+	const auto fromFile = [fileId](const auto &entry) {
+		return entry.second->getFileId() == fileId;
+	};
+	std::erase_if(talkActions, fromFile);
+	phmap::erase_if(talkActionsByWord, fromFile);
 }
 
 bool TalkActions::registerLuaEvent(const TalkAction_ptr &talkAction) {
-	auto [iterator, inserted] = talkActions.try_emplace(talkAction->getWords(), talkAction);
-	return inserted;
+	const auto &words = talkAction->getWords();
+	auto [iterator, inserted] = talkActions.try_emplace(words, talkAction);
+	if (!inserted) {
+		return false;
+	}
+
+	if (words.find(',') != std::string::npos) {
+		for (auto &word : split(words)) {
+			talkActionsByWord.try_emplace(std::move(word), talkAction);
+		}
+	} else {
+		talkActionsByWord.try_emplace(words, talkAction);
+	}
+	return true;
 }
 
 bool TalkActions::checkWord(std::shared_ptr<Player> player, SpeakClasses type, const std::string &words, const std::string_view &word, const TalkAction_ptr &talkActionPtr) const {
@@ -58,23 +79,17 @@ bool TalkActions::checkWord(std::shared_ptr<Player> player, SpeakClasses type, c
 		}
 	}
 
-	return talkActionPtr->executeSay(player, words, param, type);
+	// A reload of the scripts from the talkaction itself drops it from the map while it runs
+	const auto talkAction = talkActionPtr;
+	return talkAction->executeSay(player, words, param, type);
 }
 
 TalkActionResult_t TalkActions::checkPlayerCanSayTalkAction(std::shared_ptr<Player> player, SpeakClasses type, const std::string &words) const {
-	for (const auto &[talkactionWords, talkActionPtr] : talkActions) {
-		if (talkactionWords.find(',') != std::string::npos) {
-			auto wordsList = split(talkactionWords);
-			for (const auto &word : wordsList) {
-				if (checkWord(player, type, words, word, talkActionPtr)) {
-					return TALKACTION_BREAK;
-				}
-			}
-		} else {
-			if (checkWord(player, type, words, talkactionWords, talkActionPtr)) {
-				return TALKACTION_BREAK;
-			}
-		}
+	// Only the talkaction of the first word can match, checkWord compares the whole word
+	const auto spacePos = std::ranges::find_if(words.begin(), words.end(), ::isspace);
+	const auto it = talkActionsByWord.find(words.substr(0, spacePos - words.begin()));
+	if (it != talkActionsByWord.end() && checkWord(player, type, words, it->first, it->second)) {
+		return TALKACTION_BREAK;
 	}
 	return TALKACTION_CONTINUE;
 }
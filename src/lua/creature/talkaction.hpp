@@ -87,6 +87,8 @@ public:
 
 	bool registerLuaEvent(const TalkAction_ptr &talkAction);
 	void clear();
+	// Drops what the script file registered, for an incremental reload
+	void clearFile(uint32_t fileId);
 
 	const std::map<std::string, std::shared_ptr<TalkAction>> &getTalkActionsMap() const {
 		return talkActions;
@@ -94,6 +96,8 @@ public:
 
 private:
 	std::map<std::string, std::shared_ptr<TalkAction>> talkActions;
+	// The same talkactions by each of their comma separated words, the first one registered of each word
+	phmap::flat_hash_map<std::string, std::shared_ptr<TalkAction>> talkActionsByWord;
 };
 
 constexpr auto g_talkActions = TalkActions::getInstance;
@@ -12,6 +12,7 @@
 #include "core.hpp"
 #include "creatures/monsters/monster.hpp"
 #include "game/functions/game_reload.hpp"
+#include "game/memory_census.hpp"
 #include "game/game.hpp"
 #include "items/item.hpp"
 #include "io/iobestiary.hpp"
@@ -20,6 +21,15 @@
 #include "lua/functions/core/game/game_functions.hpp"
 #include "lua/functions/events/event_callback_functions.hpp"
 #include "game/scheduling/dispatcher.hpp"
+#include "game/scheduling/task_profiler.hpp"
+#include "lib/metrics/allocation_counter.hpp"
+#include "server/network/connection/connection.hpp"
+#include "creatures/combat/combat_trace.hpp"
+#include "lua/scripts/lua_profiler.hpp"
+#include "lua/scripts/lua_memory.hpp"
+#include "lua/scripts/lua_workers.hpp"
+#include "lua/global/globalevent.hpp"
+#include "lua/scripts/scripts.hpp"
 #include "lua/creature/talkaction.hpp"
 #include "lua/functions/creatures/npc/npc_type_functions.hpp"
 #include "lua/scripts/lua_environment.hpp"
@@ -36,6 +46,7 @@
 int GameFunctions::luaGameCreateMonsterType(lua_State* L) {
 	// Game.createMonsterType(name[, variant = ""[, alternateName = ""]])
 	if (isString(L, 1)) {
+		g_scripts().requireFullReload();
 		const auto name = getString(L, 1);
 		std::string uniqueName = name;
 		auto variant = getString(L, 2, "");
@@ -116,6 +127,91 @@ int GameFunctions::luaGameGetSpectators(lua_State* L) {
 	return 1;
 }
 
+namespace {
+	// The upvalue of a Game.iterateSpectators iterator
+	struct SpectatorIterator {
+		CreatureVector creatures;
+		size_t next = 0;
+	};
+
+	constexpr const char* SPECTATOR_ITERATOR = "SpectatorIterator";
+}
+
+int GameFunctions::luaGameIterateSpectators(lua_State* L) {
+	// Game.iterateSpectators(position[, multifloor = false[, filter = "all"[, minRangeX = 0[, maxRangeX = 0[, minRangeY = 0[, maxRangeY = 0]]]]]])
+	// filter is "all", "players", "monsters" or "npcs", true is "players" like the onlyPlayer of getSpectators
+	// for creature in Game.iterateSpectators(position, false, "monsters", 7, 7, 5, 5) do ... end
+	const Position &position = getPosition(L, 1);
+	const bool multifloor = getBoolean(L, 2, false);
+	std::string filter = "all";
+	if (lua_isboolean(L, 3)) {
+		filter = getBoolean(L, 3) ? "players" : "all";
+	} else if (isString(L, 3)) {
+		filter = asLowerCaseString(getString(L, 3));
+	}
+	const int32_t minRangeX = getNumber<int32_t>(L, 4, 0);
+	const int32_t maxRangeX = getNumber<int32_t>(L, 5, 0);
+	const int32_t minRangeY = getNumber<int32_t>(L, 6, 0);
+	const int32_t maxRangeY = getNumber<int32_t>(L, 7, 0);
+
+	if (filter != "all" && filter != "players" && filter != "monsters" && filter != "npcs") {
+		reportErrorFunc(fmt::format("Unknown spectator filter {}, expected all, players, monsters or npcs.", filter));
+		lua_pushnil(L);
+		return 1;
+	}
+
+	auto* iterator = new (lua_newuserdata(L, sizeof(SpectatorIterator))) SpectatorIterator();
+	if (luaL_newmetatable(L, SPECTATOR_ITERATOR) != 0) {
+		lua_pushcfunction(L, GameFunctions::luaGameSpectatorIteratorGc);
+		lua_setfield(L, -2, "__gc");
+	}
+	lua_setmetatable(L, -2);
+
+	// The loop body can run anything (moves, removals), so the sector lists are only walked here,
+	// the creatures are kept in a C++ vector and made userdata one at a time as the loop asks for them
+	if (filter == "players") {
+		Spectators::forEach<Player>(position, multifloor, minRangeX, maxRangeX, minRangeY, maxRangeY, [iterator](Player &player) {
+			iterator->creatures.emplace_back(player.getCreature());
+		});
+	} else {
+		const bool onlyMonsters = filter == "monsters";
+		const bool onlyNpcs = filter == "npcs";
+		Spectators::forEach<Creature>(position, multifloor, minRangeX, maxRangeX, minRangeY, maxRangeY, [iterator, onlyMonsters, onlyNpcs](Creature &creature) {
+			if ((onlyMonsters && !creature.getMonster()) || (onlyNpcs && !creature.getNpc())) {
+				return;
+			}
+			iterator->creatures.emplace_back(creature.getCreature());
+		});
+	}
+
+	lua_pushcclosure(L, GameFunctions::luaGameSpectatorIteratorNext, 1);
+	return 1;
+}
+
+int GameFunctions::luaGameSpectatorIteratorNext(lua_State* L) {
+	auto* iterator = static_cast<SpectatorIterator*>(lua_touserdata(L, lua_upvalueindex(1)));
+	while (iterator->next < iterator->creatures.size()) {
+		const auto creature = std::move(iterator->creatures[iterator->next++]);
+		// Removed by the loop body since the search
+		if (creature && !creature->isRemoved()) {
+			pushUserdata<Creature>(L, creature);
+			setCreatureMetatable(L, -1, creature);
+			return 1;
+		}
+	}
+
+	// The loop is over, the creatures are released now instead of on the next collection
+	iterator->creatures = {};
+	iterator->next = 0;
+	lua_pushnil(L);
+	return 1;
+}
+
+int GameFunctions::luaGameSpectatorIteratorGc(lua_State* L) {
+	static_cast<SpectatorIterator*>(lua_touserdata(L, 1))->~SpectatorIterator();
+	return 0;
+}
+
 int GameFunctions::luaGameGetBoostedCreature(lua_State* L) {
 	// Game.getBoostedCreature()
 	pushString(L, g_game().getBoostedMonsterName());
@@ -650,6 +746,14 @@ int GameFunctions::luaGameGetOfflinePlayer(lua_State* L) {
 	return 1;
 }
 
+int GameFunctions::luaGameRemoveOfflinePlayer(lua_State* L) {
+	// Game.removeOfflinePlayer(guid)
+	// After a direct write to the players row, the cached offline copy would write the old values back
+	g_game().removeOfflinePlayer(getNumber<uint32_t>(L, 1));
+	pushBoolean(L, true);
+	return 1;
+}
+
 int GameFunctions::luaGameGetNormalizedPlayerName(lua_State* L) {
 	// Game.getNormalizedPlayerName(name[, isNewName = false])
 	auto name = getString(L, 1);
@@ -919,3 +1023,261 @@ int GameFunctions::luaGameGetAchievements(lua_State* L) {
 	}
 	return 1;
 }
+
+int GameFunctions::luaGameGetTaskProfile(lua_State* L) {
+	// Game.getTaskProfile([count = 10[, seconds = 60]])
+	const auto count = getNumber<uint32_t>(L, 1, 10);
+	const auto seconds = getNumber<uint32_t>(L, 2, 60);
+	const auto entries = g_taskProfiler().getTop(count, seconds);
+	int index = 0;
+	lua_createtable(L, entries.size(), 0);
+	for (const auto &entry : entries) {
+		lua_createtable(L, 0, 6);
+		setField(L, "context", std::string(entry.context));
+		setField(L, "count", entry.count);
+		setField(L, "totalTime", entry.totalTime);
+		setField(L, "averageTime", entry.averageTime);
+		setField(L, "p99Time", entry.p99Time);
+		setField(L, "allocations", entry.allocations);
+		lua_rawseti(L, -2, ++index);
+	}
+	return 1;
+}
+
+int GameFunctions::luaGameGetAllocationStats(lua_State* L) {
+	// Game.getAllocationStats()
+	if (!allocation_counter::isEnabled()) {
+		lua_pushnil(L);
+		return 1;
+	}
+
+	const auto totals = allocation_counter::tagTotals();
+	lua_createtable(L, 0, allocation_counter::TAGS);
+	for (size_t tag = 0; tag < allocation_counter::TAGS; ++tag) {
+		lua_createtable(L, 0, 2);
+		setField(L, "allocations", totals[tag].allocations);
+		setField(L, "bytes", totals[tag].bytes);
+		lua_setfield(L, -2, allocation_counter::tagNames[tag].data());
+	}
+	return 1;
+}
+
+int GameFunctions::luaGameGetConnectionStats(lua_State* L) {
+	// Game.getConnectionStats([count = 10[, sort = "sent"]])
+	static const phmap::flat_hash_map<std::string, ConnectionStatisticsSort> sorts {
+		{ "received", ConnectionStatisticsSort::BytesReceived },
+		{ "sent", ConnectionStatisticsSort::BytesSent },
+		{ "packetsin", ConnectionStatisticsSort::PacketsReceived },
+		{ "packetsout", ConnectionStatisticsSort::PacketsSent },
+		{ "queue", ConnectionStatisticsSort::QueueDepth },
+		{ "latency", ConnectionStatisticsSort::WriteLatency },
+	};
+
+	const auto count = getNumber<uint32_t>(L, 1, 10);
+	const auto sort = asLowerCaseString(getString(L, 2, "sent"));
+	const auto it = sorts.find(sort);
+	if (it == sorts.end()) {
+		reportErrorFunc(fmt::format("Unknown sort {}, expected received, sent, packetsin, packetsout, queue or latency.", sort));
+		lua_pushnil(L);
+		return 1;
+	}
+
+	const auto connections = ConnectionManager::getInstance().getTopConnections(count, it->second);
+	int index = 0;
+	lua_createtable(L, connections.size(), 0);
+	for (const auto &connection : connections) {
+		lua_createtable(L, 0, 11);
+		setField(L, "ip", convertIPToString(connection.ip));
+		setField(L, "protocol", std::string(connection.protocol));
+		setField(L, "age", connection.age);
+		setField(L, "bytesReceived", connection.bytesReceived);
+		setField(L, "bytesSent", connection.bytesSent);
+		setField(L, "packetsReceivedPerSecond", connection.packetsReceivedPerSecond);
+		setField(L, "packetsSentPerSecond", connection.packetsSentPerSecond);
+		setField(L, "queueDepth", connection.queueDepth);
+		setField(L, "maxQueueDepth", connection.maxQueueDepth);
+		setField(L, "writeLatency", connection.writeLatency);
+		setField(L, "compressionRatio", connection.compressionRatio);
+		lua_rawseti(L, -2, ++index);
+	}
+	return 1;
+}
+
+int GameFunctions::luaGameGetMemoryCensus(lua_State* L) {
+	// Game.getMemoryCensus()
+	const auto categories = g_memoryCensus().take();
+	int index = 0;
+	lua_createtable(L, categories.size(), 0);
+	for (const auto &category : categories) {
+		lua_createtable(L, 0, 3);
+		setField(L, "name", category.name);
+		setField(L, "objects", category.objects);
+		setField(L, "bytes", category.bytes);
+		lua_rawseti(L, -2, ++index);
+	}
+	return 1;
+}
+
+int GameFunctions::luaGameStartCombatTrace(lua_State* L) {
+	// Game.startCombatTrace(path)
+	pushBoolean(L, g_combatTrace().start(getString(L, 1)));
+	return 1;
+}
+
+int GameFunctions::luaGameStopCombatTrace(lua_State* L) {
+	// Game.stopCombatTrace()
+	pushBoolean(L, g_combatTrace().stop());
+	return 1;
+}
+
+int GameFunctions::luaGameReplayCombatTrace(lua_State* L) {
+	// Game.replayCombatTrace(path)
+	const auto report = g_combatTrace().replay(getString(L, 1));
+	if (!report) {
+		lua_pushnil(L);
+		return 1;
+	}
+
+	lua_createtable(L, 0, 8);
+	setField(L, "events", report->events);
+	setField(L, "tiles", report->tiles);
+	setField(L, "creatures", report->creatures);
+	setField(L, "spectators", report->spectators);
+	setField(L, "bytes", report->bytes);
+	setField(L, "recordedTime", report->recordedTime);
+	setField(L, "replayTime", report->replayTime);
+
+	int index = 0;
+	lua_createtable(L, report->phases.size(), 0);
+	for (const auto &phase : report->phases) {
+		lua_createtable(L, 0, 4);
+		setField(L, "name", std::string(phase.name));
+		setField(L, "totalTime", phase.totalTime);
+		setField(L, "p50Time", phase.p50Time);
+		setField(L, "p99Time", phase.p99Time);
+		lua_rawseti(L, -2, ++index);
+	}
+	lua_setfield(L, -2, "phases");
+	return 1;
+}
+
+int GameFunctions::luaGameStartLuaProfiler(lua_State* L) {
+	// Game.startLuaProfiler()
+	pushBoolean(L, g_luaProfiler().start());
+	return 1;
+}
+
+int GameFunctions::luaGameStopLuaProfiler(lua_State* L) {
+	// Game.stopLuaProfiler()
+	pushBoolean(L, g_luaProfiler().stop());
+	return 1;
+}
+
+int GameFunctions::luaGameGetLuaProfile(lua_State* L) {
+	// Game.getLuaProfile([count = 10[, byScript = false]])
+	const auto count = getNumber<uint32_t>(L, 1, 10);
+	const auto entries = g_luaProfiler().getTop(count, getBoolean(L, 2, false));
+	int index = 0;
+	lua_createtable(L, entries.size(), 0);
+	for (const auto &entry : entries) {
+		lua_createtable(L, 0, 5);
+		setField(L, "name", entry.name);
+		setField(L, "calls", entry.calls);
+		setField(L, "totalTime", entry.totalTime);
+		setField(L, "selfTime", entry.selfTime);
+		setField(L, "allocations", entry.allocations);
+		lua_rawseti(L, -2, ++index);
+	}
+	return 1;
+}
+
+int GameFunctions::luaGameDumpLuaProfile(lua_State* L) {
+	// Game.dumpLuaProfile(path)
+	pushBoolean(L, g_luaProfiler().dump(getString(L, 1)));
+	return 1;
+}
+
+int GameFunctions::luaGameRunWorkerJob(lua_State* L) {
+	// Game.runWorkerJob(source, input, callback(result, error))
+	if (!isString(L, 1) || !isFunction(L, 3)) {
+		reportErrorFunc("Expected the source of the job and a callback.");
+		pushBoolean(L, false);
+		return 1;
+	}
+
+	LuaWorkerValue input;
+	std::string error;
+	if (!LuaWorkers::read(L, 2, input, error)) {
+		reportErrorFunc(fmt::format("Invalid job input, {}.", error));
+		pushBoolean(L, false);
+		return 1;
+	}
+
+	lua_pushvalue(L, 3);
+	const int32_t callback = luaL_ref(L, LUA_REGISTRYINDEX);
+	if (!g_luaWorkers().submit(getString(L, 1), std::move(input), callback, getScriptEnv()->getScriptId())) {
+		luaL_unref(L, LUA_REGISTRYINDEX, callback);
+		pushBoolean(L, false);
+		return 1;
+	}
+
+	pushBoolean(L, true);
+	return 1;
+}
+
+int GameFunctions::luaGameGetGlobalEventStats(lua_State* L) {
+	// Game.getGlobalEventStats([count = 10])
+	const auto count = getNumber<size_t>(L, 1, 10);
+	auto stats = g_globalEvents().getStats();
+	if (stats.size() > count) {
+		stats.resize(count);
+	}
+
+	lua_createtable(L, static_cast<int>(stats.size()), 0);
+	int index = 0;
+	for (const auto &entry : stats) {
+		lua_createtable(L, 0, 6);
+		setField(L, "name", entry.name);
+		setField(L, "type", std::string(entry.type == GLOBALEVENT_TIMER ? "timer" : "think"));
+		setField(L, "interval", entry.interval);
+		setField(L, "calls", entry.calls);
+		setField(L, "totalTime", entry.totalTime);
+		setField(L, "maxTime", entry.maxTime);
+		lua_rawseti(L, -2, ++index);
+	}
+	return 1;
+}
+
+int GameFunctions::luaGameGetLuaMemory(lua_State* L) {
+	// Game.getLuaMemory([count = 10])
+	const auto count = getNumber<size_t>(L, 1, 10);
+	const auto stats = LuaMemory::getStats();
+	auto interfaces = g_luaMemory().getInterfaces();
+	if (interfaces.size() > count) {
+		interfaces.resize(count);
+	}
+
+	lua_createtable(L, 0, 9);
+	setField(L, "heapBytes", stats.heapBytes);
+	setField(L, "peakBytes", stats.peakBytes);
+	setField(L, "allocatedBytes", stats.allocatedBytes);
+	setField(L, "allocations", stats.allocations);
+	setField(L, "frees", stats.frees);
+	setField(L, "gcCycles", stats.gcCycles);
+	setField(L, "idleSteps", stats.idleSteps);
+	pushBoolean(L, stats.tracked);
+	lua_setfield(L, -2, "tracked");
+
+	lua_createtable(L, static_cast<int>(interfaces.size()), 0);
+	int index = 0;
+	for (const auto &entry : interfaces) {
+		lua_createtable(L, 0, 4);
+		setField(L, "name", entry.name);
+		setField(L, "calls", entry.calls);
+		setField(L, "allocatedBytes", entry.allocatedBytes);
+		setField(L, "allocations", entry.allocations);
+		lua_rawseti(L, -2, ++index);
+	}
+	lua_setfield(L, -2, "interfaces");
+	return 1;
+}
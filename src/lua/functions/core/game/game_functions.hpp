@@ -20,6 +20,7 @@ public:
 		registerMethod(L, "Game", "createMonsterType", GameFunctions::luaGameCreateMonsterType);
 
 		registerMethod(L, "Game", "getSpectators", GameFunctions::luaGameGetSpectators);
+		registerMethod(L, "Game", "iterateSpectators", GameFunctions::luaGameIterateSpectators);
 
 		registerMethod(L, "Game", "getBoostedCreature", GameFunctions::luaGameGetBoostedCreature);
 		registerMethod(L, "Game", "getBestiaryList", GameFunctions::luaGameGetBestiaryList);
@@ -66,6 +67,7 @@ public:
 		registerMethod(L, "Game", "hasDistanceEffect", GameFunctions::luaGameHasDistanceEffect);
 		registerMethod(L, "Game", "hasEffect", GameFunctions::luaGameHasEffect);
 		registerMethod(L, "Game", "getOfflinePlayer", GameFunctions::luaGameGetOfflinePlayer);
+		registerMethod(L, "Game", "removeOfflinePlayer", GameFunctions::luaGameRemoveOfflinePlayer);
 		registerMethod(L, "Game", "getNormalizedPlayerName", GameFunctions::luaGameGetNormalizedPlayerName);
 		registerMethod(L, "Game", "getNormalizedGuildName", GameFunctions::luaGameGetNormalizedGuildName);
 
@@ -89,6 +91,21 @@ public:
 		registerMethod(L, "Game", "getSecretAchievements", GameFunctions::luaGameGetSecretAchievements);
 		registerMethod(L, "Game", "getPublicAchievements", GameFunctions::luaGameGetPublicAchievements);
 		registerMethod(L, "Game", "getAchievements", GameFunctions::luaGameGetAchievements);
+
+		registerMethod(L, "Game", "getTaskProfile", GameFunctions::luaGameGetTaskProfile);
+		registerMethod(L, "Game", "getAllocationStats", GameFunctions::luaGameGetAllocationStats);
+		registerMethod(L, "Game", "getConnectionStats", GameFunctions::luaGameGetConnectionStats);
+		registerMethod(L, "Game", "getMemoryCensus", GameFunctions::luaGameGetMemoryCensus);
+		registerMethod(L, "Game", "startCombatTrace", GameFunctions::luaGameStartCombatTrace);
+		registerMethod(L, "Game", "stopCombatTrace", GameFunctions::luaGameStopCombatTrace);
+		registerMethod(L, "Game", "replayCombatTrace", GameFunctions::luaGameReplayCombatTrace);
+		registerMethod(L, "Game", "startLuaProfiler", GameFunctions::luaGameStartLuaProfiler);
+		registerMethod(L, "Game", "stopLuaProfiler", GameFunctions::luaGameStopLuaProfiler);
+		registerMethod(L, "Game", "getLuaProfile", GameFunctions::luaGameGetLuaProfile);
+		registerMethod(L, "Game", "dumpLuaProfile", GameFunctions::luaGameDumpLuaProfile);
+		registerMethod(L, "Game", "runWorkerJob", GameFunctions::luaGameRunWorkerJob);
+		registerMethod(L, "Game", "getGlobalEventStats", GameFunctions::luaGameGetGlobalEventStats);
+		registerMethod(L, "Game", "getLuaMemory", GameFunctions::luaGameGetLuaMemory);
 	}
 
 private:
@@ -96,6 +113,9 @@ private:
 	static int luaGameCreateNpcType(lua_State* L);
 
 	static int luaGameGetSpectators(lua_State* L);
+	static int luaGameIterateSpectators(lua_State* L);
+	static int luaGameSpectatorIteratorNext(lua_State* L);
+	static int luaGameSpectatorIteratorGc(lua_State* L);
 
 	static int luaGameGetBoostedCreature(lua_State* L);
 	static int luaGameGetBestiaryList(lua_State* L);
@@ -140,6 +160,7 @@ private:
 	static int luaGameReload(lua_State* L);
 
 	static int luaGameGetOfflinePlayer(lua_State* L);
+	static int luaGameRemoveOfflinePlayer(lua_State* L);
 	static int luaGameGetNormalizedPlayerName(lua_State* L);
 	static int luaGameGetNormalizedGuildName(lua_State* L);
 	static int luaGameHasEffect(lua_State* L);
@@ -166,4 +187,20 @@ private:
 	static int luaGameGetSecretAchievements(lua_State* L);
 	static int luaGameGetPublicAchievements(lua_State* L);
 	static int luaGameGetAchievements(lua_State* L);
+
+	static int luaGameGetTaskProfile(lua_State* L);
+	static int luaGameGetAllocationStats(lua_State* L);
+	static int luaGameGetConnectionStats(lua_State* L);
+	static int luaGameGetMemoryCensus(lua_State* L);
+
+	static int luaGameStartCombatTrace(lua_State* L);
+	static int luaGameStopCombatTrace(lua_State* L);
+	static int luaGameReplayCombatTrace(lua_State* L);
+	static int luaGameStartLuaProfiler(lua_State* L);
+	static int luaGameStopLuaProfiler(lua_State* L);
+	static int luaGameGetLuaProfile(lua_State* L);
+	static int luaGameDumpLuaProfile(lua_State* L);
+	static int luaGameRunWorkerJob(lua_State* L);
+	static int luaGameGetGlobalEventStats(lua_State* L);
+	static int luaGameGetLuaMemory(lua_State* L);
 };
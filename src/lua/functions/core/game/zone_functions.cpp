@@ -129,16 +129,27 @@ int ZoneFunctions::luaZoneGetCreatures(lua_State* L) {
 		pushBoolean(L, false);
 		return 1;
 	}
-	auto creatures = zone->getCreatures();
-	lua_createtable(L, static_cast<int>(creatures.size()), 0);
+	lua_createtable(L, static_cast<int>(zone->getCreatureCount()), 0);
 
 	int index = 0;
-	for (auto creature : creatures) {
+	zone->forEachCreature([&](const std::shared_ptr<Creature> &creature) {
 		index++;
 		pushUserdata<Creature>(L, creature);
 		setCreatureMetatable(L, -1, creature);
 		lua_rawseti(L, -2, index);
+	});
+	return 1;
+}
+
+int ZoneFunctions::luaZoneGetCreatureCount(lua_State* L) {
+	// Zone:getCreatureCount()
+	const auto zone = getUserdataShared<Zone>(L, 1);
+	if (!zone) {
+		reportErrorFunc(getErrorDesc(LUA_ERROR_ZONE_NOT_FOUND));
+		pushBoolean(L, false);
+		return 1;
 	}
+	lua_pushnumber(L, zone->getCreatureCount());
 	return 1;
 }
 
@@ -150,16 +161,27 @@ int ZoneFunctions::luaZoneGetPlayers(lua_State* L) {
 		pushBoolean(L, false);
 		return 1;
 	}
-	auto players = zone->getPlayers();
-	lua_createtable(L, static_cast<int>(players.size()), 0);
+	lua_createtable(L, static_cast<int>(zone->getPlayerCount()), 0);
 
 	int index = 0;
-	for (auto player : players) {
+	zone->forEachPlayer([&](const std::shared_ptr<Player> &player) {
 		index++;
 		pushUserdata<Player>(L, player);
 		setMetatable(L, -1, "Player");
 		lua_rawseti(L, -2, index);
+	});
+	return 1;
+}
+
+int ZoneFunctions::luaZoneGetPlayerCount(lua_State* L) {
+	// Zone:getPlayerCount()
+	const auto zone = getUserdataShared<Zone>(L, 1);
+	if (!zone) {
+		reportErrorFunc(getErrorDesc(LUA_ERROR_ZONE_NOT_FOUND));
+		pushBoolean(L, false);
+		return 1;
 	}
+	lua_pushnumber(L, zone->getPlayerCount());
 	return 1;
 }
 
@@ -171,16 +193,27 @@ int ZoneFunctions::luaZoneGetMonsters(lua_State* L) {
 		pushBoolean(L, false);
 		return 1;
 	}
-	auto monsters = zone->getMonsters();
-	lua_createtable(L, static_cast<int>(monsters.size()), 0);
+	lua_createtable(L, static_cast<int>(zone->getMonsterCount()), 0);
 
 	int index = 0;
-	for (auto monster : monsters) {
+	zone->forEachMonster([&](const std::shared_ptr<Monster> &monster) {
 		index++;
 		pushUserdata<Monster>(L, monster);
 		setMetatable(L, -1, "Monster");
 		lua_rawseti(L, -2, index);
+	});
+	return 1;
+}
+
+int ZoneFunctions::luaZoneGetMonsterCount(lua_State* L) {
+	// Zone:getMonsterCount()
+	const auto zone = getUserdataShared<Zone>(L, 1);
+	if (!zone) {
+		reportErrorFunc(getErrorDesc(LUA_ERROR_ZONE_NOT_FOUND));
+		pushBoolean(L, false);
+		return 1;
 	}
+	lua_pushnumber(L, zone->getMonsterCount());
 	return 1;
 }
 
@@ -192,16 +225,27 @@ int ZoneFunctions::luaZoneGetNpcs(lua_State* L) {
 		pushBoolean(L, false);
 		return 1;
 	}
-	auto npcs = zone->getNpcs();
-	lua_createtable(L, static_cast<int>(npcs.size()), 0);
+	lua_createtable(L, static_cast<int>(zone->getNpcCount()), 0);
 
 	int index = 0;
-	for (auto npc : npcs) {
+	zone->forEachNpc([&](const std::shared_ptr<Npc> &npc) {
 		index++;
 		pushUserdata<Npc>(L, npc);
 		setMetatable(L, -1, "Npc");
 		lua_rawseti(L, -2, index);
+	});
+	return 1;
+}
+
+int ZoneFunctions::luaZoneGetNpcCount(lua_State* L) {
+	// Zone:getNpcCount()
+	const auto zone = getUserdataShared<Zone>(L, 1);
+	if (!zone) {
+		reportErrorFunc(getErrorDesc(LUA_ERROR_ZONE_NOT_FOUND));
+		pushBoolean(L, false);
+		return 1;
 	}
+	lua_pushnumber(L, zone->getNpcCount());
 	return 1;
 }
 
@@ -213,16 +257,27 @@ int ZoneFunctions::luaZoneGetItems(lua_State* L) {
 		pushBoolean(L, false);
 		return 1;
 	}
-	auto items = zone->getItems();
-	lua_createtable(L, static_cast<int>(items.size()), 0);
+	lua_createtable(L, static_cast<int>(zone->getItemCount()), 0);
 
 	int index = 0;
-	for (auto item : items) {
+	zone->forEachItem([&](const std::shared_ptr<Item> &item) {
 		index++;
 		pushUserdata<Item>(L, item);
 		setMetatable(L, -1, "Item");
 		lua_rawseti(L, -2, index);
+	});
+	return 1;
+}
+
+int ZoneFunctions::luaZoneGetItemCount(lua_State* L) {
+	// Zone:getItemCount()
+	const auto zone = getUserdataShared<Zone>(L, 1);
+	if (!zone) {
+		reportErrorFunc(getErrorDesc(LUA_ERROR_ZONE_NOT_FOUND));
+		pushBoolean(L, false);
+		return 1;
 	}
+	lua_pushnumber(L, zone->getItemCount());
 	return 1;
 }
 
@@ -303,7 +358,7 @@ int ZoneFunctions::luaZoneGetByPosition(lua_State* L) {
 		return 1;
 	}
 	int index = 0;
-	auto zones = tile->getZones();
+	const auto &zones = tile->getZones();
 	lua_createtable(L, static_cast<int>(zones.size()), 0);
 	for (auto zone : zones) {
 		index++;
@@ -17,10 +17,15 @@ public:
 		registerMethod(L, "Zone", "setRemoveDestination", ZoneFunctions::luaZoneSetRemoveDestination);
 		registerMethod(L, "Zone", "getPositions", ZoneFunctions::luaZoneGetPositions);
 		registerMethod(L, "Zone", "getCreatures", ZoneFunctions::luaZoneGetCreatures);
+		registerMethod(L, "Zone", "getCreatureCount", ZoneFunctions::luaZoneGetCreatureCount);
 		registerMethod(L, "Zone", "getPlayers", ZoneFunctions::luaZoneGetPlayers);
+		registerMethod(L, "Zone", "getPlayerCount", ZoneFunctions::luaZoneGetPlayerCount);
 		registerMethod(L, "Zone", "getMonsters", ZoneFunctions::luaZoneGetMonsters);
+		registerMethod(L, "Zone", "getMonsterCount", ZoneFunctions::luaZoneGetMonsterCount);
 		registerMethod(L, "Zone", "getNpcs", ZoneFunctions::luaZoneGetNpcs);
+		registerMethod(L, "Zone", "getNpcCount", ZoneFunctions::luaZoneGetNpcCount);
 		registerMethod(L, "Zone", "getItems", ZoneFunctions::luaZoneGetItems);
+		registerMethod(L, "Zone", "getItemCount", ZoneFunctions::luaZoneGetItemCount);
 
 		registerMethod(L, "Zone", "removePlayers", ZoneFunctions::luaZoneRemovePlayers);
 		registerMethod(L, "Zone", "removeMonsters", ZoneFunctions::luaZoneRemoveMonsters);
@@ -47,10 +52,15 @@ private:
 	static int luaZoneRefresh(lua_State* L);
 	static int luaZoneGetPositions(lua_State* L);
 	static int luaZoneGetCreatures(lua_State* L);
+	static int luaZoneGetCreatureCount(lua_State* L);
 	static int luaZoneGetPlayers(lua_State* L);
+	static int luaZoneGetPlayerCount(lua_State* L);
 	static int luaZoneGetMonsters(lua_State* L);
+	static int luaZoneGetMonsterCount(lua_State* L);
 	static int luaZoneGetNpcs(lua_State* L);
+	static int luaZoneGetNpcCount(lua_State* L);
 	static int luaZoneGetItems(lua_State* L);
+	static int luaZoneGetItemCount(lua_State* L);
 
 	static int luaZoneRemovePlayers(lua_State* L);
 	static int luaZoneRemoveMonsters(lua_State* L);
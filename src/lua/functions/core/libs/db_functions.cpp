@@ -14,7 +14,27 @@
 #include "lua/functions/core/libs/db_functions.hpp"
 #include "lua/scripts/lua_environment.hpp"
 
+namespace {
+	// The origin of the caller followed by the script that runs the query, for the slow query log
+	std::string scriptOrigin(const ScriptEnvironment* env) {
+		if (!DBQueryOrigin::isNeeded()) {
+			return {};
+		}
+
+		int32_t scriptId;
+		int32_t callbackId;
+		bool timerEvent;
+		LuaScriptInterface* scriptInterface;
+		env->getEventInfo(scriptId, scriptInterface, callbackId, timerEvent);
+		if (!scriptInterface || scriptId == EVENT_ID_LOADING || scriptId == EVENT_ID_USER) {
+			return DBQueryOrigin::current();
+		}
+		return fmt::format("{} > {}", DBQueryOrigin::current(), scriptInterface->getFileById(scriptId));
+	}
+}
+
 int DBFunctions::luaDatabaseExecute(lua_State* L) {
+	DBQueryOrigin origin(scriptOrigin(getScriptEnv()));
 	pushBoolean(L, Database::getInstance().executeQuery(getString(L, -1)));
 	return 1;
 }
@@ -44,11 +64,13 @@ int DBFunctions::luaDatabaseAsyncExecute(lua_State* L) {
 			luaL_unref(luaState, LUA_REGISTRYINDEX, ref);
 		};
 	}
+	DBQueryOrigin origin(scriptOrigin(getScriptEnv()));
 	g_databaseTasks().execute(getString(L, -1), callback);
 	return 0;
 }
 
 int DBFunctions::luaDatabaseStoreQuery(lua_State* L) {
+	DBQueryOrigin origin(scriptOrigin(getScriptEnv()));
 	if (DBResult_ptr res = Database::getInstance().storeQuery(getString(L, -1))) {
 		lua_pushnumber(L, ScriptEnvironment::addResult(res));
 	} else {
@@ -86,6 +108,7 @@ int DBFunctions::luaDatabaseAsyncStoreQuery(lua_State* L) {
 			luaL_unref(luaState, LUA_REGISTRYINDEX, ref);
 		};
 	}
+	DBQueryOrigin origin(scriptOrigin(getScriptEnv()));
 	g_databaseTasks().store(getString(L, -1), callback);
 	return 0;
 }
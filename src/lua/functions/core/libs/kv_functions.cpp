@@ -93,6 +93,45 @@ int KVFunctions::luaKVRemove(lua_State* L) {
 	return 1;
 }
 
+int KVFunctions::luaKVIncrement(lua_State* L) {
+	// KV.increment(key[, delta = 1]) | scopedKV:increment(key[, delta = 1])
+	const int arg = isUserdata(L, 1) ? 2 : 1;
+	const auto key = getString(L, arg);
+	const auto delta = getNumber<int32_t>(L, arg + 1, 1);
+	if (arg == 2) {
+		lua_pushnumber(L, getUserdataShared<KV>(L, 1)->increment(key, delta));
+	} else {
+		lua_pushnumber(L, g_kv().increment(key, delta));
+	}
+	return 1;
+}
+
+int KVFunctions::luaKVUpdateMax(lua_State* L) {
+	// KV.updateMax(key, value) | scopedKV:updateMax(key, value)
+	const int arg = isUserdata(L, 1) ? 2 : 1;
+	const auto key = getString(L, arg);
+	const auto value = getNumber<int32_t>(L, arg + 1);
+	if (arg == 2) {
+		lua_pushnumber(L, getUserdataShared<KV>(L, 1)->updateMax(key, value));
+	} else {
+		lua_pushnumber(L, g_kv().updateMax(key, value));
+	}
+	return 1;
+}
+
+int KVFunctions::luaKVUpdateMin(lua_State* L) {
+	// KV.updateMin(key, value) | scopedKV:updateMin(key, value)
+	const int arg = isUserdata(L, 1) ? 2 : 1;
+	const auto key = getString(L, arg);
+	const auto value = getNumber<int32_t>(L, arg + 1);
+	if (arg == 2) {
+		lua_pushnumber(L, getUserdataShared<KV>(L, 1)->updateMin(key, value));
+	} else {
+		lua_pushnumber(L, g_kv().updateMin(key, value));
+	}
+	return 1;
+}
+
 int KVFunctions::luaKVKeys(lua_State* L) {
 	// KV.keys([prefix = ""]) | scopedKV:keys([prefix = ""])
 	std::unordered_set<std::string> keys;
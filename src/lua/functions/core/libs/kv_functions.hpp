@@ -34,6 +34,9 @@ public:
 		registerMethod(L, "kv", "get", KVFunctions::luaKVGet);
 		registerMethod(L, "kv", "keys", KVFunctions::luaKVKeys);
 		registerMethod(L, "kv", "remove", KVFunctions::luaKVRemove);
+		registerMethod(L, "kv", "increment", KVFunctions::luaKVIncrement);
+		registerMethod(L, "kv", "updateMax", KVFunctions::luaKVUpdateMax);
+		registerMethod(L, "kv", "updateMin", KVFunctions::luaKVUpdateMin);
 
 		registerClass(L, "KV", "");
 		registerMethod(L, "KV", "scoped", KVFunctions::luaKVScoped);
@@ -41,6 +44,9 @@ public:
 		registerMethod(L, "KV", "get", KVFunctions::luaKVGet);
 		registerMethod(L, "KV", "keys", KVFunctions::luaKVKeys);
 		registerMethod(L, "KV", "remove", KVFunctions::luaKVRemove);
+		registerMethod(L, "KV", "increment", KVFunctions::luaKVIncrement);
+		registerMethod(L, "KV", "updateMax", KVFunctions::luaKVUpdateMax);
+		registerMethod(L, "KV", "updateMin", KVFunctions::luaKVUpdateMin);
 	}
 
 private:
@@ -49,6 +55,9 @@ private:
 	static int luaKVGet(lua_State* L);
 	static int luaKVKeys(lua_State* L);
 	static int luaKVRemove(lua_State* L);
+	static int luaKVIncrement(lua_State* L);
+	static int luaKVUpdateMax(lua_State* L);
+	static int luaKVUpdateMin(lua_State* L);
 
 	static std::optional<ValueWrapper> getValueWrapper(lua_State* L);
 	static void pushStringValue(lua_State* L, const std::string &value);
@@ -121,6 +121,7 @@ int SpellFunctions::luaSpellRegister(lua_State* L) {
 		return 1;
 	}
 
+	g_scripts().requireFullReload();
 	if (spell->spellType == SPELL_INSTANT) {
 		const auto spellBase = getUserdataShared<Spell>(L, 1);
 		const auto instant = std::static_pointer_cast<InstantSpell>(spellBase);
@@ -1014,6 +1014,17 @@ int MonsterTypeFunctions::luaMonsterTypeAddLoot(lua_State* L) {
 	return 1;
 }
 
+int MonsterTypeFunctions::luaMonsterTypeGetLootRevision(lua_State* L) {
+	// monsterType:getLootRevision()
+	const auto monsterType = getUserdataShared<MonsterType>(L, 1);
+	if (monsterType) {
+		lua_pushnumber(L, monsterType->getLootRevision());
+	} else {
+		lua_pushnil(L);
+	}
+	return 1;
+}
+
 int MonsterTypeFunctions::luaMonsterTypeGetCreatureEvents(lua_State* L) {
 	// monsterType:getCreatureEvents()
 	const auto monsterType = getUserdataShared<MonsterType>(L, 1);
@@ -88,6 +88,7 @@ public:
 
 		registerMethod(L, "MonsterType", "getLoot", MonsterTypeFunctions::luaMonsterTypeGetLoot);
 		registerMethod(L, "MonsterType", "addLoot", MonsterTypeFunctions::luaMonsterTypeAddLoot);
+		registerMethod(L, "MonsterType", "getLootRevision", MonsterTypeFunctions::luaMonsterTypeGetLootRevision);
 
 		registerMethod(L, "MonsterType", "getCreatureEvents", MonsterTypeFunctions::luaMonsterTypeGetCreatureEvents);
 		registerMethod(L, "MonsterType", "registerEvent", MonsterTypeFunctions::luaMonsterTypeRegisterEvent);
@@ -220,6 +221,7 @@ private:
 
 	static int luaMonsterTypeGetLoot(lua_State* L);
 	static int luaMonsterTypeAddLoot(lua_State* L);
+	static int luaMonsterTypeGetLootRevision(lua_State* L);
 
 	static int luaMonsterTypeGetCreatureEvents(lua_State* L);
 	static int luaMonsterTypeRegisterEvent(lua_State* L);
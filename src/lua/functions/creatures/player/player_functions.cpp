@@ -1760,6 +1760,71 @@ int PlayerFunctions::luaPlayerSetStorageValue(lua_State* L) {
 	return 1;
 }
 
+int PlayerFunctions::luaPlayerGetStorageValues(lua_State* L) {
+	// player:getStorageValues({key, ...})
+	const auto player = getUserdataShared<Player>(L, 1);
+	if (!player) {
+		lua_pushnil(L);
+		return 1;
+	}
+
+	if (!isTable(L, 2)) {
+		reportErrorFunc("Expected a table of storage keys");
+		lua_pushnil(L);
+		return 1;
+	}
+
+	// {[key] = value, ...}, -1 for the keys that are not set
+	const auto count = static_cast<int>(lua_objlen(L, 2));
+	lua_createtable(L, 0, count);
+	for (int i = 1; i <= count; ++i) {
+		lua_rawgeti(L, 2, i);
+		if (!isNumber(L, -1)) {
+			lua_pop(L, 1);
+			continue;
+		}
+
+		lua_pushnumber(L, player->getStorageValue(getNumber<uint32_t>(L, -1)));
+		lua_rawset(L, -3);
+	}
+	return 1;
+}
+
+int PlayerFunctions::luaPlayerSetStorageValues(lua_State* L) {
+	// player:setStorageValues({[key] = value, ...})
+	const auto player = getUserdataShared<Player>(L, 1);
+	if (!player) {
+		lua_pushnil(L);
+		return 1;
+	}
+
+	if (!isTable(L, 2)) {
+		reportErrorFunc("Expected a table of storage keys and values");
+		pushBoolean(L, false);
+		return 1;
+	}
+
+	bool allSet = true;
+	lua_pushnil(L);
+	while (lua_next(L, 2) != 0) {
+		// Number keys only, lua_next breaks if the key is converted
+		const uint32_t key = isNumber(L, -2) ? getNumber<uint32_t>(L, -2) : 0;
+		if (key == 0 || !isNumber(L, -1)) {
+			reportErrorFunc("Storage key or value is not a number");
+			allSet = false;
+		} else if (IS_IN_KEYRANGE(key, RESERVED_RANGE)) {
+			reportErrorFunc(fmt::format("Accessing reserved range: {}", key));
+			allSet = false;
+		} else {
+			player->addStorageValue(key, getNumber<int32_t>(L, -1));
+		}
+		lua_pop(L, 1);
+	}
+
+	pushBoolean(L, allSet);
+	return 1;
+}
+
 int PlayerFunctions::luaPlayerGetStorageValueByName(lua_State* L) {
 	// player:getStorageValueByName(name)
 	std::shared_ptr<Player> player = getUserdataShared<Player>(L, 1);
@@ -3037,16 +3102,16 @@ int PlayerFunctions::luaPlayerSetGhostMode(lua_State* L) {
 	}
 
 	if (player->isInGhostMode()) {
-		for (const auto &it : g_game().getPlayers()) {
-			if (!it.second->isAccessPlayer()) {
-				it.second->vip()->notifyStatusChange(player, VipStatus_t::Offline);
+		for (const auto &watcher : g_game().getVipWatchers(player->getGUID())) {
+			if (!watcher->isAccessPlayer()) {
+				watcher->vip()->notifyStatusChange(player, VipStatus_t::Offline);
 			}
 		}
 		IOLoginData::updateOnlineStatus(player->getGUID(), false);
 	} else {
-		for (const auto &it : g_game().getPlayers()) {
-			if (!it.second->isAccessPlayer()) {
-				it.second->vip()->notifyStatusChange(player, player->vip()->getStatus());
+		for (const auto &watcher : g_game().getVipWatchers(player->getGUID())) {
+			if (!watcher->isAccessPlayer()) {
+				watcher->vip()->notifyStatusChange(player, player->vip()->getStatus());
 			}
 		}
 		IOLoginData::updateOnlineStatus(player->getGUID(), true);
@@ -170,6 +170,8 @@ private:
 
 		registerMethod(L, "Player", "getStorageValue", PlayerFunctions::luaPlayerGetStorageValue);
 		registerMethod(L, "Player", "setStorageValue", PlayerFunctions::luaPlayerSetStorageValue);
+		registerMethod(L, "Player", "getStorageValues", PlayerFunctions::luaPlayerGetStorageValues);
+		registerMethod(L, "Player", "setStorageValues", PlayerFunctions::luaPlayerSetStorageValues);
 
 		registerMethod(L, "Player", "getStorageValueByName", PlayerFunctions::luaPlayerGetStorageValueByName);
 		registerMethod(L, "Player", "setStorageValueByName", PlayerFunctions::luaPlayerSetStorageValueByName);
@@ -538,6 +540,8 @@ private:
 
 	static int luaPlayerGetStorageValue(lua_State* L);
 	static int luaPlayerSetStorageValue(lua_State* L);
+	static int luaPlayerGetStorageValues(lua_State* L);
+	static int luaPlayerSetStorageValues(lua_State* L);
 	static int luaPlayerGetStorageValueByName(lua_State* L);
 	static int luaPlayerSetStorageValueByName(lua_State* L);
 
@@ -89,6 +89,7 @@ int EventCallbackFunctions::luaEventCallbackRegister(lua_State* luaState) {
 		return 0;
 	}
 
+	g_scripts().requireFullReload();
 	if (g_callbacks().isCallbackRegistered(callback)) {
 		reportErrorFunc(fmt::format("EventCallback is duplicated for event with name: {}", callback->getName()));
 		return 0;
@@ -92,6 +92,7 @@ int WeaponFunctions::luaWeaponRegister(lua_State* L) {
 	// weapon:register()
 	WeaponShared_ptr* weaponPtr = getRawUserDataShared<Weapon>(L, 1);
 	if (weaponPtr && *weaponPtr) {
+		g_scripts().requireFullReload();
 		WeaponShared_ptr weapon = *weaponPtr;
 		if (weapon->weaponType == WEAPON_DISTANCE || weapon->weaponType == WEAPON_AMMO || weapon->weaponType == WEAPON_MISSILE) {
 			weapon = getUserdataShared<WeaponDistance>(L, 1);
@@ -31,6 +31,42 @@
 
 class LuaScriptInterface;
 
+namespace {
+	// Registry keys looked up by address, instead of interning a name each time
+	const char userdataCacheKey = 0;
+
+	enum CachedMetatable : uint8_t {
+		METATABLE_ITEM,
+		METATABLE_CONTAINER,
+		METATABLE_TELEPORT,
+		METATABLE_PLAYER,
+		METATABLE_MONSTER,
+		METATABLE_NPC,
+		METATABLE_COUNT,
+	};
+
+	constexpr std::array<const char*, METATABLE_COUNT> cachedMetatableNames = { "Item", "Container", "Teleport", "Player", "Monster", "Npc" };
+	const std::array<char, METATABLE_COUNT> cachedMetatableKeys {};
+
+	// Pushes the metatable of the class, the registry keeps it by address after the first lookup of its name
+	void pushCachedMetatable(lua_State* L, CachedMetatable metatable) {
+		auto key = const_cast<char*>(&cachedMetatableKeys[metatable]);
+		lua_pushlightuserdata(L, key);
+		lua_rawget(L, LUA_REGISTRYINDEX);
+		if (!lua_isnil(L, -1)) {
+			return;
+		}
+
+		lua_pop(L, 1);
+		luaL_getmetatable(L, cachedMetatableNames[metatable]);
+		if (!lua_isnil(L, -1)) {
+			lua_pushlightuserdata(L, key);
+			lua_pushvalue(L, -2);
+			lua_rawset(L, LUA_REGISTRYINDEX);
+		}
+	}
+}
+
 void LuaFunctionsLoader::load(lua_State* L) {
 	if (!L) {
 		g_game().dieSafely("Invalid lua state, cannot load lua functions.");
@@ -269,7 +305,7 @@ void LuaFunctionsLoader::setMetatable(lua_State* L, int32_t index, const std::st
 	}
 
 	luaL_getmetatable(L, name.c_str());
-	lua_setmetatable(L, index - 1);
+	applyMetatable(L, index - 1);
 }
 
 void LuaFunctionsLoader::setWeakMetatable(lua_State* L, int32_t index, const std::string &name) {
@@ -307,7 +343,7 @@ void LuaFunctionsLoader::setWeakMetatable(lua_State* L, int32_t index, const std
 	} else {
 		luaL_getmetatable(L, weakName.c_str());
 	}
-	lua_setmetatable(L, index - 1);
+	applyMetatable(L, index - 1);
 }
 
 void LuaFunctionsLoader::setItemMetatable(lua_State* L, int32_t index, std::shared_ptr<Item> item) {
@@ -316,13 +352,13 @@ void LuaFunctionsLoader::setItemMetatable(lua_State* L, int32_t index, std::shar
 	}
 
 	if (item && item->getContainer()) {
-		luaL_getmetatable(L, "Container");
+		pushCachedMetatable(L, METATABLE_CONTAINER);
 	} else if (item && item->getTeleport()) {
-		luaL_getmetatable(L, "Teleport");
+		pushCachedMetatable(L, METATABLE_TELEPORT);
 	} else {
-		luaL_getmetatable(L, "Item");
+		pushCachedMetatable(L, METATABLE_ITEM);
 	}
-	lua_setmetatable(L, index - 1);
+	applyMetatable(L, index - 1);
 }
 
 void LuaFunctionsLoader::setCreatureMetatable(lua_State* L, int32_t index, std::shared_ptr<Creature> creature) {
@@ -331,13 +367,13 @@ void LuaFunctionsLoader::setCreatureMetatable(lua_State* L, int32_t index, std::
 	}
 
 	if (creature && creature->getPlayer()) {
-		luaL_getmetatable(L, "Player");
+		pushCachedMetatable(L, METATABLE_PLAYER);
 	} else if (creature && creature->getMonster()) {
-		luaL_getmetatable(L, "Monster");
+		pushCachedMetatable(L, METATABLE_MONSTER);
 	} else {
-		luaL_getmetatable(L, "Npc");
+		pushCachedMetatable(L, METATABLE_NPC);
 	}
-	lua_setmetatable(L, index - 1);
+	applyMetatable(L, index - 1);
 }
 
 CombatDamage LuaFunctionsLoader::getCombatDamage(lua_State* L) {
@@ -788,6 +824,75 @@ int LuaFunctionsLoader::luaGarbageCollection(lua_State* L) {
 	return 0;
 }
 
+bool LuaFunctionsLoader::pushCachedUserdata(lua_State* L, const void* object) {
+	lua_pushlightuserdata(L, const_cast<char*>(&userdataCacheKey));
+	lua_rawget(L, LUA_REGISTRYINDEX);
+	if (!lua_istable(L, -1)) {
+		lua_pop(L, 1);
+		return false;
+	}
+
+	lua_pushlightuserdata(L, const_cast<void*>(object));
+	lua_rawget(L, -2);
+	lua_remove(L, -2);
+	if (!lua_isuserdata(L, -1)) {
+		lua_pop(L, 1);
+		return false;
+	}
+	return true;
+}
+
+void LuaFunctionsLoader::cacheUserdata(lua_State* L, const void* object) {
+	lua_pushlightuserdata(L, const_cast<char*>(&userdataCacheKey));
+	lua_rawget(L, LUA_REGISTRYINDEX);
+	if (!lua_istable(L, -1)) {
+		// The values are weak, an entry goes away with its userdata (before its __gc releases the object)
+		lua_pop(L, 1);
+		lua_newtable(L);
+		lua_createtable(L, 0, 1);
+		lua_pushliteral(L, "v");
+		lua_setfield(L, -2, "__mode");
+		lua_setmetatable(L, -2);
+		lua_pushlightuserdata(L, const_cast<char*>(&userdataCacheKey));
+		lua_pushvalue(L, -2);
+		lua_rawset(L, LUA_REGISTRYINDEX);
+	}
+
+	lua_pushlightuserdata(L, const_cast<void*>(object));
+	lua_pushvalue(L, -3);
+	lua_rawset(L, -3);
+	lua_pop(L, 1);
+}
+
+void LuaFunctionsLoader::applyMetatable(lua_State* L, int32_t index) {
+	if (index < 0) {
+		index = lua_gettop(L) + index + 1;
+	}
+
+	if (!lua_getmetatable(L, index)) {
+		lua_setmetatable(L, index);
+		return;
+	}
+
+	const bool sameMetatable = lua_rawequal(L, -1, -2);
+	lua_pop(L, 1);
+	if (sameMetatable) {
+		lua_pop(L, 1);
+		return;
+	}
+	if (lua_type(L, index) != LUA_TUSERDATA) {
+		lua_setmetatable(L, index);
+		return;
+	}
+
+	auto cached = static_cast<std::shared_ptr<SharedObject>*>(lua_touserdata(L, index));
+	auto userData = static_cast<std::shared_ptr<SharedObject>*>(lua_newuserdata(L, sizeof(std::shared_ptr<SharedObject>)));
+	new (userData) std::shared_ptr<SharedObject>(*cached);
+	lua_insert(L, -2);
+	lua_setmetatable(L, -2);
+	lua_replace(L, index);
+}
+
 int LuaFunctionsLoader::validateDispatcherContext(std::string_view fncName) {
 	if (g_dispatcher().context().isOn() && g_dispatcher().context().isAsync()) {
 		g_logger().warn("[{}] The call to lua was ignored because the '{}' task is trying to communicate while in async mode.", fncName, g_dispatcher().context().getName());
@@ -222,10 +222,24 @@ public:
 
 	template <class T>
 	static void pushUserdata(lua_State* L, std::shared_ptr<T> value) {
+		// The same object reuses its userdata while Lua holds it, unless a script deleted it meanwhile.
+		// A pointer nobody else owns (wrapped just for the call) is never cached
+		const bool cacheable = value && value.use_count() > 1;
+		if (cacheable && pushCachedUserdata(L, value.get())) {
+			const auto &cached = *static_cast<std::shared_ptr<T>*>(lua_touserdata(L, -1));
+			if (cached.get() == value.get() && !cached.owner_before(value) && !value.owner_before(cached)) {
+				return;
+			}
+			lua_pop(L, 1);
+		}
+
 		// This is basically malloc from C++ point of view.
 		auto userData = static_cast<std::shared_ptr<T>*>(lua_newuserdata(L, sizeof(std::shared_ptr<T>)));
 		// Copy constructor, bumps ref count.
 		new (userData) std::shared_ptr<T>(value);
+		if (cacheable) {
+			cacheUserdata(L, value.get());
+		}
 	}
 
 protected:
@@ -244,6 +258,21 @@ protected:
 	static int luaUserdataCompare(lua_State* L);
 	static int luaGarbageCollection(lua_State* L);
 
+	/**
+	 * The userdata of the shared objects are kept in a weak table of the registry, by address,
+	 * so pushing an object Lua still holds does not allocate a new userdata (and garbage) per call.
+	 * @return true with the cached userdata of object on the stack, false with the stack untouched.
+	 */
+	static bool pushCachedUserdata(lua_State* L, const void* object);
+	// Caches the userdata on the top of the stack as the one of object
+	static void cacheUserdata(lua_State* L, const void* object);
+	/**
+	 * Sets the metatable on the top of the stack (popping it) to the userdata at index.
+	 * A cached userdata that already has another one (a player pushed once as a Creature
+	 * and then as a Player) keeps it, index is replaced by a new userdata of the same object.
+	 */
+	static void applyMetatable(lua_State* L, int32_t index);
+
 	static ScriptEnvironment scriptEnv[16];
 	static int32_t scriptEnvIndex;
 	static int validateDispatcherContext(std::string_view fncName);
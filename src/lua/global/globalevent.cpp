@@ -13,6 +13,7 @@
 #include "utils/tools.hpp"
 #include "game/game.hpp"
 #include "game/scheduling/dispatcher.hpp"
+#include "config/configmanager.hpp"
 
 GlobalEvents::GlobalEvents() = default;
 GlobalEvents::~GlobalEvents() = default;
@@ -30,6 +31,25 @@ void GlobalEvents::clear() {
 	timerMap.clear();
 }
 
+void GlobalEvents::clearFile(uint32_t fileId) {
+	const auto fromFile = [fileId](const auto &entry) {
+		return entry.second->getFileId() == fileId;
+	};
+	std::erase_if(thinkMap, fromFile);
+	std::erase_if(serverMap, fromFile);
+	std::erase_if(timerMap, fromFile);
+
+	// Nothing left to run, the next registration schedules them again
+	if (thinkMap.empty()) {
+		g_dispatcher().stopEvent(thinkEventId);
+		thinkEventId = 0;
+	}
+	if (timerMap.empty()) {
+		g_dispatcher().stopEvent(timerEventId);
+		timerEventId = 0;
+	}
+}
+
 bool GlobalEvents::registerLuaEvent(const std::shared_ptr<GlobalEvent> globalEvent) {
 	if (globalEvent->getEventType() == GLOBALEVENT_TIMER) {
 		auto result = timerMap.emplace(globalEvent->getName(), globalEvent);
@@ -49,6 +69,7 @@ bool GlobalEvents::registerLuaEvent(const std::shared_ptr<GlobalEvent> globalEve
 	} else { // think event
 		auto result = thinkMap.emplace(globalEvent->getName(), globalEvent);
 		if (result.second) {
+			globalEvent->setNextExecution(getNextSlot(OTSYS_TIME(), globalEvent->getInterval()));
 			if (thinkEventId == 0) {
 				thinkEventId = g_dispatcher().scheduleEvent(
 					SCHEDULER_MINTICKS, [this] { think(); }, "GlobalEvents::think"
@@ -93,7 +114,7 @@ void GlobalEvents::timer() {
 			continue;
 		}
 
-		if (!globalEvent->executeEvent()) {
+		if (!run(globalEvent)) {
 			it = timerMap.erase(it);
 			continue;
 		}
@@ -116,42 +137,87 @@ void GlobalEvents::timer() {
 }
 
 void GlobalEvents::think() {
-	int64_t now = OTSYS_TIME();
+	const int64_t now = OTSYS_TIME();
 
 	int64_t nextScheduledTime = std::numeric_limits<int64_t>::max();
 	for (const auto &[globalEventName, globalEvent] : thinkMap) {
-		int64_t nextExecutionTime = globalEvent->getNextExecution() - now;
-		if (nextExecutionTime > 0) {
-			if (nextExecutionTime < nextScheduledTime) {
-				nextScheduledTime = nextExecutionTime;
-			}
-			continue;
-		}
-
-		g_logger().trace("[GlobalEvents::think] - Executing event: {}", globalEvent->getName());
+		if (globalEvent->getNextExecution() <= now) {
+			g_logger().trace("[GlobalEvents::think] - Executing event: {}", globalEvent->getName());
 
-		if (!globalEvent->executeEvent()) {
-			g_logger().error("[GlobalEvents::think] - "
-			                 "Failed to execute event: {}",
-			                 globalEvent->getName());
-		}
+			if (!run(globalEvent)) {
+				g_logger().error("[GlobalEvents::think] - "
+				                 "Failed to execute event: {}",
+				                 globalEvent->getName());
+			}
 
-		nextExecutionTime = globalEvent->getInterval();
-		if (nextExecutionTime < nextScheduledTime) {
-			nextScheduledTime = nextExecutionTime;
+			// A late run skips the slots it missed instead of running them back to back
+			int64_t nextExecution = globalEvent->getNextExecution() + globalEvent->getInterval();
+			if (nextExecution <= now) {
+				nextExecution = getNextSlot(now, globalEvent->getInterval());
+			}
+			globalEvent->setNextExecution(nextExecution);
 		}
 
-		globalEvent->setNextExecution(globalEvent->getNextExecution() + nextExecutionTime);
+		nextScheduledTime = std::min(nextScheduledTime, globalEvent->getNextExecution() - now);
 	}
 
 	if (nextScheduledTime != std::numeric_limits<int64_t>::max()) {
-		auto delay = static_cast<uint32_t>(nextScheduledTime);
+		auto delay = static_cast<uint32_t>(std::max<int64_t>(1, nextScheduledTime));
 		thinkEventId = g_dispatcher().scheduleEvent(
 			delay, [this] { think(); }, "GlobalEvents::think"
 		);
 	}
 }
 
+int64_t GlobalEvents::getNextSlot(int64_t now, uint32_t interval) {
+	if (interval == 0) {
+		return now + SCHEDULER_MINTICKS;
+	}
+	return (now / interval + 1) * interval;
+}
+
+bool GlobalEvents::run(const std::shared_ptr<GlobalEvent> &globalEvent) {
+	const auto start = std::chrono::steady_clock::now();
+	const bool result = globalEvent->executeEvent();
+	const auto elapsed = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count());
+
+	++globalEvent->calls;
+	globalEvent->totalTime += elapsed;
+	globalEvent->maxTime = std::max(globalEvent->maxTime, elapsed);
+
+	const auto budget = g_configManager().getNumber(GLOBAL_EVENT_BUDGET, __FUNCTION__);
+	if (budget > 0 && elapsed > static_cast<uint64_t>(budget) * 1000) {
+		// Once a minute per event, a slow think event would flood the log otherwise
+		const auto now = OTSYS_TIME();
+		if (now - globalEvent->lastBudgetWarning >= 60 * 1000) {
+			globalEvent->lastBudgetWarning = now;
+			g_logger().warn("[GlobalEvents::run] - Event {} took {} ms, over the budget of {} ms", globalEvent->getName(), elapsed / 1000, budget);
+		}
+	}
+	return result;
+}
+
+std::vector<GlobalEventStats> GlobalEvents::getStats() const {
+	std::vector<GlobalEventStats> stats;
+	stats.reserve(thinkMap.size() + timerMap.size());
+	for (const auto* map : { &thinkMap, &timerMap }) {
+		for (const auto &[name, globalEvent] : *map) {
+			auto &entry = stats.emplace_back();
+			entry.name = name;
+			entry.type = globalEvent->getEventType();
+			entry.interval = globalEvent->getInterval();
+			entry.calls = globalEvent->calls;
+			entry.totalTime = globalEvent->totalTime;
+			entry.maxTime = globalEvent->maxTime;
+		}
+	}
+
+	std::ranges::sort(stats, [](const auto &lhs, const auto &rhs) {
+		return lhs.totalTime > rhs.totalTime;
+	});
+	return stats;
+}
+
 void GlobalEvents::execute(GlobalEvent_t type) const {
 	for (const auto &[globalEventName, globalEvent] : serverMap) {
 		if (globalEvent->getEventType() == type) {
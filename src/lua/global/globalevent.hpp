@@ -15,6 +15,16 @@
 class GlobalEvent;
 using GlobalEventMap = std::map<std::string, std::shared_ptr<GlobalEvent>>;
 
+struct GlobalEventStats {
+	std::string name;
+	GlobalEvent_t type = GLOBALEVENT_NONE;
+	uint32_t interval = 0;
+	uint64_t calls = 0;
+	// microseconds
+	uint64_t totalTime = 0;
+	uint64_t maxTime = 0;
+};
+
 class GlobalEvents final : public Scripts {
 public:
 	GlobalEvents();
@@ -38,10 +48,22 @@ public:
 
 	GlobalEventMap getEventMap(GlobalEvent_t type);
 
+	/**
+	 * @return the cost of the think and timer events, the most expensive first.
+	 */
+	std::vector<GlobalEventStats> getStats() const;
+
 	bool registerLuaEvent(const std::shared_ptr<GlobalEvent> globalEvent);
 	void clear();
+	// Drops what the script file registered, for an incremental reload
+	void clearFile(uint32_t fileId);
 
 private:
+	// Think events run on the multiples of their interval, the events of an interval (and of its divisors) share one dispatcher task
+	static int64_t getNextSlot(int64_t now, uint32_t interval);
+	// Executes a think or timer event, keeping its cost and warning when it goes over globalEventBudget
+	static bool run(const std::shared_ptr<GlobalEvent> &globalEvent);
+
 	GlobalEventMap thinkMap, serverMap, timerMap;
 	uint64_t thinkEventId = 0, timerEventId = 0;
 };
@@ -84,6 +106,8 @@ public:
 	}
 
 private:
+	friend class GlobalEvents;
+
 	GlobalEvent_t eventType = GLOBALEVENT_NONE;
 
 	std::string getScriptTypeName() const override;
@@ -91,4 +115,10 @@ private:
 	std::string name;
 	int64_t nextExecution = 0;
 	uint32_t interval = 0;
+
+	uint64_t calls = 0;
+	// microseconds
+	uint64_t totalTime = 0;
+	uint64_t maxTime = 0;
+	int64_t lastBudgetWarning = 0;
 };
@@ -23,6 +23,7 @@ void Modules::clear(bool) {
 	for (auto &it : recvbyteList) {
 		it.second.clearEvent();
 	}
+	rebuildRecvbyteTable();
 
 	// clear lua state
 	scriptInterface.reInitState();
@@ -54,6 +55,7 @@ bool Modules::registerEvent(Event_ptr event, const pugi::xml_node &) {
 	if (oldModule) {
 		if (!oldModule->isLoaded() && oldModule->getEventType() == module->getEventType()) {
 			oldModule->copyEvent(module.get());
+			rebuildRecvbyteTable();
 		}
 		return false;
 	} else {
@@ -63,10 +65,20 @@ bool Modules::registerEvent(Event_ptr event, const pugi::xml_node &) {
 		} else {
 			recvbyteList.emplace(module->getRecvbyte(), std::move(*module));
 		}
+		rebuildRecvbyteTable();
 		return true;
 	}
 }
 
+void Modules::rebuildRecvbyteTable() {
+	recvbyteTable.fill(nullptr);
+	for (auto &[recvbyte, module] : recvbyteList) {
+		if (module.getEventType() == MODULE_TYPE_RECVBYTE && module.isLoaded()) {
+			recvbyteTable[recvbyte] = &module;
+		}
+	}
+}
+
 Module* Modules::getEventByRecvbyte(uint8_t recvbyte, bool force) {
 	ModulesList::iterator it = recvbyteList.find(recvbyte);
 	if (it != recvbyteList.end()) {
@@ -77,20 +89,14 @@ Module* Modules::getEventByRecvbyte(uint8_t recvbyte, bool force) {
 	return nullptr;
 }
 
-void Modules::executeOnRecvbyte(uint32_t playerId, NetworkMessage &msg, uint8_t byte) const {
-	std::shared_ptr<Player> player = g_game().getPlayerByID(playerId);
-	if (!player) {
+void Modules::executeOnRecvbyte(const std::shared_ptr<Player> &player, NetworkMessage &msg, uint8_t byte) const {
+	Module* module = recvbyteTable[byte];
+	if (!module || !player || !player->canRunModule(byte)) {
 		return;
 	}
 
-	for (auto &it : recvbyteList) {
-		Module module = it.second;
-		if (module.getEventType() == MODULE_TYPE_RECVBYTE && module.getRecvbyte() == byte && player->canRunModule(module.getRecvbyte())) {
-			player->setModuleDelay(module.getRecvbyte(), module.getDelay());
-			module.executeOnRecvbyte(player, msg);
-			return;
-		}
-	}
+	player->setModuleDelay(byte, module->getDelay());
+	module->executeOnRecvbyte(player, msg);
 }
 
 Module::Module(LuaScriptInterface* interface) :
@@ -168,7 +174,8 @@ void Module::executeOnRecvbyte(std::shared_ptr<Player> player, NetworkMessage &m
 	LuaScriptInterface::pushUserdata<Player>(L, player);
 	LuaScriptInterface::setMetatable(L, -1, "Player");
 
-	LuaScriptInterface::pushUserdata<NetworkMessage>(L, std::shared_ptr<NetworkMessage>(&msg));
+	// A view of the message being parsed, it is not copied and the pointer does not own it
+	LuaScriptInterface::pushUserdata<NetworkMessage>(L, std::shared_ptr<NetworkMessage>(std::shared_ptr<NetworkMessage>(), &msg));
 	LuaScriptInterface::setWeakMetatable(L, -1, "NetworkMessage");
 
 	lua_pushnumber(L, recvbyte);
@@ -67,7 +67,12 @@ public:
 		return inject<Modules>();
 	}
 
-	void executeOnRecvbyte(uint32_t playerId, NetworkMessage &msg, uint8_t byte) const;
+	// One array check for the opcodes without a module, the packets of walking and turning included
+	bool hasRecvbyte(uint8_t byte) const {
+		return recvbyteTable[byte] != nullptr;
+	}
+
+	void executeOnRecvbyte(const std::shared_ptr<Player> &player, NetworkMessage &msg, uint8_t byte) const;
 	Module* getEventByRecvbyte(uint8_t recvbyte, bool force);
 
 protected:
@@ -77,8 +82,12 @@ protected:
 	bool registerEvent(Event_ptr event, const pugi::xml_node &node) override;
 	void clear(bool) override final;
 
+	// The loaded recvbyte module of every opcode, rebuilt when the list changes
+	void rebuildRecvbyteTable();
+
 	typedef std::map<uint8_t, Module> ModulesList;
 	ModulesList recvbyteList;
+	std::array<Module*, 256> recvbyteTable {};
 
 	LuaScriptInterface scriptInterface;
 };
@@ -11,6 +11,7 @@
 
 #include "declarations.hpp"
 #include "lua/scripts/lua_environment.hpp"
+#include "lua/scripts/lua_memory.hpp"
 #include "lua/functions/lua_functions_loader.hpp"
 #include "lua/scripts/script_environment.hpp"
 #include "lua/global/lua_timer_event_descr.hpp"
@@ -43,8 +44,9 @@ lua_State* LuaEnvironment::getLuaState() {
 }
 
 bool LuaEnvironment::initState() {
-	luaState = luaL_newstate();
+	luaState = LuaMemory::newState();
 	LuaFunctionsLoader::load(luaState);
+	LuaMemory::configure();
 	runningEventId = EVENT_ID_USER;
 
 	return true;
@@ -82,7 +84,7 @@ bool LuaEnvironment::closeState() {
 	timerEvents.clear();
 	cacheFiles.clear();
 
-	lua_close(luaState);
+	LuaMemory::closeState(luaState);
 	luaState = nullptr;
 	return true;
 }
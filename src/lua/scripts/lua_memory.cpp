@@ -0,0 +1,232 @@
+/**
+ * Canary - A free and open-source MMORPG server emulator
+ * Copyright (©) 2019-2024 OpenTibiaBR <opentibiabr@outlook.com>
+ * Repository: https://github.com/opentibiabr/canary
+ * License: https://github.com/opentibiabr/canary/blob/main/LICENSE
+ * Contributors: https://github.com/opentibiabr/canary/graphs/contributors
+ * Website: https://docs.opentibiabr.com/
+ */
+
+#include "pch.hpp"
+
+#include "lua/scripts/lua_memory.hpp"
+#include "config/configmanager.hpp"
+#include "lib/metrics/metrics.hpp"
+#include "lib/di/container.hpp"
+
+namespace {
+	constexpr const char* SENTINEL_METATABLE = "LuaMemorySentinel";
+	constexpr int64_t REPORT_INTERVAL = 1000;
+}
+
+LuaMemory &LuaMemory::getInstance() {
+	return inject<LuaMemory>();
+}
+
+lua_State* LuaMemory::newState() {
+	heap = {};
+	lua_State* L = lua_newstate(allocate, nullptr);
+	if (L) {
+		heap.tracked = true;
+	} else {
+		// LuaJIT only takes an allocator of its own on 64 bits builds with GC64
+		g_logger().warn("[{}] - The Lua build does not accept a custom allocator, only the heap size and the collector cycles are accounted", __FUNCTION__);
+		L = luaL_newstate();
+	}
+
+	heap.state = L;
+	if (L) {
+		pushSentinel(L);
+	}
+	return L;
+}
+
+void LuaMemory::closeState(lua_State* L) {
+	// The sentinel is finalized with everything else, it must not make a new one
+	heap.closing = true;
+	lua_close(L);
+	heap = {};
+}
+
+void LuaMemory::configure() {
+	lua_State* L = heap.state;
+	if (!L) {
+		return;
+	}
+
+	const auto pause = g_configManager().getNumber(LUA_GC_PAUSE, __FUNCTION__);
+	const auto stepMultiplier = g_configManager().getNumber(LUA_GC_STEP_MULTIPLIER, __FUNCTION__);
+#ifdef LUA_GCGEN
+	if (g_configManager().getBoolean(LUA_GC_GENERATIONAL, __FUNCTION__)) {
+		lua_gc(L, LUA_GCGEN, 0, 0);
+		return;
+	}
+	lua_gc(L, LUA_GCINC, pause, stepMultiplier, 0);
+#else
+	if (g_configManager().getBoolean(LUA_GC_GENERATIONAL, __FUNCTION__)) {
+		g_logger().warn("[{}] - The Lua build has no generational collector, using the incremental one", __FUNCTION__);
+	}
+	lua_gc(L, LUA_GCSETPAUSE, pause);
+	lua_gc(L, LUA_GCSETSTEPMUL, stepMultiplier);
+#endif
+}
+
+void* LuaMemory::allocate(void*, void* ptr, size_t osize, size_t nsize) {
+	// Without a block, osize is the type of the new object in Lua 5.4
+	const size_t oldSize = ptr ? osize : 0;
+	if (nsize == 0) {
+		if (ptr) {
+			std::free(ptr);
+			heap.heapBytes -= oldSize;
+			++heap.frees;
+		}
+		return nullptr;
+	}
+
+	void* block = std::realloc(ptr, nsize);
+	if (!block) {
+		return nullptr;
+	}
+
+	if (!ptr) {
+		++heap.allocations;
+	}
+	if (nsize > oldSize) {
+		heap.allocatedBytes += nsize - oldSize;
+	}
+	heap.heapBytes = heap.heapBytes - oldSize + nsize;
+	heap.peakBytes = std::max(heap.peakBytes, heap.heapBytes);
+	return block;
+}
+
+void LuaMemory::pushSentinel(lua_State* L) {
+	// Garbage from the start, its finalizer runs once per collector cycle and leaves the next one
+	lua_newuserdata(L, 1);
+	if (luaL_newmetatable(L, SENTINEL_METATABLE) != 0) {
+		lua_pushcfunction(L, LuaMemory::onCollect);
+		lua_setfield(L, -2, "__gc");
+	}
+	lua_setmetatable(L, -2);
+	lua_pop(L, 1);
+}
+
+int LuaMemory::onCollect(lua_State* L) {
+	if (heap.closing) {
+		return 0;
+	}
+
+	++heap.gcCycles;
+	heap.idleBaseline = getHeapBytes();
+	pushSentinel(L);
+	return 0;
+}
+
+uint64_t LuaMemory::getHeapBytes() {
+	if (heap.tracked || !heap.state) {
+		return heap.heapBytes;
+	}
+	return static_cast<uint64_t>(lua_gc(heap.state, LUA_GCCOUNT, 0)) * 1024 + lua_gc(heap.state, LUA_GCCOUNTB, 0);
+}
+
+void LuaMemory::account(const std::string &interfaceName, uint64_t allocatedBefore, uint64_t allocationsBefore) {
+	auto it = interfaces.find(interfaceName);
+	if (it == interfaces.end()) {
+		it = interfaces.emplace(interfaceName, LuaInterfaceMemory {}).first;
+		it->second.name = interfaceName;
+	}
+
+	auto &entry = it->second;
+	++entry.calls;
+	// The state was recreated during the call (a reload)
+	if (heap.allocatedBytes >= allocatedBefore && heap.allocations >= allocationsBefore) {
+		entry.allocatedBytes += heap.allocatedBytes - allocatedBefore;
+		entry.allocations += heap.allocations - allocationsBefore;
+	}
+}
+
+void LuaMemory::idle(std::chrono::milliseconds available) {
+	report();
+
+	lua_State* L = heap.state;
+	const auto idleTime = std::chrono::milliseconds(g_configManager().getNumber(LUA_GC_IDLE_TIME, __FUNCTION__));
+	if (!L || idleTime.count() <= 0 || available < std::chrono::milliseconds(1)) {
+		return;
+	}
+
+	const auto heapBytes = getHeapBytes();
+	if (!heap.idleCollecting) {
+		// The automatic cycle starts at pause% of the heap left by the last one, start half way there
+		const auto pause = std::max<int64_t>(100, g_configManager().getNumber(LUA_GC_PAUSE, __FUNCTION__));
+		const auto threshold = heap.idleBaseline + heap.idleBaseline * static_cast<uint64_t>(pause - 100) / 200;
+		if (heapBytes < threshold) {
+			return;
+		}
+		heap.idleCollecting = true;
+	}
+
+	const auto deadline = std::chrono::steady_clock::now() + std::min(idleTime, available / 2);
+	do {
+		++heap.idleSteps;
+		if (lua_gc(L, LUA_GCSTEP, 0) != 0) {
+			heap.idleCollecting = false;
+			break;
+		}
+	} while (std::chrono::steady_clock::now() < deadline);
+}
+
+void LuaMemory::report() {
+	const auto now = OTSYS_TIME();
+	if (now - reported.time < REPORT_INTERVAL) {
+		return;
+	}
+	reported.time = now;
+
+	static const auto heapCounter = g_metrics().registerCounter("lua_heap_bytes", true);
+	static const auto cyclesCounter = g_metrics().registerCounter("lua_gc_cycles");
+
+	const auto heapBytes = getHeapBytes();
+	if (heapBytes != reported.heapBytes) {
+		g_metrics().addCounter(heapCounter, static_cast<double>(heapBytes) - static_cast<double>(reported.heapBytes));
+		reported.heapBytes = heapBytes;
+	}
+
+	if (heap.gcCycles != reported.gcCycles) {
+		// A new state starts the count again
+		g_metrics().addCounter(cyclesCounter, static_cast<double>(heap.gcCycles > reported.gcCycles ? heap.gcCycles - reported.gcCycles : heap.gcCycles));
+		reported.gcCycles = heap.gcCycles;
+	}
+
+	for (const auto &[name, entry] : interfaces) {
+		auto &last = reported.interfaces[name];
+		if (entry.allocatedBytes != last) {
+			g_metrics().addCounter("lua_allocated_bytes", static_cast<double>(entry.allocatedBytes - last), { { "interface", name } });
+			last = entry.allocatedBytes;
+		}
+	}
+}
+
+LuaMemoryStats LuaMemory::getStats() {
+	LuaMemoryStats stats;
+	stats.tracked = heap.tracked;
+	stats.heapBytes = getHeapBytes();
+	stats.peakBytes = heap.peakBytes;
+	stats.allocatedBytes = heap.allocatedBytes;
+	stats.allocations = heap.allocations;
+	stats.frees = heap.frees;
+	stats.gcCycles = heap.gcCycles;
+	stats.idleSteps = heap.idleSteps;
+	return stats;
+}
+
+std::vector<LuaInterfaceMemory> LuaMemory::getInterfaces() const {
+	std::vector<LuaInterfaceMemory> entries;
+	entries.reserve(interfaces.size());
+	for (const auto &[name, entry] : interfaces) {
+		entries.emplace_back(entry);
+	}
+
+	std::ranges::sort(entries, [](const auto &lhs, const auto &rhs) {
+		return lhs.allocatedBytes > rhs.allocatedBytes;
+	});
+	return entries;
+}
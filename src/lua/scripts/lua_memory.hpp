@@ -0,0 +1,118 @@
+/**
+ * Canary - A free and open-source MMORPG server emulator
+ * Copyright (©) 2019-2024 OpenTibiaBR <opentibiabr@outlook.com>
+ * Repository: https://github.com/opentibiabr/canary
+ * License: https://github.com/opentibiabr/canary/blob/main/LICENSE
+ * Contributors: https://github.com/opentibiabr/canary/graphs/contributors
+ * Website: https://docs.opentibiabr.com/
+ */
+
+#pragma once
+
+struct LuaMemoryStats {
+	// false if the Lua build did not take the accounting allocator, only heapBytes and gcCycles are known then
+	bool tracked = false;
+	uint64_t heapBytes = 0;
+	uint64_t peakBytes = 0;
+	// Since the state was created
+	uint64_t allocatedBytes = 0;
+	uint64_t allocations = 0;
+	uint64_t frees = 0;
+	uint64_t gcCycles = 0;
+	// Collector steps run while the dispatcher had nothing to do
+	uint64_t idleSteps = 0;
+};
+
+struct LuaInterfaceMemory {
+	std::string name;
+	uint64_t calls = 0;
+	// Allocated during the calls of the server into the scripts of the interface, nested calls included
+	uint64_t allocatedBytes = 0;
+	uint64_t allocations = 0;
+};
+
+/**
+ * Accounts the memory of the Lua state of the scripts: an allocator that counts the bytes and blocks,
+ * a finalizer that counts the collector cycles, and the allocations of each LuaScriptInterface
+ * (scripts, npcs, monsters, modules...), that all share the state, measured around their calls.
+ * It also sets the collector parameters of the config and runs collector steps
+ * while the dispatcher is idle, so the collector does less work in the middle of the tasks.
+ */
+class LuaMemory {
+public:
+	LuaMemory() = default;
+
+	// Singleton - ensures we don't accidentally copy it
+	LuaMemory(const LuaMemory &) = delete;
+	void operator=(const LuaMemory &) = delete;
+
+	static LuaMemory &getInstance();
+
+	// A state with the accounting allocator, or a plain one if the Lua build does not accept it
+	static lua_State* newState();
+	static void closeState(lua_State* L);
+
+	// Sets the collector parameters of the config on the state, again after a config reload
+	static void configure();
+
+	static uint64_t getAllocatedBytes() {
+		return heap.allocatedBytes;
+	}
+
+	static uint64_t getAllocations() {
+		return heap.allocations;
+	}
+
+	// After a call of interface into the state, with the counters from before it
+	void account(const std::string &interfaceName, uint64_t allocatedBefore, uint64_t allocationsBefore);
+
+	/**
+	 * Called by the dispatcher thread when it has no tasks, available is the time until the next scheduled one.
+	 * Runs collector steps for up to luaGarbageCollectorIdleTime and reports the metrics.
+	 */
+	void idle(std::chrono::milliseconds available);
+
+	static LuaMemoryStats getStats();
+	// By allocated bytes
+	std::vector<LuaInterfaceMemory> getInterfaces() const;
+
+private:
+	// Plain values, the state can be closed when the singletons are being destroyed
+	struct Heap {
+		lua_State* state = nullptr;
+		bool tracked = false;
+		bool closing = false;
+		uint64_t heapBytes = 0;
+		uint64_t peakBytes = 0;
+		uint64_t allocatedBytes = 0;
+		uint64_t allocations = 0;
+		uint64_t frees = 0;
+		uint64_t gcCycles = 0;
+		uint64_t idleSteps = 0;
+		// The heap when the last cycle ended, the idle steps start half way to the automatic threshold
+		uint64_t idleBaseline = 0;
+		bool idleCollecting = false;
+	};
+
+	struct Reported {
+		uint64_t heapBytes = 0;
+		uint64_t gcCycles = 0;
+		phmap::flat_hash_map<std::string, uint64_t> interfaces;
+		int64_t time = 0;
+	};
+
+	static void* allocate(void* ud, void* ptr, size_t osize, size_t nsize);
+	static void pushSentinel(lua_State* L);
+	static int onCollect(lua_State* L);
+	static uint64_t getHeapBytes();
+
+	void report();
+
+	// Only the dispatcher runs scripts
+	inline static Heap heap;
+
+	phmap::flat_hash_map<std::string, LuaInterfaceMemory> interfaces;
+	Reported reported;
+};
+
+constexpr auto g_luaMemory = LuaMemory::getInstance;
@@ -0,0 +1,279 @@
+/**
+ * Canary - A free and open-source MMORPG server emulator
+ * Copyright (©) 2019-2024 OpenTibiaBR <opentibiabr@outlook.com>
+ * Repository: https://github.com/opentibiabr/canary
+ * License: https://github.com/opentibiabr/canary/blob/main/LICENSE
+ * Contributors: https://github.com/opentibiabr/canary/graphs/contributors
+ * Website: https://docs.opentibiabr.com/
+ */
+
+#include "pch.hpp"
+
+#include "lua/scripts/lua_profiler.hpp"
+#include "lua/scripts/lua_environment.hpp"
+#include "lib/di/container.hpp"
+
+namespace {
+	// The file of a chunk, from the data folder on like the metrics scopes
+	std::string_view getScript(const char* source) {
+		if (!source || *source != '@') {
+			return "[string]";
+		}
+
+		std::string_view script(source + 1);
+		if (const auto pos = script.find("data"); pos != std::string_view::npos) {
+			script.remove_prefix(pos);
+		}
+		return script;
+	}
+
+	// The script of a root scope, "file:event"
+	std::string_view getScopeScript(std::string_view scope) {
+		const auto pos = scope.rfind(':');
+		return pos == std::string_view::npos ? scope : scope.substr(0, pos);
+	}
+}
+
+LuaProfiler &LuaProfiler::getInstance() {
+	return inject<LuaProfiler>();
+}
+
+bool LuaProfiler::start() {
+	if (running) {
+		return false;
+	}
+
+	mainState = g_luaEnvironment().getLuaState();
+	if (!mainState) {
+		return false;
+	}
+
+	functions.clear();
+	functionIds.clear();
+	frames.clear();
+	roots.clear();
+	path.clear();
+	stacks.clear();
+
+	lua_sethook(mainState, hook, LUA_MASKCALL | LUA_MASKRET, 0);
+#ifdef LUAJIT_VERSION
+	luaJIT_setmode(mainState, 0, LUAJIT_MODE_ENGINE | LUAJIT_MODE_FLUSH);
+	luaJIT_setmode(mainState, 0, LUAJIT_MODE_ENGINE | LUAJIT_MODE_OFF);
+#endif
+	running = true;
+	g_logger().info("Started the Lua profiler");
+	return true;
+}
+
+bool LuaProfiler::stop() {
+	if (!running) {
+		return false;
+	}
+
+	// The calls that are running are closed now, the script that stops it included
+	while (!frames.empty()) {
+		pop();
+	}
+	roots.clear();
+
+	lua_sethook(mainState, nullptr, 0, 0);
+#ifdef LUAJIT_VERSION
+	luaJIT_setmode(mainState, 0, LUAJIT_MODE_ENGINE | LUAJIT_MODE_ON);
+#endif
+	running = false;
+	g_logger().info("Stopped the Lua profiler, {} functions were profiled", functions.size());
+	return true;
+}
+
+void LuaProfiler::enter(lua_State* L, std::string_view scope) {
+	if (!running || L != mainState) {
+		return;
+	}
+
+	roots.emplace_back(frames.size());
+	nameBuffer.assign(scope);
+	push(getFunction(nameBuffer, getScopeScript(scope)), getDepth(L));
+}
+
+void LuaProfiler::leave(lua_State* L) {
+	if (!running || L != mainState || roots.empty()) {
+		return;
+	}
+
+	const auto root = roots.back();
+	while (frames.size() > root) {
+		pop();
+	}
+	roots.pop_back();
+}
+
+void LuaProfiler::hook(lua_State* L, lua_Debug* ar) {
+	auto &profiler = getInstance();
+	if (L != profiler.mainState || profiler.roots.empty()) {
+		return;
+	}
+
+	const auto depth = getDepth(L);
+	// Whatever is still open at this level returned without telling (a tail call or an error caught by pcall)
+	profiler.unwind(depth);
+	if (ar->event != LUA_HOOKCALL || !lua_getinfo(L, "Sn", ar)) {
+		return;
+	}
+
+	auto &name = profiler.nameBuffer;
+	name.clear();
+	std::string_view script;
+	if (*ar->what == 'C') {
+		script = "[C]";
+		fmt::format_to(std::back_inserter(name), "[C] {}", ar->name ? ar->name : "?");
+	} else {
+		script = getScript(ar->source);
+		fmt::format_to(std::back_inserter(name), "{}:{} {}", script, ar->linedefined, ar->name ? ar->name : "?");
+	}
+	profiler.push(profiler.getFunction(name, script), depth);
+}
+
+int32_t LuaProfiler::getDepth(lua_State* L) {
+	lua_Debug ar;
+	if (!lua_getstack(L, 0, &ar)) {
+		return 0;
+	}
+
+	// The deepest level that exists, doubling and then halving instead of walking every level
+	int32_t low = 0;
+	int32_t high = 1;
+	while (lua_getstack(L, high, &ar)) {
+		low = high;
+		high *= 2;
+	}
+	while (high - low > 1) {
+		const int32_t middle = low + (high - low) / 2;
+		if (lua_getstack(L, middle, &ar)) {
+			low = middle;
+		} else {
+			high = middle;
+		}
+	}
+	return low + 1;
+}
+
+int64_t LuaProfiler::getTime() {
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+int64_t LuaProfiler::getMemory() const {
+	return static_cast<int64_t>(lua_gc(mainState, LUA_GCCOUNT, 0)) * 1024 + lua_gc(mainState, LUA_GCCOUNTB, 0);
+}
+
+uint32_t LuaProfiler::getFunction(const std::string &name, std::string_view script) {
+	if (auto it = functionIds.find(name); it != functionIds.end()) {
+		return it->second;
+	}
+
+	const auto id = static_cast<uint32_t>(functions.size());
+	auto &function = functions.emplace_back();
+	function.name = name;
+	function.script = script;
+	functionIds.emplace(name, id);
+	return id;
+}
+
+void LuaProfiler::push(uint32_t function, int32_t depth) {
+	Frame frame;
+	frame.function = function;
+	frame.depth = depth;
+	frame.pathLength = path.size();
+	if (!path.empty()) {
+		path += ';';
+	}
+	path += functions[function].name;
+	frame.startMemory = getMemory();
+	frame.startTime = getTime();
+	frames.emplace_back(frame);
+}
+
+void LuaProfiler::pop() {
+	const auto frame = frames.back();
+	frames.pop_back();
+
+	const auto elapsed = getTime() - frame.startTime;
+	const auto allocated = std::max<int64_t>(0, getMemory() - frame.startMemory);
+	const auto selfTime = static_cast<uint64_t>(std::max<int64_t>(0, elapsed - frame.childTime));
+
+	auto &function = functions[frame.function];
+	++function.calls;
+	function.totalTime += static_cast<uint64_t>(elapsed);
+	function.selfTime += selfTime;
+	function.allocations += static_cast<uint64_t>(std::max<int64_t>(0, allocated - frame.childAllocations));
+
+	if (auto it = stacks.find(path); it != stacks.end()) {
+		it->second += selfTime;
+	} else {
+		stacks.emplace(path, selfTime);
+	}
+	path.resize(frame.pathLength);
+
+	if (!frames.empty()) {
+		frames.back().childTime += elapsed;
+		frames.back().childAllocations += allocated;
+	}
+}
+
+void LuaProfiler::unwind(int32_t depth) {
+	const auto root = roots.back();
+	while (frames.size() > root + 1 && frames.back().depth >= depth) {
+		pop();
+	}
+}
+
+std::vector<LuaProfileEntry> LuaProfiler::getTop(size_t count, bool byScript) const {
+	std::vector<LuaProfileEntry> entries;
+	phmap::flat_hash_map<std::string_view, size_t> scripts;
+	for (const auto &function : functions) {
+		LuaProfileEntry* entry;
+		if (byScript) {
+			auto [it, inserted] = scripts.try_emplace(function.script, entries.size());
+			if (inserted) {
+				entries.emplace_back().name = function.script;
+			}
+			entry = &entries[it->second];
+		} else {
+			entry = &entries.emplace_back();
+			entry->name = function.name;
+		}
+
+		entry->calls += function.calls;
+		entry->totalTime += function.totalTime;
+		entry->selfTime += function.selfTime;
+		entry->allocations += function.allocations;
+	}
+
+	std::ranges::sort(entries, [](const auto &lhs, const auto &rhs) {
+		return lhs.selfTime > rhs.selfTime;
+	});
+	if (entries.size() > count) {
+		entries.resize(count);
+	}
+
+	for (auto &entry : entries) {
+		entry.totalTime /= 1000;
+		entry.selfTime /= 1000;
+	}
+	return entries;
+}
+
+bool LuaProfiler::dump(const std::string &dumpPath) const {
+	std::ofstream file(dumpPath, std::ios::trunc);
+	if (!file) {
+		g_logger().error("[{}] - Failed to create the Lua profile {}", __FUNCTION__, dumpPath);
+		return false;
+	}
+
+	for (const auto &[stack, time] : stacks) {
+		if (time >= 1000) {
+			file << stack << ' ' << time / 1000 << '\n';
+		}
+	}
+	g_logger().info("Saved the Lua profile to {}", dumpPath);
+	return file.good();
+}
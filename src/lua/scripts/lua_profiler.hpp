@@ -0,0 +1,120 @@
+/**
+ * Canary - A free and open-source MMORPG server emulator
+ * Copyright (©) 2019-2024 OpenTibiaBR <opentibiabr@outlook.com>
+ * Repository: https://github.com/opentibiabr/canary
+ * License: https://github.com/opentibiabr/canary/blob/main/LICENSE
+ * Contributors: https://github.com/opentibiabr/canary/graphs/contributors
+ * Website: https://docs.opentibiabr.com/
+ */
+
+#pragma once
+
+struct LuaProfileEntry {
+	// The function (file:line name) or, per script, the file
+	std::string name;
+	uint64_t calls = 0;
+	// microseconds
+	uint64_t totalTime = 0;
+	uint64_t selfTime = 0;
+	// bytes the Lua heap grew by
+	uint64_t allocations = 0;
+};
+
+/**
+ * Profiles the Lua functions the scripts run, with a call and return hook on the Lua state:
+ * calls, total and self time and the growth of the Lua heap of every function and script,
+ * and the self time of every stack, written as collapsed stacks for a flamegraph.
+ * The calls of the server into the scripts (LuaScriptInterface::callFunction) are the roots of the stacks,
+ * frames the hook could not close (errors, tail calls) are closed when their root returns.
+ * The JIT compiler is off while it runs, compiled code does not call the hook.
+ * Coroutines are not followed, their time is the one of the function that resumed them.
+ */
+class LuaProfiler {
+public:
+	LuaProfiler() = default;
+
+	// Singleton - ensures we don't accidentally copy it
+	LuaProfiler(const LuaProfiler &) = delete;
+	void operator=(const LuaProfiler &) = delete;
+
+	static LuaProfiler &getInstance();
+
+	static bool isRunning() {
+		return running;
+	}
+
+	/**
+	 * Starts profiling the Lua state of the scripts, discarding the previous results.
+	 * @return false if it is already running.
+	 */
+	bool start();
+	/**
+	 * Stops profiling, the results are kept until the next start.
+	 * @return false if it was not running.
+	 */
+	bool stop();
+
+	// Around every call of the server into the scripts, scope names the root of the stacks
+	void enter(lua_State* L, std::string_view scope);
+	void leave(lua_State* L);
+
+	/**
+	 * @return the functions (or scripts) with the highest self time.
+	 */
+	std::vector<LuaProfileEntry> getTop(size_t count, bool byScript) const;
+
+	/**
+	 * Writes the self time of every stack, in microseconds, as "root;function;function time" lines.
+	 * @return false if the file could not be written.
+	 */
+	bool dump(const std::string &path) const;
+
+private:
+	struct Function {
+		std::string name;
+		std::string script;
+		uint64_t calls = 0;
+		// nanoseconds
+		uint64_t totalTime = 0;
+		uint64_t selfTime = 0;
+		uint64_t allocations = 0;
+	};
+
+	struct Frame {
+		uint32_t function = 0;
+		// Levels of the Lua stack, the frames at or above the level of a call or return are done
+		int32_t depth = 0;
+		size_t pathLength = 0;
+		int64_t startTime = 0;
+		int64_t childTime = 0;
+		int64_t startMemory = 0;
+		int64_t childAllocations = 0;
+	};
+
+	static void hook(lua_State* L, lua_Debug* ar);
+	static int32_t getDepth(lua_State* L);
+	static int64_t getTime();
+	int64_t getMemory() const;
+
+	uint32_t getFunction(const std::string &name, std::string_view script);
+	void push(uint32_t function, int32_t depth);
+	void pop();
+	// Pops the frames of the current root at or above depth
+	void unwind(int32_t depth);
+
+	// Only the dispatcher runs scripts
+	inline static bool running = false;
+
+	lua_State* mainState = nullptr;
+	std::vector<Function> functions;
+	phmap::flat_hash_map<std::string, uint32_t> functionIds;
+	std::vector<Frame> frames;
+	// The first frame of each nested call of the server into the scripts
+	std::vector<size_t> roots;
+	std::string path;
+	// nanoseconds
+	phmap::flat_hash_map<std::string, uint64_t> stacks;
+	std::string nameBuffer;
+};
+
+constexpr auto g_luaProfiler = LuaProfiler::getInstance;
@@ -0,0 +1,287 @@
+/**
+ * Canary - A free and open-source MMORPG server emulator
+ * Copyright (©) 2019-2024 OpenTibiaBR <opentibiabr@outlook.com>
+ * Repository: https://github.com/opentibiabr/canary
+ * License: https://github.com/opentibiabr/canary/blob/main/LICENSE
+ * Contributors: https://github.com/opentibiabr/canary/graphs/contributors
+ * Website: https://docs.opentibiabr.com/
+ */
+
+#include "pch.hpp"
+
+#include "lua/scripts/lua_workers.hpp"
+#include "lua/scripts/lua_environment.hpp"
+#include "lua/scripts/script_environment.hpp"
+#include "config/configmanager.hpp"
+#include "game/memory_census.hpp"
+#include "game/scheduling/dispatcher.hpp"
+#include "lib/thread/thread_pool.hpp"
+#include "lib/di/container.hpp"
+
+namespace {
+	std::string popError(lua_State* L) {
+		const char* message = lua_tostring(L, -1);
+		std::string error = message ? message : "unknown error";
+		lua_pop(L, 1);
+		return error;
+	}
+
+	// Instructions the job of the calling thread can still run
+	thread_local int64_t remainingInstructions = 0;
+}
+
+LuaWorkers::~LuaWorkers() {
+	for (const auto &worker : workers) {
+		lua_close(worker->L);
+	}
+}
+
+LuaWorkers &LuaWorkers::getInstance() {
+	return inject<LuaWorkers>();
+}
+
+void LuaWorkers::start(ThreadPool &pool) {
+	const auto count = std::max<int32_t>(0, g_configManager().getNumber(LUA_WORKER_STATES, __FUNCTION__));
+	instructionLimit = std::max<int32_t>(0, g_configManager().getNumber(LUA_WORKER_INSTRUCTION_LIMIT, __FUNCTION__));
+	for (int32_t i = 0; i < count; ++i) {
+		lua_State* L = newState(instructionLimit > 0);
+		if (!L) {
+			g_logger().error("[{}] - Failed to create a Lua worker state, the worker jobs are disabled", __FUNCTION__);
+			for (const auto &worker : workers) {
+				lua_close(worker->L);
+			}
+			workers.clear();
+			return;
+		}
+
+		auto &worker = workers.emplace_back(std::make_unique<Worker>());
+		worker->L = L;
+		worker->heapBytes = getHeapBytes(L);
+	}
+
+	if (workers.empty()) {
+		return;
+	}
+
+	pool.setLaneThreads(ThreadLane::Lua, static_cast<uint16_t>(workers.size()));
+	threadPool = &pool;
+	g_logger().info("Started {} Lua worker states", workers.size());
+}
+
+bool LuaWorkers::submit(std::string source, LuaWorkerValue input, int32_t callback, int32_t scriptId) {
+	if (!threadPool) {
+		return false;
+	}
+
+	lua_State* globalState = g_luaEnvironment().getLuaState();
+	threadPool->detachTask(ThreadLane::Lua, [this, globalState, callback, scriptId, source = std::move(source), input = std::move(input)] {
+		auto &worker = getWorker();
+		LuaWorkerValue result;
+		std::string error;
+		if (!run(worker, source, input, result, error) && error.empty()) {
+			error = "the job failed";
+		}
+		worker.heapBytes.store(getHeapBytes(worker.L), std::memory_order_relaxed);
+
+		g_dispatcher().addEvent(
+			[globalState, callback, scriptId, result = std::move(result), error = std::move(error)] {
+				complete(globalState, callback, scriptId, result, error);
+			},
+			"LuaWorkers::complete"
+		);
+	});
+	return true;
+}
+
+LuaWorkers::Worker &LuaWorkers::getWorker() {
+	// The lane has as many threads as there are states, so no two threads share one
+	thread_local Worker* worker = nullptr;
+	if (!worker) {
+		worker = workers[nextWorker.fetch_add(1, std::memory_order_relaxed) % workers.size()].get();
+	}
+	return *worker;
+}
+
+lua_State* LuaWorkers::newState(bool limited) {
+	lua_State* L = luaL_newstate();
+	if (!L) {
+		return nullptr;
+	}
+
+	// Only what computing needs: no io, os, package or debug, and no jit, so the state is interpreted and the count hook always fires
+	const std::pair<const char*, lua_CFunction> libraries[] = { { "", luaopen_base }, { LUA_STRLIBNAME, luaopen_string }, { LUA_TABLIBNAME, luaopen_table }, { LUA_MATHLIBNAME, luaopen_math } };
+	for (const auto &[name, open] : libraries) {
+		lua_pushcfunction(L, open);
+		lua_pushstring(L, name);
+		lua_call(L, 1, 0);
+	}
+
+	// The base library can still read files
+	for (const auto* name : { "dofile", "loadfile" }) {
+		lua_pushnil(L);
+		lua_setglobal(L, name);
+	}
+
+	if (limited) {
+		lua_sethook(L, limitHook, LUA_MASKCOUNT, HOOK_INSTRUCTIONS);
+	}
+	return L;
+}
+
+void LuaWorkers::limitHook(lua_State* L, lua_Debug* /*debug*/) {
+	remainingInstructions -= HOOK_INSTRUCTIONS;
+	if (remainingInstructions < 0) {
+		luaL_error(L, "the job ran more than luaWorkerInstructionLimit instructions");
+	}
+}
+
+void LuaWorkers::countMemory(MemoryCensus &census) const {
+	for (const auto &worker : workers) {
+		census.add("lua_workers", 1, worker->heapBytes.load(std::memory_order_relaxed));
+	}
+}
+
+uint64_t LuaWorkers::getHeapBytes(lua_State* L) {
+	return static_cast<uint64_t>(lua_gc(L, LUA_GCCOUNT, 0)) * 1024 + static_cast<uint64_t>(lua_gc(L, LUA_GCCOUNTB, 0));
+}
+
+bool LuaWorkers::run(Worker &worker, const std::string &source, const LuaWorkerValue &input, LuaWorkerValue &result, std::string &error) const {
+	lua_State* L = worker.L;
+	remainingInstructions = instructionLimit;
+	auto it = worker.jobs.find(source);
+	if (it == worker.jobs.end()) {
+		if (luaL_loadbuffer(L, source.data(), source.size(), "=worker") != 0 || lua_pcall(L, 0, 1, 0) != 0) {
+			error = popError(L);
+			return false;
+		}
+
+		if (!lua_isfunction(L, -1)) {
+			lua_pop(L, 1);
+			error = "the job source must return a function";
+			return false;
+		}
+
+		if (worker.jobs.size() >= MAX_CACHED_JOBS) {
+			for (const auto &[cachedSource, reference] : worker.jobs) {
+				luaL_unref(L, LUA_REGISTRYINDEX, reference);
+			}
+			worker.jobs.clear();
+		}
+		it = worker.jobs.emplace(source, luaL_ref(L, LUA_REGISTRYINDEX)).first;
+	}
+
+	lua_rawgeti(L, LUA_REGISTRYINDEX, it->second);
+	push(L, input);
+	if (lua_pcall(L, 1, 1, 0) != 0) {
+		error = popError(L);
+		return false;
+	}
+
+	const bool copied = read(L, -1, result, error);
+	lua_pop(L, 1);
+	return copied;
+}
+
+void LuaWorkers::complete(lua_State* globalState, int32_t callback, int32_t scriptId, const LuaWorkerValue &result, const std::string &error) {
+	auto &environment = g_luaEnvironment();
+	// The scripts state was recreated since the job was queued, the callback went with the old one
+	if (environment.getLuaState() != globalState) {
+		return;
+	}
+
+	lua_rawgeti(globalState, LUA_REGISTRYINDEX, callback);
+	if (error.empty()) {
+		push(globalState, result);
+		lua_pushnil(globalState);
+	} else {
+		lua_pushnil(globalState);
+		lua_pushlstring(globalState, error.data(), error.size());
+	}
+
+	if (environment.reserveScriptEnv()) {
+		ScriptEnvironment* env = environment.getScriptEnv();
+		env->setTimerEvent();
+		env->setScriptId(scriptId, &environment);
+		environment.callFunction(2);
+	} else {
+		lua_pop(globalState, 3);
+		g_logger().error("[LuaWorkers::complete] - Call stack overflow. Too many lua script calls being nested");
+	}
+
+	luaL_unref(globalState, LUA_REGISTRYINDEX, callback);
+}
+
+bool LuaWorkers::read(lua_State* L, int index, LuaWorkerValue &value, std::string &error, uint32_t depth) {
+	if (index < 0 && index > LUA_REGISTRYINDEX) {
+		index = lua_gettop(L) + index + 1;
+	}
+
+	value.type = lua_type(L, index);
+	switch (value.type) {
+		case LUA_TNIL:
+			return true;
+		case LUA_TBOOLEAN:
+			value.boolean = lua_toboolean(L, index) != 0;
+			return true;
+		case LUA_TNUMBER:
+			value.number = lua_tonumber(L, index);
+			return true;
+		case LUA_TSTRING: {
+			size_t length = 0;
+			const char* string = lua_tolstring(L, index, &length);
+			value.string.assign(string, length);
+			return true;
+		}
+		case LUA_TTABLE: {
+			if (depth >= MAX_DEPTH || !lua_checkstack(L, 4)) {
+				error = "the table is nested too deep (or it contains itself)";
+				return false;
+			}
+
+			lua_pushnil(L);
+			while (lua_next(L, index) != 0) {
+				value.table.emplace_back();
+				if (!read(L, -2, value.table.back(), error, depth + 1)) {
+					lua_pop(L, 2);
+					return false;
+				}
+				value.table.emplace_back();
+				if (!read(L, -1, value.table.back(), error, depth + 1)) {
+					lua_pop(L, 2);
+					return false;
+				}
+				lua_pop(L, 1);
+			}
+			return true;
+		}
+		default:
+			error = fmt::format("a {} can not be passed to or from a worker", lua_typename(L, value.type));
+			return false;
+	}
+}
+
+void LuaWorkers::push(lua_State* L, const LuaWorkerValue &value) {
+	switch (value.type) {
+		case LUA_TBOOLEAN:
+			lua_pushboolean(L, value.boolean);
+			break;
+		case LUA_TNUMBER:
+			lua_pushnumber(L, value.number);
+			break;
+		case LUA_TSTRING:
+			lua_pushlstring(L, value.string.data(), value.string.size());
+			break;
+		case LUA_TTABLE:
+			lua_checkstack(L, 4);
+			lua_createtable(L, 0, static_cast<int>(value.table.size() / 2));
+			for (size_t i = 0; i + 1 < value.table.size(); i += 2) {
+				push(L, value.table[i]);
+				push(L, value.table[i + 1]);
+				lua_rawset(L, -3);
+			}
+			break;
+		default:
+			lua_pushnil(L);
+			break;
+	}
+}
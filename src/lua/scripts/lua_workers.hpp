@@ -0,0 +1,98 @@
+/**
+ * Canary - A free and open-source MMORPG server emulator
+ * Copyright (©) 2019-2024 OpenTibiaBR <opentibiabr@outlook.com>
+ * Repository: https://github.com/opentibiabr/canary
+ * License: https://github.com/opentibiabr/canary/blob/main/LICENSE
+ * Contributors: https://github.com/opentibiabr/canary/graphs/contributors
+ * Website: https://docs.opentibiabr.com/
+ */
+
+#pragma once
+
+class MemoryCensus;
+class ThreadPool;
+
+/**
+ * A copy of a Lua value that can move between Lua states:
+ * nil, boolean, number, string or a table of them.
+ */
+struct LuaWorkerValue {
+	int type = LUA_TNIL;
+	bool boolean = false;
+	lua_Number number = 0;
+	std::string string;
+	// key, value, key, value... of a table
+	std::vector<LuaWorkerValue> table;
+};
+
+/**
+ * Runs pure script work (path scoring, loot tables, text formatting...) on Lua states of their own,
+ * on the Lua lane of the thread pool, so it does not hold the dispatcher.
+ * The lane has a thread for each state and each thread always runs its own state, so a job never waits for one.
+ * A job is a chunk that returns a function, it is called with a copy of the input and its result
+ * is copied back to the callback, which runs on the dispatcher like an addEvent.
+ * The worker states only have the base, string, table and math libraries: no game objects, only plain values cross them,
+ * and a job that runs more than luaWorkerInstructionLimit instructions is aborted with an error.
+ */
+class LuaWorkers {
+public:
+	LuaWorkers() = default;
+	~LuaWorkers();
+
+	// Singleton - ensures we don't accidentally copy it
+	LuaWorkers(const LuaWorkers &) = delete;
+	void operator=(const LuaWorkers &) = delete;
+
+	static LuaWorkers &getInstance();
+
+	// Creates the states and the Lua lane of threadPool, at startup
+	void start(ThreadPool &threadPool);
+
+	/**
+	 * Queues source (a chunk that returns the job function) with input,
+	 * callback is a reference in the registry of the scripts state, called with (result, error).
+	 * @return false if there are no worker states.
+	 */
+	bool submit(std::string source, LuaWorkerValue input, int32_t callback, int32_t scriptId);
+
+	/**
+	 * Copies the value at index, tables are copied deep.
+	 * @return false with the reason in error if it holds something that can not be copied.
+	 */
+	static bool read(lua_State* L, int index, LuaWorkerValue &value, std::string &error, uint32_t depth = 0);
+	static void push(lua_State* L, const LuaWorkerValue &value);
+
+	// Adds the heaps of the worker states, as of their last job
+	void countMemory(MemoryCensus &census) const;
+
+private:
+	static constexpr uint32_t MAX_DEPTH = 32;
+	// Compiled jobs kept per state, sources are usually constants of the scripts
+	static constexpr size_t MAX_CACHED_JOBS = 256;
+
+	// Instructions between two checks of the limit
+	static constexpr int HOOK_INSTRUCTIONS = 1000;
+
+	struct Worker {
+		lua_State* L = nullptr;
+		// source -> registry reference of the job function
+		phmap::flat_hash_map<std::string, int32_t> jobs;
+		// Updated after each job, the state itself is only touched by its thread
+		std::atomic_uint64_t heapBytes = 0;
+	};
+
+	// The state of the calling lane thread, each thread takes the next one on its first job
+	Worker &getWorker();
+	static lua_State* newState(bool limited);
+	static void limitHook(lua_State* L, lua_Debug* debug);
+	static uint64_t getHeapBytes(lua_State* L);
+	bool run(Worker &worker, const std::string &source, const LuaWorkerValue &input, LuaWorkerValue &result, std::string &error) const;
+	static void complete(lua_State* globalState, int32_t callback, int32_t scriptId, const LuaWorkerValue &result, const std::string &error);
+
+	ThreadPool* threadPool = nullptr;
+	std::vector<std::unique_ptr<Worker>> workers;
+	std::atomic_size_t nextWorker = 0;
+	int64_t instructionLimit = 0;
+};
+
+constexpr auto g_luaWorkers = LuaWorkers::getInstance;
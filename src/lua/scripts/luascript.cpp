@@ -11,7 +11,11 @@
 
 #include "lua/scripts/luascript.hpp"
 #include "lua/scripts/lua_environment.hpp"
+#include "lua/scripts/lua_profiler.hpp"
+#include "lua/scripts/lua_memory.hpp"
+#include "lib/metrics/allocation_counter.hpp"
 #include "lib/metrics/metrics.hpp"
+#include "config/configmanager.hpp"
 
 ScriptEnvironment::DBResultMap ScriptEnvironment::tempResults;
 uint32_t ScriptEnvironment::lastResultId = 0;
@@ -39,7 +43,7 @@ bool LuaScriptInterface::reInitState() {
 /// Same as lua_pcall, but adds stack trace to error strings in called function.
 int32_t LuaScriptInterface::loadFile(const std::string &file, const std::string &scriptName) {
 	// loads file as a chunk at stack top
-	int ret = luaL_loadfile(luaState, file.c_str());
+	int ret = loadChunk(luaState, file);
 	if (ret != 0) {
 		lastLuaError = popString(luaState);
 		return -1;
@@ -73,6 +77,72 @@ int32_t LuaScriptInterface::loadFile(const std::string &file, const std::string
 	return 0;
 }
 
+int LuaScriptInterface::loadChunk(lua_State* L, const std::string &file) {
+	const auto &cacheDirectory = g_configManager().getString(LUA_BYTECODE_CACHE_DIRECTORY, __FUNCTION__);
+	if (cacheDirectory.empty()) {
+		return luaL_loadfile(L, file.c_str());
+	}
+
+	std::ifstream sourceFile(file, std::ios::binary);
+	if (!sourceFile) {
+		return luaL_loadfile(L, file.c_str());
+	}
+	std::string source((std::istreambuf_iterator<char>(sourceFile)), std::istreambuf_iterator<char>());
+
+	// Like luaL_loadfile, a first line starting with '#' is skipped, its line break is kept for the line numbers
+	std::string_view code(source);
+	if (code.starts_with('#')) {
+		const auto lineEnd = code.find('\n');
+		code.remove_prefix(lineEnd == std::string_view::npos ? code.size() : lineEnd);
+	}
+
+	// The path is part of the key as the chunk name is in the bytecode
+	const auto key = std::hash<std::string> {}(fmt::format("{}\n{}\n{}\n{}", LUAJIT_VERSION, sizeof(void*), file, code));
+	const auto cachePath = std::filesystem::path(cacheDirectory) / fmt::format("{:016x}.luac", key);
+	const auto chunkName = "@" + file;
+
+	if (std::ifstream cacheFile(cachePath, std::ios::binary); cacheFile) {
+		const std::string bytecode((std::istreambuf_iterator<char>(cacheFile)), std::istreambuf_iterator<char>());
+		if (luaL_loadbuffer(L, bytecode.data(), bytecode.size(), chunkName.c_str()) == 0) {
+			return 0;
+		}
+
+		// Written by another build or damaged, compiled again below
+		g_logger().debug("[{}] - Discarding the cached bytecode of {}: {}", __FUNCTION__, file, lua_tostring(L, -1));
+		lua_pop(L, 1);
+	}
+
+	const int ret = luaL_loadbuffer(L, code.data(), code.size(), chunkName.c_str());
+	if (ret != 0) {
+		return ret;
+	}
+
+	std::string bytecode;
+	const auto writer = [](lua_State*, const void* data, size_t size, void* buffer) -> int {
+		static_cast<std::string*>(buffer)->append(static_cast<const char*>(data), size);
+		return 0;
+	};
+	if (lua_dump(L, writer, &bytecode) != 0 || bytecode.empty()) {
+		return 0;
+	}
+
+	// Written aside and renamed, a chunk is never read half written
+	std::error_code error;
+	std::filesystem::create_directories(cachePath.parent_path(), error);
+	auto tmpPath = cachePath;
+	tmpPath += ".tmp";
+	if (std::ofstream cacheFile(tmpPath, std::ios::binary | std::ios::trunc); cacheFile) {
+		cacheFile.write(bytecode.data(), static_cast<std::streamsize>(bytecode.size()));
+		cacheFile.close();
+		if (cacheFile) {
+			std::filesystem::rename(tmpPath, cachePath, error);
+		} else {
+			std::filesystem::remove(tmpPath, error);
+		}
+	}
+	return 0;
+}
+
 int32_t LuaScriptInterface::getEvent(const std::string &eventName) {
 	// get our events table
 	lua_rawgeti(luaState, LUA_REGISTRYINDEX, eventTableRef);
@@ -266,6 +336,14 @@ std::string LuaScriptInterface::getMetricsScope() {
 
 bool LuaScriptInterface::callFunction(int params) {
 	metrics::lua_latency measure(getMetricsScope());
+	allocation_counter::Scope allocationScope(allocation_counter::AllocationTag::Lua);
+	const bool profiling = LuaProfiler::isRunning();
+	if (profiling) {
+		g_luaProfiler().enter(luaState, getMetricsScope());
+	}
+
+	const auto allocatedBefore = LuaMemory::getAllocatedBytes();
+	const auto allocationsBefore = LuaMemory::getAllocations();
 	bool result = false;
 	int size = lua_gettop(luaState);
 	if (protectedCall(luaState, params, 1) != 0) {
@@ -274,6 +352,11 @@ bool LuaScriptInterface::callFunction(int params) {
 		result = LuaScriptInterface::getBoolean(luaState, -1);
 	}
 
+	if (profiling) {
+		g_luaProfiler().leave(luaState);
+	}
+	g_luaMemory().account(interfaceName, allocatedBefore, allocationsBefore);
+
 	lua_pop(luaState, 1);
 	if ((lua_gettop(luaState) + params + 1) != size) {
 		LuaScriptInterface::reportError(nullptr, "Stack size changed!");
@@ -285,11 +368,24 @@ bool LuaScriptInterface::callFunction(int params) {
 
 void LuaScriptInterface::callVoidFunction(int params) {
 	metrics::lua_latency measure(getMetricsScope());
+	allocation_counter::Scope allocationScope(allocation_counter::AllocationTag::Lua);
+	const bool profiling = LuaProfiler::isRunning();
+	if (profiling) {
+		g_luaProfiler().enter(luaState, getMetricsScope());
+	}
+
+	const auto allocatedBefore = LuaMemory::getAllocatedBytes();
+	const auto allocationsBefore = LuaMemory::getAllocations();
 	int size = lua_gettop(luaState);
 	if (protectedCall(luaState, params, 0) != 0) {
 		LuaScriptInterface::reportError(nullptr, LuaScriptInterface::popString(luaState));
 	}
 
+	if (profiling) {
+		g_luaProfiler().leave(luaState);
+	}
+	g_luaMemory().account(interfaceName, allocatedBefore, allocationsBefore);
+
 	if ((lua_gettop(luaState) + params + 1) != size) {
 		LuaScriptInterface::reportError(nullptr, "Stack size changed!");
 	}
@@ -75,6 +75,12 @@ protected:
 private:
 	std::string getMetricsScope();
 
+	/**
+	 * Loads file as a chunk at the stack top like luaL_loadfile, from its compiled copy in the bytecode cache when there is one,
+	 * otherwise from source, saving the compiled chunk to the cache.
+	 */
+	static int loadChunk(lua_State* L, const std::string &file);
+
 	std::string lastLuaError;
 	std::string interfaceName;
 	std::string loadingFile;
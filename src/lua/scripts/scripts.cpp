@@ -16,6 +16,9 @@
 #include "lua/scripts/scripts.hpp"
 #include "creatures/combat/spells.hpp"
 #include "lua/callbacks/events_callbacks.hpp"
+#include "lua/creature/actions.hpp"
+#include "lua/creature/creatureevent.hpp"
+#include "lua/creature/talkaction.hpp"
 
 Scripts::Scripts() :
 	scriptInterface("Scripts Interface") {
@@ -109,11 +112,8 @@ bool Scripts::loadScripts(std::string loadPath, bool isLib, bool reload) {
 				lastDirectory = realPath.parent_path().string();
 			}
 
-			// If the function 'loadFile' returns -1, then there was an error loading the file
-			if (scriptInterface.loadFile(realPath.string(), realPath.filename().string()) == -1) {
-				// Log the error and the file path, and skip to the next iteration of the loop.
-				g_logger().error(realPath.string());
-				g_logger().error(scriptInterface.getLastLuaError());
+			// If the function 'loadFile' returns false, then there was an error loading the file, skip to the next iteration of the loop.
+			if (!loadFile(realPath, loadPath, isLib)) {
 				continue;
 			}
 		}
@@ -129,3 +129,123 @@ bool Scripts::loadScripts(std::string loadPath, bool isLib, bool reload) {
 
 	return true;
 }
+
+size_t Scripts::reloadChangedScripts(const std::string &folderName, bool isLib) {
+	const auto dir = std::filesystem::current_path() / folderName;
+	if (!std::filesystem::exists(dir) || !std::filesystem::is_directory(dir)) {
+		g_logger().error("Can not load folder {}", folderName);
+		return 0;
+	}
+
+	std::vector<std::filesystem::path> changed;
+	phmap::flat_hash_set<std::string> found;
+	for (const auto &entry : std::filesystem::recursive_directory_iterator(dir)) {
+		if (!isScriptFile(entry, isLib)) {
+			continue;
+		}
+
+		const auto &path = entry.path();
+		const auto &fileName = *found.emplace(path.string()).first;
+		auto it = files.find(fileName);
+		if (it == files.end()) {
+			changed.emplace_back(path);
+			continue;
+		}
+
+		std::error_code error;
+		const auto modified = std::filesystem::last_write_time(path, error);
+		if (modified == it->second.modified) {
+			continue;
+		}
+
+		// Touched but not edited
+		if (hashFile(path) == it->second.hash) {
+			it->second.modified = modified;
+			continue;
+		}
+		changed.emplace_back(path);
+	}
+
+	for (auto it = files.begin(); it != files.end();) {
+		const auto &[fileName, file] = *it;
+		if (file.folder != folderName || file.isLib != isLib || found.contains(fileName)) {
+			++it;
+			continue;
+		}
+
+		if (file.requiresFullReload) {
+			g_logger().warn("[{}] - {} was deleted, what it registered is kept until a full reload of the scripts", __FUNCTION__, fileName);
+			++it;
+			continue;
+		}
+
+		clearFile(file.id);
+		g_logger().info("[script removed]: {}", fileName);
+		it = files.erase(it);
+	}
+
+	size_t reloaded = 0;
+	for (const auto &path : changed) {
+		if (auto it = files.find(path.string()); it != files.end()) {
+			if (it->second.requiresFullReload) {
+				g_logger().warn("[{}] - {} registers spells, weapons, callbacks or types, it needs a full reload of the scripts", __FUNCTION__, it->first);
+				continue;
+			}
+			clearFile(it->second.id);
+		}
+
+		if (loadFile(path, folderName, isLib)) {
+			g_logger().info("[script reloaded]: {}", path.filename().string());
+			++reloaded;
+		}
+	}
+	return reloaded;
+}
+
+bool Scripts::isScriptFile(const std::filesystem::directory_entry &entry, bool isLib) {
+	const auto &path = entry.path();
+	if (!entry.is_regular_file() || path.extension() != ".lua" || path.filename().string().starts_with('#')) {
+		return false;
+	}
+
+	const auto fileFolder = path.parent_path().filename().string();
+	return isLib || (fileFolder != "lib" && fileFolder != "events");
+}
+
+size_t Scripts::hashFile(const std::filesystem::path &path) {
+	std::ifstream file(path, std::ios::binary);
+	const std::string content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+	return std::hash<std::string> {}(content);
+}
+
+bool Scripts::loadFile(const std::filesystem::path &path, const std::string &folderName, bool isLib) {
+	const auto fileName = path.string();
+	auto &file = files[fileName];
+	if (file.id == 0) {
+		file.id = ++lastFileId;
+	}
+	file.folder = folderName;
+	file.isLib = isLib;
+	file.requiresFullReload = false;
+	std::error_code error;
+	file.modified = std::filesystem::last_write_time(path, error);
+	file.hash = hashFile(path);
+
+	loadingFile = &file;
+	const bool loaded = scriptInterface.loadFile(fileName, path.filename().string()) != -1;
+	loadingFile = nullptr;
+	if (!loaded) {
+		// Log the error and the file path
+		g_logger().error(fileName);
+		g_logger().error(scriptInterface.getLastLuaError());
+	}
+	return loaded;
+}
+
+void Scripts::clearFile(uint32_t fileId) {
+	g_actions().clearFile(fileId);
+	g_creatureEvents().clearFile(fileId);
+	g_talkActions().clearFile(fileId);
+	g_globalEvents().clearFile(fileId);
+	g_moveEvents().clearFile(fileId);
+}
@@ -28,6 +28,28 @@ public:
 
 	bool loadEventSchedulerScripts(const std::string &fileName);
 	bool loadScripts(std::string folderName, bool isLib, bool reload);
+	/**
+	 * Executes again only the files of the folder that were added or changed (by time and content) since they were loaded,
+	 * after dropping the actions, move events, talkactions, creature events and global events they registered.
+	 * The registrations of deleted files are dropped, files that register anything else are left to a full reload.
+	 * @return the number of files executed.
+	 */
+	size_t reloadChangedScripts(const std::string &folderName, bool isLib);
+
+	/**
+	 * The file being loaded registers something that only a full reload drops (spells, weapons, callbacks, monster or npc types).
+	 */
+	void requireFullReload() {
+		if (loadingFile) {
+			loadingFile->requiresFullReload = true;
+		}
+	}
+
+	// The file the scripts created now belong to, 0 when no file is loading
+	uint32_t getLoadingFileId() const {
+		return loadingFile ? loadingFile->id : 0;
+	}
+
 	LuaScriptInterface &getScriptInterface() {
 		return scriptInterface;
 	}
@@ -41,8 +63,29 @@ public:
 	}
 
 private:
+	struct ScriptFile {
+		uint32_t id = 0;
+		std::string folder;
+		bool isLib = false;
+		bool requiresFullReload = false;
+		std::filesystem::file_time_type modified;
+		size_t hash = 0;
+	};
+
+	static bool isScriptFile(const std::filesystem::directory_entry &entry, bool isLib);
+	static size_t hashFile(const std::filesystem::path &path);
+
+	bool loadFile(const std::filesystem::path &path, const std::string &folderName, bool isLib);
+	// Drops what the file registered
+	static void clearFile(uint32_t fileId);
+
 	int32_t scriptId = 0;
 	LuaScriptInterface scriptInterface;
+
+	// Every file that was loaded, by path
+	std::map<std::string, ScriptFile> files;
+	ScriptFile* loadingFile = nullptr;
+	uint32_t lastFileId = 0;
 };
 
 constexpr auto g_scripts = Scripts::getInstance;
@@ -57,7 +100,7 @@ public:
 	 * @param interface Lua Script Interface
 	 */
 	explicit Script(LuaScriptInterface* interface) :
-		scriptInterface(interface) { }
+		fileId(g_scripts().getLoadingFileId()), scriptInterface(interface) { }
 	virtual ~Script() = default;
 
 	/**
@@ -117,10 +160,19 @@ public:
 		scriptId = newScriptId;
 	}
 
+	// The file that created it, to drop it when only that file is reloaded
+	uint32_t getFileId() const {
+		return fileId;
+	}
+	void setFileId(uint32_t newFileId) {
+		fileId = newFileId;
+	}
+
 private:
 	// If script is loaded callback
 	bool loadedCallback = false;
 
+	uint32_t fileId = 0;
 	int32_t scriptId = 0;
 	LuaScriptInterface* scriptInterface = nullptr;
 };
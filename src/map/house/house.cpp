@@ -87,7 +87,7 @@ bool House::tryTransferOwnership(std::shared_ptr<Player> player, bool serverStar
 	return transferSuccess;
 }
 
-void House::setOwner(uint32_t guid, bool updateDatabase /* = true*/, std::shared_ptr<Player> player /* = nullptr*/) {
+void House::setOwner(uint32_t guid, bool updateDatabase /* = true*/, std::shared_ptr<Player> player /* = nullptr*/, const HouseOwnerInfo* ownerInfo /* = nullptr*/) {
 	if (updateDatabase && owner != guid) {
 		Database &db = Database::getInstance();
 
@@ -125,19 +125,27 @@ void House::setOwner(uint32_t guid, bool updateDatabase /* = true*/, std::shared
 	rentWarnings = 0;
 
 	if (guid != 0) {
-		Database &db = Database::getInstance();
-		std::ostringstream query;
-		query << "SELECT `name`, `account_id` FROM `players` WHERE `id` = " << guid;
-		DBResult_ptr result = db.storeQuery(query.str());
-		if (!result) {
-			return;
+		HouseOwnerInfo info;
+		if (ownerInfo) {
+			if (ownerInfo->name.empty()) {
+				return;
+			}
+			info = *ownerInfo;
+		} else {
+			Database &db = Database::getInstance();
+			std::ostringstream query;
+			query << "SELECT `name`, `account_id` FROM `players` WHERE `id` = " << guid;
+			DBResult_ptr result = db.storeQuery(query.str());
+			if (!result) {
+				return;
+			}
+			info = { result->getString("name"), result->getNumber<uint32_t>("account_id") };
 		}
 
-		std::string name = result->getString("name");
-		if (!name.empty()) {
+		if (!info.name.empty()) {
 			owner = guid;
-			ownerName = name;
-			ownerAccountId = result->getNumber<uint32_t>("account_id");
+			ownerName = std::move(info.name);
+			ownerAccountId = info.accountId;
 		}
 	}
 
@@ -546,6 +554,7 @@ void AccessList::parseList(const std::string &list) {
 	validList = oss.str();
 
 	playerList.clear();
+	guildList.clear();
 	guildRankList.clear();
 	allowEveryone = false;
 	this->list = validList;
@@ -553,6 +562,7 @@ void AccessList::parseList(const std::string &list) {
 		return;
 	}
 
+	std::vector<std::string> playerNames;
 	auto lines = explodeString(validList, "\n", 100);
 	for (auto &m_line : lines) {
 		trimString(m_line);
@@ -579,9 +589,10 @@ void AccessList::parseList(const std::string &list) {
 			// Remove regular expressions since they don't make much sense in houses
 			continue;
 		} else if (m_line.length() <= NETWORKMESSAGE_PLAYERNAME_MAXLENGTH) {
-			addPlayer(m_line);
+			playerNames.emplace_back(std::move(m_line));
 		}
 	}
+	addPlayers(playerNames);
 }
 
 void AccessList::addPlayer(const std::string &name) {
@@ -596,6 +607,20 @@ void AccessList::addPlayer(const std::string &name) {
 	}
 }
 
+void AccessList::addPlayers(const std::vector<std::string> &names) {
+	std::vector<std::string> offlineNames;
+	for (const auto &name : names) {
+		if (const auto &player = g_game().getPlayerByName(name)) {
+			playerList.insert(player->getGUID());
+		} else {
+			offlineNames.emplace_back(name);
+		}
+	}
+	for (const uint32_t guid : IOLoginData::getGuidsByNames(offlineNames)) {
+		playerList.insert(guid);
+	}
+}
+
 namespace {
 	std::shared_ptr<Guild> getGuildByName(const std::string &name) {
 		uint32_t guildId = IOGuild::getGuildIdByName(name);
@@ -613,11 +638,9 @@ namespace {
 }
 
 void AccessList::addGuild(const std::string &name) {
-	const auto guild = getGuildByName(name);
-	if (guild) {
-		for (const auto &rank : guild->getRanks()) {
-			guildRankList.insert(rank->id);
-		}
+	// By id, so the ranks created after the list are in it too
+	if (const uint32_t guildId = IOGuild::getGuildIdByName(name); guildId != 0) {
+		guildList.insert(guildId);
 	}
 }
 
@@ -640,6 +663,10 @@ bool AccessList::isInList(std::shared_ptr<Player> player) const {
 		return true;
 	}
 
+	if (const auto &guild = player->getGuild(); guild && guildList.contains(guild->getId())) {
+		return true;
+	}
+
 	const auto &rank = player->getGuildRank();
 	return rank && guildRankList.contains(rank->id);
 }
@@ -778,109 +805,145 @@ void Houses::payHouses(RentPeriod_t rentPeriod) const {
 		return;
 	}
 
-	time_t currentTime = time(nullptr);
-	for (const auto &it : houseMap) {
-		std::shared_ptr<House> house = it.second;
-		if (house->getOwner() == 0) {
-			continue;
+	// By owner, so an owner of several houses is loaded and saved once
+	std::map<uint32_t, std::vector<std::shared_ptr<House>>> housesByOwner;
+	for (const auto &[_, house] : houseMap) {
+		if (house->getOwner() != 0 && g_game().map.towns.getTown(house->getTownId())) {
+			housesByOwner[house->getOwner()].emplace_back(house);
 		}
+	}
 
-		const uint32_t ownerId = house->getOwner();
-		const auto &town = g_game().map.towns.getTown(house->getTownId());
-		if (!town) {
-			continue;
+	if (housesByOwner.empty()) {
+		return;
+	}
+
+	// The last login of every owner in one query, so only the owners with something to do are loaded
+	Database &db = Database::getInstance();
+	std::ostringstream query;
+	query << "SELECT `id`, `lastlogin` FROM `players` WHERE `id` IN (";
+	for (auto it = housesByOwner.begin(); it != housesByOwner.end(); ++it) {
+		query << (it == housesByOwner.begin() ? "" : ",") << it->first;
+	}
+	query << ')';
+	phmap::flat_hash_map<uint32_t, time_t> lastLogins;
+	if (const auto &result = db.storeQuery(query.str())) {
+		do {
+			lastLogins.emplace(result->getNumber<uint32_t>("id"), result->getNumber<time_t>("lastlogin"));
+		} while (result->next());
+	}
+
+	const time_t currentTime = time(nullptr);
+	const auto daysToReset = g_configManager().getNumber(HOUSE_LOSE_AFTER_INACTIVITY, __FUNCTION__);
+	const bool vipKeepHouse = g_configManager().getBoolean(VIP_KEEP_HOUSE, __FUNCTION__);
+	for (const auto &[ownerId, houses] : housesByOwner) {
+		if (const auto lastLogin = lastLogins.find(ownerId); lastLogin != lastLogins.end()) {
+			const bool inactive = daysToReset > 0 && (currentTime - lastLogin->second) / (60 * 60 * 24) >= daysToReset;
+			const bool rentDue = std::ranges::any_of(houses, [currentTime](const std::shared_ptr<House> &house) {
+				return house->getRent() != 0 && house->getPaidUntil() <= currentTime;
+			});
+			if (!inactive && !rentDue) {
+				continue;
+			}
 		}
 
 		auto player = g_game().getPlayerByGUID(ownerId, true);
 		if (!player) {
 			// Player doesn't exist, reset house owner
-			house->tryTransferOwnership(nullptr, true);
-			continue;
-		}
-
-		// Player hasn't logged in for a while, reset house owner
-		auto daysToReset = g_configManager().getNumber(HOUSE_LOSE_AFTER_INACTIVITY, __FUNCTION__);
-		if (daysToReset > 0) {
-			auto daysSinceLastLogin = (currentTime - player->getLastLoginSaved()) / (60 * 60 * 24);
-			bool vipKeep = g_configManager().getBoolean(VIP_KEEP_HOUSE, __FUNCTION__) && player->isVip();
-			bool activityKeep = daysSinceLastLogin < daysToReset;
-			if (vipKeep && !activityKeep) {
-				g_logger().info("Player {} has not logged in for {} days, but is a VIP, so the house will not be reset.", player->getName(), daysToReset);
-			} else if (!vipKeep && !activityKeep) {
-				g_logger().info("Player {} has not logged in for {} days, so the house will be reset.", player->getName(), daysToReset);
-				house->setOwner(0, true, player);
-				g_saveManager().savePlayer(player);
-				continue;
+			for (const auto &house : houses) {
+				house->tryTransferOwnership(nullptr, true);
 			}
-		}
-
-		const uint32_t rent = house->getRent();
-		if (rent == 0 || house->getPaidUntil() > currentTime) {
 			continue;
 		}
 
-		if (player->getBankBalance() >= rent) {
-			g_game().removeMoney(player, rent, 0, true);
-			g_metrics().addCounter("balance_decrease", rent, { { "player", player->getName() }, { "context", "house_rent" } });
-
-			time_t paidUntil = currentTime;
-			switch (rentPeriod) {
-				case RENTPERIOD_DAILY:
-					paidUntil += 24 * 60 * 60;
-					break;
-				case RENTPERIOD_WEEKLY:
-					paidUntil += 24 * 60 * 60 * 7;
-					break;
-				case RENTPERIOD_MONTHLY:
-					paidUntil += 24 * 60 * 60 * 30;
-					break;
-				case RENTPERIOD_YEARLY:
-					paidUntil += 24 * 60 * 60 * 365;
-					break;
-				default:
-					break;
+		bool changed = false;
+		for (const auto &house : houses) {
+			// Player hasn't logged in for a while, reset house owner
+			if (daysToReset > 0) {
+				auto daysSinceLastLogin = (currentTime - player->getLastLoginSaved()) / (60 * 60 * 24);
+				bool vipKeep = vipKeepHouse && player->isVip();
+				bool activityKeep = daysSinceLastLogin < daysToReset;
+				if (vipKeep && !activityKeep) {
+					g_logger().info("Player {} has not logged in for {} days, but is a VIP, so the house will not be reset.", player->getName(), daysToReset);
+				} else if (!vipKeep && !activityKeep) {
+					g_logger().info("Player {} has not logged in for {} days, so the house will be reset.", player->getName(), daysToReset);
+					house->setOwner(0, true, player);
+					changed = true;
+					continue;
+				}
 			}
 
-			house->setPaidUntil(paidUntil);
-		} else {
-			if (house->getPayRentWarnings() < 7) {
-				int32_t daysLeft = 7 - house->getPayRentWarnings();
+			const uint32_t rent = house->getRent();
+			if (rent == 0 || house->getPaidUntil() > currentTime) {
+				continue;
+			}
 
-				std::shared_ptr<Item> letter = Item::CreateItem(ITEM_LETTER_STAMPED);
-				std::string period;
+			if (player->getBankBalance() >= rent) {
+				g_game().removeMoney(player, rent, 0, true);
+				g_metrics().addCounter("balance_decrease", rent, { { "player", player->getName() }, { "context", "house_rent" } });
 
+				time_t paidUntil = currentTime;
 				switch (rentPeriod) {
 					case RENTPERIOD_DAILY:
-						period = "daily";
+						paidUntil += 24 * 60 * 60;
 						break;
-
 					case RENTPERIOD_WEEKLY:
-						period = "weekly";
+						paidUntil += 24 * 60 * 60 * 7;
 						break;
-
 					case RENTPERIOD_MONTHLY:
-						period = "monthly";
+						paidUntil += 24 * 60 * 60 * 30;
 						break;
-
 					case RENTPERIOD_YEARLY:
-						period = "annual";
+						paidUntil += 24 * 60 * 60 * 365;
 						break;
-
 					default:
 						break;
 				}
 
-				std::ostringstream ss;
-				ss << "Warning! \nThe " << period << " rent of " << house->getRent() << " gold for your house \"" << house->getName() << "\" is payable. Have it within " << daysLeft << " days or you will lose this house.";
-				letter->setAttribute(ItemAttribute_t::TEXT, ss.str());
-				g_game().internalAddItem(player->getInbox(), letter, INDEX_WHEREEVER, FLAG_NOLIMIT);
-				house->setPayRentWarnings(house->getPayRentWarnings() + 1);
+				house->setPaidUntil(paidUntil);
 			} else {
-				house->setOwner(0, true, player);
+				if (house->getPayRentWarnings() < 7) {
+					int32_t daysLeft = 7 - house->getPayRentWarnings();
+
+					std::shared_ptr<Item> letter = Item::CreateItem(ITEM_LETTER_STAMPED);
+					std::string period;
+
+					switch (rentPeriod) {
+						case RENTPERIOD_DAILY:
+							period = "daily";
+							break;
+
+						case RENTPERIOD_WEEKLY:
+							period = "weekly";
+							break;
+
+						case RENTPERIOD_MONTHLY:
+							period = "monthly";
+							break;
+
+						case RENTPERIOD_YEARLY:
+							period = "annual";
+							break;
+
+						default:
+							break;
+					}
+
+					std::ostringstream ss;
+					ss << "Warning! \nThe " << period << " rent of " << house->getRent() << " gold for your house \"" << house->getName() << "\" is payable. Have it within " << daysLeft << " days or you will lose this house.";
+					letter->setAttribute(ItemAttribute_t::TEXT, ss.str());
+					g_game().internalAddItem(player->getInbox(), letter, INDEX_WHEREEVER, FLAG_NOLIMIT);
+					house->setPayRentWarnings(house->getPayRentWarnings() + 1);
+				} else {
+					house->setOwner(0, true, player);
+				}
 			}
+
+			changed = true;
 		}
 
-		g_saveManager().savePlayer(player);
+		if (changed) {
+			g_saveManager().savePlayer(player);
+		}
 	}
 }
 
@@ -18,10 +18,15 @@ class House;
 class BedItem;
 class Player;
 
+/**
+ * A guest, subowner or door list. The text is resolved when it is set: the names to player GUIDs
+ * (in one query), "@guild" to the guild id and "rank@guild" to the rank id, so isInList is a few hash lookups.
+ */
 class AccessList {
 public:
 	void parseList(const std::string &list);
 	void addPlayer(const std::string &name);
+	void addPlayers(const std::vector<std::string> &names);
 	void addGuild(const std::string &name);
 	void addGuildRank(const std::string &name, const std::string &rankName);
 
@@ -32,6 +37,7 @@ public:
 private:
 	std::string list;
 	phmap::flat_hash_set<uint32_t> playerList;
+	phmap::flat_hash_set<uint32_t> guildList;
 	phmap::flat_hash_set<uint32_t> guildRankList;
 	bool allowEveryone = false;
 };
@@ -97,6 +103,12 @@ private:
 	std::shared_ptr<House> house;
 };
 
+// The name and account of an owner, when already known, so setOwner does not query them
+struct HouseOwnerInfo {
+	std::string name;
+	uint32_t accountId = 0;
+};
+
 class House : public SharedObject {
 public:
 	explicit House(uint32_t houseId);
@@ -149,7 +161,7 @@ public:
 	void setNewOwnerGuid(int32_t newOwnerGuid, bool serverStartup);
 	void clearHouseInfo(bool preventOwnerDeletion);
 	bool tryTransferOwnership(std::shared_ptr<Player> player, bool serverStartup);
-	void setOwner(uint32_t guid, bool updateDatabase = true, std::shared_ptr<Player> player = nullptr);
+	void setOwner(uint32_t guid, bool updateDatabase = true, std::shared_ptr<Player> player = nullptr, const HouseOwnerInfo* ownerInfo = nullptr);
 	uint32_t getOwner() const {
 		return owner;
 	}
@@ -233,6 +245,17 @@ public:
 	bool hasNewOwnership() const;
 	void setNewOwnership();
 
+	/**
+	 * Whether the items of the house may have changed since they were last saved,
+	 * only dirty houses are written to tile_store (see IOMapSerialize::saveHouseItems).
+	 */
+	bool isItemsDirty() const {
+		return itemsDirty.load(std::memory_order_relaxed);
+	}
+	void setItemsDirty(bool dirty = true) {
+		itemsDirty.store(dirty, std::memory_order_relaxed);
+	}
+
 private:
 	bool transferToDepot() const;
 
@@ -268,6 +291,9 @@ private:
 
 	bool isLoaded = false;
 
+	// Unknown until the first save, saves can run on another thread
+	std::atomic<bool> itemsDirty = true;
+
 	void handleContainer(ItemList &moveItemList, std::shared_ptr<Item> item) const;
 	void handleWrapableItem(ItemList &moveItemList, std::shared_ptr<Item> item, std::shared_ptr<Player> player, std::shared_ptr<HouseTile> houseTile) const;
 };
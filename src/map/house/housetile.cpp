@@ -20,6 +20,8 @@ HouseTile::HouseTile(int32_t initX, int32_t initY, int32_t initZ, std::shared_pt
 
 void HouseTile::addThing(int32_t index, std::shared_ptr<Thing> thing) {
 	Tile::addThing(index, thing);
+	// Creatures too, whoever enters can change the items without touching the tile
+	house->setItemsDirty();
 
 	if (!thing || !thing->getParent()) {
 		return;
@@ -32,6 +34,7 @@ void HouseTile::addThing(int32_t index, std::shared_ptr<Thing> thing) {
 
 void HouseTile::internalAddThing(uint32_t index, std::shared_ptr<Thing> thing) {
 	Tile::internalAddThing(index, thing);
+	house->setItemsDirty();
 
 	if (!thing || !thing->getParent()) {
 		return;
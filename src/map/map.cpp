@@ -11,6 +11,7 @@
 
 #include "map.hpp"
 #include "utils/astarnodes.hpp"
+#include "utils/hierarchicalpath.hpp"
 
 #include "lua/callbacks/event_callback.hpp"
 #include "lua/callbacks/events_callbacks.hpp"
@@ -21,6 +22,24 @@
 #include "io/iomapserialize.hpp"
 #include "game/scheduling/dispatcher.hpp"
 #include "map/spectators.hpp"
+#include "lib/metrics/allocation_counter.hpp"
+#include "lib/metrics/profiler.hpp"
+
+namespace {
+	// The results of isSightClear of each thread, valid while no tile changes what blocks projectiles
+	struct SightLineCache {
+		static constexpr size_t MAX_ENTRIES = 1 << 16;
+
+		uint32_t version = 0;
+		phmap::flat_hash_map<std::pair<uint64_t, uint64_t>, bool> results;
+	};
+
+	thread_local SightLineCache sightLineCache;
+
+	uint64_t getSightLineKey(const Position &pos) {
+		return (static_cast<uint64_t>(pos.x) << 24) | (static_cast<uint64_t>(pos.y) << 8) | pos.z;
+	}
+}
 
 void Map::load(const std::string &identifier, const Position &pos) {
 	try {
@@ -31,7 +50,8 @@ void Map::load(const std::string &identifier, const Position &pos) {
 	}
 }
 
-void Map::loadMap(const std::string &identifier, bool mainMap /*= false*/, bool loadHouses /*= false*/, bool loadMonsters /*= false*/, bool loadNpcs /*= false*/, bool loadZones /*= false*/, const Position &pos /*= Position()*/) {
+void Map::parse(const std::string &identifier, bool mainMap /*= false*/, const Position &pos /*= Position()*/) {
+	allocation_counter::Scope allocationScope(allocation_counter::AllocationTag::Map);
 	// Only download map if is loading the main map and it is not already downloaded
 	if (mainMap && g_configManager().getBoolean(TOGGLE_DOWNLOAD_MAP, __FUNCTION__) && !std::filesystem::exists(identifier)) {
 		const auto mapDownloadUrl = g_configManager().getString(MAP_DOWNLOAD_URL, __FUNCTION__);
@@ -54,6 +74,15 @@ void Map::loadMap(const std::string &identifier, bool mainMap /*= false*/, bool
 
 	// Load the map
 	load(identifier, pos);
+	parsedIdentifier = identifier;
+}
+
+void Map::loadMap(const std::string &identifier, bool mainMap /*= false*/, bool loadHouses /*= false*/, bool loadMonsters /*= false*/, bool loadNpcs /*= false*/, bool loadZones /*= false*/, const Position &pos /*= Position()*/) {
+	allocation_counter::Scope allocationScope(allocation_counter::AllocationTag::Map);
+	if (parsedIdentifier != identifier) {
+		parse(identifier, mainMap, pos);
+	}
+	parsedIdentifier.clear();
 
 	// Only create items from lua functions if is loading main map
 	// It needs to be after the load map to ensure the map already exists before creating the items
@@ -210,20 +239,49 @@ void Map::refreshZones(uint16_t x, uint16_t y, uint8_t z) {
 	}
 }
 
+void Map::addZone(const Position &pos, const std::shared_ptr<Zone> &zone) {
+	if (const auto tile = getLoadedTile(pos.x, pos.y, pos.z)) {
+		tile->addZone(zone);
+	}
+}
+
+void Map::removeZone(const Position &pos, const std::shared_ptr<Zone> &zone) {
+	if (const auto tile = getLoadedTile(pos.x, pos.y, pos.z)) {
+		tile->removeZone(zone);
+	}
+}
+
 void Map::setTile(uint16_t x, uint16_t y, uint8_t z, std::shared_ptr<Tile> newTile) {
 	if (z >= MAP_MAX_LAYERS) {
 		g_logger().error("Attempt to set tile on invalid coordinate: {}", Position(x, y, z).toString());
 		return;
 	}
 
-	if (const auto sector = getMapSector(x, y)) {
-		sector->createFloor(z)->setTile(x, y, newTile);
-	} else {
-		getBestMapSector(x, y)->createFloor(z)->setTile(x, y, newTile);
+	const auto sector = getMapSector(x, y);
+	const auto &floor = (sector ? sector : getBestMapSector(x, y))->createFloor(z);
+	floor->setTile(x, y, newTile);
+	floor->setPathBlocked(x, y, newTile && newTile->isPathBlocked());
+	invalidateSightLines();
+	// Replaced tiles must not be evicted back to what was loaded
+	floor->setTileOrigin(x, y, nullptr);
+}
+
+bool Map::isPathBlocked(const Position &pos) const {
+	if (pos.z >= MAP_MAX_LAYERS) {
+		return false;
 	}
+
+	const auto sector = getMapSector(pos.x, pos.y);
+	if (!sector) {
+		return false;
+	}
+
+	const auto &floor = sector->getFloor(pos.z);
+	return floor && floor->isPathBlocked(pos.x, pos.y);
 }
 
 bool Map::placeCreature(const Position &centerPos, std::shared_ptr<Creature> creature, bool extendedPos /* = false*/, bool forceLogin /* = false*/) {
+	allocation_counter::Scope allocationScope(allocation_counter::AllocationTag::Map);
 	auto monster = creature->getMonster();
 	if (monster) {
 		monster->ignoreFieldDamage = true;
@@ -316,11 +374,12 @@ bool Map::placeCreature(const Position &centerPos, std::shared_ptr<Creature> cre
 	toCylinder->internalAddThing(creature);
 
 	const Position &dest = toCylinder->getPosition();
-	getMapSector(dest.x, dest.y)->addCreature(creature);
+	getMapSector(dest.x, dest.y)->addCreature(creature, dest.z);
 	return true;
 }
 
 void Map::moveCreature(const std::shared_ptr<Creature> &creature, const std::shared_ptr<Tile> &newTile, bool forceTeleport /* = false*/) {
+	allocation_counter::Scope allocationScope(allocation_counter::AllocationTag::Map);
 	if (!creature || !newTile) {
 		return;
 	}
@@ -334,8 +393,9 @@ void Map::moveCreature(const std::shared_ptr<Creature> &creature, const std::sha
 	const auto &oldPos = oldTile->getPosition();
 	const auto &newPos = newTile->getPosition();
 
-	const auto &fromZones = oldTile->getZones();
-	const auto &toZones = newTile->getZones();
+	// Copies, the zone callbacks may refresh the zones of the tiles, one zone fits without allocating
+	const auto fromZones = oldTile->getZones();
+	const auto toZones = newTile->getZones();
 
 	if (auto ret = g_game().beforeCreatureZoneChange(creature, fromZones, toZones); ret != RETURNVALUE_NOERROR) {
 		return;
@@ -388,8 +448,10 @@ void Map::moveCreature(const std::shared_ptr<Creature> &creature, const std::sha
 
 	// Switch the node ownership
 	if (old_sector != new_sector) {
-		old_sector->removeCreature(creature);
-		new_sector->addCreature(creature);
+		old_sector->removeCreature(creature, oldPos.z);
+		new_sector->addCreature(creature, newPos.z);
+	} else if (oldPos.z != newPos.z) {
+		old_sector->moveCreatureFloor(creature, oldPos.z, newPos.z);
 	}
 
 	// add the creature
@@ -422,7 +484,9 @@ void Map::moveCreature(const std::shared_ptr<Creature> &creature, const std::sha
 
 	// event method
 	for (const auto &spectator : spectators) {
-		spectator->onCreatureMove(creature, newTile, newPos, oldTile, oldPos, teleport);
+		if (spectator->wantsCreatureMove(creature)) {
+			spectator->onCreatureMove(creature, newTile, newPos, oldTile, oldPos, teleport);
+		}
 	}
 
 	oldTile->postRemoveNotification(creature, newTile, 0);
@@ -565,6 +629,24 @@ bool Map::checkSightLine(Position start, Position destination) {
 }
 
 bool Map::isSightClear(const Position &fromPos, const Position &toPos, bool floorCheck) {
+	const auto version = sightLinesVersion.load(std::memory_order_relaxed);
+	auto &cache = sightLineCache;
+	if (cache.version != version || cache.results.size() >= SightLineCache::MAX_ENTRIES) {
+		cache.results.clear();
+		cache.version = version;
+	}
+
+	const std::pair key { (getSightLineKey(fromPos) << 1) | static_cast<uint64_t>(floorCheck), getSightLineKey(toPos) };
+	if (auto it = cache.results.find(key); it != cache.results.end()) {
+		return it->second;
+	}
+
+	const bool sightClear = computeSightClear(fromPos, toPos, floorCheck);
+	cache.results.emplace(key, sightClear);
+	return sightClear;
+}
+
+bool Map::computeSightClear(const Position &fromPos, const Position &toPos, bool floorCheck) {
 	// Check if this sight line should be even possible
 	if (floorCheck && fromPos.z != toPos.z) {
 		return false;
@@ -629,6 +711,11 @@ std::shared_ptr<Tile> Map::canWalkTo(const std::shared_ptr<Creature> &creature,
 		return getTile(pos.x, pos.y, pos.z);
 	}
 
+	// blocked for everyone, no need to look the tile up
+	if (isPathBlocked(pos) && creature->getPosition() != pos) {
+		return nullptr;
+	}
+
 	// used for non-cached tiles
 	const auto &tile = getTile(pos.x, pos.y, pos.z);
 	if (creature->getTile() != tile) {
@@ -641,6 +728,63 @@ std::shared_ptr<Tile> Map::canWalkTo(const std::shared_ptr<Creature> &creature,
 }
 
 bool Map::getPathMatching(const std::shared_ptr<Creature> &creature, const Position &__targetPos, std::vector<Direction> &dirList, const FrozenPathingConditionCall &pathCondition, const FindPathParams &fpp) {
+	allocation_counter::Scope allocationScope(allocation_counter::AllocationTag::Map);
+	profiler::Zone zone(__METHOD_NAME__);
+	const bool withoutCreature = creature == nullptr;
+	const auto &startPos = withoutCreature ? __targetPos : creature->getPosition();
+	const auto &targetPos = withoutCreature ? pathCondition.getTargetPos() : __targetPos;
+	const auto startCost = AStarNodes::getTileWalkCost(creature, getTile(startPos.x, startPos.y, startPos.z));
+
+	const auto distance = std::max(Position::getDistanceX(startPos, targetPos), Position::getDistanceY(startPos, targetPos));
+	const auto hierarchicalDistance = g_configManager().getNumber(PATHFINDING_HIERARCHICAL_DISTANCE, __FUNCTION__);
+	if (hierarchicalDistance > 0 && distance >= hierarchicalDistance && getHierarchicalPath(creature, startPos, targetPos, dirList, pathCondition, fpp)) {
+		return true;
+	}
+
+	// Long routes (map clicks, far targets) would run out of the fixed node budget of AStarNodes
+	const auto longDistance = g_configManager().getNumber(PATHFINDING_LONG_DISTANCE, __FUNCTION__);
+	if (longDistance > 0 && distance >= longDistance) {
+		const auto maxNodes = static_cast<uint32_t>(g_configManager().getNumber(PATHFINDING_LONG_MAX_NODES, __FUNCTION__));
+		AStarHeapNodes nodes(startPos.x, startPos.y, startCost, maxNodes);
+		return searchPath(nodes, creature, startPos, targetPos, dirList, pathCondition, fpp);
+	}
+
+	AStarNodes nodes(startPos.x, startPos.y, startCost);
+	return searchPath(nodes, creature, startPos, targetPos, dirList, pathCondition, fpp);
+}
+
+bool Map::getHierarchicalPath(const std::shared_ptr<Creature> &creature, const Position &startPos, const Position &targetPos, std::vector<Direction> &dirList, const FrozenPathingConditionCall &pathCondition, const FindPathParams &fpp) {
+	std::vector<Position> waypoints;
+	if (!HierarchicalPath::findWaypoints(startPos, targetPos, waypoints)) {
+		return false;
+	}
+
+	FindPathParams legParams;
+	legParams.clearSight = false;
+	legParams.minTargetDist = 0;
+	legParams.maxTargetDist = 0;
+
+	// Every leg is in the order of dirList, last step first, so they are joined from the last one
+	std::vector<std::vector<Direction>> legs(waypoints.size() + 1);
+	Position from = startPos;
+	for (size_t i = 0; i <= waypoints.size(); ++i) {
+		const bool lastLeg = i == waypoints.size();
+		const auto &to = lastLeg ? targetPos : waypoints[i];
+		AStarNodes nodes(from.x, from.y, AStarNodes::getTileWalkCost(creature, getTile(from)));
+		if (!searchPath(nodes, creature, from, to, legs[i], lastLeg ? pathCondition : FrozenPathingConditionCall(to), lastLeg ? fpp : legParams)) {
+			return false;
+		}
+		from = to;
+	}
+
+	for (auto it = legs.rbegin(); it != legs.rend(); ++it) {
+		dirList.insert(dirList.end(), it->begin(), it->end());
+	}
+	return true;
+}
+
+template <typename Nodes>
+bool Map::searchPath(Nodes &nodes, const std::shared_ptr<Creature> &creature, const Position &fromPos, const Position &targetPos, std::vector<Direction> &dirList, const FrozenPathingConditionCall &pathCondition, const FindPathParams &fpp) {
 	static int_fast32_t allNeighbors[8][2] = {
 		{ -1, 0 }, { 0, 1 }, { 1, 0 }, { 0, -1 }, { -1, -1 }, { 1, -1 }, { 1, 1 }, { -1, 1 }
 	};
@@ -658,15 +802,12 @@ bool Map::getPathMatching(const std::shared_ptr<Creature> &creature, const Posit
 
 	const bool withoutCreature = creature == nullptr;
 
-	Position pos = withoutCreature ? __targetPos : creature->getPosition();
+	Position pos = fromPos;
 	Position endPos;
 
-	AStarNodes nodes(pos.x, pos.y, AStarNodes::getTileWalkCost(creature, getTile(pos.x, pos.y, pos.z)));
-
 	int32_t bestMatch = 0;
 
 	const auto &startPos = pos;
-	const auto &targetPos = withoutCreature ? pathCondition.getTargetPos() : __targetPos;
 
 	const int_fast32_t sX = std::abs(targetPos.getX() - pos.getX());
 	const int_fast32_t sY = std::abs(targetPos.getY() - pos.getY());
@@ -772,7 +913,7 @@ bool Map::getPathMatching(const std::shared_ptr<Creature> &creature, const Posit
 			}
 		}
 		nodes.closeNode(n);
-	} while (nodes.getClosedNodes() < 100);
+	} while (nodes.getClosedNodes() < nodes.getMaxClosedNodes());
 	if (!found) {
 		return false;
 	}
@@ -824,6 +965,8 @@ bool Map::getPathMatching(const std::shared_ptr<Creature> &creature, std::vector
 }
 
 bool Map::getPathMatchingCond(const std::shared_ptr<Creature> &creature, const Position &targetPos, std::vector<Direction> &dirList, const FrozenPathingConditionCall &pathCondition, const FindPathParams &fpp) {
+	allocation_counter::Scope allocationScope(allocation_counter::AllocationTag::Map);
+	profiler::Zone zone(__METHOD_NAME__);
 	Position pos = creature->getPosition();
 	Position endPos;
 
@@ -1018,7 +1161,7 @@ uint32_t Map::clean() {
 	ItemVector toRemove;
 	toRemove.reserve(128);
 
-	for (const auto &tile : g_game().getTilesToClean()) {
+	for (const auto &[tile, addedAt] : g_game().getTilesToClean()) {
 		if (!tile) {
 			continue;
 		}
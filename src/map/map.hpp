@@ -20,6 +20,7 @@ class Player;
 class Game;
 class Tile;
 class Map;
+class Zone;
 
 struct FindPathParams;
 
@@ -42,6 +43,12 @@ public:
 	 * \returns true if the map was loaded successfully
 	 */
 	void load(const std::string &identifier, const Position &pos = Position());
+	/**
+	 * Reads the OTBM of a map (downloading the main one first when enabled) without its spawns, houses and zones.
+	 * It only fills the map itself, so the startup runs it on the thread pool while the scripts load,
+	 * the loadMap of the same identifier that follows does not read it again.
+	 */
+	void parse(const std::string &identifier, bool mainMap = false, const Position &pos = Position());
 	/**
 	 * Load the main map
 	 * \param identifier Is the main map name (name of file .otbm)
@@ -82,6 +89,9 @@ public:
 	void refreshZones(const Position &pos) {
 		refreshZones(pos.x, pos.y, pos.z);
 	}
+	// A tile still in the cache gets its zones when loaded, so only the loaded one is changed
+	void addZone(const Position &pos, const std::shared_ptr<Zone> &zone);
+	void removeZone(const Position &pos, const std::shared_ptr<Zone> &zone);
 
 	std::shared_ptr<Tile> getOrCreateTile(uint16_t x, uint16_t y, uint8_t z, bool isDynamic = false);
 	std::shared_ptr<Tile> getOrCreateTile(const Position &pos, bool isDynamic = false) {
@@ -120,8 +130,26 @@ public:
 	bool isSightClear(const Position &fromPos, const Position &toPos, bool floorCheck);
 	bool checkSightLine(Position start, Position destination);
 
+	/**
+	 * Drops the sight lines cached by isSightClear, called whenever a tile gains or loses
+	 * a ground or a projectile blocking item.
+	 */
+	static void invalidateSightLines() {
+		sightLinesVersion.fetch_add(1, std::memory_order_relaxed);
+	}
+	// Changes whenever a line of sight may have changed, for the results kept outside the map
+	static uint32_t getSightLinesVersion() {
+		return sightLinesVersion.load(std::memory_order_relaxed);
+	}
+
 	std::shared_ptr<Tile> canWalkTo(const std::shared_ptr<Creature> &creature, const Position &pos);
 
+	/**
+	 * Lock free check of the floor path block bits, see Tile::isPathBlocked.
+	 * Only tiles that were materialized at least once are known, so false does not mean walkable.
+	 */
+	bool isPathBlocked(const Position &pos) const;
+
 	bool getPathMatching(const std::shared_ptr<Creature> &creature, std::vector<Direction> &dirList, const FrozenPathingConditionCall &pathCondition, const FindPathParams &fpp);
 	bool getPathMatching(const std::shared_ptr<Creature> &creature, const Position &targetPos, std::vector<Direction> &dirList, const FrozenPathingConditionCall &pathCondition, const FindPathParams &fpp);
 	bool getPathMatchingCond(const std::shared_ptr<Creature> &creature, const Position &targetPos, std::vector<Direction> &dirList, const FrozenPathingConditionCall &pathCondition, const FindPathParams &fpp);
@@ -153,7 +181,22 @@ private:
 	}
 	std::shared_ptr<Tile> getLoadedTile(uint16_t x, uint16_t y, uint8_t z);
 
+	bool computeSightClear(const Position &fromPos, const Position &toPos, bool floorCheck);
+
+	inline static std::atomic<uint32_t> sightLinesVersion = 0;
+
+	/**
+	 * Plans the route over the sector portals (see HierarchicalPath) and refines each leg with AStarNodes.
+	 */
+	bool getHierarchicalPath(const std::shared_ptr<Creature> &creature, const Position &startPos, const Position &targetPos, std::vector<Direction> &dirList, const FrozenPathingConditionCall &pathCondition, const FindPathParams &fpp);
+
+	// A* core of getPathMatching, Nodes is AStarNodes or AStarHeapNodes
+	template <typename Nodes>
+	bool searchPath(Nodes &nodes, const std::shared_ptr<Creature> &creature, const Position &fromPos, const Position &targetPos, std::vector<Direction> &dirList, const FrozenPathingConditionCall &pathCondition, const FindPathParams &fpp);
+
 	std::filesystem::path path;
+	// Set by parse until the loadMap of the same map
+	std::string parsedIdentifier;
 	std::string monsterfile;
 	std::string housefile;
 	std::string npcfile;
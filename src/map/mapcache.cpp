@@ -17,6 +17,7 @@
 #include "io/iologindata.hpp"
 #include "items/item.hpp"
 #include "game/game.hpp"
+#include "game/memory_census.hpp"
 #include "game/zones/zone.hpp"
 #include "map/map.hpp"
 #include "utils/hash.hpp"
@@ -24,15 +25,49 @@
 
 #include "io/iomap.hpp"
 
-static phmap::flat_hash_map<size_t, std::shared_ptr<BasicItem>> items;
-static phmap::flat_hash_map<size_t, std::shared_ptr<BasicTile>> tiles;
+// Tile areas are parsed in parallel (see IOMap::parseTileAreas), so both caches are locked
+static phmap::parallel_flat_hash_map_m<size_t, std::shared_ptr<BasicItem>> items;
+static phmap::parallel_flat_hash_map_m<size_t, std::shared_ptr<BasicTile>> tiles;
+
+// Node based, so the views of BasicItem::internText stay valid when it grows
+static phmap::node_hash_set<std::string> internedTexts;
+static std::mutex internedTextsMutex;
 
 std::shared_ptr<BasicItem> static_tryGetItemFromCache(const std::shared_ptr<BasicItem> &ref) {
-	return ref ? items.try_emplace(ref->hash(), ref).first->second : nullptr;
+	if (!ref) {
+		return nullptr;
+	}
+
+	auto item = ref;
+	items.try_emplace_l(
+		ref->hash(), [&item](const auto &entry) { item = entry.second; }, ref
+	);
+	return item;
+}
+
+std::shared_ptr<BasicItem> static_tryGetItemFromCache(BasicItem &&ref) {
+	std::shared_ptr<BasicItem> item;
+	const auto hash = ref.hash();
+	items.lazy_emplace_l(
+		hash, [&item](const auto &entry) { item = entry.second; },
+		[&](const auto &ctor) {
+			item = std::make_shared<BasicItem>(std::move(ref));
+			ctor(hash, item);
+		}
+	);
+	return item;
 }
 
 std::shared_ptr<BasicTile> static_tryGetTileFromCache(const std::shared_ptr<BasicTile> &ref) {
-	return ref ? tiles.try_emplace(ref->hash(), ref).first->second : nullptr;
+	if (!ref) {
+		return nullptr;
+	}
+
+	auto tile = ref;
+	tiles.try_emplace_l(
+		ref->hash(), [&tile](const auto &entry) { tile = entry.second; }, ref
+	);
+	return tile;
 }
 
 void MapCache::flush() {
@@ -67,7 +102,7 @@ void MapCache::parseItemAttr(const std::shared_ptr<BasicItem> &BasicItem, std::s
 	}
 
 	if (!BasicItem->text.empty()) {
-		item->setAttribute(ItemAttribute_t::TEXT, BasicItem->text);
+		item->setAttribute(ItemAttribute_t::TEXT, std::string(BasicItem->text));
 	}
 
 	/* if (BasicItem.description != 0)
@@ -82,8 +117,8 @@ std::shared_ptr<Item> MapCache::createItem(const std::shared_ptr<BasicItem> &Bas
 
 	parseItemAttr(BasicItem, item);
 
-	if (item->getContainer() && !BasicItem->items.empty()) {
-		for (const auto &BasicItemInside : BasicItem->items) {
+	if (item->getContainer() && BasicItem->items) {
+		for (const auto &BasicItemInside : *BasicItem->items) {
 			if (auto itemInsede = createItem(BasicItemInside, position)) {
 				item->getContainer()->addItem(itemInsede);
 				item->getContainer()->updateItemWeight(itemInsede->getWeight());
@@ -163,27 +198,214 @@ std::shared_ptr<Tile> MapCache::getOrCreateTileFromCache(const std::unique_ptr<F
 	// Remove Tile from cache
 	floor->setTileCache(x, y, nullptr);
 
+	// Keep where it came from, so it can go back to the cache once its sector is idle
+	if (tileEvictionTime > 0 && !cachedTile->isHouse()) {
+		floor->setTileOrigin(x, y, cachedTile);
+		floor->setLastMaterialization(OTSYS_TIME());
+	}
+
 	return tile;
 }
 
-void MapCache::setBasicTile(uint16_t x, uint16_t y, uint8_t z, const std::shared_ptr<BasicTile> &newTile) {
+bool MapCache::canEvictTile(const std::shared_ptr<Tile> &tile, const std::shared_ptr<BasicTile> &origin) {
+	// Anything else holding the tile (cleaning lists, scripts, spectator caches) would keep a stale copy
+	if (!tile || tile.use_count() > 1 || tile->getHouse() || tile->getCreatureCount() != 0) {
+		return false;
+	}
+
+	std::vector<uint16_t> originIds;
+	originIds.reserve(origin->items.size() + 1);
+	if (origin->ground) {
+		originIds.emplace_back(origin->ground->id);
+	}
+	for (const auto &basicItem : origin->items) {
+		originIds.emplace_back(basicItem->id);
+	}
+
+	if (tile->getThingCount() != originIds.size()) {
+		return false;
+	}
+
+	std::vector<uint16_t> tileIds;
+	tileIds.reserve(originIds.size());
+	for (size_t i = 0; i < originIds.size(); ++i) {
+		const auto item = tile->getThing(i) ? tile->getThing(i)->getItem() : nullptr;
+		// Items referenced from elsewhere, decaying or holding player changes must stay
+		if (!item || item.use_count() > 2 || !item->isLoadedFromMap() || item->getContainer() || Item::items[item->getID()].canWriteText || item->getDecaying() != DECAYING_FALSE || item->hasAttribute(ItemAttribute_t::UNIQUEID)) {
+			return false;
+		}
+		tileIds.emplace_back(item->getID());
+	}
+
+	std::ranges::sort(originIds);
+	std::ranges::sort(tileIds);
+	return originIds == tileIds;
+}
+
+size_t MapCache::evictIdleTiles() {
+	if (tileEvictionTime <= 0) {
+		return 0;
+	}
+
+	const int64_t now = OTSYS_TIME();
+	size_t evicted = 0;
+	for (auto &[index, sector] : mapSectors) {
+		if (!sector.creature_list.empty() || now - sector.lastActivity < tileEvictionTime) {
+			continue;
+		}
+
+		for (const auto &floor : sector.floors) {
+			if (!floor || !floor->hasEvictableTiles() || now - floor->getLastMaterialization() < tileEvictionTime) {
+				continue;
+			}
+
+			std::unique_lock l(floor->getMutex());
+
+			const uint16_t baseX = (index & 0xFFFF) * SECTOR_SIZE;
+			const uint16_t baseY = (index >> 16) * SECTOR_SIZE;
+			for (uint16_t x = baseX; x < baseX + SECTOR_SIZE; ++x) {
+				for (uint16_t y = baseY; y < baseY + SECTOR_SIZE; ++y) {
+					const auto origin = floor->getTileOrigin(x, y);
+					if (!origin) {
+						continue;
+					}
+
+					// getTile is not used here, it would lock the floor again
+					const auto &tile = floor->getTiles()[x & SECTOR_MASK][y & SECTOR_MASK].first;
+					if (!canEvictTile(tile, origin)) {
+						continue;
+					}
+
+					floor->setTile(x, y, nullptr);
+					floor->setTileCache(x, y, origin);
+					floor->setTileOrigin(x, y, nullptr);
+					++evicted;
+				}
+			}
+		}
+	}
+
+	return evicted;
+}
+
+void MapCache::setTileEvictionTime(int64_t time) {
+	tileEvictionTime = time;
+}
+
+namespace {
+	/**
+	 * The cached tiles and items are shared, a reference to one weighs 1 / use_count(), so all the references
+	 * to it add up to one object without a set of the visited ones. The caches are flushed after the map is loaded,
+	 * the floors and the cached tiles hold every reference left.
+	 */
+	struct CachedCensus {
+		double tiles = 0;
+		double tileBytes = 0;
+		double items = 0;
+		double itemBytes = 0;
+	};
+
+	void countCachedItem(const std::shared_ptr<BasicItem> &item, double weight, CachedCensus &census) {
+		weight /= static_cast<double>(item.use_count());
+		census.items += weight;
+		census.itemBytes += weight * MemoryCensus::sharedBytes<BasicItem>();
+		if (!item->items) {
+			return;
+		}
+
+		census.itemBytes += weight * (sizeof(*item->items) + item->items->capacity() * sizeof(std::shared_ptr<BasicItem>));
+		for (const auto &child : *item->items) {
+			countCachedItem(child, weight, census);
+		}
+	}
+
+	void countCachedTile(const std::shared_ptr<BasicTile> &tile, CachedCensus &census) {
+		const auto weight = 1.0 / static_cast<double>(tile.use_count());
+		census.tiles += weight;
+		census.tileBytes += weight * (MemoryCensus::sharedBytes<BasicTile>() + tile->items.capacity() * sizeof(std::shared_ptr<BasicItem>));
+		if (tile->ground) {
+			countCachedItem(tile->ground, weight, census);
+		}
+		for (const auto &item : tile->items) {
+			countCachedItem(item, weight, census);
+		}
+	}
+}
+
+void MapCache::countMemory(MemoryCensus &census) const {
+	// A node of the unordered map holds the pair, the next pointer and the hash
+	census.add("map_sectors", mapSectors.size(), mapSectors.size() * (sizeof(std::pair<const uint32_t, MapSector>) + 2 * sizeof(void*)) + mapSectors.bucket_count() * sizeof(void*) + sectorGrid.capacity() * sizeof(MapSector*));
+
+	CachedCensus cached;
+	for (const auto &[index, sector] : mapSectors) {
+		census.add("map_sectors", 0, (sector.creature_list.capacity() + sector.player_list.capacity()) * sizeof(std::shared_ptr<Creature>));
+
+		for (const auto &floor : sector.floors) {
+			if (!floor) {
+				continue;
+			}
+
+			std::shared_lock lock(floor->getMutex());
+			const auto &origins = floor->getTileOrigins();
+			census.add("map_floors", 1, sizeof(Floor) + (origins ? sizeof(*origins) : 0));
+
+			uint64_t materialized = 0;
+			for (uint16_t x = 0; x < SECTOR_SIZE; ++x) {
+				for (uint16_t y = 0; y < SECTOR_SIZE; ++y) {
+					const auto &[tile, cachedTile] = floor->getTiles()[x][y];
+					if (tile) {
+						++materialized;
+					}
+					if (cachedTile) {
+						countCachedTile(cachedTile, cached);
+					}
+					// Not getTileOrigin, a copy would be one more reference
+					if (origins) {
+						if (const auto &origin = (*origins)[x * SECTOR_SIZE + y]) {
+							countCachedTile(origin, cached);
+						}
+					}
+				}
+			}
+
+			// The items on them are counted with all the others, the largest tile type stands for all of them
+			census.add("map_tiles", materialized, materialized * MemoryCensus::sharedBytes<DynamicTile>());
+		}
+	}
+
+	census.add("map_cached_tiles", static_cast<uint64_t>(cached.tiles + 0.5), static_cast<uint64_t>(cached.tileBytes));
+	census.add("map_cached_items", static_cast<uint64_t>(cached.items + 0.5), static_cast<uint64_t>(cached.itemBytes));
+
+	std::scoped_lock lock(internedTextsMutex);
+	uint64_t textBytes = internedTexts.bucket_count() * sizeof(void*);
+	for (const auto &text : internedTexts) {
+		textBytes += sizeof(std::string) + sizeof(void*) + MemoryCensus::heapBytes(text);
+	}
+	census.add("map_texts", internedTexts.size(), textBytes);
+}
+
+std::shared_ptr<BasicTile> MapCache::setBasicTile(uint16_t x, uint16_t y, uint8_t z, const std::shared_ptr<BasicTile> &newTile, bool deduplicated /* = false*/) {
 	if (z >= MAP_MAX_LAYERS) {
 		g_logger().error("Attempt to set tile on invalid coordinate: {}", Position(x, y, z).toString());
-		return;
+		return nullptr;
 	}
 
-	const auto tile = static_tryGetTileFromCache(newTile);
-	if (const auto sector = getMapSector(x, y)) {
-		sector->createFloor(z)->setTileCache(x, y, tile);
-	} else {
-		getBestMapSector(x, y)->createFloor(z)->setTileCache(x, y, tile);
-	}
+	const auto tile = deduplicated ? newTile : static_tryGetTileFromCache(newTile);
+	const auto sector = getMapSector(x, y);
+	const auto &floor = (sector ? sector : getBestMapSector(x, y))->createFloor(z);
+	floor->setTileCache(x, y, tile);
+	floor->setTileOrigin(x, y, nullptr);
+	return tile;
 }
 
 std::shared_ptr<BasicItem> MapCache::tryReplaceItemFromCache(const std::shared_ptr<BasicItem> &ref) {
 	return static_tryGetItemFromCache(ref);
 }
 
+std::shared_ptr<BasicItem> MapCache::tryReplaceItemFromCache(BasicItem &&ref) {
+	return static_tryGetItemFromCache(std::move(ref));
+}
+
 MapSector* MapCache::createMapSector(const uint32_t x, const uint32_t y) {
 	const uint32_t index = x / SECTOR_SIZE | y / SECTOR_SIZE << 16;
 	const auto it = mapSectors.find(index);
@@ -192,7 +414,52 @@ MapSector* MapCache::createMapSector(const uint32_t x, const uint32_t y) {
 	}
 
 	MapSector::newSector = true;
-	return &mapSectors[index];
+	auto* sector = &mapSectors[index];
+
+	const uint32_t gridX = x / SECTOR_SIZE - sectorGridX;
+	const uint32_t gridY = y / SECTOR_SIZE - sectorGridY;
+	if (gridX < sectorGridWidth && gridY < sectorGridHeight) {
+		sectorGrid[gridY * sectorGridWidth + gridX] = sector;
+	}
+
+	return sector;
+}
+
+void MapCache::buildSectorGrid() {
+	// Above this the grid would waste more memory than it is worth (32MB of pointers)
+	static constexpr size_t MAX_SECTOR_GRID_CELLS = 4 * 1024 * 1024;
+
+	if (mapSectors.empty()) {
+		return;
+	}
+
+	uint32_t minX = std::numeric_limits<uint32_t>::max(), minY = std::numeric_limits<uint32_t>::max();
+	uint32_t maxX = 0, maxY = 0;
+	for (const auto &[index, sector] : mapSectors) {
+		const uint32_t sectorX = index & 0xFFFF;
+		const uint32_t sectorY = index >> 16;
+		minX = std::min(minX, sectorX);
+		minY = std::min(minY, sectorY);
+		maxX = std::max(maxX, sectorX);
+		maxY = std::max(maxY, sectorY);
+	}
+
+	const uint32_t width = maxX - minX + 1;
+	const uint32_t height = maxY - minY + 1;
+	if (static_cast<size_t>(width) * height > MAX_SECTOR_GRID_CELLS) {
+		g_logger().warn("[{}] - Map bounds are too large for the sector grid ({}x{} sectors), keeping the current one", __FUNCTION__, width, height);
+		return;
+	}
+
+	sectorGrid.assign(static_cast<size_t>(width) * height, nullptr);
+	sectorGridX = minX;
+	sectorGridY = minY;
+	sectorGridWidth = width;
+	sectorGridHeight = height;
+
+	for (auto &[index, sector] : mapSectors) {
+		sectorGrid[((index >> 16) - minY) * width + ((index & 0xFFFF) - minX)] = &sector;
+	}
 }
 
 MapSector* MapCache::getBestMapSector(uint32_t x, uint32_t y) {
@@ -256,14 +523,22 @@ void BasicItem::hash(size_t &h) const {
 		stdext::hash_combine(h, text);
 	}
 
-	if (!items.empty()) {
-		stdext::hash_combine(h, items.size());
-		for (const auto &item : items) {
+	if (items) {
+		stdext::hash_combine(h, items->size());
+		for (const auto &item : *items) {
 			item->hash(h);
 		}
 	}
 }
 
+std::string_view BasicItem::internText(std::string_view text) {
+	std::scoped_lock lock(internedTextsMutex);
+	if (const auto it = internedTexts.find(text); it != internedTexts.end()) {
+		return *it;
+	}
+	return *internedTexts.emplace(text).first;
+}
+
 bool BasicItem::unserializeItemNode(FileStream &stream, uint16_t x, uint16_t y, uint8_t z) {
 	if (stream.isProp(OTB::Node::END)) {
 		stream.back();
@@ -279,14 +554,17 @@ bool BasicItem::unserializeItemNode(FileStream &stream, uint16_t x, uint16_t y,
 
 		const uint16_t streamId = stream.getU16();
 
-		const auto item = std::make_shared<BasicItem>();
-		item->id = streamId;
+		BasicItem item;
+		item.id = streamId;
 
-		if (!item->unserializeItemNode(stream, x, y, z)) {
+		if (!item.unserializeItemNode(stream, x, y, z)) {
 			throw IOMapException(fmt::format("[x:{}, y:{}, z:{}] Failed to load item.", x, y, z));
 		}
 
-		items.emplace_back(static_tryGetItemFromCache(item));
+		if (!items) {
+			items = std::make_unique<std::vector<std::shared_ptr<BasicItem>>>();
+		}
+		items->emplace_back(static_tryGetItemFromCache(std::move(item)));
 
 		if (!stream.endNode()) {
 			throw IOMapException(fmt::format("[x:{}, y:{}, z:{}] Could not end node.", x, y, z));
@@ -332,14 +610,14 @@ void BasicItem::readAttr(FileStream &stream) {
 			} break;
 
 			case ATTR_TEXT: {
-				const auto str = stream.getString();
+				const auto str = stream.getStringView();
 				if (!str.empty()) {
-					text = str;
+					text = internText(str);
 				}
 			} break;
 
 			case ATTR_DESC: {
-				const auto str = stream.getString();
+				const auto str = stream.getStringView();
 				// if (!str.empty())
 				//	text = str;
 			} break;
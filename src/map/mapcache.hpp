@@ -17,10 +17,12 @@ class Tile;
 class Item;
 class Position;
 class FileStream;
+class MemoryCensus;
 
 #pragma pack(1)
 struct BasicItem {
-	std::string text;
+	// Interned, see BasicItem::internText
+	std::string_view text;
 	// size_t description { 0 };
 
 	uint16_t id { 0 };
@@ -33,11 +35,18 @@ struct BasicItem {
 
 	uint8_t destZ { 0 };
 
-	std::vector<std::shared_ptr<BasicItem>> items;
+	// Only containers have children, so they are kept out of line
+	std::unique_ptr<std::vector<std::shared_ptr<BasicItem>>> items;
 
 	bool unserializeItemNode(FileStream &propStream, uint16_t x, uint16_t y, uint8_t z);
 	void readAttr(FileStream &propStream);
 
+	/**
+	 * Map texts repeat a lot (signs, books, letters), every distinct text is stored once
+	 * and kept for the whole server lifetime.
+	 */
+	static std::string_view internText(std::string_view text);
+
 	size_t hash() const {
 		size_t h = 0;
 		hash(h);
@@ -83,10 +92,21 @@ class MapCache {
 public:
 	virtual ~MapCache() = default;
 
-	void setBasicTile(uint16_t x, uint16_t y, uint8_t z, const std::shared_ptr<BasicTile> &BasicTile);
+	/**
+	 * Sets the cached tile of a position, equal tiles are shared.
+	 * \param deduplicated Skips the tile cache, for tiles that are already known to be unique (e.g. from a map snapshot).
+	 * \returns The tile that was set.
+	 */
+	std::shared_ptr<BasicTile> setBasicTile(uint16_t x, uint16_t y, uint8_t z, const std::shared_ptr<BasicTile> &BasicTile, bool deduplicated = false);
 
 	std::shared_ptr<BasicItem> tryReplaceItemFromCache(const std::shared_ptr<BasicItem> &ref);
 
+	/**
+	 * Returns the cached item equal to ref, ref is only allocated if
+	 * there is no equal item in the cache yet.
+	 */
+	std::shared_ptr<BasicItem> tryReplaceItemFromCache(BasicItem &&ref);
+
 	void flush();
 
 	/**
@@ -101,21 +121,59 @@ public:
 	 * \returns A pointer to that map sector.
 	 */
 	MapSector* getMapSector(const uint32_t x, const uint32_t y) {
+		const uint32_t gridX = x / SECTOR_SIZE - sectorGridX;
+		const uint32_t gridY = y / SECTOR_SIZE - sectorGridY;
+		if (gridX < sectorGridWidth && gridY < sectorGridHeight) {
+			return sectorGrid[gridY * sectorGridWidth + gridX];
+		}
+
 		const auto it = mapSectors.find(x / SECTOR_SIZE | y / SECTOR_SIZE << 16);
 		return it != mapSectors.end() ? &it->second : nullptr;
 	}
 
 	const MapSector* getMapSector(const uint32_t x, const uint32_t y) const {
-		const auto it = mapSectors.find(x / SECTOR_SIZE | y / SECTOR_SIZE << 16);
-		return it != mapSectors.end() ? &it->second : nullptr;
+		return const_cast<MapCache*>(this)->getMapSector(x, y);
 	}
 
+	/**
+	 * Builds the dense sector grid over the bounds of the loaded map, so the sector lookup
+	 * of Map::getTile does not need to hash. Sectors outside of the grid
+	 * (e.g. far away custom maps) are still found in the sparse mapSectors.
+	 */
+	void buildSectorGrid();
+
+	/**
+	 * Turns materialized tiles of sectors that had no creatures for the eviction time
+	 * back into their cached BasicTile, as long as nothing on them changed since they were loaded.
+	 * \returns The number of evicted tiles.
+	 */
+	size_t evictIdleTiles();
+
+	/**
+	 * Time (in ms) a sector needs to be idle before its tiles are evicted, 0 disables tile eviction.
+	 */
+	void setTileEvictionTime(int64_t time);
+
+	// Adds the sectors, floors and tiles of the map, and the cached tiles, items and texts they were loaded from
+	void countMemory(MemoryCensus &census) const;
+
 protected:
 	std::shared_ptr<Tile> getOrCreateTileFromCache(const std::unique_ptr<Floor> &floor, uint16_t x, uint16_t y);
 
 	std::unordered_map<uint32_t, MapSector> mapSectors;
 
+	// Dense [sectorGridHeight][sectorGridWidth] index of mapSectors, starting at sector (sectorGridX, sectorGridY)
+	std::vector<MapSector*> sectorGrid;
+	uint32_t sectorGridX = 0;
+	uint32_t sectorGridY = 0;
+	uint32_t sectorGridWidth = 0;
+	uint32_t sectorGridHeight = 0;
+
+	int64_t tileEvictionTime = 0;
+
 private:
+	static bool canEvictTile(const std::shared_ptr<Tile> &tile, const std::shared_ptr<BasicTile> &origin);
+
 	void parseItemAttr(const std::shared_ptr<BasicItem> &BasicItem, std::shared_ptr<Item> item);
 	std::shared_ptr<Item> createItem(const std::shared_ptr<BasicItem> &BasicItem, Position position);
 };
@@ -11,21 +11,16 @@
 
 #include "spectators.hpp"
 #include "game/game.hpp"
+#include "lib/metrics/allocation_counter.hpp"
 
-phmap::flat_hash_map<Position, SpectatorsCache> Spectators::spectatorsCache;
-
-void Spectators::clearCache() {
-	spectatorsCache.clear();
-}
-
-Spectators Spectators::insert(const std::shared_ptr<Creature> &creature) {
+Spectators &Spectators::insert(const std::shared_ptr<Creature> &creature) {
 	if (creature) {
 		creatures.emplace_back(creature);
 	}
 	return *this;
 }
 
-Spectators Spectators::insertAll(const CreatureVector &list) {
+Spectators &Spectators::insertAll(const CreatureVector &list) {
 	if (!list.empty()) {
 		const bool hasValue = !creatures.empty();
 
@@ -41,120 +36,103 @@ Spectators Spectators::insertAll(const CreatureVector &list) {
 	return *this;
 }
 
-bool Spectators::checkCache(const SpectatorsCache::FloorData &specData, bool onlyPlayers, const Position &centerPos, bool checkDistance, bool multifloor, int32_t minRangeX, int32_t maxRangeX, int32_t minRangeY, int32_t maxRangeY) {
-	const auto &list = multifloor || !specData.floor ? specData.multiFloor : specData.floor;
-
-	if (!list) {
-		return false;
-	}
+void Spectators::findInRange(const Position &centerPos, bool multifloor, bool onlyPlayers, int32_t minRangeX, int32_t maxRangeX, int32_t minRangeY, int32_t maxRangeY) {
+	allocation_counter::Scope allocationScope(allocation_counter::AllocationTag::Map);
+	const size_t previousSize = creatures.size();
 
-	if (!multifloor && !specData.floor) {
-		// Force check the distance of creatures as we only need to pick up creatures from the Floor(centerPos.z)
-		checkDistance = true;
-	}
-
-	if (checkDistance) {
-		CreatureVector spectators;
-		spectators.reserve(creatures.size());
-		for (const auto &creature : *list) {
-			const auto &specPos = creature->getPosition();
-			if (centerPos.x - specPos.x >= minRangeX
-			    && centerPos.y - specPos.y >= minRangeY
-			    && centerPos.x - specPos.x <= maxRangeX
-			    && centerPos.y - specPos.y <= maxRangeY
-			    && (multifloor || specPos.z == centerPos.z)
-			    && (!onlyPlayers || creature->getPlayer())) {
-				spectators.emplace_back(creature);
-			}
-		}
-		insertAll(spectators);
-	} else {
-		insertAll(*list);
+	forEachInRange(centerPos, multifloor, onlyPlayers, minRangeX, maxRangeX, minRangeY, maxRangeY, [this](const std::shared_ptr<Creature> &creature) {
+		creatures.emplace_back(creature);
+	});
+
+	// Remove duplicate
+	if (previousSize > 0 && creatures.size() > previousSize) {
+		std::unordered_set<std::shared_ptr<Creature>> found(creatures.begin(), creatures.begin() + previousSize);
+		const auto newEnd = std::remove_if(creatures.begin() + previousSize, creatures.end(), [&found](const auto &creature) {
+			return !found.emplace(creature).second;
+		});
+		creatures.erase(newEnd, creatures.end());
 	}
-
-	return true;
 }
 
-Spectators Spectators::find(const Position &centerPos, bool multifloor, bool onlyPlayers, int32_t minRangeX, int32_t maxRangeX, int32_t minRangeY, int32_t maxRangeY) {
+Spectators::Range Spectators::getRange(const Position &centerPos, bool multifloor, int32_t minRangeX, int32_t maxRangeX, int32_t minRangeY, int32_t maxRangeY) {
 	minRangeX = (minRangeX == 0 ? -MAP_MAX_VIEW_PORT_X : -minRangeX);
 	maxRangeX = (maxRangeX == 0 ? MAP_MAX_VIEW_PORT_X : maxRangeX);
 	minRangeY = (minRangeY == 0 ? -MAP_MAX_VIEW_PORT_Y : -minRangeY);
 	maxRangeY = (maxRangeY == 0 ? MAP_MAX_VIEW_PORT_Y : maxRangeY);
 
-	const auto &it = spectatorsCache.find(centerPos);
-	const bool cacheFound = it != spectatorsCache.end();
-	if (cacheFound) {
-		auto &cache = it->second;
-		if (minRangeX < cache.minRangeX || maxRangeX > cache.maxRangeX || minRangeY < cache.minRangeY || maxRangeY > cache.maxRangeY) {
-			// recache with new range
-			cache.minRangeX = minRangeX = std::min<int32_t>(minRangeX, cache.minRangeX);
-			cache.minRangeY = minRangeY = std::min<int32_t>(minRangeY, cache.minRangeY);
-			cache.maxRangeX = maxRangeX = std::max<int32_t>(maxRangeX, cache.maxRangeX);
-			cache.maxRangeY = maxRangeY = std::max<int32_t>(maxRangeY, cache.maxRangeY);
-		} else {
-			const bool checkDistance = minRangeX != cache.minRangeX || maxRangeX != cache.maxRangeX || minRangeY != cache.minRangeY || maxRangeY != cache.maxRangeY;
-
-			if (onlyPlayers) {
-				// check players cache
-				if (checkCache(cache.players, true, centerPos, checkDistance, multifloor, minRangeX, maxRangeX, minRangeY, maxRangeY)) {
-					return *this;
-				}
-
-				// if there is no player cache, look for players in the creatures cache.
-				if (checkCache(cache.creatures, true, centerPos, true, multifloor, minRangeX, maxRangeX, minRangeY, maxRangeY)) {
-					return *this;
-				}
-
-				// All Creatures
-			} else if (checkCache(cache.creatures, false, centerPos, checkDistance, multifloor, minRangeX, maxRangeX, minRangeY, maxRangeY)) {
-				return *this;
-			}
-		}
-	}
-
-	uint8_t minRangeZ = centerPos.z;
-	uint8_t maxRangeZ = centerPos.z;
+	Range range;
+	range.z = centerPos.z;
+	range.minZ = centerPos.z;
+	range.maxZ = centerPos.z;
 
 	if (multifloor) {
 		if (centerPos.z > MAP_INIT_SURFACE_LAYER) {
-			minRangeZ = static_cast<uint8_t>(std::max<int8_t>(centerPos.z - MAP_LAYER_VIEW_LIMIT, 0u));
-			maxRangeZ = static_cast<uint8_t>(std::min<int8_t>(centerPos.z + MAP_LAYER_VIEW_LIMIT, MAP_MAX_LAYERS - 1));
+			range.minZ = static_cast<uint8_t>(std::max<int8_t>(centerPos.z - MAP_LAYER_VIEW_LIMIT, 0u));
+			range.maxZ = static_cast<uint8_t>(std::min<int8_t>(centerPos.z + MAP_LAYER_VIEW_LIMIT, MAP_MAX_LAYERS - 1));
 		} else if (centerPos.z == MAP_INIT_SURFACE_LAYER - 1) {
-			minRangeZ = 0;
-			maxRangeZ = (MAP_INIT_SURFACE_LAYER - 1) + MAP_LAYER_VIEW_LIMIT;
+			range.minZ = 0;
+			range.maxZ = (MAP_INIT_SURFACE_LAYER - 1) + MAP_LAYER_VIEW_LIMIT;
 		} else if (centerPos.z == MAP_INIT_SURFACE_LAYER) {
-			minRangeZ = 0;
-			maxRangeZ = MAP_INIT_SURFACE_LAYER + MAP_LAYER_VIEW_LIMIT;
+			range.minZ = 0;
+			range.maxZ = MAP_INIT_SURFACE_LAYER + MAP_LAYER_VIEW_LIMIT;
 		} else {
-			minRangeZ = 0;
-			maxRangeZ = MAP_INIT_SURFACE_LAYER;
+			range.minZ = 0;
+			range.maxZ = MAP_INIT_SURFACE_LAYER;
 		}
 	}
 
-	const int32_t min_y = centerPos.y + minRangeY;
-	const int32_t min_x = centerPos.x + minRangeX;
-	const int32_t max_y = centerPos.y + maxRangeY;
-	const int32_t max_x = centerPos.x + maxRangeX;
+	range.minX = centerPos.x + minRangeX;
+	range.minY = centerPos.y + minRangeY;
+	range.maxX = centerPos.x + maxRangeX;
+	range.maxY = centerPos.y + maxRangeY;
+	return range;
+}
+
+bool Spectators::Range::contains(const Position &pos) const {
+	if (pos.z < minZ || pos.z > maxZ) {
+		return false;
+	}
+
+	// The other floors are seen shifted by their distance to the center floor
+	const int_fast16_t offsetZ = z - pos.z;
+	return static_cast<uint32_t>(pos.x - offsetZ - minX) <= static_cast<uint32_t>(maxX - minX) && static_cast<uint32_t>(pos.y - offsetZ - minY) <= static_cast<uint32_t>(maxY - minY);
+}
+
+bool Spectators::Range::contains(const Range &other) const {
+	// Same center floor, so both shift every floor the same way
+	return other.z == z && other.minZ >= minZ && other.maxZ <= maxZ && other.minX >= minX && other.maxX <= maxX && other.minY >= minY && other.maxY <= maxY;
+}
+
+void Spectators::forEachInRange(const Position &centerPos, bool multifloor, bool onlyPlayers, int32_t minRangeX, int32_t maxRangeX, int32_t minRangeY, int32_t maxRangeY, const Visitor &visitor) {
+	const auto range = getRange(centerPos, multifloor, minRangeX, maxRangeX, minRangeY, maxRangeY);
 
-	const auto width = static_cast<uint32_t>(max_x - min_x);
-	const auto height = static_cast<uint32_t>(max_y - min_y);
-	const auto depth = static_cast<uint32_t>(maxRangeZ - minRangeZ);
+	// Inside the range of the combat cast being run, its players are filtered instead of walking the sectors
+	if (onlyPlayers) {
+		if (const auto* scope = SpectatorScope::active; scope && scope->range.contains(range)) {
+			for (const auto &creature : scope->players) {
+				if (!creature->isRemoved() && range.contains(creature->getPosition())) {
+					visitor(creature);
+				}
+			}
+			return;
+		}
+	}
 
-	const int32_t minoffset = centerPos.getZ() - maxRangeZ;
-	const int32_t x1 = std::min<int32_t>(0xFFFF, std::max<int32_t>(0, min_x + minoffset));
-	const int32_t y1 = std::min<int32_t>(0xFFFF, std::max<int32_t>(0, min_y + minoffset));
+	const int32_t minoffset = centerPos.getZ() - range.maxZ;
+	const int32_t x1 = std::min<int32_t>(0xFFFF, std::max<int32_t>(0, range.minX + minoffset));
+	const int32_t y1 = std::min<int32_t>(0xFFFF, std::max<int32_t>(0, range.minY + minoffset));
 
-	const int32_t maxoffset = centerPos.getZ() - minRangeZ;
-	const int32_t x2 = std::min<int32_t>(0xFFFF, std::max<int32_t>(0, max_x + maxoffset));
-	const int32_t y2 = std::min<int32_t>(0xFFFF, std::max<int32_t>(0, max_y + maxoffset));
+	const int32_t maxoffset = centerPos.getZ() - range.minZ;
+	const int32_t x2 = std::min<int32_t>(0xFFFF, std::max<int32_t>(0, range.maxX + maxoffset));
+	const int32_t y2 = std::min<int32_t>(0xFFFF, std::max<int32_t>(0, range.maxY + maxoffset));
 
 	const int32_t startx1 = x1 - (x1 & SECTOR_MASK);
 	const int32_t starty1 = y1 - (y1 & SECTOR_MASK);
 	const int32_t endx2 = x2 - (x2 & SECTOR_MASK);
 	const int32_t endy2 = y2 - (y2 & SECTOR_MASK);
 
-	CreatureVector spectators;
-	spectators.reserve(std::max<uint8_t>(MAP_MAX_VIEW_PORT_X, MAP_MAX_VIEW_PORT_Y) * 2);
+	// Floors in range, sectors without a creature on any of them are skipped without touching their lists
+	const uint16_t floorMask = static_cast<uint16_t>(((1u << (range.maxZ + 1)) - 1) & ~((1u << range.minZ) - 1));
 
 	const MapSector* startSector = g_game().map.getMapSector(startx1, starty1);
 	const MapSector* sectorS = startSector;
@@ -162,13 +140,11 @@ Spectators Spectators::find(const Position &centerPos, bool multifloor, bool onl
 		const MapSector* sectorE = sectorS;
 		for (int32_t nx = startx1; nx <= endx2; nx += SECTOR_SIZE) {
 			if (sectorE) {
-				const auto &node_list = onlyPlayers ? sectorE->player_list : sectorE->creature_list;
-				for (const auto &creature : node_list) {
-					const auto &cpos = creature->getPosition();
-					if (static_cast<uint32_t>(static_cast<int32_t>(cpos.z) - minRangeZ) <= depth) {
-						const int_fast16_t offsetZ = Position::getOffsetZ(centerPos, cpos);
-						if (static_cast<uint32_t>(cpos.x - offsetZ - min_x) <= width && static_cast<uint32_t>(cpos.y - offsetZ - min_y) <= height) {
-							spectators.emplace_back(creature);
+				if ((sectorE->getOccupiedFloors(onlyPlayers) & floorMask) != 0) {
+					// Only the creatures of the floors in range
+					for (const auto &creature : sectorE->getCreatures(onlyPlayers, range.minZ, range.maxZ)) {
+						if (range.contains(creature->getPosition())) {
+							visitor(creature);
 						}
 					}
 				}
@@ -184,22 +160,18 @@ Spectators Spectators::find(const Position &centerPos, bool multifloor, bool onl
 			sectorS = g_game().map.getMapSector(startx1, ny + SECTOR_SIZE);
 		}
 	}
+}
 
-	// It is necessary to create the cache even if no spectators is found, so that there is no future query.
-	auto &cache = cacheFound ? it->second : spectatorsCache.emplace(centerPos, SpectatorsCache { .minRangeX = minRangeX, .maxRangeX = maxRangeX, .minRangeY = minRangeY, .maxRangeY = maxRangeY, .creatures = {}, .players = {} }).first->second;
-	auto &creaturesCache = onlyPlayers ? cache.players : cache.creatures;
-	auto &creatureList = (multifloor ? creaturesCache.multiFloor : creaturesCache.floor);
-	if (creatureList) {
-		creatureList->clear();
-	} else {
-		creatureList.emplace();
-	}
-
-	if (!spectators.empty()) {
-		insertAll(spectators);
+thread_local SpectatorScope* SpectatorScope::active = nullptr;
 
-		creatureList->insert(creatureList->end(), spectators.begin(), spectators.end());
-	}
+SpectatorScope::SpectatorScope(const Position &centerPos, int32_t rangeX, int32_t rangeY) :
+	range(Spectators::getRange(centerPos, true, rangeX, rangeX, rangeY, rangeY)) {
+	// Found before it becomes the active one, and the enclosing cast may already have them
+	players.find<Player>(centerPos, true, rangeX, rangeX, rangeY, rangeY);
+	previous = active;
+	active = this;
+}
 
-	return *this;
+SpectatorScope::~SpectatorScope() {
+	active = previous;
 }
@@ -10,45 +10,59 @@
 #pragma once
 
 #include "creatures/creature.hpp"
+#include "utils/inline_function.hpp"
 
 class Player;
 class Monster;
 class Npc;
 struct Position;
 
-struct SpectatorsCache {
-	struct FloorData {
-		std::optional<CreatureVector> floor;
-		std::optional<CreatureVector> multiFloor;
-	};
-
-	int32_t minRangeX { 0 };
-	int32_t maxRangeX { 0 };
-	int32_t minRangeY { 0 };
-	int32_t maxRangeY { 0 };
-
-	FloorData creatures;
-	FloorData players;
-};
-
 class Spectators {
 public:
-	static void clearCache();
+	template <typename T>
+		requires std::is_same_v<Creature, T> || std::is_same_v<Player, T>
+	Spectators &find(const Position &centerPos, bool multifloor = false, int32_t minRangeX = 0, int32_t maxRangeX = 0, int32_t minRangeY = 0, int32_t maxRangeY = 0) & {
+		constexpr bool onlyPlayers = std::is_same_v<T, Player>;
+		findInRange(centerPos, multifloor, onlyPlayers, minRangeX, maxRangeX, minRangeY, maxRangeY);
+		return *this;
+	}
 
+	// Spectators().find<T>(...) moves the result out instead of copying it
 	template <typename T>
 		requires std::is_same_v<Creature, T> || std::is_same_v<Player, T>
-	Spectators find(const Position &centerPos, bool multifloor = false, int32_t minRangeX = 0, int32_t maxRangeX = 0, int32_t minRangeY = 0, int32_t maxRangeY = 0) {
+	Spectators find(const Position &centerPos, bool multifloor = false, int32_t minRangeX = 0, int32_t maxRangeX = 0, int32_t minRangeY = 0, int32_t maxRangeY = 0) && {
 		constexpr bool onlyPlayers = std::is_same_v<T, Player>;
-		return find(centerPos, multifloor, onlyPlayers, minRangeX, maxRangeX, minRangeY, maxRangeY);
+		findInRange(centerPos, multifloor, onlyPlayers, minRangeX, maxRangeX, minRangeY, maxRangeY);
+		return std::move(*this);
+	}
+
+	/**
+	 * Calls fn with every spectator in range, like find<T> but without building a result,
+	 * so there is no allocation and no shared_ptr copy per spectator.
+	 * fn must not move or remove creatures, the sector lists are iterated in place.
+	 */
+	template <typename T, typename F>
+		requires(std::is_same_v<Creature, T> || std::is_same_v<Player, T>) && std::is_invocable_v<F &, T &>
+	static void forEach(const Position &centerPos, bool multifloor, int32_t minRangeX, int32_t maxRangeX, int32_t minRangeY, int32_t maxRangeY, F &&fn) {
+		constexpr bool onlyPlayers = std::is_same_v<T, Player>;
+		forEachInRange(centerPos, multifloor, onlyPlayers, minRangeX, maxRangeX, minRangeY, maxRangeY, [&fn](const std::shared_ptr<Creature> &creature) {
+			fn(static_cast<T &>(*creature));
+		});
+	}
+
+	template <typename T, typename F>
+		requires(std::is_same_v<Creature, T> || std::is_same_v<Player, T>) && std::is_invocable_v<F &, T &>
+	static void forEach(const Position &centerPos, bool multifloor, F &&fn) {
+		forEach<T>(centerPos, multifloor, 0, 0, 0, 0, std::forward<F>(fn));
 	}
 
 	template <typename T>
 		requires std::is_base_of_v<Creature, T>
 	Spectators filter();
 
-	Spectators insert(const std::shared_ptr<Creature> &creature);
-	Spectators insertAll(const CreatureVector &list);
-	Spectators join(const Spectators &anotherSpectators) {
+	Spectators &insert(const std::shared_ptr<Creature> &creature);
+	Spectators &insertAll(const CreatureVector &list);
+	Spectators &join(const Spectators &anotherSpectators) {
 		return insertAll(anotherSpectators.creatures);
 	}
 
@@ -81,14 +95,60 @@ public:
 	}
 
 private:
-	static phmap::flat_hash_map<Position, SpectatorsCache> spectatorsCache;
+	friend class SpectatorScope;
+
+	using Visitor = stdext::inline_function<void(const std::shared_ptr<Creature> &)>;
+
+	// The positions a search sees, the bounds are the ones of the center floor
+	struct Range {
+		int32_t minX = 0;
+		int32_t minY = 0;
+		int32_t maxX = 0;
+		int32_t maxY = 0;
+		uint8_t minZ = 0;
+		uint8_t maxZ = 0;
+		uint8_t z = 0;
+
+		bool contains(const Position &pos) const;
+		bool contains(const Range &other) const;
+	};
+
+	static Range getRange(const Position &centerPos, bool multifloor, int32_t minRangeX, int32_t maxRangeX, int32_t minRangeY, int32_t maxRangeY);
 
-	Spectators find(const Position &centerPos, bool multifloor = false, bool onlyPlayers = false, int32_t minRangeX = 0, int32_t maxRangeX = 0, int32_t minRangeY = 0, int32_t maxRangeY = 0);
-	bool checkCache(const SpectatorsCache::FloorData &specData, bool onlyPlayers, const Position &centerPos, bool checkDistance, bool multifloor, int32_t minRangeX, int32_t maxRangeX, int32_t minRangeY, int32_t maxRangeY);
+	void findInRange(const Position &centerPos, bool multifloor, bool onlyPlayers, int32_t minRangeX, int32_t maxRangeX, int32_t minRangeY, int32_t maxRangeY);
+	static void forEachInRange(const Position &centerPos, bool multifloor, bool onlyPlayers, int32_t minRangeX, int32_t maxRangeX, int32_t minRangeY, int32_t maxRangeY, const Visitor &visitor);
 
 	CreatureVector creatures;
 };
 
+/**
+ * The players of a whole combat cast, found once. While it is alive, the player searches of the thread
+ * that fall inside its range filter them instead of walking the map sectors again.
+ * Players that enter the range during the cast are not seen by those searches.
+ */
+class SpectatorScope {
+public:
+	SpectatorScope(const Position &centerPos, int32_t rangeX, int32_t rangeY);
+	~SpectatorScope();
+
+	// non-copyable
+	SpectatorScope(const SpectatorScope &) = delete;
+	SpectatorScope &operator=(const SpectatorScope &) = delete;
+
+	const CreatureVector &data() const noexcept {
+		return players.data();
+	}
+
+private:
+	friend class Spectators;
+
+	static thread_local SpectatorScope* active;
+
+	Spectators::Range range;
+	Spectators players;
+	SpectatorScope* previous = nullptr;
+};
+
 template <typename T>
 	requires std::is_base_of_v<Creature, T>
 Spectators Spectators::filter() {
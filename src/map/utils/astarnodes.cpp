@@ -257,6 +257,73 @@ AStarNode* AStarNodes::getNodeByPosition(uint32_t x, uint32_t y) {
 #endif
 }
 
+AStarHeapNodes::AStarHeapNodes(uint32_t x, uint32_t y, int_fast32_t extraCost, uint32_t maxNodes) :
+	maxNodes(std::max<uint32_t>(maxNodes, 1)) {
+	nodes.reserve(this->maxNodes);
+	openNodes.reserve(this->maxNodes);
+	nodesIndex.reserve(this->maxNodes);
+
+	createOpenNode(nullptr, x, y, 0, 0, extraCost);
+}
+
+bool AStarHeapNodes::createOpenNode(AStarNode* parent, uint32_t x, uint32_t y, int_fast32_t f, int_fast32_t heuristic, int_fast32_t extraCost) {
+	if (nodes.size() >= maxNodes) {
+		return false;
+	}
+
+	const auto index = static_cast<uint32_t>(nodes.size());
+	AStarNode &node = nodes.emplace_back();
+	node.parent = parent;
+	node.x = x;
+	node.y = y;
+	node.f = f;
+	node.g = heuristic;
+	node.c = extraCost;
+	openNodes.emplace_back(true);
+	nodesIndex.emplace((x << 16) | y, index);
+	pushOpenEntry(index);
+	return true;
+}
+
+void AStarHeapNodes::pushOpenEntry(uint32_t index) {
+	openHeap.push_back({ nodes[index].f + nodes[index].g, index });
+	std::push_heap(openHeap.begin(), openHeap.end());
+}
+
+AStarNode* AStarHeapNodes::getBestNode() {
+	while (!openHeap.empty()) {
+		const auto entry = openHeap.front();
+		std::pop_heap(openHeap.begin(), openHeap.end());
+		openHeap.pop_back();
+
+		const auto &node = nodes[entry.index];
+		if (openNodes[entry.index] && node.f + node.g == entry.cost) {
+			return &nodes[entry.index];
+		}
+	}
+	return nullptr;
+}
+
+void AStarHeapNodes::closeNode(const AStarNode* node) {
+	const size_t index = node - nodes.data();
+	assert(index < nodes.size());
+	openNodes[index] = false;
+	++closedNodes;
+}
+
+void AStarHeapNodes::openNode(const AStarNode* node) {
+	const size_t index = node - nodes.data();
+	assert(index < nodes.size());
+	closedNodes -= (openNodes[index] ? 0 : 1);
+	openNodes[index] = true;
+	pushOpenEntry(static_cast<uint32_t>(index));
+}
+
+AStarNode* AStarHeapNodes::getNodeByPosition(uint32_t x, uint32_t y) {
+	const auto it = nodesIndex.find((x << 16) | y);
+	return it != nodesIndex.end() ? &nodes[it->second] : nullptr;
+}
+
 int_fast32_t AStarNodes::getMapWalkCost(AStarNode* node, const Position &neighborPos) {
 	// diagonal movement extra cost
 	return (((std::abs(node->x - neighborPos.x) + std::abs(node->y - neighborPos.y)) - 1) * MAP_DIAGONALWALKCOST) + MAP_NORMALWALKCOST;
@@ -28,6 +28,9 @@ public:
 	void closeNode(const AStarNode* node);
 	void openNode(const AStarNode* node);
 	int32_t getClosedNodes() const;
+	int32_t getMaxClosedNodes() const {
+		return MAX_CLOSED_NODES;
+	}
 	AStarNode* getNodeByPosition(uint32_t x, uint32_t y);
 
 	static int_fast32_t getMapWalkCost(AStarNode* node, const Position &neighborPos);
@@ -35,6 +38,7 @@ public:
 
 private:
 	static constexpr int32_t MAX_NODES = 512;
+	static constexpr int32_t MAX_CLOSED_NODES = 100;
 	static constexpr int32_t MAP_NORMALWALKCOST = 10;
 	static constexpr int32_t MAP_PREFERDIAGONALWALKCOST = 14;
 	static constexpr int32_t MAP_DIAGONALWALKCOST = 25;
@@ -51,3 +55,47 @@ private:
 	int32_t curNode;
 	bool openNodes[MAX_NODES];
 };
+
+/**
+ * Node storage with the same interface as AStarNodes, for long searches (see pathfindingLongDistance).
+ * Open nodes are kept in a binary heap and nodes are found by position through a hash index,
+ * so the cost per node does not grow with the number of nodes and the budget can be much bigger.
+ */
+class AStarHeapNodes {
+public:
+	AStarHeapNodes(uint32_t x, uint32_t y, int_fast32_t extraCost, uint32_t maxNodes);
+
+	bool createOpenNode(AStarNode* parent, uint32_t x, uint32_t y, int_fast32_t f, int_fast32_t heuristic, int_fast32_t extraCost);
+	AStarNode* getBestNode();
+	void closeNode(const AStarNode* node);
+	void openNode(const AStarNode* node);
+	int32_t getClosedNodes() const {
+		return closedNodes;
+	}
+	int32_t getMaxClosedNodes() const {
+		return static_cast<int32_t>(maxNodes);
+	}
+	AStarNode* getNodeByPosition(uint32_t x, uint32_t y);
+
+private:
+	struct OpenEntry {
+		int_fast32_t cost;
+		uint32_t index;
+
+		// Min heap, ties go to the oldest node like in AStarNodes
+		bool operator<(const OpenEntry &other) const {
+			return cost != other.cost ? cost > other.cost : index > other.index;
+		}
+	};
+
+	void pushOpenEntry(uint32_t index);
+
+	// Reserved up front, nodes keep pointers to their parent
+	std::vector<AStarNode> nodes;
+	std::vector<bool> openNodes;
+	// Entries of nodes that were closed or got cheaper are stale, they are skipped when popped
+	std::vector<OpenEntry> openHeap;
+	phmap::flat_hash_map<uint32_t, uint32_t> nodesIndex;
+	uint32_t maxNodes;
+	int32_t closedNodes = 0;
+};
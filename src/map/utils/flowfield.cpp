@@ -0,0 +1,138 @@
+/**
+ * Canary - A free and open-source MMORPG server emulator
+ * Copyright (©) 2019-2024 OpenTibiaBR <opentibiabr@outlook.com>
+ * Repository: https://github.com/opentibiabr/canary
+ * License: https://github.com/opentibiabr/canary/blob/main/LICENSE
+ * Contributors: https://github.com/opentibiabr/canary/graphs/contributors
+ * Website: https://docs.opentibiabr.com/
+ */
+
+#include "pch.hpp"
+
+#include "map/utils/flowfield.hpp"
+#include "creatures/creature.hpp"
+#include "game/game.hpp"
+
+// A field is rebuilt after this, even if no tile around it changed, so monsters do not keep walking an old one
+static constexpr int64_t FLOW_FIELD_LIFETIME = 500;
+
+std::shared_mutex FlowField::fieldsMutex;
+phmap::flat_hash_map<Position, std::shared_ptr<const FlowField>> FlowField::fields;
+
+FlowField::FlowField(const Position &target, int32_t radius) :
+	target(target), radius(radius), size(radius * 2 + 1), createdAt(OTSYS_TIME()) {
+	build();
+}
+
+std::shared_ptr<const FlowField> FlowField::get(const Position &target, int32_t radius) {
+	const int64_t now = OTSYS_TIME();
+	{
+		std::shared_lock lock(fieldsMutex);
+		if (const auto it = fields.find(target); it != fields.end() && it->second->radius == radius && now - it->second->createdAt < FLOW_FIELD_LIFETIME) {
+			return it->second;
+		}
+	}
+
+	std::unique_lock lock(fieldsMutex);
+	// Another task may have built it meanwhile
+	auto &field = fields[target];
+	if (!field || field->radius != radius || now - field->createdAt >= FLOW_FIELD_LIFETIME) {
+		field = std::make_shared<const FlowField>(target, radius);
+	}
+	const auto result = field;
+
+	std::erase_if(fields, [now](const auto &entry) {
+		return now - entry.second->createdAt >= FLOW_FIELD_LIFETIME;
+	});
+	return result;
+}
+
+void FlowField::invalidate(const Position &pos) {
+	std::unique_lock lock(fieldsMutex);
+	if (fields.empty()) {
+		return;
+	}
+
+	std::erase_if(fields, [&pos](const auto &entry) {
+		return entry.second->contains(pos);
+	});
+}
+
+bool FlowField::contains(const Position &pos) const {
+	return pos.z == target.z && Position::getDistanceX(pos, target) <= radius && Position::getDistanceY(pos, target) <= radius;
+}
+
+uint16_t FlowField::getCost(const Position &pos) const {
+	return contains(pos) ? costs[getIndex(pos)] : UNREACHABLE;
+}
+
+void FlowField::build() {
+	costs.assign(static_cast<size_t>(size) * size, UNREACHABLE);
+
+	using Entry = std::pair<uint16_t, Position>;
+	const auto compare = [](const Entry &a, const Entry &b) { return a.first > b.first; };
+	std::priority_queue<Entry, std::vector<Entry>, decltype(compare)> open(compare);
+
+	costs[getIndex(target)] = 0;
+	open.emplace(0, target);
+
+	while (!open.empty()) {
+		const auto [cost, pos] = open.top();
+		open.pop();
+		if (cost != costs[getIndex(pos)]) {
+			continue;
+		}
+
+		for (uint8_t i = DIRECTION_NORTH; i <= DIRECTION_NORTHEAST; ++i) {
+			const auto neighborPos = getNextPosition(static_cast<Direction>(i), pos);
+			if (!contains(neighborPos)) {
+				continue;
+			}
+
+			const auto &tile = g_game().map.getTile(neighborPos);
+			if (!tile || !tile->getGround() || tile->hasFlag(TILESTATE_BLOCKSOLID | TILESTATE_IMMOVABLEBLOCKPATH | TILESTATE_FLOORCHANGE | TILESTATE_TELEPORT | TILESTATE_PROTECTIONZONE)) {
+				continue;
+			}
+
+			uint32_t newCost = cost + ((i & DIRECTION_DIAGONAL_MASK) ? DIAGONAL_WALK_COST : NORMAL_WALK_COST);
+			if (tile->hasFlag(TILESTATE_MAGICFIELD)) {
+				newCost += FIELD_WALK_COST;
+			}
+
+			auto &neighborCost = costs[getIndex(neighborPos)];
+			if (newCost < neighborCost) {
+				neighborCost = static_cast<uint16_t>(newCost);
+				open.emplace(neighborCost, neighborPos);
+			}
+		}
+	}
+}
+
+bool FlowField::getNextStep(const std::shared_ptr<Creature> &creature, Direction &dir) const {
+	const auto &pos = creature->getPosition();
+	const auto cost = getCost(pos);
+	if (cost == UNREACHABLE) {
+		return false;
+	}
+
+	std::array<std::pair<uint32_t, Direction>, 8> candidates;
+	size_t count = 0;
+	for (uint8_t i = DIRECTION_NORTH; i <= DIRECTION_NORTHEAST; ++i) {
+		const auto neighborCost = getCost(getNextPosition(static_cast<Direction>(i), pos));
+		if (neighborCost >= cost) {
+			continue;
+		}
+
+		const uint32_t stepCost = (i & DIRECTION_DIAGONAL_MASK) ? DIAGONAL_WALK_COST : NORMAL_WALK_COST;
+		candidates[count++] = { neighborCost + stepCost, static_cast<Direction>(i) };
+	}
+
+	std::sort(candidates.begin(), candidates.begin() + count);
+	for (size_t i = 0; i < count; ++i) {
+		if (g_game().map.canWalkTo(creature, getNextPosition(candidates[i].second, pos))) {
+			dir = candidates[i].second;
+			return true;
+		}
+	}
+	return false;
+}
@@ -0,0 +1,57 @@
+/**
+ * Canary - A free and open-source MMORPG server emulator
+ * Copyright (©) 2019-2024 OpenTibiaBR <opentibiabr@outlook.com>
+ * Repository: https://github.com/opentibiabr/canary
+ * License: https://github.com/opentibiabr/canary/blob/main/LICENSE
+ * Contributors: https://github.com/opentibiabr/canary/graphs/contributors
+ * Website: https://docs.opentibiabr.com/
+ */
+
+#pragma once
+
+#include "game/movement/position.hpp"
+
+class Creature;
+
+/**
+ * Walking cost to a target from every tile in a radius around it (Dijkstra map), shared by the monsters
+ * chasing that target, so each of them only picks its next step instead of running A* (see flowFieldRadius).
+ * Creatures on the way are ignored while building it, the step is still checked with Map::canWalkTo.
+ */
+class FlowField {
+public:
+	static constexpr uint16_t UNREACHABLE = std::numeric_limits<uint16_t>::max();
+
+	FlowField(const Position &target, int32_t radius);
+
+	/**
+	 * Returns a recent field of the target position, or builds it. Safe to call from parallel tasks.
+	 */
+	static std::shared_ptr<const FlowField> get(const Position &target, int32_t radius);
+	// Drops the fields covering pos, called when the walkability of its tile changes
+	static void invalidate(const Position &pos);
+
+	bool contains(const Position &pos) const;
+	uint16_t getCost(const Position &pos) const;
+	bool getNextStep(const std::shared_ptr<Creature> &creature, Direction &dir) const;
+
+private:
+	static constexpr uint16_t NORMAL_WALK_COST = 10;
+	static constexpr uint16_t DIAGONAL_WALK_COST = 25;
+	static constexpr uint16_t FIELD_WALK_COST = NORMAL_WALK_COST * 18;
+
+	size_t getIndex(const Position &pos) const {
+		return static_cast<size_t>(pos.y - target.y + radius) * size + (pos.x - target.x + radius);
+	}
+
+	void build();
+
+	Position target;
+	int32_t radius;
+	int32_t size;
+	int64_t createdAt;
+	std::vector<uint16_t> costs;
+
+	static std::shared_mutex fieldsMutex;
+	static phmap::flat_hash_map<Position, std::shared_ptr<const FlowField>> fields;
+};
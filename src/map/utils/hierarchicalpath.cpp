@@ -0,0 +1,258 @@
+/**
+ * Canary - A free and open-source MMORPG server emulator
+ * Copyright (©) 2019-2024 OpenTibiaBR <opentibiabr@outlook.com>
+ * Repository: https://github.com/opentibiabr/canary
+ * License: https://github.com/opentibiabr/canary/blob/main/LICENSE
+ * Contributors: https://github.com/opentibiabr/canary/graphs/contributors
+ * Website: https://docs.opentibiabr.com/
+ */
+
+#include "pch.hpp"
+
+#include "map/utils/hierarchicalpath.hpp"
+#include "game/game.hpp"
+
+std::shared_mutex HierarchicalPath::sectorsMutex;
+phmap::flat_hash_map<uint64_t, std::shared_ptr<const HierarchicalPath::Sector>> HierarchicalPath::sectors;
+
+static constexpr uint32_t UNREACHABLE_COST = std::numeric_limits<uint32_t>::max();
+
+bool HierarchicalPath::isWalkable(const Position &pos) {
+	const auto &tile = g_game().map.getTile(pos);
+	return tile && tile->getGround() && !tile->hasFlag(TILESTATE_BLOCKSOLID | TILESTATE_IMMOVABLEBLOCKPATH | TILESTATE_FLOORCHANGE | TILESTATE_TELEPORT);
+}
+
+std::array<uint32_t, SECTOR_SIZE * SECTOR_SIZE> HierarchicalPath::getSectorCosts(const Position &pos) {
+	const int32_t originX = pos.x & ~SECTOR_MASK;
+	const int32_t originY = pos.y & ~SECTOR_MASK;
+	const auto getIndex = [originX, originY](int32_t x, int32_t y) {
+		return static_cast<size_t>(y - originY) * SECTOR_SIZE + (x - originX);
+	};
+
+	std::array<uint32_t, SECTOR_SIZE * SECTOR_SIZE> costs;
+	costs.fill(UNREACHABLE_COST);
+
+	using Entry = std::pair<uint32_t, Position>;
+	const auto compare = [](const Entry &a, const Entry &b) { return a.first > b.first; };
+	std::priority_queue<Entry, std::vector<Entry>, decltype(compare)> open(compare);
+
+	costs[getIndex(pos.x, pos.y)] = 0;
+	open.emplace(0, pos);
+	while (!open.empty()) {
+		const auto [cost, current] = open.top();
+		open.pop();
+		if (cost != costs[getIndex(current.x, current.y)]) {
+			continue;
+		}
+
+		for (uint8_t i = DIRECTION_NORTH; i <= DIRECTION_NORTHEAST; ++i) {
+			const auto next = getNextPosition(static_cast<Direction>(i), current);
+			if (next.x < originX || next.x >= originX + SECTOR_SIZE || next.y < originY || next.y >= originY + SECTOR_SIZE || !isWalkable(next)) {
+				continue;
+			}
+
+			const uint32_t newCost = cost + ((i & DIRECTION_DIAGONAL_MASK) ? DIAGONAL_WALK_COST : NORMAL_WALK_COST);
+			auto &nextCost = costs[getIndex(next.x, next.y)];
+			if (newCost < nextCost) {
+				nextCost = newCost;
+				open.emplace(newCost, next);
+			}
+		}
+	}
+	return costs;
+}
+
+std::shared_ptr<const HierarchicalPath::Sector> HierarchicalPath::buildSector(const Position &origin) {
+	auto sector = std::make_shared<Sector>();
+
+	// Portals and the tile across the border of each: west, east, north and south sides
+	std::vector<std::pair<Position, Position>> portals;
+	const auto addSide = [&portals](Position inside, Position outside, int32_t stepX, int32_t stepY) {
+		int32_t runStart = -1;
+		for (int32_t i = 0; i <= SECTOR_SIZE; ++i) {
+			const Position a(inside.x + stepX * i, inside.y + stepY * i, inside.z);
+			const Position b(outside.x + stepX * i, outside.y + stepY * i, outside.z);
+			const bool open = i < SECTOR_SIZE && isWalkable(a) && isWalkable(b);
+			if (open && runStart < 0) {
+				runStart = i;
+			} else if (!open && runStart >= 0) {
+				const int32_t middle = (runStart + i - 1) / 2;
+				portals.emplace_back(
+					Position(inside.x + stepX * middle, inside.y + stepY * middle, inside.z),
+					Position(outside.x + stepX * middle, outside.y + stepY * middle, outside.z)
+				);
+				runStart = -1;
+			}
+		}
+	};
+
+	const int32_t x = origin.x;
+	const int32_t y = origin.y;
+	const int32_t last = SECTOR_SIZE - 1;
+	if (x > 0) {
+		addSide(Position(x, y, origin.z), Position(x - 1, y, origin.z), 0, 1);
+	}
+	if (x + SECTOR_SIZE <= std::numeric_limits<uint16_t>::max()) {
+		addSide(Position(x + last, y, origin.z), Position(x + SECTOR_SIZE, y, origin.z), 0, 1);
+	}
+	if (y > 0) {
+		addSide(Position(x, y, origin.z), Position(x, y - 1, origin.z), 1, 0);
+	}
+	if (y + SECTOR_SIZE <= std::numeric_limits<uint16_t>::max()) {
+		addSide(Position(x, y + last, origin.z), Position(x, y + SECTOR_SIZE, origin.z), 1, 0);
+	}
+
+	for (const auto &[portal, across] : portals) {
+		auto &edges = sector->edges[getKey(portal)];
+		edges.push_back({ getKey(across), NORMAL_WALK_COST, true });
+
+		const auto costs = getSectorCosts(portal);
+		for (const auto &[other, otherAcross] : portals) {
+			const auto cost = costs[static_cast<size_t>(other.y - y) * SECTOR_SIZE + (other.x - x)];
+			if (other != portal && cost != UNREACHABLE_COST) {
+				edges.push_back({ getKey(other), cost, false });
+			}
+		}
+	}
+	return sector;
+}
+
+std::shared_ptr<const HierarchicalPath::Sector> HierarchicalPath::getSector(const Position &pos) {
+	const auto key = getSectorKey(pos);
+	{
+		std::shared_lock lock(sectorsMutex);
+		if (const auto it = sectors.find(key); it != sectors.end()) {
+			return it->second;
+		}
+	}
+
+	// Built outside of the lock, two tasks may build the same sector and the last one is kept
+	const auto sector = buildSector(Position(pos.x & ~SECTOR_MASK, pos.y & ~SECTOR_MASK, pos.z));
+	std::unique_lock lock(sectorsMutex);
+	sectors[key] = sector;
+	return sector;
+}
+
+void HierarchicalPath::invalidate(const Position &pos) {
+	std::unique_lock lock(sectorsMutex);
+	if (sectors.empty()) {
+		return;
+	}
+
+	sectors.erase(getSectorKey(pos));
+	// The portals of the sectors next to a border tile depend on it too
+	const int32_t localX = pos.x & SECTOR_MASK;
+	const int32_t localY = pos.y & SECTOR_MASK;
+	if (localX == 0 && pos.x > 0) {
+		sectors.erase(getSectorKey(Position(pos.x - 1, pos.y, pos.z)));
+	} else if (localX == SECTOR_MASK && pos.x < std::numeric_limits<uint16_t>::max()) {
+		sectors.erase(getSectorKey(Position(pos.x + 1, pos.y, pos.z)));
+	}
+	if (localY == 0 && pos.y > 0) {
+		sectors.erase(getSectorKey(Position(pos.x, pos.y - 1, pos.z)));
+	} else if (localY == SECTOR_MASK && pos.y < std::numeric_limits<uint16_t>::max()) {
+		sectors.erase(getSectorKey(Position(pos.x, pos.y + 1, pos.z)));
+	}
+}
+
+bool HierarchicalPath::findWaypoints(const Position &start, const Position &goal, std::vector<Position> &waypoints) {
+	if (start.z != goal.z) {
+		return false;
+	}
+
+	if (getSectorKey(start) == getSectorKey(goal)) {
+		waypoints.clear();
+		return true;
+	}
+
+	// Portals of the start and goal sectors, with the cost from start and to goal
+	const auto startSector = getSector(start);
+	const auto goalSector = getSector(goal);
+	const auto startCosts = getSectorCosts(start);
+	const auto goalCosts = getSectorCosts(goal);
+	const auto getLocalCost = [](const auto &costs, const Position &pos) {
+		return costs[static_cast<size_t>(pos.y & SECTOR_MASK) * SECTOR_SIZE + (pos.x & SECTOR_MASK)];
+	};
+
+	struct Node {
+		uint32_t cost;
+		uint64_t parent;
+		bool closed;
+	};
+	phmap::flat_hash_map<uint64_t, Node> nodes;
+	using Entry = std::pair<uint32_t, uint64_t>;
+	std::priority_queue<Entry, std::vector<Entry>, std::greater<>> open;
+
+	const auto heuristic = [&goal](const Position &pos) {
+		return static_cast<uint32_t>(std::max(Position::getDistanceX(pos, goal), Position::getDistanceY(pos, goal))) * NORMAL_WALK_COST;
+	};
+	// The goal is a node of its own, reached from the portals of its sector
+	const uint64_t goalKey = std::numeric_limits<uint64_t>::max();
+	const uint64_t noParent = goalKey - 1;
+	const auto push = [&](uint64_t key, uint32_t cost, uint64_t parent) {
+		auto [it, inserted] = nodes.try_emplace(key, Node { cost, parent, false });
+		if (!inserted) {
+			if (it->second.closed || it->second.cost <= cost) {
+				return;
+			}
+			it->second = { cost, parent, false };
+		}
+		open.emplace(cost + (key == goalKey ? 0 : heuristic(getPosition(key))), key);
+	};
+
+	for (const auto &[key, edges] : startSector->edges) {
+		const auto cost = getLocalCost(startCosts, getPosition(key));
+		if (cost != UNREACHABLE_COST) {
+			push(key, cost, noParent);
+		}
+	}
+
+	int32_t expanded = 0;
+	while (!open.empty() && expanded < MAX_EXPANDED_PORTALS) {
+		const auto [estimate, key] = open.top();
+		open.pop();
+
+		auto &node = nodes[key];
+		if (node.closed) {
+			continue;
+		}
+		node.closed = true;
+
+		if (key == goalKey) {
+			break;
+		}
+		++expanded;
+
+		const auto pos = getPosition(key);
+		const auto cost = node.cost;
+		if (getSectorKey(pos) == getSectorKey(goal)) {
+			const auto goalCost = getLocalCost(goalCosts, pos);
+			if (goalCost != UNREACHABLE_COST) {
+				push(goalKey, cost + goalCost, key);
+			}
+		}
+
+		const auto sector = getSector(pos);
+		if (const auto it = sector->edges.find(key); it != sector->edges.end()) {
+			for (const auto &edge : it->second) {
+				push(edge.to, cost + edge.cost, key);
+			}
+		}
+	}
+
+	const auto goalIt = nodes.find(goalKey);
+	if (goalIt == nodes.end() || !goalIt->second.closed) {
+		return false;
+	}
+
+	// Only the tiles entering a sector are kept, the local search finds the way through it
+	std::vector<Position> route;
+	for (auto key = goalIt->second.parent; key != noParent; key = nodes[key].parent) {
+		const auto parent = nodes[key].parent;
+		if (parent != noParent && getSectorKey(getPosition(parent)) != getSectorKey(getPosition(key))) {
+			route.emplace_back(getPosition(key));
+		}
+	}
+	waypoints.assign(route.rbegin(), route.rend());
+	return true;
+}
@@ -0,0 +1,69 @@
+/**
+ * Canary - A free and open-source MMORPG server emulator
+ * Copyright (©) 2019-2024 OpenTibiaBR <opentibiabr@outlook.com>
+ * Repository: https://github.com/opentibiabr/canary
+ * License: https://github.com/opentibiabr/canary/blob/main/LICENSE
+ * Contributors: https://github.com/opentibiabr/canary/graphs/contributors
+ * Website: https://docs.opentibiabr.com/
+ */
+
+#pragma once
+
+#include "game/movement/position.hpp"
+#include "map/map_const.hpp"
+
+/**
+ * Abstract graph of the portals between map sectors (HPA*), used to plan long routes before refining
+ * them with a local search (see Map::getHierarchicalPath and pathfindingHierarchicalDistance).
+ * A portal is the middle tile of each walkable run along a sector border and the edges between the
+ * portals of a sector are its walking costs. Sectors are built the first time a route needs them and
+ * rebuilt after a tile in them changes walkability. Creatures are ignored, the local search checks them.
+ */
+class HierarchicalPath {
+public:
+	/**
+	 * Finds the tiles a route from start to goal enters each sector on.
+	 * Neither start nor goal is included, and consecutive waypoints are at most one sector apart.
+	 * Safe to call from parallel tasks.
+	 */
+	static bool findWaypoints(const Position &start, const Position &goal, std::vector<Position> &waypoints);
+	// Drops the sectors whose portals may depend on pos, called when the walkability of its tile changes
+	static void invalidate(const Position &pos);
+
+private:
+	static constexpr int32_t MAX_EXPANDED_PORTALS = 4096;
+	static constexpr uint32_t NORMAL_WALK_COST = 10;
+	static constexpr uint32_t DIAGONAL_WALK_COST = 25;
+
+	struct Edge {
+		uint64_t to;
+		uint32_t cost;
+		// Step to the portal on the other side of the border
+		bool crossing;
+	};
+
+	struct Sector {
+		phmap::flat_hash_map<uint64_t, std::vector<Edge>> edges;
+	};
+
+	static uint64_t getKey(const Position &pos) {
+		return (static_cast<uint64_t>(pos.z) << 32) | (static_cast<uint64_t>(pos.x) << 16) | pos.y;
+	}
+	static Position getPosition(uint64_t key) {
+		return Position(static_cast<uint16_t>(key >> 16), static_cast<uint16_t>(key), static_cast<uint8_t>(key >> 32));
+	}
+	static uint64_t getSectorKey(const Position &pos) {
+		return getKey(Position(pos.x / SECTOR_SIZE, pos.y / SECTOR_SIZE, pos.z));
+	}
+
+	static bool isWalkable(const Position &pos);
+	static std::shared_ptr<const Sector> getSector(const Position &pos);
+	static std::shared_ptr<const Sector> buildSector(const Position &origin);
+	/**
+	 * Walking costs from pos to every tile of its sector, indexed by (y - origin y) * SECTOR_SIZE + (x - origin x).
+	 */
+	static std::array<uint32_t, SECTOR_SIZE * SECTOR_SIZE> getSectorCosts(const Position &pos);
+
+	static std::shared_mutex sectorsMutex;
+	static phmap::flat_hash_map<uint64_t, std::shared_ptr<const Sector>> sectors;
+};
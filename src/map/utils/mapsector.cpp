@@ -14,33 +14,63 @@
 
 bool MapSector::newSector = false;
 
-void MapSector::addCreature(const std::shared_ptr<Creature> &c) {
-	creature_list.emplace_back(c);
+void MapSector::addCreature(const std::shared_ptr<Creature> &c, uint8_t z) {
+	lastActivity = OTSYS_TIME();
+	addToFloor(creature_list, creatureOffsets, creatureFloors, c, z);
 	if (c->getPlayer()) {
-		player_list.emplace_back(c);
+		addToFloor(player_list, playerOffsets, playerFloors, c, z);
 	}
 }
 
-void MapSector::removeCreature(const std::shared_ptr<Creature> &c) {
-	auto iter = std::find(creature_list.begin(), creature_list.end(), c);
-	if (iter == creature_list.end()) {
+void MapSector::removeCreature(const std::shared_ptr<Creature> &c, uint8_t z) {
+	lastActivity = OTSYS_TIME();
+	if (!removeFromFloor(creature_list, creatureOffsets, creatureFloors, c, z)) {
 		g_logger().error("[{}]: Creature not found in creature_list!", __FUNCTION__);
 		return;
 	}
 
-	assert(iter != creature_list.end());
-	*iter = creature_list.back();
-	creature_list.pop_back();
+	if (c->getPlayer() && !removeFromFloor(player_list, playerOffsets, playerFloors, c, z)) {
+		g_logger().error("[{}]: Player not found in player_list!", __FUNCTION__);
+	}
+}
 
-	if (c->getPlayer()) {
-		iter = std::find(player_list.begin(), player_list.end(), c);
-		if (iter == player_list.end()) {
-			g_logger().error("[{}]: Player not found in player_list!", __FUNCTION__);
-			return;
+void MapSector::moveCreatureFloor(const std::shared_ptr<Creature> &c, uint8_t fromZ, uint8_t toZ) {
+	if (removeFromFloor(creature_list, creatureOffsets, creatureFloors, c, fromZ)) {
+		addToFloor(creature_list, creatureOffsets, creatureFloors, c, toZ);
+	}
+	if (c->getPlayer() && removeFromFloor(player_list, playerOffsets, playerFloors, c, fromZ)) {
+		addToFloor(player_list, playerOffsets, playerFloors, c, toZ);
+	}
+}
+
+void MapSector::addToFloor(std::vector<std::shared_ptr<Creature>> &list, FloorOffsets &offsets, uint16_t &floorMask, const std::shared_ptr<Creature> &c, uint8_t z) {
+	z = std::min<uint8_t>(z, MAP_MAX_LAYERS - 1);
+	list.insert(list.begin() + offsets[z + 1], c);
+	for (size_t i = z + 1; i < offsets.size(); ++i) {
+		++offsets[i];
+	}
+	floorMask |= 1 << z;
+}
+
+bool MapSector::removeFromFloor(std::vector<std::shared_ptr<Creature>> &list, FloorOffsets &offsets, uint16_t &floorMask, const std::shared_ptr<Creature> &c, uint8_t z) {
+	z = std::min<uint8_t>(z, MAP_MAX_LAYERS - 1);
+	auto it = std::find(list.begin() + offsets[z], list.begin() + offsets[z + 1], c);
+	if (it == list.begin() + offsets[z + 1]) {
+		// Not where it should be, look for it on the other floors
+		it = std::find(list.begin(), list.end(), c);
+		if (it == list.end()) {
+			return false;
 		}
+		const auto index = static_cast<uint16_t>(it - list.begin());
+		z = static_cast<uint8_t>(std::upper_bound(offsets.begin(), offsets.end(), index) - offsets.begin() - 1);
+	}
 
-		assert(iter != player_list.end());
-		*iter = player_list.back();
-		player_list.pop_back();
+	list.erase(it);
+	for (size_t i = z + 1; i < offsets.size(); ++i) {
+		--offsets[i];
+	}
+	if (offsets[z] == offsets[z + 1]) {
+		floorMask &= ~(1 << z);
 	}
+	return true;
 }
@@ -37,6 +37,66 @@ struct Floor {
 		tiles[x & SECTOR_MASK][y & SECTOR_MASK].second = newTile;
 	}
 
+	/**
+	 * The cached tile a materialized tile was created from,
+	 * only kept when tile eviction is enabled (see MapCache::evictIdleTiles).
+	 */
+	std::shared_ptr<BasicTile> getTileOrigin(uint16_t x, uint16_t y) const {
+		return origins ? (*origins)[(x & SECTOR_MASK) * SECTOR_SIZE + (y & SECTOR_MASK)] : nullptr;
+	}
+
+	void setTileOrigin(uint16_t x, uint16_t y, const std::shared_ptr<BasicTile> &origin) {
+		if (!origins) {
+			if (!origin) {
+				return;
+			}
+			origins = std::make_unique<std::array<std::shared_ptr<BasicTile>, SECTOR_SIZE * SECTOR_SIZE>>();
+		}
+
+		auto &entry = (*origins)[(x & SECTOR_MASK) * SECTOR_SIZE + (y & SECTOR_MASK)];
+		evictableTiles += static_cast<int32_t>(origin != nullptr) - static_cast<int32_t>(entry != nullptr);
+		entry = origin;
+	}
+
+	// Null until the first tile with an origin is materialized
+	const auto &getTileOrigins() const {
+		return origins;
+	}
+
+	bool hasEvictableTiles() const {
+		return evictableTiles > 0;
+	}
+
+	int64_t getLastMaterialization() const {
+		return lastMaterialization;
+	}
+
+	void setLastMaterialization(int64_t time) {
+		lastMaterialization = time;
+	}
+
+	/**
+	 * Whether no creature can path through the tile (no ground, floor change or teleport),
+	 * kept up to date by the tile itself (see Tile::updatePathBlock).
+	 * Lock free, so pathfinding can reject a position without looking the tile up.
+	 */
+	bool isPathBlocked(uint16_t x, uint16_t y) const {
+		return (pathBlocked[x & SECTOR_MASK].load(std::memory_order_relaxed) >> (y & SECTOR_MASK)) & 1;
+	}
+
+	void setPathBlocked(uint16_t x, uint16_t y, bool blocked) {
+		setBit(pathBlocked, x, y, blocked);
+	}
+
+	/**
+	 * Whether the tile is a static obstacle for the flow fields and portal graphs
+	 * (see Tile::isWalkBlocked), kept up to date by the tile itself.
+	 * \returns true if the bit flipped.
+	 */
+	bool setWalkBlocked(uint16_t x, uint16_t y, bool blocked) {
+		return setBit(walkBlocked, x, y, blocked);
+	}
+
 	const auto &getTiles() const {
 		return tiles;
 	}
@@ -50,8 +110,24 @@ struct Floor {
 	}
 
 private:
+	using BitRows = std::array<std::atomic<uint16_t>, SECTOR_SIZE>;
+
+	static bool setBit(BitRows &rows, uint16_t x, uint16_t y, bool value) {
+		const auto bit = static_cast<uint16_t>(1 << (y & SECTOR_MASK));
+		auto &row = rows[x & SECTOR_MASK];
+		const auto previous = value ? row.fetch_or(bit, std::memory_order_relaxed) : row.fetch_and(static_cast<uint16_t>(~bit), std::memory_order_relaxed);
+		return ((previous & bit) != 0) != value;
+	}
+
 	std::pair<std::shared_ptr<Tile>, std::shared_ptr<BasicTile>> tiles[SECTOR_SIZE][SECTOR_SIZE] = {};
+	std::unique_ptr<std::array<std::shared_ptr<BasicTile>, SECTOR_SIZE * SECTOR_SIZE>> origins;
+	// One row of bits per x, bit y is set when the tile at (x, y) blocks paths
+	static_assert(SECTOR_SIZE <= 16, "pathBlocked rows are 16 bits wide");
+	BitRows pathBlocked {};
+	BitRows walkBlocked {};
 	mutable std::shared_mutex mutex;
+	int64_t lastMaterialization { 0 };
+	uint16_t evictableTiles { 0 };
 	uint8_t z { 0 };
 };
 
@@ -75,17 +151,56 @@ public:
 		return floors[z];
 	}
 
-	void addCreature(const std::shared_ptr<Creature> &c);
-	void removeCreature(const std::shared_ptr<Creature> &c);
+	void addCreature(const std::shared_ptr<Creature> &c, uint8_t z);
+	void removeCreature(const std::shared_ptr<Creature> &c, uint8_t z);
+
+	/**
+	 * Updates the floor of a creature that changed floors without leaving the sector.
+	 */
+	void moveCreatureFloor(const std::shared_ptr<Creature> &c, uint8_t fromZ, uint8_t toZ);
+
+	/**
+	 * @return a bitmask of the floors that have at least one creature (or player) in this sector.
+	 */
+	uint16_t getOccupiedFloors(bool onlyPlayers) const {
+		return onlyPlayers ? playerFloors : creatureFloors;
+	}
+
+	/**
+	 * @return the creatures (or players) of this sector on floors [minZ, maxZ].
+	 */
+	std::span<const std::shared_ptr<Creature>> getCreatures(bool onlyPlayers, uint8_t minZ, uint8_t maxZ) const {
+		const auto &list = onlyPlayers ? player_list : creature_list;
+		const auto &offsets = onlyPlayers ? playerOffsets : creatureOffsets;
+		return { list.data() + offsets[minZ], list.data() + offsets[maxZ + 1] };
+	}
+
+	/**
+	 * @return the last time (in ms) a creature entered or left this sector.
+	 */
+	int64_t getLastActivity() const {
+		return lastActivity;
+	}
 
 private:
+	using FloorOffsets = std::array<uint16_t, MAP_MAX_LAYERS + 1>;
+
 	static bool newSector;
 	MapSector* sectorS = nullptr;
 	MapSector* sectorE = nullptr;
+	// Sorted by floor, the creatures of floor z are [offsets[z], offsets[z + 1])
 	std::vector<std::shared_ptr<Creature>> creature_list;
 	std::vector<std::shared_ptr<Creature>> player_list;
+	FloorOffsets creatureOffsets {};
+	FloorOffsets playerOffsets {};
 	std::unique_ptr<Floor> floors[MAP_MAX_LAYERS] = {};
-	uint32_t floorBits = 0;
+	// Bit set for every floor with at least one creature (or player)
+	uint16_t creatureFloors = 0;
+	uint16_t playerFloors = 0;
+	int64_t lastActivity = 0;
+
+	static void addToFloor(std::vector<std::shared_ptr<Creature>> &list, FloorOffsets &offsets, uint16_t &floorMask, const std::shared_ptr<Creature> &c, uint8_t z);
+	static bool removeFromFloor(std::vector<std::shared_ptr<Creature>> &list, FloorOffsets &offsets, uint16_t &floorMask, const std::shared_ptr<Creature> &c, uint8_t z);
 
 	friend class Spectators;
 	friend class MapCache;
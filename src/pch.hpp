@@ -39,6 +39,7 @@
 #include <algorithm>
 #include <regex>
 #include <set>
+#include <span>
 #include <thread>
 #include <vector>
 #include <variant>
@@ -141,6 +142,10 @@ struct fmt::formatter<E, std::enable_if_t<std::is_enum_v<E>, char>> : formatter<
 // Zlib
 #include <zlib.h>
 
+#ifdef FEATURE_LIBDEFLATE
+	#include <libdeflate.h>
+#endif
+
 #include <boost/di.hpp>
 
 // -------------------------
@@ -26,6 +26,8 @@ public:
 
 	void setKey(const char* pString, const char* qString, int base = 10);
 	void decrypt(char* msg) const;
+	// The side of the client, with the public exponent
+	void encrypt(char* msg) const;
 
 	std::string base64Decrypt(const std::string &input) const;
 	uint16_t decodeLength(char*&pos) const;
@@ -14,6 +14,10 @@
 #include "server/network/protocol/protocol.hpp"
 #include "game/scheduling/dispatcher.hpp"
 #include "server/server.hpp"
+#include "lib/metrics/allocation_counter.hpp"
+#include "lib/metrics/measured_lock.hpp"
+#include "lib/metrics/metrics.hpp"
+#include "lib/metrics/profiler.hpp"
 
 Connection_ptr ConnectionManager::createConnection(asio::io_service &io_service, ConstServicePort_ptr servicePort) {
 	auto connection = std::make_shared<Connection>(io_service, servicePort);
@@ -43,6 +47,94 @@ void ConnectionManager::closeAll() {
 	connections.clear();
 }
 
+void ConnectionManager::reportStatistics() {
+	struct Traffic {
+		uint64_t bytesReceived = 0;
+		uint64_t bytesSent = 0;
+		uint64_t packetsReceived = 0;
+		uint64_t packetsSent = 0;
+	};
+	std::map<std::string_view, Traffic> traffic;
+
+	const auto now = std::chrono::steady_clock::now();
+	connections.for_each([&](const Connection_ptr &connection) {
+		const auto &counters = connection->counters;
+		auto &reported = connection->reported;
+		const auto bytesReceived = counters.bytesReceived.load(std::memory_order_relaxed);
+		const auto bytesSent = counters.bytesSent.load(std::memory_order_relaxed);
+		const auto packetsReceived = counters.packetsReceived.load(std::memory_order_relaxed);
+		const auto packetsSent = counters.packetsSent.load(std::memory_order_relaxed);
+
+		const auto seconds = std::max(std::chrono::duration<double>(now - reported.time).count(), 0.001);
+		reported.packetsReceivedPerSecond = static_cast<uint32_t>((packetsReceived - reported.packetsReceived) / seconds);
+		reported.packetsSentPerSecond = static_cast<uint32_t>((packetsSent - reported.packetsSent) / seconds);
+
+		auto &protocol = traffic[connection->protocolName.load(std::memory_order_relaxed)];
+		protocol.bytesReceived += bytesReceived - reported.bytesReceived;
+		protocol.bytesSent += bytesSent - reported.bytesSent;
+		protocol.packetsReceived += packetsReceived - reported.packetsReceived;
+		protocol.packetsSent += packetsSent - reported.packetsSent;
+
+		reported.bytesReceived = bytesReceived;
+		reported.bytesSent = bytesSent;
+		reported.packetsReceived = packetsReceived;
+		reported.packetsSent = packetsSent;
+		reported.time = now;
+	});
+
+	if (!g_metrics().isEnabled()) {
+		return;
+	}
+
+	// The traffic of the connections closed since the previous call is not counted
+	for (const auto &[protocol, total] : traffic) {
+		const std::map<std::string, std::string> attrs { { "protocol", std::string(protocol) } };
+		g_metrics().addCounter("network_bytes_received", static_cast<double>(total.bytesReceived), attrs);
+		g_metrics().addCounter("network_bytes_sent", static_cast<double>(total.bytesSent), attrs);
+		g_metrics().addCounter("network_packets_received", static_cast<double>(total.packetsReceived), attrs);
+		g_metrics().addCounter("network_packets_sent", static_cast<double>(total.packetsSent), attrs);
+	}
+}
+
+std::vector<ConnectionStatistics> ConnectionManager::getTopConnections(size_t count, ConnectionStatisticsSort sort) {
+	// Copied first, the statistics take the lock of the connection and a connection closing under it takes the one of the set
+	std::vector<Connection_ptr> copy;
+	connections.for_each([&copy](const Connection_ptr &connection) {
+		copy.emplace_back(connection);
+	});
+
+	std::vector<ConnectionStatistics> statistics;
+	statistics.reserve(copy.size());
+	for (const auto &connection : copy) {
+		statistics.emplace_back(connection->getStatistics());
+	}
+
+	const auto key = [sort](const ConnectionStatistics &connection) -> double {
+		switch (sort) {
+			case ConnectionStatisticsSort::BytesReceived:
+				return static_cast<double>(connection.bytesReceived);
+			case ConnectionStatisticsSort::BytesSent:
+				return static_cast<double>(connection.bytesSent);
+			case ConnectionStatisticsSort::PacketsReceived:
+				return connection.packetsReceivedPerSecond;
+			case ConnectionStatisticsSort::PacketsSent:
+				return connection.packetsSentPerSecond;
+			case ConnectionStatisticsSort::QueueDepth:
+				return connection.maxQueueDepth;
+			case ConnectionStatisticsSort::WriteLatency:
+				return connection.writeLatency;
+		}
+		return 0;
+	};
+
+	count = std::min(count, statistics.size());
+	std::partial_sort(statistics.begin(), statistics.begin() + count, statistics.end(), [&key](const auto &a, const auto &b) {
+		return key(a) > key(b);
+	});
+	statistics.resize(count);
+	return statistics;
+}
+
 Connection::Connection(asio::io_service &initIoService, ConstServicePort_ptr initservicePort) :
 	readTimer(initIoService),
 	writeTimer(initIoService),
@@ -50,10 +142,30 @@ Connection::Connection(asio::io_service &initIoService, ConstServicePort_ptr ini
 	socket(initIoService) {
 }
 
+ConnectionStatistics Connection::getStatistics() {
+	ConnectionStatistics statistics;
+	statistics.ip = getIP();
+	statistics.protocol = protocolName.load(std::memory_order_relaxed);
+	statistics.age = static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::seconds>(std::chrono::steady_clock::now() - acceptedAt).count());
+	statistics.bytesReceived = counters.bytesReceived.load(std::memory_order_relaxed);
+	statistics.bytesSent = counters.bytesSent.load(std::memory_order_relaxed);
+	statistics.packetsReceivedPerSecond = reported.packetsReceivedPerSecond;
+	statistics.packetsSentPerSecond = reported.packetsSentPerSecond;
+	statistics.queueDepth = pendingMessages.load(std::memory_order_relaxed);
+	statistics.maxQueueDepth = counters.maxQueueDepth.load(std::memory_order_relaxed);
+	if (const auto writes = counters.writes.load(std::memory_order_relaxed); writes != 0) {
+		statistics.writeLatency = static_cast<double>(counters.writeMicroseconds.load(std::memory_order_relaxed)) / writes;
+	}
+	if (const auto input = counters.compressionInputBytes.load(std::memory_order_relaxed); input != 0) {
+		statistics.compressionRatio = static_cast<double>(counters.compressionOutputBytes.load(std::memory_order_relaxed)) / input;
+	}
+	return statistics;
+}
+
 void Connection::close(bool force) {
 	ConnectionManager::getInstance().releaseConnection(shared_from_this());
 
-	std::scoped_lock lock(connectionLock);
+	metrics::measured_lock lock(connectionLock, __METHOD_NAME__);
 	ip = 0;
 
 	if (connectionState == CONNECTION_STATE_CLOSED) {
@@ -65,7 +177,7 @@ void Connection::close(bool force) {
 		g_dispatcher().addEvent([protocol = protocol] { protocol->release(); }, "Protocol::release", std::chrono::milliseconds(CONNECTION_WRITE_TIMEOUT * 1000).count());
 	}
 
-	if (messageQueue.empty() || force) {
+	if (pendingMessages.load(std::memory_order_acquire) == 0 || force) {
 		closeSocket();
 	}
 }
@@ -121,7 +233,7 @@ void Connection::acceptInternal(bool toggleParseHeader) {
 	}
 }
 void Connection::parseProxyIdentification(const std::error_code &error) {
-	std::scoped_lock lock(connectionLock);
+	metrics::measured_lock lock(connectionLock, __METHOD_NAME__);
 	readTimer.cancel();
 
 	if (error || connectionState == CONNECTION_STATE_CLOSED) {
@@ -175,7 +287,8 @@ void Connection::parseProxyIdentification(const std::error_code &error) {
 }
 
 void Connection::parseHeader(const std::error_code &error) {
-	std::scoped_lock lock(connectionLock);
+	allocation_counter::Scope allocationScope(allocation_counter::AllocationTag::Network);
+	metrics::measured_lock lock(connectionLock, __METHOD_NAME__);
 	readTimer.cancel();
 
 	if (error) {
@@ -206,6 +319,9 @@ void Connection::parseHeader(const std::error_code &error) {
 		return;
 	}
 
+	counters.bytesReceived.fetch_add(size + HEADER_LENGTH, std::memory_order_relaxed);
+	counters.packetsReceived.fetch_add(1, std::memory_order_relaxed);
+
 	try {
 		readTimer.expires_from_now(std::chrono::seconds(CONNECTION_READ_TIMEOUT));
 		readTimer.async_wait([self = std::weak_ptr<Connection>(shared_from_this())](const std::error_code &error) { Connection::handleTimeout(self, error); });
@@ -221,7 +337,8 @@ void Connection::parseHeader(const std::error_code &error) {
 }
 
 void Connection::parsePacket(const std::error_code &error) {
-	std::scoped_lock lock(connectionLock);
+	allocation_counter::Scope allocationScope(allocation_counter::AllocationTag::Network);
+	metrics::measured_lock lock(connectionLock, __METHOD_NAME__);
 	readTimer.cancel();
 
 	if (error || connectionState == CONNECTION_STATE_CLOSED) {
@@ -267,7 +384,7 @@ void Connection::parsePacket(const std::error_code &error) {
 			msg.skipBytes(1);
 		}
 
-		protocol->onRecvFirstMessage(msg);
+		skipReadingNextPacket = protocol->onRecvFirstMessage(msg);
 	} else {
 		// Send the packet to the current protocol
 		skipReadingNextPacket = protocol->onRecvMessage(msg);
@@ -288,6 +405,12 @@ void Connection::parsePacket(const std::error_code &error) {
 }
 
 void Connection::resumeWork() {
+	// Called by the dispatcher and the crypto lane, while the network thread may still be in parsePacket
+	metrics::measured_lock lock(connectionLock, __METHOD_NAME__);
+	if (connectionState == CONNECTION_STATE_CLOSED) {
+		return;
+	}
+
 	readTimer.expires_from_now(std::chrono::seconds(CONNECTION_READ_TIMEOUT));
 	readTimer.async_wait([self = std::weak_ptr<Connection>(shared_from_this())](const std::error_code &error) { Connection::handleTimeout(self, error); });
 
@@ -300,48 +423,68 @@ void Connection::resumeWork() {
 }
 
 void Connection::send(const OutputMessage_ptr &outputMessage) {
-	std::scoped_lock lock(connectionLock);
-	if (connectionState == CONNECTION_STATE_CLOSED) {
+	allocation_counter::Scope allocationScope(allocation_counter::AllocationTag::Network);
+	if (connectionState.load(std::memory_order_acquire) == CONNECTION_STATE_CLOSED) {
 		return;
 	}
 
-	bool noPendingWrite = messageQueue.empty();
-	messageQueue.emplace_back(outputMessage);
+	messageQueue.push(outputMessage);
+	const auto queued = pendingMessages.fetch_add(1, std::memory_order_acq_rel);
+	auto maxQueueDepth = counters.maxQueueDepth.load(std::memory_order_relaxed);
+	while (queued + 1 > maxQueueDepth && !counters.maxQueueDepth.compare_exchange_weak(maxQueueDepth, queued + 1, std::memory_order_relaxed)) { }
 
-	if (noPendingWrite) {
-		if (socket.is_open()) {
-			try {
-				asio::post(socket.get_executor(), [self = shared_from_this()] { self->internalWorker(); });
-			} catch (const std::system_error &e) {
-				g_logger().error("[Connection::send] - Exception in posting write operation: {}", e.what());
-				close(FORCE_CLOSE);
-			}
-		} else {
-			g_logger().error("[Connection::send] - Socket is not open for writing.");
+	// A write is already running, it takes this message when it is done
+	if (queued != 0) {
+		return;
+	}
+
+	if (socket.is_open()) {
+		try {
+			asio::post(socket.get_executor(), [self = shared_from_this()] { self->internalWorker(); });
+		} catch (const std::system_error &e) {
+			g_logger().error("[Connection::send] - Exception in posting write operation: {}", e.what());
 			close(FORCE_CLOSE);
 		}
+	} else {
+		g_logger().error("[Connection::send] - Socket is not open for writing.");
+		close(FORCE_CLOSE);
 	}
 }
 
 void Connection::internalWorker() {
-	std::unique_lock lock(connectionLock);
-	if (messageQueue.empty()) {
-		if (connectionState == CONNECTION_STATE_CLOSED) {
-			closeSocket();
+	writeNextMessages();
+}
+
+void Connection::writeNextMessages() {
+	allocation_counter::Scope allocationScope(allocation_counter::AllocationTag::Network);
+	profiler::Zone zone(__METHOD_NAME__);
+	// Every queued message goes in a single scatter-gather write, up to networkWriteBatch of them
+	const auto maxBatch = static_cast<uint32_t>(std::max<int32_t>(1, g_configManager().getNumber(NETWORK_WRITE_BATCH, __FUNCTION__)));
+	const auto batch = std::min(pendingMessages.load(std::memory_order_acquire), maxBatch);
+
+	for (uint32_t i = 0; i < batch; ++i) {
+		OutputMessage_ptr outputMessage;
+		// pendingMessages says there is one, its producer may still be linking it
+		while (!messageQueue.pop(outputMessage)) {
+			std::this_thread::yield();
 		}
-		return;
+
+		protocol->onSendMessage(outputMessage);
+		counters.bytesSent.fetch_add(outputMessage->getLength(), std::memory_order_relaxed);
+		writingMessages.emplace_back(std::move(outputMessage));
 	}
 
-	const auto &outputMessage = messageQueue.front();
-	lock.unlock();
-	protocol->onSendMessage(outputMessage);
-	lock.lock();
+	counters.packetsSent.fetch_add(batch, std::memory_order_relaxed);
+	const auto &compressionStats = protocol->getCompressionStats();
+	counters.compressionInputBytes.store(compressionStats.inputBytes, std::memory_order_relaxed);
+	counters.compressionOutputBytes.store(compressionStats.outputBytes, std::memory_order_relaxed);
 
-	internalSend(outputMessage);
+	metrics::measured_lock lock(connectionLock, __METHOD_NAME__);
+	internalSend();
 }
 
 uint32_t Connection::getIP() {
-	std::scoped_lock lock(connectionLock);
+	metrics::measured_lock lock(connectionLock, __METHOD_NAME__);
 
 	if (ip == 1) {
 		std::error_code error;
@@ -356,12 +499,18 @@ uint32_t Connection::getIP() {
 	return ip;
 }
 
-void Connection::internalSend(const OutputMessage_ptr &outputMessage) {
+void Connection::internalSend() {
 	writeTimer.expires_from_now(std::chrono::seconds(CONNECTION_WRITE_TIMEOUT));
 	writeTimer.async_wait([self = std::weak_ptr<Connection>(shared_from_this())](const std::error_code &error) { Connection::handleTimeout(self, error); });
 
+	writingBuffers.clear();
+	for (const auto &outputMessage : writingMessages) {
+		writingBuffers.emplace_back(outputMessage->getOutputBuffer(), outputMessage->getLength());
+	}
+
+	writeStartedAt = std::chrono::steady_clock::now();
 	try {
-		asio::async_write(socket, asio::buffer(outputMessage->getOutputBuffer(), outputMessage->getLength()), [self = shared_from_this()](const std::error_code &error, std::size_t N) { self->onWriteOperation(error); });
+		asio::async_write(socket, writingBuffers, [self = shared_from_this()](const std::error_code &error, std::size_t N) { self->onWriteOperation(error); });
 	} catch (const std::system_error &e) {
 		g_logger().error("[Connection::internalSend] - Exception in async_write: {}", e.what());
 		close(FORCE_CLOSE);
@@ -369,25 +518,30 @@ void Connection::internalSend(const OutputMessage_ptr &outputMessage) {
 }
 
 void Connection::onWriteOperation(const std::error_code &error) {
-	std::unique_lock lock(connectionLock);
-	writeTimer.cancel();
+	allocation_counter::Scope allocationScope(allocation_counter::AllocationTag::Network);
+	{
+		metrics::measured_lock lock(connectionLock, __METHOD_NAME__);
+		writeTimer.cancel();
+	}
+	const auto written = static_cast<uint32_t>(writingMessages.size());
+	writingMessages.clear();
+
+	const auto writeMicroseconds = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - writeStartedAt).count();
+	counters.writes.fetch_add(1, std::memory_order_relaxed);
+	counters.writeMicroseconds.fetch_add(writeMicroseconds, std::memory_order_relaxed);
+	metrics::Metrics::recordLatency("network_write_latency", "protocol", protocolName.load(std::memory_order_relaxed), static_cast<double>(writeMicroseconds));
 
 	if (error) {
 		g_logger().error("[Connection::onWriteOperation] - Write error: {}", error.message());
-		messageQueue.clear();
+		// pendingMessages is left as it is, so no writer is started again, the queue goes with the connection
 		close(FORCE_CLOSE);
 		return;
 	}
 
-	messageQueue.pop_front();
-
-	if (!messageQueue.empty()) {
-		const auto &outputMessage = messageQueue.front();
-		lock.unlock();
-		protocol->onSendMessage(outputMessage);
-		lock.lock();
-		internalSend(outputMessage);
-	} else if (connectionState == CONNECTION_STATE_CLOSED) {
+	if (pendingMessages.fetch_sub(written, std::memory_order_acq_rel) > written) {
+		writeNextMessages();
+	} else if (connectionState.load(std::memory_order_acquire) == CONNECTION_STATE_CLOSED) {
+		metrics::measured_lock lock(connectionLock, __METHOD_NAME__);
 		closeSocket();
 	}
 }
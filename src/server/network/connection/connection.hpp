@@ -12,6 +12,7 @@
 #include "declarations.hpp"
 #include "lib/di/container.hpp"
 #include "server/network/message/networkmessage.hpp"
+#include "utils/mpsc_queue.hpp"
 
 static constexpr int32_t CONNECTION_WRITE_TIMEOUT = 30;
 static constexpr int32_t CONNECTION_READ_TIMEOUT = 30;
@@ -29,6 +30,35 @@ class ServicePort;
 using ServicePort_ptr = std::shared_ptr<ServicePort>;
 using ConstServicePort_ptr = std::shared_ptr<const ServicePort>;
 
+// A view of a connection, for the admins, see ConnectionManager::getTopConnections
+struct ConnectionStatistics {
+	uint32_t ip = 0;
+	std::string_view protocol;
+	// Seconds since the connection was accepted
+	uint32_t age = 0;
+	uint64_t bytesReceived = 0;
+	uint64_t bytesSent = 0;
+	// Over the last second
+	uint32_t packetsReceivedPerSecond = 0;
+	uint32_t packetsSentPerSecond = 0;
+	// Messages waiting to be written, and the most there has been
+	uint32_t queueDepth = 0;
+	uint32_t maxQueueDepth = 0;
+	// Average time from a write to its completion, in microseconds
+	double writeLatency = 0;
+	// Size after compression over the size before, of the packets big enough to be compressed, 1 without any
+	double compressionRatio = 1;
+};
+
+enum class ConnectionStatisticsSort : uint8_t {
+	BytesReceived,
+	BytesSent,
+	PacketsReceived,
+	PacketsSent,
+	QueueDepth,
+	WriteLatency,
+};
+
 class ConnectionManager {
 public:
 	ConnectionManager() = default;
@@ -41,6 +71,14 @@ public:
 	void releaseConnection(const Connection_ptr &connection);
 	void closeAll();
 
+	/**
+	 * Updates the rates of the connections and adds what they received and sent since the previous call
+	 * to the network counters of the metrics, by protocol. Called every second by the dispatcher.
+	 */
+	void reportStatistics();
+	// The count connections with the highest sort, the rates are the ones of the last reportStatistics
+	std::vector<ConnectionStatistics> getTopConnections(size_t count, ConnectionStatisticsSort sort);
+
 private:
 	phmap::parallel_flat_hash_set_m<Connection_ptr> connections;
 };
@@ -80,20 +118,30 @@ private:
 
 	void closeSocket();
 	void internalWorker();
-	void internalSend(const OutputMessage_ptr &outputMessage);
+	void writeNextMessages();
+	void internalSend();
 
 	asio::ip::tcp::socket &getSocket() {
 		return socket;
 	}
 
+	// The rates are the ones of the last ConnectionManager::reportStatistics
+	ConnectionStatistics getStatistics();
+
 	NetworkMessage msg;
 
 	asio::high_resolution_timer readTimer;
 	asio::high_resolution_timer writeTimer;
 
+	// Guards the socket, the timers and the read side, sending a message does not take it
 	std::recursive_mutex connectionLock;
 
-	std::list<OutputMessage_ptr> messageQueue;
+	stdext::mpsc_queue<OutputMessage_ptr> messageQueue;
+	// Messages queued or being written, the send that makes it 1 starts the writer
+	std::atomic<uint32_t> pendingMessages = 0;
+	// Only touched by the writer, the batch of messages of the current write, kept alive until it completes
+	std::vector<OutputMessage_ptr> writingMessages;
+	std::vector<asio::const_buffer> writingBuffers;
 
 	ConstServicePort_ptr service_port;
 	Protocol_ptr protocol;
@@ -104,7 +152,40 @@ private:
 	uint32_t packetsSent = 0;
 	uint32_t ip = 1;
 
-	std::underlying_type_t<ConnectionState_t> connectionState = CONNECTION_STATE_OPEN;
+	// Totals since the connection was accepted, written by its network thread and read by the dispatcher
+	struct Counters {
+		std::atomic_uint64_t bytesReceived = 0;
+		std::atomic_uint64_t bytesSent = 0;
+		std::atomic_uint32_t packetsReceived = 0;
+		std::atomic_uint32_t packetsSent = 0;
+		std::atomic_uint32_t writes = 0;
+		std::atomic_uint64_t writeMicroseconds = 0;
+		std::atomic_uint32_t maxQueueDepth = 0;
+		// From the compression stats of the protocol, copied after each batch is prepared
+		std::atomic_uint64_t compressionInputBytes = 0;
+		std::atomic_uint64_t compressionOutputBytes = 0;
+	};
+	Counters counters;
+
+	// The counters at the last ConnectionManager::reportStatistics and the rates since then, only touched by the dispatcher
+	struct Reported {
+		uint64_t bytesReceived = 0;
+		uint64_t bytesSent = 0;
+		uint32_t packetsReceived = 0;
+		uint32_t packetsSent = 0;
+		uint32_t packetsReceivedPerSecond = 0;
+		uint32_t packetsSentPerSecond = 0;
+		std::chrono::steady_clock::time_point time = std::chrono::steady_clock::now();
+	};
+	Reported reported;
+
+	const std::chrono::steady_clock::time_point acceptedAt = std::chrono::steady_clock::now();
+	// Only touched by the writer
+	std::chrono::steady_clock::time_point writeStartedAt;
+	// Of the service that made the protocol, a static string
+	std::atomic<const char*> protocolName = "unidentified";
+
+	std::atomic<std::underlying_type_t<ConnectionState_t>> connectionState = CONNECTION_STATE_OPEN;
 	bool receivedFirst = false;
 
 	friend class ServicePort;
@@ -19,17 +19,21 @@ int32_t NetworkMessage::decodeHeader() {
 }
 
 std::string NetworkMessage::getString(uint16_t stringLen /* = 0*/) {
+	return std::string(getStringView(stringLen));
+}
+
+std::string_view NetworkMessage::getStringView(uint16_t stringLen /* = 0*/) {
 	if (stringLen == 0) {
 		stringLen = get<uint16_t>();
 	}
 
 	if (!canRead(stringLen)) {
-		return std::string();
+		return {};
 	}
 
-	char* v = reinterpret_cast<char*>(buffer) + info.position; // does not break strict aliasing
+	const char* v = reinterpret_cast<const char*>(buffer) + info.position; // does not break strict aliasing
 	info.position += stringLen;
-	return std::string(v, stringLen);
+	return { v, stringLen };
 }
 
 Position NetworkMessage::getPosition() {
@@ -59,6 +59,11 @@ public:
 	}
 
 	std::string getString(uint16_t stringLen = 0);
+	/**
+	 * Same as getString without the copy, the view points into the buffer,
+	 * so it is only valid until the message is reused (e.g. the connection reads the next packet into it).
+	 */
+	std::string_view getStringView(uint16_t stringLen = 0);
 	Position getPosition();
 
 	// skips count unknown/unused bytes in an incoming message
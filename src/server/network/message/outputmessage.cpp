@@ -11,7 +11,11 @@
 
 #include "outputmessage.hpp"
 #include "server/network/protocol/protocol.hpp"
+#include "game/memory_census.hpp"
 #include "game/scheduling/dispatcher.hpp"
+#include "game/scheduling/frame_profiler.hpp"
+#include "lib/metrics/allocation_counter.hpp"
+#include "utils/pool_allocator.hpp"
 
 const std::chrono::milliseconds OUTPUTMESSAGE_AUTOSEND_DELAY { 10 };
 
@@ -23,6 +27,22 @@ void OutputMessagePool::scheduleSendAll() {
 
 void OutputMessagePool::sendAll() {
 	// dispatcher thread
+	FrameScope scope(FramePhase::SendMessages);
+	allocation_counter::Scope allocationScope(allocation_counter::AllocationTag::Network);
+	std::vector<Protocol*> pending;
+	for (const auto &protocol : bufferedProtocols) {
+		if (protocol->hasSharedMessages()) {
+			pending.emplace_back(protocol.get());
+		}
+	}
+
+	// Each protocol only writes its own buffer, in queue order, so the output is the same as a serial copy
+	if (!pending.empty()) {
+		g_dispatcher().asyncWait(pending.size(), [&pending](size_t i) {
+			pending[i]->flushSharedMessages();
+		});
+	}
+
 	for (auto &protocol : bufferedProtocols) {
 		auto &msg = protocol->getCurrentBuffer();
 		if (msg) {
@@ -53,5 +73,11 @@ void OutputMessagePool::removeProtocolFromAutosend(const Protocol_ptr &protocol)
 }
 
 OutputMessage_ptr OutputMessagePool::getOutputMessage() {
-	return std::make_shared<OutputMessage>();
+	// Built on the dispatcher and released by the network threads once sent, so the blocks go through a shared pool
+	return std::allocate_shared<OutputMessage>(stdext::shared_pool_allocator<OutputMessage>());
+}
+
+void OutputMessagePool::countMemory(MemoryCensus &census) const {
+	const auto live = OutputMessage::getLive();
+	census.add("output_messages", live, live * MemoryCensus::sharedBytes<OutputMessage>() + bufferedProtocols.capacity() * sizeof(Protocol_ptr));
 }
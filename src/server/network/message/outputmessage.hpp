@@ -14,10 +14,23 @@
 #include "utils/tools.hpp"
 
 class Protocol;
+class MemoryCensus;
 
 class OutputMessage : public NetworkMessage {
 public:
-	OutputMessage() = default;
+	// User provided on purpose, a defaulted one would zero the whole buffer on each make_shared
+	OutputMessage() {
+		live.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	~OutputMessage() {
+		live.fetch_sub(1, std::memory_order_relaxed);
+	}
+
+	// Built and not released yet, queued or being sent included
+	static uint64_t getLive() {
+		return live.load(std::memory_order_relaxed);
+	}
 
 	// non-copyable
 	OutputMessage(const OutputMessage &) = delete;
@@ -57,7 +70,10 @@ private:
 	template <typename T>
 	void add_header(T addHeader) {
 		if (outputBufferStart < sizeof(T)) {
-			g_logger().error("[{}]: Insufficient buffer space for header!", __FUNCTION__);
+			static LogRateLimit rateLimit(std::chrono::seconds(1));
+			if (const auto skipped = rateLimit.allow()) {
+				g_logger().error("[{}]: Insufficient buffer space for header! ({} more since the last one)", __FUNCTION__, *skipped);
+			}
 			return;
 		}
 
@@ -69,6 +85,9 @@ private:
 	}
 
 	MsgSize_t outputBufferStart = INITIAL_BUFFER_POSITION;
+
+	// Released by the network threads
+	inline static std::atomic_uint64_t live = 0;
 };
 
 class OutputMessagePool {
@@ -91,6 +110,9 @@ public:
 	void addProtocolToAutosend(Protocol_ptr protocol);
 	void removeProtocolFromAutosend(const Protocol_ptr &protocol);
 
+	// Adds the live messages, the blocks cached by the pool for the next ones are not counted
+	void countMemory(MemoryCensus &census) const;
+
 private:
 	// NOTE: A vector is used here because this container is mostly read
 	// and relatively rarely modified (only when a client connects/disconnects)
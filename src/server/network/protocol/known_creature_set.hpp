@@ -0,0 +1,150 @@
+/**
+ * Canary - A free and open-source MMORPG server emulator
+ * Copyright (©) 2019-2024 OpenTibiaBR <opentibiabr@outlook.com>
+ * Repository: https://github.com/opentibiabr/canary
+ * License: https://github.com/opentibiabr/canary/blob/main/LICENSE
+ * Contributors: https://github.com/opentibiabr/canary/graphs/contributors
+ * Website: https://docs.opentibiabr.com/
+ */
+
+#pragma once
+
+/**
+ * The creatures a client knows, the client keeps at most MAX_KNOWN of them.
+ * Ids live in a dense array indexed by an open addressing table, so lookups never allocate,
+ * and eviction walks the array as a clock: creatures found again since the hand last passed
+ * them get a second chance, so the ones that left the screen long ago are checked first.
+ */
+class KnownCreatureSet {
+public:
+	static constexpr size_t MAX_KNOWN = 1300;
+
+	bool contains(uint32_t id) const {
+		return slots[findSlot(id)] != EMPTY_SLOT;
+	}
+
+	/**
+	 * @return true if the id was not known yet, otherwise it is only marked as recently used.
+	 */
+	bool insert(uint32_t id) {
+		const auto slot = findSlot(id);
+		if (slots[slot] != EMPTY_SLOT) {
+			referenced[slots[slot]] = true;
+			return false;
+		}
+
+		slots[slot] = static_cast<uint16_t>(count);
+		ids[count] = id;
+		referenced[count] = true;
+		++count;
+		return true;
+	}
+
+	size_t size() const {
+		return count;
+	}
+
+	/**
+	 * Removes a creature other than keep, the first one canEvict accepts in clock order,
+	 * or, when it accepts none, the one under the hand.
+	 * @return the removed id, 0 if there was nothing to remove.
+	 */
+	template <typename F>
+	uint32_t evict(uint32_t keep, F &&canEvict) {
+		if (count < 2) {
+			return 0;
+		}
+
+		// Two rounds, the first one only clears the recently used marks
+		for (size_t step = 0; step < count * 2; ++step) {
+			const auto index = advanceHand();
+			if (ids[index] == keep) {
+				continue;
+			}
+
+			if (referenced[index]) {
+				referenced[index] = false;
+				continue;
+			}
+
+			if (canEvict(ids[index])) {
+				return eraseAt(index);
+			}
+		}
+
+		auto index = advanceHand();
+		if (ids[index] == keep) {
+			index = advanceHand();
+		}
+		return eraseAt(index);
+	}
+
+private:
+	static constexpr uint16_t EMPTY_SLOT = std::numeric_limits<uint16_t>::max();
+	// Power of two with the table at most ~2/3 full
+	static constexpr size_t TABLE_SIZE = 2048;
+	static_assert(TABLE_SIZE > (MAX_KNOWN + 1) * 3 / 2);
+
+	static size_t hash(uint32_t id) {
+		// Fibonacci hashing, creature ids are sequential
+		return static_cast<size_t>((id * 2654435769u) >> (32 - std::countr_zero(TABLE_SIZE)));
+	}
+
+	size_t findSlot(uint32_t id) const {
+		auto slot = hash(id);
+		while (slots[slot] != EMPTY_SLOT && ids[slots[slot]] != id) {
+			slot = (slot + 1) & (TABLE_SIZE - 1);
+		}
+		return slot;
+	}
+
+	size_t advanceHand() {
+		if (hand >= count) {
+			hand = 0;
+		}
+		return hand++;
+	}
+
+	uint32_t eraseAt(size_t index) {
+		const auto id = ids[index];
+		eraseSlot(findSlot(id));
+
+		// The last id takes the freed place in the dense array
+		const auto last = count - 1;
+		if (index != last) {
+			slots[findSlot(ids[last])] = static_cast<uint16_t>(index);
+			ids[index] = ids[last];
+			referenced[index] = referenced[last];
+		}
+		--count;
+		return id;
+	}
+
+	// Backward shift deletion, keeps the probe sequences intact without tombstones
+	void eraseSlot(size_t slot) {
+		auto next = (slot + 1) & (TABLE_SIZE - 1);
+		while (slots[next] != EMPTY_SLOT) {
+			const auto home = hash(ids[slots[next]]);
+			// Moves the entry back if its home is not in (slot, next]
+			if (((next - home) & (TABLE_SIZE - 1)) >= ((next - slot) & (TABLE_SIZE - 1))) {
+				slots[slot] = slots[next];
+				slot = next;
+			}
+			next = (next + 1) & (TABLE_SIZE - 1);
+		}
+		slots[slot] = EMPTY_SLOT;
+	}
+
+	std::array<uint16_t, TABLE_SIZE> slots = makeEmptySlots();
+	// One more than the client limit, the new creature is inserted before one is evicted
+	std::array<uint32_t, MAX_KNOWN + 1> ids {};
+	std::array<bool, MAX_KNOWN + 1> referenced {};
+	size_t count = 0;
+	size_t hand = 0;
+
+	static constexpr std::array<uint16_t, TABLE_SIZE> makeEmptySlots() {
+		std::array<uint16_t, TABLE_SIZE> empty {};
+		empty.fill(EMPTY_SLOT);
+		return empty;
+	}
+};
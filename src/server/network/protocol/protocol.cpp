@@ -13,10 +13,11 @@
 #include "server/network/message/outputmessage.hpp"
 #include "security/rsa.hpp"
 #include "game/scheduling/dispatcher.hpp"
+#include "lib/thread/thread_pool.hpp"
 
 void Protocol::onSendMessage(const OutputMessage_ptr &msg) {
 	if (!rawMessages) {
-		const uint32_t sendMessageChecksum = msg->getLength() >= 128 && compression(*msg) ? (1U << 31) : 0;
+		const uint32_t sendMessageChecksum = compression(*msg) ? (1U << 31) : 0;
 
 		msg->writeMessageLength();
 
@@ -96,6 +97,22 @@ bool Protocol::onRecvMessage(NetworkMessage &msg) {
 
 OutputMessage_ptr Protocol::getOutputBuffer(int32_t size) {
 	// dispatcher thread
+	flushSharedMessages();
+	return reserveOutputBuffer(size);
+}
+
+void Protocol::flushSharedMessages() {
+	if (sharedMessages.empty()) {
+		return;
+	}
+
+	for (const auto &msg : sharedMessages) {
+		reserveOutputBuffer(msg->getLength())->append(*msg);
+	}
+	sharedMessages.clear();
+}
+
+OutputMessage_ptr Protocol::reserveOutputBuffer(int32_t size) {
 	if (!outputBuffer) {
 		outputBuffer = OutputMessagePool::getOutputMessage();
 	} else if ((outputBuffer->getLength() + size) > MAX_PROTOCOL_BODY_LENGTH) {
@@ -105,19 +122,132 @@ OutputMessage_ptr Protocol::getOutputBuffer(int32_t size) {
 	return outputBuffer;
 }
 
-void Protocol::XTEA_encrypt(OutputMessage &msg) const {
-	const uint32_t delta = 0x61C88647;
+namespace {
+	// XTEA blocks are independent of each other, so the vector paths run 8 (AVX2) or 4 (SSE2/NEON)
+	// blocks through the rounds side by side. They return how many bytes were processed, the
+	// scalar loop does the rest.
+#if defined(__AVX2__)
+	inline __m256i xteaMix(__m256i v) {
+		return _mm256_add_epi32(_mm256_xor_si256(_mm256_slli_epi32(v, 4), _mm256_srli_epi32(v, 5)), v);
+	}
+#endif
+#if defined(__SSE2__)
+	inline __m128i xteaMix(__m128i v) {
+		return _mm_add_epi32(_mm_xor_si128(_mm_slli_epi32(v, 4), _mm_srli_epi32(v, 5)), v);
+	}
+#elif defined(__NEON__)
+	inline uint32x4_t xteaMix(uint32x4_t v) {
+		return vaddq_u32(veorq_u32(vshlq_n_u32(v, 4), vshrq_n_u32(v, 5)), v);
+	}
+#endif
+
+	size_t xteaEncryptVector(uint8_t* buffer, size_t length, const uint32_t (&controlSum)[32][2]) {
+		size_t pos = 0;
+#if defined(__AVX2__)
+		for (; pos + 64 <= length; pos += 64) {
+			auto* data = reinterpret_cast<__m256i*>(buffer + pos);
+			// Split the 8 blocks into their first and second words
+			const auto a = _mm256_castsi256_ps(_mm256_loadu_si256(data));
+			const auto b = _mm256_castsi256_ps(_mm256_loadu_si256(data + 1));
+			auto v0 = _mm256_castps_si256(_mm256_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+			auto v1 = _mm256_castps_si256(_mm256_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+			for (const auto &sum : controlSum) {
+				v0 = _mm256_add_epi32(v0, _mm256_xor_si256(xteaMix(v1), _mm256_set1_epi32(static_cast<int32_t>(sum[0]))));
+				v1 = _mm256_add_epi32(v1, _mm256_xor_si256(xteaMix(v0), _mm256_set1_epi32(static_cast<int32_t>(sum[1]))));
+			}
+			_mm256_storeu_si256(data, _mm256_unpacklo_epi32(v0, v1));
+			_mm256_storeu_si256(data + 1, _mm256_unpackhi_epi32(v0, v1));
+		}
+#endif
+#if defined(__SSE2__)
+		for (; pos + 32 <= length; pos += 32) {
+			auto* data = reinterpret_cast<__m128i*>(buffer + pos);
+			const auto a = _mm_castsi128_ps(_mm_loadu_si128(data));
+			const auto b = _mm_castsi128_ps(_mm_loadu_si128(data + 1));
+			auto v0 = _mm_castps_si128(_mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+			auto v1 = _mm_castps_si128(_mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+			for (const auto &sum : controlSum) {
+				v0 = _mm_add_epi32(v0, _mm_xor_si128(xteaMix(v1), _mm_set1_epi32(static_cast<int32_t>(sum[0]))));
+				v1 = _mm_add_epi32(v1, _mm_xor_si128(xteaMix(v0), _mm_set1_epi32(static_cast<int32_t>(sum[1]))));
+			}
+			_mm_storeu_si128(data, _mm_unpacklo_epi32(v0, v1));
+			_mm_storeu_si128(data + 1, _mm_unpackhi_epi32(v0, v1));
+		}
+#elif defined(__NEON__)
+		for (; pos + 32 <= length; pos += 32) {
+			auto* data = reinterpret_cast<uint32_t*>(buffer + pos);
+			auto v = vld2q_u32(data);
+			for (const auto &sum : controlSum) {
+				v.val[0] = vaddq_u32(v.val[0], veorq_u32(xteaMix(v.val[1]), vdupq_n_u32(sum[0])));
+				v.val[1] = vaddq_u32(v.val[1], veorq_u32(xteaMix(v.val[0]), vdupq_n_u32(sum[1])));
+			}
+			vst2q_u32(data, v);
+		}
+#endif
+		return pos;
+	}
+
+	size_t xteaDecryptVector(uint8_t* buffer, size_t length, const uint32_t (&controlSum)[32][2]) {
+		size_t pos = 0;
+#if defined(__AVX2__)
+		for (; pos + 64 <= length; pos += 64) {
+			auto* data = reinterpret_cast<__m256i*>(buffer + pos);
+			const auto a = _mm256_castsi256_ps(_mm256_loadu_si256(data));
+			const auto b = _mm256_castsi256_ps(_mm256_loadu_si256(data + 1));
+			auto v0 = _mm256_castps_si256(_mm256_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+			auto v1 = _mm256_castps_si256(_mm256_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+			for (const auto &sum : controlSum) {
+				v1 = _mm256_sub_epi32(v1, _mm256_xor_si256(xteaMix(v0), _mm256_set1_epi32(static_cast<int32_t>(sum[0]))));
+				v0 = _mm256_sub_epi32(v0, _mm256_xor_si256(xteaMix(v1), _mm256_set1_epi32(static_cast<int32_t>(sum[1]))));
+			}
+			_mm256_storeu_si256(data, _mm256_unpacklo_epi32(v0, v1));
+			_mm256_storeu_si256(data + 1, _mm256_unpackhi_epi32(v0, v1));
+		}
+#endif
+#if defined(__SSE2__)
+		for (; pos + 32 <= length; pos += 32) {
+			auto* data = reinterpret_cast<__m128i*>(buffer + pos);
+			const auto a = _mm_castsi128_ps(_mm_loadu_si128(data));
+			const auto b = _mm_castsi128_ps(_mm_loadu_si128(data + 1));
+			auto v0 = _mm_castps_si128(_mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+			auto v1 = _mm_castps_si128(_mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+			for (const auto &sum : controlSum) {
+				v1 = _mm_sub_epi32(v1, _mm_xor_si128(xteaMix(v0), _mm_set1_epi32(static_cast<int32_t>(sum[0]))));
+				v0 = _mm_sub_epi32(v0, _mm_xor_si128(xteaMix(v1), _mm_set1_epi32(static_cast<int32_t>(sum[1]))));
+			}
+			_mm_storeu_si128(data, _mm_unpacklo_epi32(v0, v1));
+			_mm_storeu_si128(data + 1, _mm_unpackhi_epi32(v0, v1));
+		}
+#elif defined(__NEON__)
+		for (; pos + 32 <= length; pos += 32) {
+			auto* data = reinterpret_cast<uint32_t*>(buffer + pos);
+			auto v = vld2q_u32(data);
+			for (const auto &sum : controlSum) {
+				v.val[1] = vsubq_u32(v.val[1], veorq_u32(xteaMix(v.val[0]), vdupq_n_u32(sum[0])));
+				v.val[0] = vsubq_u32(v.val[0], veorq_u32(xteaMix(v.val[1]), vdupq_n_u32(sum[1])));
+			}
+			vst2q_u32(data, v);
+		}
+#endif
+		return pos;
+	}
+}
 
+void Protocol::XTEA_encrypt(OutputMessage &msg) const {
 	// The message must be a multiple of 8
 	size_t paddingBytes = msg.getLength() & 7;
 	if (paddingBytes != 0) {
 		msg.addPaddingBytes(8 - paddingBytes);
 	}
 
-	uint8_t* buffer = msg.getOutputBuffer();
-	auto messageLength = static_cast<int32_t>(msg.getLength());
+	xteaEncrypt(msg.getOutputBuffer(), msg.getLength(), key);
+}
+
+void Protocol::xteaEncrypt(uint8_t* buffer, size_t length, const std::array<uint32_t, 4> &newKey) {
+	const uint32_t delta = 0x61C88647;
+
+	auto messageLength = static_cast<int32_t>(length);
 	int32_t readPos = 0;
-	const std::array<uint32_t, 4> newKey = { key[0], key[1], key[2], key[3] };
 	// TODO: refactor this for not use c-style
 	uint32_t precachedControlSum[32][2];
 	uint32_t sum = 0;
@@ -126,6 +256,7 @@ void Protocol::XTEA_encrypt(OutputMessage &msg) const {
 		sum -= delta;
 		precachedControlSum[i][1] = (sum + newKey[(sum >> 11) & 3]);
 	}
+	readPos = static_cast<int32_t>(xteaEncryptVector(buffer, messageLength, precachedControlSum));
 	while (readPos < messageLength) {
 		std::array<uint32_t, 2> vData = {};
 		memcpy(vData.data(), buffer + readPos, 8);
@@ -144,12 +275,22 @@ bool Protocol::XTEA_decrypt(NetworkMessage &msg) const {
 		return false;
 	}
 
+	xteaDecrypt(msg.getBuffer() + msg.getBufferPosition(), msgLength, key);
+
+	uint16_t innerLength = msg.get<uint16_t>();
+	if (std::cmp_greater(innerLength, msgLength - 2)) {
+		return false;
+	}
+
+	msg.setLength(innerLength);
+	return true;
+}
+
+void Protocol::xteaDecrypt(uint8_t* buffer, size_t length, const std::array<uint32_t, 4> &newKey) {
 	const uint32_t delta = 0x61C88647;
 
-	uint8_t* buffer = msg.getBuffer() + msg.getBufferPosition();
-	auto messageLength = static_cast<int32_t>(msgLength);
+	auto messageLength = static_cast<int32_t>(length);
 	int32_t readPos = 0;
-	const std::array<uint32_t, 4> newKey = { key[0], key[1], key[2], key[3] };
 	// TODO: refactor this for not use c-style
 	uint32_t precachedControlSum[32][2];
 	uint32_t sum = 0xC6EF3720;
@@ -158,6 +299,7 @@ bool Protocol::XTEA_decrypt(NetworkMessage &msg) const {
 		sum += delta;
 		precachedControlSum[i][1] = (sum + newKey[sum & 3]);
 	}
+	readPos = static_cast<int32_t>(xteaDecryptVector(buffer, messageLength, precachedControlSum));
 	while (readPos < messageLength) {
 		std::array<uint32_t, 2> vData = {};
 		memcpy(vData.data(), buffer + readPos, 8);
@@ -168,14 +310,6 @@ bool Protocol::XTEA_decrypt(NetworkMessage &msg) const {
 		memcpy(buffer + readPos, vData.data(), 8);
 		readPos += 8;
 	}
-
-	uint16_t innerLength = msg.get<uint16_t>();
-	if (std::cmp_greater(innerLength, msgLength - 2)) {
-		return false;
-	}
-
-	msg.setLength(innerLength);
-	return true;
 }
 
 bool Protocol::RSA_decrypt(NetworkMessage &msg) {
@@ -189,6 +323,23 @@ bool Protocol::RSA_decrypt(NetworkMessage &msg) {
 	return (msg.getByte() == 0);
 }
 
+bool Protocol::detachLoginTask(std::function<void()> task) {
+	auto &threadPool = inject<ThreadPool>();
+	const auto queueLimit = g_configManager().getNumber(LOGIN_CRYPTO_QUEUE_LIMIT, __FUNCTION__);
+	if (queueLimit > 0 && threadPool.getLaneQueueDepth(ThreadLane::Crypto) >= queueLimit) {
+		g_logger().debug("[Protocol::detachLoginTask] - {} logins waiting, dropping the connection from {}", queueLimit, convertIPToString(getIP()));
+		disconnect();
+		return false;
+	}
+
+	threadPool.detachTask(ThreadLane::Crypto, [connection = getConnection(), task = std::move(task)] {
+		if (connection) {
+			task();
+		}
+	});
+	return true;
+}
+
 uint32_t Protocol::getIP() const {
 	if (auto protocolConnection = getConnection()) {
 		return protocolConnection->getIP();
@@ -197,39 +348,75 @@ uint32_t Protocol::getIP() const {
 	return 0;
 }
 
-bool Protocol::compression(OutputMessage &msg) const {
+size_t Protocol::ZStream::compress(uint8_t* input, size_t size) {
+#ifdef FEATURE_LIBDEFLATE
+	return libdeflate_deflate_compress(compressor, input, size, buffer.data(), buffer.size());
+#else
+	stream->next_in = input;
+	stream->avail_in = static_cast<uInt>(size);
+	stream->next_out = reinterpret_cast<Bytef*>(buffer.data());
+	stream->avail_out = static_cast<uInt>(buffer.size());
+
+	const int32_t ret = deflate(stream.get(), Z_FINISH);
+	const auto totalSize = ret == Z_OK || ret == Z_STREAM_END ? stream->total_out : 0;
+	deflateReset(stream.get());
+	return totalSize;
+#endif
+}
+
+bool Protocol::compression(OutputMessage &msg) {
+	// A size class that costs too much is sent raw for this many packets, then measured again
+	constexpr uint8_t COMPRESSION_PROBE_INTERVAL = 32;
+
 	if (checksumMethod != CHECKSUM_METHOD_SEQUENCE) {
 		return false;
 	}
 
 	static const thread_local auto &compress = std::make_unique<ZStream>();
-	if (!compress->stream) {
+	if (!compress->isEnabled()) {
 		return false;
 	}
 
 	const auto outputMessageSize = msg.getLength();
+	if (outputMessageSize < g_configManager().getNumber(PACKET_COMPRESSION_MIN_SIZE, __FUNCTION__)) {
+		return false;
+	}
+
 	if (outputMessageSize > NETWORKMESSAGE_MAXSIZE) {
 		g_logger().error("[NetworkMessage::compression] - Exceded NetworkMessage max size: {}, actually size: {}", NETWORKMESSAGE_MAXSIZE, outputMessageSize);
 		return false;
 	}
 
-	compress->stream->next_in = msg.getOutputBuffer();
-	compress->stream->avail_in = outputMessageSize;
-	compress->stream->next_out = reinterpret_cast<Bytef*>(compress->buffer.data());
-	compress->stream->avail_out = NETWORKMESSAGE_MAXSIZE;
+	compressionStats.inputBytes += outputMessageSize;
 
-	const int32_t ret = deflate(compress->stream.get(), Z_FINISH);
-	if (ret != Z_OK && ret != Z_STREAM_END) {
+	auto &sizeClass = compressionClasses[outputMessageSize < 512 ? 0 : (outputMessageSize < 4096 ? 1 : 2)];
+	const auto maxCost = static_cast<uint32_t>(std::max<int32_t>(0, g_configManager().getNumber(PACKET_COMPRESSION_MAX_COST, __FUNCTION__)));
+	if (maxCost != 0 && sizeClass.cost > maxCost && sizeClass.skipped < COMPRESSION_PROBE_INTERVAL) {
+		++sizeClass.skipped;
+		++compressionStats.skippedMessages;
+		compressionStats.outputBytes += outputMessageSize;
 		return false;
 	}
+	sizeClass.skipped = 0;
 
-	const auto totalSize = compress->stream->total_out;
-	deflateReset(compress->stream.get());
+	const auto start = std::chrono::steady_clock::now();
+	const auto totalSize = compress->compress(msg.getOutputBuffer(), outputMessageSize);
+	const auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
 
-	if (totalSize == 0) {
+	const auto saved = totalSize != 0 && totalSize < outputMessageSize ? outputMessageSize - totalSize : 0;
+	const auto cost = static_cast<uint32_t>(std::min<int64_t>(elapsed / std::max<size_t>(saved, 1), std::numeric_limits<uint16_t>::max()));
+	sizeClass.cost = sizeClass.cost == 0 ? cost : (sizeClass.cost * 3 + cost) / 4;
+
+	// Nothing saved, the raw packet is not bigger
+	if (saved == 0) {
+		++compressionStats.skippedMessages;
+		compressionStats.outputBytes += outputMessageSize;
 		return false;
 	}
 
+	++compressionStats.compressedMessages;
+	compressionStats.outputBytes += totalSize;
+
 	msg.reset();
 	msg.addBytes(compress->buffer.data(), totalSize);
 
@@ -28,7 +28,11 @@ public:
 	virtual void onSendMessage(const OutputMessage_ptr &msg);
 	bool onRecvMessage(NetworkMessage &msg);
 	bool sendRecvMessageCallback(NetworkMessage &msg);
-	virtual void onRecvFirstMessage(NetworkMessage &msg) = 0;
+	/**
+	 * @return true when the connection must not read the next packet yet, the protocol resumes it
+	 * (Connection::resumeWork) once done with the message.
+	 */
+	virtual bool onRecvFirstMessage(NetworkMessage &msg) = 0;
 	virtual void onConnect() { }
 
 	bool isConnectionExpired() const {
@@ -44,10 +48,36 @@ public:
 	// Use this function for autosend messages only
 	OutputMessage_ptr getOutputBuffer(int32_t size);
 
+	/**
+	 * Queues a packet shared by many protocols, it is copied to the output buffer right before it is sent
+	 * (see OutputMessagePool::sendAll) or before the next packet written directly, so the order is kept.
+	 */
+	void queueSharedMessage(std::shared_ptr<const NetworkMessage> msg) {
+		sharedMessages.emplace_back(std::move(msg));
+	}
+	bool hasSharedMessages() const {
+		return !sharedMessages.empty();
+	}
+	// Only touches this protocol's buffer, so it may run in parallel for different protocols
+	void flushSharedMessages();
+
 	OutputMessage_ptr &getCurrentBuffer() {
 		return outputBuffer;
 	}
 
+	struct CompressionStats {
+		// Bytes of the packets big enough to be compressed, before and after it
+		uint64_t inputBytes = 0;
+		uint64_t outputBytes = 0;
+		uint32_t compressedMessages = 0;
+		uint32_t skippedMessages = 0;
+	};
+
+	// Updated by the network thread of the connection
+	const CompressionStats &getCompressionStats() const {
+		return compressionStats;
+	}
+
 	void send(OutputMessage_ptr msg) const {
 		if (auto connection = getConnection();
 		    connection != nullptr) {
@@ -56,6 +86,15 @@ public:
 	}
 
 protected:
+	/**
+	 * Runs the RSA decryption and the credential check of a login on the crypto lane of the thread pool,
+	 * away from the network threads and the dispatcher. The task may keep using the first message, the
+	 * connection (and its message) stays alive and reads nothing else until the task resumes or closes it.
+	 * When loginCryptoQueueLimit logins are already waiting the connection is closed instead, the client retries.
+	 * @return whether the task was queued.
+	 */
+	bool detachLoginTask(std::function<void()> task);
+
 	void disconnect() const {
 		if (auto connection = getConnection()) {
 			connection->close();
@@ -74,6 +113,12 @@ protected:
 
 	static bool RSA_decrypt(NetworkMessage &msg);
 
+public:
+	// The XTEA of the packets on a plain buffer of a multiple of 8 bytes, for the tools that speak the protocol as a client
+	static void xteaEncrypt(uint8_t* buffer, size_t length, const std::array<uint32_t, 4> &key);
+	static void xteaDecrypt(uint8_t* buffer, size_t length, const std::array<uint32_t, 4> &key);
+
+protected:
 	void setRawMessages(bool value) {
 		rawMessages = value;
 	}
@@ -88,6 +133,12 @@ private:
 				return;
 			}
 
+#ifdef FEATURE_LIBDEFLATE
+			compressor = libdeflate_alloc_compressor(compressionLevel);
+			if (!compressor) {
+				g_logger().error("[Protocol::enableCompression()] - libdeflate_alloc_compressor error for level {}", compressionLevel);
+			}
+#else
 			stream = std::make_unique<z_stream>();
 			stream->zalloc = nullptr;
 			stream->zfree = nullptr;
@@ -97,21 +148,57 @@ private:
 				stream.reset();
 				g_logger().error("[Protocol::enableCompression()] - Zlib deflateInit2 error: {}", (stream->msg ? stream->msg : " unknown error"));
 			}
+#endif
 		}
 
 		~ZStream() {
+#ifdef FEATURE_LIBDEFLATE
+			if (compressor) {
+				libdeflate_free_compressor(compressor);
+			}
+#else
 			deflateEnd(stream.get());
+#endif
+		}
+
+		bool isEnabled() const {
+#ifdef FEATURE_LIBDEFLATE
+			return compressor != nullptr;
+#else
+			return stream != nullptr;
+#endif
 		}
 
+		// Raw deflate of the input into buffer, returns the compressed size, 0 on failure
+		size_t compress(uint8_t* input, size_t size);
+
+#ifdef FEATURE_LIBDEFLATE
+		libdeflate_compressor* compressor = nullptr;
+#else
 		std::unique_ptr<z_stream> stream;
+#endif
 		std::array<char, NETWORKMESSAGE_MAXSIZE> buffer {};
 	};
 
+	// Adaptive compression state of a packet size class
+	struct CompressionClass {
+		// Average nanoseconds spent per byte saved, 0 until measured
+		uint32_t cost = 0;
+		// Packets sent raw since the class was last measured
+		uint8_t skipped = 0;
+	};
+
 	void XTEA_encrypt(OutputMessage &msg) const;
 	bool XTEA_decrypt(NetworkMessage &msg) const;
-	bool compression(OutputMessage &msg) const;
+	bool compression(OutputMessage &msg);
+
+	OutputMessage_ptr reserveOutputBuffer(int32_t size);
 
 	OutputMessage_ptr outputBuffer;
+	std::vector<std::shared_ptr<const NetworkMessage>> sharedMessages;
+	// Small (< 512 bytes), medium (< 4 KB) and large packets
+	std::array<CompressionClass, 3> compressionClasses;
+	CompressionStats compressionStats;
 
 	const ConnectionWeak_ptr connectionPtr;
 	std::array<uint32_t, 4> key = {};
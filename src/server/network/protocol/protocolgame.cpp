@@ -36,7 +36,9 @@
 #include "creatures/combat/spells.hpp"
 #include "utils/tools.hpp"
 #include "creatures/players/management/waitlist.hpp"
+#include "creatures/players/management/login_queue.hpp"
 #include "items/weapons/weapons.hpp"
+#include "lib/metrics/metrics.hpp"
 #include "enums/object_category.hpp"
 #include "enums/account_type.hpp"
 #include "enums/account_group_type.hpp"
@@ -245,6 +247,117 @@ namespace {
 			msg.addString(toStartCaseWithSpace(magic_enum::enum_name(value).data()), "void sendContainerCategory - toStartCaseWithSpace(magic_enum::enum_name(value).data())");
 		}
 	}
+
+	/**
+	 * Serialized descriptions of the tiles without creatures, by position and protocol version.
+	 * An entry is valid while the tile keeps the version it was serialized at (see Tile::getVersion).
+	 */
+	class TileDescriptionCache {
+	public:
+		// Items whose bytes change without the tile changing (timers, charges, podiums, wrap kits) can not be cached
+		static bool isCacheable(const std::shared_ptr<Tile> &tile) {
+			const auto* creatures = tile->getCreatures();
+			if (creatures && !creatures->empty()) {
+				return false;
+			}
+
+			const auto isStatic = [](const std::shared_ptr<Item> &item) {
+				const ItemType &it = Item::items[item->getID()];
+				return !it.expire && !it.expireStop && !it.clockExpire && !it.wearOut && !it.isPodium && !it.isWrapKit;
+			};
+
+			if (const auto &ground = tile->getGround(); ground && !isStatic(ground)) {
+				return false;
+			}
+
+			const auto* items = tile->getItemList();
+			return !items || std::ranges::all_of(*items, isStatic);
+		}
+
+		bool copyTo(const std::shared_ptr<Tile> &tile, bool oldProtocol, NetworkMessage &msg) {
+			bool found = false;
+			descriptions.if_contains(getKey(tile->getPosition(), oldProtocol), [&](const auto &entry) {
+				if (entry.second.version == tile->getVersion()) {
+					msg.addBytes(reinterpret_cast<const char*>(entry.second.bytes.data()), entry.second.bytes.size());
+					found = true;
+				}
+			});
+			return found;
+		}
+
+		void store(const std::shared_ptr<Tile> &tile, bool oldProtocol, const uint8_t* bytes, size_t size) {
+			const auto maxSize = static_cast<size_t>(g_configManager().getNumber(TILE_DESCRIPTION_CACHE_SIZE, __FUNCTION__));
+			if (descriptions.size() >= maxSize) {
+				descriptions.clear();
+			}
+
+			descriptions.insert_or_assign(getKey(tile->getPosition(), oldProtocol), Description { tile->getVersion(), std::vector<uint8_t>(bytes, bytes + size) });
+		}
+
+	private:
+		struct Description {
+			uint32_t version;
+			std::vector<uint8_t> bytes;
+		};
+
+		static uint64_t getKey(const Position &pos, bool oldProtocol) {
+			return static_cast<uint64_t>(pos.x) | (static_cast<uint64_t>(pos.y) << 16) | (static_cast<uint64_t>(pos.z) << 32) | (static_cast<uint64_t>(oldProtocol) << 40);
+		}
+
+		phmap::parallel_flat_hash_map_m<uint64_t, Description> descriptions;
+	};
+
+	TileDescriptionCache tileDescriptionCache;
+
+	// Room left in the message for the biggest tile description, so a cached one is never cut short
+	constexpr size_t TILE_DESCRIPTION_MAX_SIZE = 4096;
+
+	struct PacketRateLimit {
+		double rate = 0;
+		double burst = 0;
+	};
+
+	// The packetRateLimits by opcode, parsed again when the config changes, only used by the dispatcher thread
+	const std::array<PacketRateLimit, 256> &getPacketRateLimits() {
+		static std::string source;
+		static std::array<PacketRateLimit, 256> limits {};
+		const auto &config = g_configManager().getString(PACKET_RATE_LIMITS, __FUNCTION__);
+		if (config == source) {
+			return limits;
+		}
+
+		source = config;
+		limits = {};
+		for (const auto &entry : explodeString(config, ",")) {
+			const auto fields = explodeString(entry, ":");
+			if (fields.size() != 3) {
+				g_logger().warn("[{}] - invalid packet rate limit '{}', expected opcode:rate:burst", __FUNCTION__, entry);
+				continue;
+			}
+
+			const auto opcode = std::strtol(fields[0].c_str(), nullptr, 0);
+			const auto rate = std::strtod(fields[1].c_str(), nullptr);
+			const auto burst = std::strtod(fields[2].c_str(), nullptr);
+			if (opcode < 0 || opcode > 0xFF || rate <= 0 || burst < 1) {
+				g_logger().warn("[{}] - invalid packet rate limit '{}'", __FUNCTION__, entry);
+				continue;
+			}
+			limits[opcode] = { rate, burst };
+		}
+		return limits;
+	}
+
+	// The opcode label of the packet metrics, formatted once
+	const std::string &getOpcodeLabel(uint8_t opcode) {
+		static const auto labels = [] {
+			std::array<std::string, 256> result;
+			for (size_t i = 0; i < result.size(); ++i) {
+				result[i] = fmt::format("0x{:02X}", i);
+			}
+			return result;
+		}();
+		return labels[opcode];
+	}
 } // namespace
 
 ProtocolGame::ProtocolGame(Connection_ptr initConnection) :
@@ -466,7 +579,7 @@ void ProtocolGame::release() {
 	Protocol::release();
 }
 
-void ProtocolGame::login(const std::string &name, uint32_t accountId, OperatingSystem_t operatingSystem) {
+void ProtocolGame::login(const std::shared_ptr<Player> &loadingPlayer, OperatingSystem_t operatingSystem) {
 	// OTCV8 features
 	if (otclientV8 > 0) {
 		sendFeatures();
@@ -485,26 +598,13 @@ void ProtocolGame::login(const std::string &name, uint32_t accountId, OperatingS
 	g_logger().debug("Player logging in in version '{}' and oldProtocol '{}'", getVersion(), oldProtocol);
 
 	// dispatcher thread
-	std::shared_ptr<Player> foundPlayer = g_game().getPlayerUniqueLogin(name);
+	std::shared_ptr<Player> foundPlayer = g_game().getPlayerUniqueLogin(loadingPlayer->getName());
 	if (!foundPlayer) {
-		player = std::make_shared<Player>(getThis());
-		player->setName(name);
+		player = loadingPlayer;
 		g_game().addPlayerUniqueLogin(player);
 
 		player->setID();
 
-		if (!IOLoginDataLoad::preLoadPlayer(player, name)) {
-			g_game().removePlayerUniqueLogin(player);
-			disconnectClient("Your character could not be loaded.");
-			return;
-		}
-
-		if (IOBan::isPlayerNamelocked(player->getGUID())) {
-			g_game().removePlayerUniqueLogin(player);
-			disconnectClient("Your character has been namelocked.");
-			return;
-		}
-
 		if (g_game().getGameState() == GAME_STATE_CLOSING && !player->hasFlag(PlayerFlags_t::CanAlwaysLogin)) {
 			g_game().removePlayerUniqueLogin(player);
 			disconnectClient("The game is just going down.\nPlease try again later.");
@@ -536,27 +636,6 @@ void ProtocolGame::login(const std::string &name, uint32_t accountId, OperatingS
 			return;
 		}
 
-		if (!player->hasFlag(PlayerFlags_t::CannotBeBanned)) {
-			BanInfo banInfo;
-			if (IOBan::isAccountBanned(accountId, banInfo)) {
-				if (banInfo.reason.empty()) {
-					banInfo.reason = "(none)";
-				}
-
-				std::ostringstream ss;
-				if (banInfo.expiresAt > 0) {
-					ss << "Your account has been banned until " << formatDateShort(banInfo.expiresAt) << " by " << banInfo.bannedBy << ".\n\nReason specified:\n"
-					   << banInfo.reason;
-				} else {
-					ss << "Your account has been permanently banned by " << banInfo.bannedBy << ".\n\nReason specified:\n"
-					   << banInfo.reason;
-				}
-				g_game().removePlayerUniqueLogin(player);
-				disconnectClient(ss.str());
-				return;
-			}
-		}
-
 		WaitingList &waitingList = WaitingList::getInstance();
 		if (!waitingList.clientLogin(player)) {
 			auto currentSlot = static_cast<uint32_t>(waitingList.getClientSlot(player));
@@ -576,62 +655,92 @@ void ProtocolGame::login(const std::string &name, uint32_t accountId, OperatingS
 			return;
 		}
 
-		if (!IOLoginData::loadPlayerById(player, player->getGUID(), false)) {
-			g_game().removePlayerUniqueLogin(player);
-			disconnectClient("Your character could not be loaded.");
-			g_logger().warn("Player {} could not be loaded", player->getName());
-			return;
-		}
+		// The character is loaded on the thread pool, it enters the world with the next login batch
+		LoginQueue::getInstance().reserve();
+		player->loadingAsync = true;
+		inject<ThreadPool>().detachTask(ThreadLane::Database, [self = getThis(), loadingPlayer, operatingSystem] {
+			const bool loaded = IOLoginData::loadPlayerById(loadingPlayer, loadingPlayer->getGUID(), false);
+			LoginQueue::getInstance().push([self, loadingPlayer, loaded, operatingSystem] {
+				self->enterWorld(loadingPlayer, loaded, operatingSystem);
+			});
+		});
+		return;
+	}
 
-		player->setOperatingSystem(operatingSystem);
+	if (eventConnect != 0 || foundPlayer->loadingAsync || !g_configManager().getBoolean(REPLACE_KICK_ON_LOGIN, __FUNCTION__)) {
+		// Already trying to connect
+		disconnectClient("You are already logged in.");
+		return;
+	}
 
-		const auto tile = g_game().map.getOrCreateTile(player->getLoginPosition());
-		// moving from a pz tile to a non-pz tile
-		if (maxOnline > 1 && player->getAccountType() < ACCOUNT_TYPE_GAMEMASTER && !tile->hasFlag(TILESTATE_PROTECTIONZONE)) {
-			auto maxOutsizePZ = g_configManager().getNumber(MAX_PLAYERS_OUTSIDE_PZ_PER_ACCOUNT, __FUNCTION__);
-			auto accountPlayers = g_game().getPlayersByAccount(player->getAccount());
-			int countOutsizePZ = 0;
-			for (const auto &accountPlayer : accountPlayers) {
-				if (accountPlayer != player && accountPlayer->getTile() && !accountPlayer->getTile()->hasFlag(TILESTATE_PROTECTIONZONE)) {
-					++countOutsizePZ;
-				}
-			}
-			if (countOutsizePZ >= maxOutsizePZ) {
-				g_game().removePlayerUniqueLogin(player);
-				disconnectClient(fmt::format("You can only have {} character{} from your account outside of a protection zone.", maxOutsizePZ == 1 ? "one" : std::to_string(maxOutsizePZ), maxOutsizePZ > 1 ? "s" : ""));
-				return;
+	if (foundPlayer->client) {
+		foundPlayer->disconnect();
+		foundPlayer->isConnecting = true;
+
+		eventConnect = g_dispatcher().scheduleEvent(
+			1000,
+			[self = getThis(), playerName = foundPlayer->getName(), operatingSystem] { self->connect(playerName, operatingSystem); }, "ProtocolGame::connect"
+		);
+	} else {
+		connect(foundPlayer->getName(), operatingSystem);
+	}
+	OutputMessagePool::getInstance().addProtocolToAutosend(shared_from_this());
+	sendBosstiaryCooldownTimer();
+}
+
+void ProtocolGame::enterWorld(const std::shared_ptr<Player> &loadedPlayer, bool loaded, OperatingSystem_t operatingSystem) {
+	if (player != loadedPlayer || isConnectionExpired()) {
+		// The client left while the character was being loaded
+		g_game().removePlayerUniqueLogin(loadedPlayer);
+		return;
+	}
+
+	if (!loaded || !IOLoginData::finishLoadPlayer(player)) {
+		g_game().removePlayerUniqueLogin(player);
+		disconnectClient("Your character could not be loaded.");
+		g_logger().warn("Player {} could not be loaded", player->getName());
+		return;
+	}
+
+	player->setOperatingSystem(operatingSystem);
+
+	// Other characters of the account may have entered while this one was loaded
+	auto maxOnline = g_configManager().getNumber(MAX_PLAYERS_PER_ACCOUNT, __FUNCTION__);
+	if (player->getAccountType() < ACCOUNT_TYPE_GAMEMASTER && g_game().getPlayersByAccount(player->getAccount()).size() >= maxOnline) {
+		g_game().removePlayerUniqueLogin(player);
+		disconnectClient(fmt::format("You may only login with {} character{}\nof your account at the same time.", maxOnline, maxOnline > 1 ? "s" : ""));
+		return;
+	}
+
+	const auto tile = g_game().map.getOrCreateTile(player->getLoginPosition());
+	// moving from a pz tile to a non-pz tile
+	if (maxOnline > 1 && player->getAccountType() < ACCOUNT_TYPE_GAMEMASTER && !tile->hasFlag(TILESTATE_PROTECTIONZONE)) {
+		auto maxOutsizePZ = g_configManager().getNumber(MAX_PLAYERS_OUTSIDE_PZ_PER_ACCOUNT, __FUNCTION__);
+		auto accountPlayers = g_game().getPlayersByAccount(player->getAccount());
+		int countOutsizePZ = 0;
+		for (const auto &accountPlayer : accountPlayers) {
+			if (accountPlayer != player && accountPlayer->getTile() && !accountPlayer->getTile()->hasFlag(TILESTATE_PROTECTIONZONE)) {
+				++countOutsizePZ;
 			}
 		}
-
-		if (!g_game().placeCreature(player, player->getLoginPosition()) && !g_game().placeCreature(player, player->getTemplePosition(), false, true)) {
+		if (countOutsizePZ >= maxOutsizePZ) {
 			g_game().removePlayerUniqueLogin(player);
-			disconnectClient("Temple position is wrong. Please, contact the administrator.");
-			g_logger().warn("Player {} temple position is wrong", player->getName());
+			disconnectClient(fmt::format("You can only have {} character{} from your account outside of a protection zone.", maxOutsizePZ == 1 ? "one" : std::to_string(maxOutsizePZ), maxOutsizePZ > 1 ? "s" : ""));
 			return;
 		}
+	}
 
-		player->lastIP = player->getIP();
-		player->lastLoginSaved = std::max<time_t>(time(nullptr), player->lastLoginSaved + 1);
-		acceptPackets = true;
-	} else {
-		if (eventConnect != 0 || !g_configManager().getBoolean(REPLACE_KICK_ON_LOGIN, __FUNCTION__)) {
-			// Already trying to connect
-			disconnectClient("You are already logged in.");
-			return;
-		}
+	if (!g_game().placeCreature(player, player->getLoginPosition()) && !g_game().placeCreature(player, player->getTemplePosition(), false, true)) {
+		g_game().removePlayerUniqueLogin(player);
+		disconnectClient("Temple position is wrong. Please, contact the administrator.");
+		g_logger().warn("Player {} temple position is wrong", player->getName());
+		return;
+	}
 
-		if (foundPlayer->client) {
-			foundPlayer->disconnect();
-			foundPlayer->isConnecting = true;
+	player->lastIP = player->getIP();
+	player->lastLoginSaved = std::max<time_t>(time(nullptr), player->lastLoginSaved + 1);
+	acceptPackets = true;
 
-			eventConnect = g_dispatcher().scheduleEvent(
-				1000,
-				[self = getThis(), playerName = foundPlayer->getName(), operatingSystem] { self->connect(playerName, operatingSystem); }, "ProtocolGame::connect"
-			);
-		} else {
-			connect(foundPlayer->getName(), operatingSystem);
-		}
-	}
 	OutputMessagePool::getInstance().addProtocolToAutosend(shared_from_this());
 	sendBosstiaryCooldownTimer();
 }
@@ -701,10 +810,10 @@ void ProtocolGame::logout(bool displayEffect, bool forced) {
 	g_game().removeCreature(player, true);
 }
 
-void ProtocolGame::onRecvFirstMessage(NetworkMessage &msg) {
+bool ProtocolGame::onRecvFirstMessage(NetworkMessage &msg) {
 	if (g_game().getGameState() == GAME_STATE_SHUTDOWN) {
 		disconnect();
-		return;
+		return true;
 	}
 
 	OperatingSystem_t operatingSystem = static_cast<OperatingSystem_t>(msg.get<uint16_t>());
@@ -723,10 +832,10 @@ void ProtocolGame::onRecvFirstMessage(NetworkMessage &msg) {
 	clientVersion = static_cast<int32_t>(msg.get<uint32_t>());
 
 	if (!oldProtocol) {
-		auto clientVersionString = msg.getString(); // Client version (String)
+		auto clientVersionString = msg.getStringView(); // Client version (String)
 		g_logger().trace("Client version: {}", clientVersionString);
 		if (version >= 1334) {
-			auto assetHashIdentifier = msg.getString(); // Assets hash identifier
+			auto assetHashIdentifier = msg.getStringView(); // Assets hash identifier
 			g_logger().trace("Client asset hash identifier: {}", assetHashIdentifier);
 		}
 	}
@@ -739,8 +848,16 @@ void ProtocolGame::onRecvFirstMessage(NetworkMessage &msg) {
 	auto gamePreviewState = msg.getByte(); // U8 game preview state
 	g_logger().trace("Game preview state: {}", gamePreviewState);
 
+	// The connection reads nothing else until the message is decrypted and the XTEA key is set
+	detachLoginTask([self = getThis(), &msg, operatingSystem] {
+		self->parseLoginMessage(msg, operatingSystem);
+	});
+	return true;
+}
+
+void ProtocolGame::parseLoginMessage(NetworkMessage &msg, OperatingSystem_t operatingSystem) {
 	if (!Protocol::RSA_decrypt(msg)) {
-		g_logger().warn("[ProtocolGame::onRecvFirstMessage] - RSA Decrypt Failed");
+		g_logger().warn("[ProtocolGame::parseLoginMessage] - RSA Decrypt Failed");
 		disconnect();
 		return;
 	}
@@ -777,8 +894,8 @@ void ProtocolGame::onRecvFirstMessage(NetworkMessage &msg) {
 
 	if (!oldProtocol && operatingSystem == CLIENTOS_NEW_LINUX) {
 		// TODO: check what new info for linux is send
-		msg.getString();
-		msg.getString();
+		msg.getStringView();
+		msg.getStringView();
 	}
 
 	std::string characterName = msg.getString();
@@ -827,13 +944,23 @@ void ProtocolGame::onRecvFirstMessage(NetworkMessage &msg) {
 		return;
 	}
 
+	// The packets that come before the player is in the world are parsed by the dispatcher as before
+	if (const auto connection = getConnection()) {
+		connection->resumeWork();
+	}
+
+	// The password check is the other half of the crypto work, the rest of the login runs here with it
+	authenticate(accountDescriptor, password, characterName, operatingSystem);
+}
+
+void ProtocolGame::authenticate(const std::string &accountDescriptor, const std::string &password, std::string &characterName, OperatingSystem_t operatingSystem) {
+	std::ostringstream ss;
 	BanInfo banInfo;
 	if (IOBan::isIpBanned(getIP(), banInfo)) {
 		if (banInfo.reason.empty()) {
 			banInfo.reason = "(none)";
 		}
 
-		ss.str(std::string());
 		ss << "Your IP has been banned until " << formatDateShort(banInfo.expiresAt) << " by " << banInfo.bannedBy << ".\n\nReason specified:\n"
 		   << banInfo.reason;
 		disconnectClient(ss.str());
@@ -842,8 +969,7 @@ void ProtocolGame::onRecvFirstMessage(NetworkMessage &msg) {
 
 	uint32_t accountId;
 	if (!IOLoginData::gameWorldAuthentication(accountDescriptor, password, characterName, accountId, oldProtocol)) {
-		ss.str(std::string());
-		if (authType == "session") {
+		if (g_configManager().getString(AUTH_TYPE, __FUNCTION__) == "session") {
 			ss << "Your session has expired. Please log in again.";
 		} else { // authType == "password"
 			ss << "Your " << (oldProtocol ? "username" : "email") << " or password is not correct.";
@@ -851,7 +977,7 @@ void ProtocolGame::onRecvFirstMessage(NetworkMessage &msg) {
 
 		auto output = OutputMessagePool::getOutputMessage();
 		output->addByte(0x14);
-		output->addString(ss.str(), "ProtocolGame::onRecvFirstMessage - ss.str()");
+		output->addString(ss.str(), "ProtocolGame::authenticate - ss.str()");
 		send(output);
 		g_dispatcher().scheduleEvent(
 			1000, [self = getThis()] { self->disconnect(); }, "ProtocolGame::disconnect"
@@ -859,7 +985,35 @@ void ProtocolGame::onRecvFirstMessage(NetworkMessage &msg) {
 		return;
 	}
 
-	g_dispatcher().addEvent([self = getThis(), characterName, accountId, operatingSystem] { self->login(characterName, accountId, operatingSystem); }, "ProtocolGame::login");
+	const auto loadingPlayer = std::make_shared<Player>(getThis());
+	loadingPlayer->setName(characterName);
+	if (!IOLoginDataLoad::preLoadPlayer(loadingPlayer, characterName)) {
+		disconnectClient("Your character could not be loaded.");
+		return;
+	}
+
+	if (IOBan::isPlayerNamelocked(loadingPlayer->getGUID())) {
+		disconnectClient("Your character has been namelocked.");
+		return;
+	}
+
+	if (!loadingPlayer->hasFlag(PlayerFlags_t::CannotBeBanned) && IOBan::isAccountBanned(accountId, banInfo)) {
+		if (banInfo.reason.empty()) {
+			banInfo.reason = "(none)";
+		}
+
+		if (banInfo.expiresAt > 0) {
+			ss << "Your account has been banned until " << formatDateShort(banInfo.expiresAt) << " by " << banInfo.bannedBy << ".\n\nReason specified:\n"
+			   << banInfo.reason;
+		} else {
+			ss << "Your account has been permanently banned by " << banInfo.bannedBy << ".\n\nReason specified:\n"
+			   << banInfo.reason;
+		}
+		disconnectClient(ss.str());
+		return;
+	}
+
+	g_dispatcher().addEvent([self = getThis(), loadingPlayer, operatingSystem] { self->login(loadingPlayer, operatingSystem); }, "ProtocolGame::login");
 }
 
 void ProtocolGame::onConnect() {
@@ -898,6 +1052,23 @@ void ProtocolGame::disconnectClient(const std::string &message) const {
 	disconnect();
 }
 
+BroadcastMessage::BroadcastMessage(Builder builder) :
+	builder(std::move(builder)) { }
+
+BroadcastMessage::BroadcastMessage(const Position &visiblePosition, Builder builder) :
+	builder(std::move(builder)), visiblePosition(visiblePosition) { }
+
+BroadcastMessage::~BroadcastMessage() = default;
+
+const std::shared_ptr<NetworkMessage> &BroadcastMessage::get(bool oldProtocol) {
+	auto &msg = messages[oldProtocol ? 1 : 0];
+	if (!msg) {
+		msg = std::make_shared<NetworkMessage>();
+		builder(*msg, oldProtocol);
+	}
+	return msg;
+}
+
 void ProtocolGame::writeToOutputBuffer(const NetworkMessage &msg) {
 	auto out = getOutputBuffer(msg.getLength());
 	out->append(msg);
@@ -929,8 +1100,8 @@ void ProtocolGame::parsePacket(NetworkMessage &msg) {
 	}
 
 	// Modules system
-	if (player && recvbyte != 0xD3) {
-		g_modules().executeOnRecvbyte(player->getID(), msg, recvbyte);
+	if (recvbyte != 0xD3 && g_modules().hasRecvbyte(recvbyte)) {
+		g_modules().executeOnRecvbyte(player, msg, recvbyte);
 	}
 
 	parsePacketFromDispatcher(msg, recvbyte);
@@ -984,7 +1155,7 @@ void ProtocolGame::addBless() {
 	player->checkAndShowBlessingMessage();
 }
 
-void ProtocolGame::parsePacketFromDispatcher(NetworkMessage msg, uint8_t recvbyte) {
+void ProtocolGame::parsePacketFromDispatcher(NetworkMessage &msg, uint8_t recvbyte) {
 	if (!acceptPackets || g_game().getGameState() == GAME_STATE_SHUTDOWN) {
 		return;
 	}
@@ -993,6 +1164,19 @@ void ProtocolGame::parsePacketFromDispatcher(NetworkMessage msg, uint8_t recvbyt
 		return;
 	}
 
+	const auto &limit = getPacketRateLimits()[recvbyte];
+	PacketBucket* bucket = nullptr;
+	if (limit.rate > 0) {
+		bucket = &packetBuckets[recvbyte];
+		if (!consumePacketToken(*bucket, limit.rate, limit.burst)) {
+			g_logger().debug("[{}] - player {} exceeded the rate limit of packet 0x{:02X}", __FUNCTION__, player->getName(), recvbyte);
+			g_metrics().addCounter("packet_rate_limited", 1, { { "opcode", getOpcodeLabel(recvbyte) } });
+			return;
+		}
+	}
+
+	const auto dispatchStart = std::chrono::steady_clock::now();
+
 	switch (recvbyte) {
 		case 0x14:
 			logout(true, false);
@@ -1373,6 +1557,33 @@ void ProtocolGame::parsePacketFromDispatcher(NetworkMessage msg, uint8_t recvbyt
 			g_logger().debug("Player '{}' sent unknown packet header: hex[{}], decimal[{}]", player->getName(), asUpperCaseString(hexString), recvbyte);
 			break;
 	}
+
+	const auto cost = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - dispatchStart).count();
+	if (bucket) {
+		// The slow requests also pay for the time they took
+		if (const auto costUnit = g_configManager().getNumber(PACKET_RATE_LIMIT_COST, __FUNCTION__); costUnit > 0) {
+			bucket->tokens -= static_cast<double>(cost) / costUnit;
+		}
+	}
+	if (g_metrics().isEnabled()) {
+		g_metrics().addCounter("packet_dispatch_cost", static_cast<double>(cost), { { "opcode", getOpcodeLabel(recvbyte) } });
+	}
+}
+
+bool ProtocolGame::consumePacketToken(PacketBucket &bucket, double rate, double burst) {
+	const int64_t now = OTSYS_TIME();
+	if (bucket.lastRefill == 0) {
+		bucket.tokens = burst;
+	} else {
+		bucket.tokens = std::min(burst, bucket.tokens + static_cast<double>(now - bucket.lastRefill) * rate / 1000);
+	}
+	bucket.lastRefill = now;
+
+	if (bucket.tokens < 1) {
+		return false;
+	}
+	bucket.tokens -= 1;
+	return true;
 }
 
 void ProtocolGame::parseHotkeyEquip(NetworkMessage &msg) {
@@ -1386,6 +1597,25 @@ void ProtocolGame::parseHotkeyEquip(NetworkMessage &msg) {
 }
 
 void ProtocolGame::GetTileDescription(std::shared_ptr<Tile> tile, NetworkMessage &msg) {
+	static const bool cacheEnabled = g_configManager().getNumber(TILE_DESCRIPTION_CACHE_SIZE, __FUNCTION__) > 0;
+	if (!cacheEnabled || !TileDescriptionCache::isCacheable(tile)) {
+		SerializeTileDescription(tile, msg);
+		return;
+	}
+
+	if (tileDescriptionCache.copyTo(tile, oldProtocol, msg)) {
+		return;
+	}
+
+	const auto start = msg.getBufferPosition();
+	const bool hasRoom = start + TILE_DESCRIPTION_MAX_SIZE < MAX_BODY_LENGTH;
+	SerializeTileDescription(tile, msg);
+	if (hasRoom) {
+		tileDescriptionCache.store(tile, oldProtocol, msg.getBuffer() + start, msg.getBufferPosition() - start);
+	}
+}
+
+void ProtocolGame::SerializeTileDescription(const std::shared_ptr<Tile> &tile, NetworkMessage &msg) {
 	if (oldProtocol) {
 		msg.add<uint16_t>(0x00); // Env effects
 	}
@@ -1500,48 +1730,28 @@ void ProtocolGame::GetFloorDescription(NetworkMessage &msg, int32_t x, int32_t y
 }
 
 void ProtocolGame::checkCreatureAsKnown(uint32_t id, bool &known, uint32_t &removedKnown) {
-	if (auto [creatureKnown, creatureInserted] = knownCreatureSet.insert(id);
-	    !creatureInserted) {
+	if (!knownCreatureSet.insert(id)) {
 		known = true;
 		return;
 	}
 	known = false;
-	if (knownCreatureSet.size() > 1300) {
-		// Look for a creature to remove
-		for (auto it = knownCreatureSet.begin(), end = knownCreatureSet.end(); it != end; ++it) {
-			if (*it == id) {
-				continue;
-			}
+	if (knownCreatureSet.size() > KnownCreatureSet::MAX_KNOWN) {
+		// Look for a creature to remove, if none can be removed anyone is (bad situation)
+		removedKnown = knownCreatureSet.evict(id, [this](uint32_t knownId) {
 			// We need to protect party players from removing
-			std::shared_ptr<Creature> creature = g_game().getCreatureByID(*it);
+			std::shared_ptr<Creature> creature = g_game().getCreatureByID(knownId);
 			if (std::shared_ptr<Player> checkPlayer;
 			    creature && (checkPlayer = creature->getPlayer()) != nullptr) {
-				if (player->getParty() != checkPlayer->getParty() && !canSee(creature)) {
-					removedKnown = *it;
-					knownCreatureSet.erase(it);
-					return;
-				}
-			} else if (!canSee(creature)) {
-				removedKnown = *it;
-				knownCreatureSet.erase(it);
-				return;
+				return player->getParty() != checkPlayer->getParty() && !canSee(creature);
 			}
-		}
-
-		// Bad situation. Let's just remove anyone.
-		auto it = knownCreatureSet.begin();
-		if (*it == id) {
-			++it;
-		}
-
-		removedKnown = *it;
-		knownCreatureSet.erase(it);
+			return !canSee(creature);
+		});
 	} else {
 		removedKnown = 0;
 	}
 }
 
-bool ProtocolGame::canSee(std::shared_ptr<Creature> c) const {
+bool ProtocolGame::canSee(const std::shared_ptr<Creature> &c) const {
 	if (!c || !player || c->isRemoved()) {
 		return false;
 	}
@@ -2146,7 +2356,14 @@ void ProtocolGame::parseCyclopediaCharacterInfo(NetworkMessage &msg) {
 	if (characterID == 0) {
 		characterID = player->getGUID();
 	}
-	g_game().playerCyclopediaCharacterInfo(player, characterID, characterInfoType, entriesPerPage, page);
+	g_dispatcher().addEvent(
+		[playerId = player->getID(), characterID, characterInfoType, entriesPerPage, page] {
+			if (const auto &player = g_game().getPlayerByID(playerId)) {
+				g_game().playerCyclopediaCharacterInfo(player, characterID, characterInfoType, entriesPerPage, page);
+			}
+		},
+		"Game::playerCyclopediaCharacterInfo", DISPATCHER_TASK_EXPIRATION
+	);
 }
 
 void ProtocolGame::parseHighscores(NetworkMessage &msg) {
@@ -2165,7 +2382,14 @@ void ProtocolGame::parseHighscores(NetworkMessage &msg) {
 		page = std::max<uint16_t>(1, msg.get<uint16_t>());
 	}
 	uint8_t entriesPerPage = std::min<uint8_t>(30, std::max<uint8_t>(5, msg.getByte()));
-	g_game().playerHighscores(player, type, category, vocation, worldName, page, entriesPerPage);
+	g_dispatcher().addEvent(
+		[playerId = player->getID(), type, category, vocation, worldName, page, entriesPerPage] {
+			if (const auto &player = g_game().getPlayerByID(playerId)) {
+				g_game().playerHighscores(player, type, category, vocation, worldName, page, entriesPerPage);
+			}
+		},
+		"Game::playerHighscores", DISPATCHER_TASK_EXPIRATION
+	);
 }
 
 void ProtocolGame::parseTaskHuntingAction(NetworkMessage &msg) {
@@ -3125,17 +3349,18 @@ void ProtocolGame::parseMarketLeave() {
 void ProtocolGame::parseMarketBrowse(NetworkMessage &msg) {
 	uint16_t browseId = oldProtocol ? msg.get<uint16_t>() : static_cast<uint16_t>(msg.getByte());
 
+	const auto playerId = player->getID();
 	if ((oldProtocol && browseId == MARKETREQUEST_OWN_OFFERS_OLD) || (!oldProtocol && browseId == MARKETREQUEST_OWN_OFFERS)) {
-		g_game().playerBrowseMarketOwnOffers(player->getID());
+		g_dispatcher().addEvent([playerId] { g_game().playerBrowseMarketOwnOffers(playerId); }, "Game::playerBrowseMarketOwnOffers", DISPATCHER_TASK_EXPIRATION);
 	} else if ((oldProtocol && browseId == MARKETREQUEST_OWN_HISTORY_OLD) || (!oldProtocol && browseId == MARKETREQUEST_OWN_HISTORY)) {
-		g_game().playerBrowseMarketOwnHistory(player->getID());
+		g_dispatcher().addEvent([playerId] { g_game().playerBrowseMarketOwnHistory(playerId); }, "Game::playerBrowseMarketOwnHistory", DISPATCHER_TASK_EXPIRATION);
 	} else if (!oldProtocol) {
 		uint16_t itemId = msg.get<uint16_t>();
 		uint8_t tier = msg.get<uint8_t>();
 		player->sendMarketEnter(player->getLastDepotId());
-		g_game().playerBrowseMarket(player->getID(), itemId, tier);
+		g_dispatcher().addEvent([playerId, itemId, tier] { g_game().playerBrowseMarket(playerId, itemId, tier); }, "Game::playerBrowseMarket", DISPATCHER_TASK_EXPIRATION);
 	} else {
-		g_game().playerBrowseMarket(player->getID(), browseId, 0);
+		g_dispatcher().addEvent([playerId, browseId] { g_game().playerBrowseMarket(playerId, browseId, 0); }, "Game::playerBrowseMarket", DISPATCHER_TASK_EXPIRATION);
 	}
 }
 
@@ -3240,7 +3465,7 @@ void ProtocolGame::sendChannelEvent(uint16_t channelId, const std::string &playe
 }
 
 void ProtocolGame::sendCreatureOutfit(std::shared_ptr<Creature> creature, const Outfit_t &outfit) {
-	if (!canSee(creature)) {
+	if (!canSee(creature) || deferCreatureUpdate(creature, DEFERRED_OUTFIT)) {
 		return;
 	}
 
@@ -3265,7 +3490,7 @@ void ProtocolGame::sendCreatureOutfit(std::shared_ptr<Creature> creature, const
 }
 
 void ProtocolGame::sendCreatureLight(std::shared_ptr<Creature> creature) {
-	if (!canSee(creature)) {
+	if (!canSee(creature) || deferCreatureUpdate(creature, DEFERRED_LIGHT)) {
 		return;
 	}
 
@@ -3292,7 +3517,7 @@ void ProtocolGame::addCreatureIcon(NetworkMessage &msg, std::shared_ptr<Creature
 }
 
 void ProtocolGame::sendCreatureIcon(std::shared_ptr<Creature> creature) {
-	if (!creature || !player || oldProtocol) {
+	if (!creature || !player || oldProtocol || deferCreatureUpdate(creature, DEFERRED_ICONS) || coalesceCycleUpdate(creature->getID(), CYCLE_ICONS)) {
 		return;
 	}
 
@@ -3305,6 +3530,214 @@ void ProtocolGame::sendCreatureIcon(std::shared_ptr<Creature> creature) {
 	writeToOutputBuffer(msg);
 }
 
+bool ProtocolGame::deferCreatureUpdate(const std::shared_ptr<Creature> &creature, DeferredUpdate_t update) {
+	if (sendingDeferredUpdates || !player || creature == player) {
+		return false;
+	}
+
+	const auto edgeDistance = g_configManager().getNumber(INTEREST_EDGE_DISTANCE, __FUNCTION__);
+	if (edgeDistance <= 0) {
+		return false;
+	}
+
+	int64_t delay = 0;
+	switch (update) {
+		case DEFERRED_OUTFIT:
+			delay = g_configManager().getNumber(INTEREST_OUTFIT_DELAY, __FUNCTION__);
+			break;
+		case DEFERRED_LIGHT:
+			delay = g_configManager().getNumber(INTEREST_LIGHT_DELAY, __FUNCTION__);
+			break;
+		case DEFERRED_ICONS:
+			delay = g_configManager().getNumber(INTEREST_ICONS_DELAY, __FUNCTION__);
+			break;
+		case DEFERRED_SKULL:
+			delay = g_configManager().getNumber(INTEREST_SKULL_DELAY, __FUNCTION__);
+			break;
+	}
+
+	if (delay <= 0) {
+		return false;
+	}
+
+	const auto &playerPos = player->getPosition();
+	const auto &creaturePos = creature->getPosition();
+	if (std::max(Position::getDistanceX(playerPos, creaturePos), Position::getDistanceY(playerPos, creaturePos)) < edgeDistance) {
+		return false;
+	}
+
+	// Repeated updates keep the first due time, so a creature changing all the time is still updated
+	const int64_t due = OTSYS_TIME() + delay;
+	auto &entry = deferredUpdates[creature->getID()];
+	entry.due = entry.updates == 0 ? due : std::min(entry.due, due);
+	entry.updates |= update;
+
+	scheduleDeferredUpdates(entry.due);
+	return true;
+}
+
+void ProtocolGame::scheduleDeferredUpdates(int64_t due) {
+	if (deferredUpdatesTime != 0 && deferredUpdatesTime <= due) {
+		return;
+	}
+
+	deferredUpdatesTime = due;
+	g_dispatcher().scheduleEvent(
+		static_cast<uint32_t>(std::max<int64_t>(due - OTSYS_TIME(), 1)), [self = getThis(), due] {
+			// A sooner send was scheduled meanwhile, that one takes care of it
+			if (self->deferredUpdatesTime == due) {
+				self->sendDeferredUpdates();
+			}
+		},
+		"ProtocolGame::sendDeferredUpdates"
+	);
+}
+
+void ProtocolGame::sendDeferredUpdates() {
+	deferredUpdatesTime = 0;
+	if (!player || player->isRemoved()) {
+		deferredUpdates.clear();
+		return;
+	}
+
+	const int64_t now = OTSYS_TIME();
+	int64_t nextDue = 0;
+	std::vector<std::pair<uint32_t, uint8_t>> dueUpdates;
+	for (const auto &[creatureId, entry] : deferredUpdates) {
+		if (entry.due <= now) {
+			dueUpdates.emplace_back(creatureId, entry.updates);
+		} else {
+			nextDue = nextDue == 0 ? entry.due : std::min(nextDue, entry.due);
+		}
+	}
+
+	sendingDeferredUpdates = true;
+	for (const auto &[creatureId, updates] : dueUpdates) {
+		deferredUpdates.erase(creatureId);
+
+		const auto &creature = g_game().getCreatureByID(creatureId);
+		if (!creature || !canSee(creature)) {
+			continue;
+		}
+
+		if (updates & DEFERRED_OUTFIT) {
+			sendCreatureOutfit(creature, creature->getCurrentOutfit());
+		}
+		if (updates & DEFERRED_LIGHT) {
+			sendCreatureLight(creature);
+		}
+		if (updates & DEFERRED_ICONS) {
+			sendCreatureIcon(creature);
+		}
+		if (updates & DEFERRED_SKULL) {
+			sendCreatureSkull(creature);
+		}
+	}
+	sendingDeferredUpdates = false;
+
+	if (nextDue != 0) {
+		scheduleDeferredUpdates(nextDue);
+	}
+}
+
+bool ProtocolGame::coalesceCycleUpdate(uint32_t creatureId, CycleUpdate_t update) {
+	if (sendingCycleUpdates || sendingDeferredUpdates || sendingLoginPackets || !player) {
+		return false;
+	}
+
+	const bool queued = !cycleUpdates.empty();
+	cycleUpdates[creatureId] |= update;
+	if (!queued) {
+		g_dispatcher().addEvent([self = getThis()] { self->sendCycleUpdates(); }, "ProtocolGame::sendCycleUpdates");
+	}
+	return true;
+}
+
+void ProtocolGame::sendCycleUpdates() {
+	const auto updates = std::move(cycleUpdates);
+	cycleUpdates.clear();
+	if (!player || player->isRemoved()) {
+		return;
+	}
+
+	sendingCycleUpdates = true;
+	for (const auto &[creatureId, pending] : updates) {
+		if (creatureId == player->getID()) {
+			if (pending & CYCLE_STATS) {
+				sendStats();
+			}
+			if (pending & CYCLE_SKILLS) {
+				sendSkills();
+			}
+		}
+
+		const auto &creature = g_game().getCreatureByID(creatureId);
+		if (!creature || !canSee(creature)) {
+			continue;
+		}
+
+		if (pending & CYCLE_HEALTH) {
+			sendCreatureHealth(creature);
+		}
+		if (pending & CYCLE_SKULL) {
+			sendCreatureSkull(creature);
+		}
+		if (pending & CYCLE_ICONS) {
+			sendCreatureIcon(creature);
+		}
+	}
+	sendingCycleUpdates = false;
+}
+
+bool ProtocolGame::coalesceContainerUpdate(uint8_t cid, const NetworkMessage &msg) {
+	if (sendingContainerUpdates || !player) {
+		return false;
+	}
+
+	const bool queued = !containerUpdates.empty();
+	auto &updates = containerUpdates[cid];
+	// What is queued must fit in one message
+	if (updates.messages.size() + msg.getLength() > MAX_BODY_LENGTH / 2) {
+		NetworkMessage pending;
+		pending.addBytes(reinterpret_cast<const char*>(updates.messages.data()), updates.messages.size());
+		writeToOutputBuffer(pending);
+		updates.messages.clear();
+	}
+	const auto* bytes = msg.getBuffer() + NetworkMessage::INITIAL_BUFFER_POSITION;
+	updates.messages.insert(updates.messages.end(), bytes, bytes + msg.getLength());
+	++updates.count;
+	if (!queued) {
+		g_dispatcher().addEvent([self = getThis()] { self->sendContainerUpdates(); }, "ProtocolGame::sendContainerUpdates");
+	}
+	return true;
+}
+
+void ProtocolGame::sendContainerUpdates() {
+	const auto pending = std::move(containerUpdates);
+	containerUpdates.clear();
+	if (!player || player->isRemoved()) {
+		return;
+	}
+
+	sendingContainerUpdates = true;
+	for (const auto &[cid, updates] : pending) {
+		const auto &container = player->getContainerByID(cid);
+		if (!container) {
+			continue;
+		}
+
+		if (updates.count > 1 && updates.count > std::min<uint32_t>(container->size(), container->capacity())) {
+			sendContainer(cid, container, container->hasParent(), player->getContainerIndex(cid));
+			continue;
+		}
+
+		NetworkMessage msg;
+		msg.addBytes(reinterpret_cast<const char*>(updates.messages.data()), updates.messages.size());
+		writeToOutputBuffer(msg);
+	}
+	sendingContainerUpdates = false;
+}
+
 void ProtocolGame::sendWorldLight(const LightInfo &lightInfo) {
 	NetworkMessage msg;
 	AddWorldLight(msg, lightInfo);
@@ -3317,10 +3750,18 @@ void ProtocolGame::sendTibiaTime(int32_t time) {
 	}
 
 	NetworkMessage msg;
+	addTibiaTime(msg, time, oldProtocol);
+	writeToOutputBuffer(msg);
+}
+
+void ProtocolGame::addTibiaTime(NetworkMessage &msg, int32_t time, bool oldProtocol) {
+	if (oldProtocol) {
+		return;
+	}
+
 	msg.addByte(0xEF);
 	msg.addByte(time / 60);
 	msg.addByte(time % 60);
-	writeToOutputBuffer(msg);
 }
 
 void ProtocolGame::sendCreatureWalkthrough(std::shared_ptr<Creature> creature, bool walkthrough) {
@@ -3374,7 +3815,7 @@ void ProtocolGame::sendCreatureSkull(std::shared_ptr<Creature> creature) {
 		return;
 	}
 
-	if (!canSee(creature)) {
+	if (!canSee(creature) || deferCreatureUpdate(creature, DEFERRED_SKULL) || coalesceCycleUpdate(creature->getID(), CYCLE_SKULL)) {
 		return;
 	}
 
@@ -3876,6 +4317,7 @@ void ProtocolGame::sendCyclopediaCharacterItemSummary(const ItemsTierCountList &
 	msg.setBufferPosition(startInbox);
 	msg.add<uint16_t>(inboxItemsCount);
 
+	cacheCyclopediaPayload(CYCLOPEDIA_CHARACTERINFO_ITEMSUMMARY, msg);
 	writeToOutputBuffer(msg);
 }
 
@@ -3894,7 +4336,7 @@ void ProtocolGame::sendCyclopediaCharacterOutfitsMounts() {
 	auto startOutfits = msg.getBufferPosition();
 	msg.skipBytes(2);
 
-	const auto outfits = Outfits::getInstance().getOutfits(player->getSex());
+	const auto &outfits = Outfits::getInstance().getOutfits(player->getSex());
 	for (const auto &outfit : outfits) {
 		uint8_t addons;
 		if (!player->getOutfitAddons(outfit, addons)) {
@@ -3979,7 +4421,38 @@ void ProtocolGame::sendCyclopediaCharacterOutfitsMounts() {
 	msg.add<uint16_t>(mountSize);
 	msg.setBufferPosition(startFamiliars);
 	msg.add<uint16_t>(familiarsSize);
+	cacheCyclopediaPayload(CYCLOPEDIA_CHARACTERINFO_OUTFITSMOUNTS, msg);
+	writeToOutputBuffer(msg);
+}
+
+bool ProtocolGame::sendCachedCyclopediaCharacterInfo(CyclopediaCharacterInfoType_t type, uint64_t key) {
+	if (!player || oldProtocol) {
+		return false;
+	}
+
+	auto it = cyclopediaPayloads.find(type);
+	if (it == cyclopediaPayloads.end()) {
+		return false;
+	}
+
+	const auto &payload = it->second;
+	if (payload.key != key || OTSYS_TIME() - payload.builtAt > CYCLOPEDIA_PAYLOAD_MAX_AGE) {
+		cyclopediaPayloads.erase(it);
+		return false;
+	}
+
+	NetworkMessage msg;
+	msg.addBytes(reinterpret_cast<const char*>(payload.body.data()), payload.body.size());
 	writeToOutputBuffer(msg);
+	return true;
+}
+
+void ProtocolGame::cacheCyclopediaPayload(CyclopediaCharacterInfoType_t type, const NetworkMessage &msg) {
+	const auto body = msg.getBuffer() + NetworkMessage::INITIAL_BUFFER_POSITION;
+	auto &payload = cyclopediaPayloads[type];
+	payload.key = player->getCyclopediaPayloadKey(type);
+	payload.builtAt = OTSYS_TIME();
+	payload.body.assign(body, body + msg.getLength());
 }
 
 void ProtocolGame::sendCyclopediaCharacterStoreSummary() {
@@ -4277,6 +4750,10 @@ void ProtocolGame::sendReLoginWindow(uint8_t unfairFightReduction) {
 }
 
 void ProtocolGame::sendStats() {
+	if (player && coalesceCycleUpdate(player->getID(), CYCLE_STATS)) {
+		return;
+	}
+
 	NetworkMessage msg;
 	AddPlayerStats(msg);
 	writeToOutputBuffer(msg);
@@ -4568,6 +5045,11 @@ void ProtocolGame::sendChannel(uint16_t channelId, const std::string &channelNam
 
 void ProtocolGame::sendChannelMessage(const std::string &author, const std::string &text, SpeakClasses type, uint16_t channel) {
 	NetworkMessage msg;
+	addChannelMessage(msg, author, text, type, channel);
+	writeToOutputBuffer(msg);
+}
+
+void ProtocolGame::addChannelMessage(NetworkMessage &msg, const std::string &author, const std::string &text, SpeakClasses type, uint16_t channel) {
 	msg.addByte(0xAA);
 	msg.add<uint32_t>(0x00);
 	msg.addString(author, "ProtocolGame::sendChannelMessage - author");
@@ -4575,7 +5057,6 @@ void ProtocolGame::sendChannelMessage(const std::string &author, const std::stri
 	msg.addByte(type);
 	msg.add<uint16_t>(channel);
 	msg.addString(text, "ProtocolGame::sendChannelMessage - text");
-	writeToOutputBuffer(msg);
 }
 
 void ProtocolGame::sendIcons(const std::unordered_set<PlayerIcon> &iconSet, const IconBakragore iconBakragore) {
@@ -4627,6 +5108,9 @@ void ProtocolGame::sendContainer(uint8_t cid, std::shared_ptr<Container> contain
 		return;
 	}
 
+	// The whole container supersedes its queued changes
+	containerUpdates.erase(cid);
+
 	NetworkMessage msg;
 	msg.addByte(0x6E);
 
@@ -4815,11 +5299,27 @@ void ProtocolGame::sendShop(std::shared_ptr<Npc> npc) {
 	uint16_t itemsToSend = std::min<size_t>(shoplist.size(), std::numeric_limits<uint16_t>::max());
 	msg.add<uint16_t>(itemsToSend);
 
+	// The shop of the npc type is serialized once and copied to every window, the lists of a single player are not
+	ShopCatalog* catalog = npc->getShopCatalog(player->getGUID());
+	if (catalog && catalog->offsets.size() != shoplist.size() + 1) {
+		catalog->bytes.clear();
+		catalog->offsets.assign(1, 0);
+		for (const ShopBlock &shopBlock : shoplist) {
+			NetworkMessage itemMsg;
+			AddShopItemDescription(itemMsg, shopBlock);
+			catalog->bytes.append(reinterpret_cast<const char*>(itemMsg.getBuffer() + NetworkMessage::INITIAL_BUFFER_POSITION), itemMsg.getLength());
+			catalog->offsets.emplace_back(static_cast<uint32_t>(catalog->bytes.size()));
+		}
+	}
+
 	// Initialize before the loop to avoid database overload on each iteration
 	auto talkactionHidden = player->kv()->get("npc-shop-hidden-sell-item");
-	// Initialize the inventoryMap outside the loop to avoid creation on each iteration
+	const bool hideSellItems = talkactionHidden && talkactionHidden->get<bool>();
+	// Initialize the inventoryMap outside the loop to avoid creation on each iteration, it is only needed to hide sell items
 	std::map<uint16_t, uint16_t> inventoryMap;
-	player->getAllSaleItemIdAndCount(inventoryMap);
+	if (hideSellItems) {
+		player->getAllSaleItemIdAndCount(inventoryMap);
+	}
 	uint16_t i = 0;
 	for (const ShopBlock &shopBlock : shoplist) {
 		if (++i > itemsToSend) {
@@ -4827,7 +5327,7 @@ void ProtocolGame::sendShop(std::shared_ptr<Npc> npc) {
 		}
 
 		// Hidden sell items from the shop if they are not in the player's inventory
-		if (talkactionHidden && talkactionHidden->get<bool>()) {
+		if (hideSellItems) {
 			const auto &foundItem = inventoryMap.find(shopBlock.itemId);
 			if (foundItem == inventoryMap.end() && shopBlock.itemSellPrice > 0 && shopBlock.itemBuyPrice == 0) {
 				AddHiddenShopItem(msg);
@@ -4835,7 +5335,12 @@ void ProtocolGame::sendShop(std::shared_ptr<Npc> npc) {
 			}
 		}
 
-		AddShopItem(msg, shopBlock);
+		if (catalog) {
+			const auto begin = catalog->offsets[i - 1];
+			AddShopItem(msg, shopBlock, std::string_view(catalog->bytes).substr(begin, catalog->offsets[i] - begin));
+		} else {
+			AddShopItem(msg, shopBlock);
+		}
 	}
 
 	writeToOutputBuffer(msg);
@@ -6117,6 +6622,8 @@ void ProtocolGame::sendCloseTrade() {
 }
 
 void ProtocolGame::sendCloseContainer(uint8_t cid) {
+	containerUpdates.erase(cid);
+
 	NetworkMessage msg;
 	msg.addByte(0x6F);
 	msg.addByte(cid);
@@ -6141,6 +6648,11 @@ void ProtocolGame::sendCreatureTurn(std::shared_ptr<Creature> creature, uint32_t
 
 void ProtocolGame::sendCreatureSay(std::shared_ptr<Creature> creature, SpeakClasses type, const std::string &text, const Position* pos /* = nullptr*/) {
 	NetworkMessage msg;
+	addCreatureSay(msg, creature, type, text, pos, oldProtocol);
+	writeToOutputBuffer(msg);
+}
+
+void ProtocolGame::addCreatureSay(NetworkMessage &msg, const std::shared_ptr<Creature> &creature, SpeakClasses type, const std::string &text, const Position* pos, bool oldProtocol) {
 	msg.addByte(0xAA);
 
 	static uint32_t statementId = 0;
@@ -6172,11 +6684,15 @@ void ProtocolGame::sendCreatureSay(std::shared_ptr<Creature> creature, SpeakClas
 	}
 
 	msg.addString(text, "ProtocolGame::sendCreatureSay - text");
-	writeToOutputBuffer(msg);
 }
 
 void ProtocolGame::sendToChannel(std::shared_ptr<Creature> creature, SpeakClasses type, const std::string &text, uint16_t channelId) {
 	NetworkMessage msg;
+	addToChannel(msg, creature, type, text, channelId, oldProtocol);
+	writeToOutputBuffer(msg);
+}
+
+void ProtocolGame::addToChannel(NetworkMessage &msg, const std::shared_ptr<Creature> &creature, SpeakClasses type, const std::string &text, uint16_t channelId, bool oldProtocol) {
 	msg.addByte(0xAA);
 
 	static uint32_t statementId = 0;
@@ -6214,7 +6730,6 @@ void ProtocolGame::sendToChannel(std::shared_ptr<Creature> creature, SpeakClasse
 
 	msg.add<uint16_t>(channelId);
 	msg.addString(text, "ProtocolGame::sendToChannel - text");
-	writeToOutputBuffer(msg);
 }
 
 void ProtocolGame::sendPrivateMessage(std::shared_ptr<Player> speaker, SpeakClasses type, const std::string &text) {
@@ -6271,6 +6786,10 @@ void ProtocolGame::sendCancelWalk() {
 }
 
 void ProtocolGame::sendSkills() {
+	if (player && coalesceCycleUpdate(player->getID(), CYCLE_SKILLS)) {
+		return;
+	}
+
 	NetworkMessage msg;
 	AddPlayerSkills(msg);
 	writeToOutputBuffer(msg);
@@ -6295,6 +6814,15 @@ void ProtocolGame::sendDistanceShoot(const Position &from, const Position &to, u
 		return;
 	}
 	NetworkMessage msg;
+	addDistanceShoot(msg, from, to, type, oldProtocol);
+	writeToOutputBuffer(msg);
+}
+
+void ProtocolGame::addDistanceShoot(NetworkMessage &msg, const Position &from, const Position &to, uint16_t type, bool oldProtocol) {
+	if (oldProtocol && type > 0xFF) {
+		return;
+	}
+
 	if (oldProtocol) {
 		msg.addByte(0x85);
 		msg.addPosition(from);
@@ -6309,7 +6837,6 @@ void ProtocolGame::sendDistanceShoot(const Position &from, const Position &to, u
 		msg.addByte(static_cast<uint8_t>(static_cast<int8_t>(static_cast<int32_t>(to.y) - static_cast<int32_t>(from.y))));
 		msg.addByte(MAGIC_EFFECTS_END_LOOP);
 	}
-	writeToOutputBuffer(msg);
 }
 
 void ProtocolGame::sendRestingStatus(uint8_t protection) {
@@ -6363,6 +6890,15 @@ void ProtocolGame::sendMagicEffect(const Position &pos, uint16_t type) {
 	}
 
 	NetworkMessage msg;
+	addMagicEffect(msg, pos, type, oldProtocol);
+	writeToOutputBuffer(msg);
+}
+
+void ProtocolGame::addMagicEffect(NetworkMessage &msg, const Position &pos, uint16_t type, bool oldProtocol) {
+	if (oldProtocol && type > 0xFF) {
+		return;
+	}
+
 	if (oldProtocol) {
 		msg.addByte(0x83);
 		msg.addPosition(pos);
@@ -6374,7 +6910,6 @@ void ProtocolGame::sendMagicEffect(const Position &pos, uint16_t type) {
 		msg.add<uint16_t>(type);
 		msg.addByte(MAGIC_EFFECTS_END_LOOP);
 	}
-	writeToOutputBuffer(msg);
 }
 
 void ProtocolGame::removeMagicEffect(const Position &pos, uint16_t type) {
@@ -6382,6 +6917,15 @@ void ProtocolGame::removeMagicEffect(const Position &pos, uint16_t type) {
 		return;
 	}
 	NetworkMessage msg;
+	addRemoveMagicEffect(msg, pos, type, oldProtocol);
+	writeToOutputBuffer(msg);
+}
+
+void ProtocolGame::addRemoveMagicEffect(NetworkMessage &msg, const Position &pos, uint16_t type, bool oldProtocol) {
+	if (oldProtocol && type > 0xFF) {
+		return;
+	}
+
 	msg.addByte(0x84);
 	msg.addPosition(pos);
 	if (oldProtocol) {
@@ -6389,11 +6933,27 @@ void ProtocolGame::removeMagicEffect(const Position &pos, uint16_t type) {
 	} else {
 		msg.add<uint16_t>(type);
 	}
-	writeToOutputBuffer(msg);
+}
+
+void ProtocolGame::sendBroadcast(BroadcastMessage &message) {
+	if (const auto &pos = message.getVisiblePosition(); pos && !canSee(*pos)) {
+		return;
+	}
+
+	const auto &msg = message.get(oldProtocol);
+	if (msg->getLength() <= 0) {
+		return;
+	}
+
+	if (g_configManager().getBoolean(BROADCAST_PARALLEL_DELIVERY, __FUNCTION__)) {
+		queueSharedMessage(msg);
+	} else {
+		writeToOutputBuffer(*msg);
+	}
 }
 
 void ProtocolGame::sendCreatureHealth(std::shared_ptr<Creature> creature) {
-	if (creature->isHealthHidden()) {
+	if (creature->isHealthHidden() || coalesceCycleUpdate(creature->getID(), CYCLE_HEALTH)) {
 		return;
 	}
 
@@ -6706,6 +7266,9 @@ void ProtocolGame::sendAddCreature(std::shared_ptr<Creature> creature, const Pos
 		return;
 	}
 
+	// The client expects the stats and skills in the login sequence, do not coalesce them
+	sendingLoginPackets = true;
+
 	NetworkMessage msg;
 	msg.addByte(0x17);
 
@@ -6825,6 +7388,8 @@ void ProtocolGame::sendAddCreature(std::shared_ptr<Creature> creature, const Pos
 	if (isLogin && oldProtocol) {
 		player->openPlayerContainers();
 	}
+
+	sendingLoginPackets = false;
 }
 
 void ProtocolGame::sendMoveCreature(std::shared_ptr<Creature> creature, const Position &newPos, int32_t newStackPos, const Position &oldPos, int32_t oldStackPos, bool teleport) {
@@ -6937,6 +7502,9 @@ void ProtocolGame::sendAddContainerItem(uint8_t cid, uint16_t slot, std::shared_
 	msg.addByte(cid);
 	msg.add<uint16_t>(slot);
 	AddItem(msg, item);
+	if (coalesceContainerUpdate(cid, msg)) {
+		return;
+	}
 	writeToOutputBuffer(msg);
 }
 
@@ -6946,6 +7514,9 @@ void ProtocolGame::sendUpdateContainerItem(uint8_t cid, uint16_t slot, std::shar
 	msg.addByte(cid);
 	msg.add<uint16_t>(slot);
 	AddItem(msg, item);
+	if (coalesceContainerUpdate(cid, msg)) {
+		return;
+	}
 	writeToOutputBuffer(msg);
 }
 
@@ -6959,6 +7530,9 @@ void ProtocolGame::sendRemoveContainerItem(uint8_t cid, uint16_t slot, std::shar
 	} else {
 		msg.add<uint16_t>(0x00);
 	}
+	if (coalesceContainerUpdate(cid, msg)) {
+		return;
+	}
 	writeToOutputBuffer(msg);
 }
 
@@ -7046,7 +7620,7 @@ void ProtocolGame::sendOutfitWindow() {
 
 	if (oldProtocol) {
 		std::vector<ProtocolOutfit> protocolOutfits;
-		const auto outfits = Outfits::getInstance().getOutfits(player->getSex());
+		const auto &outfits = Outfits::getInstance().getOutfits(player->getSex());
 		protocolOutfits.reserve(outfits.size());
 		for (const auto &outfit : outfits) {
 			uint8_t addons;
@@ -7117,7 +7691,7 @@ void ProtocolGame::sendOutfitWindow() {
 		++outfitSize;
 	}
 
-	const auto outfits = Outfits::getInstance().getOutfits(player->getSex());
+	const auto &outfits = Outfits::getInstance().getOutfits(player->getSex());
 
 	for (const auto &outfit : outfits) {
 		uint8_t addons;
@@ -7167,7 +7741,7 @@ void ProtocolGame::sendOutfitWindow() {
 	uint16_t mountSize = 0;
 	msg.skipBytes(2);
 
-	const auto mounts = g_game().mounts.getMounts();
+	const auto &mounts = g_game().mounts.getMounts();
 	for (const auto &mount : mounts) {
 		if (player->hasMount(mount)) {
 			msg.add<uint16_t>(mount->clientId);
@@ -7261,7 +7835,7 @@ void ProtocolGame::sendPodiumWindow(std::shared_ptr<Item> podium, const Position
 	uint16_t outfitSize = 0;
 	msg.skipBytes(2);
 
-	const auto outfits = Outfits::getInstance().getOutfits(player->getSex());
+	const auto &outfits = Outfits::getInstance().getOutfits(player->getSex());
 	for (const auto &outfit : outfits) {
 		uint8_t addons;
 		if (!player->getOutfitAddons(outfit, addons)) {
@@ -7287,7 +7861,7 @@ void ProtocolGame::sendPodiumWindow(std::shared_ptr<Item> podium, const Position
 	uint16_t mountSize = 0;
 	msg.skipBytes(2);
 
-	const auto mounts = g_game().mounts.getMounts();
+	const auto &mounts = g_game().mounts.getMounts();
 	for (const auto &mount : mounts) {
 		if (player->hasMount(mount)) {
 			msg.add<uint16_t>(mount->clientId);
@@ -7962,8 +8536,15 @@ void ProtocolGame::closeImbuementWindow() {
 }
 
 void ProtocolGame::AddWorldLight(NetworkMessage &msg, LightInfo lightInfo) {
+	if (player->isAccessPlayer()) {
+		lightInfo.level = 0xFF;
+	}
+	addWorldLight(msg, lightInfo);
+}
+
+void ProtocolGame::addWorldLight(NetworkMessage &msg, const LightInfo &lightInfo) {
 	msg.addByte(0x82);
-	msg.addByte((player->isAccessPlayer() ? 0xFF : lightInfo.level));
+	msg.addByte(lightInfo.level);
 	msg.addByte(lightInfo.color);
 }
 
@@ -8286,13 +8867,22 @@ void ProtocolGame::AddHiddenShopItem(NetworkMessage &msg) {
 	msg.add<uint32_t>(0);
 }
 
-void ProtocolGame::AddShopItem(NetworkMessage &msg, const ShopBlock &shopBlock) {
+void ProtocolGame::AddShopItem(NetworkMessage &msg, const ShopBlock &shopBlock, std::string_view serialized /* = {}*/) {
 	// Sends the item information empty if the player doesn't have the storage to buy/sell a certain item
 	if (shopBlock.itemStorageKey != 0 && player->getStorageValue(shopBlock.itemStorageKey) < shopBlock.itemStorageValue) {
 		AddHiddenShopItem(msg);
 		return;
 	}
 
+	if (!serialized.empty()) {
+		msg.addBytes(serialized.data(), serialized.size());
+		return;
+	}
+
+	AddShopItemDescription(msg, shopBlock);
+}
+
+void ProtocolGame::AddShopItemDescription(NetworkMessage &msg, const ShopBlock &shopBlock) {
 	const ItemType &it = Item::items[shopBlock.itemId];
 	msg.add<uint16_t>(shopBlock.itemId);
 	if (it.isSplash() || it.isFluidContainer()) {
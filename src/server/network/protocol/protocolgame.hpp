@@ -10,12 +10,14 @@
 #pragma once
 
 #include "server/network/protocol/protocol.hpp"
+#include "server/network/protocol/known_creature_set.hpp"
 #include "creatures/interactions/chat.hpp"
 #include "creatures/creature.hpp"
 #include "enums/forge_conversion.hpp"
 #include "creatures/players/cyclopedia/player_badge.hpp"
 #include "creatures/players/cyclopedia/player_cyclopedia.hpp"
 #include "creatures/players/cyclopedia/player_title.hpp"
+#include "utils/inline_function.hpp"
 
 class NetworkMessage;
 class Player;
@@ -54,6 +56,37 @@ struct TextMessage {
 	} primary, secondary;
 };
 
+/**
+ * A packet that is the same for every spectator, it is serialized once per protocol version
+ * (the first time a spectator with that version needs it) and then only copied to the output buffers.
+ */
+class BroadcastMessage {
+public:
+	using Builder = stdext::inline_function<void(NetworkMessage &msg, bool oldProtocol)>;
+
+	explicit BroadcastMessage(Builder builder);
+	/**
+	 * \param visiblePosition Spectators that can not see this position are skipped (e.g. magic effects).
+	 */
+	BroadcastMessage(const Position &visiblePosition, Builder builder);
+	~BroadcastMessage();
+
+	// non-copyable
+	BroadcastMessage(const BroadcastMessage &) = delete;
+	BroadcastMessage &operator=(const BroadcastMessage &) = delete;
+
+	const std::shared_ptr<NetworkMessage> &get(bool oldProtocol);
+
+	const std::optional<Position> &getVisiblePosition() const {
+		return visiblePosition;
+	}
+
+private:
+	Builder builder;
+	std::optional<Position> visiblePosition;
+	std::array<std::shared_ptr<NetworkMessage>, 2> messages;
+};
+
 class ProtocolGame final : public Protocol {
 public:
 	// Static protocol information.
@@ -68,7 +101,7 @@ public:
 
 	explicit ProtocolGame(Connection_ptr initConnection);
 
-	void login(const std::string &name, uint32_t accnumber, OperatingSystem_t operatingSystem);
+	void login(const std::shared_ptr<Player> &loadingPlayer, OperatingSystem_t operatingSystem);
 	void logout(bool displayEffect, bool forced);
 
 	void AddItem(NetworkMessage &msg, std::shared_ptr<Item> item);
@@ -78,11 +111,27 @@ public:
 		return version;
 	}
 
+	// Packets that do not depend on the receiving player, they are also used to build broadcast messages
+	static void addDistanceShoot(NetworkMessage &msg, const Position &from, const Position &to, uint16_t type, bool oldProtocol);
+	static void addMagicEffect(NetworkMessage &msg, const Position &pos, uint16_t type, bool oldProtocol);
+	static void addRemoveMagicEffect(NetworkMessage &msg, const Position &pos, uint16_t type, bool oldProtocol);
+	static void addCreatureSay(NetworkMessage &msg, const std::shared_ptr<Creature> &creature, SpeakClasses type, const std::string &text, const Position* pos, bool oldProtocol);
+	static void addChannelMessage(NetworkMessage &msg, const std::string &author, const std::string &text, SpeakClasses type, uint16_t channel);
+	static void addToChannel(NetworkMessage &msg, const std::shared_ptr<Creature> &creature, SpeakClasses type, const std::string &text, uint16_t channelId, bool oldProtocol);
+	static void addWorldLight(NetworkMessage &msg, const LightInfo &lightInfo);
+	static void addTibiaTime(NetworkMessage &msg, int32_t time, bool oldProtocol);
+
 private:
 	ProtocolGame_ptr getThis() {
 		return std::static_pointer_cast<ProtocolGame>(shared_from_this());
 	}
 	void connect(const std::string &playerName, OperatingSystem_t operatingSystem);
+	// Crypto lane: decrypts the message, sets the XTEA key and goes on with authenticate
+	void parseLoginMessage(NetworkMessage &msg, OperatingSystem_t operatingSystem);
+	// Crypto lane: checks the bans and the credentials and preloads the character
+	void authenticate(const std::string &accountDescriptor, const std::string &password, std::string &characterName, OperatingSystem_t operatingSystem);
+	// Dispatcher: places the loaded character in the world, called by a LoginQueue batch
+	void enterWorld(const std::shared_ptr<Player> &loadedPlayer, bool loaded, OperatingSystem_t operatingSystem);
 	void disconnectClient(const std::string &message) const;
 	void writeToOutputBuffer(const NetworkMessage &msg);
 
@@ -91,13 +140,25 @@ private:
 	void checkCreatureAsKnown(uint32_t id, bool &known, uint32_t &removedKnown);
 
 	bool canSee(int32_t x, int32_t y, int32_t z) const;
-	bool canSee(std::shared_ptr<Creature>) const;
+	bool canSee(const std::shared_ptr<Creature> &) const;
 	bool canSee(const Position &pos) const;
 
 	// we have all the parse methods
 	void parsePacket(NetworkMessage &msg) override;
-	void parsePacketFromDispatcher(NetworkMessage msg, uint8_t recvbyte);
-	void onRecvFirstMessage(NetworkMessage &msg) override;
+	void parsePacketFromDispatcher(NetworkMessage &msg, uint8_t recvbyte);
+
+	// Token bucket of one rate limited opcode received from this client
+	struct PacketBucket {
+		double tokens = 0;
+		int64_t lastRefill = 0;
+	};
+
+	/**
+	 * Refills the bucket of a rate limited opcode (see packetRateLimits) and takes a token from it.
+	 * \returns false if the bucket is empty and the packet must be dropped.
+	 */
+	static bool consumePacketToken(PacketBucket &bucket, double rate, double burst);
+	bool onRecvFirstMessage(NetworkMessage &msg) override;
 	void onConnect() override;
 
 	// Parse methods
@@ -285,6 +346,7 @@ private:
 	void sendDistanceShoot(const Position &from, const Position &to, uint16_t type);
 	void sendMagicEffect(const Position &pos, uint16_t type);
 	void removeMagicEffect(const Position &pos, uint16_t type);
+	void sendBroadcast(BroadcastMessage &message);
 	void sendRestingStatus(uint8_t protection);
 	void sendCreatureHealth(std::shared_ptr<Creature> creature);
 	void sendPartyCreatureUpdate(std::shared_ptr<Creature> target);
@@ -325,6 +387,7 @@ private:
 	void sendCyclopediaCharacterAchievements(uint16_t secretsUnlocked, std::vector<std::pair<Achievement, uint32_t>> achievementsUnlocked);
 	void sendCyclopediaCharacterItemSummary(const ItemsTierCountList &inventoryItems, const ItemsTierCountList &storeInboxItems, const StashItemList &supplyStashItems, const ItemsTierCountList &depotBoxItems, const ItemsTierCountList &inboxItems);
 	void sendCyclopediaCharacterOutfitsMounts();
+	bool sendCachedCyclopediaCharacterInfo(CyclopediaCharacterInfoType_t type, uint64_t key);
 	void sendCyclopediaCharacterStoreSummary();
 	void sendCyclopediaCharacterInspection();
 	void sendCyclopediaCharacterBadges();
@@ -432,6 +495,7 @@ private:
 	// Help functions
 	// translate a tile to clientreadable format
 	void GetTileDescription(std::shared_ptr<Tile> tile, NetworkMessage &msg);
+	void SerializeTileDescription(const std::shared_ptr<Tile> &tile, NetworkMessage &msg);
 
 	// translate a floor to clientreadable format
 	void GetFloorDescription(NetworkMessage &msg, int32_t x, int32_t y, int32_t z, int32_t width, int32_t height, int32_t offset, int32_t &skip);
@@ -459,7 +523,8 @@ private:
 
 	// shop
 	void AddHiddenShopItem(NetworkMessage &msg);
-	void AddShopItem(NetworkMessage &msg, const ShopBlock &shopBlock);
+	void AddShopItem(NetworkMessage &msg, const ShopBlock &shopBlock, std::string_view serialized = {});
+	static void AddShopItemDescription(NetworkMessage &msg, const ShopBlock &shopBlock);
 
 	// otclient
 	void parseExtendedOpcode(NetworkMessage &msg);
@@ -481,11 +546,89 @@ private:
 	void parseSaveWheel(NetworkMessage &msg);
 	void parseWheelGemAction(NetworkMessage &msg);
 
+	// Interest management, cosmetic updates of creatures at the edge of the view are coalesced
+	enum DeferredUpdate_t : uint8_t {
+		DEFERRED_OUTFIT = 1 << 0,
+		DEFERRED_LIGHT = 1 << 1,
+		DEFERRED_ICONS = 1 << 2,
+		DEFERRED_SKULL = 1 << 3,
+	};
+
+	struct DeferredCreatureUpdate {
+		int64_t due = 0;
+		uint8_t updates = 0;
+	};
+
+	/**
+	 * Holds the update back if the creature is at the edge of the view and the packet type has a delay
+	 * (see interestEdgeDistance), the latest state is sent once the delay is over.
+	 * \returns true if the update was deferred and must not be sent now.
+	 */
+	bool deferCreatureUpdate(const std::shared_ptr<Creature> &creature, DeferredUpdate_t update);
+	void scheduleDeferredUpdates(int64_t due);
+	void sendDeferredUpdates();
+
+	// Repeated updates of the same creature within one dispatcher cycle are sent once, at the end of it
+	enum CycleUpdate_t : uint8_t {
+		CYCLE_HEALTH = 1 << 0,
+		CYCLE_SKULL = 1 << 1,
+		CYCLE_ICONS = 1 << 2,
+		CYCLE_STATS = 1 << 3,
+		CYCLE_SKILLS = 1 << 4,
+	};
+
+	/**
+	 * Marks the update as pending for this cycle, the first one queues the send of all of them.
+	 * \returns true if the update was queued and must not be sent now.
+	 */
+	bool coalesceCycleUpdate(uint32_t creatureId, CycleUpdate_t update);
+	void sendCycleUpdates();
+
+	/**
+	 * Holds the add, update and remove item messages of an open container until the end of the cycle.
+	 * They are then sent as they are, or replaced by the whole container if there are more of them than
+	 * items it shows (e.g. a corpse emptied by quick loot). Opening or closing the container drops them.
+	 * \returns true if the message was queued and must not be sent now.
+	 */
+	bool coalesceContainerUpdate(uint8_t cid, const NetworkMessage &msg);
+	void sendContainerUpdates();
+
+	/**
+	 * The body of a cyclopedia character info message, kept to be sent again while the key of the player
+	 * for its type is the same. It also expires, for the changes that do not reach the player, like the items
+	 * delivered to the depot or updated in place inside a container.
+	 */
+	struct CachedCyclopediaPayload {
+		uint64_t key = 0;
+		int64_t builtAt = 0;
+		std::vector<uint8_t> body;
+	};
+	static constexpr int64_t CYCLOPEDIA_PAYLOAD_MAX_AGE = 5000;
+
+	void cacheCyclopediaPayload(CyclopediaCharacterInfoType_t type, const NetworkMessage &msg);
+
 	friend class Player;
 	friend class PlayerWheel;
 	friend class PlayerVIP;
-
-	std::unordered_set<uint32_t> knownCreatureSet;
+	// tests/benchmark, times the tile and map descriptions
+	friend class ProtocolGameBenchmark;
+
+	KnownCreatureSet knownCreatureSet;
+	phmap::flat_hash_map<uint8_t, PacketBucket> packetBuckets;
+	phmap::flat_hash_map<uint32_t, DeferredCreatureUpdate> deferredUpdates;
+	int64_t deferredUpdatesTime = 0;
+	bool sendingDeferredUpdates = false;
+	phmap::flat_hash_map<uint32_t, uint8_t> cycleUpdates;
+	bool sendingCycleUpdates = false;
+	bool sendingLoginPackets = false;
+	// The queued messages of each container id, one after the other, and how many they are
+	struct ContainerUpdates {
+		std::vector<uint8_t> messages;
+		uint16_t count = 0;
+	};
+	phmap::flat_hash_map<uint8_t, ContainerUpdates> containerUpdates;
+	bool sendingContainerUpdates = false;
+	phmap::flat_hash_map<uint8_t, CachedCyclopediaPayload> cyclopediaPayloads;
 	std::shared_ptr<Player> player = nullptr;
 
 	uint32_t eventConnect = 0;
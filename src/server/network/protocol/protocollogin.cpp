@@ -99,10 +99,10 @@ void ProtocolLogin::getCharacterList(const std::string &accountDescriptor, const
 	disconnect();
 }
 
-void ProtocolLogin::onRecvFirstMessage(NetworkMessage &msg) {
+bool ProtocolLogin::onRecvFirstMessage(NetworkMessage &msg) {
 	if (g_game().getGameState() == GAME_STATE_SHUTDOWN) {
 		disconnect();
-		return;
+		return true;
 	}
 
 	msg.skipBytes(2); // client OS
@@ -120,8 +120,16 @@ void ProtocolLogin::onRecvFirstMessage(NetworkMessage &msg) {
 	 - 1 byte: preview world(971+)
 	 */
 
+	// The connection reads nothing else, the login ends with the character list or an error
+	detachLoginTask([self = std::static_pointer_cast<ProtocolLogin>(shared_from_this()), &msg] {
+		self->parseLoginMessage(msg);
+	});
+	return true;
+}
+
+void ProtocolLogin::parseLoginMessage(NetworkMessage &msg) {
 	if (!Protocol::RSA_decrypt(msg)) {
-		g_logger().warn("[ProtocolLogin::onRecvFirstMessage] - RSA Decrypt Failed");
+		g_logger().warn("[ProtocolLogin::parseLoginMessage] - RSA Decrypt Failed");
 		disconnect();
 		return;
 	}
@@ -174,8 +182,5 @@ void ProtocolLogin::onRecvFirstMessage(NetworkMessage &msg) {
 		return;
 	}
 
-	g_dispatcher().addEvent([self = std::static_pointer_cast<ProtocolLogin>(shared_from_this()), accountDescriptor, password] {
-		self->getCharacterList(accountDescriptor, password);
-	},
-	                        "ProtocolLogin::getCharacterList");
+	getCharacterList(accountDescriptor, password);
 }
@@ -27,11 +27,14 @@ public:
 	explicit ProtocolLogin(Connection_ptr loginConnection) :
 		Protocol(loginConnection) { }
 
-	void onRecvFirstMessage(NetworkMessage &msg);
+	bool onRecvFirstMessage(NetworkMessage &msg);
 
 private:
 	void disconnectClient(const std::string &message);
 
+	// Crypto lane: decrypts the message, checks the ban and the credentials and sends the character list
+	void parseLoginMessage(NetworkMessage &msg);
+
 	void getCharacterList(const std::string &accountDescriptor, const std::string &password);
 
 	bool oldProtocol = false;
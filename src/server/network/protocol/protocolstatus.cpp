@@ -16,39 +16,50 @@
 #include "config/configmanager.hpp"
 #include "game/game.hpp"
 #include "game/scheduling/dispatcher.hpp"
+#include "game/world_snapshot.hpp"
 #include "server/network/message/outputmessage.hpp"
 
 std::string ProtocolStatus::SERVER_NAME = "Canary";
 std::string ProtocolStatus::SERVER_VERSION = "3.0";
 std::string ProtocolStatus::SERVER_DEVELOPERS = "OpenTibiaBR Organization";
 
+std::mutex ProtocolStatus::ipConnectMutex;
 std::map<uint32_t, int64_t> ProtocolStatus::ipConnectMap;
+std::mutex ProtocolStatus::snapshotMutex;
+std::shared_ptr<const ProtocolStatus::Snapshot> ProtocolStatus::snapshot;
 const uint64_t ProtocolStatus::start = OTSYS_TIME(true);
 
-void ProtocolStatus::onRecvFirstMessage(NetworkMessage &msg) {
+namespace {
+	std::string getMessageBytes(const NetworkMessage &msg) {
+		return std::string(reinterpret_cast<const char*>(msg.getBuffer()) + NetworkMessage::INITIAL_BUFFER_POSITION, msg.getLength());
+	}
+} // namespace
+
+bool ProtocolStatus::onRecvFirstMessage(NetworkMessage &msg) {
 	uint32_t ip = getIP();
-	if (ip != 0x0100007F) {
-		std::string ipStr = convertIPToString(ip);
-		if (ipStr != g_configManager().getString(IP, __FUNCTION__)) {
-			std::map<uint32_t, int64_t>::const_iterator it = ipConnectMap.find(ip);
-			if (it != ipConnectMap.end() && (OTSYS_TIME() < (it->second + g_configManager().getNumber(STATUSQUERY_TIMEOUT, __FUNCTION__)))) {
-				disconnect();
-				return;
+	{
+		std::scoped_lock lock(ipConnectMutex);
+		if (ip != 0x0100007F) {
+			std::string ipStr = convertIPToString(ip);
+			if (ipStr != g_configManager().getString(IP, __FUNCTION__)) {
+				std::map<uint32_t, int64_t>::const_iterator it = ipConnectMap.find(ip);
+				if (it != ipConnectMap.end() && (OTSYS_TIME() < (it->second + g_configManager().getNumber(STATUSQUERY_TIMEOUT, __FUNCTION__)))) {
+					disconnect();
+					return false;
+				}
 			}
 		}
-	}
 
-	ipConnectMap[ip] = OTSYS_TIME();
+		ipConnectMap[ip] = OTSYS_TIME();
+	}
 
+	// Answered from the snapshot, without going through the dispatcher
 	switch (msg.getByte()) {
 		// XML info protocol
 		case 0xFF: {
 			if (msg.getString(4) == "info") {
-				g_dispatcher().addEvent([self = std::static_pointer_cast<ProtocolStatus>(shared_from_this())] {
-					self->sendStatusString();
-				},
-				                        "ProtocolStatus::sendStatusString");
-				return;
+				sendStatusString();
+				return false;
 			}
 			break;
 		}
@@ -60,105 +71,163 @@ void ProtocolStatus::onRecvFirstMessage(NetworkMessage &msg) {
 			if (requestedInfo & REQUEST_PLAYER_STATUS_INFO) {
 				characterName = msg.getString();
 			}
-			g_dispatcher().addEvent([self = std::static_pointer_cast<ProtocolStatus>(shared_from_this()), requestedInfo, characterName] {
-				self->sendInfo(requestedInfo, characterName);
-			},
-			                        "ProtocolStatus::sendInfo");
-
-			return;
+			sendInfo(requestedInfo, characterName);
+			return false;
 		}
 
 		default:
 			break;
 	}
 	disconnect();
+	return false;
 }
 
-void ProtocolStatus::sendStatusString() {
-	auto output = OutputMessagePool::getOutputMessage();
+std::shared_ptr<const ProtocolStatus::Snapshot> ProtocolStatus::getSnapshot() {
+	std::scoped_lock lock(snapshotMutex);
+	return snapshot;
+}
 
-	setRawMessages(true);
+void ProtocolStatus::updateSnapshot() {
+	const auto world = g_game().getWorldSnapshot();
+	if (!world) {
+		return;
+	}
 
-	pugi::xml_document doc;
-
-	pugi::xml_node decl = doc.prepend_child(pugi::node_declaration);
-	decl.append_attribute("version") = "1.0";
-
-	pugi::xml_node tsqp = doc.append_child("tsqp");
-	tsqp.append_attribute("version") = "1.0";
-
-	pugi::xml_node serverinfo = tsqp.append_child("serverinfo");
-	uint64_t uptime = (OTSYS_TIME() - ProtocolStatus::start) / 1000;
-	serverinfo.append_attribute("uptime") = std::to_string(uptime).c_str();
-	serverinfo.append_attribute("ip") = g_configManager().getString(IP, __FUNCTION__).c_str();
-	serverinfo.append_attribute("servername") = g_configManager().getString(ConfigKey_t::SERVER_NAME, __FUNCTION__).c_str();
-	serverinfo.append_attribute("port") = std::to_string(g_configManager().getNumber(LOGIN_PORT, __FUNCTION__)).c_str();
-	serverinfo.append_attribute("location") = g_configManager().getString(LOCATION, __FUNCTION__).c_str();
-	serverinfo.append_attribute("url") = g_configManager().getString(URL, __FUNCTION__).c_str();
-	serverinfo.append_attribute("server") = ProtocolStatus::SERVER_NAME.c_str();
-	serverinfo.append_attribute("version") = ProtocolStatus::SERVER_VERSION.c_str();
-	serverinfo.append_attribute("client") = fmt::format("{}.{}", CLIENT_VERSION_UPPER, CLIENT_VERSION_LOWER).c_str();
-
-	pugi::xml_node owner = tsqp.append_child("owner");
-	owner.append_attribute("name") = g_configManager().getString(OWNER_NAME, __FUNCTION__).c_str();
-	owner.append_attribute("email") = g_configManager().getString(OWNER_EMAIL, __FUNCTION__).c_str();
-
-	pugi::xml_node players = tsqp.append_child("players");
-	uint32_t real = 0;
-	std::map<uint32_t, uint32_t> listIP;
-	for (const auto &[key, player] : g_game().getPlayers()) {
-		if (player->getIP() != 0) {
-			auto ip = listIP.find(player->getIP());
-			if (ip != listIP.end()) {
-				listIP[player->getIP()]++;
-				if (listIP[player->getIP()] < 5) {
+	inject<ThreadPool>().detachTask(ThreadLane::Network, [world] {
+		const auto &players = *world;
+		const auto playersRecord = world->playersRecord;
+		const auto monstersOnline = world->monstersOnline;
+		const auto npcsOnline = world->npcsOnline;
+		const auto mapWidth = world->mapWidth;
+		const auto mapHeight = world->mapHeight;
+
+		auto next = std::make_shared<Snapshot>();
+
+		pugi::xml_document doc;
+
+		pugi::xml_node decl = doc.prepend_child(pugi::node_declaration);
+		decl.append_attribute("version") = "1.0";
+
+		pugi::xml_node tsqp = doc.append_child("tsqp");
+		tsqp.append_attribute("version") = "1.0";
+
+		pugi::xml_node serverinfo = tsqp.append_child("serverinfo");
+		uint64_t uptime = (OTSYS_TIME() - ProtocolStatus::start) / 1000;
+		serverinfo.append_attribute("uptime") = std::to_string(uptime).c_str();
+		serverinfo.append_attribute("ip") = g_configManager().getString(IP, __FUNCTION__).c_str();
+		serverinfo.append_attribute("servername") = g_configManager().getString(ConfigKey_t::SERVER_NAME, __FUNCTION__).c_str();
+		serverinfo.append_attribute("port") = std::to_string(g_configManager().getNumber(LOGIN_PORT, __FUNCTION__)).c_str();
+		serverinfo.append_attribute("location") = g_configManager().getString(LOCATION, __FUNCTION__).c_str();
+		serverinfo.append_attribute("url") = g_configManager().getString(URL, __FUNCTION__).c_str();
+		serverinfo.append_attribute("server") = ProtocolStatus::SERVER_NAME.c_str();
+		serverinfo.append_attribute("version") = ProtocolStatus::SERVER_VERSION.c_str();
+		serverinfo.append_attribute("client") = fmt::format("{}.{}", CLIENT_VERSION_UPPER, CLIENT_VERSION_LOWER).c_str();
+
+		pugi::xml_node owner = tsqp.append_child("owner");
+		owner.append_attribute("name") = g_configManager().getString(OWNER_NAME, __FUNCTION__).c_str();
+		owner.append_attribute("email") = g_configManager().getString(OWNER_EMAIL, __FUNCTION__).c_str();
+
+		pugi::xml_node playersNode = tsqp.append_child("players");
+		uint32_t real = 0;
+		std::map<uint32_t, uint32_t> listIP;
+		for (const auto playerIp : players.ips) {
+			if (playerIp != 0) {
+				auto ip = listIP.find(playerIp);
+				if (ip != listIP.end()) {
+					listIP[playerIp]++;
+					if (listIP[playerIp] < 5) {
+						real++;
+					}
+				} else {
+					listIP[playerIp] = 1;
 					real++;
 				}
-			} else {
-				listIP[player->getIP()] = 1;
-				real++;
 			}
 		}
-	}
-	players.append_attribute("online") = std::to_string(real).c_str();
-	players.append_attribute("max") = std::to_string(g_configManager().getNumber(MAX_PLAYERS, __FUNCTION__)).c_str();
-	players.append_attribute("peak") = std::to_string(g_game().getPlayersRecord()).c_str();
-
-	pugi::xml_node monsters = tsqp.append_child("monsters");
-	monsters.append_attribute("total") = std::to_string(g_game().getMonstersOnline()).c_str();
-
-	pugi::xml_node npcs = tsqp.append_child("npcs");
-	npcs.append_attribute("total") = std::to_string(g_game().getNpcsOnline()).c_str();
-
-	pugi::xml_node rates = tsqp.append_child("rates");
-	rates.append_attribute("experience") = std::to_string(g_configManager().getNumber(RATE_EXPERIENCE, __FUNCTION__)).c_str();
-	rates.append_attribute("skill") = std::to_string(g_configManager().getNumber(RATE_SKILL, __FUNCTION__)).c_str();
-	rates.append_attribute("loot") = std::to_string(g_configManager().getNumber(RATE_LOOT, __FUNCTION__)).c_str();
-	rates.append_attribute("magic") = std::to_string(g_configManager().getNumber(RATE_MAGIC, __FUNCTION__)).c_str();
-	rates.append_attribute("spawn") = std::to_string(g_configManager().getNumber(RATE_SPAWN, __FUNCTION__)).c_str();
+		playersNode.append_attribute("online") = std::to_string(real).c_str();
+		playersNode.append_attribute("max") = std::to_string(g_configManager().getNumber(MAX_PLAYERS, __FUNCTION__)).c_str();
+		playersNode.append_attribute("peak") = std::to_string(playersRecord).c_str();
+
+		pugi::xml_node monsters = tsqp.append_child("monsters");
+		monsters.append_attribute("total") = std::to_string(monstersOnline).c_str();
+
+		pugi::xml_node npcs = tsqp.append_child("npcs");
+		npcs.append_attribute("total") = std::to_string(npcsOnline).c_str();
+
+		pugi::xml_node rates = tsqp.append_child("rates");
+		rates.append_attribute("experience") = std::to_string(g_configManager().getNumber(RATE_EXPERIENCE, __FUNCTION__)).c_str();
+		rates.append_attribute("skill") = std::to_string(g_configManager().getNumber(RATE_SKILL, __FUNCTION__)).c_str();
+		rates.append_attribute("loot") = std::to_string(g_configManager().getNumber(RATE_LOOT, __FUNCTION__)).c_str();
+		rates.append_attribute("magic") = std::to_string(g_configManager().getNumber(RATE_MAGIC, __FUNCTION__)).c_str();
+		rates.append_attribute("spawn") = std::to_string(g_configManager().getNumber(RATE_SPAWN, __FUNCTION__)).c_str();
+
+		pugi::xml_node map = tsqp.append_child("map");
+		map.append_attribute("name") = g_configManager().getString(MAP_NAME, __FUNCTION__).c_str();
+		map.append_attribute("author") = g_configManager().getString(MAP_AUTHOR, __FUNCTION__).c_str();
+		map.append_attribute("width") = std::to_string(mapWidth).c_str();
+		map.append_attribute("height") = std::to_string(mapHeight).c_str();
+
+		pugi::xml_node motd = tsqp.append_child("motd");
+		motd.text() = g_configManager().getString(SERVER_MOTD, __FUNCTION__).c_str();
+
+		std::ostringstream ss;
+		doc.save(ss, "", pugi::format_raw);
+		next->statusString = ss.str();
+
+		NetworkMessage msg;
+		msg.addByte(0x20);
+		msg.add<uint32_t>(static_cast<uint32_t>(players.size()));
+		msg.add<uint32_t>(g_configManager().getNumber(MAX_PLAYERS, __FUNCTION__));
+		msg.add<uint32_t>(playersRecord);
+		next->playersInfo = getMessageBytes(msg);
+
+		msg.reset();
+		msg.addByte(0x30);
+		msg.addString(g_configManager().getString(MAP_NAME, __FUNCTION__), "ProtocolStatus::updateSnapshot - g_configManager().getString(MAP_NAME)");
+		msg.addString(g_configManager().getString(MAP_AUTHOR, __FUNCTION__), "ProtocolStatus::updateSnapshot - g_configManager().getString(MAP_AUTHOR)");
+		msg.add<uint16_t>(mapWidth);
+		msg.add<uint16_t>(mapHeight);
+		next->mapInfo = getMessageBytes(msg);
+
+		msg.reset();
+		msg.addByte(0x21); // players info - online players list
+		msg.add<uint32_t>(players.size());
+		next->playerNames.reserve(players.size());
+		for (size_t i = 0; i < players.size(); ++i) {
+			msg.addString(players.names[i], "ProtocolStatus::updateSnapshot - player.name");
+			msg.add<uint32_t>(players.levels[i]);
+			next->playerNames.emplace(asLowerCaseString(players.names[i]));
+		}
+		next->extPlayersInfo = getMessageBytes(msg);
 
-	pugi::xml_node map = tsqp.append_child("map");
-	map.append_attribute("name") = g_configManager().getString(MAP_NAME, __FUNCTION__).c_str();
-	map.append_attribute("author") = g_configManager().getString(MAP_AUTHOR, __FUNCTION__).c_str();
+		std::scoped_lock lock(snapshotMutex);
+		snapshot = std::move(next);
+	});
+}
 
-	uint32_t mapWidth, mapHeight;
-	g_game().getMapDimensions(mapWidth, mapHeight);
-	map.append_attribute("width") = std::to_string(mapWidth).c_str();
-	map.append_attribute("height") = std::to_string(mapHeight).c_str();
+void ProtocolStatus::sendStatusString() {
+	const auto current = getSnapshot();
+	if (!current) {
+		disconnect();
+		return;
+	}
 
-	pugi::xml_node motd = tsqp.append_child("motd");
-	motd.text() = g_configManager().getString(SERVER_MOTD, __FUNCTION__).c_str();
+	auto output = OutputMessagePool::getOutputMessage();
 
-	std::ostringstream ss;
-	doc.save(ss, "", pugi::format_raw);
+	setRawMessages(true);
 
-	std::string data = ss.str();
-	output->addBytes(data.c_str(), data.size());
+	output->addBytes(current->statusString.data(), current->statusString.size());
 	send(output);
 	disconnect();
 }
 
 void ProtocolStatus::sendInfo(uint16_t requestedInfo, const std::string &characterName) {
+	const auto current = getSnapshot();
+	if (!current) {
+		disconnect();
+		return;
+	}
+
 	auto output = OutputMessagePool::getOutputMessage();
 
 	if (requestedInfo & REQUEST_BASIC_SERVER_INFO) {
@@ -183,36 +252,20 @@ void ProtocolStatus::sendInfo(uint16_t requestedInfo, const std::string &charact
 	}
 
 	if (requestedInfo & REQUEST_PLAYERS_INFO) {
-		output->addByte(0x20);
-		output->add<uint32_t>(static_cast<uint32_t>(g_game().getPlayersOnline()));
-		output->add<uint32_t>(g_configManager().getNumber(MAX_PLAYERS, __FUNCTION__));
-		output->add<uint32_t>(g_game().getPlayersRecord());
+		output->addBytes(current->playersInfo.data(), current->playersInfo.size());
 	}
 
 	if (requestedInfo & REQUEST_MAP_INFO) {
-		output->addByte(0x30);
-		output->addString(g_configManager().getString(MAP_NAME, __FUNCTION__), "ProtocolStatus::sendInfo - g_configManager().getString(MAP_NAME)");
-		output->addString(g_configManager().getString(MAP_AUTHOR, __FUNCTION__), "ProtocolStatus::sendInfo - g_configManager().getString(MAP_AUTHOR)");
-		uint32_t mapWidth, mapHeight;
-		g_game().getMapDimensions(mapWidth, mapHeight);
-		output->add<uint16_t>(mapWidth);
-		output->add<uint16_t>(mapHeight);
+		output->addBytes(current->mapInfo.data(), current->mapInfo.size());
 	}
 
 	if (requestedInfo & REQUEST_EXT_PLAYERS_INFO) {
-		output->addByte(0x21); // players info - online players list
-
-		const auto players = g_game().getPlayers();
-		output->add<uint32_t>(players.size());
-		for (const auto &it : players) {
-			output->addString(it.second->getName(), "ProtocolStatus::sendInfo - it.second->getName()");
-			output->add<uint32_t>(it.second->getLevel());
-		}
+		output->addBytes(current->extPlayersInfo.data(), current->extPlayersInfo.size());
 	}
 
 	if (requestedInfo & REQUEST_PLAYER_STATUS_INFO) {
 		output->addByte(0x22); // players info - online status info of a player
-		if (g_game().getPlayerByName(characterName) != nullptr) {
+		if (current->playerNames.contains(asLowerCaseString(characterName))) {
 			output->addByte(0x01);
 		} else {
 			output->addByte(0x00);
@@ -25,11 +25,17 @@ public:
 	explicit ProtocolStatus(Connection_ptr conn) :
 		Protocol(conn) { }
 
-	void onRecvFirstMessage(NetworkMessage &msg) override;
+	bool onRecvFirstMessage(NetworkMessage &msg) override;
 
 	void sendStatusString();
 	void sendInfo(uint16_t requestedInfo, const std::string &characterName);
 
+	/**
+	 * Rebuilds the responses served to the status requests, called from the dispatcher every statusCacheTime.
+	 * The responses are built on the thread pool from the last world snapshot (Game::getWorldSnapshot).
+	 */
+	static void updateSnapshot();
+
 	static const uint64_t start;
 
 	static std::string SERVER_NAME;
@@ -37,5 +43,22 @@ public:
 	static std::string SERVER_DEVELOPERS;
 
 private:
+	struct Snapshot {
+		std::string statusString;
+		// The players (0x20), map (0x30) and players list (0x21) blocks of sendInfo
+		std::string playersInfo;
+		std::string mapInfo;
+		std::string extPlayersInfo;
+		// Lower case
+		phmap::flat_hash_set<std::string> playerNames;
+	};
+
+	static std::shared_ptr<const Snapshot> getSnapshot();
+
+	// The requests are answered on the network threads
+	static std::mutex ipConnectMutex;
 	static std::map<uint32_t, int64_t> ipConnectMap;
+
+	static std::mutex snapshotMutex;
+	static std::shared_ptr<const Snapshot> snapshot;
 };
@@ -14,6 +14,7 @@
 #include "game/scheduling/dispatcher.hpp"
 #include "utils/tools.hpp"
 #include "lib/di/container.hpp"
+#include "lib/metrics/measured_lock.hpp"
 
 Webhook::Webhook(ThreadPool &threadPool) :
 	threadPool(threadPool) {
@@ -30,23 +31,55 @@ Webhook::Webhook(ThreadPool &threadPool) :
 		return;
 	}
 
+	multiHandle = curl_multi_init();
+	if (!multiHandle) {
+		g_logger().error("Failed to init curl, curl_multi_init failed");
+		return;
+	}
+
 	run();
 }
 
+Webhook::~Webhook() {
+	for (auto* handle : idleHandles) {
+		curl_easy_cleanup(handle);
+	}
+	if (multiHandle) {
+		curl_multi_cleanup(multiHandle);
+	}
+	curl_slist_free_all(headers);
+}
+
 Webhook &Webhook::getInstance() {
 	return inject<Webhook>();
 }
 
 void Webhook::run() {
-	threadPool.detach_task([this] { sendWebhook(); });
+	// A slow endpoint must not pile up senders, the next one picks up what was queued meanwhile
+	if (!sending.exchange(true)) {
+		threadPool.detachTask(ThreadLane::Network, [this] {
+			sendWebhook();
+			sending = false;
+		});
+	}
 	g_dispatcher().scheduleEvent(
 		g_configManager().getNumber(DISCORD_WEBHOOK_DELAY_MS, __FUNCTION__), [this] { run(); }, "Webhook::run"
 	);
 }
 
+void Webhook::queue(WebhookTask &&task) {
+	const auto maxQueue = static_cast<size_t>(std::max<int32_t>(g_configManager().getNumber(DISCORD_WEBHOOK_MAX_QUEUE, __FUNCTION__), 1));
+
+	metrics::measured_lock lock(taskLock, __METHOD_NAME__);
+	while (webhooks.size() >= maxQueue) {
+		webhooks.pop_front();
+		++droppedWebhooks;
+	}
+	webhooks.emplace_back(std::move(task));
+}
+
 void Webhook::sendPayload(const std::string &payload, std::string url) {
-	std::scoped_lock lock { taskLock };
-	webhooks.push_back(std::make_shared<WebhookTask>(payload, url));
+	queue({ WebhookTask::Type::Payload, payload, std::move(url) });
 }
 
 void Webhook::sendMessage(const std::string &title, const std::string &message, int color, std::string url, bool embed) {
@@ -58,7 +91,11 @@ void Webhook::sendMessage(const std::string &title, const std::string &message,
 		return;
 	}
 
-	sendPayload(getPayload(title, message, color, embed), url);
+	if (embed) {
+		queue({ WebhookTask::Type::Embed, getEmbed(title, message, color), std::move(url) });
+	} else {
+		queue({ WebhookTask::Type::Content, message, std::move(url) });
+	}
 }
 
 void Webhook::sendMessage(const std::string &message, std::string url) {
@@ -70,40 +107,7 @@ void Webhook::sendMessage(const std::string &message, std::string url) {
 		return;
 	}
 
-	sendPayload(getPayload("", message, -1, false), url);
-}
-
-int Webhook::sendRequest(const char* url, const char* payload, std::string* response_body) const {
-	CURL* curl = curl_easy_init();
-	if (!curl) {
-		g_logger().error("Failed to send webhook message; curl_easy_init failed");
-		return -1;
-	}
-
-	curl_easy_setopt(curl, CURLOPT_URL, url);
-	curl_easy_setopt(curl, CURLOPT_SSLVERSION, CURL_SSLVERSION_TLSv1_2);
-	curl_easy_setopt(curl, CURLOPT_POST, 1L);
-	curl_easy_setopt(curl, CURLOPT_POSTFIELDS, payload);
-	curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, &Webhook::writeCallback);
-	curl_easy_setopt(curl, CURLOPT_WRITEDATA, reinterpret_cast<void*>(response_body));
-	curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
-	curl_easy_setopt(curl, CURLOPT_USERAGENT, "canary (https://github.com/opentibiabr/canary)");
-
-	CURLcode res = curl_easy_perform(curl);
-
-	if (res != CURLE_OK) {
-		g_logger().error("Failed to send webhook message with the error: {}", curl_easy_strerror(res));
-		curl_easy_cleanup(curl);
-
-		return -1;
-	}
-
-	int response_code;
-
-	curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &response_code);
-	curl_easy_cleanup(curl);
-
-	return response_code;
+	queue({ WebhookTask::Type::Content, message, std::move(url) });
 }
 
 size_t Webhook::writeCallback(void* contents, size_t size, size_t nmemb, void* userp) {
@@ -113,69 +117,200 @@ size_t Webhook::writeCallback(void* contents, size_t size, size_t nmemb, void* u
 	return real_size;
 }
 
-std::string Webhook::getPayload(const std::string &title, const std::string &message, int color, bool embed) const {
-	std::time_t now = getTimeNow();
-	std::string time_buf = formatDate(now);
-
-	std::stringstream footer_text;
-	footer_text
-		<< g_configManager().getString(SERVER_NAME, __FUNCTION__) << " | "
-		<< time_buf;
+std::string Webhook::getEmbed(const std::string &title, const std::string &message, int color) const {
+	std::stringstream embed;
+	embed << "{ \"title\": \"" << title << "\"";
+	if (!message.empty()) {
+		embed << ", \"description\": \"" << message << "\"";
+	}
+	if (g_configManager().getBoolean(DISCORD_SEND_FOOTER, __FUNCTION__)) {
+		embed << ", \"footer\": { \"text\": \"" << g_configManager().getString(SERVER_NAME, __FUNCTION__) << " | " << formatDate(getTimeNow()) << "\" }";
+	}
+	if (color >= 0) {
+		embed << ", \"color\": " << color;
+	}
+	embed << " }";
+	return embed.str();
+}
 
-	std::stringstream payload;
-	if (embed) {
-		payload << "{ \"embeds\": [{ ";
-		payload << "\"title\": \"" << title << "\", ";
-		if (!message.empty()) {
-			payload << "\"description\": \"" << message << "\", ";
-		}
-		if (g_configManager().getBoolean(DISCORD_SEND_FOOTER, __FUNCTION__)) {
-			payload << "\"footer\": { \"text\": \"" << footer_text.str() << "\" }, ";
+std::vector<Webhook::Request> Webhook::buildRequests(std::deque<WebhookTask> &tasks) {
+	std::vector<Request> requests;
+	// The request still accepting messages, by url and type
+	std::map<std::pair<std::string, WebhookTask::Type>, size_t> openRequests;
+	std::vector<size_t> parts;
+
+	for (auto &task : tasks) {
+		if (task.type != WebhookTask::Type::Payload) {
+			auto it = openRequests.find({ task.url, task.type });
+			if (it != openRequests.end()) {
+				auto &request = requests[it->second];
+				auto &count = parts[it->second];
+				if (task.type == WebhookTask::Type::Embed && count < MAX_EMBEDS_PER_MESSAGE) {
+					request.payload.append(", ").append(task.body);
+					request.tasks.emplace_back(std::move(task));
+					++count;
+					continue;
+				}
+				// Lines are joined by an escaped line break
+				if (task.type == WebhookTask::Type::Content && request.payload.size() + task.body.size() + 2 <= MAX_CONTENT_LENGTH) {
+					request.payload.append("\\n").append(task.body);
+					request.tasks.emplace_back(std::move(task));
+					++count;
+					continue;
+				}
+			}
+			openRequests[{ task.url, task.type }] = requests.size();
 		}
-		if (color >= 0) {
-			payload << "\"color\": " << color;
+
+		auto &request = requests.emplace_back();
+		request.url = task.url;
+		request.payload = task.body;
+		request.tasks.emplace_back(std::move(task));
+		parts.emplace_back(1);
+	}
+
+	for (auto &request : requests) {
+		switch (request.tasks.front().type) {
+			case WebhookTask::Type::Embed:
+				request.payload = "{ \"embeds\": [" + request.payload + "] }";
+				break;
+			case WebhookTask::Type::Content:
+				request.payload = "{ \"content\": \"" + request.payload + "\" }";
+				break;
+			default:
+				break;
 		}
-		payload << " }] }";
-	} else {
-		payload << "{ \"content\": \"" << (!message.empty() ? message : title) << "\" }";
 	}
+	return requests;
+}
 
-	return payload.str();
+CURL* Webhook::acquireHandle() {
+	if (!idleHandles.empty()) {
+		auto* handle = idleHandles.back();
+		idleHandles.pop_back();
+		return handle;
+	}
+
+	CURL* handle = curl_easy_init();
+	if (!handle) {
+		g_logger().error("Failed to send webhook message; curl_easy_init failed");
+		return nullptr;
+	}
+
+	curl_easy_setopt(handle, CURLOPT_SSLVERSION, CURL_SSLVERSION_TLSv1_2);
+	curl_easy_setopt(handle, CURLOPT_POST, 1L);
+	curl_easy_setopt(handle, CURLOPT_WRITEFUNCTION, &Webhook::writeCallback);
+	curl_easy_setopt(handle, CURLOPT_HTTPHEADER, headers);
+	curl_easy_setopt(handle, CURLOPT_USERAGENT, "canary (https://github.com/opentibiabr/canary)");
+	curl_easy_setopt(handle, CURLOPT_TIMEOUT_MS, 10000L);
+	return handle;
 }
 
-void Webhook::sendWebhook() {
-	std::scoped_lock lock { taskLock };
-	if (webhooks.empty()) {
-		return;
+void Webhook::releaseHandle(CURL* handle) {
+	// Enough to keep the connections of a few webhook urls alive
+	static constexpr size_t MAX_IDLE_HANDLES = 8;
+	if (idleHandles.size() < MAX_IDLE_HANDLES) {
+		idleHandles.emplace_back(handle);
+	} else {
+		curl_easy_cleanup(handle);
 	}
+}
 
-	auto task = webhooks.front();
+void Webhook::sendWebhook() {
+	std::deque<WebhookTask> tasks;
+	size_t dropped = 0;
+	{
+		metrics::measured_lock lock(taskLock, __METHOD_NAME__);
+		tasks.swap(webhooks);
+		dropped = std::exchange(droppedWebhooks, 0);
+	}
 
-	std::string response_body;
-	auto response_code = sendRequest(task->url.c_str(), task->payload.c_str(), &response_body);
+	if (dropped > 0) {
+		g_logger().warn("Webhook queue is full, {} messages were dropped", dropped);
+	}
 
-	if (response_code == -1) {
+	if (tasks.empty() || !multiHandle) {
 		return;
 	}
 
-	if (response_code == 429 || response_code == 504) {
-		g_logger().warn("Webhook encountered error code {}, re-queueing task.", response_code);
+	auto requests = buildRequests(tasks);
+	std::vector<WebhookTask> retry;
+	for (auto &request : requests) {
+		request.handle = acquireHandle();
+		if (!request.handle) {
+			std::ranges::move(request.tasks, std::back_inserter(retry));
+			continue;
+		}
 
-		return;
+		curl_easy_setopt(request.handle, CURLOPT_URL, request.url.c_str());
+		curl_easy_setopt(request.handle, CURLOPT_POSTFIELDS, request.payload.c_str());
+		curl_easy_setopt(request.handle, CURLOPT_WRITEDATA, reinterpret_cast<void*>(&request.responseBody));
+		curl_easy_setopt(request.handle, CURLOPT_PRIVATE, reinterpret_cast<void*>(&request));
+		curl_multi_add_handle(multiHandle, request.handle);
 	}
 
-	webhooks.pop_front();
+	int running = 0;
+	do {
+		if (curl_multi_perform(multiHandle, &running) != CURLM_OK) {
+			break;
+		}
+		if (running > 0) {
+			curl_multi_poll(multiHandle, nullptr, 0, 1000, nullptr);
+		}
+	} while (running > 0);
 
-	if (response_code >= 300) {
-		g_logger().error(
-			"Failed to send webhook message, error code: {} response body: {} request body: {}",
-			response_code,
-			response_body,
-			task->payload
-		);
+	int pending = 0;
+	while (CURLMsg* msg = curl_multi_info_read(multiHandle, &pending)) {
+		if (msg->msg != CURLMSG_DONE) {
+			continue;
+		}
+
+		Request* request = nullptr;
+		curl_easy_getinfo(msg->easy_handle, CURLINFO_PRIVATE, reinterpret_cast<char**>(&request));
+		if (msg->data.result != CURLE_OK) {
+			g_logger().error("Failed to send webhook message with the error: {}", curl_easy_strerror(msg->data.result));
+			std::ranges::move(request->tasks, std::back_inserter(retry));
+			continue;
+		}
+
+		long responseCode = 0;
+		curl_easy_getinfo(msg->easy_handle, CURLINFO_RESPONSE_CODE, &responseCode);
+		if (responseCode == 429 || responseCode == 504) {
+			g_logger().warn("Webhook encountered error code {}, re-queueing task.", responseCode);
+			std::ranges::move(request->tasks, std::back_inserter(retry));
+			continue;
+		}
 
+		if (responseCode >= 300) {
+			g_logger().error(
+				"Failed to send webhook message, error code: {} response body: {} request body: {}",
+				responseCode,
+				request->responseBody,
+				request->payload
+			);
+			continue;
+		}
+
+		g_logger().debug("Webhook successfully sent to {}", request->url);
+	}
+
+	for (auto &request : requests) {
+		if (request.handle) {
+			curl_multi_remove_handle(multiHandle, request.handle);
+			releaseHandle(request.handle);
+		}
+	}
+
+	if (retry.empty()) {
 		return;
 	}
 
-	g_logger().debug("Webhook successfully sent to {}", task->url);
+	// Retried before the ones queued meanwhile, the queue bound still applies
+	const auto maxQueue = static_cast<size_t>(std::max<int32_t>(g_configManager().getNumber(DISCORD_WEBHOOK_MAX_QUEUE, __FUNCTION__), 1));
+	metrics::measured_lock lock(taskLock, __METHOD_NAME__);
+	webhooks.insert(webhooks.begin(), std::make_move_iterator(retry.begin()), std::make_move_iterator(retry.end()));
+	while (webhooks.size() > maxQueue) {
+		webhooks.pop_front();
+		++droppedWebhooks;
+	}
 }
@@ -12,15 +12,26 @@
 #include "lib/thread/thread_pool.hpp"
 
 struct WebhookTask {
-	std::string payload;
+	enum class Type : uint8_t {
+		// A full payload, sent as is
+		Payload,
+		// An embed object or a content line, merged with the ones queued for the same url
+		Embed,
+		Content,
+	};
+
+	Type type;
+	std::string body;
 	std::string url;
 };
 
 class Webhook {
 public:
 	static constexpr size_t DEFAULT_DELAY_MS = 1000;
+	static constexpr size_t DEFAULT_MAX_QUEUE = 1000;
 
 	explicit Webhook(ThreadPool &threadPool);
+	~Webhook();
 
 	// Singleton - ensures we don't accidentally copy it
 	Webhook(const Webhook &) = delete;
@@ -35,16 +46,42 @@ public:
 	void sendMessage(const std::string &message, std::string url = "");
 
 private:
+	// Discord limits
+	static constexpr size_t MAX_EMBEDS_PER_MESSAGE = 10;
+	static constexpr size_t MAX_CONTENT_LENGTH = 2000;
+
+	struct Request {
+		CURL* handle = nullptr;
+		std::string url;
+		std::string payload;
+		std::string responseBody;
+		// Tasks to queue again if the request must be retried
+		std::vector<WebhookTask> tasks;
+	};
+
 	std::mutex taskLock;
 	ThreadPool &threadPool;
-	std::deque<std::shared_ptr<WebhookTask>> webhooks;
+	std::deque<WebhookTask> webhooks;
+	size_t droppedWebhooks = 0;
 	curl_slist* headers = nullptr;
 
+	// Only used by the running sendWebhook, the easy handles are kept to reuse their connections
+	std::atomic<bool> sending = false;
+	CURLM* multiHandle = nullptr;
+	std::vector<CURL*> idleHandles;
+
+	void queue(WebhookTask &&task);
 	void sendWebhook();
 
-	int sendRequest(const char* url, const char* payload, std::string* response_body) const;
+	/**
+	 * Merges the queued messages for the same url into as few requests as Discord accepts.
+	 */
+	static std::vector<Request> buildRequests(std::deque<WebhookTask> &tasks);
+	CURL* acquireHandle();
+	void releaseHandle(CURL* handle);
+
 	static size_t writeCallback(void* contents, size_t size, size_t nmemb, void* userp);
-	std::string getPayload(const std::string &title, const std::string &message, int color, bool embed = true) const;
+	std::string getEmbed(const std::string &title, const std::string &message, int color) const;
 };
 
 constexpr auto g_webhook = Webhook::getInstance;
@@ -14,6 +14,13 @@
 #include "config/configmanager.hpp"
 #include "game/scheduling/dispatcher.hpp"
 #include "creatures/players/management/ban.hpp"
+#include "utils/tools.hpp"
+
+namespace {
+#ifdef SO_REUSEPORT
+	using reuse_port = asio::detail::socket_option::boolean<SOL_SOCKET, SO_REUSEPORT>;
+#endif
+}
 
 ServiceManager::~ServiceManager() {
 	try {
@@ -24,9 +31,32 @@ ServiceManager::~ServiceManager() {
 }
 
 void ServiceManager::die() {
+	extraIoWorkGuards.clear();
+	for (const auto &extraIoService : extraIoServices) {
+		extraIoService->stop();
+	}
 	io_service.stop();
 }
 
+const std::vector<asio::io_service*> &ServiceManager::getIoServices() {
+	if (!ioServices.empty()) {
+		return ioServices;
+	}
+
+	auto threads = g_configManager().getNumber(NETWORK_IO_THREADS, __FUNCTION__);
+	if (threads <= 0) {
+		threads = static_cast<int32_t>(getNumberOfCores());
+	}
+
+	ioServices.emplace_back(&io_service);
+	for (int32_t i = 1; i < threads; ++i) {
+		const auto &extraIoService = extraIoServices.emplace_back(std::make_unique<asio::io_service>(1));
+		extraIoWorkGuards.emplace_back(asio::make_work_guard(*extraIoService));
+		ioServices.emplace_back(extraIoService.get());
+	}
+	return ioServices;
+}
+
 void ServiceManager::run() {
 	if (running) {
 		g_logger().error("ServiceManager is already running!", __FUNCTION__);
@@ -35,7 +65,22 @@ void ServiceManager::run() {
 
 	assert(!running);
 	running = true;
+#ifdef FEATURE_IO_URING
+	g_logger().info("Network running on io_uring");
+#endif
+	for (const auto &extraIoService : extraIoServices) {
+		extraIoThreads.emplace_back([&extraIoService = *extraIoService] { extraIoService.run(); });
+	}
+	if (!extraIoThreads.empty()) {
+		g_logger().info("Network running with {} threads", extraIoThreads.size() + 1);
+	}
+
 	io_service.run();
+
+	for (auto &thread : extraIoThreads) {
+		thread.join();
+	}
+	extraIoThreads.clear();
 }
 
 void ServiceManager::stop() {
@@ -83,16 +128,18 @@ std::string ServicePort::get_protocol_names() const {
 	return str;
 }
 
-void ServicePort::accept() {
-	if (!acceptor) {
+void ServicePort::accept(size_t index) {
+	if (index >= acceptors.size()) {
 		return;
 	}
 
-	auto connection = ConnectionManager::getInstance().createConnection(io_service, shared_from_this());
-	acceptor->async_accept(connection->getSocket(), [self = shared_from_this(), connection](const std::error_code &error) { self->onAccept(connection, error); });
+	// With a single acceptor the connections are spread over the io services in turns
+	auto &connection_io_service = acceptors.size() == io_services.size() ? *io_services[index] : *io_services[nextIoService++ % io_services.size()];
+	auto connection = ConnectionManager::getInstance().createConnection(connection_io_service, shared_from_this());
+	acceptors[index]->async_accept(connection->getSocket(), [self = shared_from_this(), index, connection](const std::error_code &error) { self->onAccept(index, connection, error); });
 }
 
-void ServicePort::onAccept(Connection_ptr connection, const std::error_code &error) {
+void ServicePort::onAccept(size_t index, Connection_ptr connection, const std::error_code &error) {
 	if (!error) {
 		if (services.empty()) {
 			return;
@@ -102,6 +149,7 @@ void ServicePort::onAccept(Connection_ptr connection, const std::error_code &err
 		if (remote_ip != 0 && inject<Ban>().acceptConnection(remote_ip)) {
 			Service_ptr service = services.front();
 			if (service->is_single_socket()) {
+				connection->protocolName = service->get_protocol_name();
 				connection->accept(service->make_protocol(connection));
 			} else {
 				connection->acceptInternal();
@@ -110,11 +158,10 @@ void ServicePort::onAccept(Connection_ptr connection, const std::error_code &err
 			connection->close(FORCE_CLOSE);
 		}
 
-		accept();
+		accept(index);
 	} else if (error != asio::error::operation_aborted) {
-		if (!pendingStart) {
+		if (!pendingStart.exchange(true)) {
 			close();
-			pendingStart = true;
 			g_dispatcher().scheduleEvent(
 				15000, [self = shared_from_this(), serverPort = serverPort] { ServicePort::openAcceptor(std::weak_ptr<ServicePort>(self), serverPort); }, "ServicePort::openAcceptor"
 			);
@@ -130,6 +177,7 @@ Protocol_ptr ServicePort::make_protocol(bool checksummed, NetworkMessage &msg, c
 		}
 
 		if ((checksummed && service->is_checksummed()) || !service->is_checksummed()) {
+			connection->protocolName = service->get_protocol_name();
 			return service->make_protocol(connection);
 		}
 	}
@@ -152,18 +200,42 @@ void ServicePort::open(uint16_t port) {
 	serverPort = port;
 	pendingStart = false;
 
+	acceptors.clear();
+
 	try {
+		asio::ip::tcp::endpoint endpoint;
 		if (g_configManager().getBoolean(BIND_ONLY_GLOBAL_ADDRESS, __FUNCTION__)) {
-			acceptor.reset(new asio::ip::tcp::acceptor(io_service, asio::ip::tcp::endpoint(asio::ip::address(asio::ip::address_v4::from_string(g_configManager().getString(IP, __FUNCTION__))), serverPort)));
+			endpoint = asio::ip::tcp::endpoint(asio::ip::address(asio::ip::address_v4::from_string(g_configManager().getString(IP, __FUNCTION__))), serverPort);
 		} else {
-			acceptor.reset(new asio::ip::tcp::acceptor(io_service, asio::ip::tcp::endpoint(asio::ip::address(asio::ip::address_v4(INADDR_ANY)), serverPort)));
+			endpoint = asio::ip::tcp::endpoint(asio::ip::address(asio::ip::address_v4(INADDR_ANY)), serverPort);
 		}
 
-		acceptor->set_option(asio::ip::tcp::no_delay(true));
+		// Every network thread listens on the port by itself, the kernel balances the connections between them
+#ifdef SO_REUSEPORT
+		const auto count = io_services.size();
+#else
+		const size_t count = 1;
+#endif
+		for (size_t i = 0; i < count; ++i) {
+			const auto &acceptor = acceptors.emplace_back(std::make_unique<asio::ip::tcp::acceptor>(*io_services[i]));
+			acceptor->open(endpoint.protocol());
+			acceptor->set_option(asio::ip::tcp::acceptor::reuse_address(true));
+#ifdef SO_REUSEPORT
+			if (count > 1) {
+				acceptor->set_option(reuse_port(true));
+			}
+#endif
+			acceptor->bind(endpoint);
+			acceptor->listen();
+			acceptor->set_option(asio::ip::tcp::no_delay(true));
+		}
 
-		accept();
+		for (size_t i = 0; i < acceptors.size(); ++i) {
+			accept(i);
+		}
 	} catch (const std::system_error &e) {
 		g_logger().warn("[ServicePort::open] - Error code: {}", e.what());
+		close();
 
 		pendingStart = true;
 		g_dispatcher().scheduleEvent(
@@ -174,9 +246,11 @@ void ServicePort::open(uint16_t port) {
 }
 
 void ServicePort::close() {
-	if (acceptor && acceptor->is_open()) {
-		std::error_code error;
-		acceptor->close(error);
+	for (const auto &acceptor : acceptors) {
+		if (acceptor->is_open()) {
+			std::error_code error;
+			acceptor->close(error);
+		}
 	}
 }
 
@@ -49,8 +49,8 @@ public:
 
 class ServicePort : public std::enable_shared_from_this<ServicePort> {
 public:
-	explicit ServicePort(asio::io_service &init_io_service) :
-		io_service(init_io_service) { }
+	explicit ServicePort(std::vector<asio::io_service*> init_io_services) :
+		io_services(std::move(init_io_services)) { }
 	~ServicePort();
 
 	// non-copyable
@@ -67,17 +67,20 @@ public:
 	Protocol_ptr make_protocol(bool checksummed, NetworkMessage &msg, const Connection_ptr &connection) const;
 
 	void onStopServer();
-	void onAccept(Connection_ptr connection, const std::error_code &error);
+	void onAccept(size_t index, Connection_ptr connection, const std::error_code &error);
 
 private:
-	void accept();
+	void accept(size_t index);
 
-	asio::io_service &io_service;
-	std::unique_ptr<asio::ip::tcp::acceptor> acceptor;
+	// One io service per network thread, a connection stays on the one it was accepted on
+	std::vector<asio::io_service*> io_services;
+	// One acceptor per io service when SO_REUSEPORT is available, otherwise a single one
+	std::vector<std::unique_ptr<asio::ip::tcp::acceptor>> acceptors;
 	std::vector<Service_ptr> services;
 
 	uint16_t serverPort = 0;
-	bool pendingStart = false;
+	std::atomic_size_t nextIoService = 0;
+	std::atomic_bool pendingStart = false;
 };
 
 class ServiceManager {
@@ -101,10 +104,16 @@ public:
 
 private:
 	void die();
+	const std::vector<asio::io_service*> &getIoServices();
 
 	phmap::flat_hash_map<uint16_t, ServicePort_ptr> acceptors;
 
 	asio::io_service io_service;
+	// networkIoThreads - 1 extra io services, each one run by its own thread
+	std::vector<std::unique_ptr<asio::io_service>> extraIoServices;
+	std::vector<asio::executor_work_guard<asio::io_service::executor_type>> extraIoWorkGuards;
+	std::vector<std::thread> extraIoThreads;
+	std::vector<asio::io_service*> ioServices;
 	Signals signals { io_service };
 	asio::high_resolution_timer death_timer { io_service };
 	bool running = false;
@@ -124,7 +133,7 @@ bool ServiceManager::add(uint16_t port) {
 	auto foundServicePort = acceptors.find(port);
 
 	if (foundServicePort == acceptors.end()) {
-		service_port = std::make_shared<ServicePort>(io_service);
+		service_port = std::make_shared<ServicePort>(getIoServices());
 		service_port->open(port);
 		acceptors[port] = service_port;
 	} else {
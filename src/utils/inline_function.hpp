@@ -0,0 +1,177 @@
+/**
+ * Canary - A free and open-source MMORPG server emulator
+ * Copyright (©) 2019-2024 OpenTibiaBR <opentibiabr@outlook.com>
+ * Repository: https://github.com/opentibiabr/canary
+ * License: https://github.com/opentibiabr/canary/blob/main/LICENSE
+ * Contributors: https://github.com/opentibiabr/canary/graphs/contributors
+ * Website: https://docs.opentibiabr.com/
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+// inline_function is a std::function replacement that keeps the callable in a fixed
+// inline buffer, callables bigger than the buffer are still accepted, but allocated on the heap.
+// Use it where many short-lived callables are created, like dispatcher tasks.
+
+namespace stdext {
+	template <typename Signature, size_t Capacity = 64>
+	class inline_function;
+
+	template <typename R, typename... Args, size_t Capacity>
+	class inline_function<R(Args...), Capacity> {
+	public:
+		inline_function() noexcept = default;
+
+		inline_function(std::nullptr_t) noexcept { }
+
+		template <typename F, typename = std::enable_if_t<!std::is_same_v<std::decay_t<F>, inline_function> && std::is_invocable_r_v<R, std::decay_t<F> &, Args...>>>
+		inline_function(F &&f) {
+			using Fn = std::decay_t<F>;
+			if constexpr (std::is_pointer_v<std::remove_cvref_t<F>> || std::is_member_pointer_v<std::remove_cvref_t<F>>) {
+				if (f == nullptr) {
+					return;
+				}
+			} else if constexpr (requires(const Fn &fn) { fn.operator bool(); }) {
+				// std::function and similar wrappers may be empty
+				if (!static_cast<bool>(f)) {
+					return;
+				}
+			}
+
+			if constexpr (isInline<Fn>()) {
+				new (storage) Fn(std::forward<F>(f));
+			} else {
+				*reinterpret_cast<Fn**>(storage) = new Fn(std::forward<F>(f));
+			}
+			vtable = &vtableFor<Fn>;
+		}
+
+		inline_function(const inline_function &other) {
+			if (other.vtable) {
+				other.vtable->copy(storage, other.storage);
+				vtable = other.vtable;
+			}
+		}
+
+		inline_function(inline_function &&other) noexcept {
+			if (other.vtable) {
+				other.vtable->move(storage, other.storage);
+				vtable = std::exchange(other.vtable, nullptr);
+			}
+		}
+
+		~inline_function() {
+			reset();
+		}
+
+		inline_function &operator=(const inline_function &other) {
+			if (this != &other) {
+				inline_function(other).swap(*this);
+			}
+			return *this;
+		}
+
+		inline_function &operator=(inline_function &&other) noexcept {
+			if (this != &other) {
+				reset();
+				if (other.vtable) {
+					other.vtable->move(storage, other.storage);
+					vtable = std::exchange(other.vtable, nullptr);
+				}
+			}
+			return *this;
+		}
+
+		inline_function &operator=(std::nullptr_t) noexcept {
+			reset();
+			return *this;
+		}
+
+		R operator()(Args... args) const {
+			return vtable->invoke(const_cast<std::byte*>(storage), std::forward<Args>(args)...);
+		}
+
+		explicit operator bool() const noexcept {
+			return vtable != nullptr;
+		}
+
+		bool operator==(std::nullptr_t) const noexcept {
+			return vtable == nullptr;
+		}
+
+		void swap(inline_function &other) noexcept {
+			inline_function tmp(std::move(other));
+			other = std::move(*this);
+			*this = std::move(tmp);
+		}
+
+	private:
+		struct VTable {
+			R (*invoke)(void* storage, Args &&... args);
+			void (*copy)(void* dst, const void* src);
+			void (*move)(void* dst, void* src) noexcept;
+			void (*destroy)(void* storage) noexcept;
+		};
+
+		template <typename Fn>
+		static constexpr bool isInline() {
+			return sizeof(Fn) <= Capacity && alignof(Fn) <= alignof(std::max_align_t) && std::is_nothrow_move_constructible_v<Fn>;
+		}
+
+		template <typename Fn>
+		static Fn* target(void* storage) {
+			if constexpr (isInline<Fn>()) {
+				return std::launder(reinterpret_cast<Fn*>(storage));
+			} else {
+				return *reinterpret_cast<Fn**>(storage);
+			}
+		}
+
+		template <typename Fn>
+		static constexpr VTable vtableFor = {
+			[](void* storage, Args &&... args) -> R {
+				return std::invoke(*target<Fn>(storage), std::forward<Args>(args)...);
+			},
+			[](void* dst, const void* src) {
+				const auto* fn = target<Fn>(const_cast<void*>(src));
+				if constexpr (isInline<Fn>()) {
+					new (dst) Fn(*fn);
+				} else {
+					*reinterpret_cast<Fn**>(dst) = new Fn(*fn);
+				}
+			},
+			[](void* dst, void* src) noexcept {
+				if constexpr (isInline<Fn>()) {
+					auto* fn = target<Fn>(src);
+					new (dst) Fn(std::move(*fn));
+					fn->~Fn();
+				} else {
+					*reinterpret_cast<Fn**>(dst) = *reinterpret_cast<Fn**>(src);
+				}
+			},
+			[](void* storage) noexcept {
+				if constexpr (isInline<Fn>()) {
+					target<Fn>(storage)->~Fn();
+				} else {
+					delete target<Fn>(storage);
+				}
+			},
+		};
+
+		void reset() noexcept {
+			if (vtable) {
+				vtable->destroy(storage);
+				vtable = nullptr;
+			}
+		}
+
+		alignas(std::max_align_t) std::byte storage[Capacity];
+		const VTable* vtable = nullptr;
+	};
+}
@@ -0,0 +1,96 @@
+/**
+ * Canary - A free and open-source MMORPG server emulator
+ * Copyright (©) 2019-2024 OpenTibiaBR <opentibiabr@outlook.com>
+ * Repository: https://github.com/opentibiabr/canary
+ * License: https://github.com/opentibiabr/canary/blob/main/LICENSE
+ * Contributors: https://github.com/opentibiabr/canary/graphs/contributors
+ * Website: https://docs.opentibiabr.com/
+ */
+
+#pragma once
+
+#include <atomic>
+#include <new>
+#include <utility>
+
+#include "utils/pool_allocator.hpp"
+
+// mpsc_queue is an intrusive multi producer, single consumer queue (Vyukov's algorithm).
+// push never blocks and may be called from any thread, pop must only be called by one consumer at a time.
+// pop may return false while a push is halfway done, a consumer that knows an element is coming can retry.
+// Nodes come from a shared_block_pool: they are allocated by the producers and freed by the consumer, so the
+// freed nodes are handed back to the producer threads in batches and a push does not touch the global allocator
+// in the steady state.
+
+namespace stdext {
+	template <typename T>
+	class mpsc_queue {
+	public:
+		mpsc_queue() noexcept = default;
+
+		// non-copyable
+		mpsc_queue(const mpsc_queue &) = delete;
+		mpsc_queue &operator=(const mpsc_queue &) = delete;
+
+		~mpsc_queue() {
+			T value;
+			while (pop(value)) { }
+		}
+
+		void push(T value) {
+			auto* node = new (NodePool::allocate()) Node { std::move(value) };
+			link(node);
+		}
+
+		bool pop(T &value) {
+			Node* node = tail;
+			Node* next = node->next.load(std::memory_order_acquire);
+			if (node == &stub) {
+				if (!next) {
+					return false;
+				}
+				tail = next;
+				node = next;
+				next = next->next.load(std::memory_order_acquire);
+			}
+
+			if (!next) {
+				if (node != head.load(std::memory_order_acquire)) {
+					// A producer swapped the head but did not link its node yet
+					return false;
+				}
+				// node is the last one, the stub is put behind it so it can be taken
+				link(&stub);
+				next = node->next.load(std::memory_order_acquire);
+				if (!next) {
+					return false;
+				}
+			}
+
+			tail = next;
+			value = std::move(node->value);
+			node->~Node();
+			NodePool::deallocate(node);
+			return true;
+		}
+
+	private:
+		struct Node {
+			T value {};
+			std::atomic<Node*> next = nullptr;
+		};
+
+		using NodePool = shared_block_pool<sizeof(Node), alignof(Node)>;
+
+		void link(Node* node) noexcept {
+			node->next.store(nullptr, std::memory_order_relaxed);
+			Node* prev = head.exchange(node, std::memory_order_acq_rel);
+			prev->next.store(node, std::memory_order_release);
+		}
+
+		Node stub;
+		std::atomic<Node*> head = &stub;
+		// Only touched by the consumer
+		Node* tail = &stub;
+	};
+}
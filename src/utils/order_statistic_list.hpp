@@ -0,0 +1,162 @@
+/**
+ * Canary - A free and open-source MMORPG server emulator
+ * Copyright (©) 2019-2024 OpenTibiaBR <opentibiabr@outlook.com>
+ * Repository: https://github.com/opentibiabr/canary
+ * License: https://github.com/opentibiabr/canary/blob/main/LICENSE
+ * Contributors: https://github.com/opentibiabr/canary/graphs/contributors
+ * Website: https://docs.opentibiabr.com/
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+// order_statistic_list is a sorted set that also finds the position of a value and the value
+// at a position, without walking the elements before it. The values are kept in sorted blocks
+// of at most 2 * BlockSize, so every operation only walks the block sizes and one block.
+
+namespace stdext {
+	template <typename T, typename Compare = std::less<T>, size_t BlockSize = 256>
+	class order_statistic_list {
+	public:
+		size_t size() const noexcept {
+			return m_size;
+		}
+		bool empty() const noexcept {
+			return m_size == 0;
+		}
+
+		void clear() noexcept {
+			m_blocks.clear();
+			m_size = 0;
+		}
+
+		/**
+		 * @return false if an equivalent value was already in the list.
+		 */
+		bool insert(const T &value) {
+			if (m_blocks.empty()) {
+				m_blocks.emplace_back().emplace_back(value);
+				++m_size;
+				return true;
+			}
+
+			auto blockIt = findBlock(value);
+			if (blockIt == m_blocks.end()) {
+				--blockIt;
+			}
+
+			auto &block = *blockIt;
+			auto it = std::lower_bound(block.begin(), block.end(), value, m_compare);
+			if (it != block.end() && !m_compare(value, *it)) {
+				return false;
+			}
+
+			block.insert(it, value);
+			++m_size;
+
+			if (block.size() > BlockSize * 2) {
+				std::vector<T> upper(std::make_move_iterator(block.begin() + BlockSize), std::make_move_iterator(block.end()));
+				block.resize(BlockSize);
+				m_blocks.insert(blockIt + 1, std::move(upper));
+			}
+			return true;
+		}
+
+		/**
+		 * @return false if the value was not in the list.
+		 */
+		bool erase(const T &value) {
+			auto blockIt = findBlock(value);
+			if (blockIt == m_blocks.end()) {
+				return false;
+			}
+
+			auto &block = *blockIt;
+			auto it = std::lower_bound(block.begin(), block.end(), value, m_compare);
+			if (it == block.end() || m_compare(value, *it)) {
+				return false;
+			}
+
+			block.erase(it);
+			--m_size;
+
+			if (block.empty()) {
+				m_blocks.erase(blockIt);
+			} else if (block.size() < BlockSize / 2 && blockIt + 1 != m_blocks.end() && block.size() + (blockIt + 1)->size() <= BlockSize * 2) {
+				// Merged with the next one, so the number of blocks stays proportional to the size
+				auto &next = *(blockIt + 1);
+				block.insert(block.end(), std::make_move_iterator(next.begin()), std::make_move_iterator(next.end()));
+				m_blocks.erase(blockIt + 1);
+			}
+			return true;
+		}
+
+		/**
+		 * @return the number of values ordered before value, whether it is in the list or not.
+		 */
+		size_t rank(const T &value) const {
+			size_t before = 0;
+			for (const auto &block : m_blocks) {
+				if (!m_compare(block.back(), value)) {
+					return before + static_cast<size_t>(std::lower_bound(block.begin(), block.end(), value, m_compare) - block.begin());
+				}
+				before += block.size();
+			}
+			return before;
+		}
+
+		bool contains(const T &value) const {
+			const auto index = rank(value);
+			return index < m_size && !m_compare(value, at(index));
+		}
+
+		// Expects index < size()
+		const T &at(size_t index) const {
+			for (const auto &block : m_blocks) {
+				if (index < block.size()) {
+					return block[index];
+				}
+				index -= block.size();
+			}
+			return m_blocks.back().back();
+		}
+
+		/**
+		 * Calls f with up to count values, from the one at index first, in order.
+		 */
+		template <typename F>
+		void forEach(size_t first, size_t count, F &&f) const {
+			for (const auto &block : m_blocks) {
+				if (count == 0) {
+					return;
+				}
+
+				if (first >= block.size()) {
+					first -= block.size();
+					continue;
+				}
+
+				for (auto i = first; i < block.size() && count > 0; ++i, --count) {
+					f(block[i]);
+				}
+				first = 0;
+			}
+		}
+
+	private:
+		// The first block whose last value is not ordered before value
+		auto findBlock(const T &value) {
+			return std::find_if(m_blocks.begin(), m_blocks.end(), [&](const auto &block) {
+				return !m_compare(block.back(), value);
+			});
+		}
+
+		std::vector<std::vector<T>> m_blocks;
+		size_t m_size = 0;
+		[[no_unique_address]] Compare m_compare;
+	};
+}
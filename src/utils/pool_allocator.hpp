@@ -0,0 +1,268 @@
+/**
+ * Canary - A free and open-source MMORPG server emulator
+ * Copyright (©) 2019-2024 OpenTibiaBR <opentibiabr@outlook.com>
+ * Repository: https://github.com/opentibiabr/canary
+ * License: https://github.com/opentibiabr/canary/blob/main/LICENSE
+ * Contributors: https://github.com/opentibiabr/canary/graphs/contributors
+ * Website: https://docs.opentibiabr.com/
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <mutex>
+#include <new>
+#include <vector>
+
+// pool_allocator is a std allocator for objects that are created and destroyed at a high rate
+// (e.g. with std::allocate_shared). Freed blocks are kept in a thread local free list
+// and reused by the next allocation of the same size, so the global allocator is only
+// touched when the list is empty or full.
+
+namespace stdext {
+	template <size_t Size, size_t Align, size_t MaxCached = 4096>
+	class fixed_block_pool {
+	public:
+		static void* allocate() {
+			auto &cache = localCache();
+			if (cache.head) {
+				auto* node = cache.head;
+				cache.head = node->next;
+				--cache.size;
+				return node;
+			}
+
+			return ::operator new(BlockSize, std::align_val_t(BlockAlign));
+		}
+
+		static void deallocate(void* ptr) noexcept {
+			auto &cache = localCache();
+			if (cache.size >= MaxCached) {
+				::operator delete(ptr, std::align_val_t(BlockAlign));
+				return;
+			}
+
+			auto* node = static_cast<Node*>(ptr);
+			node->next = cache.head;
+			cache.head = node;
+			++cache.size;
+		}
+
+	private:
+		struct Node {
+			Node* next;
+		};
+
+		static constexpr size_t BlockSize = Size < sizeof(Node) ? sizeof(Node) : Size;
+		static constexpr size_t BlockAlign = Align < alignof(Node) ? alignof(Node) : Align;
+
+		// Trivially destructible on purpose, so it is still usable while thread locals are being destroyed
+		struct Cache {
+			Node* head = nullptr;
+			size_t size = 0;
+		};
+
+		// Frees the blocks left in the thread list when the thread exits, the list stays usable after it
+		struct CacheOwner {
+			Cache* cache;
+
+			~CacheOwner() {
+				while (cache->head) {
+					auto* next = cache->head->next;
+					::operator delete(cache->head, std::align_val_t(BlockAlign));
+					cache->head = next;
+				}
+				cache->size = 0;
+			}
+		};
+
+		static Cache &localCache() {
+			thread_local Cache cache;
+			thread_local CacheOwner owner { &cache };
+			return cache;
+		}
+	};
+
+	// shared_block_pool is a fixed_block_pool for blocks that are allocated on one thread and freed
+	// on another (e.g. packets built by the dispatcher and released by the network threads).
+	// The thread local lists hand full batches over to a shared list, where the allocating
+	// thread takes them back from, the lock is only taken once per batch.
+	// At most MaxSharedBatches batches are kept, the rest goes back to the global allocator.
+	template <size_t Size, size_t Align, size_t BatchSize = 32, size_t MaxSharedBatches = 32>
+	class shared_block_pool {
+	public:
+		static void* allocate() {
+			auto &cache = localCache();
+			if (!cache.head) {
+				refill(cache);
+			}
+
+			if (cache.head) {
+				auto* node = cache.head;
+				cache.head = node->next;
+				--cache.size;
+				return node;
+			}
+
+			return ::operator new(BlockSize, std::align_val_t(BlockAlign));
+		}
+
+		static void deallocate(void* ptr) noexcept {
+			auto &cache = localCache();
+			auto* node = static_cast<Node*>(ptr);
+			node->next = cache.head;
+			cache.head = node;
+			if (++cache.size >= BatchSize * 2) {
+				release(cache);
+			}
+		}
+
+	private:
+		struct Node {
+			Node* next;
+		};
+
+		static constexpr size_t BlockSize = Size < sizeof(Node) ? sizeof(Node) : Size;
+		static constexpr size_t BlockAlign = Align < alignof(Node) ? alignof(Node) : Align;
+
+		// Trivially destructible on purpose, so it is still usable while thread locals are being destroyed
+		struct Cache {
+			Node* head = nullptr;
+			size_t size = 0;
+		};
+
+		struct Shared {
+			std::mutex mutex;
+			std::vector<Node*> batches;
+		};
+
+		// Hands the blocks left in the thread list over when the thread exits, the list stays usable after it
+		struct CacheOwner {
+			Cache* cache;
+
+			~CacheOwner() {
+				while (cache->size >= BatchSize) {
+					release(*cache);
+				}
+				while (cache->head) {
+					auto* next = cache->head->next;
+					::operator delete(cache->head, std::align_val_t(BlockAlign));
+					cache->head = next;
+				}
+				cache->size = 0;
+			}
+		};
+
+		static Cache &localCache() {
+			thread_local Cache cache;
+			thread_local CacheOwner owner { &cache };
+			return cache;
+		}
+
+		static Shared &shared() {
+			// Never destroyed, blocks may still be freed after static destruction
+			static auto* instance = new Shared();
+			return *instance;
+		}
+
+		static void refill(Cache &cache) {
+			auto &pool = shared();
+			std::scoped_lock lock(pool.mutex);
+			if (!pool.batches.empty()) {
+				cache.head = pool.batches.back();
+				cache.size = BatchSize;
+				pool.batches.pop_back();
+			}
+		}
+
+		// Moves BatchSize blocks from the head of the thread list to the shared list
+		static void release(Cache &cache) noexcept {
+			auto* batch = cache.head;
+			auto* last = batch;
+			for (size_t i = 1; i < BatchSize; ++i) {
+				last = last->next;
+			}
+			cache.head = last->next;
+			cache.size -= BatchSize;
+			last->next = nullptr;
+
+			{
+				auto &pool = shared();
+				std::scoped_lock lock(pool.mutex);
+				if (pool.batches.size() < MaxSharedBatches) {
+					pool.batches.emplace_back(batch);
+					return;
+				}
+			}
+
+			while (batch) {
+				auto* next = batch->next;
+				::operator delete(batch, std::align_val_t(BlockAlign));
+				batch = next;
+			}
+		}
+	};
+
+	template <typename T>
+	class pool_allocator {
+	public:
+		using value_type = T;
+
+		pool_allocator() noexcept = default;
+
+		template <typename U>
+		pool_allocator(const pool_allocator<U> &) noexcept { }
+
+		T* allocate(size_t n) {
+			if (n != 1) {
+				return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t(alignof(T))));
+			}
+			return static_cast<T*>(fixed_block_pool<sizeof(T), alignof(T)>::allocate());
+		}
+
+		void deallocate(T* ptr, size_t n) noexcept {
+			if (n != 1) {
+				::operator delete(ptr, std::align_val_t(alignof(T)));
+				return;
+			}
+			fixed_block_pool<sizeof(T), alignof(T)>::deallocate(ptr);
+		}
+
+		template <typename U>
+		bool operator==(const pool_allocator<U> &) const noexcept {
+			return true;
+		}
+	};
+
+	// Same as pool_allocator, for objects that are usually freed on another thread than the one that allocated them
+	template <typename T>
+	class shared_pool_allocator {
+	public:
+		using value_type = T;
+
+		shared_pool_allocator() noexcept = default;
+
+		template <typename U>
+		shared_pool_allocator(const shared_pool_allocator<U> &) noexcept { }
+
+		T* allocate(size_t n) {
+			if (n != 1) {
+				return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t(alignof(T))));
+			}
+			return static_cast<T*>(shared_block_pool<sizeof(T), alignof(T)>::allocate());
+		}
+
+		void deallocate(T* ptr, size_t n) noexcept {
+			if (n != 1) {
+				::operator delete(ptr, std::align_val_t(alignof(T)));
+				return;
+			}
+			shared_block_pool<sizeof(T), alignof(T)>::deallocate(ptr);
+		}
+
+		template <typename U>
+		bool operator==(const shared_pool_allocator<U> &) const noexcept {
+			return true;
+		}
+	};
+}
@@ -0,0 +1,184 @@
+/**
+ * Canary - A free and open-source MMORPG server emulator
+ * Copyright (©) 2019-2024 OpenTibiaBR <opentibiabr@outlook.com>
+ * Repository: https://github.com/opentibiabr/canary
+ * License: https://github.com/opentibiabr/canary/blob/main/LICENSE
+ * Contributors: https://github.com/opentibiabr/canary/graphs/contributors
+ * Website: https://docs.opentibiabr.com/
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <utility>
+
+// slot_table hands out the ids of objects and finds an object by its id with an array access.
+// An id is firstId + (generation << IndexBits | index): the index is the slot of the object and the
+// generation counts the times the slot was reused, so the id of a released object does not find the
+// object that took its slot. The released slots are reused in FIFO order, so an id only repeats once
+// its slot went through every generation, which takes that many releases of every other free slot.
+// The slots are in a deque, the references to the values stay valid while the table grows.
+
+namespace stdext {
+	template <typename T, uint32_t IndexBits = 20>
+	class slot_table {
+		struct slot {
+			std::shared_ptr<T> value;
+			uint32_t generation = 1;
+			bool reserved = false;
+		};
+
+	public:
+		using value_type = std::pair<uint32_t, const std::shared_ptr<T> &>;
+
+		class const_iterator {
+		public:
+			const_iterator(const slot_table* table, size_t index) :
+				table(table), index(index) {
+				skip();
+			}
+
+			value_type operator*() const {
+				const auto &s = table->slots[index];
+				return { table->makeId(s.generation, static_cast<uint32_t>(index)), s.value };
+			}
+
+			const_iterator &operator++() {
+				++index;
+				skip();
+				return *this;
+			}
+
+			bool operator==(const const_iterator &other) const {
+				return index == other.index;
+			}
+
+		private:
+			void skip() {
+				while (index < table->slots.size() && !table->slots[index].value) {
+					++index;
+				}
+			}
+
+			const slot_table* table;
+			// By index and not by deque iterator, so a value added while iterating does not invalidate it
+			size_t index;
+		};
+
+		/**
+		 * \param firstId The ids are above it.
+		 * \param idCount How many ids from firstId are available, past the slots it limits the generations.
+		 */
+		slot_table(uint32_t firstId, uint32_t idCount) :
+			firstId(firstId), maxGeneration((idCount >> IndexBits) - 1) { }
+
+		/**
+		 * Takes a slot for a new object, its value is added by set().
+		 * @return the id, 0 when all the slots are taken.
+		 */
+		uint32_t reserve() {
+			uint32_t index;
+			if (!freeIndexes.empty()) {
+				index = freeIndexes.front();
+				freeIndexes.pop_front();
+			} else if (slots.size() < IndexMask + 1) {
+				index = static_cast<uint32_t>(slots.size());
+				slots.emplace_back();
+			} else {
+				return 0;
+			}
+
+			auto &s = slots[index];
+			s.reserved = true;
+			return makeId(s.generation, index);
+		}
+
+		// Whether the id was reserved and not released since
+		bool isReserved(uint32_t id) const {
+			return find(id) != nullptr;
+		}
+
+		// The id must be reserved
+		void set(uint32_t id, std::shared_ptr<T> value) {
+			if (auto* s = find(id)) {
+				if (!s->value && value) {
+					++count;
+				} else if (s->value && !value) {
+					--count;
+				}
+				s->value = std::move(value);
+			}
+		}
+
+		// Clears the value and frees the slot, the id no longer finds anything
+		void release(uint32_t id) {
+			auto* s = find(id);
+			if (!s) {
+				return;
+			}
+
+			if (s->value) {
+				s->value.reset();
+				--count;
+			}
+			s->reserved = false;
+			s->generation = s->generation == maxGeneration ? 1 : s->generation + 1;
+			freeIndexes.push_back((id - firstId) & IndexMask);
+		}
+
+		// nullptr when the id is stale, not reserved or has no value yet
+		std::shared_ptr<T> get(uint32_t id) const {
+			const auto* s = find(id);
+			return s ? s->value : nullptr;
+		}
+
+		// The values that are set
+		size_t size() const noexcept {
+			return count;
+		}
+
+		size_t memoryBytes() const noexcept {
+			return slots.size() * sizeof(slot) + freeIndexes.size() * sizeof(uint32_t);
+		}
+
+		const_iterator begin() const {
+			return { this, 0 };
+		}
+		const_iterator end() const {
+			return { this, slots.size() };
+		}
+
+	private:
+		static constexpr uint32_t IndexMask = (1u << IndexBits) - 1;
+
+		uint32_t makeId(uint32_t generation, uint32_t index) const {
+			return firstId + ((generation << IndexBits) | index);
+		}
+
+		const slot* find(uint32_t id) const {
+			if (id <= firstId) {
+				return nullptr;
+			}
+
+			const uint32_t offset = id - firstId;
+			const uint32_t index = offset & IndexMask;
+			if (index >= slots.size()) {
+				return nullptr;
+			}
+
+			const auto &s = slots[index];
+			return s.reserved && s.generation == offset >> IndexBits ? &s : nullptr;
+		}
+		slot* find(uint32_t id) {
+			return const_cast<slot*>(std::as_const(*this).find(id));
+		}
+
+		std::deque<slot> slots;
+		std::deque<uint32_t> freeIndexes;
+		uint32_t firstId;
+		uint32_t maxGeneration;
+		size_t count = 0;
+	};
+}
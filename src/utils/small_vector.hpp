@@ -0,0 +1,259 @@
+/**
+ * Canary - A free and open-source MMORPG server emulator
+ * Copyright (©) 2019-2024 OpenTibiaBR <opentibiabr@outlook.com>
+ * Repository: https://github.com/opentibiabr/canary
+ * License: https://github.com/opentibiabr/canary/blob/main/LICENSE
+ * Contributors: https://github.com/opentibiabr/canary/graphs/contributors
+ * Website: https://docs.opentibiabr.com/
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <utility>
+
+// small_vector is a std::vector replacement that keeps up to N elements inline,
+// it only allocates when it grows past that. Iterators are plain pointers,
+// so, like std::vector, they are invalidated on insertion and erase.
+
+namespace stdext {
+	template <typename T, size_t N>
+	class small_vector {
+	public:
+		using value_type = T;
+		using size_type = size_t;
+		using reference = T &;
+		using const_reference = const T &;
+		using iterator = T*;
+		using const_iterator = const T*;
+		using reverse_iterator = std::reverse_iterator<iterator>;
+		using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+		small_vector() noexcept = default;
+
+		small_vector(const small_vector &other) {
+			reserve(other.m_size);
+			std::uninitialized_copy(other.begin(), other.end(), m_data);
+			m_size = other.m_size;
+		}
+
+		small_vector(small_vector &&other) noexcept(std::is_nothrow_move_constructible_v<T>) {
+			moveFrom(std::move(other));
+		}
+
+		~small_vector() {
+			clear();
+			release();
+		}
+
+		small_vector &operator=(const small_vector &other) {
+			if (this != &other) {
+				small_vector(other).swap(*this);
+			}
+			return *this;
+		}
+
+		small_vector &operator=(small_vector &&other) noexcept(std::is_nothrow_move_constructible_v<T>) {
+			if (this != &other) {
+				clear();
+				release();
+				moveFrom(std::move(other));
+			}
+			return *this;
+		}
+
+		void swap(small_vector &other) noexcept(std::is_nothrow_move_constructible_v<T>) {
+			small_vector tmp(std::move(other));
+			other = std::move(*this);
+			*this = std::move(tmp);
+		}
+
+		iterator begin() noexcept {
+			return m_data;
+		}
+		const_iterator begin() const noexcept {
+			return m_data;
+		}
+		iterator end() noexcept {
+			return m_data + m_size;
+		}
+		const_iterator end() const noexcept {
+			return m_data + m_size;
+		}
+		reverse_iterator rbegin() noexcept {
+			return reverse_iterator(end());
+		}
+		const_reverse_iterator rbegin() const noexcept {
+			return const_reverse_iterator(end());
+		}
+		reverse_iterator rend() noexcept {
+			return reverse_iterator(begin());
+		}
+		const_reverse_iterator rend() const noexcept {
+			return const_reverse_iterator(begin());
+		}
+
+		T* data() noexcept {
+			return m_data;
+		}
+		const T* data() const noexcept {
+			return m_data;
+		}
+
+		size_t size() const noexcept {
+			return m_size;
+		}
+		size_t capacity() const noexcept {
+			return m_capacity;
+		}
+		bool empty() const noexcept {
+			return m_size == 0;
+		}
+		bool isInline() const noexcept {
+			return m_data == inlineData();
+		}
+
+		T &operator[](size_t index) noexcept {
+			return m_data[index];
+		}
+		const T &operator[](size_t index) const noexcept {
+			return m_data[index];
+		}
+
+		T &at(size_t index) {
+			if (index >= m_size) {
+				throw std::out_of_range("small_vector::at");
+			}
+			return m_data[index];
+		}
+		const T &at(size_t index) const {
+			if (index >= m_size) {
+				throw std::out_of_range("small_vector::at");
+			}
+			return m_data[index];
+		}
+
+		T &front() noexcept {
+			return m_data[0];
+		}
+		const T &front() const noexcept {
+			return m_data[0];
+		}
+		T &back() noexcept {
+			return m_data[m_size - 1];
+		}
+		const T &back() const noexcept {
+			return m_data[m_size - 1];
+		}
+
+		void reserve(size_t capacity) {
+			if (capacity <= m_capacity) {
+				return;
+			}
+
+			auto* data = static_cast<T*>(::operator new(capacity * sizeof(T), std::align_val_t(alignof(T))));
+			std::uninitialized_move(begin(), end(), data);
+			std::destroy(begin(), end());
+			release();
+			m_data = data;
+			m_capacity = capacity;
+		}
+
+		template <typename... Args>
+		T &emplace_back(Args &&... args) {
+			if (m_size == m_capacity) {
+				// Built before growing, args may point into the current storage
+				T value(std::forward<Args>(args)...);
+				reserve(m_capacity * 2);
+				return *new (m_data + m_size++) T(std::move(value));
+			}
+			return *new (m_data + m_size++) T(std::forward<Args>(args)...);
+		}
+
+		void push_back(const T &value) {
+			emplace_back(value);
+		}
+		void push_back(T &&value) {
+			emplace_back(std::move(value));
+		}
+
+		void pop_back() noexcept {
+			std::destroy_at(m_data + --m_size);
+		}
+
+		iterator insert(const_iterator pos, const T &value) {
+			return emplace(pos, value);
+		}
+		iterator insert(const_iterator pos, T &&value) {
+			return emplace(pos, std::move(value));
+		}
+
+		template <typename... Args>
+		iterator emplace(const_iterator pos, Args &&... args) {
+			const auto index = static_cast<size_t>(pos - begin());
+			T value(std::forward<Args>(args)...);
+			emplace_back(std::move(value));
+			std::rotate(begin() + index, end() - 1, end());
+			return begin() + index;
+		}
+
+		iterator erase(const_iterator pos) {
+			return erase(pos, pos + 1);
+		}
+
+		iterator erase(const_iterator first, const_iterator last) {
+			auto* from = begin() + (first - begin());
+			auto* to = begin() + (last - begin());
+			if (from != to) {
+				auto* newEnd = std::move(to, end(), from);
+				std::destroy(newEnd, end());
+				m_size -= static_cast<size_t>(to - from);
+			}
+			return from;
+		}
+
+		void clear() noexcept {
+			std::destroy(begin(), end());
+			m_size = 0;
+		}
+
+	private:
+		T* inlineData() noexcept {
+			return reinterpret_cast<T*>(m_inline);
+		}
+		const T* inlineData() const noexcept {
+			return reinterpret_cast<const T*>(m_inline);
+		}
+
+		void release() noexcept {
+			if (!isInline()) {
+				::operator delete(m_data, std::align_val_t(alignof(T)));
+				m_data = inlineData();
+				m_capacity = N;
+			}
+		}
+
+		// Expects this to be empty and inline
+		void moveFrom(small_vector &&other) noexcept(std::is_nothrow_move_constructible_v<T>) {
+			if (other.isInline()) {
+				std::uninitialized_move(other.begin(), other.end(), m_data);
+				m_size = other.m_size;
+				other.clear();
+			} else {
+				m_data = std::exchange(other.m_data, other.inlineData());
+				m_size = std::exchange(other.m_size, 0);
+				m_capacity = std::exchange(other.m_capacity, N);
+			}
+		}
+
+		T* m_data = inlineData();
+		size_t m_size = 0;
+		size_t m_capacity = N;
+		alignas(T) std::byte m_inline[sizeof(T) * N];
+	};
+}
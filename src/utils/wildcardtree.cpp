@@ -11,100 +11,103 @@
 
 #include "utils/wildcardtree.hpp"
 
-std::shared_ptr<WildcardTreeNode> WildcardTreeNode::getChild(char ch) {
-	auto it = children.find(ch);
-	if (it == children.end()) {
-		return nullptr;
-	}
-	return it->second;
+std::vector<WildcardTree::Node>::iterator WildcardTree::findChild(Node &node, char ch) {
+	return std::ranges::lower_bound(node.children, ch, {}, [](const Node &child) { return child.edge.front(); });
 }
 
-std::shared_ptr<WildcardTreeNode> WildcardTreeNode::getChild(char ch) const {
-	auto it = children.find(ch);
-	if (it == children.end()) {
-		return nullptr;
+void WildcardTree::insert(const std::string &str) {
+	if (!str.empty()) {
+		insert(root, str);
 	}
-	return it->second;
 }
 
-std::shared_ptr<WildcardTreeNode> WildcardTreeNode::addChild(char ch, bool breakp) {
-	std::shared_ptr<WildcardTreeNode> child = getChild(ch);
-	if (child) {
-		if (breakp && !child->breakpoint) {
-			child->breakpoint = true;
-		}
-	} else {
-		auto pair = children.emplace(std::piecewise_construct, std::forward_as_tuple(ch), std::forward_as_tuple(std::make_shared<WildcardTreeNode>(breakp)));
-		child = pair.first->second;
+void WildcardTree::insert(Node &node, std::string_view str) {
+	auto it = findChild(node, str.front());
+	if (it == node.children.end() || it->edge.front() != str.front()) {
+		node.children.insert(it, Node { std::string(str), {}, true });
+		return;
 	}
-	return child;
-}
-
-void WildcardTreeNode::insert(const std::string &str) {
-	std::shared_ptr<WildcardTreeNode> cur = static_self_cast<WildcardTreeNode>();
 
-	size_t length = str.length() - 1;
-	for (size_t pos = 0; pos < length; ++pos) {
-		cur = cur->addChild(str[pos], false);
+	const auto common = static_cast<size_t>(std::ranges::mismatch(it->edge, str).in1 - it->edge.begin());
+	if (common < it->edge.size()) {
+		// The name branches inside the edge, the rest of it becomes the only child
+		Node tail { it->edge.substr(common), std::move(it->children), it->breakpoint };
+		it->edge.resize(common);
+		it->children.clear();
+		it->children.emplace_back(std::move(tail));
+		it->breakpoint = false;
 	}
 
-	cur->addChild(str[length], true);
+	if (common == str.size()) {
+		it->breakpoint = true;
+	} else {
+		insert(*it, str.substr(common));
+	}
 }
 
-void WildcardTreeNode::remove(const std::string &str) {
-	std::shared_ptr<WildcardTreeNode> cur = static_self_cast<WildcardTreeNode>();
-
-	std::stack<std::shared_ptr<WildcardTreeNode>> path;
-	path.push(cur);
-	size_t len = str.length();
-	for (size_t pos = 0; pos < len; ++pos) {
-		cur = cur->getChild(str[pos]);
-		if (!cur) {
-			return;
-		}
-		path.push(cur);
+void WildcardTree::remove(const std::string &str) {
+	if (!str.empty()) {
+		remove(root, str);
 	}
+}
 
-	cur->breakpoint = false;
+void WildcardTree::remove(Node &node, std::string_view str) {
+	auto it = findChild(node, str.front());
+	if (it == node.children.end() || !str.starts_with(it->edge)) {
+		return;
+	}
 
-	do {
-		cur = path.top();
-		path.pop();
+	const auto rest = str.substr(it->edge.size());
+	if (rest.empty()) {
+		it->breakpoint = false;
+	} else {
+		remove(*it, rest);
+	}
 
-		if (!cur->children.empty() || cur->breakpoint || path.empty()) {
-			break;
-		}
+	if (it->breakpoint) {
+		return;
+	}
 
-		cur = path.top();
+	// Drops the node without names below it, or joins it with its only child
+	if (it->children.empty()) {
+		node.children.erase(it);
+	} else if (it->children.size() == 1) {
+		Node child = std::move(it->children.front());
+		child.edge.insert(0, it->edge);
+		*it = std::move(child);
+	}
+}
 
-		auto it = cur->children.find(str[--len]);
-		if (it != cur->children.end()) {
-			cur->children.erase(it);
+ReturnValue WildcardTree::findOne(const std::string &query, std::string &result) const {
+	const Node* cur = &root;
+	std::string_view rest = query;
+	result = query;
+	while (!rest.empty()) {
+		const auto it = std::ranges::lower_bound(cur->children, rest.front(), {}, [](const Node &child) { return child.edge.front(); });
+		if (it == cur->children.end() || it->edge.front() != rest.front()) {
+			return RETURNVALUE_PLAYERWITHTHISNAMEISNOTONLINE;
 		}
-	} while (true);
-}
 
-ReturnValue WildcardTreeNode::findOne(const std::string &query, std::string &result) const {
-	auto cur = static_self_cast<const WildcardTreeNode>();
-	for (char pos : query) {
-		cur = cur->getChild(pos);
-		if (!cur) {
+		const auto length = std::min(rest.size(), it->edge.size());
+		if (rest.substr(0, length) != std::string_view(it->edge).substr(0, length)) {
 			return RETURNVALUE_PLAYERWITHTHISNAMEISNOTONLINE;
 		}
-	}
 
-	result = query;
+		// The query ends inside the edge, the rest of it is the only way on
+		result.append(it->edge, length);
+		rest.remove_prefix(length);
+		cur = &*it;
+	}
 
-	do {
-		size_t size = cur->children.size();
+	while (true) {
+		const size_t size = cur->children.size();
 		if (size == 0) {
 			return RETURNVALUE_NOERROR;
 		} else if (size > 1 || cur->breakpoint) {
 			return RETURNVALUE_NAMEISTOOAMBIGUOUS;
 		}
 
-		auto it = cur->children.begin();
-		result += it->first;
-		cur = it->second;
-	} while (true);
+		cur = &cur->children.front();
+		result += cur->edge;
+	}
 }
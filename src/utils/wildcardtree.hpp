@@ -11,26 +11,34 @@
 
 #include "declarations.hpp"
 
-class WildcardTreeNode : public SharedObject {
+/**
+ * The names of the online players by prefix, as a radix tree: a node holds the whole run of characters
+ * up to the next branch, so a name takes a node or two instead of one per character, and the children
+ * of a node are kept in a vector sorted by their first character.
+ */
+class WildcardTree {
 public:
-	explicit WildcardTreeNode(bool initBreakpoint) :
-		breakpoint(initBreakpoint) { }
-	WildcardTreeNode(WildcardTreeNode &&other) noexcept = default;
-
-	// non-copyable
-	WildcardTreeNode(const WildcardTreeNode &) = delete;
-	WildcardTreeNode &operator=(const WildcardTreeNode &) = delete;
-
-	std::shared_ptr<WildcardTreeNode> getChild(char ch);
-	std::shared_ptr<WildcardTreeNode> getChild(char ch) const;
-	std::shared_ptr<WildcardTreeNode> addChild(char ch, bool breakpoint);
-
 	void insert(const std::string &str);
 	void remove(const std::string &str);
 
+	/**
+	 * Completes the query to the single name that starts with it.
+	 * @return RETURNVALUE_NAMEISTOOAMBIGUOUS when more than one does.
+	 */
 	ReturnValue findOne(const std::string &query, std::string &result) const;
 
 private:
-	std::map<char, std::shared_ptr<WildcardTreeNode>> children;
-	bool breakpoint;
+	struct Node {
+		// The characters from the parent to this node, short ones are stored inline by the string
+		std::string edge;
+		std::vector<Node> children;
+		// Whether a name ends here
+		bool breakpoint = false;
+	};
+
+	static std::vector<Node>::iterator findChild(Node &node, char ch);
+	static void insert(Node &node, std::string_view str);
+	static void remove(Node &node, std::string_view str);
+
+	Node root;
 };
@@ -0,0 +1,85 @@
+/**
+ * Canary - A free and open-source MMORPG server emulator
+ * Copyright (©) 2019-2024 OpenTibiaBR <opentibiabr@outlook.com>
+ * Repository: https://github.com/opentibiabr/canary
+ * License: https://github.com/opentibiabr/canary/blob/main/LICENSE
+ * Contributors: https://github.com/opentibiabr/canary/graphs/contributors
+ * Website: https://docs.opentibiabr.com/
+ */
+
+#include "pch.hpp"
+
+#include "benchmark_world.hpp"
+
+#include "config/configmanager.hpp"
+#include "creatures/players/player.hpp"
+#include "game/game.hpp"
+#include "items/item.hpp"
+#include "items/tile.hpp"
+
+namespace {
+	uint16_t findItemId(const std::function<bool(const ItemType &)> &match) {
+		for (size_t id = 100; id < Item::items.size(); ++id) {
+			const auto &itemType = Item::items[id];
+			if (itemType.id != 0 && match(itemType)) {
+				return static_cast<uint16_t>(id);
+			}
+		}
+		return 0;
+	}
+}
+
+bool BenchmarkWorld::load() {
+	const char* configFile = std::getenv("CANARY_CONFIG");
+	g_configManager().setConfigFileLua(configFile ? configFile : "config.lua.dist");
+	if (!g_configManager().load()) {
+		g_logger().error("[{}] - Could not load {}", __FUNCTION__, g_configManager().getConfigFileLua());
+		return false;
+	}
+
+	const auto coreFolder = g_configManager().getString(CORE_DIRECTORY, __FUNCTION__);
+	if (g_game().loadAppearanceProtobuf(coreFolder + "/items/appearances.dat") != ERROR_NONE || !Item::items.loadFromXml()) {
+		g_logger().error("[{}] - Could not load the items from {}/items", __FUNCTION__, coreFolder);
+		return false;
+	}
+
+	// Plain walkable ground, and a wall that blocks the path searches
+	groundId = findItemId([](const ItemType &itemType) {
+		return itemType.isGroundTile() && itemType.speed > 0 && !itemType.blockSolid && !itemType.blockPathFind && itemType.floorChange == TILESTATE_NONE;
+	});
+	wallId = findItemId([](const ItemType &itemType) {
+		return !itemType.isGroundTile() && !itemType.isContainer() && itemType.blockSolid && itemType.blockPathFind && !itemType.movable && !itemType.pickupable && itemType.floorChange == TILESTATE_NONE;
+	});
+	if (groundId == 0 || wallId == 0) {
+		g_logger().error("[{}] - The items have no plain ground or wall to build the map", __FUNCTION__);
+		return false;
+	}
+
+	generateMap();
+	return true;
+}
+
+void BenchmarkWorld::generateMap() {
+	auto &map = g_game().map;
+	for (uint16_t x = 0; x < WIDTH; ++x) {
+		for (uint16_t y = 0; y < HEIGHT; ++y) {
+			Position position(static_cast<uint16_t>(ORIGIN.x + x), static_cast<uint16_t>(ORIGIN.y + y), ORIGIN.z);
+			const auto tile = std::make_shared<StaticTile>(position.x, position.y, position.z);
+			tile->internalAddThing(Item::CreateItem(groundId, position));
+			// A gap of 4 tiles every 32 rows
+			if (x >= CREATURE_AREA && x % 8 == 0 && y % 32 >= 4) {
+				tile->internalAddThing(Item::CreateItem(wallId, position));
+			}
+			map.setTile(position, tile);
+		}
+	}
+
+	// Always the same spread, so the runs can be compared
+	std::mt19937 generator(42);
+	std::uniform_int_distribution<uint16_t> column(0, CREATURE_AREA - 1);
+	std::uniform_int_distribution<uint16_t> row(0, HEIGHT - 1);
+	for (uint16_t i = 0; i < PLAYERS; ++i) {
+		const auto player = std::make_shared<Player>(nullptr);
+		map.placeCreature(getCreatureAreaPosition(column(generator), row(generator)), player, false, true);
+	}
+}
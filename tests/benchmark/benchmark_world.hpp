@@ -0,0 +1,54 @@
+/**
+ * Canary - A free and open-source MMORPG server emulator
+ * Copyright (©) 2019-2024 OpenTibiaBR <opentibiabr@outlook.com>
+ * Repository: https://github.com/opentibiabr/canary
+ * License: https://github.com/opentibiabr/canary/blob/main/LICENSE
+ * Contributors: https://github.com/opentibiabr/canary/graphs/contributors
+ * Website: https://docs.opentibiabr.com/
+ */
+
+#pragma once
+
+#include "game/movement/position.hpp"
+
+/**
+ * The data the benchmarks run on: the config (CANARY_CONFIG, config.lua.dist by default),
+ * the items of the datapack and a generated map, so the results do not depend on a world map.
+ * The map is a floor of ground from ORIGIN, the first CREATURE_AREA columns have players
+ * spread on them, the others have walls every 8 columns (with gaps) for the path searches
+ * and no creatures, for the tile descriptions.
+ */
+class BenchmarkWorld {
+public:
+	static constexpr uint16_t WIDTH = 256;
+	static constexpr uint16_t HEIGHT = 128;
+	static constexpr uint16_t CREATURE_AREA = 128;
+	static constexpr uint16_t PLAYERS = 256;
+
+	static constexpr Position ORIGIN { 1000, 1000, 7 };
+
+	// Run from the root of the repository, the paths of the config are relative
+	static bool load();
+
+	static uint16_t getGroundId() {
+		return groundId;
+	}
+	static uint16_t getWallId() {
+		return wallId;
+	}
+
+	// Inside the area with players
+	static Position getCreatureAreaPosition(uint16_t x, uint16_t y) {
+		return { static_cast<uint16_t>(ORIGIN.x + x % CREATURE_AREA), static_cast<uint16_t>(ORIGIN.y + y % HEIGHT), ORIGIN.z };
+	}
+	// Inside the area with walls
+	static Position getPathAreaPosition(uint16_t x, uint16_t y) {
+		return { static_cast<uint16_t>(ORIGIN.x + CREATURE_AREA + x % (WIDTH - CREATURE_AREA)), static_cast<uint16_t>(ORIGIN.y + y % HEIGHT), ORIGIN.z };
+	}
+
+private:
+	static void generateMap();
+
+	inline static uint16_t groundId = 0;
+	inline static uint16_t wallId = 0;
+};
@@ -0,0 +1,34 @@
+/**
+ * Canary - A free and open-source MMORPG server emulator
+ * Copyright (©) 2019-2024 OpenTibiaBR <opentibiabr@outlook.com>
+ * Repository: https://github.com/opentibiabr/canary
+ * License: https://github.com/opentibiabr/canary/blob/main/LICENSE
+ * Contributors: https://github.com/opentibiabr/canary/graphs/contributors
+ * Website: https://docs.opentibiabr.com/
+ */
+
+#include "pch.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include "game/scheduling/dispatcher.hpp"
+
+/**
+ * The dispatcher loop is not running, so the queued tasks stay until the process exits:
+ * the iterations are fixed to keep the memory bounded, the cost is the one of the caller.
+ */
+static void BM_DispatcherAddEvent(benchmark::State &state) {
+	for (auto _ : state) {
+		g_dispatcher().addEvent([] { }, "BM_DispatcherAddEvent");
+	}
+}
+BENCHMARK(BM_DispatcherAddEvent)->Iterations(1 << 18);
+
+// Scheduled and stopped again, as the creature and condition events usually are
+static void BM_DispatcherScheduleEvent(benchmark::State &state) {
+	for (auto _ : state) {
+		const auto eventId = g_dispatcher().scheduleEvent(60000, [] { }, "BM_DispatcherScheduleEvent");
+		g_dispatcher().stopEvent(eventId);
+	}
+}
+BENCHMARK(BM_DispatcherScheduleEvent)->Iterations(1 << 18);
@@ -0,0 +1,72 @@
+/**
+ * Canary - A free and open-source MMORPG server emulator
+ * Copyright (©) 2019-2024 OpenTibiaBR <opentibiabr@outlook.com>
+ * Repository: https://github.com/opentibiabr/canary
+ * License: https://github.com/opentibiabr/canary/blob/main/LICENSE
+ * Contributors: https://github.com/opentibiabr/canary/graphs/contributors
+ * Website: https://docs.opentibiabr.com/
+ */
+
+#include "pch.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include "items/item.hpp"
+
+// The ids of the loaded items, in a fixed shuffle so the lookups do not follow the memory
+static const std::vector<uint16_t> &getItemIds() {
+	static const auto ids = [] {
+		std::vector<uint16_t> result;
+		for (size_t id = 100; id < Item::items.size(); ++id) {
+			if (Item::items[id].id != 0) {
+				result.emplace_back(static_cast<uint16_t>(id));
+			}
+		}
+		std::ranges::shuffle(result, std::mt19937(3));
+		return result;
+	}();
+	return ids;
+}
+
+static void BM_ItemTypeLookup(benchmark::State &state) {
+	const auto &ids = getItemIds();
+	size_t i = 0;
+	for (auto _ : state) {
+		benchmark::DoNotOptimize(Item::items[ids[i % ids.size()]].weight);
+		++i;
+	}
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ItemTypeLookup);
+
+// The flags the movement and pathing code reads per tile item
+static void BM_ItemTypeHotLookup(benchmark::State &state) {
+	const auto &ids = getItemIds();
+	size_t i = 0;
+	for (auto _ : state) {
+		benchmark::DoNotOptimize(Item::items.getHot(ids[i % ids.size()]));
+		++i;
+	}
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ItemTypeHotLookup);
+
+static void BM_ItemIdByName(benchmark::State &state) {
+	std::vector<std::string> names;
+	for (const auto id : getItemIds()) {
+		if (!Item::items[id].name.empty()) {
+			names.emplace_back(Item::items[id].name);
+		}
+		if (names.size() == 1024) {
+			break;
+		}
+	}
+
+	size_t i = 0;
+	for (auto _ : state) {
+		benchmark::DoNotOptimize(Item::items.getItemIdByName(names[i % names.size()]));
+		++i;
+	}
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ItemIdByName);
@@ -0,0 +1,80 @@
+/**
+ * Canary - A free and open-source MMORPG server emulator
+ * Copyright (©) 2019-2024 OpenTibiaBR <opentibiabr@outlook.com>
+ * Repository: https://github.com/opentibiabr/canary
+ * License: https://github.com/opentibiabr/canary/blob/main/LICENSE
+ * Contributors: https://github.com/opentibiabr/canary/graphs/contributors
+ * Website: https://docs.opentibiabr.com/
+ */
+
+#include "pch.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include "kv/in_memory_kv.hpp"
+
+namespace {
+	KVMemory &getKV() {
+		static KVMemory kv(g_logger());
+		return kv;
+	}
+
+	// Keys like the ones of the player storages
+	std::vector<std::string> makeKeys(size_t count) {
+		std::vector<std::string> keys;
+		keys.reserve(count);
+		for (size_t i = 0; i < count; ++i) {
+			keys.emplace_back(fmt::format("player.{}.storage.{}", i % 64, i));
+		}
+		return keys;
+	}
+}
+
+static void BM_KVSet(benchmark::State &state) {
+	const auto keys = makeKeys(4096);
+	auto &kv = getKV();
+	size_t i = 0;
+	for (auto _ : state) {
+		kv.set(keys[i % keys.size()], static_cast<int>(i));
+		++i;
+	}
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_KVSet);
+
+static void BM_KVGet(benchmark::State &state) {
+	const auto keys = makeKeys(4096);
+	auto &kv = getKV();
+	for (size_t i = 0; i < keys.size(); ++i) {
+		kv.set(keys[i], static_cast<int>(i));
+	}
+
+	size_t i = 0;
+	for (auto _ : state) {
+		benchmark::DoNotOptimize(kv.get(keys[i % keys.size()]));
+		++i;
+	}
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_KVGet);
+
+// Not stored, the in memory store has nothing to load either
+static void BM_KVGetMissing(benchmark::State &state) {
+	auto &kv = getKV();
+	const std::string key = "benchmark.missing";
+	for (auto _ : state) {
+		benchmark::DoNotOptimize(kv.get(key));
+	}
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_KVGetMissing);
+
+static void BM_KVScopedGet(benchmark::State &state) {
+	auto scoped = getKV().scoped("player")->scoped("1");
+	scoped->set("storage", 10);
+	for (auto _ : state) {
+		benchmark::DoNotOptimize(scoped->get("storage"));
+	}
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_KVScopedGet);
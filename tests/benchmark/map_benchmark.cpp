@@ -0,0 +1,96 @@
+/**
+ * Canary - A free and open-source MMORPG server emulator
+ * Copyright (©) 2019-2024 OpenTibiaBR <opentibiabr@outlook.com>
+ * Repository: https://github.com/opentibiabr/canary
+ * License: https://github.com/opentibiabr/canary/blob/main/LICENSE
+ * Contributors: https://github.com/opentibiabr/canary/graphs/contributors
+ * Website: https://docs.opentibiabr.com/
+ */
+
+#include "pch.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include "benchmark_world.hpp"
+
+#include "creatures/creature.hpp"
+#include "creatures/players/player.hpp"
+#include "game/game.hpp"
+#include "map/spectators.hpp"
+
+static void BM_MapGetTile(benchmark::State &state) {
+	auto &map = g_game().map;
+	uint16_t i = 0;
+	for (auto _ : state) {
+		const auto position = BenchmarkWorld::getPathAreaPosition(i * 7, i * 13);
+		benchmark::DoNotOptimize(map.getTile(position));
+		++i;
+	}
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_MapGetTile);
+
+// Outside of the generated map, no sector
+static void BM_MapGetTileMissing(benchmark::State &state) {
+	auto &map = g_game().map;
+	uint16_t i = 0;
+	for (auto _ : state) {
+		benchmark::DoNotOptimize(map.getTile(static_cast<uint16_t>(20000 + i % 1024), static_cast<uint16_t>(20000 + i / 1024 % 1024), 7));
+		++i;
+	}
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_MapGetTileMissing);
+
+// Arg 0: multifloor
+static void BM_SpectatorsFind(benchmark::State &state) {
+	const bool multifloor = state.range(0) != 0;
+	uint16_t i = 0;
+	size_t found = 0;
+	for (auto _ : state) {
+		const auto spectators = Spectators().find<Creature>(BenchmarkWorld::getCreatureAreaPosition(i * 7, i * 13), multifloor);
+		found += spectators.size();
+		++i;
+	}
+	state.counters["spectators"] = benchmark::Counter(static_cast<double>(found), benchmark::Counter::kAvgIterations);
+}
+BENCHMARK(BM_SpectatorsFind)->Arg(0)->Arg(1);
+
+static void BM_SpectatorsFindPlayers(benchmark::State &state) {
+	uint16_t i = 0;
+	for (auto _ : state) {
+		benchmark::DoNotOptimize(Spectators().find<Player>(BenchmarkWorld::getCreatureAreaPosition(i * 7, i * 13), true));
+		++i;
+	}
+}
+BENCHMARK(BM_SpectatorsFindPlayers);
+
+/**
+ * Arg 0: the distance in columns, the searches cross a wall every 8 of them.
+ * The short ones stay in AStarNodes, the long ones go over the sector portals.
+ */
+static void BM_MapGetPathMatching(benchmark::State &state) {
+	const auto distance = static_cast<uint16_t>(state.range(0));
+	auto &map = g_game().map;
+
+	FindPathParams fpp;
+	fpp.fullPathSearch = true;
+	fpp.clearSight = false;
+	fpp.maxSearchDist = distance + 32;
+	fpp.minTargetDist = 0;
+	fpp.maxTargetDist = 1;
+
+	std::vector<Direction> dirList;
+	uint16_t i = 0;
+	int64_t found = 0;
+	for (auto _ : state) {
+		const auto row = static_cast<uint16_t>(i * 17 % BenchmarkWorld::HEIGHT);
+		const auto from = BenchmarkWorld::getPathAreaPosition(1, row);
+		const auto to = BenchmarkWorld::getPathAreaPosition(1 + distance, row + 3);
+		dirList.clear();
+		found += map.getPathMatching(from, dirList, FrozenPathingConditionCall(to), fpp) ? 1 : 0;
+		++i;
+	}
+	state.counters["found"] = benchmark::Counter(static_cast<double>(found), benchmark::Counter::kAvgIterations);
+}
+BENCHMARK(BM_MapGetPathMatching)->Arg(6)->Arg(20)->Arg(60)->Arg(120);
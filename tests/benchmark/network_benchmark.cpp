@@ -0,0 +1,126 @@
+/**
+ * Canary - A free and open-source MMORPG server emulator
+ * Copyright (©) 2019-2024 OpenTibiaBR <opentibiabr@outlook.com>
+ * Repository: https://github.com/opentibiabr/canary
+ * License: https://github.com/opentibiabr/canary/blob/main/LICENSE
+ * Contributors: https://github.com/opentibiabr/canary/graphs/contributors
+ * Website: https://docs.opentibiabr.com/
+ */
+
+#include "pch.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include "benchmark_world.hpp"
+
+#include "game/game.hpp"
+#include "server/network/message/outputmessage.hpp"
+#include "server/network/protocol/protocolgame.hpp"
+
+// Without a connection, the packets are only prepared (compressed, encrypted, checksum)
+class BenchmarkProtocol final : public Protocol {
+public:
+	explicit BenchmarkProtocol(ChecksumMethods_t checksumMethod) :
+		Protocol(nullptr) {
+		constexpr std::array<uint32_t, 4> xteaKey = { 0x1F2E3D4C, 0x5B6A7988, 0x01234567, 0x89ABCDEF };
+		setXTEAKey(xteaKey.data());
+		enableXTEAEncryption();
+		setChecksumMethod(checksumMethod);
+	}
+
+	bool onRecvFirstMessage(NetworkMessage &) override {
+		return false;
+	}
+};
+
+class ProtocolGameBenchmark {
+public:
+	static void getTileDescription(ProtocolGame &protocol, const std::shared_ptr<Tile> &tile, NetworkMessage &msg) {
+		protocol.GetTileDescription(tile, msg);
+	}
+
+	static void getMapDescription(ProtocolGame &protocol, const Position &position, NetworkMessage &msg) {
+		protocol.GetMapDescription(position.x - MAP_MAX_CLIENT_VIEW_PORT_X, position.y - MAP_MAX_CLIENT_VIEW_PORT_Y, position.z, (MAP_MAX_CLIENT_VIEW_PORT_X * 2) + 2, (MAP_MAX_CLIENT_VIEW_PORT_Y * 2) + 2, msg);
+	}
+};
+
+namespace {
+	// Half repeated, half noise, about what the map and creature packets compress to
+	std::vector<char> makePayload(size_t size) {
+		std::vector<char> payload(size);
+		std::mt19937 generator(7);
+		for (size_t i = 0; i < size; ++i) {
+			payload[i] = i % 2 == 0 ? static_cast<char>(i % 16) : static_cast<char>(generator());
+		}
+		return payload;
+	}
+}
+
+// A packet of a few of the usual values: bytes, numbers, strings and positions
+static void BM_NetworkMessageBuild(benchmark::State &state) {
+	const std::string name = "Benchmark Player";
+	const Position position = BenchmarkWorld::ORIGIN;
+	NetworkMessage msg;
+	for (auto _ : state) {
+		msg.reset();
+		for (uint8_t i = 0; i < 16; ++i) {
+			msg.addByte(0x6A);
+			msg.addPosition(position);
+			msg.add<uint16_t>(i);
+			msg.add<uint32_t>(0x10000000 + i);
+			msg.addString(name);
+		}
+		benchmark::DoNotOptimize(msg.getBuffer());
+	}
+	state.SetBytesProcessed(state.iterations() * msg.getLength());
+}
+BENCHMARK(BM_NetworkMessageBuild);
+
+/**
+ * Arg 0: the size of the packet. Without compression (adler32 checksum) it is the XTEA encryption,
+ * with it (sequence checksum) the adaptive compression of the size class comes first.
+ */
+template <ChecksumMethods_t ChecksumMethod>
+static void BM_ProtocolSend(benchmark::State &state) {
+	const auto payload = makePayload(static_cast<size_t>(state.range(0)));
+	const auto protocol = std::make_shared<BenchmarkProtocol>(ChecksumMethod);
+	for (auto _ : state) {
+		const auto msg = OutputMessagePool::getOutputMessage();
+		msg->addBytes(payload.data(), payload.size());
+		protocol->onSendMessage(msg);
+		benchmark::DoNotOptimize(msg->getOutputBuffer());
+	}
+	state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK_TEMPLATE(BM_ProtocolSend, CHECKSUM_METHOD_ADLER32)->Arg(128)->Arg(1024)->Arg(8192);
+BENCHMARK_TEMPLATE(BM_ProtocolSend, CHECKSUM_METHOD_SEQUENCE)->Arg(128)->Arg(1024)->Arg(8192);
+
+// The tiles with walls, the descriptions of creatures need a player that sees them
+static void BM_GetTileDescription(benchmark::State &state) {
+	const auto protocol = std::make_shared<ProtocolGame>(nullptr);
+	auto &map = g_game().map;
+	NetworkMessage msg;
+	uint16_t i = 0;
+	for (auto _ : state) {
+		msg.reset();
+		ProtocolGameBenchmark::getTileDescription(*protocol, map.getTile(BenchmarkWorld::getPathAreaPosition(i / 8 * 8, i)), msg);
+		benchmark::DoNotOptimize(msg.getBuffer());
+		++i;
+	}
+}
+BENCHMARK(BM_GetTileDescription);
+
+// The whole screen, as sent on login and teleports
+static void BM_GetMapDescription(benchmark::State &state) {
+	const auto protocol = std::make_shared<ProtocolGame>(nullptr);
+	NetworkMessage msg;
+	uint16_t i = 0;
+	for (auto _ : state) {
+		msg.reset();
+		ProtocolGameBenchmark::getMapDescription(*protocol, BenchmarkWorld::getPathAreaPosition(i % 64 + 16, i % 64 + 16), msg);
+		benchmark::DoNotOptimize(msg.getBuffer());
+		++i;
+	}
+	state.SetBytesProcessed(state.iterations() * msg.getLength());
+}
+BENCHMARK(BM_GetMapDescription);
@@ -30,7 +30,7 @@ public:
 		KVStore(logger) { }
 
 	KVMemory &reset() {
-		flush();
+		clear();
 		return *this;
 	}
 
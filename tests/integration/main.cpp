@@ -1,10 +1,13 @@
 #include <boost/ut.hpp>
+#include <future>
+#include <latch>
 
 #include "account/account_repository_db.hpp"
 #include "lib/logging/in_memory_logger.hpp"
 #include "utils/tools.hpp"
 #include "enums/account_type.hpp"
 #include "account/account_info.hpp"
+#include "database/database.hpp"
 
 using namespace boost::ut;
 
@@ -35,6 +38,39 @@ void createAccount(Database &db) {
 	));
 }
 
+// The tables of the DBBatch tests, created for each test and dropped after it, the rows of an owner reference its parent row
+auto batchTest(Database &db, const std::function<void(void)> &load) {
+	return [&db, load] {
+		db.executeQuery("CREATE TABLE IF NOT EXISTS `dbbatch_parents` (`id` INT NOT NULL, `value` INT NOT NULL DEFAULT 0, PRIMARY KEY (`id`)) ENGINE=InnoDB");
+		db.executeQuery("CREATE TABLE IF NOT EXISTS `dbbatch_rows` (`owner` INT NOT NULL, `value` INT NOT NULL, FOREIGN KEY (`owner`) REFERENCES `dbbatch_parents` (`id`) ON DELETE CASCADE) ENGINE=InnoDB");
+		db.executeQuery("INSERT INTO `dbbatch_parents` (`id`) VALUES (1), (2)");
+
+		try {
+			load();
+		} catch (...) {
+		}
+
+		db.executeQuery("DROP TABLE IF EXISTS `dbbatch_rows`");
+		db.executeQuery("DROP TABLE IF EXISTS `dbbatch_parents`");
+	};
+}
+
+bool replaceRows(uint64_t owner, const std::vector<int> &values) {
+	DBInsert insert("INSERT INTO `dbbatch_rows` (`owner`, `value`) VALUES ");
+	insert.replace("dbbatch_rows", "owner", owner);
+	for (const auto value : values) {
+		if (!insert.addRow(fmt::format("{}, {}", owner, value))) {
+			return false;
+		}
+	}
+	return insert.execute();
+}
+
+std::string ownerRows(Database &db, uint64_t owner) {
+	const auto result = db.storeQuery(fmt::format("SELECT GROUP_CONCAT(`value` ORDER BY `value`) AS `rows` FROM `dbbatch_rows` WHERE `owner` = {}", owner));
+	return result ? result->getString("rows") : std::string {};
+}
+
 void assertAccountLoad(AccountInfo acc) {
 	expect(eq(acc.id, 111));
 	expect(eq(acc.accountType, AccountType::ACCOUNT_TYPE_SENIORTUTOR));
@@ -159,4 +195,99 @@ int main() {
 		// sessionExpires is not saved
 		expect(eq(acc2.sessionExpires, 0));
 	});
+
+	// The batches write through the shared instance, with a connection for each thread of the tests
+	auto &batchDb = Database::getInstance();
+	batchDb.connect(&dbConfig.host, &dbConfig.user, &dbConfig.password, &dbConfig.database, dbConfig.port, &dbConfig.sock, 4);
+
+	test("Database pool gives each thread inside a transaction a connection of its own") = [&batchDb] {
+		expect(eq(batchDb.getPoolSize(), 4));
+
+		std::latch holding(4);
+		std::vector<uint64_t> connectionIds(4);
+		std::vector<std::thread> threads;
+		for (size_t i = 0; i < connectionIds.size(); ++i) {
+			threads.emplace_back([&batchDb, &holding, &connectionIds, i] {
+				DBTransaction::executeWithinTransaction([&] {
+					const auto result = batchDb.storeQuery("SELECT CONNECTION_ID() AS `id`");
+					connectionIds[i] = result ? result->getNumber<uint64_t>("id") : 0;
+					// Every transaction holds its connection at the same time
+					holding.arrive_and_wait();
+					return true;
+				});
+			});
+		}
+		for (auto &thread : threads) {
+			thread.join();
+		}
+
+		std::ranges::sort(connectionIds);
+		expect(neq(connectionIds[0], uint64_t { 0 }));
+		expect(std::ranges::adjacent_find(connectionIds) == connectionIds.end());
+	};
+
+	test("Database transaction runs every query on the same connection") = [&batchDb] {
+		expect(DBTransaction::executeWithinTransaction([&batchDb] {
+			// A session variable is only seen by the connection that set it
+			expect(batchDb.executeQuery("SET @canary_pool_test = 42"));
+			const auto result = batchDb.storeQuery("SELECT @canary_pool_test AS `value`");
+			expect(result != nullptr);
+			expect(eq(result ? result->getNumber<int32_t>("value") : 0, 42));
+			return true;
+		}));
+	};
+
+	test("DBBatch writes the rows of its owners on flush") = batchTest(batchDb, [&batchDb] {
+		DBBatch batch;
+		expect(replaceRows(1, { 1, 2 }));
+		expect(replaceRows(2, { 3 }));
+		// Nothing is written before the flush
+		expect(eq(ownerRows(batchDb, 1), std::string {}));
+		expect(eq(batch.getOwnerCount(), 2));
+
+		expect(batch.flush());
+		expect(eq(ownerRows(batchDb, 1), std::string { "1,2" }));
+		expect(eq(ownerRows(batchDb, 2), std::string { "3" }));
+		expect(eq(batch.getOwnerCount(), 0));
+	});
+
+	test("DBBatch::claim keeps the batch from writing over a direct save") = batchTest(batchDb, [&batchDb] {
+		DBBatch batch;
+		expect(replaceRows(1, { 1, 2 }));
+		expect(replaceRows(2, { 3 }));
+
+		// A logout save on another thread, the batch rows of its owner are older than its own
+		std::thread([] {
+			DBBatch::claim(1);
+			expect(DBTransaction::executeWithinTransaction([] {
+				return replaceRows(1, { 4 });
+			}));
+		}).join();
+		expect(eq(batch.getOwnerCount(), 1));
+
+		// Rows added after the claim are dropped as well
+		expect(replaceRows(1, { 5 }));
+		expect(batch.flush());
+		expect(eq(ownerRows(batchDb, 1), std::string { "4" }));
+		expect(eq(ownerRows(batchDb, 2), std::string { "3" }));
+	});
+
+	test("DBBatch flush and a direct save that locked the parent row both finish") = batchTest(batchDb, [&batchDb] {
+		// The flush needs the parent row for the foreign key, the direct save holds it, so the save never waits inside its transaction
+		for (int i = 0; i < 20; ++i) {
+			DBBatch batch;
+			expect(replaceRows(1, { 1, 2 }));
+
+			auto save = std::async(std::launch::async, [] {
+				DBBatch::claim(1);
+				return DBTransaction::executeWithinTransaction([] {
+					return Database::getInstance().executeQuery("UPDATE `dbbatch_parents` SET `value` = `value` + 1 WHERE `id` = 1") && replaceRows(1, { 3 });
+				});
+			});
+			expect(batch.flush());
+			expect(eq(save.wait_for(std::chrono::seconds(10)) == std::future_status::ready, true) >> fatal);
+			expect(save.get());
+			expect(eq(ownerRows(batchDb, 1), std::string { "3" }));
+		}
+	});
 }
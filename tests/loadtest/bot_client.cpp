@@ -0,0 +1,437 @@
+/**
+ * Canary - A free and open-source MMORPG server emulator
+ * Copyright (©) 2019-2024 OpenTibiaBR <opentibiabr@outlook.com>
+ * Repository: https://github.com/opentibiabr/canary
+ * License: https://github.com/opentibiabr/canary/blob/main/LICENSE
+ * Contributors: https://github.com/opentibiabr/canary/graphs/contributors
+ * Website: https://docs.opentibiabr.com/
+ */
+
+#include "pch.hpp"
+
+#include "bot_client.hpp"
+
+#include "load_stats.hpp"
+#include "scenario.hpp"
+
+#include "core.hpp"
+#include "creatures/creatures_definitions.hpp"
+#include "security/rsa.hpp"
+#include "server/network/protocol/protocol.hpp"
+#include "utils/tools.hpp"
+#include "utils/utils_definitions.hpp"
+
+namespace {
+	constexpr uint32_t COMPRESSED_FLAG = 1U << 31;
+
+	// Indexed by Direction
+	constexpr std::array<uint8_t, 8> WALK_OPCODES = { 0x65, 0x66, 0x67, 0x68, 0x6C, 0x6B, 0x6D, 0x6A };
+
+	std::mt19937 &getGenerator() {
+		static thread_local std::mt19937 generator(std::random_device {}());
+		return generator;
+	}
+
+	// Raw inflate of the packets the server deflates (see Protocol::ZStream), one per network thread
+	class Inflater {
+	public:
+		Inflater() {
+			if (inflateInit2(&stream, -15) != Z_OK) {
+				g_logger().error("[Inflater] - Zlib inflateInit2 error: {}", stream.msg ? stream.msg : "unknown error");
+			}
+		}
+
+		~Inflater() {
+			inflateEnd(&stream);
+		}
+
+		// Returns the size inflated into buffer, 0 on failure
+		size_t inflate(const uint8_t* input, size_t size) {
+			stream.next_in = const_cast<Bytef*>(input);
+			stream.avail_in = static_cast<uInt>(size);
+			stream.next_out = buffer.data();
+			stream.avail_out = static_cast<uInt>(buffer.size());
+
+			const int32_t ret = ::inflate(&stream, Z_FINISH);
+			const auto totalSize = ret == Z_STREAM_END ? stream.total_out : 0;
+			inflateReset(&stream);
+			return totalSize;
+		}
+
+		std::array<uint8_t, NETWORKMESSAGE_MAXSIZE> buffer {};
+
+	private:
+		z_stream stream {};
+	};
+
+	template <typename T>
+	void writeValue(std::vector<uint8_t> &packet, size_t position, T value) {
+		memcpy(packet.data() + position, &value, sizeof(T));
+	}
+}
+
+BotClient::BotClient(asio::io_context &ioContext, const Scenario &scenario, LoadStats &stats, BotAccount account) :
+	socket(ioContext), timer(ioContext), scenario(scenario), stats(stats), account(std::move(account)) { }
+
+void BotClient::start(const asio::ip::tcp::endpoint &endpoint) {
+	++stats.connecting;
+	socket.async_connect(endpoint, [self = shared_from_this()](const std::error_code &error) {
+		if (error) {
+			self->close(false);
+			return;
+		}
+
+		std::error_code ignored;
+		self->socket.set_option(asio::ip::tcp::no_delay(true), ignored);
+		self->state = State::Challenge;
+		self->readHeader();
+	});
+}
+
+void BotClient::stop() {
+	asio::post(socket.get_executor(), [self = shared_from_this()] {
+		if (self->state == State::Closed) {
+			return;
+		}
+
+		self->stopping = true;
+		if (self->state != State::Online) {
+			self->close(true);
+			return;
+		}
+
+		// Closed by writeNext once the logout is written
+		NetworkMessage msg;
+		msg.addByte(0x14);
+		self->send(msg);
+	});
+}
+
+void BotClient::readHeader() {
+	asio::async_read(socket, asio::buffer(header), [self = shared_from_this()](const std::error_code &error, std::size_t) {
+		if (error) {
+			self->close(self->stopping);
+			return;
+		}
+
+		const auto size = static_cast<size_t>(self->header[0] | self->header[1] << 8);
+		if (size == 0) {
+			self->close(false);
+			return;
+		}
+
+		self->body.resize(size);
+		asio::async_read(self->socket, asio::buffer(self->body), [self, size](const std::error_code &error, std::size_t) {
+			if (error) {
+				self->close(self->stopping);
+				return;
+			}
+			self->onPacket(size);
+		});
+	});
+}
+
+void BotClient::onPacket(size_t size) {
+	stats.bytesReceived += size + header.size();
+	++stats.packetsReceived;
+
+	bool valid = true;
+	if (state == State::Challenge) {
+		valid = onChallenge(body.data(), size);
+	} else if (state == State::Login || state == State::Online) {
+		valid = onGamePacket(body.data(), size);
+	}
+
+	if (!valid) {
+		g_logger().warn("[BotClient::onPacket] - {} received an invalid packet of {} bytes", account.character, size);
+		close(false);
+		return;
+	}
+
+	if (state != State::Closed) {
+		readHeader();
+	}
+}
+
+bool BotClient::onChallenge(const uint8_t* data, size_t size) {
+	// Checksum, length, 0x1F, timestamp and random number (see ProtocolGame::onConnect)
+	if (size < 12 || data[6] != 0x1F) {
+		return false;
+	}
+
+	uint32_t challengeTimestamp;
+	memcpy(&challengeTimestamp, data + 7, sizeof(challengeTimestamp));
+	sendLogin(challengeTimestamp, data[11]);
+	return true;
+}
+
+bool BotClient::onGamePacket(uint8_t* data, size_t size) {
+	// Sequence number, then the XTEA blocks
+	if (size < 12 || (size - 4) % 8 != 0) {
+		return false;
+	}
+
+	uint32_t checksum;
+	memcpy(&checksum, data, sizeof(checksum));
+	Protocol::xteaDecrypt(data + 4, size - 4, key);
+
+	const auto length = static_cast<size_t>(data[4] | data[5] << 8);
+	if (length > size - 6) {
+		return false;
+	}
+
+	if ((checksum & COMPRESSED_FLAG) == 0) {
+		onPayload(data + 6, length);
+		return true;
+	}
+
+	static thread_local Inflater inflater;
+	const auto inflatedSize = inflater.inflate(data + 6, length);
+	if (inflatedSize == 0) {
+		return false;
+	}
+
+	onPayload(inflater.buffer.data(), inflatedSize);
+	return true;
+}
+
+void BotClient::onPayload(const uint8_t* payload, size_t size) {
+	if (size == 0) {
+		return;
+	}
+
+	if (state == State::Login) {
+		// The refusal, anything else is the world of the player (see ProtocolGame::login)
+		if (payload[0] == 0x14 || payload[0] == 0x16) {
+			std::string message = "waiting list";
+			if (payload[0] == 0x14 && size >= 3) {
+				const auto messageLength = std::min<size_t>(static_cast<size_t>(payload[1] | payload[2] << 8), size - 3);
+				message.assign(reinterpret_cast<const char*>(payload + 3), messageLength);
+			}
+			g_logger().warn("[BotClient::onPayload] - {} could not log in: {}", account.character, message);
+			close(false);
+			return;
+		}
+
+		state = State::Online;
+		--stats.connecting;
+		++stats.online;
+		lastKeepAlive = std::chrono::steady_clock::now();
+		scheduleStep(std::chrono::milliseconds(0));
+		return;
+	}
+
+	// The pong is written last when the server handles the ping and flushed right after, so under
+	// heavy traffic an unrelated packet ending in 0x1E may be taken for it
+	if (pingSentAt && payload[size - 1] == 0x1E) {
+		stats.addPingSample(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - *pingSentAt));
+		pingSentAt.reset();
+	}
+}
+
+void BotClient::sendLogin(uint32_t challengeTimestamp, uint8_t challengeRandom) {
+	for (auto &part : key) {
+		part = getGenerator()();
+	}
+
+	// The RSA block, it has to decrypt to a leading zero
+	NetworkMessage block;
+	block.addByte(0x00);
+	for (const auto part : key) {
+		block.add<uint32_t>(part);
+	}
+	block.addByte(0x00); // Gamemaster flag
+	block.addString(fmt::format("{}\n{}", account.email, account.password));
+	block.addString(account.character);
+	block.add<uint32_t>(challengeTimestamp);
+	block.addByte(challengeRandom);
+
+	std::array<char, 128> rsaBlock {};
+	if (block.getLength() > rsaBlock.size()) {
+		g_logger().error("[BotClient::sendLogin] - The account and character of {} do not fit the RSA block", account.character);
+		close(false);
+		return;
+	}
+	memcpy(rsaBlock.data(), block.getBuffer() + NetworkMessage::INITIAL_BUFFER_POSITION, block.getLength());
+	g_RSA().encrypt(rsaBlock.data());
+
+	NetworkMessage msg;
+	msg.addByte(0x0A); // Protocol id of the game, skipped by the server
+	msg.add<uint16_t>(CLIENTOS_NEW_WINDOWS);
+	msg.add<uint16_t>(CLIENT_VERSION);
+	msg.add<uint32_t>(CLIENT_VERSION);
+	msg.addString(fmt::format("{}.{}", CLIENT_VERSION_UPPER, CLIENT_VERSION_LOWER));
+	msg.addString("canary_loadtest"); // Assets hash identifier
+	msg.addByte(0x00); // Game preview state
+	msg.addBytes(rsaBlock.data(), rsaBlock.size());
+
+	// Not encrypted, with the adler checksum
+	const auto length = msg.getLength();
+	const auto* payload = msg.getBuffer() + NetworkMessage::INITIAL_BUFFER_POSITION;
+	std::vector<uint8_t> packet(6 + length);
+	writeValue<uint16_t>(packet, 0, static_cast<uint16_t>(4 + length));
+	writeValue<uint32_t>(packet, 2, adlerChecksum(payload, length));
+	memcpy(packet.data() + 6, payload, length);
+
+	state = State::Login;
+	write(std::move(packet));
+}
+
+void BotClient::send(const NetworkMessage &msg) {
+	const auto length = msg.getLength();
+	const size_t encryptedLength = (length + 2 + 7) & ~static_cast<size_t>(7);
+
+	// The server counts the sequence the same way, see Protocol::onRecvMessage
+	const uint32_t checksum = ++sequence;
+	if (sequence >= 0x7FFFFFFF) {
+		sequence = 0;
+	}
+
+	std::vector<uint8_t> packet(6 + encryptedLength);
+	writeValue<uint16_t>(packet, 0, static_cast<uint16_t>(4 + encryptedLength));
+	writeValue<uint32_t>(packet, 2, checksum);
+	writeValue<uint16_t>(packet, 6, length);
+	memcpy(packet.data() + 8, msg.getBuffer() + NetworkMessage::INITIAL_BUFFER_POSITION, length);
+	Protocol::xteaEncrypt(packet.data() + 6, encryptedLength, key);
+
+	write(std::move(packet));
+}
+
+void BotClient::write(std::vector<uint8_t> &&packet) {
+	stats.bytesSent += packet.size();
+	++stats.packetsSent;
+
+	writeQueue.emplace_back(std::move(packet));
+	if (writeQueue.size() == 1) {
+		writeNext();
+	}
+}
+
+void BotClient::writeNext() {
+	asio::async_write(socket, asio::buffer(writeQueue.front()), [self = shared_from_this()](const std::error_code &error, std::size_t) {
+		if (error) {
+			self->close(self->stopping);
+			return;
+		}
+
+		self->writeQueue.pop_front();
+		if (!self->writeQueue.empty()) {
+			self->writeNext();
+		} else if (self->stopping) {
+			self->close(true);
+		}
+	});
+}
+
+void BotClient::scheduleStep(std::chrono::milliseconds delay) {
+	timer.expires_after(delay);
+	timer.async_wait([self = shared_from_this()](const std::error_code &error) {
+		if (!error) {
+			self->runSteps();
+		}
+	});
+}
+
+void BotClient::runSteps() {
+	if (state != State::Online || stopping) {
+		return;
+	}
+
+	const auto now = std::chrono::steady_clock::now();
+	if (now - lastKeepAlive >= KEEP_ALIVE_INTERVAL) {
+		NetworkMessage msg;
+		msg.addByte(0x1E);
+		send(msg);
+		lastKeepAlive = now;
+	}
+
+	if (pingSentAt && now - *pingSentAt >= PING_TIMEOUT) {
+		++stats.pingsLost;
+		pingSentAt.reset();
+	}
+
+	// Scenario::load made sure there is a wait to stop at
+	const auto &steps = scenario.getSteps();
+	while (true) {
+		const auto &step = steps[stepIndex];
+		stepIndex = (stepIndex + 1) % steps.size();
+		if (step.action != ScenarioAction::Wait) {
+			runStep(step);
+		} else if (step.value > 0) {
+			scheduleStep(std::chrono::milliseconds(step.value));
+			return;
+		}
+	}
+}
+
+void BotClient::runStep(const ScenarioStep &step) {
+	NetworkMessage msg;
+	switch (step.action) {
+		case ScenarioAction::Walk: {
+			const auto direction = step.direction.value_or(static_cast<Direction>(getGenerator()() % WALK_OPCODES.size()));
+			msg.addByte(WALK_OPCODES[direction]);
+			break;
+		}
+
+		case ScenarioAction::Attack:
+			msg.addByte(0xA1);
+			msg.add<uint32_t>(step.value);
+			msg.add<uint32_t>(step.value); // The client sends it twice, see ProtocolGame::parseAttack
+			break;
+
+		case ScenarioAction::Say:
+		case ScenarioAction::Cast:
+			msg.addByte(0x96);
+			msg.addByte(TALKTYPE_SAY);
+			msg.addString(step.text);
+			break;
+
+		case ScenarioAction::Open:
+			// Use of the container in an inventory slot
+			msg.addByte(0x82);
+			msg.addPosition(Position(0xFFFF, static_cast<uint16_t>(step.value), 0));
+			msg.add<uint16_t>(step.itemId);
+			msg.addByte(0x00); // Stack position
+			msg.addByte(0x00); // Container id
+			break;
+
+		case ScenarioAction::Ping:
+			// One at a time, the answers cannot be told apart
+			if (pingSentAt) {
+				return;
+			}
+			pingSentAt = std::chrono::steady_clock::now();
+			msg.addByte(0x1D);
+			break;
+
+		case ScenarioAction::Wait:
+			return;
+	}
+
+	send(msg);
+}
+
+void BotClient::close(bool requested) {
+	if (state == State::Closed) {
+		return;
+	}
+
+	if (state == State::Online) {
+		--stats.online;
+		if (!requested) {
+			++stats.disconnects;
+		}
+	} else {
+		--stats.connecting;
+		if (!requested) {
+			++stats.loginFailures;
+		}
+	}
+
+	state = State::Closed;
+	timer.cancel();
+
+	std::error_code ignored;
+	socket.shutdown(asio::ip::tcp::socket::shutdown_both, ignored);
+	socket.close(ignored);
+}
@@ -0,0 +1,90 @@
+/**
+ * Canary - A free and open-source MMORPG server emulator
+ * Copyright (©) 2019-2024 OpenTibiaBR <opentibiabr@outlook.com>
+ * Repository: https://github.com/opentibiabr/canary
+ * License: https://github.com/opentibiabr/canary/blob/main/LICENSE
+ * Contributors: https://github.com/opentibiabr/canary/graphs/contributors
+ * Website: https://docs.opentibiabr.com/
+ */
+
+#pragma once
+
+#include "server/network/message/networkmessage.hpp"
+
+class LoadStats;
+class Scenario;
+struct ScenarioStep;
+
+struct BotAccount {
+	std::string email;
+	std::string password;
+	std::string character;
+};
+
+/**
+ * A headless client of the game protocol, as the official client on Windows speaks it: the login
+ * with the RSA block, then XTEA packets with the sequence checksum, compressed by the server.
+ * It logs in with the password (authType = "password"), without the login server, and runs its
+ * scenario until stop. Everything runs on the io_context of the bot, a single thread, only stop
+ * may be called from another one.
+ */
+class BotClient final : public std::enable_shared_from_this<BotClient> {
+public:
+	static constexpr auto PING_TIMEOUT = std::chrono::seconds(10);
+	// As the client answers the pings of the server, which kicks after a minute without it
+	static constexpr auto KEEP_ALIVE_INTERVAL = std::chrono::seconds(5);
+
+	BotClient(asio::io_context &ioContext, const Scenario &scenario, LoadStats &stats, BotAccount account);
+
+	void start(const asio::ip::tcp::endpoint &endpoint);
+	// Logs out and closes the connection once the packets queued are written
+	void stop();
+
+private:
+	enum class State : uint8_t {
+		Connecting,
+		Challenge,
+		Login,
+		Online,
+		Closed,
+	};
+
+	void readHeader();
+	void onPacket(size_t size);
+	bool onChallenge(const uint8_t* data, size_t size);
+	bool onGamePacket(uint8_t* data, size_t size);
+	void onPayload(const uint8_t* payload, size_t size);
+
+	void sendLogin(uint32_t challengeTimestamp, uint8_t challengeRandom);
+	// Wraps a packet of the game: length, XTEA, sequence number
+	void send(const NetworkMessage &msg);
+	void write(std::vector<uint8_t> &&packet);
+	void writeNext();
+
+	void scheduleStep(std::chrono::milliseconds delay);
+	// Runs the steps up to the next wait
+	void runSteps();
+	void runStep(const ScenarioStep &step);
+
+	void close(bool requested);
+
+	asio::ip::tcp::socket socket;
+	asio::steady_timer timer;
+	const Scenario &scenario;
+	LoadStats &stats;
+	const BotAccount account;
+
+	std::array<uint8_t, 2> header {};
+	std::vector<uint8_t> body;
+	std::deque<std::vector<uint8_t>> writeQueue;
+
+	std::array<uint32_t, 4> key {};
+	uint32_t sequence = 0;
+
+	size_t stepIndex = 0;
+	std::optional<std::chrono::steady_clock::time_point> pingSentAt;
+	std::chrono::steady_clock::time_point lastKeepAlive;
+
+	State state = State::Connecting;
+	bool stopping = false;
+};
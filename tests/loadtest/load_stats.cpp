@@ -0,0 +1,78 @@
+/**
+ * Canary - A free and open-source MMORPG server emulator
+ * Copyright (©) 2019-2024 OpenTibiaBR <opentibiabr@outlook.com>
+ * Repository: https://github.com/opentibiabr/canary
+ * License: https://github.com/opentibiabr/canary/blob/main/LICENSE
+ * Contributors: https://github.com/opentibiabr/canary/graphs/contributors
+ * Website: https://docs.opentibiabr.com/
+ */
+
+#include "pch.hpp"
+
+#include "load_stats.hpp"
+
+namespace {
+	// Milliseconds, with the microseconds of the samples
+	double percentile(std::vector<uint32_t> &samples, double fraction) {
+		if (samples.empty()) {
+			return 0;
+		}
+
+		const auto index = std::min(samples.size() - 1, static_cast<size_t>(fraction * static_cast<double>(samples.size())));
+		std::nth_element(samples.begin(), samples.begin() + static_cast<std::ptrdiff_t>(index), samples.end());
+		return samples[index] / 1000.0;
+	}
+
+	double kilobytes(uint64_t bytes) {
+		return static_cast<double>(bytes) / 1024.0;
+	}
+}
+
+void LoadStats::addPingSample(std::chrono::microseconds roundTrip) {
+	std::scoped_lock lock(samplesMutex);
+	pendingSamples.emplace_back(static_cast<uint32_t>(std::min<int64_t>(roundTrip.count(), std::numeric_limits<uint32_t>::max())));
+}
+
+void LoadStats::report(uint32_t second, uint32_t started) {
+	std::vector<uint32_t> samples;
+	{
+		std::scoped_lock lock(samplesMutex);
+		samples.swap(pendingSamples);
+		allSamples.insert(allSamples.end(), samples.begin(), samples.end());
+	}
+
+	const uint64_t received = bytesReceived;
+	const uint64_t sent = bytesSent;
+	const uint64_t receivedPackets = packetsReceived;
+	const uint64_t sentPackets = packetsSent;
+
+	g_logger().info(
+		"[{:>4}s] bots {} online {} connecting {} failed {} lost {} | in {:.1f} KB/s ({} packets) out {:.1f} KB/s ({} packets) | ping p50 {:.1f} ms p99 {:.1f} ms max {:.1f} ms ({} samples, {} lost)",
+		second, started, online.load(), connecting.load(), loginFailures.load(), disconnects.load(),
+		kilobytes(received - lastBytesReceived), receivedPackets - lastPacketsReceived,
+		kilobytes(sent - lastBytesSent), sentPackets - lastPacketsSent,
+		percentile(samples, 0.5), percentile(samples, 0.99), percentile(samples, 1.0), samples.size(), pingsLost.load()
+	);
+
+	lastBytesReceived = received;
+	lastBytesSent = sent;
+	lastPacketsReceived = receivedPackets;
+	lastPacketsSent = sentPackets;
+}
+
+void LoadStats::summary(uint32_t seconds) {
+	std::vector<uint32_t> samples;
+	{
+		std::scoped_lock lock(samplesMutex);
+		samples = allSamples;
+	}
+
+	const auto perSecond = [seconds](uint64_t value) {
+		return static_cast<double>(value) / std::max<uint32_t>(seconds, 1);
+	};
+
+	g_logger().info("Summary of {} seconds:", seconds);
+	g_logger().info("  logins failed {}, disconnected by the server {}", loginFailures.load(), disconnects.load());
+	g_logger().info("  received {:.1f} KB/s ({:.0f} packets/s), sent {:.1f} KB/s ({:.0f} packets/s)", kilobytes(static_cast<uint64_t>(perSecond(bytesReceived))), perSecond(packetsReceived), kilobytes(static_cast<uint64_t>(perSecond(bytesSent))), perSecond(packetsSent));
+	g_logger().info("  ping p50 {:.1f} ms, p90 {:.1f} ms, p99 {:.1f} ms, max {:.1f} ms ({} samples, {} lost)", percentile(samples, 0.5), percentile(samples, 0.9), percentile(samples, 0.99), percentile(samples, 1.0), samples.size(), pingsLost.load());
+}
@@ -0,0 +1,51 @@
+/**
+ * Canary - A free and open-source MMORPG server emulator
+ * Copyright (©) 2019-2024 OpenTibiaBR <opentibiabr@outlook.com>
+ * Repository: https://github.com/opentibiabr/canary
+ * License: https://github.com/opentibiabr/canary/blob/main/LICENSE
+ * Contributors: https://github.com/opentibiabr/canary/graphs/contributors
+ * Website: https://docs.opentibiabr.com/
+ */
+
+#pragma once
+
+/**
+ * Shared by the bots of every network thread. The counters are atomics, the ping samples are
+ * collected under a mutex, report and summary run on the main thread.
+ */
+class LoadStats {
+public:
+	// Bots between the connect and the login answer
+	std::atomic<uint32_t> connecting = 0;
+	std::atomic<uint32_t> online = 0;
+	// Could not connect, or the server refused the login
+	std::atomic<uint32_t> loginFailures = 0;
+	// Closed by the server (or the network) after the login
+	std::atomic<uint32_t> disconnects = 0;
+
+	// On the wire, headers included
+	std::atomic<uint64_t> bytesReceived = 0;
+	std::atomic<uint64_t> bytesSent = 0;
+	std::atomic<uint64_t> packetsReceived = 0;
+	std::atomic<uint64_t> packetsSent = 0;
+
+	// Without an answer in BotClient::PING_TIMEOUT
+	std::atomic<uint32_t> pingsLost = 0;
+
+	void addPingSample(std::chrono::microseconds roundTrip);
+
+	// The activity since the previous report, once a second
+	void report(uint32_t second, uint32_t started);
+	// The whole run
+	void summary(uint32_t seconds);
+
+private:
+	std::mutex samplesMutex;
+	std::vector<uint32_t> pendingSamples;
+	std::vector<uint32_t> allSamples;
+
+	uint64_t lastBytesReceived = 0;
+	uint64_t lastBytesSent = 0;
+	uint64_t lastPacketsReceived = 0;
+	uint64_t lastPacketsSent = 0;
+};
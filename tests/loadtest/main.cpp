@@ -0,0 +1,190 @@
+/**
+ * Canary - A free and open-source MMORPG server emulator
+ * Copyright (©) 2019-2024 OpenTibiaBR <opentibiabr@outlook.com>
+ * Repository: https://github.com/opentibiabr/canary
+ * License: https://github.com/opentibiabr/canary/blob/main/LICENSE
+ * Contributors: https://github.com/opentibiabr/canary/graphs/contributors
+ * Website: https://docs.opentibiabr.com/
+ */
+
+#include "pch.hpp"
+
+#include "bot_client.hpp"
+#include "load_stats.hpp"
+#include "scenario.hpp"
+
+#include "security/rsa.hpp"
+#include "utils/tools.hpp"
+
+namespace {
+	struct LoadTestSettings {
+		std::string host = "127.0.0.1";
+		uint16_t port = 7172;
+		uint32_t clients = 100;
+		// Logins started per second
+		uint32_t rate = 20;
+		// Seconds after the last login is started
+		uint32_t duration = 60;
+		uint32_t threads = std::max(1U, std::thread::hardware_concurrency());
+		std::string scenario = "tests/loadtest/scenarios/walk_and_talk.txt";
+		// The {} is replaced by the number of the bot, from first
+		uint32_t first = 1;
+		std::string email = "bot{}@canary.test";
+		std::string password = "canary";
+		std::string character = "Bot {}";
+		bool printSql = false;
+	};
+
+	constexpr std::string_view USAGE = R"(Usage: canary_loadtest [options]
+  --host <address>        game server address (127.0.0.1)
+  --port <port>           game port (7172)
+  --clients <count>       bots to log in (100)
+  --rate <count>          logins started per second (20)
+  --duration <seconds>    run time after the last login is started (60)
+  --threads <count>       network threads (the cores)
+  --scenario <file>       steps of the bots (tests/loadtest/scenarios/walk_and_talk.txt)
+  --first <number>        number of the first bot (1)
+  --email <template>      email of the accounts, {} is the number of the bot (bot{}@canary.test)
+  --password <password>   password of the accounts (canary)
+  --character <template>  name of the characters, {} is the number of the bot (Bot {})
+  --print-sql             print the accounts and characters of the bots as SQL and exit
+)";
+
+	bool parseSettings(int argc, char** argv, LoadTestSettings &settings) {
+		const std::unordered_map<std::string_view, std::function<void(const std::string &)>> options = {
+			{ "--host", [&settings](const std::string &value) { settings.host = value; } },
+			{ "--port", [&settings](const std::string &value) { settings.port = static_cast<uint16_t>(std::stoul(value)); } },
+			{ "--clients", [&settings](const std::string &value) { settings.clients = static_cast<uint32_t>(std::stoul(value)); } },
+			{ "--rate", [&settings](const std::string &value) { settings.rate = std::max(1U, static_cast<uint32_t>(std::stoul(value))); } },
+			{ "--duration", [&settings](const std::string &value) { settings.duration = static_cast<uint32_t>(std::stoul(value)); } },
+			{ "--threads", [&settings](const std::string &value) { settings.threads = std::max(1U, static_cast<uint32_t>(std::stoul(value))); } },
+			{ "--scenario", [&settings](const std::string &value) { settings.scenario = value; } },
+			{ "--first", [&settings](const std::string &value) { settings.first = static_cast<uint32_t>(std::stoul(value)); } },
+			{ "--email", [&settings](const std::string &value) { settings.email = value; } },
+			{ "--password", [&settings](const std::string &value) { settings.password = value; } },
+			{ "--character", [&settings](const std::string &value) { settings.character = value; } },
+		};
+
+		for (int i = 1; i < argc; ++i) {
+			const std::string_view name = argv[i];
+			if (name == "--print-sql") {
+				settings.printSql = true;
+				continue;
+			}
+
+			const auto it = options.find(name);
+			if (it == options.end() || i + 1 >= argc) {
+				return false;
+			}
+
+			try {
+				it->second(argv[++i]);
+			} catch (const std::logic_error &) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	std::string formatBotName(const std::string &nameTemplate, uint32_t number) {
+		std::string name = nameTemplate;
+		if (const auto pos = name.find("{}"); pos != std::string::npos) {
+			name.replace(pos, 2, std::to_string(number));
+		}
+		return name;
+	}
+
+	// For schema.sql, the characters start at the temple of their town
+	void printSql(const LoadTestSettings &settings) {
+		const auto password = transformToSHA1(settings.password);
+		for (uint32_t number = settings.first; number < settings.first + settings.clients; ++number) {
+			const auto email = formatBotName(settings.email, number);
+			fmt::print("INSERT INTO `accounts` (`name`, `email`, `password`, `type`) VALUES ('{}', '{}', '{}', 1);\n", email, email, password);
+			fmt::print("INSERT INTO `players` (`name`, `account_id`, `conditions`) SELECT '{}', `id`, '' FROM `accounts` WHERE `email` = '{}';\n", formatBotName(settings.character, number), email);
+		}
+	}
+}
+
+int main(int argc, char** argv) {
+	LoadTestSettings settings;
+	if (!parseSettings(argc, argv, settings)) {
+		fmt::print("{}", USAGE);
+		return 1;
+	}
+
+	if (settings.printSql) {
+		printSql(settings);
+		return 0;
+	}
+
+	const auto scenario = Scenario::load(settings.scenario);
+	if (!scenario) {
+		return 1;
+	}
+
+	// key.pem of the working directory, run from the folder of the server to use its key
+	g_RSA().start();
+
+	asio::ip::tcp::endpoint endpoint;
+	try {
+		endpoint = asio::ip::tcp::endpoint(asio::ip::make_address(settings.host), settings.port);
+	} catch (const std::system_error &e) {
+		g_logger().error("Invalid host {}: {}", settings.host, e.what());
+		return 1;
+	}
+
+	// One io_context per thread, a bot stays on the one it was created on
+	std::vector<std::unique_ptr<asio::io_context>> ioContexts;
+	std::vector<asio::executor_work_guard<asio::io_context::executor_type>> workGuards;
+	std::vector<std::thread> threads;
+	for (uint32_t i = 0; i < settings.threads; ++i) {
+		const auto &ioContext = ioContexts.emplace_back(std::make_unique<asio::io_context>(1));
+		workGuards.emplace_back(ioContext->get_executor());
+		threads.emplace_back([&ioContext = *ioContext] { ioContext.run(); });
+	}
+
+	LoadStats stats;
+	std::vector<std::shared_ptr<BotClient>> bots;
+	bots.reserve(settings.clients);
+
+	g_logger().info("Logging in {} bots on {}:{}, {} per second, then running {} seconds", settings.clients, settings.host, settings.port, settings.rate, settings.duration);
+
+	const auto start = std::chrono::steady_clock::now();
+	uint32_t second = 0;
+	uint32_t secondsAfterLogins = 0;
+	while (secondsAfterLogins < settings.duration) {
+		const auto batchEnd = std::min(settings.clients, static_cast<uint32_t>(bots.size()) + settings.rate);
+		if (bots.size() == settings.clients) {
+			++secondsAfterLogins;
+		}
+
+		while (bots.size() < batchEnd) {
+			const auto number = settings.first + static_cast<uint32_t>(bots.size());
+			auto &ioContext = *ioContexts[bots.size() % ioContexts.size()];
+			BotAccount account { formatBotName(settings.email, number), settings.password, formatBotName(settings.character, number) };
+			const auto &bot = bots.emplace_back(std::make_shared<BotClient>(ioContext, *scenario, stats, std::move(account)));
+			bot->start(endpoint);
+		}
+
+		++second;
+		std::this_thread::sleep_until(start + std::chrono::seconds(second));
+		stats.report(second, static_cast<uint32_t>(bots.size()));
+	}
+
+	for (const auto &bot : bots) {
+		bot->stop();
+	}
+
+	// Time for the logouts to be written
+	std::this_thread::sleep_for(std::chrono::seconds(1));
+	workGuards.clear();
+	for (const auto &ioContext : ioContexts) {
+		ioContext->stop();
+	}
+	for (auto &thread : threads) {
+		thread.join();
+	}
+
+	stats.summary(second);
+	return 0;
+}
@@ -0,0 +1,99 @@
+/**
+ * Canary - A free and open-source MMORPG server emulator
+ * Copyright (©) 2019-2024 OpenTibiaBR <opentibiabr@outlook.com>
+ * Repository: https://github.com/opentibiabr/canary
+ * License: https://github.com/opentibiabr/canary/blob/main/LICENSE
+ * Contributors: https://github.com/opentibiabr/canary/graphs/contributors
+ * Website: https://docs.opentibiabr.com/
+ */
+
+#include "pch.hpp"
+
+#include "scenario.hpp"
+
+#include "utils/tools.hpp"
+
+std::optional<Scenario> Scenario::load(const std::string &filename) {
+	std::ifstream file { filename };
+	if (!file.is_open()) {
+		g_logger().error("[{}] - Could not open {}", __FUNCTION__, filename);
+		return std::nullopt;
+	}
+
+	Scenario scenario;
+	bool waits = false;
+	std::string line;
+	for (uint32_t lineNumber = 1; std::getline(file, line); ++lineNumber) {
+		trim_right(line, '\r');
+		trimString(line);
+		if (line.empty() || line.front() == '#') {
+			continue;
+		}
+
+		const auto step = parseStep(line);
+		if (!step) {
+			g_logger().error("[{}] - Invalid step in {}:{}: {}", __FUNCTION__, filename, lineNumber, line);
+			return std::nullopt;
+		}
+
+		waits = waits || (step->action == ScenarioAction::Wait && step->value > 0);
+		scenario.steps.emplace_back(*step);
+	}
+
+	if (!waits) {
+		g_logger().error("[{}] - {} never waits, the bots would flood the server", __FUNCTION__, filename);
+		return std::nullopt;
+	}
+
+	return scenario;
+}
+
+std::optional<ScenarioStep> Scenario::parseStep(const std::string &line) {
+	const auto separator = line.find(' ');
+	const auto command = asLowerCaseString(line.substr(0, separator));
+	std::string argument = separator == std::string::npos ? "" : line.substr(separator + 1);
+	trimString(argument);
+
+	ScenarioStep step;
+	try {
+		if (command == "walk") {
+			step.action = ScenarioAction::Walk;
+			if (argument != "random") {
+				static const std::unordered_set<std::string> directions = { "north", "east", "south", "west", "northeast", "southeast", "southwest", "northwest" };
+				if (!directions.contains(argument)) {
+					return std::nullopt;
+				}
+				step.direction = getDirection(argument);
+			}
+		} else if (command == "attack") {
+			step.action = ScenarioAction::Attack;
+			step.value = argument == "stop" ? 0 : static_cast<uint32_t>(std::stoul(argument));
+		} else if (command == "say" || command == "cast") {
+			if (argument.empty() || argument.size() > 255) {
+				return std::nullopt;
+			}
+			step.action = command == "say" ? ScenarioAction::Say : ScenarioAction::Cast;
+			step.text = argument;
+		} else if (command == "open") {
+			const auto values = explodeString(argument, " ");
+			if (values.size() != 2) {
+				return std::nullopt;
+			}
+			step.action = ScenarioAction::Open;
+			step.value = static_cast<uint32_t>(std::stoul(values[0]));
+			step.itemId = static_cast<uint16_t>(std::stoul(values[1]));
+		} else if (command == "wait") {
+			step.action = ScenarioAction::Wait;
+			step.value = static_cast<uint32_t>(std::stoul(argument));
+		} else if (command == "ping") {
+			step.action = ScenarioAction::Ping;
+		} else {
+			return std::nullopt;
+		}
+	} catch (const std::logic_error &) {
+		// std::stoul of something that is not a number
+		return std::nullopt;
+	}
+
+	return step;
+}
@@ -0,0 +1,60 @@
+/**
+ * Canary - A free and open-source MMORPG server emulator
+ * Copyright (©) 2019-2024 OpenTibiaBR <opentibiabr@outlook.com>
+ * Repository: https://github.com/opentibiabr/canary
+ * License: https://github.com/opentibiabr/canary/blob/main/LICENSE
+ * Contributors: https://github.com/opentibiabr/canary/graphs/contributors
+ * Website: https://docs.opentibiabr.com/
+ */
+
+#pragma once
+
+#include "game/movement/position.hpp"
+
+enum class ScenarioAction : uint8_t {
+	Walk,
+	Attack,
+	Say,
+	Cast,
+	Open,
+	Wait,
+	Ping,
+};
+
+struct ScenarioStep {
+	ScenarioAction action = ScenarioAction::Wait;
+	// Walk, random when unset
+	std::optional<Direction> direction;
+	// Attack: the creature id (0 stops), Open: the inventory slot, Wait: the milliseconds
+	uint32_t value = 0;
+	// Open: the item id
+	uint16_t itemId = 0;
+	// Say, Cast
+	std::string text;
+};
+
+/**
+ * The steps a bot repeats from login to the end of the run, one per line:
+ *   walk <north|east|south|west|northeast|southeast|southwest|northwest|random>
+ *   attack <creature id|stop>
+ *   say <text>
+ *   cast <words>
+ *   open <inventory slot> <item id>
+ *   wait <milliseconds>
+ *   ping
+ * Empty lines and lines starting with # are skipped. The steps run back to back until a wait,
+ * so a scenario must wait somewhere to stay under maxPacketsPerSecond.
+ */
+class Scenario {
+public:
+	static std::optional<Scenario> load(const std::string &filename);
+
+	const std::vector<ScenarioStep> &getSteps() const {
+		return steps;
+	}
+
+private:
+	static std::optional<ScenarioStep> parseStep(const std::string &line);
+
+	std::vector<ScenarioStep> steps;
+};
@@ -0,0 +1,130 @@
+#include "pch.hpp"
+
+#include <boost/ut.hpp>
+
+#include "game/scheduling/timing_wheel.hpp"
+
+using namespace boost::ut;
+
+namespace {
+	std::shared_ptr<Task> makeTask(uint32_t delay) {
+		return Task::create([] { }, "TimingWheelTest", delay);
+	}
+
+	// Expires up to now and returns the tasks in the order they came out
+	std::vector<std::shared_ptr<Task>> expire(TimingWheel &wheel, int64_t now) {
+		std::vector<std::shared_ptr<Task>> expired;
+		wheel.expire(now, [&expired](const std::shared_ptr<Task> &task) { expired.emplace_back(task); });
+		return expired;
+	}
+
+	bool inTimeOrder(const std::vector<std::shared_ptr<Task>> &tasks) {
+		return std::ranges::is_sorted(tasks, {}, [](const auto &task) { return task->getTime(); });
+	}
+}
+
+suite<"scheduling"> timingWheelTest = [] {
+	test("TimingWheel expires a task at its time and not before") = [] {
+		TimingWheel wheel(OTSYS_TIME());
+		const auto task = makeTask(50);
+		wheel.insert(task);
+		expect(eq(wheel.size(), 1));
+
+		expect(expire(wheel, task->getTime() - 1).empty());
+		const auto expired = expire(wheel, task->getTime());
+		expect(eq(expired.size(), 1));
+		expect(expired.front() == task);
+		expect(wheel.empty());
+	};
+
+	test("TimingWheel expires the tasks of every level in time order") = [] {
+		TimingWheel wheel(OTSYS_TIME());
+		std::vector<std::shared_ptr<Task>> tasks;
+		// The first level, the boundary of the second one, the second, third and fourth levels
+		for (const uint32_t delay : { 70000u, 5u, 256u, 300u, 1u, 255u, 20000000u, 5u }) {
+			tasks.emplace_back(makeTask(delay));
+			wheel.insert(tasks.back());
+		}
+
+		std::vector<std::shared_ptr<Task>> expired;
+		const auto last = std::ranges::max(tasks, {}, [](const auto &task) { return task->getTime(); })->getTime();
+		// Step by step, so every cascade is walked
+		for (auto now = OTSYS_TIME() - 1; now <= last; now += 37) {
+			for (const auto &task : expire(wheel, now)) {
+				expect(le(task->getTime(), now));
+				expired.emplace_back(task);
+			}
+		}
+		for (const auto &task : expire(wheel, last)) {
+			expired.emplace_back(task);
+		}
+
+		expect(eq(expired.size(), tasks.size()));
+		expect(inTimeOrder(expired));
+		expect(wheel.empty());
+	};
+
+	test("TimingWheel reports when the next task is due") = [] {
+		TimingWheel wheel(OTSYS_TIME());
+		expect(eq(wheel.nextExpiration(), std::numeric_limits<int64_t>::max()));
+
+		const auto later = makeTask(1000);
+		const auto sooner = makeTask(10);
+		wheel.insert(later);
+		wheel.insert(sooner);
+		// Never after the earliest task, it may be a cascade before it
+		expect(le(wheel.nextExpiration(), sooner->getTime()));
+
+		expire(wheel, sooner->getTime());
+		expect(le(wheel.nextExpiration(), later->getTime()));
+		expect(gt(wheel.nextExpiration(), sooner->getTime()));
+	};
+
+	test("TimingWheel expires the tasks inserted for a time already processed") = [] {
+		const auto start = OTSYS_TIME();
+		TimingWheel wheel(start);
+		expire(wheel, start + 100000);
+
+		const auto task = makeTask(0);
+		// Due before the next tick of the wheel
+		expect(lt(task->getTime(), start + 100001));
+		wheel.insert(task);
+		expect(le(wheel.nextExpiration(), start + 100000));
+
+		const auto expired = expire(wheel, start + 100000);
+		expect(eq(expired.size(), 1));
+		expect(wheel.empty());
+	};
+
+	test("TimingWheel expires everything due after a long stall") = [] {
+		const auto start = OTSYS_TIME();
+		TimingWheel wheel(start);
+		std::vector<std::shared_ptr<Task>> tasks;
+		for (const uint32_t delay : { 90000u, 10u, 70000u, 500u, 5000000u }) {
+			tasks.emplace_back(makeTask(delay));
+			wheel.insert(tasks.back());
+		}
+
+		// Further than a full walk of the first two levels
+		const auto expired = expire(wheel, start + 1000000);
+		expect(eq(expired.size(), 4));
+		expect(inTimeOrder(expired));
+		expect(eq(wheel.size(), 1));
+
+		const auto last = expire(wheel, tasks.back()->getTime());
+		expect(eq(last.size(), 1));
+		expect(last.front() == tasks.back());
+	};
+
+	test("TimingWheel hands out canceled tasks when their slot expires") = [] {
+		TimingWheel wheel(OTSYS_TIME());
+		const auto task = makeTask(20);
+		wheel.insert(task);
+		task->cancel();
+		expect(eq(wheel.size(), 1));
+
+		const auto expired = expire(wheel, task->getTime());
+		expect(eq(expired.size(), 1));
+		expect(expired.front()->isCanceled());
+	};
+};
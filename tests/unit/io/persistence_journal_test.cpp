@@ -0,0 +1,133 @@
+/**
+ * Canary - A free and open-source MMORPG server emulator
+ * Copyright (©) 2019-2024 OpenTibiaBR <opentibiabr@outlook.com>
+ * Repository: https://github.com/opentibiabr/canary
+ * License: https://github.com/opentibiabr/canary/blob/main/LICENSE
+ * Contributors: https://github.com/opentibiabr/canary/graphs/contributors
+ * Website: https://docs.opentibiabr.com/
+ */
+#include "pch.hpp"
+
+#include <boost/ut.hpp>
+
+#include "io/persistence_journal.hpp"
+#include "database/database.hpp"
+
+using namespace boost::ut;
+
+namespace {
+	// A file of its own for each test, removed when it ends
+	struct TempJournal {
+		std::string path;
+
+		explicit TempJournal(std::string_view name) :
+			path((std::filesystem::temp_directory_path() / fmt::format("canary_{}.journal", name)).string()) {
+			std::filesystem::remove(path);
+		}
+		~TempJournal() {
+			std::filesystem::remove(path);
+			std::filesystem::remove(path + ".tmp");
+		}
+	};
+
+	std::vector<std::string> queries(size_t count) {
+		std::vector<std::string> result;
+		for (size_t i = 0; i < count; ++i) {
+			result.emplace_back(fmt::format("UPDATE `players` SET `balance` = {} WHERE `id` = 1", i));
+		}
+		return result;
+	}
+
+	// Opens the journal with the replayed queries captured instead of sent to the database
+	size_t openCapturingReplay(PersistenceJournal &journal, const std::string &path) {
+		DBCapture capture;
+		DBCapture::Scope scope(capture);
+		expect(journal.open(path));
+		return capture.size();
+	}
+}
+
+suite<"io"> persistenceJournalTest = [] {
+	test("PersistenceJournal keeps the last record of each owner") = [] {
+		TempJournal file("last_record");
+		PersistenceJournal journal;
+		expect(journal.open(file.path));
+		expect(journal.isOpen());
+
+		journal.record(1, queries(1));
+		journal.record(1, queries(2));
+		journal.record(2, queries(1));
+		expect(eq(journal.getSequence(), 3));
+		expect(eq(journal.getPendingOwners(), std::vector<uint32_t> { 1, 2 }));
+	};
+
+	test("PersistenceJournal settles only the records the save covered") = [] {
+		TempJournal file("settle");
+		PersistenceJournal journal;
+		expect(journal.open(file.path));
+
+		journal.record(1, queries(1));
+		const auto saveSequence = journal.getSequence();
+		// Recorded after the save read the sequence, the save does not cover it
+		journal.record(1, queries(1));
+		journal.settle(1, saveSequence);
+		expect(eq(journal.getPendingOwners(), std::vector<uint32_t> { 1 }));
+
+		journal.settle(1, journal.getSequence());
+		expect(journal.getPendingOwners().empty());
+	};
+
+	test("PersistenceJournal replays what a crash left unsettled") = [] {
+		TempJournal file("replay");
+		{
+			PersistenceJournal journal;
+			expect(journal.open(file.path));
+			journal.record(1, queries(1));
+			journal.record(2, queries(2));
+			journal.settle(2, journal.getSequence());
+			journal.record(3, queries(4));
+			// Replaces the first record of the owner
+			journal.record(1, queries(3));
+		}
+
+		PersistenceJournal journal;
+		expect(eq(openCapturingReplay(journal, file.path), 7));
+		expect(journal.getPendingOwners().empty());
+		expect(eq(journal.getSequence(), 4));
+		// The replayed records are not replayed again on the next start
+		expect(eq(std::filesystem::file_size(file.path), 0));
+	};
+
+	test("PersistenceJournal ignores a record torn by a crash") = [] {
+		TempJournal file("torn");
+		{
+			PersistenceJournal journal;
+			expect(journal.open(file.path));
+			journal.record(1, queries(1));
+			journal.record(2, queries(2));
+		}
+		// The crash hit in the middle of the second write
+		std::filesystem::resize_file(file.path, std::filesystem::file_size(file.path) - 3);
+
+		PersistenceJournal journal;
+		expect(eq(openCapturingReplay(journal, file.path), 1));
+	};
+
+	test("PersistenceJournal compaction writes the pending records and empties the file") = [] {
+		TempJournal file("compact");
+		PersistenceJournal journal;
+		expect(journal.open(file.path));
+		journal.record(1, queries(2));
+		journal.record(2, queries(1));
+		journal.settle(2, journal.getSequence());
+
+		{
+			DBCapture capture;
+			DBCapture::Scope scope(capture);
+			expect(journal.compact());
+			expect(eq(capture.size(), 2));
+		}
+		expect(journal.getPendingOwners().empty());
+		expect(eq(std::filesystem::file_size(file.path), 0));
+	};
+};
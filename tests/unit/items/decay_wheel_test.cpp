@@ -0,0 +1,136 @@
+#include "pch.hpp"
+
+#include <boost/ut.hpp>
+
+#include "items/decay/decay_wheel.hpp"
+
+using namespace boost::ut;
+
+namespace {
+	struct DecayingItem {
+		explicit DecayingItem(int64_t due) :
+			due(due) { }
+
+		int64_t due;
+		uint32_t decayBucket = std::numeric_limits<uint32_t>::max();
+		uint32_t decayIndex = 0;
+	};
+
+	struct DueTick {
+		int64_t operator()(const std::shared_ptr<DecayingItem> &item) const {
+			return item->due;
+		}
+	};
+
+	using Wheel = DecayWheel<DecayingItem, DueTick>;
+
+	std::shared_ptr<DecayingItem> schedule(Wheel &wheel, int64_t due) {
+		auto item = std::make_shared<DecayingItem>(due);
+		wheel.schedule(item, due);
+		return item;
+	}
+
+	std::vector<std::shared_ptr<DecayingItem>> expire(Wheel &wheel, int64_t tick) {
+		std::vector<std::shared_ptr<DecayingItem>> expired;
+		wheel.expire(tick, expired);
+		return expired;
+	}
+}
+
+suite<"items"> decayWheelTest = [] {
+	test("DecayWheel expires an item at its tick and not before") = [] {
+		Wheel wheel;
+		wheel.setNextTick(1000);
+		const auto item = schedule(wheel, 1010);
+		expect(lt(item->decayBucket, Wheel::WHEEL_SIZE));
+
+		expect(expire(wheel, 1009).empty());
+		const auto expired = expire(wheel, 1010);
+		expect(eq(expired.size(), 1));
+		expect(expired.front() == item);
+		expect(eq(item->decayBucket, Wheel::NO_BUCKET));
+		expect(eq(wheel.getNextTick(), 1011));
+	};
+
+	test("DecayWheel catches up on the ticks a slow cycle skipped") = [] {
+		Wheel wheel;
+		wheel.setNextTick(0);
+		for (const int64_t due : { 3, 1, 2, 40 }) {
+			schedule(wheel, due);
+		}
+
+		const auto expired = expire(wheel, 10);
+		expect(eq(expired.size(), 3));
+		expect(eq(expired[0]->due, 1));
+		expect(eq(expired[2]->due, 3));
+		expect(eq(expire(wheel, 40).size(), 1));
+	};
+
+	test("DecayWheel schedules an item already due on the next tick") = [] {
+		Wheel wheel;
+		wheel.setNextTick(500);
+		schedule(wheel, 100);
+		expect(eq(expire(wheel, 500).size(), 1));
+	};
+
+	test("DecayWheel unschedules an item from the middle of its bucket") = [] {
+		Wheel wheel;
+		wheel.setNextTick(0);
+		const auto first = schedule(wheel, 7);
+		const auto second = schedule(wheel, 7);
+		const auto third = schedule(wheel, 7);
+		expect(eq(third->decayIndex, 2u));
+
+		wheel.unschedule(second);
+		expect(eq(second->decayBucket, Wheel::NO_BUCKET));
+		// The last item took its place
+		expect(eq(third->decayIndex, 1u));
+
+		wheel.unschedule(third);
+		const auto expired = expire(wheel, 7);
+		expect(eq(expired.size(), 1));
+		expect(expired.front() == first);
+	};
+
+	test("DecayWheel expires the coarse and far items at their tick") = [] {
+		constexpr int64_t Start = 123;
+		Wheel wheel;
+		wheel.setNextTick(Start);
+
+		std::vector<std::shared_ptr<DecayingItem>> items;
+		// First level, coarse level, a coarse bucket that wraps, far bucket
+		for (const int64_t delay : { 100, 5000, 4096 * 3 + 17, 4096 * 1023, 4096 * 1100 + 5 }) {
+			items.emplace_back(schedule(wheel, Start + delay));
+		}
+		expect(eq(items[1]->decayBucket / Wheel::WHEEL_SIZE, 1u));
+		expect(eq(items[4]->decayBucket, Wheel::FAR_BUCKET));
+
+		std::vector<int64_t> expiredAt;
+		std::vector<std::shared_ptr<DecayingItem>> expired;
+		for (int64_t tick = Start; expiredAt.size() < items.size(); ++tick) {
+			wheel.expire(tick, expired);
+			for (const auto &item : expired) {
+				expect(eq(item->due, tick));
+				expiredAt.emplace_back(tick);
+			}
+			expired.clear();
+		}
+		expect(std::ranges::is_sorted(expiredAt));
+	};
+
+	test("DecayWheel moves the items that are unscheduled after a cascade") = [] {
+		Wheel wheel;
+		wheel.setNextTick(0);
+		const auto kept = schedule(wheel, 5000);
+		const auto removed = schedule(wheel, 5000);
+
+		// The coarse bucket is spread over the first level at the turn
+		expect(expire(wheel, 4096).empty());
+		expect(lt(removed->decayBucket, Wheel::WHEEL_SIZE));
+		wheel.unschedule(removed);
+
+		const auto expired = expire(wheel, 5000);
+		expect(eq(expired.size(), 1));
+		expect(expired.front() == kept);
+	};
+};
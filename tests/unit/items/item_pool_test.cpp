@@ -0,0 +1,83 @@
+#include "pch.hpp"
+
+#include <boost/ut.hpp>
+
+#include "items/item_pool.hpp"
+
+using namespace boost::ut;
+
+namespace {
+	struct PooledItem {
+		static inline std::atomic<int> destroyed = 0;
+
+		explicit PooledItem(uint16_t id) :
+			id(id) { }
+		~PooledItem() {
+			++destroyed;
+		}
+
+		uint16_t id;
+		char payload[96] {};
+	};
+
+	struct OtherPooledItem {
+		uint32_t value = 0;
+	};
+}
+
+suite<"items"> itemPoolTest = [] {
+	test("makeItemShared constructs and destroys the items") = [] {
+		const auto destroyed = PooledItem::destroyed.load();
+		{
+			const auto item = makeItemShared<PooledItem>(3031);
+			expect(eq(item->id, 3031));
+			expect(eq(reinterpret_cast<uintptr_t>(item.get()) % alignof(PooledItem), 0));
+		}
+		expect(eq(PooledItem::destroyed.load(), destroyed + 1));
+	};
+
+	test("makeItemShared counts the live and freed items of each class") = [] {
+		auto &stats = itemPoolStats<PooledItem>;
+		const auto live = stats.live.load();
+		const auto freed = stats.freed.load();
+		const auto otherLive = itemPoolStats<OtherPooledItem>.live.load();
+
+		std::vector<std::shared_ptr<PooledItem>> items;
+		for (uint16_t i = 0; i < 3; ++i) {
+			items.emplace_back(makeItemShared<PooledItem>(i));
+		}
+		expect(eq(stats.live.load(), live + 3));
+		expect(eq(itemPoolStats<OtherPooledItem>.live.load(), otherLive));
+
+		items.clear();
+		expect(eq(stats.live.load(), live));
+		expect(eq(stats.freed.load(), freed + 3));
+	};
+
+	test("makeItemShared reuses the blocks of the freed items") = [] {
+		const auto first = makeItemShared<OtherPooledItem>();
+		auto* address = first.get();
+		const_cast<std::shared_ptr<OtherPooledItem> &>(first).reset();
+
+		const auto second = makeItemShared<OtherPooledItem>();
+		expect(second.get() == address);
+	};
+
+	test("makeItemShared takes back the items freed on another thread") = [] {
+		auto &stats = itemPoolStats<PooledItem>;
+		const auto live = stats.live.load();
+		const auto destroyed = PooledItem::destroyed.load();
+
+		for (int round = 0; round < 4; ++round) {
+			std::vector<std::shared_ptr<PooledItem>> items;
+			for (uint16_t i = 0; i < 1000; ++i) {
+				items.emplace_back(makeItemShared<PooledItem>(i));
+			}
+			// Released by another thread, as the network threads do with the items of a packet
+			std::thread([items = std::move(items)]() mutable { items.clear(); }).join();
+		}
+
+		expect(eq(stats.live.load(), live));
+		expect(eq(PooledItem::destroyed.load(), destroyed + 4000));
+	};
+};
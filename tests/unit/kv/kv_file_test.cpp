@@ -0,0 +1,158 @@
+/**
+ * Canary - A free and open-source MMORPG server emulator
+ * Copyright (©) 2019-2024 OpenTibiaBR <opentibiabr@outlook.com>
+ * Repository: https://github.com/opentibiabr/canary
+ * License: https://github.com/opentibiabr/canary/blob/main/LICENSE
+ * Contributors: https://github.com/opentibiabr/canary/graphs/contributors
+ * Website: https://docs.opentibiabr.com/
+ */
+#include "pch.hpp"
+
+#include <boost/ut.hpp>
+
+#include "kv/kv_file.hpp"
+#include "lib/logging/in_memory_logger.hpp"
+
+using namespace boost::ut;
+
+namespace {
+	// A file of its own for each test, removed when it ends
+	struct TempKVFile {
+		std::string path;
+
+		explicit TempKVFile(std::string_view name) :
+			path((std::filesystem::temp_directory_path() / fmt::format("canary_{}.kv", name)).string()) {
+			std::filesystem::remove(path);
+		}
+		~TempKVFile() {
+			std::filesystem::remove(path);
+		}
+	};
+
+	uint64_t fileSize(const std::string &path) {
+		return static_cast<uint64_t>(std::filesystem::file_size(path));
+	}
+}
+
+suite<"kv"> kvFileTest = [] {
+	test("KVFileStorage saves and loads values") = [] {
+		InMemoryLogger logger;
+		TempKVFile file("save_load");
+		KVFileStorage storage(logger);
+		expect(storage.open(file.path));
+		expect(storage.empty());
+
+		expect(storage.save({ { "player.1.level", ValueWrapper(42) }, { "player.1.name", ValueWrapper(std::string("Knight")) }, { "player.2.level", ValueWrapper(7) } }));
+		expect(eq(storage.load("player.1.level")->get<int>(), 42));
+		expect(eq(storage.load("player.1.name")->get<std::string>(), std::string("Knight")));
+		expect(!storage.load("player.3.level").has_value());
+
+		// Overwritten values are read from the last record
+		expect(storage.save({ { "player.1.level", ValueWrapper(43) } }));
+		expect(eq(storage.load("player.1.level")->get<int>(), 43));
+	};
+
+	test("KVFileStorage scans a prefix in key order") = [] {
+		InMemoryLogger logger;
+		TempKVFile file("prefix");
+		KVFileStorage storage(logger);
+		expect(storage.open(file.path));
+		expect(storage.save({ { "player.2.level", ValueWrapper(7) }, { "player.1.level", ValueWrapper(42) }, { "player.10.level", ValueWrapper(3) }, { "guild.1.level", ValueWrapper(1) } }));
+
+		const auto keys = storage.loadPrefix("player.1");
+		expect(eq(keys.size(), 2));
+		expect(eq(keys[0], std::string(".level")));
+		expect(eq(keys[1], std::string("0.level")));
+
+		const auto values = storage.loadPrefixValues("player.");
+		expect(eq(values.size(), 3));
+		expect(eq(values[0].first, std::string("player.1.level")));
+		expect(eq(values[0].second.get<int>(), 42));
+		expect(eq(values[2].first, std::string("player.2.level")));
+	};
+
+	test("KVFileStorage removes deleted keys") = [] {
+		InMemoryLogger logger;
+		TempKVFile file("delete");
+		KVFileStorage storage(logger);
+		expect(storage.open(file.path));
+		expect(storage.save({ { "key1", ValueWrapper(1) }, { "key2", ValueWrapper(2) } }));
+		expect(storage.save({ { "key1", ValueWrapper::deleted() } }));
+
+		expect(!storage.load("key1").has_value());
+		expect(eq(storage.loadPrefix("key").size(), 1));
+
+		// The delete record is replayed on open as well
+		KVFileStorage reopened(logger);
+		expect(reopened.open(file.path));
+		expect(!reopened.load("key1").has_value());
+		expect(eq(reopened.load("key2")->get<int>(), 2));
+	};
+
+	test("KVFileStorage reads the saved values after reopening") = [] {
+		InMemoryLogger logger;
+		TempKVFile file("reopen");
+		{
+			KVFileStorage storage(logger);
+			expect(storage.open(file.path));
+			expect(storage.save({ { "key", ValueWrapper(std::string("value")) } }));
+		}
+
+		KVFileStorage storage(logger);
+		expect(storage.open(file.path));
+		expect(!storage.empty());
+		expect(eq(storage.load("key")->get<std::string>(), std::string("value")));
+	};
+
+	test("KVFileStorage cuts off a record torn by a crash") = [] {
+		InMemoryLogger logger;
+		TempKVFile file("torn");
+		uint64_t validSize = 0;
+		{
+			KVFileStorage storage(logger);
+			expect(storage.open(file.path));
+			expect(storage.save({ { "key1", ValueWrapper(1) } }));
+			validSize = fileSize(file.path);
+			expect(storage.save({ { "key2", ValueWrapper(2) } }));
+		}
+		// The crash hit in the middle of the second write
+		std::filesystem::resize_file(file.path, fileSize(file.path) - 3);
+
+		{
+			KVFileStorage storage(logger);
+			expect(storage.open(file.path));
+			expect(eq(fileSize(file.path), validSize));
+			expect(eq(storage.load("key1")->get<int>(), 1));
+			expect(!storage.load("key2").has_value());
+
+			// Appended after the last valid record, not after the torn one
+			expect(storage.save({ { "key3", ValueWrapper(3) } }));
+		}
+
+		KVFileStorage storage(logger);
+		expect(storage.open(file.path));
+		expect(eq(storage.load("key1")->get<int>(), 1));
+		expect(eq(storage.load("key3")->get<int>(), 3));
+	};
+
+	test("KVFileStorage stops at a record that fails its checksum") = [] {
+		InMemoryLogger logger;
+		TempKVFile file("checksum");
+		{
+			KVFileStorage storage(logger);
+			expect(storage.open(file.path));
+			expect(storage.save({ { "key1", ValueWrapper(1) } }));
+			expect(storage.save({ { "key2", ValueWrapper(2) } }));
+		}
+		{
+			std::fstream stream(file.path, std::ios::binary | std::ios::in | std::ios::out);
+			stream.seekp(-1, std::ios::end);
+			stream.put('\xFF');
+		}
+
+		KVFileStorage storage(logger);
+		expect(storage.open(file.path));
+		expect(eq(storage.load("key1")->get<int>(), 1));
+		expect(!storage.load("key2").has_value());
+	};
+};
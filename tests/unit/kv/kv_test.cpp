@@ -13,6 +13,36 @@
 #include "kv/kv.hpp"
 #include "utils/tools.hpp"
 #include "injection_fixture.hpp"
+#include "lib/logging/in_memory_logger.hpp"
+
+// Saves into a map that stands for the database, counting the loads
+class KVSaveProbe final : public KVStore {
+public:
+	using KVStore::releaseDirty;
+	using KVStore::takeDirty;
+
+	explicit KVSaveProbe(Logger &logger) :
+		KVStore(logger) { }
+
+	std::map<std::string, ValueWrapper> database;
+	uint32_t loads = 0;
+
+protected:
+	std::vector<std::string> loadPrefix(const std::string &prefix = "") override {
+		return {};
+	}
+	std::optional<ValueWrapper> load(const std::string &key) override {
+		++loads;
+		if (auto it = database.find(key); it != database.end()) {
+			return it->second;
+		}
+		return std::nullopt;
+	}
+	bool save(const std::string &key, const ValueWrapper &value) override {
+		database.insert_or_assign(key, value);
+		return true;
+	}
+};
 
 suite<"kv"> kvTest = [] {
 	InjectionFixture injectionFixture {};
@@ -92,6 +122,29 @@ suite<"kv"> kvTest = [] {
 		expect(eq(kv.get("keyNested")->get<MapType>(), nestedMap.getVariant()));
 	};
 
+	test("Values larger than an arena block") = [&injectionFixture] {
+		auto [kv] = injectionFixture.get<KVStore>();
+		const std::string longString(1000, 'x');
+		kv.set("keyLongString", longString);
+		kv.set("keyNegative", -42);
+		expect(eq(kv.get("keyLongString")->get<std::string>(), longString));
+		expect(eq(kv.get("keyNegative")->get<int>(), -42));
+	};
+
+	test("Counters") = [&injectionFixture] {
+		auto [kv] = injectionFixture.get<KVStore>();
+		expect(eq(kv.increment("counter"), 1));
+		expect(eq(kv.increment("counter", 4), 5));
+		expect(eq(kv.updateMax("counter", 3), 5));
+		expect(eq(kv.updateMin("counter", 3), 3));
+		expect(eq(kv.get("counter")->get<int>(), 3));
+
+		kv.set("counterDouble", 2.6);
+		expect(eq(kv.increment("counterDouble"), 4));
+		expect(eq(kv.scoped("scope-name")->updateMax("counter", 7), 7));
+		expect(eq(kv.get("scope-name.counter")->get<int>(), 7));
+	};
+
 	test("Scoped KV") = [&injectionFixture] {
 		auto [kv] = injectionFixture.get<KVStore>();
 		auto scoped = kv.scoped("scope-name");
@@ -112,6 +165,17 @@ suite<"kv"> kvTest = [] {
 		expect(eq(kv.get("scope-name.nested-scope-name.nested-scope-name2.key1")->get<int>(), 1));
 	};
 
+	test("Scoped KV handles are reused") = [&injectionFixture] {
+		auto [kv] = injectionFixture.get<KVStore>();
+		auto scoped = kv.scoped("scope-name");
+		expect(scoped == kv.scoped("scope-name"));
+		expect(scoped->scoped("nested-scope-name") == scoped->scoped("nested-scope-name"));
+
+		kv.set("scope-name.nested-scope-name.key2", 2);
+		expect(eq(scoped->scoped("nested-scope-name")->get("key2")->get<int>(), 2));
+		expect(!scoped->get("nested-scope-name").has_value());
+	};
+
 	test("Removing an element")
 		= [&injectionFixture] {
 			  auto [kv] = injectionFixture.get<KVStore>();
@@ -125,4 +189,53 @@ suite<"kv"> kvTest = [] {
 			  kv.remove("key2");
 			  expect(!kv.get("key2").has_value());
 		  };
+
+	test("Saved entries are clean only once the save commits") = [] {
+		InMemoryLogger logger;
+		KVSaveProbe kv(logger);
+		kv.set("key", 1);
+
+		auto taken = kv.takeDirty();
+		expect(eq(taken.entries.size(), 1));
+		// Changed while the save is in progress
+		kv.set("key", 2);
+		kv.releaseDirty(taken, true);
+
+		taken = kv.takeDirty();
+		expect(eq(taken.entries.size(), 1));
+		expect(eq(taken.entries[0].second.get<int>(), 2));
+		kv.releaseDirty(taken, true);
+		expect(kv.takeDirty().entries.empty());
+	};
+
+	test("Failed saves keep the entries dirty") = [] {
+		InMemoryLogger logger;
+		KVSaveProbe kv(logger);
+		kv.set("key", 1);
+
+		auto taken = kv.takeDirty();
+		kv.releaseDirty(taken, false);
+		taken = kv.takeDirty();
+		expect(eq(taken.entries.size(), 1));
+		expect(eq(taken.entries[0].second.get<int>(), 1));
+	};
+
+	test("Entries being saved are not dropped by flush") = [] {
+		InMemoryLogger logger;
+		KVSaveProbe kv(logger);
+		kv.set("key", 1);
+
+		auto taken = kv.takeDirty();
+		// The first flush clears the referenced flag, the second one would drop a clean entry
+		kv.flush();
+		kv.flush();
+		expect(eq(kv.get("key")->get<int>(), 1));
+		expect(eq(kv.loads, 0));
+
+		kv.releaseDirty(taken, true);
+		kv.flush();
+		kv.flush();
+		expect(!kv.get("key").has_value());
+		expect(eq(kv.loads, 1));
+	};
 };
@@ -0,0 +1,41 @@
+/**
+ * Canary - A free and open-source MMORPG server emulator
+ * Copyright (©) 2019-2024 OpenTibiaBR <opentibiabr@outlook.com>
+ * Repository: https://github.com/opentibiabr/canary
+ * License: https://github.com/opentibiabr/canary/blob/main/LICENSE
+ * Contributors: https://github.com/opentibiabr/canary/graphs/contributors
+ * Website: https://docs.opentibiabr.com/
+ */
+#include "pch.hpp"
+
+#include <boost/ut.hpp>
+
+#include "lib/di/container.hpp"
+#include "lib/logging/in_memory_logger.hpp"
+
+using namespace boost::ut;
+
+suite<"lib"> containerTest = [] {
+	test("DI::get caches the instance") = [] {
+		di::extension::injector<> injector {};
+		DI::setTestContainer(&InMemoryLogger::install(injector));
+
+		auto &first = inject<Logger>();
+		auto &second = inject<Logger>();
+		expect(eq(&first, &second));
+		expect(eq(&first, &injector.create<Logger &>()));
+	};
+
+	test("DI::get resolves again when the test container changes") = [] {
+		di::extension::injector<> injector {};
+		DI::setTestContainer(&InMemoryLogger::install(injector));
+		auto &first = inject<Logger>();
+
+		di::extension::injector<> otherInjector {};
+		DI::setTestContainer(&InMemoryLogger::install(otherInjector));
+		auto &second = inject<Logger>();
+
+		expect(neq(&first, &second));
+		expect(eq(&second, &otherInjector.create<Logger &>()));
+	};
+};
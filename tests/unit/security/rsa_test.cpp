@@ -29,4 +29,22 @@ suite<"security"> rsaTest = [] {
 			eq(std::string { "error" }, logger.logs[0].level) and eq(std::string { "File key.pem not found or have problem on loading... Setting standard rsa key\n" }, logger.logs[0].message)
 		);
 	};
+	test("RSA::decrypt reverses RSA::encrypt") = [] {
+		di::extension::injector<> injector {};
+		DI::setTestContainer(&InMemoryLogger::install(injector));
+
+		auto &rsa = DI::create<RSA &>();
+		rsa.start();
+
+		std::array<char, 128> block {};
+		const std::string text = "canary";
+		std::memcpy(block.data() + 1, text.data(), text.size());
+
+		auto encrypted = block;
+		rsa.encrypt(encrypted.data());
+		expect(encrypted != block);
+
+		rsa.decrypt(encrypted.data());
+		expect(encrypted == block);
+	};
 };
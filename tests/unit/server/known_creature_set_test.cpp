@@ -0,0 +1,66 @@
+#include "pch.hpp"
+
+#include <boost/ut.hpp>
+
+#include "server/network/protocol/known_creature_set.hpp"
+
+using namespace boost::ut;
+
+suite<"server"> knownCreatureSetTest = [] {
+	test("KnownCreatureSet::insert reports only the new ids") = [] {
+		KnownCreatureSet set;
+		expect(set.insert(0x10000001));
+		expect(set.insert(0x10000002));
+		expect(!set.insert(0x10000001));
+		expect(eq(set.size(), size_t { 2 }));
+		expect(set.contains(0x10000002));
+		expect(!set.contains(0x10000003));
+	};
+
+	test("KnownCreatureSet::evict skips the kept id and the recently used ones") = [] {
+		KnownCreatureSet set;
+		set.insert(1);
+		set.insert(2);
+		set.insert(3);
+		// Found again, so it gets a second chance
+		set.insert(1);
+
+		const auto removed = set.evict(3, [](uint32_t) { return true; });
+		expect(neq(removed, uint32_t { 3 }));
+		expect(eq(set.size(), size_t { 2 }));
+		expect(!set.contains(removed));
+		expect(set.contains(3));
+	};
+
+	test("KnownCreatureSet::evict takes one anyway when canEvict accepts none") = [] {
+		KnownCreatureSet set;
+		set.insert(7);
+		set.insert(8);
+
+		const auto removed = set.evict(8, [](uint32_t) { return false; });
+		expect(eq(removed, uint32_t { 7 }));
+		expect(eq(set.size(), size_t { 1 }));
+		expect(set.contains(8));
+		expect(eq(set.evict(8, [](uint32_t) { return true; }), uint32_t { 0 }));
+	};
+
+	test("KnownCreatureSet keeps finding the ids while it fills and evicts") = [] {
+		KnownCreatureSet set;
+		// Sequential ids, as the game hands them out, collide in runs on the table
+		for (uint32_t id = 1; id <= KnownCreatureSet::MAX_KNOWN + 1; ++id) {
+			expect(set.insert(0x40000000 + id));
+		}
+		expect(eq(set.size(), KnownCreatureSet::MAX_KNOWN + 1));
+
+		std::vector<uint32_t> removed;
+		for (int i = 0; i < 200; ++i) {
+			removed.emplace_back(set.evict(0, [](uint32_t id) { return id % 2 == 0; }));
+		}
+		expect(eq(set.size(), KnownCreatureSet::MAX_KNOWN + 1 - 200));
+
+		for (uint32_t id = 1; id <= KnownCreatureSet::MAX_KNOWN + 1; ++id) {
+			const auto creatureId = 0x40000000 + id;
+			expect(eq(set.contains(creatureId), std::ranges::find(removed, creatureId) == removed.end()));
+		}
+	};
+};
@@ -0,0 +1,127 @@
+#include "pch.hpp"
+
+#include <boost/ut.hpp>
+
+#include "utils/inline_function.hpp"
+
+using namespace boost::ut;
+
+namespace {
+	// Counts the live copies of a callable, so leaks and double destructions show up
+	struct Tracked {
+		static inline int live = 0;
+
+		int value;
+
+		explicit Tracked(int value) :
+			value(value) {
+			++live;
+		}
+		Tracked(const Tracked &other) :
+			value(other.value) {
+			++live;
+		}
+		Tracked(Tracked &&other) noexcept :
+			value(other.value) {
+			++live;
+		}
+		~Tracked() {
+			--live;
+		}
+
+		int operator()(int add) const {
+			return value + add;
+		}
+	};
+
+	// Bigger than the inline buffer, kept on the heap
+	struct BigTracked : Tracked {
+		explicit BigTracked(int value) :
+			Tracked(value) { }
+
+		char padding[128] {};
+	};
+}
+
+suite<"utils"> inlineFunctionTest = [] {
+	test("inline_function is empty by default and from null callables") = [] {
+		stdext::inline_function<void()> empty;
+		expect(!empty);
+		expect(empty == nullptr);
+
+		stdext::inline_function<void()> fromNull = nullptr;
+		expect(!fromNull);
+
+		void (*pointer)() = nullptr;
+		stdext::inline_function<void()> fromPointer = pointer;
+		expect(!fromPointer);
+
+		stdext::inline_function<void()> fromEmptyFunction = std::function<void()>();
+		expect(!fromEmptyFunction);
+	};
+
+	test("inline_function calls inline and heap callables") = [] {
+		int captured = 2;
+		stdext::inline_function<int(int)> small = [captured](int value) { return value * captured; };
+		expect(eq(small(21), 42));
+
+		stdext::inline_function<int(int)> big = BigTracked(40);
+		expect(eq(big(2), 42));
+
+		stdext::inline_function<int(int), 8> overCapacity = [a = 1L, b = 2L](int value) { return static_cast<int>(a + b) + value; };
+		expect(eq(overCapacity(39), 42));
+	};
+
+	test("inline_function copies and moves the callable") = [] {
+		for (const bool heap : { false, true }) {
+			{
+				stdext::inline_function<int(int)> original = heap ? stdext::inline_function<int(int)>(BigTracked(1)) : stdext::inline_function<int(int)>(Tracked(1));
+				expect(eq(Tracked::live, 1));
+
+				auto copy = original;
+				expect(eq(Tracked::live, 2));
+				expect(eq(copy(1), 2));
+				expect(eq(original(2), 3));
+
+				auto moved = std::move(original);
+				expect(!original);
+				expect(eq(moved(3), 4));
+				expect(eq(Tracked::live, 2));
+
+				copy = nullptr;
+				expect(!copy);
+				expect(eq(Tracked::live, 1));
+
+				copy = moved;
+				moved = std::move(copy);
+				expect(eq(moved(4), 5));
+				expect(eq(Tracked::live, 1));
+			}
+			expect(eq(Tracked::live, 0));
+		}
+	};
+
+	test("inline_function swaps the callables") = [] {
+		stdext::inline_function<int(int)> first = Tracked(1);
+		stdext::inline_function<int(int)> second = BigTracked(10);
+		first.swap(second);
+		expect(eq(first(0), 10));
+		expect(eq(second(0), 1));
+
+		stdext::inline_function<int(int)> empty;
+		empty.swap(first);
+		expect(!first);
+		expect(eq(empty(0), 10));
+	};
+
+	test("inline_function forwards the arguments") = [] {
+		stdext::inline_function<std::string(std::string &&)> take = [](std::string &&value) { return std::move(value); };
+		std::string value = "moved";
+		expect(eq(take(std::move(value)), std::string("moved")));
+
+		stdext::inline_function<void(int &)> increment = [](int &value) { ++value; };
+		int counter = 0;
+		increment(counter);
+		expect(eq(counter, 1));
+	};
+};
@@ -0,0 +1,78 @@
+#include "pch.hpp"
+
+#include <boost/ut.hpp>
+
+#include "utils/mpsc_queue.hpp"
+
+using namespace boost::ut;
+
+suite<"utils"> mpscQueueTest = [] {
+	test("mpsc_queue pops in push order and reports empty") = [] {
+		stdext::mpsc_queue<int> queue;
+		int value = 0;
+		expect(!queue.pop(value));
+
+		for (int i = 1; i <= 3; ++i) {
+			queue.push(i);
+		}
+		for (int i = 1; i <= 3; ++i) {
+			expect(queue.pop(value));
+			expect(eq(value, i));
+		}
+		expect(!queue.pop(value));
+
+		// Works again after being drained through the stub node
+		queue.push(4);
+		expect(queue.pop(value));
+		expect(eq(value, 4));
+	};
+
+	test("mpsc_queue frees the values left on destruction") = [] {
+		auto counter = std::make_shared<int>(0);
+		{
+			stdext::mpsc_queue<std::shared_ptr<int>> queue;
+			queue.push(counter);
+			queue.push(counter);
+			expect(eq(counter.use_count(), 3L));
+		}
+		expect(eq(counter.use_count(), 1L));
+	};
+
+	test("mpsc_queue delivers every element of many producers in per producer order") = [] {
+		constexpr int producers = 4;
+		constexpr int perProducer = 20000;
+		stdext::mpsc_queue<std::pair<int, int>> queue;
+
+		std::vector<std::thread> threads;
+		for (int producer = 0; producer < producers; ++producer) {
+			threads.emplace_back([&queue, producer] {
+				for (int i = 0; i < perProducer; ++i) {
+					queue.push({ producer, i });
+				}
+			});
+		}
+
+		std::array<int, producers> next {};
+		int received = 0;
+		bool ordered = true;
+		std::pair<int, int> value;
+		while (received < producers * perProducer) {
+			if (!queue.pop(value)) {
+				std::this_thread::yield();
+				continue;
+			}
+			ordered = ordered && value.second == next[value.first];
+			next[value.first] = value.second + 1;
+			++received;
+		}
+
+		for (auto &thread : threads) {
+			thread.join();
+		}
+		expect(ordered);
+		expect(!queue.pop(value));
+		for (const auto count : next) {
+			expect(eq(count, perProducer));
+		}
+	};
+};
@@ -0,0 +1,108 @@
+#include "pch.hpp"
+
+#include <boost/ut.hpp>
+
+#include "utils/pool_allocator.hpp"
+
+using namespace boost::ut;
+
+namespace {
+	struct alignas(64) Aligned {
+		int value = 0;
+	};
+
+	struct Block {
+		uint64_t values[6] {};
+	};
+}
+
+suite<"utils"> poolAllocatorTest = [] {
+	test("fixed_block_pool reuses the last freed block") = [] {
+		using Pool = stdext::fixed_block_pool<24, 8>;
+		auto* first = Pool::allocate();
+		auto* second = Pool::allocate();
+		expect(first != second);
+
+		Pool::deallocate(first);
+		expect(Pool::allocate() == first);
+		Pool::deallocate(first);
+		Pool::deallocate(second);
+	};
+
+	test("fixed_block_pool frees the blocks over its cache size") = [] {
+		using Pool = stdext::fixed_block_pool<16, 8, 2>;
+		std::vector<void*> blocks;
+		for (int i = 0; i < 4; ++i) {
+			blocks.emplace_back(Pool::allocate());
+		}
+		// Two are kept, the rest goes back to the global allocator
+		for (auto* block : blocks) {
+			Pool::deallocate(block);
+		}
+		auto* reused = Pool::allocate();
+		expect(reused == blocks[1]);
+		Pool::deallocate(reused);
+	};
+
+	test("pool_allocator keeps the alignment of the type") = [] {
+		std::vector<std::shared_ptr<Aligned>> objects;
+		for (int i = 0; i < 8; ++i) {
+			objects.emplace_back(std::allocate_shared<Aligned>(stdext::pool_allocator<Aligned>(), Aligned { i }));
+			expect(eq(reinterpret_cast<uintptr_t>(objects.back().get()) % alignof(Aligned), 0));
+		}
+		expect(eq(objects[7]->value, 7));
+	};
+
+	test("pool_allocator allocates arrays from the global allocator") = [] {
+		std::vector<Block, stdext::pool_allocator<Block>> blocks;
+		for (uint64_t i = 0; i < 100; ++i) {
+			blocks.push_back(Block { { i } });
+		}
+		expect(eq(blocks.size(), 100));
+		expect(eq(blocks[99].values[0], 99));
+	};
+
+	test("shared_block_pool takes back the blocks freed on other threads") = [] {
+		using Pool = stdext::shared_block_pool<sizeof(Block), alignof(Block), 8, 4>;
+		constexpr int Producers = 4;
+		constexpr int Rounds = 200;
+		constexpr int PerRound = 50;
+
+		std::atomic<int> freed = 0;
+		std::vector<std::thread> threads;
+		for (int producer = 0; producer < Producers; ++producer) {
+			threads.emplace_back([&freed] {
+				for (int round = 0; round < Rounds; ++round) {
+					std::vector<Block*> blocks;
+					for (int i = 0; i < PerRound; ++i) {
+						auto* block = new (Pool::allocate()) Block();
+						block->values[0] = static_cast<uint64_t>(i);
+						blocks.emplace_back(block);
+					}
+					// Freed by another thread than the one that allocated them
+					std::thread([&freed, blocks = std::move(blocks)] {
+						for (auto* block : blocks) {
+							block->~Block();
+							Pool::deallocate(block);
+							++freed;
+						}
+					}).join();
+				}
+			});
+		}
+		for (auto &thread : threads) {
+			thread.join();
+		}
+		expect(eq(freed.load(), Producers * Rounds * PerRound));
+	};
+
+	test("shared_pool_allocator works with allocate_shared") = [] {
+		std::shared_ptr<Block> shared;
+		std::thread([&shared] {
+			shared = std::allocate_shared<Block>(stdext::shared_pool_allocator<Block>());
+			shared->values[5] = 42;
+		}).join();
+		expect(eq(shared->values[5], 42));
+		shared.reset();
+	};
+};
@@ -0,0 +1,111 @@
+#include "pch.hpp"
+
+#include <boost/ut.hpp>
+
+#include "utils/slot_table.hpp"
+
+using namespace boost::ut;
+
+suite<"utils"> slotTableTest = [] {
+	test("slot_table finds the values by id") = [] {
+		stdext::slot_table<int> table(0x40000000, 0x10000000);
+		const auto first = table.reserve();
+		const auto second = table.reserve();
+		expect(gt(first, 0x40000000u));
+		expect(neq(first, second));
+		expect(table.isReserved(first));
+
+		// Reserved, without a value yet
+		expect(table.get(first) == nullptr);
+		expect(eq(table.size(), 0));
+
+		table.set(first, std::make_shared<int>(1));
+		table.set(second, std::make_shared<int>(2));
+		expect(eq(*table.get(first), 1));
+		expect(eq(*table.get(second), 2));
+		expect(eq(table.size(), 2));
+
+		// Ids that were never handed out
+		expect(table.get(0) == nullptr);
+		expect(table.get(0x40000000) == nullptr);
+		expect(table.get(second + 1) == nullptr);
+	};
+
+	test("slot_table does not find a value by the id of a released one") = [] {
+		stdext::slot_table<int> table(0, 1u << 24);
+		const auto id = table.reserve();
+		table.set(id, std::make_shared<int>(1));
+		table.release(id);
+		expect(!table.isReserved(id));
+		expect(table.get(id) == nullptr);
+		expect(eq(table.size(), 0));
+
+		// Takes the same slot with the next generation
+		const auto reused = table.reserve();
+		expect(neq(reused, id));
+		table.set(reused, std::make_shared<int>(2));
+		expect(table.get(id) == nullptr);
+		expect(eq(*table.get(reused), 2));
+
+		// Stale ids neither change nor release the new value
+		table.set(id, std::make_shared<int>(3));
+		table.release(id);
+		expect(eq(*table.get(reused), 2));
+		expect(eq(table.size(), 1));
+	};
+
+	test("slot_table reuses the released slots in FIFO order") = [] {
+		stdext::slot_table<int, 4> table(0, 16 * 8);
+		std::vector<uint32_t> ids;
+		for (int i = 0; i < 3; ++i) {
+			ids.emplace_back(table.reserve());
+		}
+		table.release(ids[1]);
+		table.release(ids[0]);
+
+		// Slot of ids[1] first, then the one of ids[0]
+		expect(eq(table.reserve() & 0xF, ids[1] & 0xF));
+		expect(eq(table.reserve() & 0xF, ids[0] & 0xF));
+	};
+
+	test("slot_table returns 0 once every slot is taken") = [] {
+		stdext::slot_table<int, 2> table(100, 4 * 4);
+		for (int i = 0; i < 4; ++i) {
+			expect(neq(table.reserve(), 0u));
+		}
+		expect(eq(table.reserve(), 0u));
+	};
+
+	test("slot_table wraps the generations within its ids") = [] {
+		constexpr uint32_t FirstId = 1000;
+		constexpr uint32_t IdCount = 4 * 3;
+		stdext::slot_table<int, 2> table(FirstId, IdCount);
+		for (int i = 0; i < 10; ++i) {
+			const auto id = table.reserve();
+			expect(gt(id, FirstId));
+			expect(le(id, FirstId + IdCount));
+			table.set(id, std::make_shared<int>(i));
+			expect(eq(*table.get(id), i));
+			table.release(id);
+		}
+	};
+
+	test("slot_table iterates the values that are set") = [] {
+		stdext::slot_table<int> table(0, 1u << 24);
+		std::vector<uint32_t> ids;
+		for (int i = 0; i < 5; ++i) {
+			ids.emplace_back(table.reserve());
+			if (i != 2) {
+				table.set(ids.back(), std::make_shared<int>(i));
+			}
+		}
+		table.release(ids[3]);
+
+		std::vector<int> values;
+		for (const auto &[id, value] : table) {
+			expect(table.get(id) == value);
+			values.emplace_back(*value);
+		}
+		expect(values == std::vector<int> { 0, 1, 4 });
+	};
+};
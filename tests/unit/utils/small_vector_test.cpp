@@ -0,0 +1,173 @@
+#include "pch.hpp"
+
+#include <boost/ut.hpp>
+
+#include "utils/small_vector.hpp"
+
+using namespace boost::ut;
+
+namespace {
+	// Counts the live elements, so leaks and double destructions show up
+	struct Counted {
+		static inline int live = 0;
+
+		std::string value;
+
+		explicit Counted(std::string value) :
+			value(std::move(value)) {
+			++live;
+		}
+		Counted(const Counted &other) :
+			value(other.value) {
+			++live;
+		}
+		Counted(Counted &&other) noexcept :
+			value(std::move(other.value)) {
+			++live;
+		}
+		Counted &operator=(const Counted &) = default;
+		Counted &operator=(Counted &&) noexcept = default;
+		~Counted() {
+			--live;
+		}
+	};
+
+	template <size_t N>
+	std::vector<std::string> values(const stdext::small_vector<Counted, N> &vector) {
+		std::vector<std::string> result;
+		for (const auto &element : vector) {
+			result.emplace_back(element.value);
+		}
+		return result;
+	}
+
+	// Longer than the small string buffer, so a stale copy is a heap use after free
+	std::string text(int index) {
+		return fmt::format("a string long enough to be allocated #{}", index);
+	}
+}
+
+suite<"utils"> smallVectorTest = [] {
+	test("small_vector keeps up to N elements inline") = [] {
+		stdext::small_vector<int, 4> vector;
+		expect(vector.empty());
+		expect(vector.isInline());
+		for (int i = 0; i < 4; ++i) {
+			vector.push_back(i);
+		}
+		expect(vector.isInline());
+		expect(eq(vector.capacity(), 4));
+
+		vector.push_back(4);
+		expect(!vector.isInline());
+		expect(eq(vector.size(), 5));
+		for (int i = 0; i < 5; ++i) {
+			expect(eq(vector[i], i));
+		}
+		expect(eq(vector.front(), 0));
+		expect(eq(vector.back(), 4));
+		expect(throws([&vector] { vector.at(5); }));
+	};
+
+	test("small_vector inserts and erases in the middle") = [] {
+		for (const size_t count : { 2, 8 }) {
+			stdext::small_vector<Counted, 4> vector;
+			for (size_t i = 0; i < count; ++i) {
+				vector.emplace_back(text(static_cast<int>(i)));
+			}
+
+			auto it = vector.emplace(vector.begin() + 1, "inserted");
+			expect(eq(it->value, std::string("inserted")));
+			expect(eq(vector[0].value, text(0)));
+			expect(eq(vector[2].value, text(1)));
+			expect(eq(vector.size(), count + 1));
+
+			it = vector.erase(vector.begin());
+			expect(eq(it->value, std::string("inserted")));
+			it = vector.erase(vector.begin(), vector.begin() + 2);
+			expect(eq(vector.size(), count - 2));
+			expect(it == vector.begin());
+			if (count > 2) {
+				expect(eq(vector.front().value, text(2)));
+			}
+			expect(eq(Counted::live, static_cast<int>(vector.size())));
+		}
+		expect(eq(Counted::live, 0));
+	};
+
+	test("small_vector grows from an element of its own") = [] {
+		stdext::small_vector<Counted, 2> vector;
+		vector.emplace_back(text(0));
+		vector.emplace_back(text(1));
+		// The argument lives in the storage that is replaced
+		vector.push_back(vector[0]);
+		expect(eq(vector[2].value, text(0)));
+		vector.emplace(vector.begin(), vector.back());
+		expect(eq(vector[0].value, text(0)));
+		expect(eq(vector.size(), 4));
+	};
+
+	test("small_vector copies and moves inline and heap storage") = [] {
+		for (const int count : { 3, 10 }) {
+			{
+				stdext::small_vector<Counted, 4> original;
+				for (int i = 0; i < count; ++i) {
+					original.emplace_back(text(i));
+				}
+
+				auto copy = original;
+				expect(values(copy) == values(original));
+				expect(eq(Counted::live, count * 2));
+
+				auto moved = std::move(original);
+				expect(original.empty());
+				expect(original.isInline());
+				expect(values(moved) == values(copy));
+
+				original = moved;
+				copy = std::move(moved);
+				expect(values(copy) == values(original));
+				expect(moved.empty());
+				expect(eq(Counted::live, count * 2));
+
+				// Still usable after being moved from
+				moved.emplace_back(text(99));
+				expect(eq(moved.size(), 1));
+			}
+			expect(eq(Counted::live, 0));
+		}
+	};
+
+	test("small_vector swaps inline and heap storage") = [] {
+		stdext::small_vector<Counted, 2> small;
+		small.emplace_back(text(0));
+		stdext::small_vector<Counted, 2> big;
+		for (int i = 1; i <= 4; ++i) {
+			big.emplace_back(text(i));
+		}
+
+		small.swap(big);
+		expect(eq(small.size(), 4));
+		expect(eq(big.size(), 1));
+		expect(big.isInline());
+		expect(eq(small[3].value, text(4)));
+		expect(eq(big[0].value, text(0)));
+	};
+
+	test("small_vector clears and pops without leaking") = [] {
+		{
+			stdext::small_vector<Counted, 2> vector;
+			for (int i = 0; i < 5; ++i) {
+				vector.emplace_back(text(i));
+			}
+			vector.pop_back();
+			expect(eq(Counted::live, 4));
+			vector.clear();
+			expect(eq(Counted::live, 0));
+			// The heap storage is kept for reuse
+			expect(!vector.isInline());
+			vector.emplace_back(text(5));
+		}
+		expect(eq(Counted::live, 0));
+	};
+};
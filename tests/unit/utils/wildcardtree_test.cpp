@@ -0,0 +1,62 @@
+#include "pch.hpp"
+
+#include <boost/ut.hpp>
+
+#include "utils/wildcardtree.hpp"
+
+using namespace boost::ut;
+
+suite<"utils"> wildcardTreeTest = [] {
+	test("WildcardTree::findOne completes a unique prefix") = [] {
+		WildcardTree tree;
+		tree.insert("gamemaster");
+		tree.insert("gandalf");
+		tree.insert("galadriel");
+
+		std::string result;
+		expect(eq(tree.findOne("gam", result), RETURNVALUE_NOERROR));
+		expect(eq(result, std::string("gamemaster")));
+		expect(eq(tree.findOne("gal", result), RETURNVALUE_NOERROR));
+		expect(eq(result, std::string("galadriel")));
+		expect(eq(tree.findOne("gandalf", result), RETURNVALUE_NOERROR));
+		expect(eq(result, std::string("gandalf")));
+	};
+
+	test("WildcardTree::findOne reports ambiguous and unknown prefixes") = [] {
+		WildcardTree tree;
+		tree.insert("bob");
+		tree.insert("bobby");
+		tree.insert("alice");
+
+		std::string result;
+		expect(eq(tree.findOne("bo", result), RETURNVALUE_NAMEISTOOAMBIGUOUS));
+		expect(eq(tree.findOne("bob", result), RETURNVALUE_NAMEISTOOAMBIGUOUS));
+		expect(eq(tree.findOne("bobb", result), RETURNVALUE_NOERROR));
+		expect(eq(result, std::string("bobby")));
+		expect(eq(tree.findOne("carl", result), RETURNVALUE_PLAYERWITHTHISNAMEISNOTONLINE));
+		expect(eq(tree.findOne("alicia", result), RETURNVALUE_PLAYERWITHTHISNAMEISNOTONLINE));
+	};
+
+	test("WildcardTree::remove merges the branches left behind") = [] {
+		WildcardTree tree;
+		tree.insert("bob");
+		tree.insert("bobby");
+		tree.insert("bonnie");
+
+		tree.remove("bobby");
+		std::string result;
+		expect(eq(tree.findOne("bob", result), RETURNVALUE_NOERROR));
+		expect(eq(result, std::string("bob")));
+
+		tree.remove("bob");
+		expect(eq(tree.findOne("b", result), RETURNVALUE_NOERROR));
+		expect(eq(result, std::string("bonnie")));
+		expect(eq(tree.findOne("bob", result), RETURNVALUE_PLAYERWITHTHISNAMEISNOTONLINE));
+
+		// Unknown names leave it as it is
+		tree.remove("bonn");
+		tree.remove("zed");
+		expect(eq(tree.findOne("bo", result), RETURNVALUE_NOERROR));
+		expect(eq(result, std::string("bonnie")));
+	};
+};